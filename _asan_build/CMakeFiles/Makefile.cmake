@@ -0,0 +1,122 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckCSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckIncludeFile.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckLibraryExists.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageHandleStandardArgs.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageMessage.cmake"
+  "/usr/share/cmake-3.25/Modules/FindThreads.cmake"
+  "/usr/share/cmake-3.25/Modules/Internal/CheckSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "CMakeFiles/v4front.dir/DependInfo.cmake"
+  "CMakeFiles/v4front-ngrams.dir/DependInfo.cmake"
+  "CMakeFiles/v4front-batch.dir/DependInfo.cmake"
+  "CMakeFiles/v4front-bench.dir/DependInfo.cmake"
+  "CMakeFiles/v4front_bench.dir/DependInfo.cmake"
+  "CMakeFiles/v4front-codebench.dir/DependInfo.cmake"
+  "CMakeFiles/v4front-kat.dir/DependInfo.cmake"
+  "CMakeFiles/v4front_codebench.dir/DependInfo.cmake"
+  "CMakeFiles/test_errors.dir/DependInfo.cmake"
+  "CMakeFiles/test_disasm.dir/DependInfo.cmake"
+  "CMakeFiles/test_compile.dir/DependInfo.cmake"
+  "CMakeFiles/test_comments.dir/DependInfo.cmake"
+  "CMakeFiles/test_constant.dir/DependInfo.cmake"
+  "CMakeFiles/test_variable.dir/DependInfo.cmake"
+  "CMakeFiles/test_arithmetic.dir/DependInfo.cmake"
+  "CMakeFiles/test_comparison.dir/DependInfo.cmake"
+  "CMakeFiles/test_bitwise.dir/DependInfo.cmake"
+  "CMakeFiles/test_stack.dir/DependInfo.cmake"
+  "CMakeFiles/test_composite.dir/DependInfo.cmake"
+  "CMakeFiles/test_case_insensitive.dir/DependInfo.cmake"
+  "CMakeFiles/test_if_then_else.dir/DependInfo.cmake"
+  "CMakeFiles/test_begin_until.dir/DependInfo.cmake"
+  "CMakeFiles/test_while_repeat.dir/DependInfo.cmake"
+  "CMakeFiles/test_begin_again.dir/DependInfo.cmake"
+  "CMakeFiles/test_return_stack_compile.dir/DependInfo.cmake"
+  "CMakeFiles/test_do_loop.dir/DependInfo.cmake"
+  "CMakeFiles/test_word_definitions.dir/DependInfo.cmake"
+  "CMakeFiles/test_memory_access.dir/DependInfo.cmake"
+  "CMakeFiles/test_context.dir/DependInfo.cmake"
+  "CMakeFiles/test_error_position.dir/DependInfo.cmake"
+  "CMakeFiles/test_sys_compile.dir/DependInfo.cmake"
+  "CMakeFiles/test_local_incdec.dir/DependInfo.cmake"
+  "CMakeFiles/test_local_vars.dir/DependInfo.cmake"
+  "CMakeFiles/test_local_vars_opt.dir/DependInfo.cmake"
+  "CMakeFiles/test_recurse.dir/DependInfo.cmake"
+  "CMakeFiles/test_bytecode_io.dir/DependInfo.cmake"
+  "CMakeFiles/test_task.dir/DependInfo.cmake"
+  "CMakeFiles/test_allocator.dir/DependInfo.cmake"
+  "CMakeFiles/test_image.dir/DependInfo.cmake"
+  "CMakeFiles/test_peephole.dir/DependInfo.cmake"
+  "CMakeFiles/test_literal_encoding.dir/DependInfo.cmake"
+  "CMakeFiles/test_constant_fold.dir/DependInfo.cmake"
+  "CMakeFiles/test_inline.dir/DependInfo.cmake"
+  "CMakeFiles/test_tail_call.dir/DependInfo.cmake"
+  "CMakeFiles/test_passes.dir/DependInfo.cmake"
+  "CMakeFiles/test_jump_thread.dir/DependInfo.cmake"
+  "CMakeFiles/test_strip_unused.dir/DependInfo.cmake"
+  "CMakeFiles/test_loop_locals.dir/DependInfo.cmake"
+  "CMakeFiles/test_counted_loop.dir/DependInfo.cmake"
+  "CMakeFiles/test_superinsn.dir/DependInfo.cmake"
+  "CMakeFiles/test_stream.dir/DependInfo.cmake"
+  "CMakeFiles/test_source_len.dir/DependInfo.cmake"
+  "CMakeFiles/test_tokenizer.dir/DependInfo.cmake"
+  "CMakeFiles/test_context_snapshot.dir/DependInfo.cmake"
+  "CMakeFiles/test_batch.dir/DependInfo.cmake"
+  "CMakeFiles/test_word_cache.dir/DependInfo.cmake"
+  "CMakeFiles/test_disk_cache.dir/DependInfo.cmake"
+  "CMakeFiles/test_relocs.dir/DependInfo.cmake"
+  "CMakeFiles/test_stats.dir/DependInfo.cmake"
+  "CMakeFiles/test_source_map.dir/DependInfo.cmake"
+  "CMakeFiles/test_stack_effect.dir/DependInfo.cmake"
+  "CMakeFiles/test_verify.dir/DependInfo.cmake"
+  "CMakeFiles/test_session.dir/DependInfo.cmake"
+  "CMakeFiles/test_const_eval.dir/DependInfo.cmake"
+  "CMakeFiles/test_auto_yield.dir/DependInfo.cmake"
+  "CMakeFiles/test_profile.dir/DependInfo.cmake"
+  "CMakeFiles/test_lex_cache.dir/DependInfo.cmake"
+  "CMakeFiles/test_kat.dir/DependInfo.cmake"
+  "CMakeFiles/test_c.dir/DependInfo.cmake"
+  )
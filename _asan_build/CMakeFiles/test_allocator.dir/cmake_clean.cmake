@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_allocator.dir/tests/test_allocator.cpp.o"
+  "CMakeFiles/test_allocator.dir/tests/test_allocator.cpp.o.d"
+  "test_allocator"
+  "test_allocator.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_allocator.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
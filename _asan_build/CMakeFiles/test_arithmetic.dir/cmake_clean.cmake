@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_arithmetic.dir/tests/test_arithmetic.cpp.o"
+  "CMakeFiles/test_arithmetic.dir/tests/test_arithmetic.cpp.o.d"
+  "test_arithmetic"
+  "test_arithmetic.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_arithmetic.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
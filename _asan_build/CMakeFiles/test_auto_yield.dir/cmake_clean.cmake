@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_auto_yield.dir/tests/test_auto_yield.cpp.o"
+  "CMakeFiles/test_auto_yield.dir/tests/test_auto_yield.cpp.o.d"
+  "test_auto_yield"
+  "test_auto_yield.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_auto_yield.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_begin_again.dir/tests/test_begin_again.cpp.o"
+  "CMakeFiles/test_begin_again.dir/tests/test_begin_again.cpp.o.d"
+  "test_begin_again"
+  "test_begin_again.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_begin_again.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
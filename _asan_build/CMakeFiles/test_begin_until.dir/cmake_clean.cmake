@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_begin_until.dir/tests/test_begin_until.cpp.o"
+  "CMakeFiles/test_begin_until.dir/tests/test_begin_until.cpp.o.d"
+  "test_begin_until"
+  "test_begin_until.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_begin_until.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_bitwise.dir/tests/test_bitwise.cpp.o"
+  "CMakeFiles/test_bitwise.dir/tests/test_bitwise.cpp.o.d"
+  "test_bitwise"
+  "test_bitwise.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_bitwise.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_bytecode_io.dir/tests/test_bytecode_io.cpp.o"
+  "CMakeFiles/test_bytecode_io.dir/tests/test_bytecode_io.cpp.o.d"
+  "test_bytecode_io"
+  "test_bytecode_io.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_bytecode_io.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_c.dir/tests/test_c.c.o"
+  "CMakeFiles/test_c.dir/tests/test_c.c.o.d"
+  "test_c"
+  "test_c.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang C)
+  include(CMakeFiles/test_c.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_case_insensitive.dir/tests/test_case_insensitive.cpp.o"
+  "CMakeFiles/test_case_insensitive.dir/tests/test_case_insensitive.cpp.o.d"
+  "test_case_insensitive"
+  "test_case_insensitive.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_case_insensitive.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
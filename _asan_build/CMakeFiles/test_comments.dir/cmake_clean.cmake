@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_comments.dir/tests/test_comments.cpp.o"
+  "CMakeFiles/test_comments.dir/tests/test_comments.cpp.o.d"
+  "test_comments"
+  "test_comments.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_comments.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_composite.dir/tests/test_composite.cpp.o"
+  "CMakeFiles/test_composite.dir/tests/test_composite.cpp.o.d"
+  "test_composite"
+  "test_composite.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_composite.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_const_eval.dir/tests/test_const_eval.cpp.o"
+  "CMakeFiles/test_const_eval.dir/tests/test_const_eval.cpp.o.d"
+  "test_const_eval"
+  "test_const_eval.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_const_eval.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_constant.dir/tests/test_constant.cpp.o"
+  "CMakeFiles/test_constant.dir/tests/test_constant.cpp.o.d"
+  "test_constant"
+  "test_constant.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_constant.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
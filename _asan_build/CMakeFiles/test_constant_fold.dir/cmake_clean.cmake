@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_constant_fold.dir/tests/test_constant_fold.cpp.o"
+  "CMakeFiles/test_constant_fold.dir/tests/test_constant_fold.cpp.o.d"
+  "test_constant_fold"
+  "test_constant_fold.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_constant_fold.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
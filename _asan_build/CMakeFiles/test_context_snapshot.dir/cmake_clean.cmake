@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_context_snapshot.dir/tests/test_context_snapshot.cpp.o"
+  "CMakeFiles/test_context_snapshot.dir/tests/test_context_snapshot.cpp.o.d"
+  "test_context_snapshot"
+  "test_context_snapshot.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_context_snapshot.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
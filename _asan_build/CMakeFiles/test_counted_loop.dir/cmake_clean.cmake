@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_counted_loop.dir/tests/test_counted_loop.cpp.o"
+  "CMakeFiles/test_counted_loop.dir/tests/test_counted_loop.cpp.o.d"
+  "test_counted_loop"
+  "test_counted_loop.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_counted_loop.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
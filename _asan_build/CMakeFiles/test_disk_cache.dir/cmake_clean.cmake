@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_disk_cache.dir/tests/test_disk_cache.cpp.o"
+  "CMakeFiles/test_disk_cache.dir/tests/test_disk_cache.cpp.o.d"
+  "test_disk_cache"
+  "test_disk_cache.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_disk_cache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
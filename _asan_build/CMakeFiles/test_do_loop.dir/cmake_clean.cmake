@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_do_loop.dir/tests/test_do_loop.cpp.o"
+  "CMakeFiles/test_do_loop.dir/tests/test_do_loop.cpp.o.d"
+  "test_do_loop"
+  "test_do_loop.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_do_loop.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
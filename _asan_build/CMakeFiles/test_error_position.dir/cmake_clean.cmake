@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_error_position.dir/tests/test_error_position.cpp.o"
+  "CMakeFiles/test_error_position.dir/tests/test_error_position.cpp.o.d"
+  "test_error_position"
+  "test_error_position.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_error_position.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
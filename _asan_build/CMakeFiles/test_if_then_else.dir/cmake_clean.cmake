@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_if_then_else.dir/tests/test_if_then_else.cpp.o"
+  "CMakeFiles/test_if_then_else.dir/tests/test_if_then_else.cpp.o.d"
+  "test_if_then_else"
+  "test_if_then_else.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_if_then_else.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
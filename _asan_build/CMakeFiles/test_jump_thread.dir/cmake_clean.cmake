@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_jump_thread.dir/tests/test_jump_thread.cpp.o"
+  "CMakeFiles/test_jump_thread.dir/tests/test_jump_thread.cpp.o.d"
+  "test_jump_thread"
+  "test_jump_thread.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_jump_thread.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_kat.dir/tests/kat_runner.cpp.o"
+  "CMakeFiles/test_kat.dir/tests/kat_runner.cpp.o.d"
+  "CMakeFiles/test_kat.dir/tests/program_gen.cpp.o"
+  "CMakeFiles/test_kat.dir/tests/program_gen.cpp.o.d"
+  "CMakeFiles/test_kat.dir/tests/test_kat.cpp.o"
+  "CMakeFiles/test_kat.dir/tests/test_kat.cpp.o.d"
+  "test_kat"
+  "test_kat.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_kat.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_lex_cache.dir/tests/test_lex_cache.cpp.o"
+  "CMakeFiles/test_lex_cache.dir/tests/test_lex_cache.cpp.o.d"
+  "test_lex_cache"
+  "test_lex_cache.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_lex_cache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_literal_encoding.dir/tests/test_literal_encoding.cpp.o"
+  "CMakeFiles/test_literal_encoding.dir/tests/test_literal_encoding.cpp.o.d"
+  "test_literal_encoding"
+  "test_literal_encoding.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_literal_encoding.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
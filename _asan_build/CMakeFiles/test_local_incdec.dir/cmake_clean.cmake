@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_local_incdec.dir/tests/test_local_incdec.cpp.o"
+  "CMakeFiles/test_local_incdec.dir/tests/test_local_incdec.cpp.o.d"
+  "test_local_incdec"
+  "test_local_incdec.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_local_incdec.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
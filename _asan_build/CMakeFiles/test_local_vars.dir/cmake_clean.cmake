@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_local_vars.dir/tests/test_local_vars.cpp.o"
+  "CMakeFiles/test_local_vars.dir/tests/test_local_vars.cpp.o.d"
+  "test_local_vars"
+  "test_local_vars.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_local_vars.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
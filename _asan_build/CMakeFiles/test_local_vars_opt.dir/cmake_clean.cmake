@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_local_vars_opt.dir/tests/test_local_vars_opt.cpp.o"
+  "CMakeFiles/test_local_vars_opt.dir/tests/test_local_vars_opt.cpp.o.d"
+  "test_local_vars_opt"
+  "test_local_vars_opt.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_local_vars_opt.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_loop_locals.dir/tests/test_loop_locals.cpp.o"
+  "CMakeFiles/test_loop_locals.dir/tests/test_loop_locals.cpp.o.d"
+  "test_loop_locals"
+  "test_loop_locals.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_loop_locals.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_memory_access.dir/tests/test_memory_access.cpp.o"
+  "CMakeFiles/test_memory_access.dir/tests/test_memory_access.cpp.o.d"
+  "test_memory_access"
+  "test_memory_access.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_memory_access.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_recurse.dir/tests/test_recurse.cpp.o"
+  "CMakeFiles/test_recurse.dir/tests/test_recurse.cpp.o.d"
+  "test_recurse"
+  "test_recurse.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_recurse.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
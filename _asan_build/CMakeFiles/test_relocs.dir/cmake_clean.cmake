@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_relocs.dir/tests/test_relocs.cpp.o"
+  "CMakeFiles/test_relocs.dir/tests/test_relocs.cpp.o.d"
+  "test_relocs"
+  "test_relocs.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_relocs.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
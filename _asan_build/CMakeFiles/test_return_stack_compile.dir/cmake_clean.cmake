@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_return_stack_compile.dir/tests/test_return_stack_compile.cpp.o"
+  "CMakeFiles/test_return_stack_compile.dir/tests/test_return_stack_compile.cpp.o.d"
+  "test_return_stack_compile"
+  "test_return_stack_compile.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_return_stack_compile.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_source_len.dir/tests/test_source_len.cpp.o"
+  "CMakeFiles/test_source_len.dir/tests/test_source_len.cpp.o.d"
+  "test_source_len"
+  "test_source_len.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_source_len.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
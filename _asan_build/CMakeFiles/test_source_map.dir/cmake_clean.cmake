@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_source_map.dir/tests/test_source_map.cpp.o"
+  "CMakeFiles/test_source_map.dir/tests/test_source_map.cpp.o.d"
+  "test_source_map"
+  "test_source_map.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_source_map.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
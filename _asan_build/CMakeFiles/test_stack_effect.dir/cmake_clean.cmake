@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_stack_effect.dir/tests/test_stack_effect.cpp.o"
+  "CMakeFiles/test_stack_effect.dir/tests/test_stack_effect.cpp.o.d"
+  "test_stack_effect"
+  "test_stack_effect.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_stack_effect.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_stream.dir/tests/test_stream.cpp.o"
+  "CMakeFiles/test_stream.dir/tests/test_stream.cpp.o.d"
+  "test_stream"
+  "test_stream.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_stream.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
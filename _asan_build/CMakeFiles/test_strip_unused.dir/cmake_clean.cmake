@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_strip_unused.dir/tests/test_strip_unused.cpp.o"
+  "CMakeFiles/test_strip_unused.dir/tests/test_strip_unused.cpp.o.d"
+  "test_strip_unused"
+  "test_strip_unused.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_strip_unused.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
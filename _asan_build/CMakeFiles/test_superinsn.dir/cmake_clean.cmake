@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_superinsn.dir/tests/test_superinsn.cpp.o"
+  "CMakeFiles/test_superinsn.dir/tests/test_superinsn.cpp.o.d"
+  "test_superinsn"
+  "test_superinsn.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_superinsn.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_sys_compile.dir/tests/test_sys_compile.cpp.o"
+  "CMakeFiles/test_sys_compile.dir/tests/test_sys_compile.cpp.o.d"
+  "test_sys_compile"
+  "test_sys_compile.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_sys_compile.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
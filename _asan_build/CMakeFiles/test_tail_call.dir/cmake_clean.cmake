@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_tail_call.dir/tests/test_tail_call.cpp.o"
+  "CMakeFiles/test_tail_call.dir/tests/test_tail_call.cpp.o.d"
+  "test_tail_call"
+  "test_tail_call.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_tail_call.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
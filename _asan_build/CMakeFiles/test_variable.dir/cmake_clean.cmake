@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_variable.dir/tests/test_variable.cpp.o"
+  "CMakeFiles/test_variable.dir/tests/test_variable.cpp.o.d"
+  "test_variable"
+  "test_variable.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_variable.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_while_repeat.dir/tests/test_while_repeat.cpp.o"
+  "CMakeFiles/test_while_repeat.dir/tests/test_while_repeat.cpp.o.d"
+  "test_while_repeat"
+  "test_while_repeat.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_while_repeat.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
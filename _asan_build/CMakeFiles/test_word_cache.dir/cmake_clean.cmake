@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_word_cache.dir/tests/test_word_cache.cpp.o"
+  "CMakeFiles/test_word_cache.dir/tests/test_word_cache.cpp.o.d"
+  "test_word_cache"
+  "test_word_cache.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_word_cache.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
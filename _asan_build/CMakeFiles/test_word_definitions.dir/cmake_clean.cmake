@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_word_definitions.dir/tests/test_word_definitions.cpp.o"
+  "CMakeFiles/test_word_definitions.dir/tests/test_word_definitions.cpp.o.d"
+  "test_word_definitions"
+  "test_word_definitions.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_word_definitions.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
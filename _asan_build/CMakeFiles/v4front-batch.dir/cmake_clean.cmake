@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v4front-batch.dir/tools/batch.cpp.o"
+  "CMakeFiles/v4front-batch.dir/tools/batch.cpp.o.d"
+  "v4front-batch"
+  "v4front-batch.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v4front-batch.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v4front-bench.dir/tools/bench.cpp.o"
+  "CMakeFiles/v4front-bench.dir/tools/bench.cpp.o.d"
+  "v4front-bench"
+  "v4front-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v4front-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v4front-codebench.dir/tests/kat_runner.cpp.o"
+  "CMakeFiles/v4front-codebench.dir/tests/kat_runner.cpp.o.d"
+  "CMakeFiles/v4front-codebench.dir/tools/codebench.cpp.o"
+  "CMakeFiles/v4front-codebench.dir/tools/codebench.cpp.o.d"
+  "v4front-codebench"
+  "v4front-codebench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v4front-codebench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
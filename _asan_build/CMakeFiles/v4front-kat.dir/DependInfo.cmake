@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/kat_runner.cpp" "CMakeFiles/v4front-kat.dir/tests/kat_runner.cpp.o" "gcc" "CMakeFiles/v4front-kat.dir/tests/kat_runner.cpp.o.d"
+  "/root/repo/tools/kat.cpp" "CMakeFiles/v4front-kat.dir/tools/kat.cpp.o" "gcc" "CMakeFiles/v4front-kat.dir/tools/kat.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_asan_build/CMakeFiles/v4front.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
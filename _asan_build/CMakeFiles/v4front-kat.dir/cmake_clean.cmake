@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v4front-kat.dir/tests/kat_runner.cpp.o"
+  "CMakeFiles/v4front-kat.dir/tests/kat_runner.cpp.o.d"
+  "CMakeFiles/v4front-kat.dir/tools/kat.cpp.o"
+  "CMakeFiles/v4front-kat.dir/tools/kat.cpp.o.d"
+  "v4front-kat"
+  "v4front-kat.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v4front-kat.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v4front-ngrams.dir/tools/ngrams.cpp.o"
+  "CMakeFiles/v4front-ngrams.dir/tools/ngrams.cpp.o.d"
+  "v4front-ngrams"
+  "v4front-ngrams.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v4front-ngrams.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,37 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/bytecode_io.cpp" "CMakeFiles/v4front.dir/src/bytecode_io.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/bytecode_io.cpp.o.d"
+  "/root/repo/src/compile.cpp" "CMakeFiles/v4front.dir/src/compile.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/compile.cpp.o.d"
+  "/root/repo/src/compress.cpp" "CMakeFiles/v4front.dir/src/compress.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/compress.cpp.o.d"
+  "/root/repo/src/const_eval.cpp" "CMakeFiles/v4front.dir/src/const_eval.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/const_eval.cpp.o.d"
+  "/root/repo/src/disasm.cpp" "CMakeFiles/v4front.dir/src/disasm.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/disasm.cpp.o.d"
+  "/root/repo/src/disk_cache.cpp" "CMakeFiles/v4front.dir/src/disk_cache.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/disk_cache.cpp.o.d"
+  "/root/repo/src/image.cpp" "CMakeFiles/v4front.dir/src/image.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/image.cpp.o.d"
+  "/root/repo/src/ir.cpp" "CMakeFiles/v4front.dir/src/ir.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/ir.cpp.o.d"
+  "/root/repo/src/jump_opt.cpp" "CMakeFiles/v4front.dir/src/jump_opt.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/jump_opt.cpp.o.d"
+  "/root/repo/src/lexer.cpp" "CMakeFiles/v4front.dir/src/lexer.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/lexer.cpp.o.d"
+  "/root/repo/src/passes.cpp" "CMakeFiles/v4front.dir/src/passes.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/passes.cpp.o.d"
+  "/root/repo/src/peephole.cpp" "CMakeFiles/v4front.dir/src/peephole.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/peephole.cpp.o.d"
+  "/root/repo/src/profile.cpp" "CMakeFiles/v4front.dir/src/profile.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/profile.cpp.o.d"
+  "/root/repo/src/stack_effect.cpp" "CMakeFiles/v4front.dir/src/stack_effect.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/stack_effect.cpp.o.d"
+  "/root/repo/src/superinsn.cpp" "CMakeFiles/v4front.dir/src/superinsn.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/superinsn.cpp.o.d"
+  "/root/repo/src/verify.cpp" "CMakeFiles/v4front.dir/src/verify.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/verify.cpp.o.d"
+  "/root/repo/src/word_cache.cpp" "CMakeFiles/v4front.dir/src/word_cache.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/word_cache.cpp.o.d"
+  "/root/repo/src/work_pool.cpp" "CMakeFiles/v4front.dir/src/work_pool.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/work_pool.cpp.o.d"
+  "/root/repo/src/yield.cpp" "CMakeFiles/v4front.dir/src/yield.cpp.o" "gcc" "CMakeFiles/v4front.dir/src/yield.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
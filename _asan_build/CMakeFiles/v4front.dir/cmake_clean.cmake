@@ -0,0 +1,47 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v4front.dir/src/bytecode_io.cpp.o"
+  "CMakeFiles/v4front.dir/src/bytecode_io.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/compile.cpp.o"
+  "CMakeFiles/v4front.dir/src/compile.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/compress.cpp.o"
+  "CMakeFiles/v4front.dir/src/compress.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/const_eval.cpp.o"
+  "CMakeFiles/v4front.dir/src/const_eval.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/disasm.cpp.o"
+  "CMakeFiles/v4front.dir/src/disasm.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/disk_cache.cpp.o"
+  "CMakeFiles/v4front.dir/src/disk_cache.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/image.cpp.o"
+  "CMakeFiles/v4front.dir/src/image.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/ir.cpp.o"
+  "CMakeFiles/v4front.dir/src/ir.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/jump_opt.cpp.o"
+  "CMakeFiles/v4front.dir/src/jump_opt.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/lexer.cpp.o"
+  "CMakeFiles/v4front.dir/src/lexer.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/passes.cpp.o"
+  "CMakeFiles/v4front.dir/src/passes.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/peephole.cpp.o"
+  "CMakeFiles/v4front.dir/src/peephole.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/profile.cpp.o"
+  "CMakeFiles/v4front.dir/src/profile.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/stack_effect.cpp.o"
+  "CMakeFiles/v4front.dir/src/stack_effect.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/superinsn.cpp.o"
+  "CMakeFiles/v4front.dir/src/superinsn.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/verify.cpp.o"
+  "CMakeFiles/v4front.dir/src/verify.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/word_cache.cpp.o"
+  "CMakeFiles/v4front.dir/src/word_cache.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/work_pool.cpp.o"
+  "CMakeFiles/v4front.dir/src/work_pool.cpp.o.d"
+  "CMakeFiles/v4front.dir/src/yield.cpp.o"
+  "CMakeFiles/v4front.dir/src/yield.cpp.o.d"
+  "libv4front.a"
+  "libv4front.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v4front.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
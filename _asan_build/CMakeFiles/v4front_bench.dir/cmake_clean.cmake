@@ -0,0 +1,8 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v4front_bench"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang )
+  include(CMakeFiles/v4front_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
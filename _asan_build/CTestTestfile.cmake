@@ -0,0 +1,128 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_asan_build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(test_errors "/root/repo/_asan_build/test_errors")
+set_tests_properties(test_errors PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;241;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_disasm "/root/repo/_asan_build/test_disasm")
+set_tests_properties(test_disasm PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;242;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_compile "/root/repo/_asan_build/test_compile")
+set_tests_properties(test_compile PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;243;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_comments "/root/repo/_asan_build/test_comments")
+set_tests_properties(test_comments PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;244;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_constant "/root/repo/_asan_build/test_constant")
+set_tests_properties(test_constant PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;245;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_variable "/root/repo/_asan_build/test_variable")
+set_tests_properties(test_variable PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;246;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_arithmetic "/root/repo/_asan_build/test_arithmetic")
+set_tests_properties(test_arithmetic PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;247;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_comparison "/root/repo/_asan_build/test_comparison")
+set_tests_properties(test_comparison PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;248;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_bitwise "/root/repo/_asan_build/test_bitwise")
+set_tests_properties(test_bitwise PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;249;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_stack "/root/repo/_asan_build/test_stack")
+set_tests_properties(test_stack PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;250;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_composite "/root/repo/_asan_build/test_composite")
+set_tests_properties(test_composite PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;251;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_case_insensitive "/root/repo/_asan_build/test_case_insensitive")
+set_tests_properties(test_case_insensitive PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;252;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_if_then_else "/root/repo/_asan_build/test_if_then_else")
+set_tests_properties(test_if_then_else PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;253;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_begin_until "/root/repo/_asan_build/test_begin_until")
+set_tests_properties(test_begin_until PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;254;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_while_repeat "/root/repo/_asan_build/test_while_repeat")
+set_tests_properties(test_while_repeat PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;255;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_begin_again "/root/repo/_asan_build/test_begin_again")
+set_tests_properties(test_begin_again PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;256;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_return_stack_compile "/root/repo/_asan_build/test_return_stack_compile")
+set_tests_properties(test_return_stack_compile PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;257;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_do_loop "/root/repo/_asan_build/test_do_loop")
+set_tests_properties(test_do_loop PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;258;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_word_definitions "/root/repo/_asan_build/test_word_definitions")
+set_tests_properties(test_word_definitions PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;259;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_memory_access "/root/repo/_asan_build/test_memory_access")
+set_tests_properties(test_memory_access PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;260;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_context "/root/repo/_asan_build/test_context")
+set_tests_properties(test_context PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;261;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_error_position "/root/repo/_asan_build/test_error_position")
+set_tests_properties(test_error_position PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;262;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_sys_compile "/root/repo/_asan_build/test_sys_compile")
+set_tests_properties(test_sys_compile PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;263;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_local_incdec "/root/repo/_asan_build/test_local_incdec")
+set_tests_properties(test_local_incdec PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;264;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_local_vars "/root/repo/_asan_build/test_local_vars")
+set_tests_properties(test_local_vars PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;265;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_local_vars_opt "/root/repo/_asan_build/test_local_vars_opt")
+set_tests_properties(test_local_vars_opt PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;266;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_recurse "/root/repo/_asan_build/test_recurse")
+set_tests_properties(test_recurse PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;267;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_bytecode_io "/root/repo/_asan_build/test_bytecode_io")
+set_tests_properties(test_bytecode_io PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;268;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_task "/root/repo/_asan_build/test_task")
+set_tests_properties(test_task PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;269;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_allocator "/root/repo/_asan_build/test_allocator")
+set_tests_properties(test_allocator PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;270;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_image "/root/repo/_asan_build/test_image")
+set_tests_properties(test_image PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;271;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_peephole "/root/repo/_asan_build/test_peephole")
+set_tests_properties(test_peephole PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;272;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_literal_encoding "/root/repo/_asan_build/test_literal_encoding")
+set_tests_properties(test_literal_encoding PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;273;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_constant_fold "/root/repo/_asan_build/test_constant_fold")
+set_tests_properties(test_constant_fold PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;274;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_inline "/root/repo/_asan_build/test_inline")
+set_tests_properties(test_inline PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;275;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_tail_call "/root/repo/_asan_build/test_tail_call")
+set_tests_properties(test_tail_call PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;276;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_passes "/root/repo/_asan_build/test_passes")
+set_tests_properties(test_passes PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;277;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_jump_thread "/root/repo/_asan_build/test_jump_thread")
+set_tests_properties(test_jump_thread PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;278;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_strip_unused "/root/repo/_asan_build/test_strip_unused")
+set_tests_properties(test_strip_unused PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;279;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_loop_locals "/root/repo/_asan_build/test_loop_locals")
+set_tests_properties(test_loop_locals PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;280;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_counted_loop "/root/repo/_asan_build/test_counted_loop")
+set_tests_properties(test_counted_loop PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;281;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_superinsn "/root/repo/_asan_build/test_superinsn")
+set_tests_properties(test_superinsn PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;282;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_stream "/root/repo/_asan_build/test_stream")
+set_tests_properties(test_stream PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;283;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_source_len "/root/repo/_asan_build/test_source_len")
+set_tests_properties(test_source_len PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;284;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_tokenizer "/root/repo/_asan_build/test_tokenizer")
+set_tests_properties(test_tokenizer PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;285;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_context_snapshot "/root/repo/_asan_build/test_context_snapshot")
+set_tests_properties(test_context_snapshot PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;286;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_batch "/root/repo/_asan_build/test_batch")
+set_tests_properties(test_batch PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;287;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_word_cache "/root/repo/_asan_build/test_word_cache")
+set_tests_properties(test_word_cache PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;288;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_disk_cache "/root/repo/_asan_build/test_disk_cache")
+set_tests_properties(test_disk_cache PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;289;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_relocs "/root/repo/_asan_build/test_relocs")
+set_tests_properties(test_relocs PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;290;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_stats "/root/repo/_asan_build/test_stats")
+set_tests_properties(test_stats PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;291;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_source_map "/root/repo/_asan_build/test_source_map")
+set_tests_properties(test_source_map PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;292;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_stack_effect "/root/repo/_asan_build/test_stack_effect")
+set_tests_properties(test_stack_effect PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;293;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_verify "/root/repo/_asan_build/test_verify")
+set_tests_properties(test_verify PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;294;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_session "/root/repo/_asan_build/test_session")
+set_tests_properties(test_session PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;295;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_const_eval "/root/repo/_asan_build/test_const_eval")
+set_tests_properties(test_const_eval PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;296;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_auto_yield "/root/repo/_asan_build/test_auto_yield")
+set_tests_properties(test_auto_yield PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;297;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_profile "/root/repo/_asan_build/test_profile")
+set_tests_properties(test_profile PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;298;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_lex_cache "/root/repo/_asan_build/test_lex_cache")
+set_tests_properties(test_lex_cache PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;299;add_v4front_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_kat "/root/repo/_asan_build/test_kat")
+set_tests_properties(test_kat PROPERTIES  WORKING_DIRECTORY "/root/repo" _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;310;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(test_c "/root/repo/_asan_build/test_c")
+set_tests_properties(test_c PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;237;add_test;/root/repo/CMakeLists.txt;316;add_v4front_test;/root/repo/CMakeLists.txt;0;")
@@ -11,21 +11,66 @@ extern "C"
 // Include unified error definitions
 #include "v4front/errors.h"
 
+  // ---------------------------------------------------------------------------
+  // V4FrontStackEffect
+  //  - Stack use of a word inferred at compile time (V4FRONT_OPT_STACK_EFFECTS):
+  //    its ( in -- out ) effect and the deepest stacks it reaches, so a VM can
+  //    size stacks up front and skip overflow checks inside verified words.
+  //  - Depths are in cells. max_data counts the in cells; max_return counts
+  //    the word's own return stack cells (>R, DO loops), not call frames.
+  //  - known is 0 (and every other field 0) when no fixed effect exists: the
+  //    word calls a context word, an import, itself (non-tail RECURSE) or a
+  //    word of unknown effect, or uses an opcode whose stack use the VM
+  //    defines (SYS and the task opcodes SPAWN, TASK-EXIT, SEND and RECEIVE).
+  //  - A word that never returns (BEGIN ... AGAIN) has out 0.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint8_t known;        // 1 if the fields below hold
+    uint16_t in;          // Data stack cells consumed
+    uint16_t out;         // Data stack cells left in their place
+    uint16_t max_data;    // Deepest data stack use, counting the in cells
+    uint16_t max_return;  // Deepest return stack use above the entry depth
+  } V4FrontStackEffect;
+
   // ---------------------------------------------------------------------------
   // V4FrontWord
   //  - Represents a single compiled word definition.
   // ---------------------------------------------------------------------------
   typedef struct
   {
-    char* name;         // Word name (dynamically allocated)
-    uint8_t* code;      // Bytecode (dynamically allocated)
-    uint32_t code_len;  // Length of bytecode
+    char* name;                 // Word name
+    uint8_t* code;              // Bytecode
+    uint32_t code_len;          // Length of bytecode
+    V4FrontStackEffect effect;  // Inferred stack use (all 0 unless compiled with
+                                // V4FRONT_OPT_STACK_EFFECTS)
   } V4FrontWord;
 
+  // ---------------------------------------------------------------------------
+  // V4FrontReloc
+  //  - One CALL site of compiled code (see V4FRONT_OPT_RELOCS).
+  //  - A local call targets a word of the same buffer (its index in words); an
+  //    external call targets a VM word index registered in the context.
+  //  - Sites inside fused superinstructions are listed too: offset always
+  //    names the operand, not the opcode.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    int32_t unit;     // Code of the site: -1 for main code, else an index into words
+    uint32_t offset;  // Offset of the 16-bit little-endian CALL operand in that code
+    uint16_t kind;    // V4FRONT_RELOC_LOCAL or V4FRONT_RELOC_EXTERNAL
+    uint16_t target;  // Operand value: word index (local) or VM word index (external)
+  } V4FrontReloc;
+
+#define V4FRONT_RELOC_LOCAL 0
+#define V4FRONT_RELOC_EXTERNAL 1
+
   // ---------------------------------------------------------------------------
   // V4FrontBuf
   //  - Holds dynamically allocated bytecode output.
   //  - Can contain multiple word definitions and main code.
+  //  - Compiler output is a single allocation (see `block`); words, names and
+  //    code all point into it.
   //  - The caller must call v4front_free() when done.
   // ---------------------------------------------------------------------------
   typedef struct
@@ -34,8 +79,32 @@ extern "C"
     int word_count;      // Number of words in array
     uint8_t* data;       // Main bytecode (may be NULL if only words defined)
     size_t size;         // Size of main bytecode
+    void* block;         // Owning allocation (internal; NULL if fields are separately
+                         // malloc'd, e.g. by v4front_load_bytecode)
+    V4FrontReloc* relocs;  // CALL sites, main code first, then by word and offset
+                           // (NULL unless compiled with V4FRONT_OPT_RELOCS)
+    uint32_t reloc_count;  // Entries in relocs
+    const uint8_t* source_map;  // Encoded source map (NULL unless compiled with
+                                // V4FRONT_OPT_SOURCE_MAP; see
+                                // v4front_source_map_lookup)
+    uint32_t source_map_size;   // Size of source_map in bytes
   } V4FrontBuf;
 
+  // ---------------------------------------------------------------------------
+  // V4FrontAllocator
+  //  - Memory hook for compilation.
+  //  - alloc must return memory aligned for any scalar type (like malloc), or
+  //    NULL when exhausted (compilation then fails with OutOfMemory).
+  //  - free may be NULL for pools that are reclaimed wholesale by the host.
+  //  - The allocator must outlive every V4FrontBuf compiled with it.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    void* (*alloc)(void* user, size_t size);
+    void (*free)(void* user, void* ptr);
+    void* user;
+  } V4FrontAllocator;
+
   // ---------------------------------------------------------------------------
   // v4front_err
   //  - Error code type (int).
@@ -54,6 +123,17 @@ extern "C"
   v4front_err v4front_compile(const char* source, V4FrontBuf* out_buf, char* err,
                               size_t err_cap);
 
+  // ---------------------------------------------------------------------------
+  // v4front_compile_n
+  //  - Same as v4front_compile, but source is the len bytes at source and
+  //    needs no NUL terminator (e.g. a mapped file or a packet buffer). Every
+  //    byte is source text; nothing past source + len is read.
+  //  - The other *_n variants below differ from their NUL-terminated
+  //    counterparts in the same way.
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_compile_n(const char* source, size_t len, V4FrontBuf* out_buf,
+                                char* err, size_t err_cap);
+
   // ---------------------------------------------------------------------------
   // v4front_compile_word
   //  - Same as v4front_compile, but carries a word name for future extensions.
@@ -70,6 +150,115 @@ extern "C"
   // ---------------------------------------------------------------------------
   void v4front_free(V4FrontBuf* buf);
 
+  // ---------------------------------------------------------------------------
+  // v4front_relocate
+  //  - Adds local_base to every local CALL of buf, e.g. to load its words
+  //    after local_base words already in the VM or to link several buffers.
+  //  - Only the sites in buf->relocs are visited (no decoding), and their
+  //    targets are updated, so a buffer can be relocated again.
+  //  - A buffer compiled without V4FRONT_OPT_RELOCS has no sites: no-op.
+  //
+  //  @return 0 on success, DictionaryFull if a target would exceed 32767
+  //          (buf is then unchanged), BufferTooSmall if buf is NULL
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_relocate(V4FrontBuf* buf, uint32_t local_base);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontSourceLoc / v4front_source_map_lookup
+  //  - Source position of the instruction at offset pc of a unit (-1 for main
+  //    code, else a word index, as in V4FrontReloc), read from a source map
+  //    (V4FrontBuf::source_map, or the V4B_SECTION_DEBUG section of a .v4b
+  //    file, which is used in place when mapped).
+  //  - The entry with the greatest offset <= pc wins: every instruction is
+  //    attributed to the token that emitted it, also after optimization
+  //    (fused or rewritten instructions keep their first token).
+  //  - The map is decoded as it is read; nothing is allocated, so a sampling
+  //    profiler can call this on the device. See docs/bytecode-format.md for
+  //    the encoding.
+  //
+  //  @return 0 on success (*out is all zeros, line 0, if no entry covers pc),
+  //          InvalidImage if the map is malformed, BufferTooSmall if out is
+  //          NULL
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t offset;  // Byte offset of the token in the source
+    uint32_t line;    // 1-based line (0: unknown)
+    uint32_t column;  // 1-based column
+  } V4FrontSourceLoc;
+
+  v4front_err v4front_source_map_lookup(const uint8_t* map, size_t size, int32_t unit,
+                                        uint32_t pc, V4FrontSourceLoc* out);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontTaskResources / v4front_task_resources
+  //  - Worst-case stack and local use of a task whose entry is word of buf,
+  //    over everything the entry calls, so each SPAWNed task can be given
+  //    exactly the stacks it needs.
+  //  - return_depth counts a cell for the return address of every active call
+  //    (the entry's own included), DO loop frames and >R cells; locals counts
+  //    the slots of the frames of every active call.
+  //  - Stack use of SYS, the task opcodes the VM defines (SPAWN, TASK-EXIT,
+  //    SEND, RECEIVE, RECEIVE-BLOCKING) and fused superinstructions is taken
+  //    from vm_ops (256 entries indexed by opcode, known == 1 where defined;
+  //    may be NULL). Fused opcodes cannot be decoded, so buffers compiled with
+  //    superinstructions are only analyzed where they contain none.
+  //  - Where no bound exists, reason says why and culprit names the word it
+  //    was found in; the depths are then 0.
+  //
+  //  @return 0 on success, BufferTooSmall if buf or out is NULL, UnknownToken
+  //          if word is not a word index of buf, OutOfMemory
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t reason;        // V4FRONT_TASK_BOUNDED, or why there is no bound
+    int32_t culprit;        // Word where the reason was found (-1 if bounded)
+    uint32_t data_depth;    // Deepest data stack, in cells (entry inputs included)
+    uint32_t return_depth;  // Deepest return stack, in cells
+    uint32_t locals;        // Most local slots in use at once
+    uint32_t call_depth;    // Deepest CALL nesting below the entry
+  } V4FrontTaskResources;
+
+#define V4FRONT_TASK_BOUNDED 0
+#define V4FRONT_TASK_RECURSION 1  // A call cycle (RECURSE not lowered to a loop)
+#define V4FRONT_TASK_EXTERNAL_CALL 2  // Calls a word outside buf (context, import)
+#define V4FRONT_TASK_VM_OPCODE 3      // Opcode with VM-defined stack use not in vm_ops
+#define V4FRONT_TASK_UNBALANCED 4  // Depth differs between paths or grows per loop
+#define V4FRONT_TASK_UNDECODABLE 5  // Code cannot be decoded or runs out of its word
+
+  v4front_err v4front_task_resources(const V4FrontBuf* buf, int word,
+                                     const V4FrontStackEffect* vm_ops,
+                                     V4FrontTaskResources* out);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontLoop / v4front_find_yieldless_loops
+  //  - Finds the loops of buf in which a task never gives up the CPU. A loop
+  //    is a backward JMP/JZ/JNZ together with the code from its target to it.
+  //    It has no yield point if that code contains no TASK_YIELD (YIELD,
+  //    PAUSE), TASK_SLEEP or TASK_RECEIVE_BLOCKING and calls no word of buf
+  //    that contains one, directly or through its own calls. Calls of words
+  //    outside buf (context words) are assumed not to yield.
+  //  - Loops are listed main code first, then by word and by the position of
+  //    the jump, so inner loops come before the loops around them. Each one
+  //    is reported on its own.
+  //  - Writes the first cap loops to out and the number found to *count (cap
+  //    0 only counts). v4front_source_map_lookup() maps the offsets back to
+  //    source lines.
+  //
+  //  @return 0 on success, BufferTooSmall if buf or count is NULL (or out with
+  //          cap > 0), InvalidImage if the code cannot be decoded (fused
+  //          superinstructions), OutOfMemory
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    int32_t unit;    // -1 for main code, else the word index
+    uint32_t start;  // Offset of the first instruction of the loop (jump target)
+    uint32_t end;    // Offset of the backward jump
+  } V4FrontLoop;
+
+  v4front_err v4front_find_yieldless_loops(const V4FrontBuf* buf, V4FrontLoop* out,
+                                           uint32_t cap, uint32_t* count);
+
   // ===========================================================================
   // Stateful Compiler Context (for REPL support)
   // ===========================================================================
@@ -89,6 +278,22 @@ extern "C"
   // ---------------------------------------------------------------------------
   V4FrontContext* v4front_context_create(void);
 
+  // ---------------------------------------------------------------------------
+  // v4front_context_snapshot
+  //  - Returns a read-only snapshot of the words registered in ctx.
+  //  - A snapshot is a V4FrontContext: pass it to any compile function and
+  //    release it with v4front_context_destroy(). Registering words into a
+  //    snapshot fails with ReadOnlyContext; resetting it does nothing.
+  //  - Any number of threads may compile against one snapshot at the same time
+  //    without locking. Taking a snapshot of a snapshot only adds a reference
+  //    and may also be done from any thread.
+  //  - ctx itself stays writable. Its next register/reset copies the shared
+  //    word list first (copy-on-write), so snapshots never see later changes.
+  //    Calls on a writable context still need external synchronization.
+  //  - Returns NULL if ctx is NULL or on allocation failure.
+  // ---------------------------------------------------------------------------
+  V4FrontContext* v4front_context_snapshot(const V4FrontContext* ctx);
+
   // ---------------------------------------------------------------------------
   // v4front_context_destroy
   //  - Destroys a compiler context and frees all associated resources.
@@ -127,9 +332,15 @@ extern "C"
                                            V4FrontBuf* out_buf, char* err,
                                            size_t err_cap);
 
+  // Length-delimited v4front_compile_with_context (see v4front_compile_n)
+  v4front_err v4front_compile_with_context_n(V4FrontContext* ctx, const char* source,
+                                             size_t len, V4FrontBuf* out_buf, char* err,
+                                             size_t err_cap);
+
   // ---------------------------------------------------------------------------
   // v4front_context_reset
-  //  - Clears all registered words from the context.
+  //  - Clears all registered words from the context and starts its data
+  //    space over at its base.
   //  - Should be called when the VM dictionary is reset.
   // ---------------------------------------------------------------------------
   void v4front_context_reset(V4FrontContext* ctx);
@@ -162,6 +373,96 @@ extern "C"
   // ---------------------------------------------------------------------------
   int v4front_context_find_word(const V4FrontContext* ctx, const char* name);
 
+  // ---------------------------------------------------------------------------
+  // v4front_context_set_data_space
+  //  - Places the addresses VARIABLE, CREATE and ALLOT hand out in
+  //    [base, base + size) and starts allocating at base again.
+  //  - Each successful compilation with ctx continues where the previous one
+  //    stopped, so words of different compilations never share addresses.
+  //    Failed compilations and snapshots (which keep a copy from the time
+  //    they were taken) do not move it; v4front_context_reset() starts over
+  //    at base.
+  //  - The default is 64 KiB at 0x10000 (DATA_SPACE_BASE and DATA_SPACE_SIZE
+  //    when the library is built).
+  //
+  //  @param ctx  Compiler context (not a snapshot)
+  //  @param base First address (a multiple of 4)
+  //  @param size Bytes available (base + size must not exceed 2^32)
+  //  @return 0 on success, InvalidOption for a bad range, ReadOnlyContext for a
+  //          snapshot
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_context_set_data_space(V4FrontContext* ctx, uint32_t base,
+                                             uint32_t size);
+
+  // ---------------------------------------------------------------------------
+  // v4front_context_get_here
+  //  - Returns the next free data space address of ctx (DATA_SPACE_BASE for
+  //    NULL).
+  // ---------------------------------------------------------------------------
+  uint32_t v4front_context_get_here(const V4FrontContext* ctx);
+
+  // ---------------------------------------------------------------------------
+  // v4front_context_set_word_cache
+  //  - Enables incremental recompilation: compilations with ctx keep every
+  //    colon definition they compile, and a later definition with the same
+  //    name, body text, options and word index whose words still resolve the
+  //    same way is copied instead of compiled.
+  //  - Changing a word also recompiles the words that use it. The output is
+  //    always identical to a compilation without the cache.
+  //  - The least recently used definitions are dropped once the cache holds
+  //    more than max_bytes. 0 disables the cache and frees it.
+  //  - The cache survives v4front_context_reset(). Snapshots have none.
+  //
+  //  @param ctx       Compiler context (not a snapshot)
+  //  @param max_bytes Memory limit of the cache (0: disabled, the default)
+  //  @return 0 on success, negative on error (ReadOnlyContext for a snapshot)
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_context_set_word_cache(V4FrontContext* ctx, size_t max_bytes);
+
+  typedef struct
+  {
+    uint32_t entries;   // Definitions held
+    size_t bytes;       // Memory held
+    uint32_t reused;    // Last successful compilation: definitions copied
+    uint32_t compiled;  // Last successful compilation: definitions compiled
+  } V4FrontWordCacheStats;
+
+  // Word cache statistics of ctx (all zero while the cache is disabled)
+  void v4front_context_get_word_cache_stats(const V4FrontContext* ctx,
+                                            V4FrontWordCacheStats* out);
+
+  // ---------------------------------------------------------------------------
+  // v4front_context_set_lex_cache
+  //  - Keeps the tokens of every source line compiled with ctx, keyed on the
+  //    exact line text, so that lines entered again (REPL history, a file
+  //    reloaded after a small edit) are not tokenized again: their tokens,
+  //    name hashes and number values are copied from the cache.
+  //  - Lines are tokenized on their own. A token is only used where the
+  //    compiler reaches it by skipping whitespace and comments, so comments
+  //    spanning lines and words that read ahead work as before; the output
+  //    is always identical to a compilation without the cache.
+  //  - The least recently used lines are dropped once the cache holds more
+  //    than max_bytes. 0 disables the cache and frees it.
+  //  - The cache survives v4front_context_reset(). Snapshots have none.
+  //
+  //  @param ctx       Compiler context (not a snapshot)
+  //  @param max_bytes Memory limit of the cache (0: disabled, the default)
+  //  @return 0 on success, negative on error (ReadOnlyContext for a snapshot)
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_context_set_lex_cache(V4FrontContext* ctx, size_t max_bytes);
+
+  typedef struct
+  {
+    uint32_t entries;  // Lines held
+    size_t bytes;      // Memory held
+    uint32_t hits;     // Last compilation: lines taken from the cache
+    uint32_t misses;   // Last compilation: lines tokenized
+  } V4FrontLexCacheStats;
+
+  // Lex cache statistics of ctx (all zero while the cache is disabled)
+  void v4front_context_get_lex_cache_stats(const V4FrontContext* ctx,
+                                           V4FrontLexCacheStats* out);
+
   // ===========================================================================
   // Detailed Error Information (for improved error messages)
   // ===========================================================================
@@ -197,6 +498,10 @@ extern "C"
   v4front_err v4front_compile_ex(const char* source, V4FrontBuf* out_buf,
                                  V4FrontError* error_out);
 
+  // Length-delimited v4front_compile_ex (see v4front_compile_n)
+  v4front_err v4front_compile_ex_n(const char* source, size_t len, V4FrontBuf* out_buf,
+                                   V4FrontError* error_out);
+
   // ---------------------------------------------------------------------------
   // v4front_compile_with_context_ex
   //  - Compiles source with context and detailed error information.
@@ -225,6 +530,464 @@ extern "C"
   void v4front_format_error(const V4FrontError* error, const char* source, char* out_buf,
                             size_t out_cap);
 
+  // ---------------------------------------------------------------------------
+  // v4front_compile_with_allocator
+  //  - Compiles source with all memory coming from a host allocator.
+  //  - Scratch memory is taken in a few large chunks and returned before this
+  //    function returns; the output is one block released by v4front_free().
+  //  - Otherwise identical to v4front_compile_with_context_ex().
+  //
+  //  @param ctx       Compiler context (may be NULL)
+  //  @param source    Source code to compile
+  //  @param allocator Memory hook (NULL selects malloc/free)
+  //  @param out_buf   Output buffer
+  //  @param error_out Error information output (may be NULL)
+  //  @return 0 on success, negative on error
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_compile_with_allocator(V4FrontContext* ctx, const char* source,
+                                             const V4FrontAllocator* allocator,
+                                             V4FrontBuf* out_buf,
+                                             V4FrontError* error_out);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontSuperinstruction
+  //  - A fused opcode advertised by the target VM: `length` (2..4) consecutive
+  //    instructions with opcodes pattern[0..length) become `opcode` followed by
+  //    their immediates, in order and at their original widths.
+  //  - If the pattern ends in JMP/JZ/JNZ, the fused instruction is a branch
+  //    with a rel16 operand (relative to its own end) and no other element may
+  //    carry an immediate. Otherwise the immediates total at most 4 bytes.
+  //  - opcode must not be a V4 opcode (opcodes.def).
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint8_t opcode;      // Fused opcode
+    uint8_t length;      // Number of pattern elements
+    uint8_t pattern[4];  // Opcodes of the fused instructions
+  } V4FrontSuperinstruction;
+
+  // ---------------------------------------------------------------------------
+  // V4FrontWordCount / V4FrontProfile
+  //  - An execution profile of a program: how often the VM ran each word.
+  //    Words are named (indices change between compilations) and matched
+  //    case-insensitively; a name listed twice has its counts added.
+  //  - Given as V4FrontCompileOptions::profile, it guides V4FRONT_OPT_INLINE
+  //    and orders words under V4FRONT_OPT_HOT_LAYOUT. Words the profile does
+  //    not name are treated as without one.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    const char* name;  // Word name (NUL-terminated)
+    uint64_t count;    // Times the word was called
+  } V4FrontWordCount;
+
+  typedef struct
+  {
+    V4FrontWordCount* words;
+    uint32_t count;  // Entries in words
+  } V4FrontProfile;
+
+  // ---------------------------------------------------------------------------
+  // v4front_parse_profile
+  //  - Parses a profile in text form: one "NAME COUNT" line per word (COUNT
+  //    decimal), fields separated by spaces or tabs. Blank lines and lines
+  //    starting with '#' are skipped.
+  //  - out receives one block (entries and names) released by
+  //    v4front_free_profile().
+  //
+  //  @param text       Profile text (needs no NUL terminator)
+  //  @param len        Length of text in bytes
+  //  @param out        Parsed profile
+  //  @param error_line 1-based line of a malformed entry (may be NULL)
+  //  @return 0 on success, InvalidProfile for a malformed line, OutOfMemory
+  //          (BufferTooSmall for NULL text or out)
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_parse_profile(const char* text, size_t len, V4FrontProfile* out,
+                                    uint32_t* error_line);
+
+  // ---------------------------------------------------------------------------
+  // v4front_load_profile
+  //  - Reads a profile file and parses it with v4front_parse_profile().
+  //
+  //  @return 0 on success, negative on error
+  //    -1: Invalid parameters (NULL filename or out)
+  //    -2: Failed to open or read the file
+  //    otherwise as v4front_parse_profile
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_load_profile(const char* filename, V4FrontProfile* out,
+                                   uint32_t* error_line);
+
+  // Release a profile from v4front_parse_profile/v4front_load_profile (NULL
+  // and empty profiles are fine)
+  void v4front_free_profile(V4FrontProfile* profile);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontCompileOptions
+  //  - Optional compilation settings for v4front_compile_with_options().
+  //  - A zero-initialized struct selects the defaults (same output as
+  //    v4front_compile_with_context_ex()).
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t flags;                     // V4FRONT_OPT_* bits
+    const V4FrontAllocator* allocator;  // Memory hook (NULL selects malloc/free)
+    uint32_t inline_max_size;           // V4FRONT_OPT_INLINE body limit in bytes
+                                        // (0 selects the default, 8)
+    uint32_t opt_level;                 // 0: flags only; 1/2: also enables
+                                        // V4FRONT_O1_FLAGS/V4FRONT_O2_FLAGS
+    const V4FrontSuperinstruction* superinstructions;  // Fused opcodes the target
+                                                       // VM provides (NULL: none)
+    uint32_t superinstruction_count;                   // Entries in superinstructions
+    const char* cache_dir;  // Existing directory for the on-disk compile cache
+                            // (NULL: none; see v4front_compile_with_options)
+    uint32_t yield_budget;  // V4FRONT_OPT_AUTO_YIELD: instructions a loop may run
+                            // between yields (0 selects the default, 256)
+    const V4FrontProfile* profile;  // Execution counts of a previous run (NULL:
+                                    // none; see V4FrontWordCount)
+  } V4FrontCompileOptions;
+
+// Remove redundant instruction windows left by keyword expansions
+// (SWAP SWAP, DUP DROP, >R R>, 0 SWAP -, 1 +, ...) and retarget jumps
+#define V4FRONT_OPT_PEEPHOLE (1u << 0)
+// Encode the literals 0, 1 and -1 as one-byte LIT0/LIT1/LITN1 instead of LIT imm32
+#define V4FRONT_OPT_COMPACT_LITERALS (1u << 1)
+// Evaluate operators on known constants at compile time (including values of
+// CONSTANTs defined in the same compilation)
+#define V4FRONT_OPT_CONSTANT_FOLD (1u << 2)
+// Copy small leaf words into their callers instead of emitting CALL; CONSTANT
+// and VARIABLE references become a single literal. With a profile, hot words
+// may be larger and words it never saw run are always called.
+#define V4FRONT_OPT_INLINE (1u << 3)
+// Lower RECURSE in tail position (followed by RET) to a JMP to the word start
+#define V4FRONT_OPT_TAIL_CALLS (1u << 4)
+// Thread jumps through JMP chains, return directly from JMP-to-RET, invert
+// conditional jumps over a lone JMP and drop unreachable code
+#define V4FRONT_OPT_JUMP_THREAD (1u << 5)
+// Drop words that main code never reaches through CALL and renumber the rest
+// (changes word indices, so it is not part of any opt_level preset)
+#define V4FRONT_OPT_STRIP_UNUSED (1u << 6)
+// In words that use locals (and not >R/R>/R@), keep DO loop index and limit in
+// local slots above the word's own: I/J/K become L@ and LOOP becomes L++ plus
+// a compare
+#define V4FRONT_OPT_LOOP_LOCALS (1u << 7)
+// Lower DO ... LOOP with literal bounds to a single return-stack down-counter
+// and fully unroll tiny ones
+#define V4FRONT_OPT_COUNTED_LOOPS (1u << 8)
+// Also return every CALL site of the output in V4FrontBuf::relocs (the code is
+// unchanged; not part of any opt_level preset, bypasses cache_dir, and is
+// refused by v4front_compile_batch)
+#define V4FRONT_OPT_RELOCS (1u << 9)
+// Also return a table from bytecode offsets to source positions in
+// V4FrontBuf::source_map (the code is unchanged; not part of any opt_level
+// preset, bypasses cache_dir and the word cache, and is refused by
+// v4front_compile_batch)
+#define V4FRONT_OPT_SOURCE_MAP (1u << 10)
+// Infer every word's stack effect into V4FrontWord::effect and fail with
+// StackImbalance on a definition whose paths leave different depths (IF
+// branches, loop iterations, EXIT points; note that ?DUP is such a word). The
+// code is unchanged; not part of any opt_level preset, bypasses cache_dir.
+#define V4FRONT_OPT_STACK_EFFECTS (1u << 11)
+// Run calls of words without side effects (no memory access, SYS or task
+// operations) on the known literals before them at compile time and emit the
+// results as literals instead
+#define V4FRONT_OPT_EVAL (1u << 12)
+// Make BEGIN loops (UNTIL, AGAIN, REPEAT) whose body has no yield point (see
+// v4front_find_yieldless_loops) execute TASK_YIELD at least once every
+// V4FrontCompileOptions::yield_budget instructions. Short bodies count their
+// instructions in a data-space cell. Not part of any opt_level preset;
+// bypasses the word cache.
+#define V4FRONT_OPT_AUTO_YIELD (1u << 13)
+// Order the words of the output by descending V4FrontCompileOptions::profile
+// count, so hot words are contiguous (CALL operands are renumbered; words
+// with equal counts keep definition order). Without a profile, or when the
+// source calls context words, nothing moves. Changes word indices, so it is
+// not part of any opt_level preset.
+#define V4FRONT_OPT_HOT_LAYOUT (1u << 14)
+
+// Optimization level presets (opt_level 1 and 2; higher levels act as 2)
+#define V4FRONT_O1_FLAGS                                                          \
+  (V4FRONT_OPT_PEEPHOLE | V4FRONT_OPT_COMPACT_LITERALS | V4FRONT_OPT_CONSTANT_FOLD | \
+   V4FRONT_OPT_JUMP_THREAD)
+#define V4FRONT_O2_FLAGS                                           \
+  (V4FRONT_O1_FLAGS | V4FRONT_OPT_INLINE | V4FRONT_OPT_TAIL_CALLS | \
+   V4FRONT_OPT_COUNTED_LOOPS | V4FRONT_OPT_EVAL)
+
+  // ---------------------------------------------------------------------------
+  // v4front_compile_with_options
+  //  - Compiles source with the given options.
+  //  - With options->cache_dir, the output is first looked up in that
+  //    directory under a SHA-256 of the compiler version, the options, the
+  //    words registered in ctx and the source. An entry is only a hit if the
+  //    digest and source length stored in it match. A hit is returned
+  //    without compiling; a miss is compiled and stored. Processes may share
+  //    the directory: files are replaced atomically, and unreadable ones
+  //    count as misses.
+  //  - Otherwise identical to v4front_compile_with_allocator().
+  //
+  //  @param ctx       Compiler context (may be NULL)
+  //  @param source    Source code to compile
+  //  @param options   Compilation options (NULL selects the defaults)
+  //  @param out_buf   Output buffer
+  //  @param error_out Error information output (may be NULL)
+  //  @return 0 on success, negative on error
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_compile_with_options(V4FrontContext* ctx, const char* source,
+                                           const V4FrontCompileOptions* options,
+                                           V4FrontBuf* out_buf, V4FrontError* error_out);
+
+  // Length-delimited v4front_compile_with_options (see v4front_compile_n)
+  v4front_err v4front_compile_with_options_n(V4FrontContext* ctx, const char* source,
+                                             size_t len,
+                                             const V4FrontCompileOptions* options,
+                                             V4FrontBuf* out_buf,
+                                             V4FrontError* error_out);
+
+  // ---------------------------------------------------------------------------
+  // v4front_compile_all_errors
+  //  - Compiles source[0, len) like v4front_compile_with_options_n(), but
+  //    does not stop at the first error, for linters that report every
+  //    problem of a file at once.
+  //  - After an error the compiler drops the definition it was in and goes
+  //    on after the next ; token. Errors in the skipped text are not seen,
+  //    and words defined there are unknown afterwards. A structure still open
+  //    at the end of the source is reported as well; when no ; follows an
+  //    error, that error is the last one.
+  //  - Writes the first cap errors to errors, in the order they were found,
+  //    and the number found to *count. Their lines and columns come from one
+  //    index of the source's line starts.
+  //  - out_buf is only filled when there is no error.
+  //
+  //  @return 0 on success, else the code of the first error (BufferTooSmall
+  //          if out_buf or count is NULL, or errors with cap > 0)
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_compile_all_errors(V4FrontContext* ctx, const char* source,
+                                         size_t len, const V4FrontCompileOptions* options,
+                                         V4FrontBuf* out_buf, V4FrontError* errors,
+                                         uint32_t cap, uint32_t* count);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontStats
+  //  - Where one compilation spent its time, for explaining slow scripts
+  //    without a profiler (see v4front_compile_with_stats()).
+  //  - Every token is charged to one phase at a time: tokenize (skipping
+  //    whitespace and comments, scanning the token), keyword (classifying it),
+  //    lookup (dictionary and context lookup of non-keywords), backpatch
+  //    (the words that resolve jumps: ELSE THEN UNTIL AGAIN REPEAT LOOP +LOOP)
+  //    and emit (all other code generation). finish covers the passes that run
+  //    after the last token and building the output.
+  //  - Word cache hits skip a definition's tokens; a cache_dir hit skips
+  //    compilation altogether (only total_ns and bytes_emitted are set).
+  //  - enabled is 0 when the library was built without V4FRONT_ENABLE_STATS:
+  //    the hooks are compiled out and every other field stays 0.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t enabled;        // Built with V4FRONT_ENABLE_STATS
+    uint64_t total_ns;       // Whole call
+    uint64_t tokenize_ns;    // Per-phase time (nanoseconds)
+    uint64_t keyword_ns;
+    uint64_t lookup_ns;
+    uint64_t emit_ns;
+    uint64_t backpatch_ns;
+    uint64_t finish_ns;
+    uint32_t tokens;         // Tokens read (names after : CONSTANT VARIABLE too)
+    uint32_t words;          // Dictionary entries defined
+    uint32_t literals;       // Number literals in the source
+    uint32_t lookups;        // Dictionary and context lookups
+    uint32_t allocations;    // Scratch chunks taken from the allocator
+    uint32_t reallocations;  // Scratch buffers that grew by moving their data
+    uint32_t bytes_emitted;  // Output bytes (main code and every word)
+  } V4FrontStats;
+
+  // ---------------------------------------------------------------------------
+  // v4front_compile_with_stats
+  //  - v4front_compile_with_options() that also reports V4FrontStats.
+  //  - stats is filled on success and on error (then up to the failing token).
+  //
+  //  @param stats Statistics output (may be NULL)
+  //  @return 0 on success, negative on error
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_compile_with_stats(V4FrontContext* ctx, const char* source,
+                                         const V4FrontCompileOptions* options,
+                                         V4FrontBuf* out_buf, V4FrontError* error_out,
+                                         V4FrontStats* stats);
+
+  // ===========================================================================
+  // Compiler Sessions
+  // ===========================================================================
+
+  // ---------------------------------------------------------------------------
+  // V4FrontSession
+  //  - Opaque reusable compiler state for hosts that compile many short
+  //    sources (REPL lines, RPC requests) in a row.
+  //  - Scratch memory and the output block are kept between compilations and
+  //    only grow when a larger source comes along: once they have reached
+  //    the size of the workload, compiling takes no memory from the allocator
+  //    (word and lex caches of ctx, see v4front_context_set_word_cache, still do).
+  //  - One session serves one thread at a time; contexts may differ per call.
+  // ---------------------------------------------------------------------------
+  typedef struct V4FrontSession V4FrontSession;
+
+  // ---------------------------------------------------------------------------
+  // v4front_session_create
+  //  - Creates a session whose memory comes from allocator (NULL selects
+  //    malloc/free). The allocator must outlive the session.
+  //  - Returns NULL when out of memory.
+  // ---------------------------------------------------------------------------
+  V4FrontSession* v4front_session_create(const V4FrontAllocator* allocator);
+
+  // ---------------------------------------------------------------------------
+  // v4front_session_destroy
+  //  - Releases the session and all of its memory, including the output of
+  //    the last compilation. NULL is ignored.
+  // ---------------------------------------------------------------------------
+  void v4front_session_destroy(V4FrontSession* session);
+
+  // ---------------------------------------------------------------------------
+  // v4front_session_set_output
+  //  - Makes later compilations write their output into the cap bytes at mem
+  //    (which need not be aligned) instead of session memory. A result that
+  //    does not fit fails with BufferTooSmall; v4front_session_output_size()
+  //    then tells how much it needs.
+  //  - mem NULL switches back to session memory.
+  //
+  //  @return 0 on success, BufferTooSmall if cap cannot hold any output
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_session_set_output(V4FrontSession* session, void* mem, size_t cap);
+
+  // ---------------------------------------------------------------------------
+  // v4front_session_output_size
+  //  - Bytes the output of the last compilation took, or after BufferTooSmall
+  //    the bytes it needed (from a malloc-aligned start). 0 after other errors.
+  // ---------------------------------------------------------------------------
+  size_t v4front_session_output_size(const V4FrontSession* session);
+
+  // ---------------------------------------------------------------------------
+  // v4front_session_compile
+  //  - v4front_compile_with_options() with the session's memory.
+  //  - out_buf points into session memory (or the storage given to
+  //    v4front_session_set_output) and stays valid until the next compilation
+  //    through the session or its destruction. v4front_free() on it only
+  //    clears it.
+  //  - options->allocator is ignored (the session's allocator is used), and
+  //    options->cache_dir is refused with InvalidOption.
+  //
+  //  @return 0 on success, negative on error
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_session_compile(V4FrontSession* session, V4FrontContext* ctx,
+                                      const char* source,
+                                      const V4FrontCompileOptions* options,
+                                      V4FrontBuf* out_buf, V4FrontError* error_out);
+
+  // Length-delimited v4front_session_compile (see v4front_compile_n)
+  v4front_err v4front_session_compile_n(V4FrontSession* session, V4FrontContext* ctx,
+                                        const char* source, size_t len,
+                                        const V4FrontCompileOptions* options,
+                                        V4FrontBuf* out_buf, V4FrontError* error_out);
+
+  // ===========================================================================
+  // Streaming Compilation
+  // ===========================================================================
+
+  // ---------------------------------------------------------------------------
+  // V4FrontStream
+  //  - Opaque compilation whose source arrives in chunks.
+  //  - Source text is only buffered until the next line break outside word
+  //    definitions, comments and control structures; everything before it is
+  //    compiled and dropped, so memory follows the output, not the input.
+  //  - The result is identical to compiling the concatenated chunks at once.
+  // ---------------------------------------------------------------------------
+  typedef struct V4FrontStream V4FrontStream;
+
+  // ---------------------------------------------------------------------------
+  // v4front_stream_begin
+  //  - Starts a streaming compilation. ctx and options (including the
+  //    allocator, which also holds the stream) work as in
+  //    v4front_compile_with_options().
+  //
+  //  @param ctx        Compiler context (may be NULL)
+  //  @param options    Compilation options (NULL selects the defaults)
+  //  @param out_stream Receives the stream
+  //  @return 0 on success, negative on error
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_stream_begin(V4FrontContext* ctx,
+                                   const V4FrontCompileOptions* options,
+                                   V4FrontStream** out_stream);
+
+  // ---------------------------------------------------------------------------
+  // v4front_stream_feed
+  //  - Appends len bytes of source. Chunks may split tokens and comments
+  //    anywhere; they must not contain NUL bytes (NulInSource).
+  //  - Error positions, lines and columns count from the start of the stream.
+  //  - After an error every further call returns the same error; the stream
+  //    must still be passed to v4front_stream_end().
+  //
+  //  @return 0 on success, negative on error
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_stream_feed(V4FrontStream* stream, const char* chunk, size_t len,
+                                  V4FrontError* error_out);
+
+  // ---------------------------------------------------------------------------
+  // v4front_stream_end
+  //  - Compiles the rest of the source into out_buf and destroys the stream.
+  //  - out_buf NULL abandons the compilation (the stream is still destroyed).
+  //
+  //  @return 0 on success, negative on error (including an earlier feed error)
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_stream_end(V4FrontStream* stream, V4FrontBuf* out_buf,
+                                 V4FrontError* error_out);
+
+  // ===========================================================================
+  // Batch Compilation
+  // ===========================================================================
+
+  // ---------------------------------------------------------------------------
+  // V4FrontModule
+  //  - One source of a batch (see v4front_compile_batch).
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    const char* source;  // Module source (needs no NUL terminator)
+    size_t len;          // Source length in bytes
+  } V4FrontModule;
+
+  // ---------------------------------------------------------------------------
+  // v4front_compile_batch
+  //  - Compiles count modules on a thread pool and links them into one
+  //    V4FrontBuf, as if they were one source compiled in module order.
+  //    - Words: every module's words, in module order. CALLs between modules
+  //      are resolved to these merged indices.
+  //    - Main code: every module's main code, run in module order.
+  //    - VARIABLEs get distinct data space addresses across modules.
+  //  - A module may call any word defined by another module, before or after
+  //    it, as well as the words of ctx (whose VM indices are kept). A name
+  //    defined by two modules is a DuplicateWord error.
+  //  - Words of other modules are always called: they are not inlined, and a
+  //    CONSTANT or VARIABLE of another module is not replaced by its value.
+  //    Fusion and V4FRONT_OPT_STRIP_UNUSED run after linking. Otherwise
+  //    options apply to every module as in v4front_compile_with_options().
+  //  - ctx is only read; pass a snapshot (v4front_context_snapshot) if other
+  //    threads may change it meanwhile.
+  //
+  //  @param ctx          Compiler context (may be NULL)
+  //  @param modules      Module sources
+  //  @param count        Number of modules
+  //  @param options      Compilation options (NULL selects the defaults)
+  //  @param threads      Worker threads (0: one per hardware thread)
+  //  @param out_buf      Linked output
+  //  @param error_out    Error details, positions relative to the failing module
+  //                      (may be NULL)
+  //  @param error_module Index of the failing module (may be NULL; set to
+  //                      count for errors that belong to no single module)
+  //  @return 0 on success, negative on error. When several modules fail, the
+  //          error of the first one is reported.
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_compile_batch(const V4FrontContext* ctx,
+                                    const V4FrontModule* modules, uint32_t count,
+                                    const V4FrontCompileOptions* options,
+                                    uint32_t threads, V4FrontBuf* out_buf,
+                                    V4FrontError* error_out, uint32_t* error_module);
+
   // ===========================================================================
   // Bytecode File I/O (.v4b format)
   // ===========================================================================
@@ -233,36 +996,180 @@ extern "C"
   // V4BytecodeHeader
   //  - File header structure for .v4b bytecode files.
   //  - Contains magic number, version, and metadata.
+  //  - Main code always follows the header directly, so readers that only
+  //    know v0.1 still find it in a v0.2 file.
   // ---------------------------------------------------------------------------
   typedef struct
   {
     uint8_t magic[4];       // Magic number: "V4BC" (0x56 0x34 0x42 0x43)
     uint8_t version_major;  // Major version number (currently 0)
-    uint8_t version_minor;  // Minor version number (currently 1)
-    uint16_t flags;         // Reserved flags (must be 0)
-    uint32_t code_size;     // Size of bytecode in bytes
-    uint32_t reserved;      // Reserved for future use (must be 0)
+    uint8_t version_minor;  // Minor version number (1; 2 with sections; 3 compressed)
+    uint16_t flags;         // V4B_FLAG_* bits (0 in v0.1)
+    uint32_t code_size;     // Size of main bytecode in bytes
+    uint32_t reserved;      // V4B_FLAG_SECTIONS: offset of the section directory
+                            // (otherwise 0)
   } V4BytecodeHeader;
 
+// The file has a section directory (v0.2); header.reserved is its offset
+#define V4B_FLAG_SECTIONS (1u << 0)
+// The CODE and WORD_CODE sections are compressed (v0.3, with
+// V4B_FLAG_SECTIONS); their count field holds the uncompressed size. See
+// V4FrontInflater.
+#define V4B_FLAG_COMPRESSED (1u << 1)
+
+// Section offsets (and the directory offset) are multiples of this
+#define V4B_SECTION_ALIGN 8u
+
+// Section types; readers skip types they do not know
+#define V4B_SECTION_CODE 1u       // Main code (uncompressed: offset 16, code_size bytes)
+#define V4B_SECTION_WORDS 2u      // V4BytecodeWord[count]
+#define V4B_SECTION_WORD_CODE 3u  // Bytecode of all words, back to back
+#define V4B_SECTION_NAMES 4u      // NUL-terminated word names
+#define V4B_SECTION_DEBUG 5u      // Optional debug info: the source map (opaque to
+                                  // the loader)
+#define V4B_SECTION_CONTEXT 6u    // Registered context words (prelude files)
+
+  // ---------------------------------------------------------------------------
+  // V4BytecodeDirectory / V4BytecodeSection
+  //  - The section directory of a v0.2 file: a count followed by that many
+  //    section entries. Offsets are from the start of the file.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t section_count;  // Number of V4BytecodeSection entries that follow
+    uint32_t reserved;       // Must be 0
+  } V4BytecodeDirectory;
+
+  typedef struct
+  {
+    uint32_t type;    // V4B_SECTION_*
+    uint32_t offset;  // From the start of the file (V4B_SECTION_ALIGN aligned)
+    uint32_t size;    // In bytes
+    uint32_t count;   // Number of entries (V4B_SECTION_WORDS), uncompressed size
+                      // (compressed sections), otherwise 0
+  } V4BytecodeSection;
+
+  // ---------------------------------------------------------------------------
+  // V4BytecodeWord
+  //  - Entry of the V4B_SECTION_WORDS table, in dictionary order.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t name_offset;  // Into the V4B_SECTION_NAMES section
+    uint32_t code_offset;  // Into the V4B_SECTION_WORD_CODE section
+    uint32_t code_len;     // Bytecode length in bytes
+  } V4BytecodeWord;
+
+  // ---------------------------------------------------------------------------
+  // V4BytecodeContextWord
+  //  - Entry of the V4B_SECTION_CONTEXT table, in registration order. The
+  //    section holds count entries followed by their NUL-terminated names.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t name_offset;  // From the start of the V4B_SECTION_CONTEXT section
+    int32_t vm_word_idx;   // VM word index the name was registered with
+  } V4BytecodeContextWord;
+
   // ---------------------------------------------------------------------------
   // v4front_save_bytecode
-  //  - Saves bytecode to a .v4b file.
-  //  - Writes V4BytecodeHeader followed by bytecode data.
+  //  - Saves bytecode to a .v4b file (v4front_write_bytecode_cb on the file).
+  //  - Writes V4BytecodeHeader followed by the main bytecode.
+  //  - A buffer with words is written as v0.2: the main code is followed by a
+  //    section directory, the word table, the word bytecode and the names.
+  //    A buffer without words is written as v0.1 (header and code only).
   //
   //  @param buf      Bytecode buffer to save
   //  @param filename Output file path
   //  @return 0 on success, negative on error
-  //    -1: Invalid parameters (NULL buf or filename)
+  //    -1: Invalid parameters (NULL buf or filename, or nothing to save)
   //    -2: Failed to open file for writing
   //    -3: Failed to write header
   //    -4: Failed to write bytecode
+  //    -5: Failed to allocate memory for the sections
+  //  - On an error after the file was opened, the partial file is removed.
   // ---------------------------------------------------------------------------
   v4front_err v4front_save_bytecode(const V4FrontBuf* buf, const char* filename);
 
+// Compress the code sections (v4front_save_bytecode_with_flags)
+#define V4B_SAVE_COMPRESS (1u << 0)
+
+  // ---------------------------------------------------------------------------
+  // v4front_save_bytecode_with_flags
+  //  - Like v4front_save_bytecode(), with V4B_SAVE_* flags (0: identical
+  //    output).
+  //  - V4B_SAVE_COMPRESS writes a v0.3 file: the directory follows the header,
+  //    then the word table and names, then the compressed main code and
+  //    word bytecode. Everything a loader needs before inflating comes first,
+  //    so a receiver can set up code memory and inflate while the rest of the
+  //    file is still arriving.
+  //
+  //  @return as v4front_save_bytecode
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_save_bytecode_with_flags(const V4FrontBuf* buf,
+                                               const char* filename, uint32_t flags);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontByteWriter / V4FrontByteReader
+  //  - Byte stream callbacks for the .v4b format, for hosts without a file
+  //    system (UART, BLE, raw flash pages).
+  //  - write returns 0 on success, nonzero to abort. Every call passes
+  //    exactly V4B_IO_CHUNK bytes except the last one of a file.
+  //  - read fills up to len bytes (never more than V4B_IO_CHUNK) and returns
+  //    how many it stored; it may return fewer and is then called again.
+  //    0 means end of input (or an error).
+  // ---------------------------------------------------------------------------
+#define V4B_IO_CHUNK 256u
+
+  typedef struct
+  {
+    int (*write)(void* user, const uint8_t* data, size_t len);
+    void* user;
+  } V4FrontByteWriter;
+
+  typedef struct
+  {
+    size_t (*read)(void* user, uint8_t* dst, size_t len);
+    void* user;
+  } V4FrontByteReader;
+
+  // ---------------------------------------------------------------------------
+  // v4front_write_bytecode_cb
+  //  - Writes buf in the .v4b format (as v4front_save_bytecode_with_flags)
+  //    through writer, front to back.
+  //  - The file is produced as it is written: only one chunk is buffered
+  //    (V4B_SAVE_COMPRESS also holds the compressed code until its size is
+  //    known).
+  //
+  //  @return as v4front_save_bytecode (-3/-4: writer failed); -1 also for a
+  //          NULL writer
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_write_bytecode_cb(const V4FrontBuf* buf, uint32_t flags,
+                                        const V4FrontByteWriter* writer);
+
+  // ---------------------------------------------------------------------------
+  // v4front_read_bytecode_cb
+  //  - Reads a .v4b file through reader into out_buf (as v4front_load_bytecode),
+  //    strictly front to back with no seeking.
+  //  - Data goes straight into the result: the main code into out_buf->data
+  //    and each word's code into its own allocation. Besides the result,
+  //    only the word table, the names, one chunk and (for compressed files)
+  //    the inflated word bytecode are held.
+  //  - Sections are read in file order and must not overlap. Debug and
+  //    unknown sections are not read. Reading stops after the last section
+  //    it needs.
+  //
+  //  @return as v4front_load_bytecode; -1 also for a NULL reader
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_read_bytecode_cb(const V4FrontByteReader* reader,
+                                       V4FrontBuf* out_buf);
+
   // ---------------------------------------------------------------------------
   // v4front_load_bytecode
-  //  - Loads bytecode from a .v4b file.
+  //  - Loads bytecode from a .v4b file (v4front_read_bytecode_cb on the file).
   //  - Reads and validates V4BytecodeHeader, then loads bytecode.
+  //  - Words of a v0.2 file are restored into out_buf->words; v0.1 files
+  //    have none.
   //  - Caller must call v4front_free() on out_buf when done.
   //
   //  @param filename Input file path
@@ -274,9 +1181,202 @@ extern "C"
   //    -4: Invalid magic number (not "V4BC")
   //    -5: Failed to allocate memory for bytecode
   //    -6: Failed to read bytecode
+  //    -7: Malformed section directory (bounds, alignment, order or word
+  //        table), or a corrupt compressed section
   // ---------------------------------------------------------------------------
   v4front_err v4front_load_bytecode(const char* filename, V4FrontBuf* out_buf);
 
+  // ---------------------------------------------------------------------------
+  // V4FrontMappedBytecode
+  //  - Read-only view of a .v4b file mapped into memory (mmap, or
+  //    MapViewOfFile on Windows). code points into the mapping; nothing is
+  //    copied and the pages are shared with every process mapping the file.
+  //  - The word fields describe the sections of a v0.2 file; they are NULL/0
+  //    for v0.1 files. Use v4front_mapped_word() to read an entry.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    const uint8_t* code;          // Bytecode (read-only, inside the mapping)
+    size_t size;                  // Bytecode size in bytes (code_size of the header)
+    void* base;                   // Start of the mapping (for v4front_unmap_bytecode)
+    size_t length;                // Length of the mapping (the file size)
+    const V4BytecodeWord* words;  // Word table (NULL if no words)
+    uint32_t word_count;          // Number of words
+    const uint8_t* word_code;     // V4B_SECTION_WORD_CODE section
+    const char* names;            // V4B_SECTION_NAMES section
+    const uint8_t* debug;         // V4B_SECTION_DEBUG section (NULL if absent)
+    size_t debug_size;            // Size of the debug section
+  } V4FrontMappedBytecode;
+
+  // ---------------------------------------------------------------------------
+  // v4front_map_bytecode
+  //  - Maps a .v4b file instead of reading it (see v4front_load_bytecode).
+  //  - Validates the magic number and that code_size fits in the file, and
+  //    for v0.2 files the whole section directory and word table, so the
+  //    words can be registered straight from the mapping.
+  //  - The file must not be truncated or rewritten in place while mapped.
+  //  - Release the view with v4front_unmap_bytecode().
+  //
+  //  @param filename Input file path
+  //  @param out_map  Output view
+  //  @return 0 on success, negative on error
+  //    -1: Invalid parameters (NULL filename or out_map)
+  //    -2: Failed to open file for reading
+  //    -3: File shorter than the header, or mapping failed
+  //    -4: Invalid magic number (not "V4BC")
+  //    -6: code_size exceeds the file length
+  //    -7: Malformed section directory (bounds, alignment or word table)
+  //    -8: Compressed file (no code to map; see V4FrontInflater)
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_map_bytecode(const char* filename, V4FrontMappedBytecode* out_map);
+
+  // ---------------------------------------------------------------------------
+  // v4front_mapped_word
+  //  - Looks up word idx of a mapped file. The name and code point into the
+  //    mapping and stay valid until v4front_unmap_bytecode().
+  //
+  //  @param map      View returned by v4front_map_bytecode()
+  //  @param idx      Word index (0-based)
+  //  @param out_name Receives the word name (may be NULL)
+  //  @param out_code Receives the word bytecode (may be NULL)
+  //  @param out_len  Receives the bytecode length (may be NULL)
+  //  @return 0 on success, -1 if map is NULL or idx is out of range
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_mapped_word(const V4FrontMappedBytecode* map, uint32_t idx,
+                                  const char** out_name, const uint8_t** out_code,
+                                  uint32_t* out_len);
+
+  // ---------------------------------------------------------------------------
+  // v4front_unmap_bytecode
+  //  - Releases a view returned by v4front_map_bytecode().
+  //  - Safe to call with NULL or with an already-released view (no-op).
+  // ---------------------------------------------------------------------------
+  void v4front_unmap_bytecode(V4FrontMappedBytecode* map);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontVerifyResult / v4front_verify_code / v4front_verify_bytecode
+  //  - Checks loaded (untrusted) bytecode in one linear pass per unit, so a VM
+  //    can run code that passes without bounds checks on jumps and calls:
+  //    every instruction is a known opcode with its whole immediate, every
+  //    JMP/JZ/JNZ lands on an instruction start inside its unit, every CALL
+  //    names a word below call_limit, and the last instruction is RET or JMP
+  //    (execution never runs off the end).
+  //  - call_limit is the size of the VM word table the code runs against;
+  //    0 selects buf->word_count (a self-contained buffer). Context and
+  //    relocated calls need the VM's count.
+  //  - Fused superinstructions are not in opcodes.def and are rejected as
+  //    unknown opcodes. Empty units (a buffer without main code) pass.
+  //  - v4front_verify_code checks one unit (e.g. a v4front_mapped_word()
+  //    body); v4front_verify_bytecode checks the main code, then every word.
+  //
+  //  @return 0 if the code passes, InvalidImage otherwise (*out, if not NULL,
+  //          says where and why), BufferTooSmall for NULL code or buf,
+  //          OutOfMemory
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t reason;  // V4FRONT_VERIFY_OK, or the first problem found
+    int32_t unit;     // Unit of the problem (-1: main code, else a word index)
+    uint32_t pc;      // Offset of the offending instruction in that unit
+  } V4FrontVerifyResult;
+
+#define V4FRONT_VERIFY_OK 0
+#define V4FRONT_VERIFY_UNKNOWN_OPCODE 1  // Opcode not in opcodes.def
+#define V4FRONT_VERIFY_TRUNCATED 2       // Immediate runs past the end of the unit
+#define V4FRONT_VERIFY_BAD_JUMP 3        // Target outside the unit or mid-instruction
+#define V4FRONT_VERIFY_BAD_CALL 4        // Word index not below call_limit
+#define V4FRONT_VERIFY_FALLS_OFF 5       // Last instruction is not RET or JMP
+
+  v4front_err v4front_verify_code(const uint8_t* code, size_t len, uint32_t call_limit,
+                                  V4FrontVerifyResult* out);
+  v4front_err v4front_verify_bytecode(const V4FrontBuf* buf, uint32_t call_limit,
+                                      V4FrontVerifyResult* out);
+
+  // ---------------------------------------------------------------------------
+  // v4front_save_prelude
+  //  - Saves a precompiled library and the context it was registered into as
+  //    one v0.2 .v4b file: the words of lib as usual, plus a
+  //    V4B_SECTION_CONTEXT section with every word registered in ctx (its
+  //    name and VM index, in registration order).
+  //  - Typical use: compile the library once, register its words with the VM
+  //    and ctx, then save both. Every later session loads the file with
+  //    v4front_context_load_prelude() instead of compiling the library.
+  //
+  //  @param ctx      Context to save (snapshots are fine)
+  //  @param lib      Library to save with it (NULL: none)
+  //  @param filename Output file path
+  //  @return as v4front_save_bytecode; -1 for a NULL ctx or filename
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_save_prelude(const V4FrontContext* ctx, const V4FrontBuf* lib,
+                                   const char* filename);
+
+  // ---------------------------------------------------------------------------
+  // v4front_context_load_prelude
+  //  - Maps a file written by v4front_save_prelude() and replaces the words
+  //    registered in ctx with the ones it holds. Nothing is compiled.
+  //  - The library stays mapped in out_lib (as v4front_map_bytecode), so the
+  //    host can register its words with a fresh VM straight from the file;
+  //    they get the VM indices the context expects if they are registered in
+  //    the same order as when the prelude was saved. out_lib NULL unmaps it.
+  //
+  //  @param ctx      Context to initialize (not a snapshot)
+  //  @param filename Prelude file path
+  //  @param out_lib  Receives the mapped library (may be NULL)
+  //  @return 0 on success, negative on error. ctx is untouched if the file
+  //          cannot be used, and left empty if registering fails.
+  //    -1: Invalid parameters (NULL ctx or filename, or ctx is a snapshot)
+  //    -5: Out of memory while registering words
+  //    -7: Malformed file, or no V4B_SECTION_CONTEXT section
+  //    other: as v4front_map_bytecode
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_context_load_prelude(V4FrontContext* ctx, const char* filename,
+                                           V4FrontMappedBytecode* out_lib);
+
+  // ---------------------------------------------------------------------------
+  // V4FrontInflater
+  //  - Streaming decompressor for the compressed sections of a v0.3 file.
+  //  - Output goes straight into the caller's memory (e.g. the VM's code
+  //    area); matches are copied from what was already written there, so
+  //    the inflater itself is this struct and needs no window or heap.
+  //  - Input can be fed in pieces of any size as it arrives.
+  //  - Fields are internal.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint8_t* dst;        // Output memory
+    size_t cap;          // Uncompressed size (the output must fill it exactly)
+    size_t out;          // Bytes written so far
+    uint32_t literals;   // Literal bytes still to copy
+    uint32_t match_len;  // Length of the pending match
+    uint32_t offset;     // Distance of the pending match
+    uint8_t token;       // Current sequence token
+    uint8_t state;       // Decoder state
+  } V4FrontInflater;
+
+  // ---------------------------------------------------------------------------
+  // v4front_inflate_init
+  //  - Prepares z to inflate exactly cap bytes into dst (the section's count).
+  // ---------------------------------------------------------------------------
+  void v4front_inflate_init(V4FrontInflater* z, uint8_t* dst, size_t cap);
+
+  // ---------------------------------------------------------------------------
+  // v4front_inflate_feed
+  //  - Decodes the next len bytes of the compressed section.
+  //
+  //  @return 0 on success, -7 if the data is malformed (overflows cap, refers
+  //          before the start, or continues past the end); z is then unusable
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_inflate_feed(V4FrontInflater* z, const uint8_t* in, size_t len);
+
+  // ---------------------------------------------------------------------------
+  // v4front_inflate_finish
+  //  - Checks that the whole section was decoded.
+  //
+  //  @return 0 if all cap bytes were written, -7 otherwise (truncated input or
+  //          an earlier error)
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_inflate_finish(const V4FrontInflater* z);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
\ No newline at end of file
@@ -31,6 +31,67 @@ struct OpInfo
   ImmKind imm;       ///< Immediate type
 };
 
+/**
+ * @brief Metadata of an opcode (a constexpr table lookup; unknown opcodes have
+ * the name "???" and no immediate).
+ */
+const OpInfo& op_info(uint8_t opcode);
+
+/**
+ * @brief One decoded instruction (plain data, see decode()).
+ */
+struct DecodedInsn
+{
+  size_t pc;         ///< Byte offset of the opcode
+  uint8_t opcode;    ///< Opcode value
+  ImmKind imm_kind;  ///< Immediate type (ImmKind::None for unknown opcodes)
+  uint8_t length;    ///< Bytes consumed (a truncated immediate takes the rest)
+  bool truncated;    ///< The immediate runs past the end of the code
+  int32_t imm;       ///< Immediate, sign-extended (0 if none or truncated)
+};
+
+/**
+ * @brief Buffer size that holds any line written by format_insn().
+ */
+constexpr size_t kDisasmLineMax = 96;
+
+/**
+ * @brief Decode the instruction at PC without allocating.
+ *
+ * @return Bytes consumed (insn.length), or 0 if pc >= len.
+ */
+size_t decode_one(const uint8_t* code, size_t len, size_t pc, DecodedInsn& insn);
+
+/**
+ * @brief Decode consecutive instructions from PC into out[0, cap).
+ *
+ * Stops at the end of the code or when out is full; decoding resumes at
+ * out[n - 1].pc + out[n - 1].length.
+ *
+ * @return Number of instructions written.
+ *
+ * Example:
+ * @code
+ *   DecodedInsn insns[256];
+ *   for (size_t pc = 0, n; (n = decode(code, len, pc, insns, 256)) > 0;
+ *        pc = insns[n - 1].pc + insns[n - 1].length)
+ *     consume(insns, n);
+ * @endcode
+ *
+ * Thread-safety: Thread-safe (no shared state).
+ */
+size_t decode(const uint8_t* code, size_t len, size_t pc, DecodedInsn* out, size_t cap);
+
+/**
+ * @brief Format a decoded instruction as disasm_one() does, into buf.
+ *
+ * Writes at most cap - 1 characters and a terminating NUL (nothing if cap is
+ * 0), like snprintf. kDisasmLineMax bytes always suffice.
+ *
+ * @return Length of the full line, excluding the NUL.
+ */
+size_t format_insn(const DecodedInsn& insn, char* buf, size_t cap);
+
 /**
  * @brief Disassemble a single instruction at given PC.
  *
@@ -0,0 +1,136 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "v4front/compile.h"
+
+  // ===========================================================================
+  // Contiguous Compiled Image
+  // ===========================================================================
+  //
+  // Layout (all offsets are relative to the start of the image, every section
+  // starts on a 4-byte boundary, multi-byte fields are little-endian):
+  //
+  //   +--------------------------+  0
+  //   | V4FrontImageHeader       |
+  //   +--------------------------+  words_offset
+  //   | V4FrontImageWord[count]  |
+  //   +--------------------------+  code_offset
+  //   | main code | word code... |
+  //   +--------------------------+  names_offset
+  //   | NUL-terminated names     |
+  //   +--------------------------+  image_size
+  //
+  // The image contains no pointers, so it can be copied, written to disk or
+  // mapped at any address and used in place.
+
+#define V4FRONT_IMAGE_MAGIC "V4IM"
+#define V4FRONT_IMAGE_VERSION 1
+
+  // ---------------------------------------------------------------------------
+  // V4FrontImageHeader
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint8_t magic[4];       // "V4IM"
+    uint16_t version;       // Layout version (V4FRONT_IMAGE_VERSION)
+    uint16_t flags;         // Reserved (must be 0)
+    uint32_t image_size;    // Total image size in bytes
+    uint32_t word_count;    // Number of entries in the word table
+    uint32_t words_offset;  // Offset of V4FrontImageWord[word_count]
+    uint32_t code_offset;   // Offset of the code section
+    uint32_t code_size;     // Size of the code section
+    uint32_t main_size;     // Size of main code (first bytes of the code section)
+    uint32_t names_offset;  // Offset of the name pool
+    uint32_t names_size;    // Size of the name pool
+  } V4FrontImageHeader;
+
+  // ---------------------------------------------------------------------------
+  // V4FrontImageWord
+  //  - Word table entry. Index in the table == local CALL index.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint32_t name_offset;  // Offset of the name within the name pool
+    uint32_t code_offset;  // Offset of the code within the code section
+    uint32_t code_len;     // Length of the word's bytecode
+  } V4FrontImageWord;
+
+  // ---------------------------------------------------------------------------
+  // V4FrontImage
+  //  - Owning handle for an image produced by v4front_compile_image().
+  //  - data/size are the image bytes; allocator records how to release them.
+  // ---------------------------------------------------------------------------
+  typedef struct
+  {
+    uint8_t* data;               // Image bytes (starts with V4FrontImageHeader)
+    size_t size;                 // Image size in bytes
+    V4FrontAllocator allocator;  // Allocator that owns data (alloc == NULL: malloc)
+  } V4FrontImage;
+
+  // ---------------------------------------------------------------------------
+  // v4front_compile_image
+  //  - Compiles source into one contiguous image (a single allocation).
+  //  - Otherwise identical to v4front_compile_with_allocator().
+  //
+  //  @param ctx       Compiler context (may be NULL)
+  //  @param source    Source code to compile
+  //  @param allocator Memory hook (NULL selects malloc/free)
+  //  @param out_image Output image
+  //  @param error_out Error information output (may be NULL)
+  //  @return 0 on success, negative on error
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_compile_image(V4FrontContext* ctx, const char* source,
+                                    const V4FrontAllocator* allocator,
+                                    V4FrontImage* out_image, V4FrontError* error_out);
+
+  // ---------------------------------------------------------------------------
+  // v4front_image_free
+  //  - Releases an image returned by v4front_compile_image().
+  //  - Safe to call with NULL or with an already-freed image (no-op).
+  // ---------------------------------------------------------------------------
+  void v4front_image_free(V4FrontImage* image);
+
+  // ---------------------------------------------------------------------------
+  // v4front_image_validate
+  //  - Checks that size bytes at data form a well-formed image: magic, version,
+  //    section bounds, word table entries and NUL-terminated names.
+  //  - Images that pass can be read with the accessors below without further
+  //    bounds checks.
+  //
+  //  @return 0 if valid, InvalidImage otherwise
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_image_validate(const uint8_t* data, size_t size);
+
+  // ---------------------------------------------------------------------------
+  // v4front_image_main
+  //  - Returns a pointer to the main code of a validated image.
+  //
+  //  @param data     Image bytes
+  //  @param out_size Receives the main code size (may be NULL)
+  // ---------------------------------------------------------------------------
+  const uint8_t* v4front_image_main(const uint8_t* data, uint32_t* out_size);
+
+  // ---------------------------------------------------------------------------
+  // v4front_image_word
+  //  - Looks up word idx of a validated image.
+  //
+  //  @param data     Image bytes
+  //  @param idx      Word index (0-based)
+  //  @param out_name Receives the word name (may be NULL)
+  //  @param out_code Receives the word bytecode (may be NULL)
+  //  @param out_len  Receives the bytecode length (may be NULL)
+  //  @return 0 on success, InvalidImage if idx is out of range
+  // ---------------------------------------------------------------------------
+  v4front_err v4front_image_word(const uint8_t* data, uint32_t idx, const char** out_name,
+                                 const uint8_t** out_code, uint32_t* out_len);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
@@ -0,0 +1,209 @@
+#pragma once
+// Internal bump arena used for all per-compile scratch memory.
+//
+//  - Memory comes from a V4FrontAllocator (or malloc/free when none is given)
+//    in chunks; individual allocations are never freed, the whole arena is
+//    released at once.
+//  - Chunks never move, so pointers stay valid until reset()/release().
+//  - The most recent allocation can be grown in place, which keeps the
+//    append-heavy bytecode buffers cheap.
+//  - A retaining arena (V4FrontSession scratch) keeps its memory on release():
+//    see recycle().
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "v4front/compile.h"
+
+namespace v4front
+{
+
+struct Arena
+{
+  struct Chunk
+  {
+    Chunk* next;
+    size_t used;
+    size_t cap;
+    // Followed by cap bytes of storage
+  };
+
+  static constexpr size_t kAlign = 8;
+  static constexpr size_t kMinChunk = 1024;
+  static constexpr size_t kMaxChunk = 64 * 1024;
+
+  V4FrontAllocator allocator;  // alloc == nullptr selects malloc/free
+  Chunk* head;                 // Most recent chunk (allocation happens here)
+  void* last;                  // Most recent allocation (growable in place)
+  size_t last_size;            // Size reserved for last
+  bool retain;                 // release() recycles instead of freeing
+#if V4FRONT_STATS
+  uint32_t chunk_count;  // Chunks taken from the allocator (V4FrontStats)
+  uint32_t copy_count;   // grow() calls that had to move the data
+#endif
+
+  void init(const V4FrontAllocator* a = nullptr)
+  {
+    if (a && a->alloc)
+      allocator = *a;
+    else
+      allocator = {nullptr, nullptr, nullptr};
+    head = nullptr;
+    last = nullptr;
+    last_size = 0;
+    retain = false;
+#if V4FRONT_STATS
+    chunk_count = 0;
+    copy_count = 0;
+#endif
+  }
+
+  // Raw allocation through the configured allocator (not tracked by the arena)
+  void* raw_alloc(size_t size) const
+  {
+    return allocator.alloc ? allocator.alloc(allocator.user, size) : malloc(size);
+  }
+
+  void raw_free(void* ptr) const
+  {
+    if (!ptr)
+      return;
+    if (!allocator.alloc)
+      free(ptr);
+    else if (allocator.free)
+      allocator.free(allocator.user, ptr);
+  }
+
+  // Return every chunk to the allocator (retaining arenas recycle() instead)
+  void release()
+  {
+    if (retain)
+      recycle();
+    else
+      free_chunks();
+  }
+
+  // Return every chunk to the allocator, retaining or not
+  void free_chunks()
+  {
+    while (head)
+    {
+      Chunk* next = head->next;
+      raw_free(head);
+      head = next;
+    }
+    last = nullptr;
+    last_size = 0;
+  }
+
+  // Drop all allocations but keep the newest chunk for reuse
+  void reset()
+  {
+    if (!head)
+      return;
+    Chunk* keep = head;
+    head = head->next;
+    free_chunks();
+    keep->next = nullptr;
+    keep->used = 0;
+    head = keep;
+  }
+
+  // Drop all allocations and leave a single empty chunk as large as all chunks
+  // were together, so that the same allocations again take no new chunk
+  void recycle()
+  {
+    last = nullptr;
+    last_size = 0;
+    if (!head || !head->next)
+    {
+      if (head)
+        head->used = 0;
+      return;
+    }
+    size_t total = 0;
+    for (Chunk* c = head; c; c = c->next)
+      total += c->cap;
+    free_chunks();
+    Chunk* chunk = (Chunk*)raw_alloc(sizeof(Chunk) + total);
+    if (!chunk)
+      return;  // Start over from kMinChunk
+    chunk->next = nullptr;
+    chunk->used = 0;
+    chunk->cap = total;
+    head = chunk;
+  }
+
+  // Allocate size bytes (kAlign aligned); returns nullptr on exhaustion
+  void* alloc(size_t size)
+  {
+    size_t need = (size + kAlign - 1) & ~(kAlign - 1);
+    if (need == 0)
+      need = kAlign;
+    if (!head || head->cap - head->used < need)
+    {
+      size_t cap = head ? head->cap * 2 : kMinChunk;
+      if (cap > kMaxChunk)
+        cap = kMaxChunk;
+      if (cap < need)
+        cap = need;
+      Chunk* chunk = (Chunk*)raw_alloc(sizeof(Chunk) + cap);
+      if (!chunk)
+        return nullptr;
+      chunk->next = head;
+      chunk->used = 0;
+      chunk->cap = cap;
+      head = chunk;
+#if V4FRONT_STATS
+      chunk_count++;
+#endif
+    }
+    uint8_t* p = reinterpret_cast<uint8_t*>(head + 1) + head->used;
+    head->used += need;
+    last = p;
+    last_size = need;
+    return p;
+  }
+
+  // Resize an allocation made by this arena. The most recent allocation is
+  // extended in place when the chunk has room; otherwise the data is copied.
+  void* grow(void* ptr, size_t old_size, size_t new_size)
+  {
+    if (!ptr)
+      return alloc(new_size);
+    if (ptr == last)
+    {
+      size_t need = (new_size + kAlign - 1) & ~(kAlign - 1);
+      size_t start = static_cast<uint8_t*>(ptr) - reinterpret_cast<uint8_t*>(head + 1);
+      if (start + need <= head->cap)
+      {
+        head->used = start + need;
+        last_size = need;
+        return ptr;
+      }
+    }
+    void* fresh = alloc(new_size);
+    if (!fresh)
+      return nullptr;
+    memcpy(fresh, ptr, old_size < new_size ? old_size : new_size);
+#if V4FRONT_STATS
+    copy_count++;
+#endif
+    return fresh;
+  }
+
+  // Copy len bytes of s plus a terminating NUL; returns nullptr on exhaustion
+  const char* intern(const char* s, size_t len)
+  {
+    char* dst = static_cast<char*>(alloc(len + 1));
+    if (!dst)
+      return nullptr;
+    memcpy(dst, s, len);
+    dst[len] = '\0';
+    return dst;
+  }
+};
+
+}  // namespace v4front
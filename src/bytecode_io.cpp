@@ -1,32 +1,819 @@
+#include <climits>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "compress.hpp"
 #include "v4front/compile.h"
 
 // Magic number for .v4b files: "V4BC"
 static const uint8_t V4B_MAGIC[4] = {0x56, 0x34, 0x42, 0x43};
 
-// Current file format version
+// Current file format version (minor 1: code only, 2: sections, 3: compressed)
 static const uint8_t V4B_VERSION_MAJOR = 0;
 static const uint8_t V4B_VERSION_MINOR = 1;
+static const uint8_t V4B_VERSION_MINOR_SECTIONS = 2;
+static const uint8_t V4B_VERSION_MINOR_COMPRESSED = 3;
 
-extern "C" v4front_err v4front_save_bytecode(const V4FrontBuf* buf, const char* filename)
+// Sections written by v4front_save_bytecode (a source map and the context of
+// v4front_save_prelude add one each)
+static const uint32_t V4B_SAVED_SECTIONS = 4;
+
+static size_t align_section(size_t n)
+{
+  return (n + V4B_SECTION_ALIGN - 1) & ~static_cast<size_t>(V4B_SECTION_ALIGN - 1);
+}
+
+// The words of a mapped v0.2 file, as located by parse_sections
+struct SectionView
+{
+  const V4BytecodeWord* words;
+  uint32_t word_count;
+  const uint8_t* word_code;
+  const char* names;
+  const uint8_t* debug;
+  uint32_t debug_size;
+  const uint8_t* context;  // V4B_SECTION_CONTEXT (nullptr if absent)
+  uint32_t context_count;
+  uint32_t context_size;
+};
+
+// Total code and name bytes of the words of buf
+static void measure_words(const V4FrontBuf* buf, size_t* code_total, size_t* names_total)
+{
+  *code_total = 0;
+  *names_total = 0;
+  for (int i = 0; i < buf->word_count; i++)
+  {
+    *code_total += buf->words[i].code_len;
+    *names_total += strlen(buf->words[i].name) + 1;
+  }
+}
+
+// Lay out the words of buf: table entries, code back to back and names.
+// Any destination may be NULL to skip it.
+static void fill_words(const V4FrontBuf* buf, uint8_t* table, uint8_t* code,
+                       uint8_t* names)
+{
+  uint32_t code_at = 0;
+  uint32_t name_at = 0;
+  for (int i = 0; i < buf->word_count; i++)
+  {
+    const V4FrontWord& word = buf->words[i];
+    V4BytecodeWord entry = {name_at, code_at, word.code_len};
+    size_t name_len = strlen(word.name) + 1;
+    if (table)
+      memcpy(table + i * sizeof(entry), &entry, sizeof(entry));
+    if (code && word.code_len)
+      memcpy(code + code_at, word.code, word.code_len);
+    if (names)
+      memcpy(names + name_at, word.name, name_len);
+    code_at += word.code_len;
+    name_at += static_cast<uint32_t>(name_len);
+  }
+}
+
+// Offsets of a v0.2 file with words (the sections follow the main code); a
+// prelude ends with the context section, and a source map follows
+struct PlainLayout
+{
+  uint32_t section_count;
+  size_t dir;
+  size_t words;
+  size_t word_code;
+  size_t names;
+  size_t context;
+  size_t debug;
+  size_t end;
+  size_t code_total;
+  size_t names_total;
+  size_t context_total;
+  uint32_t context_count;
+};
+
+static void plain_layout(const V4FrontBuf* buf, uint32_t code_size,
+                         const V4FrontContext* ctx, PlainLayout* layout)
+{
+  measure_words(buf, &layout->code_total, &layout->names_total);
+  layout->context_count = 0;
+  layout->context_total = 0;
+  if (ctx)
+  {
+    layout->context_count = static_cast<uint32_t>(v4front_context_get_word_count(ctx));
+    layout->context_total = layout->context_count * sizeof(V4BytecodeContextWord);
+    for (uint32_t i = 0; i < layout->context_count; i++)
+      layout->context_total +=
+          strlen(v4front_context_get_word_name(ctx, static_cast<int>(i))) + 1;
+  }
+
+  layout->section_count =
+      V4B_SAVED_SECTIONS + (ctx ? 1 : 0) + (buf->source_map_size ? 1 : 0);
+  layout->dir = align_section(sizeof(V4BytecodeHeader) + code_size);
+  layout->words = align_section(layout->dir + sizeof(V4BytecodeDirectory) +
+                                layout->section_count * sizeof(V4BytecodeSection));
+  layout->word_code =
+      align_section(layout->words + buf->word_count * sizeof(V4BytecodeWord));
+  layout->names = align_section(layout->word_code + layout->code_total);
+  layout->end = layout->names + layout->names_total;
+  layout->context = ctx ? align_section(layout->end) : 0;
+  if (ctx)
+    layout->end = layout->context + layout->context_total;
+  layout->debug = buf->source_map_size ? align_section(layout->end) : 0;
+  if (buf->source_map_size)
+    layout->end = layout->debug + buf->source_map_size;
+}
+
+// Output staged into writes of V4B_IO_CHUNK bytes
+struct ChunkWriter
 {
-  if (!buf || !filename)
+  const V4FrontByteWriter* writer;
+  uint8_t chunk[V4B_IO_CHUNK];
+  size_t used;
+  size_t offset;    // File offset of the next byte
+  v4front_err err;  // First failure: -3 in the header's chunk, -4 later
+
+  void put(const void* data, size_t len)
+  {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len && err == 0)
+    {
+      size_t n = len < sizeof(chunk) - used ? len : sizeof(chunk) - used;
+      memcpy(chunk + used, p, n);
+      used += n;
+      offset += n;
+      p += n;
+      len -= n;
+      if (used == sizeof(chunk))
+        flush();
+    }
+  }
+
+  // Zero bytes up to file offset to
+  void pad_to(size_t to)
+  {
+    static const uint8_t zeros[V4B_SECTION_ALIGN] = {};
+    while (offset < to && err == 0)
+      put(zeros, to - offset < sizeof(zeros) ? to - offset : sizeof(zeros));
+  }
+
+  void flush()
+  {
+    if (used && err == 0 && writer->write(writer->user, chunk, used) != 0)
+      err = offset - used < sizeof(V4BytecodeHeader) ? -3 : -4;
+    used = 0;
+  }
+};
+
+// The words registered in the context of a prelude
+static void write_context(ChunkWriter* out, const V4FrontContext* ctx,
+                          const PlainLayout& layout)
+{
+  out->pad_to(layout.context);
+  uint32_t context_name_at =
+      static_cast<uint32_t>(layout.context_count * sizeof(V4BytecodeContextWord));
+  for (uint32_t i = 0; i < layout.context_count; i++)
+  {
+    const char* name = v4front_context_get_word_name(ctx, static_cast<int>(i));
+    V4BytecodeContextWord entry = {context_name_at, v4front_context_find_word(ctx, name)};
+    out->put(&entry, sizeof(entry));
+    context_name_at += static_cast<uint32_t>(strlen(name) + 1);
+  }
+  for (uint32_t i = 0; i < layout.context_count; i++)
+  {
+    const char* name = v4front_context_get_word_name(ctx, static_cast<int>(i));
+    out->put(name, strlen(name) + 1);
+  }
+}
+
+// The source map section, last in the file
+static void write_debug(ChunkWriter* out, const V4FrontBuf* buf,
+                        const PlainLayout& layout)
+{
+  if (!buf->source_map_size)
+    return;
+  out->pad_to(layout.debug);
+  out->put(buf->source_map, buf->source_map_size);
+}
+
+// Everything that follows the main code in a v0.2 file: padding, the
+// section directory, the word table, the word bytecode and the names, for a
+// prelude the words registered in ctx, and the source map
+static void write_sections(ChunkWriter* out, const V4FrontBuf* buf, uint32_t code_size,
+                           const V4FrontContext* ctx, const PlainLayout& layout)
+{
+  uint32_t count = static_cast<uint32_t>(buf->word_count);
+  out->pad_to(layout.dir);
+  V4BytecodeDirectory directory = {layout.section_count, 0};
+  out->put(&directory, sizeof(directory));
+  V4BytecodeSection sections[V4B_SAVED_SECTIONS + 2] = {
+      {V4B_SECTION_CODE, sizeof(V4BytecodeHeader), code_size, 0},
+      {V4B_SECTION_WORDS, static_cast<uint32_t>(layout.words),
+       static_cast<uint32_t>(count * sizeof(V4BytecodeWord)), count},
+      {V4B_SECTION_WORD_CODE, static_cast<uint32_t>(layout.word_code),
+       static_cast<uint32_t>(layout.code_total), 0},
+      {V4B_SECTION_NAMES, static_cast<uint32_t>(layout.names),
+       static_cast<uint32_t>(layout.names_total), 0},
+      {V4B_SECTION_CONTEXT, static_cast<uint32_t>(layout.context),
+       static_cast<uint32_t>(layout.context_total), layout.context_count},
+      {V4B_SECTION_DEBUG, static_cast<uint32_t>(layout.debug), buf->source_map_size, 0},
+  };
+  if (!ctx)
+    sections[V4B_SAVED_SECTIONS] = sections[V4B_SAVED_SECTIONS + 1];
+  out->put(sections, layout.section_count * sizeof(V4BytecodeSection));
+
+  out->pad_to(layout.words);
+  uint32_t code_at = 0;
+  uint32_t name_at = 0;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    V4BytecodeWord entry = {name_at, code_at, buf->words[i].code_len};
+    out->put(&entry, sizeof(entry));
+    code_at += buf->words[i].code_len;
+    name_at += static_cast<uint32_t>(strlen(buf->words[i].name) + 1);
+  }
+
+  out->pad_to(layout.word_code);
+  for (uint32_t i = 0; i < count; i++)
+    out->put(buf->words[i].code, buf->words[i].code_len);
+
+  out->pad_to(layout.names);
+  for (uint32_t i = 0; i < count; i++)
+    out->put(buf->words[i].name, strlen(buf->words[i].name) + 1);
+  if (ctx)
+    write_context(out, ctx, layout);
+  write_debug(out, buf, layout);
+}
+
+// Build everything that follows the header in a v0.3 file: the section
+// directory, the word table, the names, then the compressed main code and
+// word bytecode, and the source map (not compressed). *out_data is calloc'd.
+static v4front_err build_compressed(const V4FrontBuf* buf, uint32_t code_size,
+                                    uint8_t** out_data, size_t* out_size)
+{
+  uint32_t count = static_cast<uint32_t>(buf->word_count > 0 ? buf->word_count : 0);
+  size_t code_total;
+  size_t names_total;
+  measure_words(buf, &code_total, &names_total);
+  if (code_total > UINT32_MAX)
   {
     return -1;
   }
 
-  if (!buf->data || buf->size == 0)
+  // Compress both code sections first: their sizes decide the layout
+  using v4front::compress_bound;
+  uint8_t* word_code = static_cast<uint8_t*>(malloc(code_total ? code_total : 1));
+  uint8_t* packed_main = static_cast<uint8_t*>(malloc(compress_bound(code_size)));
+  uint8_t* packed_words = static_cast<uint8_t*>(malloc(compress_bound(code_total)));
+  size_t main_len = 0;
+  size_t words_len = 0;
+  bool ok = word_code && packed_main && packed_words;
+  if (ok)
+  {
+    fill_words(buf, nullptr, word_code, nullptr);
+    main_len = v4front::compress(buf->data, code_size, packed_main);
+    words_len = v4front::compress(word_code, code_total, packed_words);
+    ok = (main_len || !code_size) && (words_len || !code_total);
+  }
+  free(word_code);
+
+  uint32_t code_sections = count ? 4 : 1;
+  uint32_t section_count = code_sections + (buf->source_map_size ? 1 : 0);
+  size_t dir = sizeof(V4BytecodeHeader);
+  size_t words = align_section(dir + sizeof(V4BytecodeDirectory) +
+                               section_count * sizeof(V4BytecodeSection));
+  size_t names = align_section(words + count * sizeof(V4BytecodeWord));
+  size_t code = align_section(names + names_total);
+  size_t packed = align_section(code + main_len);
+  size_t debug = align_section(packed + words_len);
+  size_t end = buf->source_map_size ? debug + buf->source_map_size : packed + words_len;
+
+  uint8_t* tail = ok && end <= UINT32_MAX ? static_cast<uint8_t*>(calloc(1, end - dir))
+                                          : nullptr;
+  if (!tail)
+  {
+    free(packed_main);
+    free(packed_words);
+    return ok && end > UINT32_MAX ? -1 : -5;
+  }
+  // tail holds the file from offset dir on
+
+  V4BytecodeDirectory directory = {section_count, 0};
+  memcpy(tail, &directory, sizeof(directory));
+  V4BytecodeSection sections[5] = {
+      {V4B_SECTION_CODE, static_cast<uint32_t>(code), static_cast<uint32_t>(main_len),
+       code_size},
+      {V4B_SECTION_WORDS, static_cast<uint32_t>(words),
+       static_cast<uint32_t>(count * sizeof(V4BytecodeWord)), count},
+      {V4B_SECTION_NAMES, static_cast<uint32_t>(names),
+       static_cast<uint32_t>(names_total), 0},
+      {V4B_SECTION_WORD_CODE, static_cast<uint32_t>(packed),
+       static_cast<uint32_t>(words_len), static_cast<uint32_t>(code_total)},
+      {V4B_SECTION_DEBUG, static_cast<uint32_t>(debug), buf->source_map_size, 0},
+  };
+  sections[code_sections] = sections[4];
+  memcpy(tail + sizeof(directory), sections, section_count * sizeof(V4BytecodeSection));
+  fill_words(buf, tail + (words - dir), nullptr, tail + (names - dir));
+  memcpy(tail + (code - dir), packed_main, main_len);
+  memcpy(tail + (packed - dir), packed_words, words_len);
+  if (buf->source_map_size)
+    memcpy(tail + (debug - dir), buf->source_map, buf->source_map_size);
+  free(packed_main);
+  free(packed_words);
+
+  *out_data = tail;
+  *out_size = end - dir;
+  return 0;
+}
+
+// Locate and check the sections of a complete, uncompressed file of length
+// bytes. Files without V4B_FLAG_SECTIONS have none (an empty view).
+static v4front_err parse_sections(const uint8_t* file, size_t length,
+                                  const V4BytecodeHeader& header, SectionView* view)
+{
+  memset(view, 0, sizeof(*view));
+  if (!(header.flags & V4B_FLAG_SECTIONS))
+  {
+    return 0;
+  }
+
+  size_t code_end = sizeof(V4BytecodeHeader) + header.code_size;
+  size_t dir = header.reserved;
+  if (dir % V4B_SECTION_ALIGN != 0 || dir < code_end || dir > length ||
+      length - dir < sizeof(V4BytecodeDirectory))
+  {
+    return -7;
+  }
+  V4BytecodeDirectory directory;
+  memcpy(&directory, file + dir, sizeof(directory));
+  size_t entries_at = dir + sizeof(directory);
+  if (directory.section_count > (length - entries_at) / sizeof(V4BytecodeSection))
+  {
+    return -7;
+  }
+
+  const V4BytecodeSection* found[V4B_SECTION_CONTEXT + 1] = {};
+  V4BytecodeSection sections[V4B_SECTION_CONTEXT + 1];
+  for (uint32_t i = 0; i < directory.section_count; i++)
+  {
+    V4BytecodeSection section;
+    memcpy(&section, file + entries_at + i * sizeof(section), sizeof(section));
+    if (section.offset % V4B_SECTION_ALIGN != 0 || section.offset > length ||
+        section.size > length - section.offset)
+    {
+      return -7;
+    }
+    if (section.type < V4B_SECTION_CODE || section.type > V4B_SECTION_CONTEXT)
+    {
+      continue;  // Unknown section
+    }
+    if (found[section.type])
+    {
+      return -7;  // Duplicate section
+    }
+    sections[section.type] = section;
+    found[section.type] = &sections[section.type];
+  }
+
+  // The code section, if listed, is the main code after the header
+  const V4BytecodeSection* code = found[V4B_SECTION_CODE];
+  if (code &&
+      (code->offset != sizeof(V4BytecodeHeader) || code->size != header.code_size))
+  {
+    return -7;
+  }
+
+  const V4BytecodeSection* debug = found[V4B_SECTION_DEBUG];
+  if (debug)
+  {
+    view->debug = file + debug->offset;
+    view->debug_size = debug->size;
+  }
+
+  // Context entries come first; their names are the rest of the section
+  const V4BytecodeSection* context = found[V4B_SECTION_CONTEXT];
+  if (context)
+  {
+    const uint8_t* at = file + context->offset;
+    size_t table_size =
+        static_cast<size_t>(context->count) * sizeof(V4BytecodeContextWord);
+    bool names_ok = table_size < context->size && at[context->size - 1] == '\0';
+    if (context->count > INT_MAX || table_size > context->size ||
+        (context->count && !names_ok))
+    {
+      return -7;
+    }
+    const V4BytecodeContextWord* entries =
+        reinterpret_cast<const V4BytecodeContextWord*>(at);
+    for (uint32_t i = 0; i < context->count; i++)
+    {
+      if (entries[i].name_offset < table_size || entries[i].name_offset >= context->size)
+      {
+        return -7;
+      }
+    }
+    view->context = at;
+    view->context_count = context->count;
+    view->context_size = context->size;
+  }
+
+  const V4BytecodeSection* words = found[V4B_SECTION_WORDS];
+  if (!words || words->count == 0)
+  {
+    return 0;
+  }
+  const V4BytecodeSection* word_code = found[V4B_SECTION_WORD_CODE];
+  const V4BytecodeSection* names = found[V4B_SECTION_NAMES];
+  if (words->count > INT_MAX || words->size / sizeof(V4BytecodeWord) != words->count ||
+      words->size % sizeof(V4BytecodeWord) != 0 || !word_code || !names ||
+      names->size == 0 || file[names->offset + names->size - 1] != '\0')
+  {
+    return -7;
+  }
+
+  // The last name is terminated, so every name offset in range is a string
+  const V4BytecodeWord* table =
+      reinterpret_cast<const V4BytecodeWord*>(file + words->offset);
+  for (uint32_t i = 0; i < words->count; i++)
+  {
+    if (table[i].name_offset >= names->size || table[i].code_offset > word_code->size ||
+        table[i].code_len > word_code->size - table[i].code_offset)
+    {
+      return -7;
+    }
+  }
+
+  view->words = table;
+  view->word_count = words->count;
+  view->word_code = file + word_code->offset;
+  view->names = reinterpret_cast<const char*>(file + names->offset);
+  return 0;
+}
+
+// Input read in requests of at most V4B_IO_CHUNK bytes, front to back
+struct ChunkReader
+{
+  const V4FrontByteReader* reader;
+  size_t offset;  // File offset of the next byte
+
+  // Read exactly len bytes into dst (NULL: discard them); false at the end
+  // of the input
+  bool read(void* dst, size_t len)
+  {
+    uint8_t scratch[V4B_IO_CHUNK];
+    uint8_t* p = static_cast<uint8_t*>(dst);
+    while (len)
+    {
+      size_t want = len < sizeof(scratch) ? len : sizeof(scratch);
+      size_t got = reader->read(reader->user, p ? p : scratch, want);
+      if (got == 0 || got > want)
+        return false;
+      offset += got;
+      len -= got;
+      if (p)
+        p += got;
+    }
+    return true;
+  }
+
+  // Skip to file offset to; false if it lies behind (or past the end)
+  bool skip_to(size_t to) { return to >= offset && read(nullptr, to - offset); }
+};
+
+// Temporary buffers of read_sections
+struct SectionScratch
+{
+  V4BytecodeWord* table;
+  char* names;
+  uint8_t* word_code;  // Whole word bytecode (inflated, or read before the table)
+
+  ~SectionScratch()
+  {
+    free(table);
+    free(names);
+    free(word_code);
+  }
+};
+
+// Copy the bytes [at, at + len) of the word bytecode into the words they
+// belong to
+static void distribute_word_code(V4FrontBuf* out, const V4BytecodeWord* table, size_t at,
+                                 const uint8_t* data, size_t len)
+{
+  for (int i = 0; i < out->word_count; i++)
+  {
+    size_t begin = table[i].code_offset;
+    size_t end = begin + table[i].code_len;
+    size_t lo = at > begin ? at : begin;
+    size_t hi = at + len < end ? at + len : end;
+    if (lo < hi)
+      memcpy(out->words[i].code + (lo - begin), data + (lo - at), hi - lo);
+  }
+}
+
+// Inflate a compressed section of size bytes into exactly cap bytes at dst
+static v4front_err inflate_stream(ChunkReader* in, size_t size, uint8_t* dst, size_t cap)
+{
+  V4FrontInflater z;
+  v4front_inflate_init(&z, dst, cap);
+  uint8_t chunk[V4B_IO_CHUNK];
+  while (size)
+  {
+    size_t n = size < sizeof(chunk) ? size : sizeof(chunk);
+    if (!in->read(chunk, n) || v4front_inflate_feed(&z, chunk, n) != 0)
+      return -7;
+    size -= n;
+  }
+  return v4front_inflate_finish(&z);
+}
+
+// Read and check the word table, and allocate every word's code
+static v4front_err read_word_table(ChunkReader* in, const V4BytecodeSection& section,
+                                   uint32_t code_size, V4FrontBuf* out,
+                                   SectionScratch* scratch)
+{
+  uint32_t count = section.count;
+  scratch->table = static_cast<V4BytecodeWord*>(malloc(section.size ? section.size : 1));
+  if (!scratch->table)
+    return -5;
+  if (!in->read(scratch->table, section.size))
+    return -7;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const V4BytecodeWord& entry = scratch->table[i];
+    if (entry.code_offset > code_size || entry.code_len > code_size - entry.code_offset)
+      return -7;
+  }
+
+  out->words = static_cast<V4FrontWord*>(calloc(count, sizeof(V4FrontWord)));
+  if (!out->words)
+    return -5;
+  out->word_count = static_cast<int>(count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    uint32_t len = scratch->table[i].code_len;
+    out->words[i].code = static_cast<uint8_t*>(malloc(len ? len : 1));
+    out->words[i].code_len = len;
+    if (!out->words[i].code)
+      return -5;
+  }
+  return 0;
+}
+
+// Read the sections of a v0.2/v0.3 file into separately malloc'd words of
+// out (the layout v4front_free releases). in is positioned after the main
+// code; the main code of a compressed file is inflated into out->data.
+static v4front_err read_sections(ChunkReader* in, const V4BytecodeHeader& header,
+                                 V4FrontBuf* out)
+{
+  bool compressed = header.flags & V4B_FLAG_COMPRESSED;
+  V4BytecodeDirectory directory;
+  if (header.reserved % V4B_SECTION_ALIGN != 0 || !in->skip_to(header.reserved) ||
+      !in->read(&directory, sizeof(directory)))
+  {
+    return -7;
+  }
+
+  // Sections still to be read, sorted by offset
+  V4BytecodeSection order[V4B_SECTION_DEBUG];
+  uint32_t pending = 0;
+  bool seen[V4B_SECTION_DEBUG + 1] = {};
+  const V4BytecodeSection* words = nullptr;
+  uint32_t word_code_size = 0;
+  uint32_t names_size = 0;
+  for (uint32_t i = 0; i < directory.section_count; i++)
+  {
+    V4BytecodeSection section;
+    if (!in->read(&section, sizeof(section)) || section.offset % V4B_SECTION_ALIGN != 0 ||
+        section.size > UINT32_MAX - section.offset)
+    {
+      return -7;
+    }
+    if (section.type < V4B_SECTION_CODE || section.type > V4B_SECTION_DEBUG)
+    {
+      continue;  // Unknown section
+    }
+    if (seen[section.type])
+    {
+      return -7;  // Duplicate section
+    }
+    seen[section.type] = true;
+
+    if (section.type == V4B_SECTION_CODE)
+    {
+      if (compressed ? section.count != header.code_size
+                     : section.offset != sizeof(V4BytecodeHeader) ||
+                           section.size != header.code_size)
+      {
+        return -7;
+      }
+      if (!compressed)
+        continue;  // Already read, right after the header
+    }
+    else if (section.type == V4B_SECTION_WORD_CODE)
+    {
+      word_code_size = compressed ? section.count : section.size;
+    }
+    else if (section.type == V4B_SECTION_NAMES)
+    {
+      names_size = section.size;
+    }
+    else if (section.type == V4B_SECTION_DEBUG && section.size == 0)
+    {
+      continue;  // Nothing to keep
+    }
+
+    uint32_t at = pending++;
+    while (at > 0 && order[at - 1].offset > section.offset)
+    {
+      order[at] = order[at - 1];
+      at--;
+    }
+    order[at] = section;
+  }
+  for (uint32_t i = 0; i < pending; i++)
+  {
+    if (order[i].type == V4B_SECTION_WORDS)
+      words = &order[i];
+  }
+
+  uint32_t count = words ? words->count : 0;
+  if ((compressed && !seen[V4B_SECTION_CODE]) ||
+      (words && (count > INT_MAX || words->size / sizeof(V4BytecodeWord) != count ||
+                 words->size % sizeof(V4BytecodeWord) != 0)) ||
+      (count && (!seen[V4B_SECTION_WORD_CODE] || names_size == 0)))
+  {
+    return -7;
+  }
+
+  SectionScratch scratch = {};
+  for (uint32_t i = 0; i < pending; i++)
+  {
+    const V4BytecodeSection& section = order[i];
+    if (!in->skip_to(section.offset))
+    {
+      return -7;  // Overlaps the previous section
+    }
+
+    v4front_err err = 0;
+    if (section.type == V4B_SECTION_CODE)
+    {
+      err = inflate_stream(in, section.size, out->data, header.code_size);
+    }
+    else if (section.type == V4B_SECTION_WORDS)
+    {
+      err = count ? read_word_table(in, section, word_code_size, out, &scratch) : 0;
+    }
+    else if (section.type == V4B_SECTION_DEBUG)
+    {
+      // Kept as the source map (whatever it holds: the loader does not look)
+      uint8_t* map = static_cast<uint8_t*>(malloc(section.size));
+      if (!map)
+      {
+        err = -5;
+      }
+      else if (!in->read(map, section.size))
+      {
+        free(map);
+        err = -7;
+      }
+      else
+      {
+        out->source_map = map;
+        out->source_map_size = section.size;
+      }
+    }
+    else if (section.type == V4B_SECTION_NAMES)
+    {
+      scratch.names = static_cast<char*>(malloc(section.size ? section.size : 1));
+      if (!scratch.names)
+        err = -5;
+      else if (!in->read(scratch.names, section.size) ||
+               (section.size && scratch.names[section.size - 1] != '\0'))
+        err = -7;
+    }
+    else if (section.type == V4B_SECTION_WORD_CODE && (compressed || !scratch.table))
+    {
+      // Held whole: inflating needs the output so far, and words cannot be
+      // placed before the table is known
+      size_t size = word_code_size ? word_code_size : 1;
+      scratch.word_code = static_cast<uint8_t*>(malloc(size));
+      if (!scratch.word_code)
+        err = -5;
+      else if (compressed)
+        err = inflate_stream(in, section.size, scratch.word_code, word_code_size);
+      else if (!in->read(scratch.word_code, section.size))
+        err = -7;
+    }
+    else if (section.type == V4B_SECTION_WORD_CODE)
+    {
+      // Streamed chunk by chunk into the words
+      uint8_t chunk[V4B_IO_CHUNK];
+      for (size_t at = 0; at < section.size && err == 0; at += sizeof(chunk))
+      {
+        size_t n = section.size - at < sizeof(chunk) ? section.size - at : sizeof(chunk);
+        if (in->read(chunk, n))
+          distribute_word_code(out, scratch.table, at, chunk, n);
+        else
+          err = -7;
+      }
+    }
+    if (err != 0)
+    {
+      return err;
+    }
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  if (scratch.word_code)
+  {
+    distribute_word_code(out, scratch.table, 0, scratch.word_code, word_code_size);
+  }
+
+  // The last name is terminated, so every name offset in range is a string
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (scratch.table[i].name_offset >= names_size)
+    {
+      return -7;
+    }
+    const char* name = scratch.names + scratch.table[i].name_offset;
+    size_t name_len = strlen(name) + 1;
+    out->words[i].name = static_cast<char*>(malloc(name_len));
+    if (!out->words[i].name)
+    {
+      return -5;
+    }
+    memcpy(out->words[i].name, name, name_len);
+  }
+  return 0;
+}
+
+// Byte stream callbacks on a FILE*
+static int write_file_chunk(void* user, const uint8_t* data, size_t len)
+{
+  return fwrite(data, 1, len, static_cast<FILE*>(user)) == len ? 0 : -1;
+}
+
+static size_t read_file_chunk(void* user, uint8_t* dst, size_t len)
+{
+  return fread(dst, 1, len, static_cast<FILE*>(user));
+}
+
+// Whether buf can be saved (-1 if not)
+static v4front_err check_saveable(const V4FrontBuf* buf)
+{
+  bool has_words = buf->words && buf->word_count > 0;
+  bool has_code = buf->data && buf->size > 0;
+  if ((!has_code && !has_words) || buf->size > UINT32_MAX)
   {
     return -1;
   }
+  return 0;
+}
 
-  FILE* fp = fopen(filename, "wb");
-  if (!fp)
+// Write buf through writer; with ctx, as a prelude (always v0.2, never
+// compressed). The caller has checked buf.
+static v4front_err write_bytecode(const V4FrontBuf* buf, uint32_t flags,
+                                  const V4FrontContext* ctx,
+                                  const V4FrontByteWriter* writer)
+{
+  bool has_sections =
+      (buf->words && buf->word_count > 0) || ctx || buf->source_map_size > 0;
+  uint32_t code_size = buf->data ? static_cast<uint32_t>(buf->size) : 0;
+  bool compressed = (flags & V4B_SAVE_COMPRESS) && !ctx;
+
+  // Compressed sections are built first: the directory holds their sizes
+  uint8_t* packed = nullptr;
+  size_t packed_size = 0;
+  PlainLayout layout = {};
+  if (compressed)
   {
-    return -2;
+    v4front_err err = build_compressed(buf, code_size, &packed, &packed_size);
+    if (err != 0)
+    {
+      return err;
+    }
+  }
+  else if (has_sections)
+  {
+    plain_layout(buf, code_size, ctx, &layout);
+    if (layout.end > UINT32_MAX)
+    {
+      return -1;  // Offsets are 32-bit
+    }
   }
 
   // Build header
@@ -35,27 +822,176 @@ extern "C" v4front_err v4front_save_bytecode(const V4FrontBuf* buf, const char*
   header.version_major = V4B_VERSION_MAJOR;
   header.version_minor = V4B_VERSION_MINOR;
   header.flags = 0;
-  header.code_size = static_cast<uint32_t>(buf->size);
+  header.code_size = code_size;
   header.reserved = 0;
+  if (compressed)
+  {
+    header.version_minor = V4B_VERSION_MINOR_COMPRESSED;
+    header.flags = V4B_FLAG_SECTIONS | V4B_FLAG_COMPRESSED;
+    header.reserved = sizeof(V4BytecodeHeader);
+  }
+  else if (has_sections)
+  {
+    header.version_minor = V4B_VERSION_MINOR_SECTIONS;
+    header.flags = V4B_FLAG_SECTIONS;
+    header.reserved = static_cast<uint32_t>(layout.dir);
+  }
+
+  // Header, then the bytecode (compressed files hold it in a section), then
+  // the sections
+  ChunkWriter out;
+  out.writer = writer;
+  out.used = 0;
+  out.offset = 0;
+  out.err = 0;
+  out.put(&header, sizeof(header));
+  if (compressed)
+  {
+    out.put(packed, packed_size);
+  }
+  else
+  {
+    out.put(buf->data, code_size);
+    if (has_sections)
+      write_sections(&out, buf, code_size, ctx, layout);
+  }
+  out.flush();
+
+  free(packed);
+  return out.err;
+}
+
+extern "C" v4front_err v4front_write_bytecode_cb(const V4FrontBuf* buf, uint32_t flags,
+                                                 const V4FrontByteWriter* writer)
+{
+  if (!buf || !writer || !writer->write || check_saveable(buf) != 0)
+  {
+    return -1;
+  }
+  return write_bytecode(buf, flags, nullptr, writer);
+}
 
-  // Write header
-  if (fwrite(&header, sizeof(header), 1, fp) != 1)
+extern "C" v4front_err v4front_read_bytecode_cb(const V4FrontByteReader* reader,
+                                                V4FrontBuf* out_buf)
+{
+  if (!reader || !reader->read || !out_buf)
+  {
+    return -1;
+  }
+
+  // Read header
+  ChunkReader in = {reader, 0};
+  V4BytecodeHeader header;
+  if (!in.read(&header, sizeof(header)))
   {
-    fclose(fp);
     return -3;
   }
 
-  // Write bytecode
-  if (fwrite(buf->data, 1, buf->size, fp) != buf->size)
+  // Validate magic number
+  if (memcmp(header.magic, V4B_MAGIC, 4) != 0)
   {
-    fclose(fp);
     return -4;
   }
+  bool compressed = header.flags & V4B_FLAG_COMPRESSED;
+  bool sections = header.flags & V4B_FLAG_SECTIONS;
+  if (compressed && !sections)
+  {
+    return -7;
+  }
+
+  // Allocate bytecode buffer (one byte for an empty main code)
+  uint8_t* data = static_cast<uint8_t*>(malloc(header.code_size ? header.code_size : 1));
+  if (!data)
+  {
+    return -5;
+  }
+
+  // Read bytecode (compressed files: inflated from its section below)
+  if (!compressed && !in.read(data, header.code_size))
+  {
+    free(data);
+    return -6;
+  }
+
+  // Populate output buffer
+  out_buf->data = data;
+  out_buf->size = header.code_size;
+  out_buf->words = nullptr;
+  out_buf->word_count = 0;
+  out_buf->block = nullptr;
+  out_buf->relocs = nullptr;
+  out_buf->reloc_count = 0;
+  out_buf->source_map = nullptr;
+  out_buf->source_map_size = 0;
+
+  // Words of a v0.2 file
+  if (sections)
+  {
+    v4front_err err = read_sections(&in, header, out_buf);
+    if (err != 0)
+    {
+      v4front_free(out_buf);
+      return err;
+    }
+  }
 
-  fclose(fp);
   return 0;
 }
 
+extern "C" v4front_err v4front_save_bytecode(const V4FrontBuf* buf, const char* filename)
+{
+  return v4front_save_bytecode_with_flags(buf, filename, 0);
+}
+
+// Write a file with write_bytecode; a partial file is removed
+static v4front_err save_file(const V4FrontBuf* buf, const char* filename, uint32_t flags,
+                             const V4FrontContext* ctx)
+{
+  FILE* fp = fopen(filename, "wb");
+  if (!fp)
+  {
+    return -2;
+  }
+
+  V4FrontByteWriter writer = {write_file_chunk, fp};
+  v4front_err err = write_bytecode(buf, flags, ctx, &writer);
+  if (fclose(fp) != 0 && err == 0)
+  {
+    err = -4;
+  }
+  if (err != 0)
+  {
+    remove(filename);
+  }
+  return err;
+}
+
+extern "C" v4front_err v4front_save_bytecode_with_flags(const V4FrontBuf* buf,
+                                                        const char* filename,
+                                                        uint32_t flags)
+{
+  if (!buf || !filename || check_saveable(buf) != 0)
+  {
+    return -1;
+  }
+  return save_file(buf, filename, flags, nullptr);
+}
+
+extern "C" v4front_err v4front_save_prelude(const V4FrontContext* ctx,
+                                            const V4FrontBuf* lib, const char* filename)
+{
+  V4FrontBuf empty = {nullptr, 0, nullptr, 0, nullptr, nullptr, 0, nullptr, 0};
+  if (!lib)
+  {
+    lib = &empty;
+  }
+  if (!ctx || !filename || lib->size > UINT32_MAX)
+  {
+    return -1;
+  }
+  return save_file(lib, filename, 0, ctx);
+}
+
 extern "C" v4front_err v4front_load_bytecode(const char* filename, V4FrontBuf* out_buf)
 {
   if (!filename || !out_buf)
@@ -69,44 +1005,235 @@ extern "C" v4front_err v4front_load_bytecode(const char* filename, V4FrontBuf* o
     return -2;
   }
 
-  // Read header
+  V4FrontByteReader reader = {read_file_chunk, fp};
+  v4front_err err = v4front_read_bytecode_cb(&reader, out_buf);
+  fclose(fp);
+  return err;
+}
+
+// Map the whole file read-only; false on failure (*base/*length untouched)
+static bool map_file(const char* filename, void** base, size_t* length, bool* opened)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  *opened = true;
+
+  LARGE_INTEGER size;
+  void* view = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0 &&
+      static_cast<unsigned long long>(size.QuadPart) <= SIZE_MAX)
+  {
+    // The view keeps the mapping alive; both handles can go right away
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+    {
+      view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+  if (!view)
+    return false;
+  *base = view;
+  *length = static_cast<size_t>(size.QuadPart);
+  return true;
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+  *opened = true;
+
+  struct stat st;
+  void* view = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping stays valid without the descriptor
+  if (view == MAP_FAILED)
+    return false;
+  *base = view;
+  *length = static_cast<size_t>(st.st_size);
+  return true;
+#endif
+}
+
+static void unmap_file(void* base, size_t length)
+{
+#ifdef _WIN32
+  (void)length;
+  UnmapViewOfFile(base);
+#else
+  munmap(base, length);
+#endif
+}
+
+// Map filename into out_map; view receives every section parse_sections
+// located
+static v4front_err map_bytecode(const char* filename, V4FrontMappedBytecode* out_map,
+                                SectionView* view)
+{
+  memset(out_map, 0, sizeof(*out_map));
+
+  void* base;
+  size_t length;
+  bool opened = false;
+  if (!map_file(filename, &base, &length, &opened))
+  {
+    return opened ? -3 : -2;  // An empty file cannot be mapped (and has no header)
+  }
+
+  // The header is read from the mapping; the code is never copied
   V4BytecodeHeader header;
-  if (fread(&header, sizeof(header), 1, fp) != 1)
+  if (length < sizeof(header))
   {
-    fclose(fp);
+    unmap_file(base, length);
     return -3;
   }
+  memcpy(&header, base, sizeof(header));
 
   // Validate magic number
   if (memcmp(header.magic, V4B_MAGIC, 4) != 0)
   {
-    fclose(fp);
+    unmap_file(base, length);
     return -4;
   }
 
-  // Allocate bytecode buffer
-  uint8_t* data = static_cast<uint8_t*>(malloc(header.code_size));
-  if (!data)
+  // Compressed code has to be inflated into memory first
+  if (header.flags & V4B_FLAG_COMPRESSED)
   {
-    fclose(fp);
-    return -5;
+    unmap_file(base, length);
+    return -8;
   }
 
-  // Read bytecode
-  if (fread(data, 1, header.code_size, fp) != header.code_size)
+  // The code must lie within the file
+  if (header.code_size > length - sizeof(header))
   {
-    free(data);
-    fclose(fp);
+    unmap_file(base, length);
     return -6;
   }
 
-  fclose(fp);
+  // Sections are used in place: they are aligned, and the mapping is
+  // page-aligned
+  v4front_err err =
+      parse_sections(static_cast<const uint8_t*>(base), length, header, view);
+  if (err != 0)
+  {
+    unmap_file(base, length);
+    return err;
+  }
 
-  // Populate output buffer
-  out_buf->data = data;
-  out_buf->size = header.code_size;
-  out_buf->words = nullptr;
-  out_buf->word_count = 0;
+  out_map->code = static_cast<const uint8_t*>(base) + sizeof(header);
+  out_map->size = header.code_size;
+  out_map->base = base;
+  out_map->length = length;
+  out_map->words = view->words;
+  out_map->word_count = view->word_count;
+  out_map->word_code = view->word_code;
+  out_map->names = view->names;
+  out_map->debug = view->debug;
+  out_map->debug_size = view->debug_size;
+
+  return 0;
+}
+
+extern "C" v4front_err v4front_map_bytecode(const char* filename,
+                                             V4FrontMappedBytecode* out_map)
+{
+  if (!filename || !out_map)
+  {
+    return -1;
+  }
+
+  SectionView view;
+  return map_bytecode(filename, out_map, &view);
+}
 
+extern "C" v4front_err v4front_mapped_word(const V4FrontMappedBytecode* map,
+                                           uint32_t idx, const char** out_name,
+                                           const uint8_t** out_code, uint32_t* out_len)
+{
+  if (!map || idx >= map->word_count)
+  {
+    return -1;
+  }
+
+  const V4BytecodeWord& word = map->words[idx];
+  if (out_name)
+  {
+    *out_name = map->names + word.name_offset;
+  }
+  if (out_code)
+  {
+    *out_code = map->word_code + word.code_offset;
+  }
+  if (out_len)
+  {
+    *out_len = word.code_len;
+  }
   return 0;
 }
+
+extern "C" void v4front_unmap_bytecode(V4FrontMappedBytecode* map)
+{
+  if (!map || !map->base)
+  {
+    return;
+  }
+
+  unmap_file(map->base, map->length);
+  memset(map, 0, sizeof(*map));
+}
+
+extern "C" v4front_err v4front_context_load_prelude(V4FrontContext* ctx,
+                                                    const char* filename,
+                                                    V4FrontMappedBytecode* out_lib)
+{
+  if (!ctx || !filename)
+  {
+    return -1;
+  }
+
+  V4FrontMappedBytecode map;
+  SectionView view;
+  v4front_err err = map_bytecode(filename, &map, &view);
+  if (err != 0)
+  {
+    return err;
+  }
+  if (!view.context)
+  {
+    v4front_unmap_bytecode(&map);
+    return -7;
+  }
+
+  // Names are registered (copied) straight from the mapping
+  v4front_context_reset(ctx);
+  const V4BytecodeContextWord* entries =
+      reinterpret_cast<const V4BytecodeContextWord*>(view.context);
+  for (uint32_t i = 0; i < view.context_count && err == 0; i++)
+  {
+    const char* name =
+        reinterpret_cast<const char*>(view.context) + entries[i].name_offset;
+    v4front_err reg = v4front_context_register_word(ctx, name, entries[i].vm_word_idx);
+    if (reg != 0)
+    {
+      err = reg == V4FRONT_ERR_OutOfMemory ? -5 : -1;
+    }
+  }
+  if (err != 0)
+  {
+    v4front_context_reset(ctx);
+  }
+
+  if (err != 0 || !out_lib)
+  {
+    v4front_unmap_bytecode(&map);
+  }
+  else
+  {
+    *out_lib = map;
+  }
+  return err;
+}
@@ -0,0 +1,69 @@
+#pragma once
+// Internal character classification for the tokenizer.
+//
+//  - One 256-entry table indexed by the source byte, built at compile time.
+//    It replaces <cctype>, whose answers depend on the C locale (isspace(0xA0)
+//    is true in some Latin-1 locales) and which needs an unsigned char cast
+//    at every call.
+//  - Whitespace is the C-locale set: space, \t, \n, \v, \f, \r. Every other
+//    byte, including all bytes >= 0x80, is part of a token.
+
+#include <cstdint>
+
+namespace v4front
+{
+
+struct CharInfo
+{
+  uint8_t space;  // 1 for token separators
+  uint8_t digit;  // Digit value in bases up to 36 (0-9, A-Z/a-z), or kNoDigit
+  uint8_t fold;   // ASCII upper case of the byte (other bytes unchanged)
+};
+
+static constexpr uint8_t kNoDigit = 0xFF;
+
+struct CharTable
+{
+  CharInfo info[256];
+};
+
+static constexpr CharTable build_char_table()
+{
+  CharTable t{};
+  for (int c = 0; c < 256; c++)
+  {
+    CharInfo& e = t.info[c];
+    e.space = (c == ' ' || (c >= '\t' && c <= '\r')) ? 1 : 0;
+    if (c >= '0' && c <= '9')
+      e.digit = static_cast<uint8_t>(c - '0');
+    else if (c >= 'A' && c <= 'Z')
+      e.digit = static_cast<uint8_t>(c - 'A' + 10);
+    else if (c >= 'a' && c <= 'z')
+      e.digit = static_cast<uint8_t>(c - 'a' + 10);
+    else
+      e.digit = kNoDigit;
+    e.fold = static_cast<uint8_t>((c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c);
+  }
+  return t;
+}
+
+static constexpr CharTable CHAR_TABLE = build_char_table();
+
+static constexpr bool is_space(char c)
+{
+  return CHAR_TABLE.info[static_cast<uint8_t>(c)].space != 0;
+}
+
+// Value of c as a digit, or kNoDigit
+static constexpr uint8_t digit_value(char c)
+{
+  return CHAR_TABLE.info[static_cast<uint8_t>(c)].digit;
+}
+
+// ASCII case folding (locale independent)
+static constexpr char fold_ascii(char c)
+{
+  return static_cast<char>(CHAR_TABLE.info[static_cast<uint8_t>(c)].fold);
+}
+
+}  // namespace v4front
@@ -1,234 +1,378 @@
 #include "v4front/compile.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <cctype>
+#include <chrono>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 
 #include "v4/opcodes.hpp"
+#include "arena.hpp"
+#include "char_class.hpp"
+#include "const_eval.hpp"
+#include "disk_cache.hpp"
+#include "ir.hpp"
+#include "lexer.hpp"
+#include "op_info.hpp"
+#include "passes.hpp"
+#include "profile.hpp"
+#include "scan.hpp"
+#include "stack_effect.hpp"
+#include "superinsn.hpp"
 #include "v4front/errors.hpp"
+#include "v4front/image.h"
+#include "word_cache.hpp"
+#include "word_table.hpp"
+#include "work_pool.hpp"
+#include "yield.hpp"
 
 using namespace v4front;
 
 // ---------------------------------------------------------------------------
-// Platform-specific string duplication
+// Bytecode buffer (storage comes from the compile's arena)
 // ---------------------------------------------------------------------------
-static char* portable_strdup(const char* s)
+struct CodeBuf
 {
-#ifdef _MSC_VER
-  return _strdup(s);
-#else
-  return strdup(s);
-#endif
-}
-
-// ---------------------------------------------------------------------------
-// Helper: case-insensitive string comparison
-// ---------------------------------------------------------------------------
-static bool str_eq_ci(const char* a, const char* b)
-{
-  while (*a && *b)
-  {
-    if (tolower((unsigned char)*a) != tolower((unsigned char)*b))
-      return false;
-    ++a;
-    ++b;
-  }
-  return *a == *b;
-}
+  uint8_t* data;  // Bytecode
+  uint32_t size;  // Bytes used
+  uint32_t cap;   // Bytes reserved
+  Arena* arena;   // Storage source
+};
 
 // ---------------------------------------------------------------------------
 // Forward declarations
 // ---------------------------------------------------------------------------
-static FrontErr append_byte(uint8_t** buf, uint32_t* size, uint32_t* cap, uint8_t byte);
+static FrontErr append_byte(CodeBuf* buf, uint8_t byte);
 
 // ---------------------------------------------------------------------------
-// Opcode dispatch table for simple single-byte instructions
+// Keyword dispatch table
+//  - Every built-in token (defining words, control flow, composites and
+//    single-opcode primitives) is listed once and classified by KeywordId.
+//  - Lookup goes through a compile-time built, case-folded hash index, so
+//    classifying a token costs one hash and (almost always) one probe.
 // ---------------------------------------------------------------------------
-struct OpcodeMapping
+enum class KeywordId : uint8_t
 {
-  const char* token;
-  v4::Op opcode;
-  bool case_sensitive;  // true for symbols like +, -, @, !
+  None,
+
+  // Reserved: resolved before the dictionary, cannot be redefined
+  Colon,
+  Semicolon,
+  Begin,
+  Do,
+  Until,
+  While,
+  Repeat,
+  Again,
+  Leave,
+  Loop,
+  PlusLoop,
+  If,
+  Else,
+  Then,
+  Exit,
+  Emit,
+  Key,
+  LocalInc,
+  LocalDec,
+  LocalGet,
+  LocalSet,
+  LocalTee,
+  Recurse,
+  Constant,
+  Variable,
+  Create,
+  Allot,
+  AlignTo,
+
+  // Composites: resolved after the dictionary (user words may shadow them)
+  LoopI,
+  LoopJ,
+  LoopK,
+  Rot,
+  Nip,
+  Tuck,
+  Negate,
+  QDup,
+  Abs,
+  Min,
+  Max,
+  ZeroEq,
+  ZeroLt,
+  ZeroGt,
+  TwoDup,
+  TwoDrop,
+  TwoSwap,
+  TwoOver,
+  PlusStore,
+  True,
+  False,
+
+  // Single-opcode primitive (emits KeywordEntry::opcode)
+  Simple,
 };
 
-static const OpcodeMapping OPCODE_TABLE[] = {
+struct KeywordEntry
+{
+  const char* name;  // Canonical (upper-case) spelling
+  KeywordId id;
+  v4::Op opcode;  // Only meaningful for KeywordId::Simple
+};
+
+static constexpr KeywordEntry KEYWORD_TABLE[] = {
+    // Word definitions
+    {":", KeywordId::Colon, v4::Op::RET},
+    {";", KeywordId::Semicolon, v4::Op::RET},
+    {"CONSTANT", KeywordId::Constant, v4::Op::RET},
+    {"VARIABLE", KeywordId::Variable, v4::Op::RET},
+    {"CREATE", KeywordId::Create, v4::Op::RET},
+    {"ALLOT", KeywordId::Allot, v4::Op::RET},
+    {"ALIGN-TO", KeywordId::AlignTo, v4::Op::RET},
+    {"RECURSE", KeywordId::Recurse, v4::Op::RET},
+    {"EXIT", KeywordId::Exit, v4::Op::RET},
+
+    // Control flow
+    {"BEGIN", KeywordId::Begin, v4::Op::RET},
+    {"UNTIL", KeywordId::Until, v4::Op::RET},
+    {"WHILE", KeywordId::While, v4::Op::RET},
+    {"REPEAT", KeywordId::Repeat, v4::Op::RET},
+    {"AGAIN", KeywordId::Again, v4::Op::RET},
+    {"DO", KeywordId::Do, v4::Op::RET},
+    {"LOOP", KeywordId::Loop, v4::Op::RET},
+    {"+LOOP", KeywordId::PlusLoop, v4::Op::RET},
+    {"LEAVE", KeywordId::Leave, v4::Op::RET},
+    {"IF", KeywordId::If, v4::Op::RET},
+    {"ELSE", KeywordId::Else, v4::Op::RET},
+    {"THEN", KeywordId::Then, v4::Op::RET},
+
+    // Character I/O
+    {"EMIT", KeywordId::Emit, v4::Op::RET},
+    {"KEY", KeywordId::Key, v4::Op::RET},
+
+    // Local variables with an index operand
+    {"L++", KeywordId::LocalInc, v4::Op::RET},
+    {"L--", KeywordId::LocalDec, v4::Op::RET},
+    {"L@", KeywordId::LocalGet, v4::Op::RET},
+    {"L!", KeywordId::LocalSet, v4::Op::RET},
+    {"L>!", KeywordId::LocalTee, v4::Op::RET},
+
+    // Composite words (expanded to multiple opcodes)
+    {"J", KeywordId::LoopJ, v4::Op::RET},
+    {"K", KeywordId::LoopK, v4::Op::RET},
+    {"ROT", KeywordId::Rot, v4::Op::RET},
+    {"NIP", KeywordId::Nip, v4::Op::RET},
+    {"TUCK", KeywordId::Tuck, v4::Op::RET},
+    {"NEGATE", KeywordId::Negate, v4::Op::RET},
+    {"?DUP", KeywordId::QDup, v4::Op::RET},
+    {"ABS", KeywordId::Abs, v4::Op::RET},
+    {"MIN", KeywordId::Min, v4::Op::RET},
+    {"MAX", KeywordId::Max, v4::Op::RET},
+    {"0=", KeywordId::ZeroEq, v4::Op::RET},
+    {"0<", KeywordId::ZeroLt, v4::Op::RET},
+    {"0>", KeywordId::ZeroGt, v4::Op::RET},
+    {"2DUP", KeywordId::TwoDup, v4::Op::RET},
+    {"2DROP", KeywordId::TwoDrop, v4::Op::RET},
+    {"2SWAP", KeywordId::TwoSwap, v4::Op::RET},
+    {"2OVER", KeywordId::TwoOver, v4::Op::RET},
+    {"+!", KeywordId::PlusStore, v4::Op::RET},
+    {"TRUE", KeywordId::True, v4::Op::RET},
+    {"FALSE", KeywordId::False, v4::Op::RET},
+
     // Stack operations
-    {"DUP", v4::Op::DUP, false},
-    {"DROP", v4::Op::DROP, false},
-    {"SWAP", v4::Op::SWAP, false},
-    {"OVER", v4::Op::OVER, false},
+    {"DUP", KeywordId::Simple, v4::Op::DUP},
+    {"DROP", KeywordId::Simple, v4::Op::DROP},
+    {"SWAP", KeywordId::Simple, v4::Op::SWAP},
+    {"OVER", KeywordId::Simple, v4::Op::OVER},
 
     // Return stack operations
-    {">R", v4::Op::TOR, false},
-    {"R>", v4::Op::FROMR, false},
-    {"R@", v4::Op::RFETCH, false},
-    {"I", v4::Op::RFETCH, false},  // I is alias for R@
+    {">R", KeywordId::Simple, v4::Op::TOR},
+    {"R>", KeywordId::Simple, v4::Op::FROMR},
+    {"R@", KeywordId::Simple, v4::Op::RFETCH},
+    {"I", KeywordId::LoopI, v4::Op::RFETCH},  // I is R@ unless loops use locals
 
     // Arithmetic operators
-    {"+", v4::Op::ADD, true},
-    {"-", v4::Op::SUB, true},
-    {"*", v4::Op::MUL, true},
-    {"/", v4::Op::DIV, true},
-    {"MOD", v4::Op::MOD, false},
-    {"1+", v4::Op::INC, false},
-    {"1-", v4::Op::DEC, false},
-    {"U/", v4::Op::DIVU, false},
-    {"UMOD", v4::Op::MODU, false},
+    {"+", KeywordId::Simple, v4::Op::ADD},
+    {"-", KeywordId::Simple, v4::Op::SUB},
+    {"*", KeywordId::Simple, v4::Op::MUL},
+    {"/", KeywordId::Simple, v4::Op::DIV},
+    {"MOD", KeywordId::Simple, v4::Op::MOD},
+    {"1+", KeywordId::Simple, v4::Op::INC},
+    {"1-", KeywordId::Simple, v4::Op::DEC},
+    {"U/", KeywordId::Simple, v4::Op::DIVU},
+    {"UMOD", KeywordId::Simple, v4::Op::MODU},
 
     // Comparison operators
-    {"=", v4::Op::EQ, true},
-    {"==", v4::Op::EQ, true},
-    {"<>", v4::Op::NE, true},
-    {"!=", v4::Op::NE, true},
-    {"<", v4::Op::LT, true},
-    {"<=", v4::Op::LE, true},
-    {">", v4::Op::GT, true},
-    {">=", v4::Op::GE, true},
-    {"U<", v4::Op::LTU, false},
-    {"U<=", v4::Op::LEU, false},
+    {"=", KeywordId::Simple, v4::Op::EQ},
+    {"==", KeywordId::Simple, v4::Op::EQ},
+    {"<>", KeywordId::Simple, v4::Op::NE},
+    {"!=", KeywordId::Simple, v4::Op::NE},
+    {"<", KeywordId::Simple, v4::Op::LT},
+    {"<=", KeywordId::Simple, v4::Op::LE},
+    {">", KeywordId::Simple, v4::Op::GT},
+    {">=", KeywordId::Simple, v4::Op::GE},
+    {"U<", KeywordId::Simple, v4::Op::LTU},
+    {"U<=", KeywordId::Simple, v4::Op::LEU},
 
     // Bitwise operators
-    {"AND", v4::Op::AND, false},
-    {"OR", v4::Op::OR, false},
-    {"XOR", v4::Op::XOR, false},
-    {"INVERT", v4::Op::INVERT, false},
-    {"LSHIFT", v4::Op::SHL, false},
-    {"RSHIFT", v4::Op::SHR, false},
-    {"ARSHIFT", v4::Op::SAR, false},
+    {"AND", KeywordId::Simple, v4::Op::AND},
+    {"OR", KeywordId::Simple, v4::Op::OR},
+    {"XOR", KeywordId::Simple, v4::Op::XOR},
+    {"INVERT", KeywordId::Simple, v4::Op::INVERT},
+    {"LSHIFT", KeywordId::Simple, v4::Op::SHL},
+    {"RSHIFT", KeywordId::Simple, v4::Op::SHR},
+    {"ARSHIFT", KeywordId::Simple, v4::Op::SAR},
 
     // Memory access
-    {"@", v4::Op::LOAD, true},
-    {"!", v4::Op::STORE, true},
-    {"C@", v4::Op::LOAD8U, false},
-    {"C!", v4::Op::STORE8, false},
-    {"W@", v4::Op::LOAD16U, false},
-    {"W!", v4::Op::STORE16, false},
+    {"@", KeywordId::Simple, v4::Op::LOAD},
+    {"!", KeywordId::Simple, v4::Op::STORE},
+    {"C@", KeywordId::Simple, v4::Op::LOAD8U},
+    {"C!", KeywordId::Simple, v4::Op::STORE8},
+    {"W@", KeywordId::Simple, v4::Op::LOAD16U},
+    {"W!", KeywordId::Simple, v4::Op::STORE16},
 
     // Local variable access (optimized for indices 0 and 1)
-    {"L@0", v4::Op::LGET0, false},
-    {"L@1", v4::Op::LGET1, false},
-    {"L!0", v4::Op::LSET0, false},
-    {"L!1", v4::Op::LSET1, false},
+    {"L@0", KeywordId::Simple, v4::Op::LGET0},
+    {"L@1", KeywordId::Simple, v4::Op::LGET1},
+    {"L!0", KeywordId::Simple, v4::Op::LSET0},
+    {"L!1", KeywordId::Simple, v4::Op::LSET1},
 
     // Task management
-    {"SPAWN", v4::Op::TASK_SPAWN, false},
-    {"TASK-EXIT", v4::Op::TASK_EXIT, false},
-    {"SLEEP", v4::Op::TASK_SLEEP, false},
-    {"MS", v4::Op::TASK_SLEEP, false},  // alias for SLEEP
-    {"YIELD", v4::Op::TASK_YIELD, false},
-    {"PAUSE", v4::Op::TASK_YIELD, false},  // alias for YIELD
-    {"CRITICAL", v4::Op::CRITICAL_ENTER, false},
-    {"UNCRITICAL", v4::Op::CRITICAL_EXIT, false},
-    {"SEND", v4::Op::TASK_SEND, false},
-    {"RECEIVE", v4::Op::TASK_RECEIVE, false},
-    {"RECEIVE-BLOCKING", v4::Op::TASK_RECEIVE_BLOCKING, false},
-    {"ME", v4::Op::TASK_SELF, false},
-    {"TASKS", v4::Op::TASK_COUNT, false},
+    {"SPAWN", KeywordId::Simple, v4::Op::TASK_SPAWN},
+    {"TASK-EXIT", KeywordId::Simple, v4::Op::TASK_EXIT},
+    {"SLEEP", KeywordId::Simple, v4::Op::TASK_SLEEP},
+    {"MS", KeywordId::Simple, v4::Op::TASK_SLEEP},  // alias for SLEEP
+    {"YIELD", KeywordId::Simple, v4::Op::TASK_YIELD},
+    {"PAUSE", KeywordId::Simple, v4::Op::TASK_YIELD},  // alias for YIELD
+    {"CRITICAL", KeywordId::Simple, v4::Op::CRITICAL_ENTER},
+    {"UNCRITICAL", KeywordId::Simple, v4::Op::CRITICAL_EXIT},
+    {"SEND", KeywordId::Simple, v4::Op::TASK_SEND},
+    {"RECEIVE", KeywordId::Simple, v4::Op::TASK_RECEIVE},
+    {"RECEIVE-BLOCKING", KeywordId::Simple, v4::Op::TASK_RECEIVE_BLOCKING},
+    {"ME", KeywordId::Simple, v4::Op::TASK_SELF},
+    {"TASKS", KeywordId::Simple, v4::Op::TASK_COUNT},
 
     // System calls
-    {"SYS", v4::Op::SYS, false},
+    {"SYS", KeywordId::Simple, v4::Op::SYS},
+};
+
+static constexpr size_t KEYWORD_COUNT = sizeof(KEYWORD_TABLE) / sizeof(KEYWORD_TABLE[0]);
+
+// Hash index size (power of two, kept under 50% load so probes stay short)
+static constexpr uint32_t KEYWORD_SLOTS = 256;
+static_assert(KEYWORD_COUNT < KEYWORD_SLOTS / 2, "keyword hash index too small");
+static_assert(KEYWORD_COUNT < 255, "keyword slot encoding uses uint8_t");
+
+static constexpr size_t const_strlen(const char* s)
+{
+  size_t n = 0;
+  while (s[n])
+    n++;
+  return n;
+}
 
-    // Sentinel (end of table)
-    {nullptr, v4::Op::RET, false}};
+struct KeywordIndex
+{
+  uint8_t slots[KEYWORD_SLOTS];  // KEYWORD_TABLE index + 1, 0 = empty
+  uint32_t max_probe;            // Longest probe sequence of any keyword
+  bool has_duplicates;           // Two table entries fold to the same spelling
+};
 
-// Helper: Look up simple opcode in dispatch table
-// Returns true and sets opcode if found, false otherwise
-static bool lookup_simple_opcode(const char* token, v4::Op* opcode)
+static constexpr KeywordIndex build_keyword_index()
 {
-  for (const OpcodeMapping* entry = OPCODE_TABLE; entry->token != nullptr; ++entry)
+  KeywordIndex index{};
+  for (size_t k = 0; k < KEYWORD_COUNT; k++)
   {
-    bool match = entry->case_sensitive ? (strcmp(token, entry->token) == 0)
-                                       : str_eq_ci(token, entry->token);
-    if (match)
+    const char* name = KEYWORD_TABLE[k].name;
+    size_t len = const_strlen(name);
+    uint32_t slot = hash_ci(name, len) & (KEYWORD_SLOTS - 1);
+    uint32_t probe = 0;
+    while (index.slots[slot] != 0)
     {
-      *opcode = entry->opcode;
-      return true;
+      if (name_eq_ci(KEYWORD_TABLE[index.slots[slot] - 1].name, name, len))
+        index.has_duplicates = true;
+      slot = (slot + 1) & (KEYWORD_SLOTS - 1);
+      probe++;
     }
+    index.slots[slot] = static_cast<uint8_t>(k + 1);
+    if (probe > index.max_probe)
+      index.max_probe = probe;
   }
-  return false;
+  return index;
 }
 
-// Helper: Emit J instruction (outer loop index)
-// Emits: R> R> R> DUP >R >R >R
-static FrontErr emit_j_instruction(uint8_t** buf, uint32_t* size, uint32_t* cap)
+static constexpr KeywordIndex KEYWORD_INDEX = build_keyword_index();
+static_assert(!KEYWORD_INDEX.has_duplicates, "duplicate keyword in KEYWORD_TABLE");
+static_assert(KEYWORD_INDEX.max_probe <= 3, "keyword hash has long collision chains");
+
+// Helper: Classify a token
+// Returns the keyword table entry, or nullptr if the token is not a built-in
+// hash is hash_ci(token, len)
+static const KeywordEntry* lookup_keyword(const char* token, size_t len, uint32_t hash)
 {
-  FrontErr err;
+  uint32_t slot = hash & (KEYWORD_SLOTS - 1);
+  for (uint32_t probe = 0; probe <= KEYWORD_INDEX.max_probe; probe++)
+  {
+    uint8_t entry = KEYWORD_INDEX.slots[slot];
+    if (entry == 0)
+      return nullptr;
+    const KeywordEntry* kw = &KEYWORD_TABLE[entry - 1];
+    if (name_eq_ci(kw->name, token, len))
+      return kw;
+    slot = (slot + 1) & (KEYWORD_SLOTS - 1);
+  }
+  return nullptr;
+}
 
-  // R> R> R>: pop current loop (index, limit) and next index
-  for (int i = 0; i < 3; i++)
+static const KeywordEntry* lookup_keyword(const char* token, size_t len)
+{
+  return lookup_keyword(token, len, hash_ci(token, len));
+}
+
+// Helper: Emit the index of the loop levels out from the innermost one (J: 1,
+// K: 2) when loops keep their parameters on the return stack. The inner
+// (limit, index) pairs are popped, the wanted index is copied with R@, and
+// each popped cell is pushed back under it, leaving the return stack as it
+// was:
+//   J: R> R> R@ SWAP >R SWAP >R
+//   K: R> R> R> R> R@ SWAP >R SWAP >R SWAP >R SWAP >R
+static FrontErr emit_outer_loop_index(CodeBuf* buf, int levels)
+{
+  FrontErr err;
+  for (int i = 0; i < 2 * levels; i++)
   {
-    if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::FROMR))) !=
-        FrontErr::OK)
+    if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
       return err;
   }
-
-  // DUP: copy the outer loop index
-  if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::DUP))) !=
-      FrontErr::OK)
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::RFETCH))) != FrontErr::OK)
     return err;
-
-  // >R >R >R: restore return stack
-  for (int i = 0; i < 3; i++)
+  for (int i = 0; i < 2 * levels; i++)
   {
-    if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::TOR))) !=
-        FrontErr::OK)
+    if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK ||
+        (err = append_byte(buf, static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
       return err;
   }
-
   return FrontErr::OK;
 }
 
 // Helper: Emit ROT instruction (rotate three elements)
 // Emits: >R SWAP R> SWAP
-static FrontErr emit_rot_instruction(uint8_t** buf, uint32_t* size, uint32_t* cap)
+static FrontErr emit_rot_instruction(CodeBuf* buf)
 {
   FrontErr err;
 
-  if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::TOR))) !=
-      FrontErr::OK)
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
     return err;
-  if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::SWAP))) !=
-      FrontErr::OK)
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
     return err;
-  if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::FROMR))) !=
-      FrontErr::OK)
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
     return err;
-  if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::SWAP))) !=
-      FrontErr::OK)
-    return err;
-
-  return FrontErr::OK;
-}
-
-// Helper: Emit K instruction (outer outer loop index)
-// Emits: R> R> R> R> R> DUP >R >R >R >R >R
-static FrontErr emit_k_instruction(uint8_t** buf, uint32_t* size, uint32_t* cap)
-{
-  FrontErr err;
-
-  // R> x 5: pop two loops and next index
-  for (int i = 0; i < 5; i++)
-  {
-    if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::FROMR))) !=
-        FrontErr::OK)
-      return err;
-  }
-
-  // DUP: copy the outer outer loop index
-  if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::DUP))) !=
-      FrontErr::OK)
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
     return err;
 
-  // >R x 5: restore return stack
-  for (int i = 0; i < 5; i++)
-  {
-    if ((err = append_byte(buf, size, cap, static_cast<uint8_t>(v4::Op::TOR))) !=
-        FrontErr::OK)
-      return err;
-  }
-
   return FrontErr::OK;
 }
 
@@ -252,115 +396,64 @@ static void write_error(char* err, size_t err_cap, FrontErr code)
   write_error_msg(err, err_cap, front_err_str(code));
 }
 
-// ---------------------------------------------------------------------------
-// Comment handling
-// ---------------------------------------------------------------------------
-
-// Skip whitespace and comments
-// Handles:
-//   - Line comments: \ (backslash) to end of line
-//   - Parenthesized comments: ( ... )
-// Returns:
-//   - OK on success
-//   - UnterminatedComment if ( is not closed
-static FrontErr skip_whitespace_and_comments(const char** p, const char** error_pos)
-{
-  while (true)
-  {
-    // Skip whitespace
-    while (**p && isspace((unsigned char)**p))
-      (*p)++;
-
-    // Check for comments
-    if (**p == '\\')
-    {
-      // Line comment: skip to end of line
-      (*p)++;
-      while (**p && **p != '\n')
-        (*p)++;
-      // Continue to skip more whitespace/comments
-      continue;
-    }
-    else if (**p == '(' && *(*p + 1) && isspace((unsigned char)*(*p + 1)))
-    {
-      // Parenthesized comment: ( must be followed by whitespace to distinguish from
-      // (LOCAL) Skip the opening (
-      (*p)++;
-
-      // Find closing )
-      while (**p && **p != ')')
-        (*p)++;
-
-      if (**p == ')')
-      {
-        (*p)++;  // Skip closing )
-        // Continue to skip more whitespace/comments
-        continue;
-      }
-      else
-      {
-        // Unterminated comment
-        if (error_pos)
-          *error_pos = *p - 1;  // Point to the opening (
-        return FrontErr::UnterminatedComment;
-      }
-    }
-    else
-    {
-      // No more whitespace or comments
-      break;
-    }
-  }
-
-  return FrontErr::OK;
-}
-
 // ---------------------------------------------------------------------------
 // Dynamic bytecode buffer management
 // ---------------------------------------------------------------------------
 
 // Append a single byte to the bytecode buffer
-static FrontErr append_byte(uint8_t** buf, uint32_t* size, uint32_t* cap, uint8_t byte)
+static FrontErr append_byte(CodeBuf* buf, uint8_t byte)
 {
-  if (*size >= *cap)
+  if (buf->size >= buf->cap)
   {
-    uint32_t new_cap = (*cap == 0) ? 64 : (*cap * 2);
-    uint8_t* new_buf = (uint8_t*)realloc(*buf, new_cap);
-    if (!new_buf)
+    uint32_t new_cap = (buf->cap == 0) ? 64 : (buf->cap * 2);
+    uint8_t* new_data = (uint8_t*)buf->arena->grow(buf->data, buf->cap, new_cap);
+    if (!new_data)
       return FrontErr::OutOfMemory;
-    *buf = new_buf;
-    *cap = new_cap;
+    buf->data = new_data;
+    buf->cap = new_cap;
   }
-  (*buf)[(*size)++] = byte;
+  buf->data[buf->size++] = byte;
   return FrontErr::OK;
 }
 
 // Append a 16-bit integer in little-endian format
-static FrontErr append_i16_le(uint8_t** buf, uint32_t* size, uint32_t* cap, int16_t val)
+static FrontErr append_i16_le(CodeBuf* buf, int16_t val)
 {
   FrontErr err;
-  if ((err = append_byte(buf, size, cap, (uint8_t)(val & 0xFF))) != FrontErr::OK)
+  if ((err = append_byte(buf, (uint8_t)(val & 0xFF))) != FrontErr::OK)
     return err;
-  if ((err = append_byte(buf, size, cap, (uint8_t)((val >> 8) & 0xFF))) != FrontErr::OK)
+  if ((err = append_byte(buf, (uint8_t)((val >> 8) & 0xFF))) != FrontErr::OK)
     return err;
   return FrontErr::OK;
 }
 
 // Append a 32-bit integer in little-endian format
-static FrontErr append_i32_le(uint8_t** buf, uint32_t* size, uint32_t* cap, int32_t val)
+static FrontErr append_i32_le(CodeBuf* buf, int32_t val)
 {
   FrontErr err;
-  if ((err = append_byte(buf, size, cap, (uint8_t)(val & 0xFF))) != FrontErr::OK)
+  if ((err = append_byte(buf, (uint8_t)(val & 0xFF))) != FrontErr::OK)
     return err;
-  if ((err = append_byte(buf, size, cap, (uint8_t)((val >> 8) & 0xFF))) != FrontErr::OK)
+  if ((err = append_byte(buf, (uint8_t)((val >> 8) & 0xFF))) != FrontErr::OK)
     return err;
-  if ((err = append_byte(buf, size, cap, (uint8_t)((val >> 16) & 0xFF))) != FrontErr::OK)
+  if ((err = append_byte(buf, (uint8_t)((val >> 16) & 0xFF))) != FrontErr::OK)
     return err;
-  if ((err = append_byte(buf, size, cap, (uint8_t)((val >> 24) & 0xFF))) != FrontErr::OK)
+  if ((err = append_byte(buf, (uint8_t)((val >> 24) & 0xFF))) != FrontErr::OK)
     return err;
   return FrontErr::OK;
 }
 
+// Append len bytes copied from src
+static FrontErr append_bytes(CodeBuf* buf, const uint8_t* src, uint32_t len)
+{
+  FrontErr err;
+  for (uint32_t i = 0; i < len; i++)
+  {
+    if ((err = append_byte(buf, src[i])) != FrontErr::OK)
+      return err;
+  }
+  return FrontErr::OK;
+}
+
 // Backpatch a 16-bit offset at a specific position
 static void backpatch_i16_le(uint8_t* buf, uint32_t pos, int16_t val)
 {
@@ -368,15 +461,75 @@ static void backpatch_i16_le(uint8_t* buf, uint32_t pos, int16_t val)
   buf[pos + 1] = (uint8_t)((val >> 8) & 0xFF);
 }
 
-// Try parsing a token as an integer
-static bool try_parse_int(const char* token, int32_t* out)
+// Helper: Turn each RECURSE site (offset of a CALL to the word itself) that is
+// in tail position into a JMP to the word start. A call is in tail position
+// when the next instruction is RET, possibly reached through unconditional
+// JMPs (e.g. the skip over an ELSE branch). CALL and JMP are both 3 bytes, so
+// no other offset moves.
+static void lower_tail_recursion(uint8_t* code, uint32_t len, const uint32_t* sites,
+                                 int count)
 {
-  char* endptr = nullptr;
-  long val = strtol(token, &endptr, 0);  // base=0 auto-detects hex/oct
-  if (endptr == token || *endptr != '\0')
-    return false;
-  *out = (int32_t)val;
-  return true;
+  for (int i = 0; i < count; i++)
+  {
+    uint32_t site = sites[i];
+    int64_t pc = site + 3;
+    for (int hops = 0; hops < 8 && pc >= 0 && pc + 3 <= len &&
+                       code[pc] == static_cast<uint8_t>(v4::Op::JMP);
+         hops++)
+    {
+      int16_t rel = static_cast<int16_t>(code[pc + 1] | (code[pc + 2] << 8));
+      pc += 3 + rel;
+    }
+    if (pc < 0 || pc >= len || code[pc] != static_cast<uint8_t>(v4::Op::RET))
+      continue;
+    if (site + 3 > 32768)
+      continue;  // Start of the word is out of rel16 range
+
+    code[site] = static_cast<uint8_t>(v4::Op::JMP);
+    int32_t rel = -static_cast<int32_t>(site + 3);
+    backpatch_i16_le(code, site + 1, static_cast<int16_t>(rel));
+  }
+}
+
+// Helper: Whether execution can never reach the end of code: its last
+// instruction is a JMP (from AGAIN or REPEAT) and no branch targets the end (a
+// WHILE or an empty ELSE exit does). Only then can the final RET be left out.
+static bool ends_in_jump(const uint8_t* code, uint32_t len)
+{
+  uint32_t last = len;
+  for (uint32_t pc = 0; pc < len;)
+  {
+    bool is_jump;
+    int operands = op_operand_len(code[pc], &is_jump);
+    if (operands < 0 || pc + 1 + operands > len)
+      return false;
+    if (is_jump)
+    {
+      int16_t rel = static_cast<int16_t>(code[pc + 1] | (code[pc + 2] << 8));
+      if (static_cast<int64_t>(pc) + 3 + rel == len)
+        return false;
+    }
+    last = pc;
+    pc += 1 + static_cast<uint32_t>(operands);
+  }
+  return last < len && code[last] == static_cast<uint8_t>(v4::Op::JMP);
+}
+
+// Emit a literal push. With compact encoding, 0, 1 and -1 use the one-byte
+// LIT0/LIT1/LITN1 forms; everything else (and every value by default) is
+// [LIT] [imm32_le].
+static FrontErr emit_literal(CodeBuf* buf, int32_t val, bool compact)
+{
+  if (compact && (val == 0 || val == 1 || val == -1))
+  {
+    v4::Op op = val == 0 ? v4::Op::LIT0 : (val == 1 ? v4::Op::LIT1 : v4::Op::LITN1);
+    return append_byte(buf, static_cast<uint8_t>(op));
+  }
+
+  FrontErr err;
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::LIT))) != FrontErr::OK)
+    return err;
+  return append_i32_le(buf, val);
 }
 
 // ---------------------------------------------------------------------------
@@ -393,9 +546,10 @@ static bool try_parse_int(const char* token, int32_t* out)
 #define MAX_LEAVE_DEPTH 8
 #endif
 
-// Maximum number of word definitions
+// Maximum number of word definitions per compilation. The dictionary grows on
+// demand; this only bounds it to what a signed 16-bit CALL index can address.
 #ifndef MAX_WORDS
-#define MAX_WORDS 256
+#define MAX_WORDS 32767
 #endif
 
 // Maximum length of word names (including null terminator)
@@ -403,2461 +557,6714 @@ static bool try_parse_int(const char* token, int32_t* out)
 #define MAX_WORD_NAME_LEN 64
 #endif
 
-// Maximum length of tokens (including null terminator)
-#ifndef MAX_TOKEN_LEN
-#define MAX_TOKEN_LEN 256
+// Largest word body (bytes, excluding the trailing RET) copied into callers by
+// V4FRONT_OPT_INLINE when V4FrontCompileOptions::inline_max_size is 0
+#ifndef DEFAULT_INLINE_MAX_SIZE
+#define DEFAULT_INLINE_MAX_SIZE 8
 #endif
 
-// ---------------------------------------------------------------------------
-// Word definition entry (during compilation)
-// ---------------------------------------------------------------------------
-struct WordDefEntry
-{
-  char name[MAX_WORD_NAME_LEN];  // Word name
-  uint8_t* code;                 // Bytecode for this word
-  uint32_t code_len;             // Length of bytecode
-};
-
-// ---------------------------------------------------------------------------
-// Compiler context structures (for stateful compilation)
-// ---------------------------------------------------------------------------
-
-// Word entry in compiler context (maps name to VM word index)
-struct ContextWordEntry
-{
-  char* name;       // Word name (dynamically allocated)
-  int vm_word_idx;  // VM word index
-};
-
-// Compiler context for stateful compilation (opaque to C API users)
-struct V4FrontContext
-{
-  ContextWordEntry* words;  // Array of registered words
-  int word_count;           // Number of registered words
-  int word_capacity;        // Capacity of words array
-};
-
-enum ControlType
-{
-  IF_CONTROL,
-  BEGIN_CONTROL,
-  DO_CONTROL
-};
-
-struct ControlFrame
-{
-  ControlType type;
-  // IF control fields
-  uint32_t jz_patch_addr;   // Position of JZ offset to backpatch (for IF)
-  uint32_t jmp_patch_addr;  // Position of JMP offset to backpatch (for ELSE)
-  bool has_else;            // Whether this IF has an ELSE clause
-  // BEGIN control fields
-  uint32_t begin_addr;        // Position of BEGIN for backward jump (for UNTIL/REPEAT)
-  uint32_t while_patch_addr;  // Position of JZ offset to backpatch (for WHILE)
-  bool has_while;             // Whether this BEGIN has a WHILE clause
-  // DO control fields
-  uint32_t do_addr;  // Position after DO for backward jump (for LOOP/+LOOP)
-  uint32_t leave_patch_addrs[MAX_LEAVE_DEPTH];  // Positions of JMP offsets to backpatch
-                                                // (for LEAVE)
-  int leave_count;  // Number of LEAVE statements in this DO loop
-};
+// Largest counted DO loop (trip count x body bytes) that V4FRONT_OPT_COUNTED_LOOPS
+// unrolls completely
+#ifndef MAX_UNROLL_SIZE
+#define MAX_UNROLL_SIZE 32
+#endif
 
-// ---------------------------------------------------------------------------
-// Data space management (for VARIABLE support)
-// ---------------------------------------------------------------------------
+// Maximum number of known-constant values tracked for folding (older values
+// beyond this depth are simply left in the bytecode)
+#ifndef MAX_FOLD_DEPTH
+#define MAX_FOLD_DEPTH 8
+#endif
 
-// Default data space configuration
-#ifndef DATA_SPACE_BASE
-#define DATA_SPACE_BASE 0x10000  // Default: Start at 64KB
+// Most instructions V4FRONT_OPT_EVAL runs for one call before compiling the
+// CALL instead
+#ifndef MAX_EVAL_STEPS
+#define MAX_EVAL_STEPS 4096
 #endif
 
-#ifndef DATA_SPACE_SIZE
-#define DATA_SPACE_SIZE 0x10000  // Default: 64KB available
+// Instructions a BEGIN loop runs between yields with V4FRONT_OPT_AUTO_YIELD
+// when V4FrontCompileOptions::yield_budget is 0
+#ifndef DEFAULT_YIELD_BUDGET
+#define DEFAULT_YIELD_BUDGET 256
 #endif
 
-// Data space allocator for VARIABLE
-struct DataSpace
+// ---------------------------------------------------------------------------
+// Known-constant values at the end of the current bytecode buffer
+//  - One entry per literal instruction, in stack order (top = last entry).
+//  - start is where the literal's instruction begins, so a fold can cut the
+//    operands off the buffer and emit the result in their place.
+// ---------------------------------------------------------------------------
+struct ConstTail
 {
-  uint32_t base;   // Base address of data space
-  uint32_t here;   // Current allocation pointer (next free address)
-  uint32_t limit;  // End of data space (base + size)
-
-  // Initialize data space
-  void init(uint32_t base_addr, uint32_t size)
+  struct Entry
   {
-    base = base_addr;
-    here = base_addr;
-    limit = base_addr + size;
-  }
+    uint32_t start;
+    int32_t value;
+  };
 
-  // Allocate bytes, returns address (4-byte aligned)
-  FrontErr allot(uint32_t bytes, uint32_t* out_addr)
-  {
-    // Align to 4-byte boundary
-    uint32_t aligned_size = (bytes + 3) & ~3u;
+  Entry entries[MAX_FOLD_DEPTH];
+  int count;
 
-    if (here + aligned_size > limit)
+  void push(uint32_t start, int32_t value)
+  {
+    if (count == MAX_FOLD_DEPTH)
     {
-      return FrontErr::DataSpaceExhausted;
+      memmove(entries, entries + 1, sizeof(Entry) * (MAX_FOLD_DEPTH - 1));
+      count--;
     }
+    entries[count].start = start;
+    entries[count].value = value;
+    count++;
+  }
+};
 
-    *out_addr = here;
-    here += aligned_size;
-    return FrontErr::OK;
+// Evaluate kw applied to the top of consts at compile time. Returns false if kw
+// is not foldable, needs more known operands, or would trap/differ at runtime
+// (division by zero, out-of-range shift counts).
+static bool fold_keyword(const KeywordEntry* kw, const ConstTail* consts, int* arity,
+                         int32_t* out)
+{
+  const int n = consts->count;
+  const int32_t a = n >= 2 ? consts->entries[n - 2].value : 0;
+  const int32_t b = n >= 1 ? consts->entries[n - 1].value : 0;
+  const uint32_t ua = static_cast<uint32_t>(a);
+  const uint32_t ub = static_cast<uint32_t>(b);
+  const int32_t flag_true = -1;
+
+  // Unary words ( b -- r )
+  *arity = 1;
+  switch (kw->id)
+  {
+    case KeywordId::Negate:
+      *out = static_cast<int32_t>(0u - ub);
+      return n >= 1;
+    case KeywordId::Abs:
+      *out = static_cast<int32_t>(b < 0 ? 0u - ub : ub);
+      return n >= 1;
+    case KeywordId::ZeroEq:
+      *out = b == 0 ? flag_true : 0;
+      return n >= 1;
+    case KeywordId::ZeroLt:
+      *out = b < 0 ? flag_true : 0;
+      return n >= 1;
+    case KeywordId::ZeroGt:
+      *out = b > 0 ? flag_true : 0;
+      return n >= 1;
+    case KeywordId::Simple:
+      break;
+    case KeywordId::Min:
+    case KeywordId::Max:
+      *arity = 2;
+      *out = (kw->id == KeywordId::Min) == (a < b) ? a : b;
+      return n >= 2;
+    default:
+      return false;
   }
 
-  // Get current HERE pointer
-  uint32_t get_here() const
+  switch (kw->opcode)
   {
-    return here;
+    case v4::Op::INVERT:
+      *out = static_cast<int32_t>(~ub);
+      return n >= 1;
+    case v4::Op::INC:
+      *out = static_cast<int32_t>(ub + 1u);
+      return n >= 1;
+    case v4::Op::DEC:
+      *out = static_cast<int32_t>(ub - 1u);
+      return n >= 1;
+    default:
+      break;
   }
 
-  // Reset to base (for testing/recompilation)
-  void reset()
+  // Binary words ( a b -- r )
+  *arity = 2;
+  if (n < 2)
+    return false;
+  switch (kw->opcode)
   {
-    here = base;
+    case v4::Op::ADD:
+      *out = static_cast<int32_t>(ua + ub);
+      return true;
+    case v4::Op::SUB:
+      *out = static_cast<int32_t>(ua - ub);
+      return true;
+    case v4::Op::MUL:
+      *out = static_cast<int32_t>(ua * ub);
+      return true;
+    case v4::Op::DIV:
+    case v4::Op::MOD:
+      if (b == 0 || (a == INT32_MIN && b == -1))
+        return false;
+      *out = kw->opcode == v4::Op::DIV ? a / b : a % b;
+      return true;
+    case v4::Op::DIVU:
+    case v4::Op::MODU:
+      if (ub == 0)
+        return false;
+      *out = static_cast<int32_t>(kw->opcode == v4::Op::DIVU ? ua / ub : ua % ub);
+      return true;
+    case v4::Op::AND:
+      *out = a & b;
+      return true;
+    case v4::Op::OR:
+      *out = a | b;
+      return true;
+    case v4::Op::XOR:
+      *out = a ^ b;
+      return true;
+    case v4::Op::SHL:
+    case v4::Op::SHR:
+    case v4::Op::SAR:
+      if (ub > 31)
+        return false;
+      if (kw->opcode == v4::Op::SHL)
+        *out = static_cast<int32_t>(ua << ub);
+      else if (kw->opcode == v4::Op::SHR)
+        *out = static_cast<int32_t>(ua >> ub);
+      else
+        *out = a < 0 ? ~static_cast<int32_t>(~ua >> ub) : static_cast<int32_t>(ua >> ub);
+      return true;
+    case v4::Op::EQ:
+      *out = a == b ? flag_true : 0;
+      return true;
+    case v4::Op::NE:
+      *out = a != b ? flag_true : 0;
+      return true;
+    case v4::Op::LT:
+      *out = a < b ? flag_true : 0;
+      return true;
+    case v4::Op::LE:
+      *out = a <= b ? flag_true : 0;
+      return true;
+    case v4::Op::GT:
+      *out = a > b ? flag_true : 0;
+      return true;
+    case v4::Op::GE:
+      *out = a >= b ? flag_true : 0;
+      return true;
+    case v4::Op::LTU:
+      *out = ua < ub ? flag_true : 0;
+      return true;
+    case v4::Op::LEU:
+      *out = ua <= ub ? flag_true : 0;
+      return true;
+    default:
+      return false;
   }
-};
+}
 
 // ---------------------------------------------------------------------------
-// Main compilation logic
+// Word definition entry (during compilation)
 // ---------------------------------------------------------------------------
+struct WordDefEntry
+{
+  const char* name;     // Word name (interned in the compile's arena)
+  uint8_t* code;        // Bytecode for this word (arena memory)
+  uint32_t code_len;    // Length of bytecode
+  bool is_constant;     // Body is just LIT const_value (CONSTANT / VARIABLE)
+  int32_t const_value;  // Value pushed when is_constant
+  uint64_t fingerprint;      // Word cache: hash of code and value (0: not yet taken)
+  const CachedWord* cached;  // Word cache entry the body was reused from
+  V4FrontStackEffect effect;  // V4FRONT_OPT_STACK_EFFECTS: inferred at ;
+  bool evaluable;             // V4FRONT_OPT_EVAL: calls may run at compile time
+  bool yields;                // V4FRONT_OPT_AUTO_YIELD: contains a yield point
+};
 
-// Helper function to clean up allocated resources during compilation
-static void cleanup_compile_state(uint8_t* bc, uint8_t* word_bc, WordDefEntry* word_dict,
-                                  int word_count)
+// Word dictionary for a single compilation. Storage is taken from the compile's
+// arena on the first definition and grows geometrically.
+struct WordDict
 {
-  free(bc);
-  if (word_bc)
-    free(word_bc);
-  for (int i = 0; i < word_count; i++)
+  WordDefEntry* entries;  // Definitions in order (index == CALL target)
+  int count;              // Number of definitions
+  int capacity;           // Capacity of entries
+  Arena* arena;           // Storage for entries and names
+  WordIndex index;        // Case-folded name -> position in entries
+
+  void init(Arena* a)
   {
-    if (word_dict[i].code)
-      free(word_dict[i].code);
+    entries = nullptr;
+    count = 0;
+    capacity = 0;
+    arena = a;
+    index.init(a);
   }
-}
 
-// Helper function to handle : (colon) - start word definition
-static FrontErr handle_colon_start(const char** p, bool* in_definition,
-                                   char* current_word_name, uint8_t** word_bc,
-                                   uint32_t* word_bc_size, uint32_t* word_bc_cap,
-                                   uint8_t*** current_bc, uint32_t** current_bc_size,
-                                   uint32_t** current_bc_cap, WordDefEntry* word_dict,
-                                   int word_count, const char** error_pos)
-{
-  // Check for nested :
-  if (*in_definition)
+  bool full() const
   {
-    if (error_pos)
-      *error_pos = *p;
-    return FrontErr::NestedColon;
+    return count >= MAX_WORDS;
   }
 
-  // Read next token as word name
-  FrontErr err = skip_whitespace_and_comments(p, error_pos);
-  if (err != FrontErr::OK)
-    return err;
-  if (!**p)
+  // Returns the dictionary index of name, or -1
+  int find(const char* name, size_t len) const
   {
-    if (error_pos)
-      *error_pos = *p;
-    return FrontErr::ColonWithoutName;
+    return index.lookup(name, len, -1);
   }
 
-  const char* name_start = *p;
-  while (**p && !isspace((unsigned char)**p))
-    (*p)++;
-  size_t name_len = *p - name_start;
-
-  if (name_len == 0 || name_len >= MAX_WORD_NAME_LEN)
+  int find(const char* name, size_t len, uint32_t hash) const
   {
-    if (error_pos)
-      *error_pos = name_start;
-    return FrontErr::ColonWithoutName;
+    return index.lookup(name, len, hash, -1);
   }
 
-  memcpy(current_word_name, name_start, name_len);
-  current_word_name[name_len] = '\0';
-
-  // Check for duplicate word names
-  for (int i = 0; i < word_count; i++)
+  // Append a finished word
+  FrontErr add(const char* name, size_t len, uint8_t* code, uint32_t code_len)
   {
-    if (str_eq_ci(word_dict[i].name, current_word_name))
+    if (count >= capacity)
     {
-      if (error_pos)
-        *error_pos = name_start;
-      return FrontErr::DuplicateWord;
+      int new_capacity = (capacity == 0) ? 8 : (capacity * 2);
+      WordDefEntry* grown = (WordDefEntry*)arena->grow(
+          entries, sizeof(WordDefEntry) * capacity, sizeof(WordDefEntry) * new_capacity);
+      if (!grown)
+        return FrontErr::OutOfMemory;
+      entries = grown;
+      capacity = new_capacity;
     }
+
+    const char* interned = arena->intern(name, len);
+    if (!interned || !index.insert(interned, len, count))
+      return FrontErr::OutOfMemory;
+
+    entries[count].name = interned;
+    entries[count].code = code;
+    entries[count].code_len = code_len;
+    entries[count].is_constant = false;
+    entries[count].const_value = 0;
+    entries[count].fingerprint = 0;
+    entries[count].cached = nullptr;
+    entries[count].effect = {0, 0, 0, 0, 0};
+    entries[count].evaluable = false;
+    entries[count].yields = false;
+    count++;
+    return FrontErr::OK;
   }
+};
 
-  // Check dictionary full
-  if (word_count >= MAX_WORDS)
+// Length of word's body if it can be copied into a caller in place of
+// CALL word_idx, or -1. Inlinable bodies are at most max_size bytes (without
+// the trailing RET) and contain no EXIT, RECURSE or locals access; return-stack
+// use must be balanced and, if the body branches, absent (the callee must not
+// see a different return stack than it would after a CALL).
+static int inline_body_len(const WordDefEntry* word, int word_idx, uint32_t max_size)
+{
+  if (word->code_len == 0 ||
+      word->code[word->code_len - 1] != static_cast<uint8_t>(v4::Op::RET))
+    return -1;
+  uint32_t len = word->code_len - 1;
+  if (len > max_size)
+    return -1;
+
+  int rdepth = 0;
+  bool has_jump = false;
+  bool uses_rstack = false;
+  for (uint32_t pc = 0; pc < len;)
   {
-    if (error_pos)
-      *error_pos = name_start;
-    return FrontErr::DictionaryFull;
+    bool is_jump;
+    int operand_len = op_operand_len(word->code[pc], &is_jump);
+    if (operand_len < 0 || pc + 1 + operand_len > len)
+      return -1;
+
+    switch (static_cast<v4::Op>(word->code[pc]))
+    {
+      case v4::Op::RET:  // EXIT
+        return -1;
+      case v4::Op::CALL:  // RECURSE
+        if ((word->code[pc + 1] | (word->code[pc + 2] << 8)) == word_idx)
+          return -1;
+        break;
+      case v4::Op::LGET:
+      case v4::Op::LSET:
+      case v4::Op::LTEE:
+      case v4::Op::LGET0:
+      case v4::Op::LGET1:
+      case v4::Op::LSET0:
+      case v4::Op::LSET1:
+      case v4::Op::LINC:
+      case v4::Op::LDEC:
+        return -1;
+      case v4::Op::TOR:
+        rdepth++;
+        uses_rstack = true;
+        break;
+      case v4::Op::FROMR:
+        if (--rdepth < 0)
+          return -1;
+        uses_rstack = true;
+        break;
+      case v4::Op::RFETCH:
+        if (rdepth == 0)
+          return -1;
+        uses_rstack = true;
+        break;
+      default:
+        break;
+    }
+    has_jump |= is_jump;
+    pc += 1 + operand_len;
   }
 
-  // Enter definition mode
-  *in_definition = true;
-  *word_bc = nullptr;
-  *word_bc_size = 0;
-  *word_bc_cap = 0;
+  if (rdepth != 0 || (has_jump && uses_rstack))
+    return -1;
+  return static_cast<int>(len);
+}
 
-  // Switch to word bytecode buffer
-  *current_bc = word_bc;
-  *current_bc_size = word_bc_size;
-  *current_bc_cap = word_bc_cap;
+// CALL operands from kImportBase up are placeholders for words outside the
+// compilation (batch imports, or context words under V4FRONT_OPT_RELOCS);
+// local word indices stay below it
+static const int kImportBase = 0x4000;
 
-  return FrontErr::OK;
+// Helper: Step *pc past the instruction at code[*pc]; returns false if it
+// cannot be decoded (unknown opcode or truncated operand)
+static bool step_insn(const uint8_t* code, uint32_t len, uint32_t* pc)
+{
+  int operand_len = op_operand_len(code[*pc]);
+  if (operand_len < 0 || *pc + 1 + operand_len > len)
+    return false;
+  *pc += 1 + operand_len;
+  return true;
 }
 
-// Helper function to handle ; (semicolon) - end word definition
-static FrontErr handle_semicolon_end(bool* in_definition, char* current_word_name,
-                                     uint8_t** word_bc, uint32_t* word_bc_size,
-                                     uint32_t* word_bc_cap, uint8_t*** current_bc,
-                                     uint32_t** current_bc_size,
-                                     uint32_t** current_bc_cap, uint8_t** bc_main,
-                                     uint32_t* bc_main_size, uint32_t* bc_main_cap,
-                                     WordDefEntry* word_dict, int* word_count,
-                                     const char** error_pos, const char* token_pos)
+// Helper: Mark the local words code[0, len) calls and push newly marked ones
+// onto work. Returns false if the code cannot be decoded.
+static bool mark_calls(const uint8_t* code, uint32_t len, int word_count, int* live,
+                       int* work, int* top)
 {
-  // Check if in definition mode
-  if (!*in_definition)
+  for (uint32_t pc = 0; pc < len;)
   {
-    if (error_pos)
-      *error_pos = token_pos;
-    return FrontErr::SemicolonWithoutColon;
+    uint32_t at = pc;
+    if (!step_insn(code, len, &pc))
+      return false;
+    if (code[at] != static_cast<uint8_t>(v4::Op::CALL))
+      continue;
+    int idx = code[at + 1] | (code[at + 2] << 8);
+    if (idx < word_count && !live[idx])
+    {
+      live[idx] = 1;
+      work[(*top)++] = idx;
+    }
   }
+  return true;
+}
 
-  // Append RET to word bytecode
-  FrontErr err;
-  if ((err = append_byte(*current_bc, *current_bc_size, *current_bc_cap,
-                         static_cast<uint8_t>(v4::Op::RET))) != FrontErr::OK)
-    return err;
+// Helper: Rewrite the local CALL operands in code[0, len) through remap
+static void renumber_calls(uint8_t* code, uint32_t len, int word_count, const int* remap)
+{
+  for (uint32_t pc = 0; pc < len;)
+  {
+    uint32_t at = pc;
+    if (!step_insn(code, len, &pc))
+      return;
+    if (code[at] != static_cast<uint8_t>(v4::Op::CALL))
+      continue;
+    int idx = code[at + 1] | (code[at + 2] << 8);
+    if (idx < word_count)
+      backpatch_i16_le(code, at + 1, static_cast<int16_t>(remap[idx]));
+  }
+}
 
-  // Add word to dictionary
-  size_t name_len = strlen(current_word_name);
-  if (name_len >= MAX_WORD_NAME_LEN)
-    name_len = MAX_WORD_NAME_LEN - 1;
-  memcpy(word_dict[*word_count].name, current_word_name, name_len);
-  word_dict[*word_count].name[name_len] = '\0';
-  word_dict[*word_count].code = *word_bc;
-  word_dict[*word_count].code_len = *word_bc_size;
-  (*word_count)++;
+// Drop the words main code cannot reach through CALL and compact the indices
+// of the rest (CALL operands are renumbered to match). The dictionary is left
+// unchanged if any reachable unit cannot be decoded. If words were dropped and
+// remap_out is not NULL, it receives the new index of every old word (-1 if
+// dropped; arena memory).
+static FrontErr strip_unused_words(Arena* arena, CodeBuf* main_bc, WordDict* dict,
+                                   const int** remap_out = nullptr)
+{
+  const int n = dict->count;
+  if (n == 0)
+    return FrontErr::OK;
 
-  // Exit definition mode and switch back to main bytecode buffer
-  *in_definition = false;
-  current_word_name[0] = '\0';
-  *word_bc = nullptr;  // Don't free - it's now owned by word_dict
-  *word_bc_size = 0;
-  *word_bc_cap = 0;
+  int* live = static_cast<int*>(arena->alloc(sizeof(int) * n));
+  int* work = static_cast<int*>(arena->alloc(sizeof(int) * n));
+  if (!live || !work)
+    return FrontErr::OutOfMemory;
+  memset(live, 0, sizeof(int) * n);
 
-  // Switch back to main bytecode buffer
-  *current_bc = bc_main;
-  *current_bc_size = bc_main_size;
-  *current_bc_cap = bc_main_cap;
+  // Call graph walk from main (each word is pushed at most once)
+  int top = 0;
+  if (!mark_calls(main_bc->data, main_bc->size, n, live, work, &top))
+    return FrontErr::OK;
+  while (top > 0)
+  {
+    const WordDefEntry* word = &dict->entries[work[--top]];
+    if (!mark_calls(word->code, word->code_len, n, live, work, &top))
+      return FrontErr::OK;
+  }
+
+  // New index of every live word (reuse work as the remap table)
+  int* remap = work;
+  int kept = 0;
+  for (int i = 0; i < n; i++)
+    remap[i] = live[i] ? kept++ : -1;
+  if (kept == n)
+    return FrontErr::OK;
+
+  renumber_calls(main_bc->data, main_bc->size, n, remap);
+  for (int i = 0; i < n; i++)
+  {
+    if (!live[i])
+      continue;
+    renumber_calls(dict->entries[i].code, dict->entries[i].code_len, n, remap);
+    dict->entries[remap[i]] = dict->entries[i];
+  }
+  dict->count = kept;
+  if (remap_out)
+    *remap_out = remap;
 
+  // Rebuild the name index for the compacted entries
+  dict->index.clear();
+  for (int i = 0; i < kept; i++)
+  {
+    const char* name = dict->entries[i].name;
+    if (!dict->index.insert(name, strlen(name), i))
+      return FrontErr::OutOfMemory;
+  }
   return FrontErr::OK;
 }
 
-static FrontErr compile_internal(const char* source, V4FrontBuf* out_buf,
-                                 V4FrontContext* ctx, V4FrontError* error_out,
-                                 const char** error_pos)
+// Helper: Whether code[0, len) decodes
+static bool decodes(const uint8_t* code, uint32_t len)
 {
-  assert(out_buf);
+  for (uint32_t pc = 0; pc < len;)
+  {
+    if (!step_insn(code, len, &pc))
+      return false;
+  }
+  return true;
+}
 
-  // Silence unused parameter warning (error_out is used by caller to fill error info)
-  (void)error_out;
+// V4FRONT_OPT_HOT_LAYOUT: order the words by descending profile count (words
+// the profile does not name count 0; ties keep definition order) and renumber
+// CALL operands to match. The dictionary is left unchanged if any unit cannot
+// be decoded. remap_out as for strip_unused_words.
+static FrontErr layout_hot_words(Arena* arena, CodeBuf* main_bc, WordDict* dict,
+                                 const ProfileIndex* profile,
+                                 const int** remap_out = nullptr)
+{
+  const int n = dict->count;
+  if (n < 2)
+    return FrontErr::OK;
+  if (!decodes(main_bc->data, main_bc->size))
+    return FrontErr::OK;
+  for (int i = 0; i < n; i++)
+  {
+    if (!decodes(dict->entries[i].code, dict->entries[i].code_len))
+      return FrontErr::OK;
+  }
 
-  // Initialize output buffer
-  out_buf->data = nullptr;
-  out_buf->size = 0;
-  out_buf->words = nullptr;
-  out_buf->word_count = 0;
+  uint64_t* counts = static_cast<uint64_t*>(arena->alloc(sizeof(uint64_t) * n));
+  int* order = static_cast<int*>(arena->alloc(sizeof(int) * n));
+  int* remap = static_cast<int*>(arena->alloc(sizeof(int) * n));
+  WordDefEntry* moved =
+      static_cast<WordDefEntry*>(arena->alloc(sizeof(WordDefEntry) * n));
+  if (!counts || !order || !remap || !moved)
+    return FrontErr::OutOfMemory;
+  for (int i = 0; i < n; i++)
+  {
+    const char* name = dict->entries[i].name;
+    if (!profile->find(name, strlen(name), &counts[i]))
+      counts[i] = 0;
+    order[i] = i;
+  }
+  std::sort(order, order + n,
+            [&](int a, int b)
+            { return counts[a] != counts[b] ? counts[a] > counts[b] : a < b; });
+  bool changed = false;
+  for (int k = 0; k < n; k++)
+  {
+    remap[order[k]] = k;
+    changed |= order[k] != k;
+  }
+  if (!changed)
+    return FrontErr::OK;
 
-  // Allocate dynamic bytecode buffer
-  uint8_t* bc = nullptr;
-  uint32_t bc_size = 0;
-  uint32_t bc_cap = 0;
-  FrontErr err = FrontErr::OK;
+  renumber_calls(main_bc->data, main_bc->size, n, remap);
+  for (int i = 0; i < n; i++)
+  {
+    renumber_calls(dict->entries[i].code, dict->entries[i].code_len, n, remap);
+    moved[remap[i]] = dict->entries[i];
+  }
+  memcpy(dict->entries, moved, sizeof(WordDefEntry) * n);
+  if (remap_out)
+    *remap_out = remap;
+
+  dict->index.clear();
+  for (int i = 0; i < n; i++)
+  {
+    const char* name = dict->entries[i].name;
+    if (!dict->index.insert(name, strlen(name), i))
+      return FrontErr::OutOfMemory;
+  }
+  return FrontErr::OK;
+}
 
-  // Control flow stack for IF/THEN/ELSE
-  ControlFrame control_stack[MAX_CONTROL_DEPTH];
-  int control_depth = 0;
+// ---------------------------------------------------------------------------
+// Compiler context structures (for stateful compilation)
+// ---------------------------------------------------------------------------
 
-  // Word dictionary (during compilation)
-  WordDefEntry word_dict[MAX_WORDS];
-  int word_count = 0;
+// Word entry in compiler context (maps name to VM word index)
+// Default data space configuration (v4front_context_set_data_space changes it
+// per context at runtime)
+#ifndef DATA_SPACE_BASE
+#define DATA_SPACE_BASE 0x10000  // Default: Start at 64KB
+#endif
 
-  // Initialize code pointers to nullptr for safe cleanup
-  for (int i = 0; i < MAX_WORDS; i++)
-    word_dict[i].code = nullptr;
+#ifndef DATA_SPACE_SIZE
+#define DATA_SPACE_SIZE 0x10000  // Default: 64KB available
+#endif
 
-  // Compilation mode state
-  bool in_definition = false;                       // Are we inside a : ... ; definition?
-  char current_word_name[MAX_WORD_NAME_LEN] = {0};  // Name of word being defined
-  uint8_t* word_bc = nullptr;                       // Bytecode buffer for current word
-  uint32_t word_bc_size = 0;                        // Size of current word bytecode
-  uint32_t word_bc_cap = 0;                         // Capacity of current word bytecode
-
-  // Data space for VARIABLE support
-  DataSpace data_space;
-  data_space.init(DATA_SPACE_BASE, DATA_SPACE_SIZE);
-
-  // Pointers to current bytecode buffer (updated when switching modes)
-  uint8_t** current_bc = &bc;
-  uint32_t* current_bc_size = &bc_size;
-  uint32_t* current_bc_cap = &bc_cap;
-
-// Helper macro for cleanup on error
-#define CLEANUP_AND_RETURN(error_code)                         \
-  do                                                           \
-  {                                                            \
-    cleanup_compile_state(bc, word_bc, word_dict, word_count); \
-    return (error_code);                                       \
-  } while (0)
+// Data space allocator for VARIABLE, CREATE, ALLOT and ALIGN-TO. A context
+// keeps one across compilations, so every compilation through it continues
+// where the last one stopped.
+struct DataSpace
+{
+  uint32_t base;   // Base address of data space
+  uint32_t here;   // Current allocation pointer (next free address)
+  uint32_t limit;  // End of data space (base + size)
 
-  // Handle empty input
-  if (!source || !*source)
+  // Initialize data space
+  void init(uint32_t base_addr, uint32_t size)
   {
-    // Empty input: just emit RET
-    if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                           static_cast<uint8_t>(v4::Op::RET))) != FrontErr::OK)
-      CLEANUP_AND_RETURN(err);
-    out_buf->data = bc;
-    out_buf->size = bc_size;
-    return FrontErr::OK;
+    base = base_addr;
+    here = base_addr;
+    limit = base_addr + size;
   }
 
-  // Tokenization and code generation
-  const char* p = source;
-  char token[MAX_TOKEN_LEN];
-
-  while (*p)
+  // Allocate bytes, returns address (4-byte aligned)
+  FrontErr allot(uint32_t bytes, uint32_t* out_addr)
   {
-    // Skip whitespace and comments
-    if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-      CLEANUP_AND_RETURN(err);
-    if (!*p)
-      break;
+    // Align to 4-byte boundary (in 64 bits: sizes near 4 GiB must not wrap)
+    uint64_t aligned_size = (static_cast<uint64_t>(bytes) + 3) & ~uint64_t(3);
 
-    // Extract token
-    const char* token_start = p;
-    while (*p && !isspace((unsigned char)*p))
-      p++;
-    size_t token_len = p - token_start;
-    if (token_len >= sizeof(token))
-      token_len = sizeof(token) - 1;
-    memcpy(token, token_start, token_len);
-    token[token_len] = '\0';
-
-    // Check for word definition keywords first
-    if (str_eq_ci(token, ":"))
+    if (aligned_size > limit - here)
     {
-      // : (colon) - start word definition
-      if ((err = handle_colon_start(&p, &in_definition, current_word_name, &word_bc,
-                                    &word_bc_size, &word_bc_cap, &current_bc,
-                                    &current_bc_size, &current_bc_cap, word_dict,
-                                    word_count, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
-    }
-    else if (str_eq_ci(token, ";"))
-    {
-      // ; (semicolon) - end word definition
-      if ((err = handle_semicolon_end(
-               &in_definition, current_word_name, &word_bc, &word_bc_size, &word_bc_cap,
-               &current_bc, &current_bc_size, &current_bc_cap, &bc, &bc_size, &bc_cap,
-               word_dict, &word_count, error_pos, token_start)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      return FrontErr::DataSpaceExhausted;
     }
 
-    // Check for control flow keywords
-    if (str_eq_ci(token, "BEGIN"))
-    {
-      // BEGIN: mark the current position for backward jump
-      if (control_depth >= MAX_CONTROL_DEPTH)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ControlDepthExceeded);
-      }
-
-      // Push control frame with BEGIN position
-      control_stack[control_depth].type = BEGIN_CONTROL;
-      control_stack[control_depth].begin_addr = *current_bc_size;
-      control_stack[control_depth].has_while = false;
-      control_depth++;
-      continue;
-    }
-    else if (str_eq_ci(token, "DO"))
-    {
-      // DO: ( limit index -- R: -- limit index )
-      // Emit: SWAP >R >R
-      if (control_depth >= MAX_CONTROL_DEPTH)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ControlDepthExceeded);
-      }
+    *out_addr = here;
+    here += static_cast<uint32_t>(aligned_size);
+    return FrontErr::OK;
+  }
 
-      // SWAP: swap limit and index
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Pad here to a multiple of align (a power of two) in absolute addresses
+  FrontErr align_to(uint32_t align)
+  {
+    uint32_t pad = (0u - here) & (align - 1);
+    if (pad > limit - here)
+      return FrontErr::DataSpaceExhausted;
+    here += pad;
+    return FrontErr::OK;
+  }
 
-      // >R: push limit to return stack
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Get current HERE pointer
+  uint32_t get_here() const
+  {
+    return here;
+  }
 
-      // >R: push index to return stack
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Reset to base (for testing/recompilation)
+  void reset()
+  {
+    here = base;
+  }
+};
 
-      // Save loop start position
-      control_stack[control_depth].type = DO_CONTROL;
-      control_stack[control_depth].do_addr = *current_bc_size;
-      control_stack[control_depth].leave_count = 0;
-      control_depth++;
-      continue;
-    }
-    else if (str_eq_ci(token, "UNTIL"))
-    {
-      // UNTIL: emit JZ with backward offset to BEGIN
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::UntilWithoutBegin);
-      }
+struct ContextWordEntry
+{
+  const char* name;  // Word name (interned in ContextWords::names)
+  int vm_word_idx;   // VM word index
+};
 
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != BEGIN_CONTROL)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::UntilWithoutBegin);
-      }
-      if (frame->has_while)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::UntilAfterWhile);
-      }
+// Registered words of a context. Shared by a context and its snapshots, and
+// never modified while shared (refs > 1): writers copy it first.
+struct ContextWords
+{
+  std::atomic<int> refs;    // Contexts and snapshots holding this version
+  ContextWordEntry* words;  // Array of registered words (registration order)
+  int word_count;           // Number of registered words
+  int word_capacity;        // Capacity of words array
+  Arena names;              // Storage for all word names
+  WordIndex index;          // Case-folded name -> position in words
+};
 
-      // Emit JZ opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Compiler context for stateful compilation (opaque to C API users)
+struct V4FrontContext
+{
+  ContextWords* words;  // Current version (read by compilation)
+  bool read_only;       // Snapshot: registration and reset are refused
+  WordCache* cache;     // Compiled word bodies (nullptr: disabled; never in snapshots)
+  LexCache* lex;        // Tokens of source lines (nullptr: disabled; never in snapshots)
+  DataSpace data;       // Continued by every compilation (snapshots: a copy, not
+                        // advanced)
+};
 
-      // Calculate backward offset: target - (current + 2)
-      uint32_t jz_next_ip = *current_bc_size + 2;
-      int16_t offset = (int16_t)(frame->begin_addr - jz_next_ip);
+enum ControlType
+{
+  IF_CONTROL,
+  BEGIN_CONTROL,
+  DO_CONTROL
+};
 
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, offset)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+struct ControlFrame
+{
+  ControlType type;
+  // IF control fields
+  uint32_t jz_patch_addr;   // Position of JZ offset to backpatch (for IF)
+  uint32_t jmp_patch_addr;  // Position of JMP offset to backpatch (for ELSE)
+  bool has_else;            // Whether this IF has an ELSE clause
+  // BEGIN control fields
+  uint32_t begin_addr;        // Position of BEGIN for backward jump (for UNTIL/REPEAT)
+  uint32_t while_patch_addr;  // Position of JZ offset to backpatch (for WHILE)
+  bool has_while;             // Whether this BEGIN has a WHILE clause
+  // DO control fields
+  uint32_t do_addr;  // Position after DO for backward jump (for LOOP/+LOOP)
+  uint32_t leave_patch_addrs[MAX_LEAVE_DEPTH];  // Positions of JMP offsets to backpatch
+                                                // (for LEAVE)
+  int leave_count;  // Number of LEAVE statements in this DO loop
+  int loop_slot;    // Local slot holding the index (limit is loop_slot + 1), or -1
+                    // when the parameters live on the return stack
+  // Counted DO loop fields (literal bounds, single down-counter on the return stack)
+  bool counted;           // Loop uses the counted lowering
+  bool unrollable;        // Body may be copied (no I, no RECURSE)
+  int32_t limit;          // Literal limit (I == limit - counter)
+  uint32_t trip_count;    // Iterations
+  uint32_t counted_addr;  // Start of the counter setup (LIT n >R)
+};
 
-      // Pop control frame
-      control_depth--;
+// Helper: The level-th enclosing DO loop (0 is the innermost), or nullptr
+static const ControlFrame* enclosing_loop(const ControlFrame* stack, int depth,
+                                          int level)
+{
+  for (int i = depth - 1; i >= 0; i--)
+  {
+    if (stack[i].type != DO_CONTROL)
       continue;
-    }
-    else if (str_eq_ci(token, "WHILE"))
-    {
-      // WHILE: emit JZ with placeholder offset (forward jump to after REPEAT)
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::WhileWithoutBegin);
-      }
+    if (level-- == 0)
+      return &stack[i];
+  }
+  return nullptr;
+}
 
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != BEGIN_CONTROL)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::WhileWithoutBegin);
-      }
-      if (frame->has_while)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::DuplicateWhile);
-      }
+// Helper: Local slot of the index of the level-th enclosing DO loop, or -1 if
+// there is no such loop or it uses the return stack
+static int enclosing_loop_slot(const ControlFrame* stack, int depth, int level)
+{
+  const ControlFrame* loop = enclosing_loop(stack, depth, level);
+  return loop ? loop->loop_slot : -1;
+}
 
-      // Emit JZ opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Emit a local-variable instruction with its 8-bit index
+static FrontErr emit_local_op(CodeBuf* buf, v4::Op opcode, int idx)
+{
+  FrontErr err;
+  if ((err = append_byte(buf, static_cast<uint8_t>(opcode))) != FrontErr::OK)
+    return err;
+  return append_byte(buf, static_cast<uint8_t>(idx));
+}
 
-      // Save position for backpatching and emit placeholder
-      uint32_t patch_pos = *current_bc_size;
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Emit LOOP for a counted loop. Tiny bodies are copied trip_count
+// times in place of the counter setup; otherwise the counter counts down:
+//   R> 1- DUP >R JNZ [do_addr] R> DROP
+static FrontErr emit_counted_loop_end(CodeBuf* buf, const ControlFrame* frame)
+{
+  FrontErr err;
+  uint32_t body_len = buf->size - frame->do_addr;
+  uint64_t unrolled = static_cast<uint64_t>(body_len ? body_len : 1) * frame->trip_count;
 
-      // Update control frame
-      frame->while_patch_addr = patch_pos;
-      frame->has_while = true;
-      continue;
-    }
-    else if (str_eq_ci(token, "REPEAT"))
+  if (frame->unrollable && unrolled <= MAX_UNROLL_SIZE)
+  {
+    // Jumps inside the body are relative and stay within it, so the copies
+    // need no fixups
+    memmove(buf->data + frame->counted_addr, buf->data + frame->do_addr, body_len);
+    buf->size = frame->counted_addr + body_len;
+    for (uint32_t i = 1; i < frame->trip_count; i++)
     {
-      // REPEAT: emit JMP to BEGIN, backpatch WHILE's JZ
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::RepeatWithoutBegin);
-      }
-
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != BEGIN_CONTROL)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::RepeatWithoutBegin);
-      }
-      if (!frame->has_while)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::RepeatWithoutWhile);
-      }
+      // Arena memory is never reused, so the source stays valid if buf grows
+      const uint8_t* body = buf->data + frame->counted_addr;
+      if ((err = append_bytes(buf, body, body_len)) != FrontErr::OK)
+        return err;
+    }
+    return FrontErr::OK;
+  }
 
-      // Emit JMP opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      // Calculate backward offset to BEGIN
-      uint32_t jmp_next_ip = *current_bc_size + 2;
-      int16_t jmp_offset = (int16_t)(frame->begin_addr - jmp_next_ip);
-
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap,
-                               jmp_offset)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      // Backpatch WHILE's JZ to jump to current position
-      int16_t jz_offset = (int16_t)(*current_bc_size - (frame->while_patch_addr + 2));
-      backpatch_i16_le(*current_bc, frame->while_patch_addr, jz_offset);
-
-      // Pop control frame
-      control_depth--;
-      continue;
-    }
-    else if (str_eq_ci(token, "AGAIN"))
-    {
-      // AGAIN: emit JMP with backward offset to BEGIN (infinite loop)
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::AgainWithoutBegin);
-      }
-
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != BEGIN_CONTROL)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::AgainWithoutBegin);
-      }
-      if (frame->has_while)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::AgainAfterWhile);
-      }
-
-      // Emit JMP opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      // Calculate backward offset: target - (current + 2)
-      uint32_t jmp_next_ip = *current_bc_size + 2;
-      int16_t offset = (int16_t)(frame->begin_addr - jmp_next_ip);
-
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, offset)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      // Pop control frame
-      control_depth--;
-      continue;
-    }
-    else if (str_eq_ci(token, "LEAVE"))
-    {
-      // LEAVE: exit the current DO loop early
-      // Emit: R> R> DROP DROP JMP [forward]
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::LeaveWithoutDo);
-      }
-
-      // Find the innermost DO control frame
-      int do_frame_idx = -1;
-      for (int i = control_depth - 1; i >= 0; i--)
-      {
-        if (control_stack[i].type == DO_CONTROL)
-        {
-          do_frame_idx = i;
-          break;
-        }
-      }
+  const v4::Op step[] = {v4::Op::FROMR, v4::Op::DEC, v4::Op::DUP, v4::Op::TOR};
+  for (v4::Op opcode : step)
+  {
+    if ((err = append_byte(buf, static_cast<uint8_t>(opcode))) != FrontErr::OK)
+      return err;
+  }
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::JNZ))) != FrontErr::OK)
+    return err;
+  int16_t offset = (int16_t)(frame->do_addr - (buf->size + 2));
+  if ((err = append_i16_le(buf, offset)) != FrontErr::OK)
+    return err;
 
-      if (do_frame_idx < 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::LeaveWithoutDo);
-      }
+  // R> DROP: discard the exhausted counter
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
+    return err;
+  return append_byte(buf, static_cast<uint8_t>(v4::Op::DROP));
+}
 
-      ControlFrame* frame = &control_stack[do_frame_idx];
+// Helper: Emit LOOP (plus == false) or +LOOP for a loop whose parameters live
+// in locals and backpatch its LEAVEs. Nothing needs dropping at the exit.
+//   LOOP:  L++ i       L@ i L@ limit < JNZ [do_addr]
+//   +LOOP: L@ i + L>! i     L@ limit < JNZ [do_addr]
+static FrontErr emit_local_loop_end(CodeBuf* buf, const ControlFrame* frame, bool plus)
+{
+  FrontErr err;
+  const int idx = frame->loop_slot;
 
-      // Check if we have space for another LEAVE
-      if (frame->leave_count >= MAX_LEAVE_DEPTH)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::LeaveDepthExceeded);
-      }
+  if (plus)
+  {
+    if ((err = emit_local_op(buf, v4::Op::LGET, idx)) != FrontErr::OK)
+      return err;
+    if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::ADD))) != FrontErr::OK)
+      return err;
+    if ((err = emit_local_op(buf, v4::Op::LTEE, idx)) != FrontErr::OK)
+      return err;
+  }
+  else
+  {
+    if ((err = emit_local_op(buf, v4::Op::LINC, idx)) != FrontErr::OK)
+      return err;
+    if ((err = emit_local_op(buf, v4::Op::LGET, idx)) != FrontErr::OK)
+      return err;
+  }
+  if ((err = emit_local_op(buf, v4::Op::LGET, idx + 1)) != FrontErr::OK)
+    return err;
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::LT))) != FrontErr::OK)
+    return err;
 
-      // R>: pop index from return stack
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // JNZ: loop back while index < limit
+  if ((err = append_byte(buf, static_cast<uint8_t>(v4::Op::JNZ))) != FrontErr::OK)
+    return err;
+  int16_t offset = (int16_t)(frame->do_addr - (buf->size + 2));
+  if ((err = append_i16_le(buf, offset)) != FrontErr::OK)
+    return err;
 
-      // R>: pop limit from return stack
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  for (int i = 0; i < frame->leave_count; i++)
+  {
+    int16_t leave_offset = (int16_t)(buf->size - (frame->leave_patch_addrs[i] + 2));
+    backpatch_i16_le(buf->data, frame->leave_patch_addrs[i], leave_offset);
+  }
+  return FrontErr::OK;
+}
 
-      // DROP: discard index
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// ---------------------------------------------------------------------------
+// Data space management (for VARIABLE support)
+// ---------------------------------------------------------------------------
 
-      // DROP: discard limit
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// ---------------------------------------------------------------------------
+// Main compilation logic
+// ---------------------------------------------------------------------------
 
-      // JMP: jump to loop exit (to be backpatched)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper function to make room for one more control frame (allocated lazily,
+// bounded by MAX_CONTROL_DEPTH which the caller checks)
+static FrontErr reserve_control_frame(Arena* arena, ControlFrame** stack, int* cap,
+                                      int depth)
+{
+  if (depth < *cap)
+    return FrontErr::OK;
+  int new_cap = (*cap == 0) ? 4 : (*cap * 2);
+  if (new_cap > MAX_CONTROL_DEPTH)
+    new_cap = MAX_CONTROL_DEPTH;
+  ControlFrame* grown = (ControlFrame*)arena->grow(*stack, sizeof(ControlFrame) * *cap,
+                                                   sizeof(ControlFrame) * new_cap);
+  if (!grown)
+    return FrontErr::OutOfMemory;
+  *stack = grown;
+  *cap = new_cap;
+  return FrontErr::OK;
+}
 
-      // Save patch position and emit placeholder
-      uint32_t patch_pos = *current_bc_size;
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// ---------------------------------------------------------------------------
+// Relocation table (V4FRONT_OPT_RELOCS)
+// ---------------------------------------------------------------------------
+//
+// With the flag, a CALL of a context word compiles to the placeholder
+// kImportBase + j (j: position of the word in the context) instead of its VM
+// index, so local and external calls stay apart through every pass. Once the
+// code is final, one walk per unit lists the CALL sites and turns the
+// placeholders back into VM indices.
+
+// CALL sites of a compilation, in output order
+struct RelocTable
+{
+  V4FrontReloc* items;
+  uint32_t count;
+  uint32_t cap;
+};
 
-      // Record this LEAVE for backpatching
-      frame->leave_patch_addrs[frame->leave_count] = patch_pos;
-      frame->leave_count++;
+// Helper: Append one site to table (storage from arena)
+static FrontErr push_reloc(Arena* arena, RelocTable* table, const V4FrontReloc& reloc)
+{
+  if (table->count == table->cap)
+  {
+    uint32_t new_cap = table->cap ? table->cap * 2 : 16;
+    V4FrontReloc* grown = static_cast<V4FrontReloc*>(
+        arena->grow(table->items, sizeof(V4FrontReloc) * table->cap,
+                    sizeof(V4FrontReloc) * new_cap));
+    if (!grown)
+      return FrontErr::OutOfMemory;
+    table->items = grown;
+    table->cap = new_cap;
+  }
+  table->items[table->count++] = reloc;
+  return FrontErr::OK;
+}
 
-      continue;
+// Helper: Length of the instruction at code[pc] (0 if it cannot be decoded),
+// with fused opcodes looked up in table. The offsets of its CALL operands
+// from the opcode go to operands (a fused instruction has at most two).
+static uint32_t call_operands(const uint8_t* code, uint32_t len, uint32_t pc,
+                              const V4FrontSuperinstruction* table, uint32_t table_count,
+                              uint32_t* operands, uint32_t* operand_count)
+{
+  const uint8_t call = static_cast<uint8_t>(v4::Op::CALL);
+  const uint8_t opcode = code[pc];
+  *operand_count = 0;
+  uint32_t insn_len = 1;
+  int operand_len = op_operand_len(opcode);
+  if (operand_len >= 0)
+  {
+    if (opcode == call)
+      operands[(*operand_count)++] = 1;
+    insn_len += static_cast<uint32_t>(operand_len);
+  }
+  else
+  {
+    // A fused instruction carries the immediates of its pattern, in order
+    const V4FrontSuperinstruction* entry = nullptr;
+    for (uint32_t t = 0; t < table_count && !entry; t++)
+    {
+      if (table[t].opcode == opcode)
+        entry = &table[t];
     }
-    else if (str_eq_ci(token, "LOOP"))
+    if (!entry)
+      return 0;
+    for (uint32_t k = 0; k < entry->length; k++)
     {
-      // LOOP: increment index and loop if index < limit
-      // Emit: R> 1+ R> OVER OVER < JZ [forward] SWAP >R >R JMP [backward] [target] DROP
-      // DROP
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::LoopWithoutDo);
-      }
+      if (entry->pattern[k] == call)
+        operands[(*operand_count)++] = insn_len;
+      insn_len += static_cast<uint32_t>(op_operand_len(entry->pattern[k]));
+    }
+  }
+  return insn_len <= len - pc ? insn_len : 0;
+}
 
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != DO_CONTROL)
+// Helper: List the CALL sites of one unit (unit: -1 for main code, else the
+// word index) and resolve its context placeholders
+static FrontErr collect_relocs(Arena* arena, const V4FrontSuperinstruction* table,
+                               uint32_t table_count, const ContextWords* cw,
+                               int32_t unit, uint8_t* code, uint32_t len,
+                               RelocTable* out)
+{
+  for (uint32_t pc = 0; pc < len;)
+  {
+    uint32_t operands[2];
+    uint32_t operand_count;
+    uint32_t insn_len =
+        call_operands(code, len, pc, table, table_count, operands, &operand_count);
+    if (insn_len == 0)
+      return FrontErr::LinkFailed;  // Not reached for compiler output
+    for (uint32_t k = 0; k < operand_count; k++)
+    {
+      uint32_t at = pc + operands[k];
+      int idx = code[at] | (code[at + 1] << 8);
+      V4FrontReloc reloc = {unit, at, V4FRONT_RELOC_LOCAL, static_cast<uint16_t>(idx)};
+      if (idx >= kImportBase)
       {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::LoopWithoutDo);
+        int j = idx - kImportBase;
+        if (!cw || j >= cw->word_count)
+          return FrontErr::LinkFailed;
+        reloc.kind = V4FRONT_RELOC_EXTERNAL;
+        reloc.target = static_cast<uint16_t>(cw->words[j].vm_word_idx);
+        backpatch_i16_le(code, at, static_cast<int16_t>(reloc.target));
       }
+      FrontErr err = push_reloc(arena, out, reloc);
+      if (err != FrontErr::OK)
+        return err;
+    }
+    pc += insn_len;
+  }
+  return FrontErr::OK;
+}
 
-      // R>: pop index from return stack
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      // LIT 1
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_i32_le(current_bc, current_bc_size, current_bc_cap, 1)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// ---------------------------------------------------------------------------
+// Source map (V4FRONT_OPT_SOURCE_MAP)
+// ---------------------------------------------------------------------------
+//
+// Every token records where the code it emits starts: an entry (unit, pc,
+// source position) in source order. A token that emits nothing is replaced
+// by the next one recorded at the same pc, and entries whose code was taken
+// back (constant folding) give way to the next entry. Line and column are
+// counted incrementally from the previous token, so the source is read once.
+// Once the tokens are done the entries are grouped by unit, carried through
+// the passes (which report where each offset moved) and delta-encoded:
+//
+//   map   := u8 version, uvarint unit_count, unit...
+//   unit  := uvarint slot (0: main code, k + 1: word k), uvarint entry_count,
+//            entry...
+//   entry := uvarint pc delta, svarint offset delta, svarint line delta,
+//            uvarint column
+//
+// Deltas start from pc 0, offset 0 and line 1; uvarint is LEB128 and svarint
+// is zigzag-encoded LEB128.
+
+static const uint8_t SOURCE_MAP_VERSION = 1;
+
+// Unit of the entries of the definition being compiled (renumbered at ;)
+static const int32_t kDefinitionUnit = -2;
+
+// The token that emitted the code at pc of a unit
+struct SourceMapEntry
+{
+  int32_t unit;  // -1 for main code, a word index or kDefinitionUnit
+  uint32_t pc;
+  V4FrontSourceLoc loc;
+};
 
-      // ADD: increment index
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::ADD))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Entries of a compilation, in recording order, and the position of the last
+// token recorded
+struct SourceMapTable
+{
+  SourceMapEntry* items;
+  uint32_t count;
+  uint32_t cap;
+  const char* cursor;   // Source text at pos (nullptr: before the first token)
+  V4FrontSourceLoc pos;
+};
 
-      // R>: pop limit from return stack
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Entries grouped by unit after the tokens: slot 0 holds main code, slot
+// k + 1 word k. Each slot lists ascending pcs inside its code.
+struct SourceMapUnits
+{
+  SourceMapEntry* entries;
+  uint32_t* first;   // First entry of every slot
+  uint32_t* count;   // Entries of every slot
+  uint32_t* pcs;     // Scratch: the pcs of one slot
+  int slots;         // 0 when no map is built
+};
 
-      // OVER OVER: ( index limit -- index limit index limit )
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Move the table's position to token (which follows the cursor)
+static void source_map_advance(SourceMapTable* map, const char* token)
+{
+  for (const char* c = map->cursor; c < token; c++)
+  {
+    if (*c == '\n')
+    {
+      map->pos.line++;
+      map->pos.column = 1;
+    }
+    else
+    {
+      map->pos.column++;
+    }
+  }
+  map->pos.offset += static_cast<uint32_t>(token - map->cursor);
+  map->cursor = token;
+}
 
-      // LT: compare index < limit
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Record token as the source of the code of unit from pc on
+static FrontErr source_map_record(Arena* arena, SourceMapTable* map, int32_t unit,
+                                  uint32_t pc, const char* token)
+{
+  source_map_advance(map, token);
 
-      // JZ: jump forward if done (exit loop)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Code at pc and after now belongs to this token
+  while (map->count > 0 && map->items[map->count - 1].unit == unit &&
+         map->items[map->count - 1].pc >= pc)
+    map->count--;
 
-      uint32_t jz_patch_pos = *current_bc_size;
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  if (map->count == map->cap)
+  {
+    uint32_t new_cap = map->cap ? map->cap * 2 : 64;
+    SourceMapEntry* grown = static_cast<SourceMapEntry*>(
+        arena->grow(map->items, sizeof(SourceMapEntry) * map->cap,
+                    sizeof(SourceMapEntry) * new_cap));
+    if (!grown)
+      return FrontErr::OutOfMemory;
+    map->items = grown;
+    map->cap = new_cap;
+  }
+  map->items[map->count++] = {unit, pc, map->pos};
+  return FrontErr::OK;
+}
 
-      // SWAP: ( index limit -- limit index )
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Assign the entries of the definition just ended to word
+static void source_map_end_definition(SourceMapTable* map, int32_t word)
+{
+  for (uint32_t i = map->count; i > 0 && map->items[i - 1].unit == kDefinitionUnit; i--)
+    map->items[i - 1].unit = word;
+}
 
-      // >R >R: push back to return stack
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Code size of a slot
+static uint32_t source_map_slot_size(const CodeBuf* main_bc, const WordDict* dict,
+                                     int slot)
+{
+  return slot == 0 ? main_bc->size : dict->entries[slot - 1].code_len;
+}
 
-      // JMP: jump backward to loop start
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Update the pcs of slot from units->pcs, then keep the last entry of
+// every run that ends up at the same pc and drop entries at or past size
+static void source_map_update(SourceMapUnits* units, int slot, uint32_t size)
+{
+  if (slot >= units->slots)
+    return;
+  SourceMapEntry* entries = units->entries + units->first[slot];
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < units->count[slot]; i++)
+  {
+    SourceMapEntry entry = entries[i];
+    entry.pc = units->pcs[i];
+    while (kept > 0 && entries[kept - 1].pc >= entry.pc)
+      kept--;
+    if (entry.pc < size)
+      entries[kept++] = entry;
+  }
+  units->count[slot] = kept;
+}
 
-      uint32_t jmp_next_ip = *current_bc_size + 2;
-      int16_t jmp_offset = (int16_t)(frame->do_addr - jmp_next_ip);
+// Helper: The pcs of slot in units->pcs (nullptr when no map is built)
+static uint32_t* source_map_pcs(SourceMapUnits* units, int slot, uint32_t* n)
+{
+  *n = 0;
+  if (slot >= units->slots)
+    return nullptr;
+  const SourceMapEntry* entries = units->entries + units->first[slot];
+  for (uint32_t i = 0; i < units->count[slot]; i++)
+    units->pcs[i] = entries[i].pc;
+  *n = units->count[slot];
+  return units->pcs;
+}
 
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap,
-                               jmp_offset)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Group the recorded entries by unit (main code, then every word)
+static FrontErr source_map_group(Arena* arena, const SourceMapTable* map,
+                                 const CodeBuf* main_bc, const WordDict* dict,
+                                 SourceMapUnits* units)
+{
+  const int slots = dict->count + 1;
+  units->entries = static_cast<SourceMapEntry*>(
+      arena->alloc(sizeof(SourceMapEntry) * (map->count ? map->count : 1)));
+  units->first = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * slots));
+  units->count = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * slots));
+  if (!units->entries || !units->first || !units->count)
+    return FrontErr::OutOfMemory;
+  memset(units->count, 0, sizeof(uint32_t) * slots);
+  for (uint32_t i = 0; i < map->count; i++)
+    units->count[map->items[i].unit + 1]++;
+
+  // Stable counting sort: each slot keeps the recording order
+  uint32_t at = 0;
+  uint32_t largest = 1;
+  for (int s = 0; s < slots; s++)
+  {
+    units->first[s] = at;
+    at += units->count[s];
+    if (units->count[s] > largest)
+      largest = units->count[s];
+    units->count[s] = 0;
+  }
+  for (uint32_t i = 0; i < map->count; i++)
+  {
+    int s = map->items[i].unit + 1;
+    units->entries[units->first[s] + units->count[s]++] = map->items[i];
+  }
+  units->pcs = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * largest));
+  if (!units->pcs)
+    return FrontErr::OutOfMemory;
+  units->slots = slots;
+
+  // Main code entries may still reach past its code (tokens at the end)
+  uint32_t n;
+  for (int s = 0; s < slots; s++)
+  {
+    source_map_pcs(units, s, &n);
+    source_map_update(units, s, source_map_slot_size(main_bc, dict, s));
+  }
+  return FrontErr::OK;
+}
 
-      // Backpatch JZ to exit point
-      int16_t jz_offset = (int16_t)(*current_bc_size - (jz_patch_pos + 2));
-      backpatch_i16_le(*current_bc, jz_patch_pos, jz_offset);
+// Helper: Follow strip_unused_words or layout_hot_words (remap: new index of
+// each of the first old_count words, -1 if dropped)
+static FrontErr source_map_renumber(Arena* arena, SourceMapUnits* units, const int* remap,
+                                    int old_count)
+{
+  if (units->slots == 0)
+    return FrontErr::OK;
+  uint32_t* old = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * 2 * old_count));
+  if (!old)
+    return FrontErr::OutOfMemory;
+  memcpy(old, units->first + 1, sizeof(uint32_t) * old_count);
+  memcpy(old + old_count, units->count + 1, sizeof(uint32_t) * old_count);
+  int kept = 0;
+  for (int i = 0; i < old_count; i++)
+  {
+    if (remap[i] < 0)
+      continue;
+    units->first[remap[i] + 1] = old[i];
+    units->count[remap[i] + 1] = old[old_count + i];
+    kept++;
+  }
+  units->slots = kept + 1;
+  return FrontErr::OK;
+}
 
-      // DROP DROP: clean up index and limit
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper: Append n as LEB128
+static FrontErr append_uvarint(CodeBuf* out, uint32_t n)
+{
+  FrontErr err = FrontErr::OK;
+  while (n >= 0x80 && err == FrontErr::OK)
+  {
+    err = append_byte(out, static_cast<uint8_t>(n | 0x80));
+    n >>= 7;
+  }
+  return err == FrontErr::OK ? append_byte(out, static_cast<uint8_t>(n)) : err;
+}
 
-      // Backpatch all LEAVE jumps to exit point (current position)
-      for (int i = 0; i < frame->leave_count; i++)
-      {
-        int16_t leave_offset =
-            (int16_t)(*current_bc_size - (frame->leave_patch_addrs[i] + 2));
-        backpatch_i16_le(*current_bc, frame->leave_patch_addrs[i], leave_offset);
-      }
+// Helper: Append the signed difference b - a, zigzag-encoded
+static FrontErr append_svarint(CodeBuf* out, uint32_t a, uint32_t b)
+{
+  return append_uvarint(out, b >= a ? (b - a) << 1 : ((a - b) << 1) - 1);
+}
 
-      control_depth--;
+// Helper: Encode every slot with entries into out
+static FrontErr source_map_encode(const SourceMapUnits* units, CodeBuf* out)
+{
+  uint32_t used = 0;
+  for (int s = 0; s < units->slots; s++)
+    used += units->count[s] > 0;
+  FrontErr err = append_byte(out, SOURCE_MAP_VERSION);
+  if (err == FrontErr::OK)
+    err = append_uvarint(out, used);
+  for (int s = 0; s < units->slots && err == FrontErr::OK; s++)
+  {
+    if (units->count[s] == 0)
       continue;
-    }
-    else if (str_eq_ci(token, "+LOOP"))
+    err = append_uvarint(out, static_cast<uint32_t>(s));
+    if (err == FrontErr::OK)
+      err = append_uvarint(out, units->count[s]);
+    const SourceMapEntry* entries = units->entries + units->first[s];
+    V4FrontSourceLoc prev = {0, 1, 0};
+    uint32_t prev_pc = 0;
+    for (uint32_t i = 0; i < units->count[s] && err == FrontErr::OK; i++)
     {
-      // +LOOP: add n to index and loop if still in range
-      // Similar to LOOP but uses the value on stack instead of 1
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::PLoopWithoutDo);
-      }
+      const SourceMapEntry& e = entries[i];
+      err = append_uvarint(out, e.pc - prev_pc);
+      if (err == FrontErr::OK)
+        err = append_svarint(out, prev.offset, e.loc.offset);
+      if (err == FrontErr::OK)
+        err = append_svarint(out, prev.line, e.loc.line);
+      if (err == FrontErr::OK)
+        err = append_uvarint(out, e.loc.column);
+      prev_pc = e.pc;
+      prev = e.loc;
+    }
+  }
+  return err;
+}
 
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != DO_CONTROL)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::PLoopWithoutDo);
-      }
+// Output block header. Everything a V4FrontBuf points to lives in one
+// allocation behind this header, which remembers how to release it.
+struct OutputBlock
+{
+  V4FrontAllocator allocator;  // alloc == nullptr means the block came from malloc
+};
+static_assert(sizeof(OutputBlock) % alignof(V4FrontWord) == 0,
+              "word table must stay aligned after the block header");
+
+// Output stage: turns the finished main code and dictionary into the caller's
+// result. Runs before the scratch arena is released. relocs is nullptr unless
+// V4FRONT_OPT_RELOCS is set, source_map (the encoded map) unless
+// V4FRONT_OPT_SOURCE_MAP is.
+typedef FrontErr (*OutputBuilder)(const Arena* arena, const CodeBuf* main_bc,
+                                  const WordDict* dict, const RelocTable* relocs,
+                                  const CodeBuf* source_map, void* out);
+
+// Size of the single block build_output copies the compiled result into:
+// [OutputBlock][V4FrontWord x count][V4FrontReloc x relocs][main code]
+// [word code...][names...][source map]
+static size_t output_size(const CodeBuf* main_bc, const WordDict* dict,
+                          const RelocTable* relocs, const CodeBuf* source_map)
+{
+  size_t total = sizeof(OutputBlock) + sizeof(V4FrontWord) * dict->count +
+                 sizeof(V4FrontReloc) * (relocs ? relocs->count : 0) + main_bc->size +
+                 (source_map ? source_map->size : 0);
+  for (int i = 0; i < dict->count; i++)
+    total += dict->entries[i].code_len + strlen(dict->entries[i].name) + 1;
+  return total;
+}
 
-      // R>: pop index
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Lay the compiled result out in block (output_size() bytes, aligned like
+// malloc) and point out_buf into it; owner is how v4front_free releases it
+static void write_output(uint8_t* block, const V4FrontAllocator& owner,
+                         const CodeBuf* main_bc, const WordDict* dict,
+                         const RelocTable* relocs, const CodeBuf* source_map,
+                         V4FrontBuf* out_buf)
+{
+  const uint32_t reloc_count = relocs ? relocs->count : 0;
+  const uint32_t map_size = source_map ? source_map->size : 0;
+  ((OutputBlock*)block)->allocator = owner;
+
+  V4FrontWord* words = (V4FrontWord*)(block + sizeof(OutputBlock));
+  uint8_t* cursor = block + sizeof(OutputBlock) + sizeof(V4FrontWord) * dict->count;
+
+  // Relocation table
+  out_buf->relocs = reloc_count > 0 ? (V4FrontReloc*)cursor : nullptr;
+  out_buf->reloc_count = reloc_count;
+  if (reloc_count > 0)
+    memcpy(cursor, relocs->items, sizeof(V4FrontReloc) * reloc_count);
+  cursor += sizeof(V4FrontReloc) * reloc_count;
+
+  // Main code
+  out_buf->data = cursor;
+  out_buf->size = main_bc->size;
+  memcpy(cursor, main_bc->data, main_bc->size);
+  cursor += main_bc->size;
+
+  // Word code
+  for (int i = 0; i < dict->count; i++)
+  {
+    words[i].code = cursor;
+    words[i].code_len = dict->entries[i].code_len;
+    words[i].effect = dict->entries[i].effect;
+    memcpy(cursor, dict->entries[i].code, dict->entries[i].code_len);
+    cursor += dict->entries[i].code_len;
+  }
 
-      // ADD: add increment value to index
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::ADD))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Word names
+  for (int i = 0; i < dict->count; i++)
+  {
+    size_t name_len = strlen(dict->entries[i].name);
+    words[i].name = (char*)cursor;
+    memcpy(cursor, dict->entries[i].name, name_len + 1);
+    cursor += name_len + 1;
+  }
 
-      // R>: pop limit
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Source map
+  out_buf->source_map = map_size > 0 ? cursor : nullptr;
+  out_buf->source_map_size = map_size;
+  if (map_size > 0)
+    memcpy(cursor, source_map->data, map_size);
 
-      // OVER OVER: duplicate for comparison
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  out_buf->words = (dict->count > 0) ? words : nullptr;
+  out_buf->word_count = dict->count;
+  out_buf->block = block;
+}
 
-      // LT: compare
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper function to copy the compiled result out of the arena into a single
+// block taken from the arena's allocator
+static FrontErr build_output(const Arena* arena, const CodeBuf* main_bc,
+                             const WordDict* dict, const RelocTable* relocs,
+                             const CodeBuf* source_map, void* out)
+{
+  uint8_t* block =
+      (uint8_t*)arena->raw_alloc(output_size(main_bc, dict, relocs, source_map));
+  if (!block)
+    return FrontErr::OutOfMemory;
+  write_output(block, arena->allocator, main_bc, dict, relocs, source_map,
+               (V4FrontBuf*)out);
+  return FrontErr::OK;
+}
 
-      // JZ: exit if done
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Round up to the image section alignment
+static uint32_t image_align(uint32_t offset)
+{
+  return (offset + 3) & ~3u;
+}
 
-      uint32_t jz_patch_pos = *current_bc_size;
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper function to lay out the compiled result as a relocatable image
+// (see v4front/image.h; images carry no relocation table or source map)
+static FrontErr build_image(const Arena* arena, const CodeBuf* main_bc,
+                            const WordDict* dict, const RelocTable* relocs,
+                            const CodeBuf* source_map, void* out)
+{
+  (void)relocs;
+  (void)source_map;
+  V4FrontImage* image = (V4FrontImage*)out;
 
-      // SWAP >R >R: push back
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  uint32_t code_size = main_bc->size;
+  uint32_t names_size = 0;
+  for (int i = 0; i < dict->count; i++)
+  {
+    code_size += dict->entries[i].code_len;
+    names_size += (uint32_t)strlen(dict->entries[i].name) + 1;
+  }
 
-      // JMP: loop back
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  V4FrontImageHeader header;
+  memcpy(header.magic, V4FRONT_IMAGE_MAGIC, 4);
+  header.version = V4FRONT_IMAGE_VERSION;
+  header.flags = 0;
+  header.word_count = (uint32_t)dict->count;
+  header.words_offset = image_align(sizeof(V4FrontImageHeader));
+  header.code_offset =
+      image_align(header.words_offset + sizeof(V4FrontImageWord) * dict->count);
+  header.code_size = code_size;
+  header.main_size = main_bc->size;
+  header.names_offset = image_align(header.code_offset + code_size);
+  header.names_size = names_size;
+  header.image_size = image_align(header.names_offset + names_size);
+
+  uint8_t* data = (uint8_t*)arena->raw_alloc(header.image_size);
+  if (!data)
+    return FrontErr::OutOfMemory;
+  memset(data, 0, header.image_size);  // Padding is deterministic
+  memcpy(data, &header, sizeof(header));
+
+  V4FrontImageWord* words = (V4FrontImageWord*)(data + header.words_offset);
+  uint8_t* code = data + header.code_offset;
+  char* names = (char*)(data + header.names_offset);
+
+  memcpy(code, main_bc->data, main_bc->size);
+  uint32_t code_pos = main_bc->size;
+  uint32_t name_pos = 0;
+  for (int i = 0; i < dict->count; i++)
+  {
+    const WordDefEntry* entry = &dict->entries[i];
+    size_t name_len = strlen(entry->name);
 
-      uint32_t jmp_next_ip = *current_bc_size + 2;
-      int16_t jmp_offset = (int16_t)(frame->do_addr - jmp_next_ip);
+    words[i].name_offset = name_pos;
+    words[i].code_offset = code_pos;
+    words[i].code_len = entry->code_len;
 
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap,
-                               jmp_offset)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+    memcpy(code + code_pos, entry->code, entry->code_len);
+    code_pos += entry->code_len;
+    memcpy(names + name_pos, entry->name, name_len + 1);
+    name_pos += (uint32_t)name_len + 1;
+  }
 
-      // Backpatch JZ
-      int16_t jz_offset = (int16_t)(*current_bc_size - (jz_patch_pos + 2));
-      backpatch_i16_le(*current_bc, jz_patch_pos, jz_offset);
+  image->data = data;
+  image->size = header.image_size;
+  image->allocator = arena->allocator;
+  return FrontErr::OK;
+}
 
-      // DROP DROP: cleanup
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Locals usage of a word definition, found by scanning its source ahead of
+// compilation (for V4FRONT_OPT_LOOP_LOCALS)
+struct DefinitionScan
+{
+  bool uses_locals;  // L@/L!/L>!/L++/L-- or a short form
+  bool uses_rstack;  // >R, R> or R@ (may address DO parameters directly)
+  int max_local;     // Highest local index used (-1 if none)
+  int max_do_depth;  // Deepest DO nesting
+};
 
-      // Backpatch all LEAVE jumps to exit point (current position)
-      for (int i = 0; i < frame->leave_count; i++)
-      {
-        int16_t leave_offset =
-            (int16_t)(*current_bc_size - (frame->leave_patch_addrs[i] + 2));
-        backpatch_i16_le(*current_bc, frame->leave_patch_addrs[i], leave_offset);
-      }
+// Helper: Scan the definition body starting at p up to its ; without emitting
+// anything. Malformed input is left for the compiler proper to report.
+static void scan_definition(const char* p, const char* end, DefinitionScan* scan)
+{
+  scan->uses_locals = false;
+  scan->uses_rstack = false;
+  scan->max_local = -1;
+  scan->max_do_depth = 0;
 
-      control_depth--;
+  int do_depth = 0;
+  while (skip_whitespace_and_comments(&p, end, nullptr) == FrontErr::OK && p < end)
+  {
+    const char* start = p;
+    p = scan_token(p, end);
+    const KeywordEntry* kw = lookup_keyword(start, p - start);
+    if (!kw)
       continue;
-    }
-    else if (str_eq_ci(token, "IF"))
-    {
-      // IF: emit JZ with placeholder offset, push to control stack
-      if (control_depth >= MAX_CONTROL_DEPTH)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ControlDepthExceeded);
-      }
-
-      // Emit JZ opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      // Save position for backpatching and emit placeholder
-      uint32_t patch_pos = *current_bc_size;
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
 
-      // Push control frame
-      control_stack[control_depth].type = IF_CONTROL;
-      control_stack[control_depth].jz_patch_addr = patch_pos;
-      control_stack[control_depth].jmp_patch_addr = 0;
-      control_stack[control_depth].has_else = false;
-      control_depth++;
-      continue;
-    }
-    else if (str_eq_ci(token, "ELSE"))
+    int local_idx = -1;
+    switch (kw->id)
     {
-      // ELSE: emit JMP, then backpatch JZ to jump past the JMP
-      if (control_depth <= 0)
+      case KeywordId::Colon:
+      case KeywordId::Semicolon:
+        return;
+      case KeywordId::Do:
+        if (++do_depth > scan->max_do_depth)
+          scan->max_do_depth = do_depth;
+        break;
+      case KeywordId::Loop:
+      case KeywordId::PlusLoop:
+        if (do_depth > 0)
+          do_depth--;
+        break;
+      case KeywordId::LocalInc:
+      case KeywordId::LocalDec:
+      case KeywordId::LocalGet:
+      case KeywordId::LocalSet:
+      case KeywordId::LocalTee:
       {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ElseWithoutIf);
+        if (skip_whitespace_and_comments(&p, end, nullptr) != FrontErr::OK)
+          return;
+        start = p;
+        p = scan_token(p, end);
+        int32_t idx;
+        if (try_parse_int(start, p - start, &idx) && idx >= 0 && idx <= 255)
+          local_idx = idx;
+        break;
       }
+      case KeywordId::Simple:
+        if (kw->opcode == v4::Op::LGET0 || kw->opcode == v4::Op::LSET0)
+          local_idx = 0;
+        else if (kw->opcode == v4::Op::LGET1 || kw->opcode == v4::Op::LSET1)
+          local_idx = 1;
+        else if (kw->opcode == v4::Op::TOR || kw->opcode == v4::Op::FROMR ||
+                 kw->opcode == v4::Op::RFETCH)
+          scan->uses_rstack = true;
+        break;
+      default:
+        break;
+    }
 
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != IF_CONTROL)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ElseWithoutIf);
-      }
-      if (frame->has_else)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::DuplicateElse);
-      }
-
-      // Emit JMP with placeholder (to skip ELSE clause)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      uint32_t jmp_patch_pos = *current_bc_size;
-      if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-
-      // Now backpatch JZ to jump to current position (start of ELSE clause)
-      // offset = current_pos - (jz_patch_addr + 2)
-      int16_t jz_offset = (int16_t)(*current_bc_size - (frame->jz_patch_addr + 2));
-      backpatch_i16_le(*current_bc, frame->jz_patch_addr, jz_offset);
-
-      // Update control frame
-      frame->jmp_patch_addr = jmp_patch_pos;
-      frame->has_else = true;
-      continue;
-    }
-    else if (str_eq_ci(token, "THEN"))
+    if (local_idx >= 0)
     {
-      // THEN: backpatch the last IF or ELSE jump
-      if (control_depth <= 0)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ThenWithoutIf);
-      }
-
-      ControlFrame* frame = &control_stack[control_depth - 1];
-      if (frame->type != IF_CONTROL)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ThenWithoutIf);
-      }
+      scan->uses_locals = true;
+      if (local_idx > scan->max_local)
+        scan->max_local = local_idx;
+    }
+  }
+}
 
-      control_depth--;
+// Helper: First local slot for DO parameters in a definition, or -1 to keep
+// them on the return stack. Loops get slots only in words that already use
+// locals and never touch the return stack themselves; each nesting level
+// takes two slots (index, limit) above the word's own locals.
+static int loop_slot_base(const char* body, const char* end)
+{
+  DefinitionScan scan;
+  scan_definition(body, end, &scan);
+  if (!scan.uses_locals || scan.uses_rstack || scan.max_do_depth == 0)
+    return -1;
+  int base = scan.max_local + 1;
+  if (base + 2 * scan.max_do_depth - 1 > 255)
+    return -1;
+  return base;
+}
 
-      if (frame->has_else)
-      {
-        // Backpatch the JMP from ELSE
-        int16_t jmp_offset = (int16_t)(*current_bc_size - (frame->jmp_patch_addr + 2));
-        backpatch_i16_le(*current_bc, frame->jmp_patch_addr, jmp_offset);
-      }
-      else
-      {
-        // Backpatch the JZ from IF
-        int16_t jz_offset = (int16_t)(*current_bc_size - (frame->jz_patch_addr + 2));
-        backpatch_i16_le(*current_bc, frame->jz_patch_addr, jz_offset);
-      }
-      continue;
-    }
-    else if (str_eq_ci(token, "EXIT"))
+// Helper: Check whether the DO loop whose body starts at p can use the counted
+// lowering: it must end in LOOP and never look at the return stack layout
+// (J, K, >R, R>, R@, or LEAVE/EXIT of this loop). I of this loop is allowed.
+// *unrollable is also cleared when the body reads I or contains RECURSE.
+static bool scan_counted_loop(const char* p, const char* end, bool* unrollable)
+{
+  int depth = 0;  // Nested DO loops inside the body
+  *unrollable = true;
+  while (skip_whitespace_and_comments(&p, end, nullptr) == FrontErr::OK && p < end)
+  {
+    const char* start = p;
+    p = scan_token(p, end);
+    const KeywordEntry* kw = lookup_keyword(start, p - start);
+    switch (kw ? kw->id : KeywordId::None)
     {
-      // EXIT: early return from word (emit RET)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::RET))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      case KeywordId::Do:
+        depth++;
+        break;
+      case KeywordId::Loop:
+        if (depth == 0)
+          return true;
+        depth--;
+        break;
+      case KeywordId::PlusLoop:
+        if (depth == 0)
+          return false;
+        depth--;
+        break;
+      case KeywordId::LoopI:
+        if (depth == 0)
+          *unrollable = false;
+        break;
+      case KeywordId::Leave:
+        if (depth == 0)
+          return false;
+        break;
+      case KeywordId::Recurse:
+        *unrollable = false;
+        break;
+      case KeywordId::LoopJ:
+      case KeywordId::LoopK:
+      case KeywordId::Exit:
+      case KeywordId::Colon:
+      case KeywordId::Semicolon:
+        return false;
+      case KeywordId::Simple:
+        if (kw->opcode == v4::Op::TOR || kw->opcode == v4::Op::FROMR ||
+            kw->opcode == v4::Op::RFETCH)
+          return false;
+        break;
+      default:
+        break;
     }
-    // SYS is now handled as a primitive (NoImm) - removed special case handling
-    else if (str_eq_ci(token, "EMIT"))
-    {
-      // EMIT: output one character ( c -- )
-      // Emits: LIT 0x30 + SYS (Forth-style)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Emit 0x30 as 32-bit little-endian
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x30)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x00)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x00)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x00)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Emit SYS opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SYS))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  }
+  return false;  // Unterminated (reported by the compiler proper)
+}
 
-      continue;
-    }
-    else if (str_eq_ci(token, "KEY"))
-    {
-      // KEY: input one character ( -- c )
-      // Emits: LIT 0x31 + SYS (Forth-style)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Emit 0x31 as 32-bit little-endian
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x31)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x00)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x00)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0x00)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Emit SYS opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SYS))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Helper function to handle : (colon) - start word definition
+static FrontErr handle_colon_start(const char** p, const char* end, bool* in_definition,
+                                   char* current_word_name, CodeBuf* word_bc,
+                                   CodeBuf** current_bc, const WordDict* dict,
+                                   const char** error_pos)
+{
+  // Check for nested :
+  if (*in_definition)
+  {
+    if (error_pos)
+      *error_pos = *p;
+    return FrontErr::NestedColon;
+  }
 
-      continue;
-    }
-    else if (str_eq_ci(token, "L++"))
-    {
-      // L++: increment local variable (LINC)
-      // Skip whitespace and comments, then get next token (the local variable index)
-      if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Read next token as word name
+  FrontErr err = skip_whitespace_and_comments(p, end, error_pos);
+  if (err != FrontErr::OK)
+    return err;
+  if (*p == end)
+  {
+    if (error_pos)
+      *error_pos = *p;
+    return FrontErr::ColonWithoutName;
+  }
 
-      if (!*p)
-      {
-        // No token after L++
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
-      }
+  const char* name_start = *p;
+  *p = scan_token(*p, end);
+  size_t name_len = *p - name_start;
 
-      // Extract index token
-      const char* idx_token_start = p;
-      while (*p && !isspace((unsigned char)*p))
-        p++;
-      size_t idx_token_len = p - idx_token_start;
-      if (idx_token_len >= sizeof(token))
-        idx_token_len = sizeof(token) - 1;
+  if (name_len == 0 || name_len >= MAX_WORD_NAME_LEN)
+  {
+    if (error_pos)
+      *error_pos = name_start;
+    return FrontErr::ColonWithoutName;
+  }
 
-      char idx_token[MAX_TOKEN_LEN];
-      memcpy(idx_token, idx_token_start, idx_token_len);
-      idx_token[idx_token_len] = '\0';
+  memcpy(current_word_name, name_start, name_len);
+  current_word_name[name_len] = '\0';
 
-      // Parse index as integer
-      int32_t local_idx;
-      if (!try_parse_int(idx_token, &local_idx) || local_idx < 0 || local_idx > 255)
-      {
-        if (error_pos)
-          *error_pos = idx_token_start;
-        CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
-      }
+  // Check for duplicate word names
+  if (dict->find(current_word_name, name_len) >= 0)
+  {
+    if (error_pos)
+      *error_pos = name_start;
+    return FrontErr::DuplicateWord;
+  }
 
-      // Emit: [LINC] [idx8]
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LINC))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(local_idx))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Check dictionary full
+  if (dict->full())
+  {
+    if (error_pos)
+      *error_pos = name_start;
+    return FrontErr::DictionaryFull;
+  }
 
-      continue;
-    }
-    else if (str_eq_ci(token, "L--"))
-    {
-      // L--: decrement local variable (LDEC)
-      // Skip whitespace and comments, then get next token (the local variable index)
-      if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Enter definition mode
+  *in_definition = true;
+  word_bc->data = nullptr;
+  word_bc->size = 0;
+  word_bc->cap = 0;
 
-      if (!*p)
-      {
-        // No token after L--
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
-      }
+  // Switch to word bytecode buffer
+  *current_bc = word_bc;
 
-      // Extract index token
-      const char* idx_token_start = p;
-      while (*p && !isspace((unsigned char)*p))
-        p++;
-      size_t idx_token_len = p - idx_token_start;
-      if (idx_token_len >= sizeof(token))
-        idx_token_len = sizeof(token) - 1;
+  return FrontErr::OK;
+}
 
-      char idx_token[MAX_TOKEN_LEN];
-      memcpy(idx_token, idx_token_start, idx_token_len);
-      idx_token[idx_token_len] = '\0';
+// Helper function to handle ; (semicolon) - end word definition
+static FrontErr handle_semicolon_end(bool* in_definition, char* current_word_name,
+                                     CodeBuf* word_bc, CodeBuf** current_bc,
+                                     CodeBuf* bc_main, WordDict* dict,
+                                     const char** error_pos, const char* token_pos)
+{
+  // Check if in definition mode
+  if (!*in_definition)
+  {
+    if (error_pos)
+      *error_pos = token_pos;
+    return FrontErr::SemicolonWithoutColon;
+  }
 
-      // Parse index as integer
-      int32_t local_idx;
-      if (!try_parse_int(idx_token, &local_idx) || local_idx < 0 || local_idx > 255)
-      {
-        if (error_pos)
-          *error_pos = idx_token_start;
-        CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
-      }
+  // Append RET to word bytecode
+  FrontErr err;
+  if ((err = append_byte(*current_bc, static_cast<uint8_t>(v4::Op::RET))) != FrontErr::OK)
+    return err;
 
-      // Emit: [LDEC] [idx8]
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LDEC))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(local_idx))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Add word to dictionary
+  if ((err = dict->add(current_word_name, strlen(current_word_name), word_bc->data,
+                       word_bc->size)) != FrontErr::OK)
+    return err;
 
-      continue;
-    }
-    else if (str_eq_ci(token, "L@"))
-    {
-      // L@: get local variable (LGET)
-      // Skip whitespace and comments, then get next token (the local variable index)
-      if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Exit definition mode and switch back to main bytecode buffer
+  *in_definition = false;
+  current_word_name[0] = '\0';
+  word_bc->data = nullptr;  // Now referenced by the dictionary
+  word_bc->size = 0;
+  word_bc->cap = 0;
 
-      if (!*p)
-      {
-        // No token after L@
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
-      }
+  // Switch back to main bytecode buffer
+  *current_bc = bc_main;
 
-      // Extract index token
-      const char* idx_token_start = p;
-      while (*p && !isspace((unsigned char)*p))
-        p++;
-      size_t idx_token_len = p - idx_token_start;
-      if (idx_token_len >= sizeof(token))
-        idx_token_len = sizeof(token) - 1;
+  return FrontErr::OK;
+}
 
-      char idx_token[MAX_TOKEN_LEN];
-      memcpy(idx_token, idx_token_start, idx_token_len);
-      idx_token[idx_token_len] = '\0';
+// A definition compiled in this compilation, added to the word cache at the end
+// (its body text and code are copies: the source may be gone by then, and the
+// passes rewrite the code in place)
+struct PendingWord
+{
+  int index;  // Dictionary index
+  const char* body;
+  uint32_t body_len;
+  const uint8_t* code;  // Before the passes
+  uint32_t code_len;
+  const CacheDep* deps;
+  uint32_t dep_count;
+};
 
-      // Parse index as integer
-      int32_t local_idx;
-      if (!try_parse_int(idx_token, &local_idx) || local_idx < 0 || local_idx > 255)
-      {
-        if (error_pos)
-          *error_pos = idx_token_start;
-        CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
-      }
+// Errors of a compilation that goes on after them (v4front_compile_all_errors),
+// in the order they were found. Heap memory: it outlives the arena.
+struct ErrorLog
+{
+  struct Note
+  {
+    FrontErr code;
+    const char* pos;  // In the source (nullptr: unknown)
+  };
+  Note* notes;
+  uint32_t count;
+  uint32_t cap;
+
+  void init()
+  {
+    notes = nullptr;
+    count = 0;
+    cap = 0;
+  }
 
-      // Emit: [LGET] [idx8]
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LGET))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(local_idx))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  void destroy()
+  {
+    free(notes);
+    init();
+  }
 
-      continue;
-    }
-    else if (str_eq_ci(token, "L!"))
+  bool push(FrontErr code, const char* pos)
+  {
+    if (count == cap)
     {
-      // L!: set local variable (LSET)
-      // Skip whitespace and comments, then get next token (the local variable index)
-      if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+      uint32_t grown = cap ? cap * 2 : 8;
+      Note* bigger = static_cast<Note*>(realloc(notes, sizeof(Note) * grown));
+      if (!bigger)
+        return false;
+      notes = bigger;
+      cap = grown;
+    }
+    notes[count++] = {code, pos};
+    return true;
+  }
+};
 
-      if (!*p)
-      {
-        // No token after L!
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
-      }
+// Everything a compilation carries from one token to the next. Kept outside
+// the token loop so a stream can feed the source in several pieces; every
+// pointer member refers into the state itself or its arena, so the state must
+// not move once initialized.
+struct CompileState
+{
+  V4FrontContext* ctx;
+  uint32_t flags;  // V4FRONT_OPT_* bits, including the opt_level preset
+  uint32_t inline_max_size;
+  const V4FrontSuperinstruction* super_table;
+  uint32_t super_count;
 
-      // Extract index token
-      const char* idx_token_start = p;
-      while (*p && !isspace((unsigned char)*p))
-        p++;
-      size_t idx_token_len = p - idx_token_start;
-      if (idx_token_len >= sizeof(token))
-        idx_token_len = sizeof(token) - 1;
+  Arena arena;  // All scratch memory for this compilation
+  CodeBuf bc;   // Main bytecode
 
-      char idx_token[MAX_TOKEN_LEN];
-      memcpy(idx_token, idx_token_start, idx_token_len);
-      idx_token[idx_token_len] = '\0';
+  // Control flow stack for IF/THEN/ELSE (allocated on first use)
+  ControlFrame* control_stack;
+  int control_depth;
+  int control_cap;
 
-      // Parse index as integer
-      int32_t local_idx;
-      if (!try_parse_int(idx_token, &local_idx) || local_idx < 0 || local_idx > 255)
-      {
-        if (error_pos)
-          *error_pos = idx_token_start;
-        CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
-      }
+  WordDict dict;  // Word dictionary (during compilation)
 
-      // Emit: [LSET] [idx8]
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LSET))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(local_idx))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+  // Compilation mode state
+  bool in_definition;                         // Are we inside a : ... ; definition?
+  char current_word_name[MAX_WORD_NAME_LEN];  // Name of word being defined
+  CodeBuf word_bc;                            // Bytecode buffer for current word
+  int loop_base;  // First local slot for DO parameters in this definition
+  bool calls_ctx_words;  // Some CALL operand is a VM index from ctx
+
+  // RECURSE call sites in the current definition (for tail-call lowering)
+  uint32_t* recurse_sites;
+  int recurse_count;
+  int recurse_cap;
+
+  DataSpace data_space;  // VARIABLE/CREATE/ALLOT space (continues ctx->data)
+  CodeBuf* current_bc;   // Current bytecode buffer (updated when switching modes)
+
+  // Literals emitted by the tokens just before the current one (CONSTANT takes
+  // its value from here; constant folding evaluates operators on them)
+  ConstTail consts;
+
+  // Word cache of ctx (nullptr when disabled or ctx is a snapshot)
+  WordCache* cache;
+  bool def_cacheable;   // Current definition may be cached (its lookups are recorded)
+  const char* def_body;  // Its body (just after the name)
+  CacheDep* deps;        // Its lookups
+  uint32_t dep_count;
+  uint32_t dep_cap;
+  PendingWord* pending;  // Definitions to add to the cache
+  uint32_t pending_count;
+  uint32_t pending_cap;
+  uint32_t reused;    // Definitions taken from the cache
+  uint32_t compiled;  // Definitions compiled from source
+
+  bool source_map;     // V4FRONT_OPT_SOURCE_MAP: record map
+  SourceMapTable map;  // Its entries so far
+
+  bool stack_effects;  // V4FRONT_OPT_STACK_EFFECTS: infer effects at ;
+
+  uint32_t yield_budget;  // V4FRONT_OPT_AUTO_YIELD: instructions between yields
+  uint32_t yield_cell;    // Data-space address of its counter (0: none yet)
+
+  const V4FrontProfile* profile_src;  // V4FrontCompileOptions::profile
+  ProfileIndex profile;               // Its counts by name (built on first use)
+  bool profile_ready;
+
+  LexStream lex;  // Tokens of the source from ctx's lex cache (base nullptr: none)
+
+  ErrorLog* errors;    // Errors so far when going on after them (nullptr: stop)
+  const char* resume;  // Where compile_tokens starts (nullptr: the source start)
+  int colon_depth;     // control_depth at the : of the current definition
+
+#if V4FRONT_STATS
+  V4FrontStats* stats;  // Statistics output (nullptr: not requested)
+  int stats_phase;      // StatsPhase the clock is charged to
+  uint64_t stats_mark;  // Clock reading at the last phase change
+#endif
+};
 
-      continue;
-    }
-    else if (str_eq_ci(token, "L>!"))
-    {
-      // L>!: tee local variable (LTEE) - store and keep value on stack
-      // Skip whitespace and comments, then get next token (the local variable index)
-      if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+static FrontErr compile_init(CompileState* st, V4FrontContext* ctx,
+                             const V4FrontCompileOptions* options)
+{
+  st->ctx = ctx;
+  st->flags = options ? options->flags | opt_level_flags(options->opt_level) : 0;
+  st->inline_max_size = (options && options->inline_max_size) ? options->inline_max_size
+                                                              : DEFAULT_INLINE_MAX_SIZE;
+  st->super_table = options ? options->superinstructions : nullptr;
+  st->super_count = options ? options->superinstruction_count : 0;
+  if (!superinsn_table_valid(st->super_table, st->super_count))
+    return FrontErr::InvalidOption;
+
+  st->arena.init(options ? options->allocator : nullptr);
+  st->bc = {nullptr, 0, 0, &st->arena};
+  st->control_stack = nullptr;
+  st->control_depth = 0;
+  st->control_cap = 0;
+  st->dict.init(&st->arena);
+  st->in_definition = false;
+  st->current_word_name[0] = '\0';
+  st->word_bc = {nullptr, 0, 0, &st->arena};
+  st->loop_base = -1;
+  st->calls_ctx_words = false;
+  st->recurse_sites = nullptr;
+  st->recurse_count = 0;
+  st->recurse_cap = 0;
+  if (ctx)
+    st->data_space = ctx->data;
+  else
+    st->data_space.init(DATA_SPACE_BASE, DATA_SPACE_SIZE);
+  st->current_bc = &st->bc;
+  st->consts.count = 0;
+  // Reused definitions come without source positions
+  st->source_map = (st->flags & V4FRONT_OPT_SOURCE_MAP) != 0;
+  // Inserted yields depend on yield_budget and the counter cell, and inlining
+  // on the profile, which cache keys do not cover
+  st->profile_src = options ? options->profile : nullptr;
+  st->profile_ready = false;
+  st->lex = {nullptr, nullptr, 0, 0};
+  st->errors = nullptr;
+  st->resume = nullptr;
+  st->colon_depth = 0;
+  st->cache = ctx && !st->source_map && !(st->flags & V4FRONT_OPT_AUTO_YIELD) &&
+                      !st->profile_src
+                  ? ctx->cache
+                  : nullptr;
+  st->yield_budget = (options && options->yield_budget) ? options->yield_budget
+                                                        : DEFAULT_YIELD_BUDGET;
+  st->yield_cell = 0;
+  st->stack_effects = (st->flags & V4FRONT_OPT_STACK_EFFECTS) != 0;
+  st->def_cacheable = false;
+  st->def_body = nullptr;
+  st->deps = nullptr;
+  st->dep_count = 0;
+  st->dep_cap = 0;
+  st->pending = nullptr;
+  st->pending_count = 0;
+  st->pending_cap = 0;
+  st->reused = 0;
+  st->compiled = 0;
+  st->map = {nullptr, 0, 0, nullptr, {0, 1, 1}};
+#if V4FRONT_STATS
+  st->stats = nullptr;
+  st->stats_phase = 0;
+  st->stats_mark = 0;
+#endif
+  if (st->cache)
+    st->cache->generation++;
+  return FrontErr::OK;
+}
 
-      if (!*p)
-      {
-        // No token after L>!
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
-      }
+// The index of the options' profile, built on first use (scratch memory must
+// not be taken before the first token, see compile_source); *out is nullptr
+// without a profile
+static FrontErr profile_index(CompileState* st, const ProfileIndex** out)
+{
+  *out = nullptr;
+  if (!st->profile_src)
+    return FrontErr::OK;
+  if (!st->profile_ready)
+  {
+    if (!st->profile.build(&st->arena, st->profile_src))
+      return FrontErr::OutOfMemory;
+    st->profile_ready = true;
+  }
+  *out = &st->profile;
+  return FrontErr::OK;
+}
 
-      // Extract index token
-      const char* idx_token_start = p;
-      while (*p && !isspace((unsigned char)*p))
-        p++;
-      size_t idx_token_len = p - idx_token_start;
-      if (idx_token_len >= sizeof(token))
-        idx_token_len = sizeof(token) - 1;
+// ---------------------------------------------------------------------------
+// Compile statistics (V4FrontStats; compiled out without V4FRONT_STATS)
+// ---------------------------------------------------------------------------
+#if V4FRONT_STATS
+static uint64_t stats_now()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
 
-      char idx_token[MAX_TOKEN_LEN];
-      memcpy(idx_token, idx_token_start, idx_token_len);
-      idx_token[idx_token_len] = '\0';
+enum StatsPhase
+{
+  StatsNone,
+  StatsTokenize,
+  StatsKeyword,
+  StatsLookup,
+  StatsEmit,
+  StatsBackpatch,
+  StatsFinish,
+};
 
-      // Parse index as integer
-      int32_t local_idx;
-      if (!try_parse_int(idx_token, &local_idx) || local_idx < 0 || local_idx > 255)
-      {
-        if (error_pos)
-          *error_pos = idx_token_start;
-        CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
-      }
+// Charge the time since the last change to the current phase, then switch
+static void stats_switch(CompileState* st, int phase)
+{
+  V4FrontStats* stats = st->stats;
+  uint64_t now = stats_now();
+  uint64_t spent = now - st->stats_mark;
+  switch (st->stats_phase)
+  {
+    case StatsTokenize:
+      stats->tokenize_ns += spent;
+      break;
+    case StatsKeyword:
+      stats->keyword_ns += spent;
+      break;
+    case StatsLookup:
+      stats->lookup_ns += spent;
+      break;
+    case StatsEmit:
+      stats->emit_ns += spent;
+      break;
+    case StatsBackpatch:
+      stats->backpatch_ns += spent;
+      break;
+    case StatsFinish:
+      stats->finish_ns += spent;
+      break;
+    default:
+      break;
+  }
+  st->stats_phase = phase;
+  st->stats_mark = now;
+}
 
-      // Emit: [LTEE] [idx8]
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LTEE))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(local_idx))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+#define STATS_PHASE(st, phase)   \
+  do                             \
+  {                              \
+    if ((st)->stats)             \
+      stats_switch((st), phase); \
+  } while (0)
+#define STATS_COUNT(st, field)  \
+  do                            \
+  {                             \
+    if ((st)->stats)            \
+      (st)->stats->field++;     \
+  } while (0)
+#else
+#define STATS_PHASE(st, phase) ((void)0)
+#define STATS_COUNT(st, field) ((void)0)
+#endif
 
-      continue;
-    }
-    else if (str_eq_ci(token, "RECURSE"))
-    {
-      // RECURSE: call the currently-being-defined word recursively
-      if (!in_definition)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::RecurseOutsideWord);
-      }
+#if V4FRONT_STATS
+// Keywords whose code generation is mostly resolving earlier jumps
+static bool stats_backpatches(const KeywordEntry* kw)
+{
+  if (!kw)
+    return false;
+  switch (kw->id)
+  {
+    case KeywordId::Else:
+    case KeywordId::Then:
+    case KeywordId::Until:
+    case KeywordId::Again:
+    case KeywordId::Repeat:
+    case KeywordId::Loop:
+    case KeywordId::PlusLoop:
+      return true;
+    default:
+      return false;
+  }
+}
+#endif
 
-      // Emit CALL to the current word (which will be at index word_count)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::CALL))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// ---------------------------------------------------------------------------
+// Word cache (incremental recompilation)
+// ---------------------------------------------------------------------------
 
-      // Emit the index as 16-bit little-endian
-      int16_t word_idx = static_cast<int16_t>(word_count);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(word_idx & 0xFF))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>((word_idx >> 8) & 0xFF))) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Identity of a dictionary entry as seen by its callers: CALL, inline copy or
+// value all derive from the code and the value
+static uint64_t word_fingerprint(WordDefEntry* word)
+{
+  if (word->fingerprint == 0)
+  {
+    uint64_t h = hash64(word->code, word->code_len);
+    h = hash64(&word->is_constant, sizeof(word->is_constant), h);
+    h = hash64(&word->const_value, sizeof(word->const_value), h);
+    word->fingerprint = h | 1;
+  }
+  return word->fingerprint;
+}
 
-      continue;
-    }
-    else if (str_eq_ci(token, "CONSTANT"))
-    {
-      // CONSTANT: <value> CONSTANT <name>
-      // Extracts the last LIT instruction, creates a word that returns that value
+// What the lookup of token resolves to right now (dictionary, then context)
+// CALL operand for context word j: its VM index, or under V4FRONT_OPT_RELOCS
+// the placeholder the relocation table resolves
+static int ctx_call_operand(const CompileState* st, int j)
+{
+  if (st->flags & V4FRONT_OPT_RELOCS)
+    return kImportBase + j;
+  return st->ctx->words->words[j].vm_word_idx;
+}
 
-      // Check that we have a LIT instruction at the end of the current bytecode
-      // LIT is 1 byte opcode + 4 bytes value = 5 bytes total
-      if (*current_bc_size < 5 ||
-          (*current_bc)[*current_bc_size - 5] != static_cast<uint8_t>(v4::Op::LIT))
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ConstantWithoutValue);
-      }
+static CacheDep resolve_dep(CompileState* st, const char* token, size_t len)
+{
+  CacheDep dep = {0, static_cast<uint32_t>(len), CacheDepKind::None, -1, 0};
+  int word_idx = st->dict.find(token, len);
+  if (word_idx >= 0)
+  {
+    dep.kind = CacheDepKind::Word;
+    dep.target = word_idx;
+    dep.fingerprint = word_fingerprint(&st->dict.entries[word_idx]);
+    return dep;
+  }
+  const ContextWords* cw = st->ctx->words;
+  const WordIndex::Slot* slot = cw->index.find(token, len);
+  if (slot && cw->words[slot->value].vm_word_idx >= 0)
+  {
+    dep.kind = CacheDepKind::Context;
+    dep.target = ctx_call_operand(st, slot->value);
+  }
+  return dep;
+}
+
+// Record how a token of the current definition was looked up
+static FrontErr record_dep(CompileState* st, const char* token, size_t len)
+{
+  if (st->dep_count == st->dep_cap)
+  {
+    uint32_t new_cap = st->dep_cap ? st->dep_cap * 2 : 16;
+    CacheDep* grown = static_cast<CacheDep*>(st->arena.grow(
+        st->deps, sizeof(CacheDep) * st->dep_cap, sizeof(CacheDep) * new_cap));
+    if (!grown)
+      return FrontErr::OutOfMemory;
+    st->deps = grown;
+    st->dep_cap = new_cap;
+  }
+  CacheDep dep = resolve_dep(st, token, len);
+  dep.offset = static_cast<uint32_t>(token - st->def_body);
+  st->deps[st->dep_count++] = dep;
+  return FrontErr::OK;
+}
 
-      // Extract the value from the LIT instruction
-      uint32_t lit_offset = *current_bc_size - 4;
-      int32_t const_value = static_cast<int32_t>((*current_bc)[lit_offset]) |
-                            (static_cast<int32_t>((*current_bc)[lit_offset + 1]) << 8) |
-                            (static_cast<int32_t>((*current_bc)[lit_offset + 2]) << 16) |
-                            (static_cast<int32_t>((*current_bc)[lit_offset + 3]) << 24);
+// The ; that ends the definition whose body starts at p, or nullptr
+static const char* find_definition_end(const char* p, const char* end)
+{
+  while (skip_whitespace_and_comments(&p, end, nullptr) == FrontErr::OK && p < end)
+  {
+    const char* start = p;
+    p = scan_token(p, end);
+    const KeywordEntry* kw = lookup_keyword(start, p - start);
+    if (kw && kw->id == KeywordId::Semicolon)
+      return start;
+    if (kw && kw->id == KeywordId::Colon)
+      return nullptr;
+  }
+  return nullptr;
+}
 
-      // Remove the LIT instruction from bytecode
-      *current_bc_size -= 5;
+static const V4FrontStackEffect* dict_effect(const void* user, uint32_t index)
+{
+  return &static_cast<const WordDict*>(user)->entries[index].effect;
+}
 
-      // Get the constant name (next token)
-      if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+// Infer the stack effect of the definition just finished. Once context words
+// are called, CALL operands no longer tell local words apart from them, so
+// every call leaves the effect unknown.
+static FrontErr infer_definition_effect(CompileState* st)
+{
+  WordDefEntry* word = &st->dict.entries[st->dict.count - 1];
+  uint32_t callees = st->calls_ctx_words ? 0 : static_cast<uint32_t>(st->dict.count - 1);
+  return infer_stack_effect(&st->arena, word->code, word->code_len, dict_effect,
+                            &st->dict, callees, &word->effect);
+}
 
-      if (!*p)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::ConstantWithoutName);
-      }
+static const uint8_t* dict_code(const void* user, uint32_t index, uint32_t* len)
+{
+  const WordDefEntry* word = &static_cast<const WordDict*>(user)->entries[index];
+  *len = word->code_len;
+  return word->evaluable ? word->code : nullptr;
+}
 
-      const char* name_start = p;
-      while (*p && !isspace((unsigned char)*p))
-        p++;
-      size_t name_len = p - name_start;
+// Decide whether V4FRONT_OPT_EVAL may run the definition just finished. As for
+// stack effects, calls cannot be told apart once context words are called.
+static void mark_evaluable(CompileState* st)
+{
+  WordDefEntry* word = &st->dict.entries[st->dict.count - 1];
+  uint32_t self = static_cast<uint32_t>(st->dict.count - 1);
+  uint32_t callees = st->calls_ctx_words ? 0 : static_cast<uint32_t>(st->dict.count);
+  word->evaluable =
+      evaluable_code(word->code, word->code_len, self, dict_code, &st->dict, callees);
+}
 
-      if (name_len == 0 || name_len >= MAX_WORD_NAME_LEN)
-      {
-        if (error_pos)
-          *error_pos = name_start;
-        CLEANUP_AND_RETURN(FrontErr::ConstantWithoutName);
-      }
+// Run CALL word_idx at compile time on the known constants under it and put its
+// results in place of the constants it consumed. *done is false if the call has
+// to be compiled after all (the run stopped, or left more than MAX_FOLD_DEPTH
+// results).
+static FrontErr eval_word_call(CompileState* st, int word_idx, int known_consts,
+                               bool* done)
+{
+  *done = false;
+  ConstTail& consts = st->consts;
+  EvalStack stack;
+  stack.depth = known_consts;
+  for (int i = 0; i < known_consts; i++)
+    stack.cells[i] = consts.entries[i].value;
+  if (!eval_call(static_cast<uint32_t>(word_idx), dict_code, &st->dict,
+                 static_cast<uint32_t>(st->dict.count), MAX_EVAL_STEPS, &stack) ||
+      stack.depth - stack.low > MAX_FOLD_DEPTH)
+    return FrontErr::OK;
+
+  const bool compact = (st->flags & V4FRONT_OPT_COMPACT_LITERALS) != 0;
+  CodeBuf* bc = st->current_bc;
+  if (stack.low < known_consts)
+    bc->size = consts.entries[stack.low].start;
+  consts.count = stack.low;
+  for (int i = stack.low; i < stack.depth; i++)
+  {
+    consts.push(bc->size, stack.cells[i]);
+    FrontErr err = emit_literal(bc, stack.cells[i], compact);
+    if (err != FrontErr::OK)
+      return err;
+  }
+  *done = true;
+  return FrontErr::OK;
+}
+
+// A call reaches a yield point if it names a word of this compilation that
+// contains one. Once context words are called, operands no longer tell the two
+// apart, and calls count as not yielding (a yield too many is harmless).
+static bool dict_yields(const void* user, uint32_t operand)
+{
+  const CompileState* st = static_cast<const CompileState*>(user);
+  return !st->calls_ctx_words && operand < static_cast<uint32_t>(st->dict.count) &&
+         st->dict.entries[operand].yields;
+}
+
+// Instructions of an auto-yield counter update and the back-edge, which every
+// iteration that does not yield runs
+static const uint32_t kYieldCounterInsns = 11;
+
+// V4FRONT_OPT_AUTO_YIELD, called before the back-edge of a BEGIN loop whose
+// body starts at begin. A body without a yield point gets a TASK_YIELD; one
+// shorter than yield_budget instructions adds its length to a counter cell
+// instead and yields when the budget is used up:
+//   LIT cell @ LIT len + DUP LIT budget U< JNZ keep
+//   DROP LIT 0 YIELD keep: LIT cell !
+// (JNZ lands on the store, not on the back-edge, so jump threading cannot
+// turn it into a back-edge that skips the yield)
+static FrontErr emit_auto_yield(CompileState* st, uint32_t begin)
+{
+  CodeBuf* bc = st->current_bc;
+  uint32_t insns = 0;
+  bool ok = true;
+  if (range_yields(bc->data, begin, bc->size, dict_yields, st, &insns, &ok) || !ok)
+    return FrontErr::OK;
+  const uint8_t yield = static_cast<uint8_t>(v4::Op::TASK_YIELD);
+  uint32_t per_iter = insns + kYieldCounterInsns;
+  if (per_iter >= st->yield_budget)
+    return append_byte(bc, yield);
+
+  FrontErr err = FrontErr::OK;
+  if (!st->yield_cell && (err = st->data_space.allot(4, &st->yield_cell)) != FrontErr::OK)
+    return err;
+  const bool compact = (st->flags & V4FRONT_OPT_COMPACT_LITERALS) != 0;
+  const int32_t cell = static_cast<int32_t>(st->yield_cell);
+  auto op = [&](v4::Op o)
+  {
+    if (err == FrontErr::OK)
+      err = append_byte(bc, static_cast<uint8_t>(o));
+  };
+  auto lit = [&](int32_t v)
+  {
+    if (err == FrontErr::OK)
+      err = emit_literal(bc, v, compact);
+  };
+  lit(cell);
+  op(v4::Op::LOAD);
+  lit(static_cast<int32_t>(per_iter));
+  op(v4::Op::ADD);
+  op(v4::Op::DUP);
+  lit(static_cast<int32_t>(st->yield_budget));
+  op(v4::Op::LTU);
+  op(v4::Op::JNZ);
+  uint32_t patch = bc->size;
+  if (err == FrontErr::OK)
+    err = append_i16_le(bc, 0);
+  op(v4::Op::DROP);
+  lit(0);
+  op(v4::Op::TASK_YIELD);
+  if (err == FrontErr::OK)
+    backpatch_i16_le(bc->data, patch, static_cast<int16_t>(bc->size - (patch + 2)));
+  lit(cell);
+  op(v4::Op::STORE);
+  return err;
+}
+
+// Called after the name of a definition: either replay the definition from
+// the cache (*p then points after its ;) or start recording its lookups
+static FrontErr begin_cached_definition(CompileState* st, const char** p,
+                                        const char* end)
+{
+  st->def_cacheable = false;
+  const char* semicolon =
+      (st->control_depth == 0) ? find_definition_end(*p, end) : nullptr;
+  if (!semicolon)
+    return FrontErr::OK;
+
+  CacheKey key = {st->current_word_name,
+                  static_cast<uint32_t>(strlen(st->current_word_name)),
+                  *p,
+                  static_cast<uint32_t>(semicolon - *p),
+                  st->flags,
+                  st->inline_max_size,
+                  st->dict.count};
+  CachedWord* cached = st->cache->find(key);
+  bool calls_ctx = false;
+  for (uint32_t i = 0; cached && i < cached->dep_count; i++)
+  {
+    const CacheDep& dep = cached->deps[i];
+    CacheDep now = resolve_dep(st, cached->body + dep.offset, dep.len);
+    if (now.kind != dep.kind || now.target != dep.target ||
+        now.fingerprint != dep.fingerprint)
+      cached = nullptr;
+    else if (dep.kind == CacheDepKind::Context)
+      calls_ctx = true;
+  }
+
+  if (!cached)
+  {
+    st->def_cacheable = true;
+    st->def_body = *p;
+    st->dep_count = 0;
+    return FrontErr::OK;
+  }
+
+  // Same text, options and lookups: same code. Finish the definition as ; would.
+  CodeBuf code = {nullptr, 0, 0, &st->arena};
+  FrontErr err = append_bytes(&code, cached->code, cached->code_len);
+  if (err == FrontErr::OK)
+    err = st->dict.add(key.name, key.name_len, code.data, code.size);
+  if (err != FrontErr::OK)
+    return err;
+  st->dict.entries[st->dict.count - 1].cached = cached;
+  cached->generation = st->cache->generation;
+  st->calls_ctx_words |= calls_ctx;
+  st->reused++;
+  if (st->stack_effects && (err = infer_definition_effect(st)) != FrontErr::OK)
+    return err;
+  if (st->flags & V4FRONT_OPT_EVAL)
+    mark_evaluable(st);
+
+  st->in_definition = false;
+  st->current_word_name[0] = '\0';
+  st->current_bc = &st->bc;
+  *p = scan_token(semicolon, end);
+  return FrontErr::OK;
+}
+
+// Called at ; of a definition compiled from source
+static FrontErr end_cached_definition(CompileState* st, const char* semicolon)
+{
+  st->compiled++;
+  if (!st->def_cacheable)
+    return FrontErr::OK;
+  st->def_cacheable = false;
+
+  if (st->pending_count == st->pending_cap)
+  {
+    uint32_t new_cap = st->pending_cap ? st->pending_cap * 2 : 8;
+    PendingWord* grown = static_cast<PendingWord*>(
+        st->arena.grow(st->pending, sizeof(PendingWord) * st->pending_cap,
+                       sizeof(PendingWord) * new_cap));
+    if (!grown)
+      return FrontErr::OutOfMemory;
+    st->pending = grown;
+    st->pending_cap = new_cap;
+  }
+
+  const WordDefEntry* word = &st->dict.entries[st->dict.count - 1];
+  uint32_t body_len = static_cast<uint32_t>(semicolon - st->def_body);
+  char* body = static_cast<char*>(st->arena.alloc(body_len ? body_len : 1));
+  uint8_t* code = static_cast<uint8_t*>(st->arena.alloc(word->code_len));
+  if (!body || !code)
+    return FrontErr::OutOfMemory;
+  memcpy(body, st->def_body, body_len);
+  memcpy(code, word->code, word->code_len);
+
+  PendingWord* pw = &st->pending[st->pending_count++];
+  pw->index = st->dict.count - 1;
+  pw->body = body;
+  pw->body_len = body_len;
+  pw->code = code;
+  pw->code_len = word->code_len;
+  pw->deps = st->deps;
+  pw->dep_count = st->dep_count;
+  st->deps = nullptr;
+  st->dep_count = 0;
+  st->dep_cap = 0;
+  return FrontErr::OK;
+}
+
+// Add the definitions compiled from source to the cache (after the passes, so
+// both forms of the code are known)
+static void store_cached_definitions(CompileState* st)
+{
+  WordCache* cache = st->cache;
+  for (uint32_t i = 0; i < st->pending_count; i++)
+  {
+    const PendingWord& pw = st->pending[i];
+    const WordDefEntry* word = &st->dict.entries[pw.index];
+    CacheKey key = {word->name,       static_cast<uint32_t>(strlen(word->name)),
+                    pw.body,          pw.body_len,
+                    st->flags,        st->inline_max_size,
+                    pw.index};
+    // Best effort: a definition that does not fit is simply compiled next time
+    cache->insert(key, pw.deps, pw.dep_count, pw.code, pw.code_len, word->code,
+                  word->code_len);
+  }
+  cache->trim();
+}
+
+// Helper macro for cleanup on error (a compilation that collects its errors
+// keeps the arena: it goes on after recover_after_error())
+#define CLEANUP_AND_RETURN(error_code) \
+  do                                   \
+  {                                    \
+    if (!st->errors)                   \
+      arena.release();                 \
+    return (error_code);               \
+  } while (0)
+
+// Compile every token of source[0, end) into st, from st->resume if set. On
+// error the arena is released and st must not be used again, unless
+// st->errors collects the errors.
+static FrontErr compile_tokens(CompileState* st, const char* source, const char* end,
+                               const char** error_pos)
+{
+  const uint32_t flags = st->flags;
+  const bool compact_literals = (flags & V4FRONT_OPT_COMPACT_LITERALS) != 0;
+  const bool fold_constants = (flags & V4FRONT_OPT_CONSTANT_FOLD) != 0;
+  const bool inline_words = (flags & V4FRONT_OPT_INLINE) != 0;
+  const bool tail_calls = (flags & V4FRONT_OPT_TAIL_CALLS) != 0;
+  const bool loop_locals = (flags & V4FRONT_OPT_LOOP_LOCALS) != 0;
+  const bool counted_loops = (flags & V4FRONT_OPT_COUNTED_LOOPS) != 0;
+  const bool eval_words = (flags & V4FRONT_OPT_EVAL) != 0;
+  const bool auto_yield = (flags & V4FRONT_OPT_AUTO_YIELD) != 0;
+  const uint32_t inline_max_size = st->inline_max_size;
+  V4FrontContext* ctx = st->ctx;
+
+  Arena& arena = st->arena;
+  CodeBuf& bc = st->bc;
+  ControlFrame*& control_stack = st->control_stack;
+  int& control_depth = st->control_depth;
+  int& control_cap = st->control_cap;
+  WordDict& dict = st->dict;
+  bool& in_definition = st->in_definition;
+  char* current_word_name = st->current_word_name;
+  CodeBuf& word_bc = st->word_bc;
+  int& loop_base = st->loop_base;
+  bool& calls_ctx_words = st->calls_ctx_words;
+  uint32_t*& recurse_sites = st->recurse_sites;
+  int& recurse_count = st->recurse_count;
+  int& recurse_cap = st->recurse_cap;
+  DataSpace& data_space = st->data_space;
+  CodeBuf*& current_bc = st->current_bc;
+  ConstTail& consts = st->consts;
+  FrontErr err = FrontErr::OK;
+
+  if (!source)
+    return FrontErr::OK;
+
+  // Tokenization and code generation
+  const char* p = st->resume ? st->resume : source;
+  if (st->source_map && !st->resume)
+    st->map.cursor = source;  // map.pos is where source starts
+
+  while (p < end)
+  {
+    // Skip whitespace and comments, then extract the token (a view into the
+    // source; it is not NUL-terminated). A cached token lexed from p saves both.
+    STATS_PHASE(st, StatsTokenize);
+    const LexToken* lexed = st->lex.base == source
+                                ? st->lex.at(static_cast<uint32_t>(p - source))
+                                : nullptr;
+    const char* token_start;
+    size_t token_len;
+    uint32_t symbol;
+    if (lexed)
+    {
+      token_start = source + lexed->offset;
+      token_len = lexed->len;
+      symbol = lexed->symbol;
+      p = token_start + token_len;
+    }
+    else
+    {
+      if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+        CLEANUP_AND_RETURN(err);
+      if (p == end)
+        break;
+      token_start = p;
+      p = scan_token(p, end);
+      token_len = p - token_start;
+      symbol = hash_ci(token_start, token_len);
+    }
+    STATS_COUNT(st, tokens);
+    STATS_PHASE(st, StatsKeyword);
+    if (st->source_map &&
+        (err = source_map_record(&arena, &st->map, in_definition ? kDefinitionUnit : -1,
+                                 current_bc->size, token_start)) != FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
 
-      char const_name[MAX_WORD_NAME_LEN];
-      memcpy(const_name, name_start, name_len);
-      const_name[name_len] = '\0';
+    // Known constants only survive an unbroken run of literal-producing tokens;
+    // anything else (including BEGIN/THEN, which only record addresses) ends it
+    int known_consts = consts.count;
+    consts.count = 0;
 
-      // Check for duplicate word names
-      for (int i = 0; i < word_count; i++)
+    // Classify the token once; every later dispatch step switches on this entry
+    const KeywordEntry* kw = lookup_keyword(token_start, token_len, symbol);
+    STATS_PHASE(st, stats_backpatches(kw) ? StatsBackpatch : StatsEmit);
+
+    // Reserved keywords (definitions, control flow, local access) take precedence
+    // over the dictionary
+    switch (kw ? kw->id : KeywordId::None)
+    {
+      case KeywordId::Colon:
+      {
+        // : (colon) - start word definition
+        if ((err = handle_colon_start(&p, end, &in_definition, current_word_name,
+                                      &word_bc, &current_bc, &dict, error_pos)) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        recurse_count = 0;
+        st->colon_depth = control_depth;
+        if (st->cache && (err = begin_cached_definition(st, &p, end)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if (!in_definition)
+          continue;  // Reused from the cache
+        loop_base = loop_locals ? loop_slot_base(p, end) : -1;
+        continue;
+      }
+      case KeywordId::Semicolon:
       {
-        if (str_eq_ci(word_dict[i].name, const_name))
+        // ; (semicolon) - end word definition
+        if ((err = handle_semicolon_end(&in_definition, current_word_name, &word_bc,
+                                        &current_bc, &bc, &dict, error_pos,
+                                        token_start)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if (tail_calls && recurse_count > 0)
+        {
+          WordDefEntry* word = &dict.entries[dict.count - 1];
+          lower_tail_recursion(word->code, word->code_len, recurse_sites, recurse_count);
+        }
+        if (st->stack_effects && (err = infer_definition_effect(st)) != FrontErr::OK)
         {
           if (error_pos)
-            *error_pos = name_start;
-          CLEANUP_AND_RETURN(FrontErr::DuplicateWord);
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(err);
+        }
+        if (eval_words)
+          mark_evaluable(st);
+        if (auto_yield)
+        {
+          WordDefEntry* word = &dict.entries[dict.count - 1];
+          bool ok = true;
+          word->yields =
+              range_yields(word->code, 0, word->code_len, dict_yields, st, nullptr, &ok);
         }
+        if (st->source_map)
+          source_map_end_definition(&st->map, dict.count - 1);
+        if (st->cache && (err = end_cached_definition(st, token_start)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        loop_base = -1;
+        continue;
       }
 
-      // Check dictionary full
-      if (word_count >= MAX_WORDS)
+      // Check for control flow keywords
+      case KeywordId::Begin:
       {
-        if (error_pos)
-          *error_pos = name_start;
-        CLEANUP_AND_RETURN(FrontErr::DictionaryFull);
+        // BEGIN: mark the current position for backward jump
+        if (control_depth >= MAX_CONTROL_DEPTH)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ControlDepthExceeded);
+        }
+        if ((err = reserve_control_frame(&arena, &control_stack, &control_cap,
+                                         control_depth)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Push control frame with BEGIN position
+        control_stack[control_depth].type = BEGIN_CONTROL;
+        control_stack[control_depth].begin_addr = current_bc->size;
+        control_stack[control_depth].has_while = false;
+        control_depth++;
+        continue;
       }
+      case KeywordId::Do:
+      {
+        // DO: ( limit index -- R: -- limit index )
+        // Emit: SWAP >R >R
+        if (control_depth >= MAX_CONTROL_DEPTH)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ControlDepthExceeded);
+        }
+        if ((err = reserve_control_frame(&arena, &control_stack, &control_cap,
+                                         control_depth)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
 
-      // Create bytecode for the constant: LIT <value> ; RET
-      uint8_t* const_bc = nullptr;
-      uint32_t const_bc_size = 0;
-      uint32_t const_bc_cap = 0;
+        int loop_slot = -1;
+        if (loop_base >= 0)
+        {
+          // Two slots per enclosing DO level, above the word's own locals
+          int outer = 0;
+          while (enclosing_loop_slot(control_stack, control_depth, outer) >= 0)
+            outer++;
+          loop_slot = loop_base + 2 * outer;
+        }
 
-      // Emit LIT
-      if ((err = append_byte(&const_bc, &const_bc_size, &const_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT))) != FrontErr::OK)
-      {
-        free(const_bc);
-        CLEANUP_AND_RETURN(err);
-      }
+        // Counted loop: literal bounds become a single down-counter
+        //   limit start DO -> LIT (limit - start) >R
+        ControlFrame* frame = &control_stack[control_depth];
+        frame->counted = false;
+        if (counted_loops && loop_slot < 0 && known_consts >= 2)
+        {
+          int32_t limit = consts.entries[known_consts - 2].value;
+          int32_t start = consts.entries[known_consts - 1].value;
+          int64_t trips = static_cast<int64_t>(limit) - start;
+          bool* unrollable = &frame->unrollable;
+          if (trips > 0 && trips <= INT32_MAX && scan_counted_loop(p, end, unrollable))
+          {
+            frame->counted = true;
+            frame->limit = limit;
+            frame->trip_count = static_cast<uint32_t>(trips);
+            frame->counted_addr = consts.entries[known_consts - 2].start;
+            current_bc->size = frame->counted_addr;
+            if ((err = emit_literal(current_bc, static_cast<int32_t>(trips),
+                                    compact_literals)) != FrontErr::OK ||
+                (err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+                    FrontErr::OK)
+              CLEANUP_AND_RETURN(err);
+          }
+        }
 
-      // Emit value
-      if ((err = append_i32_le(&const_bc, &const_bc_size, &const_bc_cap, const_value)) !=
-          FrontErr::OK)
-      {
-        free(const_bc);
-        CLEANUP_AND_RETURN(err);
-      }
+        if (!frame->counted && loop_slot >= 0)
+        {
+          // L! index L! limit
+          if ((err = emit_local_op(current_bc, v4::Op::LSET, loop_slot)) !=
+                  FrontErr::OK ||
+              (err = emit_local_op(current_bc, v4::Op::LSET, loop_slot + 1)) !=
+                  FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+        }
+        else if (!frame->counted)
+        {
+          // SWAP: swap limit and index
+          if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+              FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+
+          // >R: push limit to return stack
+          if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+              FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+
+          // >R: push index to return stack
+          if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+              FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+        }
 
-      // Emit RET
-      if ((err = append_byte(&const_bc, &const_bc_size, &const_bc_cap,
-                             static_cast<uint8_t>(v4::Op::RET))) != FrontErr::OK)
-      {
-        free(const_bc);
-        CLEANUP_AND_RETURN(err);
+        // Save loop start position
+        frame->loop_slot = loop_slot;
+        frame->type = DO_CONTROL;
+        frame->do_addr = current_bc->size;
+        frame->leave_count = 0;
+        control_depth++;
+        continue;
       }
+      case KeywordId::Until:
+      {
+        // UNTIL: emit JZ with backward offset to BEGIN
+        if (control_depth <= 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::UntilWithoutBegin);
+        }
 
-      // Add to word dictionary
-      memcpy(word_dict[word_count].name, const_name, name_len + 1);
-      word_dict[word_count].code = const_bc;
-      word_dict[word_count].code_len = const_bc_size;
-      word_count++;
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != BEGIN_CONTROL)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::UntilWithoutBegin);
+        }
+        if (frame->has_while)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::UntilAfterWhile);
+        }
 
-      continue;
-    }
-    else if (str_eq_ci(token, "VARIABLE"))
-    {
-      // VARIABLE: VARIABLE <name>
-      // Allocates 4 bytes from data space, creates a word that returns the address
+        if (auto_yield && (err = emit_auto_yield(st, frame->begin_addr)) != FrontErr::OK)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(err);
+        }
 
-      // Get the variable name (next token)
-      if ((err = skip_whitespace_and_comments(&p, error_pos)) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+        // Emit JZ opcode
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
 
-      if (!*p)
-      {
-        if (error_pos)
-          *error_pos = token_start;
-        CLEANUP_AND_RETURN(FrontErr::VariableWithoutName);
-      }
+        // Calculate backward offset: target - (current + 2)
+        uint32_t jz_next_ip = current_bc->size + 2;
+        int16_t offset = (int16_t)(frame->begin_addr - jz_next_ip);
 
-      const char* name_start = p;
-      while (*p && !isspace((unsigned char)*p))
-        p++;
-      size_t name_len = p - name_start;
+        if ((err = append_i16_le(current_bc, offset)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
 
-      if (name_len == 0 || name_len >= MAX_WORD_NAME_LEN)
-      {
-        if (error_pos)
-          *error_pos = name_start;
-        CLEANUP_AND_RETURN(FrontErr::VariableWithoutName);
+        // Pop control frame
+        control_depth--;
+        continue;
       }
-
-      char var_name[MAX_WORD_NAME_LEN];
-      memcpy(var_name, name_start, name_len);
-      var_name[name_len] = '\0';
-
-      // Check for duplicate word names
-      for (int i = 0; i < word_count; i++)
+      case KeywordId::While:
       {
-        if (str_eq_ci(word_dict[i].name, var_name))
+        // WHILE: emit JZ with placeholder offset (forward jump to after REPEAT)
+        if (control_depth <= 0)
         {
           if (error_pos)
-            *error_pos = name_start;
-          CLEANUP_AND_RETURN(FrontErr::DuplicateWord);
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::WhileWithoutBegin);
         }
-      }
 
-      // Check dictionary full
-      if (word_count >= MAX_WORDS)
-      {
-        if (error_pos)
-          *error_pos = name_start;
-        CLEANUP_AND_RETURN(FrontErr::DictionaryFull);
-      }
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != BEGIN_CONTROL)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::WhileWithoutBegin);
+        }
+        if (frame->has_while)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::DuplicateWhile);
+        }
 
-      // Allocate 4 bytes from data space
-      uint32_t var_addr;
-      if ((err = data_space.allot(4, &var_addr)) != FrontErr::OK)
-      {
-        if (error_pos)
-          *error_pos = name_start;
-        CLEANUP_AND_RETURN(err);
-      }
+        // Emit JZ opcode
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
 
-      // Create bytecode for the variable: LIT <address> ; RET
-      uint8_t* var_bc = nullptr;
-      uint32_t var_bc_size = 0;
-      uint32_t var_bc_cap = 0;
+        // Save position for backpatching and emit placeholder
+        uint32_t patch_pos = current_bc->size;
+        if ((err = append_i16_le(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
 
-      // Emit LIT
-      if ((err = append_byte(&var_bc, &var_bc_size, &var_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT))) != FrontErr::OK)
-      {
-        free(var_bc);
-        CLEANUP_AND_RETURN(err);
+        // Update control frame
+        frame->while_patch_addr = patch_pos;
+        frame->has_while = true;
+        continue;
       }
-
-      // Emit address
-      if ((err = append_i32_le(&var_bc, &var_bc_size, &var_bc_cap,
-                               static_cast<int32_t>(var_addr))) != FrontErr::OK)
+      case KeywordId::Repeat:
       {
-        free(var_bc);
-        CLEANUP_AND_RETURN(err);
-      }
+        // REPEAT: emit JMP to BEGIN, backpatch WHILE's JZ
+        if (control_depth <= 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::RepeatWithoutBegin);
+        }
 
-      // Emit RET
-      if ((err = append_byte(&var_bc, &var_bc_size, &var_bc_cap,
-                             static_cast<uint8_t>(v4::Op::RET))) != FrontErr::OK)
-      {
-        free(var_bc);
-        CLEANUP_AND_RETURN(err);
-      }
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != BEGIN_CONTROL)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::RepeatWithoutBegin);
+        }
+        if (!frame->has_while)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::RepeatWithoutWhile);
+        }
+
+        if (auto_yield && (err = emit_auto_yield(st, frame->begin_addr)) != FrontErr::OK)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(err);
+        }
 
-      // Add to word dictionary
-      memcpy(word_dict[word_count].name, var_name, name_len + 1);
-      word_dict[word_count].code = var_bc;
-      word_dict[word_count].code_len = var_bc_size;
-      word_count++;
+        // Emit JMP opcode
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
 
-      continue;
-    }
+        // Calculate backward offset to BEGIN
+        uint32_t jmp_next_ip = current_bc->size + 2;
+        int16_t jmp_offset = (int16_t)(frame->begin_addr - jmp_next_ip);
 
-    // Try looking up word in dictionary
-    {
-      int word_idx = -1;
+        if ((err = append_i16_le(current_bc, jmp_offset)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
 
-      // First, search in local word_dict (words defined in this compilation)
-      for (int i = 0; i < word_count; i++)
+        // Backpatch WHILE's JZ to jump to current position
+        int16_t jz_offset = (int16_t)(current_bc->size - (frame->while_patch_addr + 2));
+        backpatch_i16_le(current_bc->data, frame->while_patch_addr, jz_offset);
+
+        // Pop control frame
+        control_depth--;
+        continue;
+      }
+      case KeywordId::Again:
       {
-        if (str_eq_ci(token, word_dict[i].name))
+        // AGAIN: emit JMP with backward offset to BEGIN (infinite loop)
+        if (control_depth <= 0)
         {
-          word_idx = i;
-          break;
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::AgainWithoutBegin);
         }
-      }
 
-      // If not found locally, search in context (words from previous compilations)
-      if (word_idx < 0 && ctx)
-      {
-        int vm_idx = v4front_context_find_word(ctx, token);
-        if (vm_idx >= 0)
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != BEGIN_CONTROL)
         {
-          word_idx = vm_idx;
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::AgainWithoutBegin);
+        }
+        if (frame->has_while)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::AgainAfterWhile);
         }
-      }
 
-      if (word_idx >= 0)
-      {
-        // Found a word - emit CALL instruction
-        if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                               static_cast<uint8_t>(v4::Op::CALL))) != FrontErr::OK)
+        if (auto_yield && (err = emit_auto_yield(st, frame->begin_addr)) != FrontErr::OK)
+        {
+          if (error_pos)
+            *error_pos = token_start;
           CLEANUP_AND_RETURN(err);
+        }
 
-        // Emit 16-bit word index (little-endian)
-        // If found in context, use VM word index directly
-        // If found locally, use local index (will be adjusted when registered to VM)
-        if ((err = append_i16_le(current_bc, current_bc_size, current_bc_cap,
-                                 static_cast<int16_t>(word_idx))) != FrontErr::OK)
+        // Emit JMP opcode
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
           CLEANUP_AND_RETURN(err);
 
+        // Calculate backward offset: target - (current + 2)
+        uint32_t jmp_next_ip = current_bc->size + 2;
+        int16_t offset = (int16_t)(frame->begin_addr - jmp_next_ip);
+
+        if ((err = append_i16_le(current_bc, offset)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Pop control frame
+        control_depth--;
         continue;
       }
-    }
-
-    // Try parsing as integer
-    int32_t val;
-    if (try_parse_int(token, &val))
-    {
-      // Emit: [LIT] [imm32_le]
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_i32_le(current_bc, current_bc_size, current_bc_cap, val)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
-    }
+      case KeywordId::Leave:
+      {
+        // LEAVE: exit the current DO loop early
+        // Emit: R> R> DROP DROP JMP [forward]
+        if (control_depth <= 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::LeaveWithoutDo);
+        }
 
-    // Special handling for J and K (multi-instruction sequences)
-    if (str_eq_ci(token, "J"))
-    {
-      if ((err = emit_j_instruction(current_bc, current_bc_size, current_bc_cap)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
-    }
-    else if (str_eq_ci(token, "K"))
-    {
-      if ((err = emit_k_instruction(current_bc, current_bc_size, current_bc_cap)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
-    }
-    // Composite words (expanded to multiple opcodes)
-    else if (str_eq_ci(token, "ROT"))
-    {
-      // ROT ( a b c -- b c a ): >R SWAP R> SWAP
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
-    }
-    else if (str_eq_ci(token, "NIP"))
-    {
-      // NIP ( a b -- b ): SWAP DROP
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
-    }
-    else if (str_eq_ci(token, "TUCK"))
-    {
-      // TUCK ( a b -- b a b ): SWAP OVER
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
-    }
-    else if (str_eq_ci(token, "NEGATE"))
-    {
-      // NEGATE ( n -- -n ): 0 SWAP -
-      // Emit: LIT 0, SWAP, SUB
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT0))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SUB))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+        // Find the innermost DO control frame
+        int do_frame_idx = -1;
+        for (int i = control_depth - 1; i >= 0; i--)
+        {
+          if (control_stack[i].type == DO_CONTROL)
+          {
+            do_frame_idx = i;
+            break;
+          }
+        }
+
+        if (do_frame_idx < 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::LeaveWithoutDo);
+        }
+
+        ControlFrame* frame = &control_stack[do_frame_idx];
+
+        // Check if we have space for another LEAVE
+        if (frame->leave_count >= MAX_LEAVE_DEPTH)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::LeaveDepthExceeded);
+        }
+
+        // Loop parameters in locals need no cleanup
+        if (frame->loop_slot < 0)
+        {
+          // R>: pop index from return stack
+          if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+              FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+
+          // R>: pop limit from return stack
+          if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+              FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+
+          // DROP: discard index
+          if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+              FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+
+          // DROP: discard limit
+          if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+              FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+        }
+
+        // JMP: jump to loop exit (to be backpatched)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Save patch position and emit placeholder
+        uint32_t patch_pos = current_bc->size;
+        if ((err = append_i16_le(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Record this LEAVE for backpatching
+        frame->leave_patch_addrs[frame->leave_count] = patch_pos;
+        frame->leave_count++;
+
+        continue;
+      }
+      case KeywordId::Loop:
+      {
+        // LOOP: increment index and loop if index < limit
+        // Emit: R> 1+ R> OVER OVER < JZ [forward] >R >R JMP [backward] [target] DROP DROP
+        if (control_depth <= 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::LoopWithoutDo);
+        }
+
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != DO_CONTROL)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::LoopWithoutDo);
+        }
+
+        if (frame->counted)
+        {
+          if ((err = emit_counted_loop_end(current_bc, frame)) != FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+          control_depth--;
+          continue;
+        }
+        if (frame->loop_slot >= 0)
+        {
+          if ((err = emit_local_loop_end(current_bc, frame, false)) != FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+          control_depth--;
+          continue;
+        }
+
+        // R>: pop index from return stack
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // LIT 1
+        if ((err = emit_literal(current_bc, 1, compact_literals)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // ADD: increment index
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::ADD))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // R>: pop limit from return stack
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // OVER OVER: ( index limit -- index limit index limit )
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // LT: compare index < limit
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LT))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // JZ: jump forward if done (exit loop)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        uint32_t jz_patch_pos = current_bc->size;
+        if ((err = append_i16_le(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // >R >R: push limit, then index, back to the return stack
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // JMP: jump backward to loop start
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        uint32_t jmp_next_ip = current_bc->size + 2;
+        int16_t jmp_offset = (int16_t)(frame->do_addr - jmp_next_ip);
+
+        if ((err = append_i16_le(current_bc, jmp_offset)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Backpatch JZ to exit point
+        int16_t jz_offset = (int16_t)(current_bc->size - (jz_patch_pos + 2));
+        backpatch_i16_le(current_bc->data, jz_patch_pos, jz_offset);
+
+        // DROP DROP: clean up index and limit
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Backpatch all LEAVE jumps to exit point (current position)
+        for (int i = 0; i < frame->leave_count; i++)
+        {
+          int16_t leave_offset =
+              (int16_t)(current_bc->size - (frame->leave_patch_addrs[i] + 2));
+          backpatch_i16_le(current_bc->data, frame->leave_patch_addrs[i], leave_offset);
+        }
+
+        control_depth--;
+        continue;
+      }
+      case KeywordId::PlusLoop:
+      {
+        // +LOOP: add n to index and loop if still in range
+        // Similar to LOOP but uses the value on stack instead of 1
+        if (control_depth <= 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::PLoopWithoutDo);
+        }
+
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != DO_CONTROL)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::PLoopWithoutDo);
+        }
+
+        if (frame->loop_slot >= 0)
+        {
+          if ((err = emit_local_loop_end(current_bc, frame, true)) != FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+          control_depth--;
+          continue;
+        }
+
+        // R>: pop index
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // ADD: add increment value to index
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::ADD))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // R>: pop limit
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // OVER OVER: duplicate for comparison
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // LT: compare
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LT))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // JZ: exit if done
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        uint32_t jz_patch_pos = current_bc->size;
+        if ((err = append_i16_le(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // >R >R: push back (limit, then index)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // JMP: loop back
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        uint32_t jmp_next_ip = current_bc->size + 2;
+        int16_t jmp_offset = (int16_t)(frame->do_addr - jmp_next_ip);
+
+        if ((err = append_i16_le(current_bc, jmp_offset)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Backpatch JZ
+        int16_t jz_offset = (int16_t)(current_bc->size - (jz_patch_pos + 2));
+        backpatch_i16_le(current_bc->data, jz_patch_pos, jz_offset);
+
+        // DROP DROP: cleanup
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Backpatch all LEAVE jumps to exit point (current position)
+        for (int i = 0; i < frame->leave_count; i++)
+        {
+          int16_t leave_offset =
+              (int16_t)(current_bc->size - (frame->leave_patch_addrs[i] + 2));
+          backpatch_i16_le(current_bc->data, frame->leave_patch_addrs[i], leave_offset);
+        }
+
+        control_depth--;
+        continue;
+      }
+      case KeywordId::If:
+      {
+        // IF: emit JZ with placeholder offset, push to control stack
+        if (control_depth >= MAX_CONTROL_DEPTH)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ControlDepthExceeded);
+        }
+        if ((err = reserve_control_frame(&arena, &control_stack, &control_cap,
+                                         control_depth)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Emit JZ opcode
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Save position for backpatching and emit placeholder
+        uint32_t patch_pos = current_bc->size;
+        if ((err = append_i16_le(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Push control frame
+        control_stack[control_depth].type = IF_CONTROL;
+        control_stack[control_depth].jz_patch_addr = patch_pos;
+        control_stack[control_depth].jmp_patch_addr = 0;
+        control_stack[control_depth].has_else = false;
+        control_depth++;
+        continue;
+      }
+      case KeywordId::Else:
+      {
+        // ELSE: emit JMP, then backpatch JZ to jump past the JMP
+        if (control_depth <= 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ElseWithoutIf);
+        }
+
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != IF_CONTROL)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ElseWithoutIf);
+        }
+        if (frame->has_else)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::DuplicateElse);
+        }
+
+        // Emit JMP with placeholder (to skip ELSE clause)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        uint32_t jmp_patch_pos = current_bc->size;
+        if ((err = append_i16_le(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Now backpatch JZ to jump to current position (start of ELSE clause)
+        // offset = current_pos - (jz_patch_addr + 2)
+        int16_t jz_offset = (int16_t)(current_bc->size - (frame->jz_patch_addr + 2));
+        backpatch_i16_le(current_bc->data, frame->jz_patch_addr, jz_offset);
+
+        // Update control frame
+        frame->jmp_patch_addr = jmp_patch_pos;
+        frame->has_else = true;
+        continue;
+      }
+      case KeywordId::Then:
+      {
+        // THEN: backpatch the last IF or ELSE jump
+        if (control_depth <= 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ThenWithoutIf);
+        }
+
+        ControlFrame* frame = &control_stack[control_depth - 1];
+        if (frame->type != IF_CONTROL)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ThenWithoutIf);
+        }
+
+        control_depth--;
+
+        if (frame->has_else)
+        {
+          // Backpatch the JMP from ELSE
+          int16_t jmp_offset = (int16_t)(current_bc->size - (frame->jmp_patch_addr + 2));
+          backpatch_i16_le(current_bc->data, frame->jmp_patch_addr, jmp_offset);
+        }
+        else
+        {
+          // Backpatch the JZ from IF
+          int16_t jz_offset = (int16_t)(current_bc->size - (frame->jz_patch_addr + 2));
+          backpatch_i16_le(current_bc->data, frame->jz_patch_addr, jz_offset);
+        }
+        continue;
+      }
+      case KeywordId::Exit:
+      {
+        // EXIT: early return from word (emit RET)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::RET))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      // SYS is now handled as a primitive (NoImm) - removed special case handling
+      case KeywordId::Emit:
+      {
+        // EMIT: output one character ( c -- )
+        // Emits: LIT 0x30 + SYS (Forth-style)
+        if ((err = emit_literal(current_bc, 0x30, compact_literals)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Emit SYS opcode
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SYS))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::Key:
+      {
+        // KEY: input one character ( -- c )
+        // Emits: LIT 0x31 + SYS (Forth-style)
+        if ((err = emit_literal(current_bc, 0x31, compact_literals)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Emit SYS opcode
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SYS))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::LocalInc:
+      {
+        // L++: increment local variable (LINC)
+        // Skip whitespace and comments, then get next token (the local variable index)
+        if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        if (p == end)
+        {
+          // No token after L++
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
+        }
+
+        // Extract index token
+        const char* idx_token_start = p;
+        p = scan_token(p, end);
+        size_t idx_token_len = p - idx_token_start;
+
+        // Parse index as integer
+        int32_t local_idx;
+        if (!try_parse_int(idx_token_start, idx_token_len, &local_idx) || local_idx < 0 ||
+            local_idx > 255)
+        {
+          if (error_pos)
+            *error_pos = idx_token_start;
+          CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
+        }
+
+        // Emit: [LINC] [idx8]
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LINC))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(local_idx))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::LocalDec:
+      {
+        // L--: decrement local variable (LDEC)
+        // Skip whitespace and comments, then get next token (the local variable index)
+        if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        if (p == end)
+        {
+          // No token after L--
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
+        }
+
+        // Extract index token
+        const char* idx_token_start = p;
+        p = scan_token(p, end);
+        size_t idx_token_len = p - idx_token_start;
+
+        // Parse index as integer
+        int32_t local_idx;
+        if (!try_parse_int(idx_token_start, idx_token_len, &local_idx) || local_idx < 0 ||
+            local_idx > 255)
+        {
+          if (error_pos)
+            *error_pos = idx_token_start;
+          CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
+        }
+
+        // Emit: [LDEC] [idx8]
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LDEC))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(local_idx))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::LocalGet:
+      {
+        // L@: get local variable (LGET)
+        // Skip whitespace and comments, then get next token (the local variable index)
+        if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        if (p == end)
+        {
+          // No token after L@
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
+        }
+
+        // Extract index token
+        const char* idx_token_start = p;
+        p = scan_token(p, end);
+        size_t idx_token_len = p - idx_token_start;
+
+        // Parse index as integer
+        int32_t local_idx;
+        if (!try_parse_int(idx_token_start, idx_token_len, &local_idx) || local_idx < 0 ||
+            local_idx > 255)
+        {
+          if (error_pos)
+            *error_pos = idx_token_start;
+          CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
+        }
+
+        // Emit: [LGET] [idx8]
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LGET))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(local_idx))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::LocalSet:
+      {
+        // L!: set local variable (LSET)
+        // Skip whitespace and comments, then get next token (the local variable index)
+        if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        if (p == end)
+        {
+          // No token after L!
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
+        }
+
+        // Extract index token
+        const char* idx_token_start = p;
+        p = scan_token(p, end);
+        size_t idx_token_len = p - idx_token_start;
+
+        // Parse index as integer
+        int32_t local_idx;
+        if (!try_parse_int(idx_token_start, idx_token_len, &local_idx) || local_idx < 0 ||
+            local_idx > 255)
+        {
+          if (error_pos)
+            *error_pos = idx_token_start;
+          CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
+        }
+
+        // Emit: [LSET] [idx8]
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LSET))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(local_idx))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::LocalTee:
+      {
+        // L>!: tee local variable (LTEE) - store and keep value on stack
+        // Skip whitespace and comments, then get next token (the local variable index)
+        if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        if (p == end)
+        {
+          // No token after L>!
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::MissingLocalIdx);
+        }
+
+        // Extract index token
+        const char* idx_token_start = p;
+        p = scan_token(p, end);
+        size_t idx_token_len = p - idx_token_start;
+
+        // Parse index as integer
+        int32_t local_idx;
+        if (!try_parse_int(idx_token_start, idx_token_len, &local_idx) || local_idx < 0 ||
+            local_idx > 255)
+        {
+          if (error_pos)
+            *error_pos = idx_token_start;
+          CLEANUP_AND_RETURN(FrontErr::InvalidLocalIdx);
+        }
+
+        // Emit: [LTEE] [idx8]
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LTEE))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(local_idx))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::Recurse:
+      {
+        // RECURSE: call the currently-being-defined word recursively
+        if (!in_definition)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::RecurseOutsideWord);
+        }
+
+        // Remember the call site for tail-call lowering at ';'
+        if (tail_calls)
+        {
+          if (recurse_count == recurse_cap)
+          {
+            int new_cap = recurse_cap ? recurse_cap * 2 : 4;
+            uint32_t* grown = static_cast<uint32_t*>(
+                arena.grow(recurse_sites, sizeof(uint32_t) * recurse_cap,
+                           sizeof(uint32_t) * new_cap));
+            if (!grown)
+              CLEANUP_AND_RETURN(FrontErr::OutOfMemory);
+            recurse_sites = grown;
+            recurse_cap = new_cap;
+          }
+          recurse_sites[recurse_count++] = current_bc->size;
+        }
+
+        // Emit CALL to the current word (which will be at index dict.count)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::CALL))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Emit the index as 16-bit little-endian
+        int16_t word_idx = static_cast<int16_t>(dict.count);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(word_idx & 0xFF))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc,
+                               static_cast<uint8_t>((word_idx >> 8) & 0xFF))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
+      case KeywordId::Constant:
+      {
+        // CONSTANT: <value> CONSTANT <name>
+        // Takes the literal emitted for the previous token, creates a word that
+        // returns that value
+        st->def_cacheable = false;  // Changes the dictionary mid-definition
+
+        // The previous token must have produced a known constant (a literal, or
+        // a folded expression when constant folding is enabled)
+        if (known_consts == 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ConstantWithoutValue);
+        }
+
+        int32_t const_value = consts.entries[known_consts - 1].value;
+
+        // Remove the literal instruction from bytecode
+        current_bc->size = consts.entries[known_consts - 1].start;
+
+        // Get the constant name (next token)
+        if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        if (p == end)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::ConstantWithoutName);
+        }
+
+        const char* name_start = p;
+        p = scan_token(p, end);
+        size_t name_len = p - name_start;
+
+        if (name_len == 0 || name_len >= MAX_WORD_NAME_LEN)
+        {
+          if (error_pos)
+            *error_pos = name_start;
+          CLEANUP_AND_RETURN(FrontErr::ConstantWithoutName);
+        }
+
+        char const_name[MAX_WORD_NAME_LEN];
+        memcpy(const_name, name_start, name_len);
+        const_name[name_len] = '\0';
+
+        // Check for duplicate word names
+        if (dict.find(const_name, name_len) >= 0)
+        {
+          if (error_pos)
+            *error_pos = name_start;
+          CLEANUP_AND_RETURN(FrontErr::DuplicateWord);
+        }
+
+        // Check dictionary full
+        if (dict.full())
+        {
+          if (error_pos)
+            *error_pos = name_start;
+          CLEANUP_AND_RETURN(FrontErr::DictionaryFull);
+        }
+
+        // Create bytecode for the constant: LIT <value> ; RET
+        CodeBuf const_bc = {nullptr, 0, 0, &arena};
+
+        // Emit the value
+        if ((err = emit_literal(&const_bc, const_value, compact_literals)) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Emit RET
+        if ((err = append_byte(&const_bc, static_cast<uint8_t>(v4::Op::RET))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Add to word dictionary
+        if ((err = dict.add(const_name, name_len, const_bc.data, const_bc.size)) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        dict.entries[dict.count - 1].is_constant = true;
+        dict.entries[dict.count - 1].const_value = const_value;
+
+        continue;
+      }
+      case KeywordId::Variable:
+      case KeywordId::Create:
+      {
+        // VARIABLE: VARIABLE <name>
+        // Allocates 4 bytes from data space, creates a word that returns the address
+        // CREATE: CREATE <name>
+        // Creates a word that returns HERE without allocating (ALLOT follows)
+        st->def_cacheable = false;  // Changes the dictionary mid-definition
+        const bool create = kw->id == KeywordId::Create;
+
+        // Get the variable name (next token)
+        if ((err = skip_whitespace_and_comments(&p, end, error_pos)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        if (p == end)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::VariableWithoutName);
+        }
+
+        const char* name_start = p;
+        p = scan_token(p, end);
+        size_t name_len = p - name_start;
+
+        if (name_len == 0 || name_len >= MAX_WORD_NAME_LEN)
+        {
+          if (error_pos)
+            *error_pos = name_start;
+          CLEANUP_AND_RETURN(FrontErr::VariableWithoutName);
+        }
+
+        char var_name[MAX_WORD_NAME_LEN];
+        memcpy(var_name, name_start, name_len);
+        var_name[name_len] = '\0';
+
+        // Check for duplicate word names
+        if (dict.find(var_name, name_len) >= 0)
+        {
+          if (error_pos)
+            *error_pos = name_start;
+          CLEANUP_AND_RETURN(FrontErr::DuplicateWord);
+        }
+
+        // Check dictionary full
+        if (dict.full())
+        {
+          if (error_pos)
+            *error_pos = name_start;
+          CLEANUP_AND_RETURN(FrontErr::DictionaryFull);
+        }
+
+        // Allocate 4 bytes from data space (CREATE only takes the address)
+        uint32_t var_addr = data_space.get_here();
+        if (!create && (err = data_space.allot(4, &var_addr)) != FrontErr::OK)
+        {
+          if (error_pos)
+            *error_pos = name_start;
+          CLEANUP_AND_RETURN(err);
+        }
+
+        // Create bytecode for the variable: LIT <address> ; RET
+        CodeBuf var_bc = {nullptr, 0, 0, &arena};
+
+        // Emit the address
+        if ((err = emit_literal(&var_bc, static_cast<int32_t>(var_addr),
+                                compact_literals)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Emit RET
+        if ((err = append_byte(&var_bc, static_cast<uint8_t>(v4::Op::RET))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Add to word dictionary
+        if ((err = dict.add(var_name, name_len, var_bc.data, var_bc.size)) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        dict.entries[dict.count - 1].is_constant = true;
+        dict.entries[dict.count - 1].const_value = static_cast<int32_t>(var_addr);
+
+        continue;
+      }
+      case KeywordId::Allot:
+      case KeywordId::AlignTo:
+      {
+        // ALLOT: <bytes> ALLOT reserves data space (rounded up to a cell)
+        // ALIGN-TO: <align> ALIGN-TO pads HERE to a multiple of align
+        // Both take their operand from the previous token, like CONSTANT
+        st->def_cacheable = false;  // Moves HERE for the rest of the compilation
+        if (known_consts == 0)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(FrontErr::AllotWithoutValue);
+        }
+        uint32_t value = static_cast<uint32_t>(consts.entries[known_consts - 1].value);
+        current_bc->size = consts.entries[known_consts - 1].start;
+
+        uint32_t addr;
+        if (kw->id == KeywordId::Allot)
+          err = data_space.allot(value, &addr);
+        else if (value == 0 || (value & (value - 1)) != 0)
+          err = FrontErr::InvalidAlignment;
+        else
+          err = data_space.align_to(value);
+        if (err != FrontErr::OK)
+        {
+          if (error_pos)
+            *error_pos = token_start;
+          CLEANUP_AND_RETURN(err);
+        }
+        continue;
+      }
+      default:
+        break;
     }
-    else if (str_eq_ci(token, "?DUP"))
+
+    // Try looking up word in dictionary
     {
-      // ?DUP ( x -- 0 | x x ): if x is zero, leave it; if non-zero, duplicate
-      // Bytecode: DUP, DUP, JZ +1 (skip next), DUP
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DUP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DUP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // JZ offset +1 (skip the next DUP instruction, which is 1 byte)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Offset: +1 byte (skip DUP), little-endian int16
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 1)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // The DUP that gets executed if non-zero
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DUP))) != FrontErr::OK)
+      int word_idx = -1;
+
+      // First, search in local dictionary (words defined in this compilation)
+      STATS_PHASE(st, StatsLookup);
+      STATS_COUNT(st, lookups);
+      word_idx = dict.find(token_start, token_len, symbol);
+
+      // The word cache keys the definition on what every lookup found
+      if (st->def_cacheable && (err = record_dep(st, token_start, token_len)) !=
+                                   FrontErr::OK)
         CLEANUP_AND_RETURN(err);
-      continue;
+      STATS_PHASE(st, StatsEmit);
+
+      // With folding or inlining, a CONSTANT/VARIABLE defined in this
+      // compilation is used by value
+      if (word_idx >= 0 && (fold_constants || inline_words) &&
+          dict.entries[word_idx].is_constant)
+      {
+        int32_t value = dict.entries[word_idx].const_value;
+        consts.count = known_consts;
+        consts.push(current_bc->size, value);
+        if ((err = emit_literal(current_bc, value, compact_literals)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+
+      // Words without side effects run now; their results become literals
+      if (word_idx >= 0 && eval_words && dict.entries[word_idx].evaluable)
+      {
+        bool done;
+        if ((err = eval_word_call(st, word_idx, known_consts, &done)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if (done)
+          continue;
+      }
+
+      // Small leaf words are copied into the caller instead of called (a
+      // profile moves the limit for hot and cold words)
+      if (word_idx >= 0 && inline_words)
+      {
+        const WordDefEntry* word = &dict.entries[word_idx];
+        const ProfileIndex* profile;
+        if ((err = profile_index(st, &profile)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        uint32_t limit = profile ? profile->inline_limit(token_start, token_len,
+                                                         inline_max_size)
+                                 : inline_max_size;
+        int body_len = inline_body_len(word, word_idx, limit);
+        if (body_len >= 0)
+        {
+          if ((err = append_bytes(current_bc, word->code, body_len)) != FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+          continue;
+        }
+      }
+
+      // If not found locally, search in context (words from previous compilations)
+      if (word_idx < 0 && ctx)
+      {
+        STATS_PHASE(st, StatsLookup);
+        STATS_COUNT(st, lookups);
+        const ContextWords* cw = ctx->words;
+        const WordIndex::Slot* slot = cw->index.find(token_start, token_len, symbol);
+        STATS_PHASE(st, StatsEmit);
+        if (slot && cw->words[slot->value].vm_word_idx >= 0)
+        {
+          // Placeholders must stay below 32768
+          if ((flags & V4FRONT_OPT_RELOCS) && slot->value >= kImportBase)
+            CLEANUP_AND_RETURN(FrontErr::DictionaryFull);
+          word_idx = ctx_call_operand(st, slot->value);
+          calls_ctx_words = true;
+        }
+      }
+
+      if (word_idx >= 0)
+      {
+        // Found a word - emit CALL instruction
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::CALL))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        // Emit 16-bit word index (little-endian)
+        // If found in context, use VM word index directly
+        // If found locally, use local index (will be adjusted when registered to VM)
+        if ((err = append_i16_le(current_bc, static_cast<int16_t>(word_idx))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+
+        continue;
+      }
     }
-    else if (str_eq_ci(token, "ABS"))
-    {
-      // ABS ( n -- |n| ): if n < 0, negate it
-      // Bytecode: DUP, LIT0, LT, JZ skip_negate, LIT0, SWAP, SUB, skip_negate:
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DUP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT0))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // JZ offset +3 (skip LIT0, SWAP, SUB)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 3)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // NEGATE sequence: LIT0, SWAP, SUB
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT0))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SUB))) != FrontErr::OK)
+
+    // Try parsing as integer
+    int32_t val = lexed ? lexed->value : 0;
+    if (lexed ? lexed->kind == LexKind::Number
+              : try_parse_int(token_start, token_len, &val))
+    {
+      STATS_COUNT(st, literals);
+      consts.count = known_consts;
+      consts.push(current_bc->size, val);
+      if ((err = emit_literal(current_bc, val, compact_literals)) != FrontErr::OK)
         CLEANUP_AND_RETURN(err);
       continue;
     }
-    else if (str_eq_ci(token, "MIN"))
+
+    // Constant folding: replace the operands' literals with the result
+    int fold_arity;
+    int32_t folded;
+    if (fold_constants && kw && known_consts > 0)
     {
-      // MIN ( a b -- min ): OVER OVER < IF DROP ELSE SWAP DROP THEN
-      // Bytecode: OVER, OVER, LT, JZ else_branch, DROP, JMP end, else_branch: SWAP, DROP,
-      // end:
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // JZ offset to else_branch (+4 bytes: DROP + JMP 3)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 4)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // True branch: DROP (keep first)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // JMP to end (+2 bytes: SWAP, DROP)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 2)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Else branch: SWAP, DROP (keep second)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
+      consts.count = known_consts;
+      if (fold_keyword(kw, &consts, &fold_arity, &folded))
+      {
+        consts.count -= fold_arity;
+        uint32_t start = consts.entries[consts.count].start;
+        current_bc->size = start;
+        consts.push(start, folded);
+        if ((err = emit_literal(current_bc, folded, compact_literals)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      consts.count = 0;
+    }
+
+    // Composite words and primitives: checked after the dictionary so that user
+    // definitions can shadow them
+    switch (kw ? kw->id : KeywordId::None)
+    {
+      case KeywordId::LoopI:
+      case KeywordId::LoopJ:
+      case KeywordId::LoopK:
+      {
+        // Loop indices kept in locals are read directly; the index of a counted
+        // loop is limit - counter
+        int level = kw->id == KeywordId::LoopI ? 0 : kw->id == KeywordId::LoopJ ? 1 : 2;
+        const ControlFrame* loop = enclosing_loop(control_stack, control_depth, level);
+        int slot = loop ? loop->loop_slot : -1;
+        if (loop && loop->counted && kw->id == KeywordId::LoopI)
+        {
+          if ((err = emit_literal(current_bc, loop->limit, compact_literals)) !=
+                  FrontErr::OK ||
+              (err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::RFETCH))) !=
+                  FrontErr::OK)
+            CLEANUP_AND_RETURN(err);
+          err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SUB));
+        }
+        else if (slot >= 0)
+          err = emit_local_op(current_bc, v4::Op::LGET, slot);
+        else if (kw->id == KeywordId::LoopI)
+          err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::RFETCH));
+        else
+          err = emit_outer_loop_index(current_bc, level);
+        if (err != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      // Composite words (expanded to multiple opcodes)
+      case KeywordId::Rot:
+      {
+        // ROT ( a b c -- b c a ): >R SWAP R> SWAP
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::Nip:
+      {
+        // NIP ( a b -- b ): SWAP DROP
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::Tuck:
+      {
+        // TUCK ( a b -- b a b ): SWAP OVER
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::Negate:
+      {
+        // NEGATE ( n -- -n ): 0 SWAP -
+        // Emit: LIT 0, SWAP, SUB
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LIT0))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SUB))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::QDup:
+      {
+        // ?DUP ( x -- 0 | x x ): if x is zero, leave it; if non-zero, duplicate
+        // Bytecode: DUP, JZ +1 (skip next), DUP
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DUP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // JZ offset +1 (skip the next DUP instruction, which is 1 byte)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Offset: +1 byte (skip DUP), little-endian int16
+        if ((err = append_byte(current_bc, 1)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // The DUP that gets executed if non-zero
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DUP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::Abs:
+      {
+        // ABS ( n -- |n| ): if n < 0, negate it
+        // Bytecode: DUP, LIT0, LT, JZ skip_negate, LIT0, SWAP, SUB, skip_negate:
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DUP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LIT0))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LT))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // JZ offset +3 (skip LIT0, SWAP, SUB)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 3)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // NEGATE sequence: LIT0, SWAP, SUB
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LIT0))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SUB))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::Min:
+      {
+        // MIN ( a b -- min ): OVER OVER < IF DROP ELSE SWAP DROP THEN
+        // Bytecode: OVER, OVER, LT, JZ else_branch, DROP, JMP end, else_branch: SWAP,
+        // DROP, end:
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LT))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // JZ offset to else_branch (+4 bytes: DROP + JMP 3)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 4)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // True branch: DROP (keep first)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // JMP to end (+2 bytes: SWAP, DROP)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 2)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Else branch: SWAP, DROP (keep second)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::Max:
+      {
+        // MAX ( a b -- max ): OVER OVER > IF DROP ELSE SWAP DROP THEN
+        // Same as MIN but with GT instead of LT
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::GT))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // JZ offset to else_branch (+4 bytes: DROP + JMP 3)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JZ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 4)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // True branch: DROP (keep first)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // JMP to end (+2 bytes: SWAP, DROP)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::JMP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 2)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, 0)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Else branch: SWAP, DROP (keep second)
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::SWAP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::ZeroEq:
+      {
+        // 0= ( n -- flag ): test if zero
+        // Bytecode: LIT0, EQ
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LIT0))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::EQ))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::ZeroLt:
+      {
+        // 0< ( n -- flag ): test if less than zero (negative)
+        // Bytecode: LIT0, LT
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LIT0))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LT))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::ZeroGt:
+      {
+        // 0> ( n -- flag ): test if greater than zero (positive)
+        // Bytecode: LIT0, GT
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LIT0))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::GT))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::TwoDup:
+      {
+        // 2DUP ( a b -- a b a b ): duplicate top two items
+        // Bytecode: OVER, OVER
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::TwoDrop:
+      {
+        // 2DROP ( a b -- ): drop top two items
+        // Bytecode: DROP, DROP
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DROP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::TwoSwap:
+      {
+        // 2SWAP ( a b c d -- c d a b ): swap top two pairs
+        // Bytecode: ROT >R ROT R>
+        if ((err = emit_rot_instruction(current_bc)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = emit_rot_instruction(current_bc)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::TwoOver:
+      {
+        // 2OVER ( a b c d -- a b c d a b ): copy second pair to top
+        // Bytecode: >R >R OVER OVER R> R> 2SWAP
+        // First, save top pair
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Duplicate the now-top pair
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::OVER))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Restore saved pair
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        // Now we have: a b a b c d, need: a b c d a b
+        // Use 2SWAP: ROT >R ROT R>
+        if ((err = emit_rot_instruction(current_bc)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = emit_rot_instruction(current_bc)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::PlusStore:
+      {
+        // +! ( n addr -- ): add n to value at addr
+        // Bytecode: DUP >R @ + R> !
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::DUP))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::TOR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LOAD))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::ADD))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::FROMR))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::STORE))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::True:
+      {
+        // TRUE ( -- -1 ): true flag value
+        // Bytecode: LITN1
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LITN1))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::False:
+      {
+        // FALSE ( -- 0 ): false flag value
+        // Bytecode: LIT0
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::LIT0))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      case KeywordId::Simple:
+      {
+        // Single-opcode primitive from the keyword table
+        if ((err = append_byte(current_bc, static_cast<uint8_t>(kw->opcode))) !=
+            FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        continue;
+      }
+      default:
+        break;
+    }
+
+    // Token not recognized
+    if (error_pos)
+      *error_pos = token_start;
+    CLEANUP_AND_RETURN(FrontErr::UnknownToken);
+  }
+
+  return FrontErr::OK;
+}
+
+// Error for a structure still open after the last token (OK if none)
+static FrontErr unclosed_error(const CompileState* st)
+{
+  // Check what kind of unclosed control structure
+  if (st->control_depth > 0)
+  {
+    ControlType type = st->control_stack[st->control_depth - 1].type;
+    if (type == IF_CONTROL)
+      return FrontErr::UnclosedIf;
+    if (type == DO_CONTROL)
+      return FrontErr::UnclosedDo;
+    return FrontErr::UnclosedBegin;
+  }
+
+  // Check for unclosed word definition
+  if (st->in_definition)
+    return FrontErr::UnclosedColon;
+  return FrontErr::OK;
+}
+
+// Close the compilation: check for unterminated structures (reported at end,
+// the end of the source), run the optimization stages and hand the result to
+// build. The arena is released in every case (unless st->errors is set).
+static FrontErr compile_finish(CompileState* st, const char* end, OutputBuilder build,
+                               void* out, const char** error_pos)
+{
+  const uint32_t flags = st->flags;
+  Arena& arena = st->arena;
+  CodeBuf& bc = st->bc;
+  WordDict& dict = st->dict;
+  CodeBuf* current_bc = st->current_bc;
+  FrontErr err = FrontErr::OK;
+
+  if ((err = unclosed_error(st)) != FrontErr::OK)
+  {
+    // Set error position to end of source (we don't know where the structure started)
+    if (error_pos)
+      *error_pos = end;
+    CLEANUP_AND_RETURN(err);
+  }
+
+  // Source map entries by unit; main code entries past its end are dropped
+  // before the final RET, which belongs to the last token
+  SourceMapUnits map_units = {nullptr, nullptr, nullptr, nullptr, 0};
+  if (st->source_map &&
+      (err = source_map_group(&arena, &st->map, &bc, &dict, &map_units)) != FrontErr::OK)
+    CLEANUP_AND_RETURN(err);
+  uint32_t* pcs;
+  uint32_t pc_count;
+
+  // Append RET unless the end of the code is unreachable (see ends_in_jump)
+  if (!ends_in_jump(current_bc->data, current_bc->size))
+  {
+    if ((err = append_byte(current_bc, static_cast<uint8_t>(v4::Op::RET))) !=
+        FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+  }
+
+  // IR passes over every unit (skipped entirely when none is enabled)
+  if (passes_enabled(flags))
+  {
+    pcs = source_map_pcs(&map_units, 0, &pc_count);
+    if ((err = run_passes(&arena, flags, bc.data, &bc.size, pcs, pc_count)) !=
+        FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+    source_map_update(&map_units, 0, bc.size);
+    for (int i = 0; i < dict.count; i++)
+    {
+      WordDefEntry* word = &dict.entries[i];
+      if (word->cached)
+      {
+        // Reused definition: the cache also holds the code after the passes
+        CodeBuf code = {nullptr, 0, 0, &arena};
+        if ((err = append_bytes(&code, word->cached->final_code,
+                                word->cached->final_len)) != FrontErr::OK)
+          CLEANUP_AND_RETURN(err);
+        word->code = code.data;
+        word->code_len = code.size;
+        continue;
+      }
+      pcs = source_map_pcs(&map_units, i + 1, &pc_count);
+      if ((err = run_passes(&arena, flags, word->code, &word->code_len, pcs,
+                            pc_count)) != FrontErr::OK)
         CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
+      source_map_update(&map_units, i + 1, word->code_len);
+    }
+  }
+
+  // Remember the new definitions before dead word elimination renumbers them
+  if (st->cache)
+    store_cached_definitions(st);
+
+  // Tree-shake the dictionary. CALL operands taken from ctx are VM indices
+  // that cannot be told apart from local ones, so such code is left alone.
+  if ((flags & V4FRONT_OPT_STRIP_UNUSED) && !st->calls_ctx_words)
+  {
+    const int word_count = dict.count;
+    const int* remap = nullptr;
+    if ((err = strip_unused_words(&arena, &bc, &dict, &remap)) != FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+    if (remap && (err = source_map_renumber(&arena, &map_units, remap, word_count)) !=
+                     FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+  }
+
+  // Hot words first, for the same reason only without ctx words
+  const ProfileIndex* profile;
+  if ((err = profile_index(st, &profile)) != FrontErr::OK)
+    CLEANUP_AND_RETURN(err);
+  if ((flags & V4FRONT_OPT_HOT_LAYOUT) && profile && !st->calls_ctx_words)
+  {
+    const int* remap = nullptr;
+    if ((err = layout_hot_words(&arena, &bc, &dict, profile, &remap)) != FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+    if (remap && (err = source_map_renumber(&arena, &map_units, remap, dict.count)) !=
+                     FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+  }
+
+  // Superinstruction fusion comes last: only the relocation walk below can
+  // decode the code after it
+  if (st->super_count > 0)
+  {
+    pcs = source_map_pcs(&map_units, 0, &pc_count);
+    if ((err = fuse_superinstructions(&arena, st->super_table, st->super_count, bc.data,
+                                      &bc.size, pcs, pc_count)) != FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+    source_map_update(&map_units, 0, bc.size);
+    for (int i = 0; i < dict.count; i++)
+    {
+      pcs = source_map_pcs(&map_units, i + 1, &pc_count);
+      if ((err = fuse_superinstructions(&arena, st->super_table, st->super_count,
+                                        dict.entries[i].code, &dict.entries[i].code_len,
+                                        pcs, pc_count)) != FrontErr::OK)
         CLEANUP_AND_RETURN(err);
-      continue;
+      source_map_update(&map_units, i + 1, dict.entries[i].code_len);
     }
-    else if (str_eq_ci(token, "MAX"))
+  }
+
+  // List the CALL sites of the final code
+  RelocTable relocs = {nullptr, 0, 0};
+  if (flags & V4FRONT_OPT_RELOCS)
+  {
+    // Local indices from kImportBase up would read as placeholders
+    if (dict.count > kImportBase)
+      CLEANUP_AND_RETURN(FrontErr::DictionaryFull);
+    const ContextWords* cw = st->ctx ? st->ctx->words : nullptr;
+    err = collect_relocs(&arena, st->super_table, st->super_count, cw, -1, bc.data,
+                         bc.size, &relocs);
+    for (int i = 0; i < dict.count && err == FrontErr::OK; i++)
+      err = collect_relocs(&arena, st->super_table, st->super_count, cw, i,
+                           dict.entries[i].code, dict.entries[i].code_len, &relocs);
+    if (err != FrontErr::OK)
+      CLEANUP_AND_RETURN(err);
+  }
+
+  CodeBuf map = {nullptr, 0, 0, &arena};
+  if (st->source_map && (err = source_map_encode(&map_units, &map)) != FrontErr::OK)
+    CLEANUP_AND_RETURN(err);
+
+  // Copy main code, words and names into the output, then drop the scratch
+  err = build(&arena, &bc, &dict, (flags & V4FRONT_OPT_RELOCS) ? &relocs : nullptr,
+              st->source_map ? &map : nullptr, out);
+  arena.release();
+  if (err == FrontErr::OK && st->cache)
+  {
+    st->cache->reused = st->reused;
+    st->cache->compiled = st->compiled;
+  }
+  // The next compilation through ctx allocates after this one's data
+  if (err == FrontErr::OK && st->ctx && !st->ctx->read_only)
+    st->ctx->data.here = st->data_space.here;
+  return err;
+}
+
+#undef CLEANUP_AND_RETURN
+
+// Get st ready to go on after an error at pos: drop the definition being
+// compiled and resume after the next ; token. False if there is none, or the
+// error has no position.
+static bool recover_after_error(CompileState* st, const char* pos, const char* end)
+{
+  if (!pos)
+    return false;
+  const char* p = pos;
+  while (true)
+  {
+    if (skip_whitespace_and_comments(&p, end, nullptr) != FrontErr::OK || p == end)
+      return false;
+    const char* start = p;
+    p = scan_token(p, end);
+    if (p - start == 1 && *start == ';')
+      break;
+  }
+
+  if (st->in_definition)
+  {
+    st->in_definition = false;
+    st->current_word_name[0] = '\0';
+    st->word_bc = {nullptr, 0, 0, &st->arena};
+    st->control_depth = st->colon_depth;
+  }
+  st->current_bc = &st->bc;
+  st->loop_base = -1;
+  st->recurse_count = 0;
+  st->consts.count = 0;
+  st->def_cacheable = false;
+  st->resume = p;
+  return true;
+}
+
+// scratch, if not nullptr, is a retaining arena (V4FrontSession) the
+// compilation takes its scratch memory from instead of options->allocator; it
+// receives the recycled memory back.
+// errors, if not nullptr, collects every error (error_pos must be given): the
+// compilation goes on after each one (see recover_after_error) and only
+// builds the output if there is none.
+static FrontErr compile_source(const char* source, size_t len, V4FrontContext* ctx,
+                               const V4FrontCompileOptions* options, OutputBuilder build,
+                               void* out, const char** error_pos, V4FrontStats* stats,
+                               Arena* scratch = nullptr, ErrorLog* errors = nullptr)
+{
+  CompileState st;
+  FrontErr err = compile_init(&st, ctx, options);
+  if (err != FrontErr::OK)
+    return err;
+  if (scratch)
+  {
+    // Nothing has been allocated yet, so the arena can be swapped under the
+    // pointers compile_init took to it
+    st.arena = *scratch;
+#if V4FRONT_STATS
+    st.arena.chunk_count = 0;
+    st.arena.copy_count = 0;
+#endif
+  }
+#if V4FRONT_STATS
+  st.stats = stats;
+  STATS_PHASE(&st, StatsNone);
+#else
+  (void)stats;
+#endif
+  // Without memory for the token stream the compiler scans the source itself
+  STATS_PHASE(&st, StatsTokenize);
+  if (ctx && ctx->lex && !ctx->read_only)
+    (void)lex_source(&st.arena, ctx->lex, source, len, &st.lex);
+  const char* end = source ? source + len : nullptr;
+  st.errors = errors;
+  err = compile_tokens(&st, source, end, error_pos);
+  while (err != FrontErr::OK && errors && errors->push(err, *error_pos) &&
+         recover_after_error(&st, *error_pos, end))
+  {
+    *error_pos = nullptr;
+    err = compile_tokens(&st, source, end, error_pos);
+  }
+  STATS_PHASE(&st, StatsFinish);
+  if (errors && errors->count > 0)
+  {
+    // No output: only the structures left open are still reported
+    if (err == FrontErr::OK && (err = unclosed_error(&st)) != FrontErr::OK)
+      errors->push(err, end);
+    err = errors->notes[0].code;
+  }
+  else if (err == FrontErr::OK)
+  {
+    err = compile_finish(&st, end, build, out, error_pos);
+    if (err != FrontErr::OK && errors)
+      errors->push(err, *error_pos);
+  }
+  if (errors)
+    st.arena.release();
+#if V4FRONT_STATS
+  if (stats)
+  {
+    STATS_PHASE(&st, StatsNone);
+    stats->words = static_cast<uint32_t>(st.dict.count);
+    stats->allocations = st.arena.chunk_count;
+    stats->reallocations = st.arena.copy_count;
+  }
+#endif
+  if (scratch)
+    *scratch = st.arena;
+  return err;
+}
+
+// ---------------------------------------------------------------------------
+// On-disk compile cache (V4FrontCompileOptions::cache_dir)
+// ---------------------------------------------------------------------------
+
+#ifndef V4FRONT_VERSION
+#define V4FRONT_VERSION "unknown"
+#endif
+
+// Bump when the cache file contents change meaning
+static const uint32_t DISK_CACHE_FORMAT = 2;
+
+// Everything the output depends on: compiler, options, context words, source
+static DiskKey disk_cache_key(const char* source, size_t len, const V4FrontContext* ctx,
+                              const V4FrontCompileOptions* options)
+{
+  DiskKeyHasher h;
+  h.init();
+  h.add(V4FRONT_VERSION, sizeof(V4FRONT_VERSION));
+  h.add_u32(DISK_CACHE_FORMAT);
+
+  h.add_u32(options->flags | opt_level_flags(options->opt_level));
+  h.add_u32(options->inline_max_size ? options->inline_max_size
+                                     : DEFAULT_INLINE_MAX_SIZE);
+  h.add_u32(options->superinstructions ? options->superinstruction_count : 0);
+  if (options->superinstructions)
+    h.add(options->superinstructions,
+          sizeof(V4FrontSuperinstruction) * options->superinstruction_count);
+  if (options->flags & V4FRONT_OPT_AUTO_YIELD)
+    h.add_u32(options->yield_budget ? options->yield_budget : DEFAULT_YIELD_BUDGET);
+  const V4FrontProfile* profile = options->profile;
+  h.add_u32(profile ? profile->count + 1 : 0);
+  for (uint32_t i = 0; profile && i < profile->count; i++)
+  {
+    for (const char* c = profile->words[i].name; *c; c++)
     {
-      // MAX ( a b -- max ): OVER OVER > IF DROP ELSE SWAP DROP THEN
-      // Same as MIN but with GT instead of LT
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::GT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // JZ offset to else_branch (+4 bytes: DROP + JMP 3)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JZ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 4)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // True branch: DROP (keep first)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // JMP to end (+2 bytes: SWAP, DROP)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::JMP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 2)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap, 0)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Else branch: SWAP, DROP (keep second)
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::SWAP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      char folded = fold_ascii(*c);
+      h.add(&folded, 1);
     }
-    else if (str_eq_ci(token, "0="))
+    h.add_u32(0);
+    h.add(&profile->words[i].count, sizeof(uint64_t));
+  }
+
+  // Lookups fold case, so the fingerprint does too
+  const ContextWords* cw = ctx ? ctx->words : nullptr;
+  h.add_u32(cw ? static_cast<uint32_t>(cw->word_count) : 0);
+  for (int i = 0; cw && i < cw->word_count; i++)
+  {
+    for (const char* c = cw->words[i].name; *c; c++)
     {
-      // 0= ( n -- flag ): test if zero
-      // Bytecode: LIT0, EQ
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT0))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::EQ))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      char folded = fold_ascii(*c);
+      h.add(&folded, 1);
     }
-    else if (str_eq_ci(token, "0<"))
+    h.add_u32(0);
+    h.add_u32(static_cast<uint32_t>(cw->words[i].vm_word_idx));
+  }
+
+  // Addresses of VARIABLE and CREATE words, and whether the compilation
+  // moves ctx's HERE (see compile_cached)
+  DataSpace data;
+  if (ctx)
+    data = ctx->data;
+  else
+    data.init(DATA_SPACE_BASE, DATA_SPACE_SIZE);
+  h.add_u32(data.here);
+  h.add_u32(data.limit);
+  h.add_u32(ctx && !ctx->read_only ? 1 : 0);
+
+  h.add_u32(static_cast<uint32_t>(len));
+  h.add(source, len);
+  return h.finish(len);
+}
+
+// A compilation's output twice: for the caller, and as an image for the cache
+struct CachedOutput
+{
+  V4FrontBuf* buf;
+  V4FrontImage image;  // data == nullptr if it could not be built
+};
+
+static FrontErr build_output_and_image(const Arena* arena, const CodeBuf* main_bc,
+                                       const WordDict* dict, const RelocTable* relocs,
+                                       const CodeBuf* source_map, void* out)
+{
+  CachedOutput* both = (CachedOutput*)out;
+  FrontErr err = build_output(arena, main_bc, dict, relocs, source_map, both->buf);
+  if (err == FrontErr::OK &&
+      build_image(arena, main_bc, dict, relocs, source_map, &both->image) !=
+          FrontErr::OK)
+    both->image.data = nullptr;  // Still a valid compilation, just not cached
+  return err;
+}
+
+// Turn a cached image back into compiler output (one block, like build_output)
+static FrontErr buf_from_image(const uint8_t* data, size_t size,
+                               const V4FrontAllocator* allocator, V4FrontBuf* out_buf)
+{
+  if (v4front_image_validate(data, size) != front_err_to_int(FrontErr::OK))
+    return FrontErr::InvalidImage;
+  const V4FrontImageHeader* h = (const V4FrontImageHeader*)data;
+  const V4FrontImageWord* image_words = (const V4FrontImageWord*)(data + h->words_offset);
+
+  Arena arena;  // Only for its allocator
+  arena.init(allocator);
+  size_t total = sizeof(OutputBlock) + sizeof(V4FrontWord) * h->word_count +
+                 h->code_size + h->names_size;
+  uint8_t* block = (uint8_t*)arena.raw_alloc(total);
+  if (!block)
+    return FrontErr::OutOfMemory;
+  ((OutputBlock*)block)->allocator = arena.allocator;
+
+  V4FrontWord* words = (V4FrontWord*)(block + sizeof(OutputBlock));
+  uint8_t* code = block + sizeof(OutputBlock) + sizeof(V4FrontWord) * h->word_count;
+  char* names = (char*)(code + h->code_size);
+  memcpy(code, data + h->code_offset, h->code_size);
+  memcpy(names, data + h->names_offset, h->names_size);
+  for (uint32_t i = 0; i < h->word_count; i++)
+  {
+    words[i].name = names + image_words[i].name_offset;
+    words[i].code = code + image_words[i].code_offset;
+    words[i].code_len = image_words[i].code_len;
+    words[i].effect = {0, 0, 0, 0, 0};
+  }
+
+  out_buf->data = code;
+  out_buf->size = h->main_size;
+  out_buf->words = (h->word_count > 0) ? words : nullptr;
+  out_buf->word_count = static_cast<int>(h->word_count);
+  out_buf->block = block;
+  return FrontErr::OK;
+}
+
+static FrontErr compile_cached(const char* source, size_t len, V4FrontBuf* out_buf,
+                               V4FrontContext* ctx, const V4FrontCompileOptions* options,
+                               const char** error_pos, V4FrontStats* stats)
+{
+  DiskKey key = disk_cache_key(source, len, ctx, options);
+  uint8_t* data;
+  size_t size;
+  if (disk_cache_read(options->cache_dir, key, &data, &size))
+  {
+    FrontErr err = buf_from_image(data, size, options->allocator, out_buf);
+    free(data);
+    if (err == FrontErr::OK)
+      return err;
+    // A damaged or foreign file: compile and replace it
+  }
+
+  CachedOutput both = {out_buf, {nullptr, 0, {nullptr, nullptr, nullptr}}};
+  const bool moves_here = ctx && !ctx->read_only;
+  const uint32_t here = moves_here ? ctx->data.here : 0;
+  FrontErr err = compile_source(source, len, ctx, options, build_output_and_image, &both,
+                                error_pos, stats);
+  // A hit could not move ctx's HERE, so output that did is not stored
+  if (err == FrontErr::OK && both.image.data && (!moves_here || ctx->data.here == here))
+    disk_cache_write(options->cache_dir, key, both.image.data, both.image.size);
+  v4front_image_free(&both.image);
+  return err;
+}
+
+static FrontErr compile_internal(const char* source, size_t len, V4FrontBuf* out_buf,
+                                 V4FrontContext* ctx,
+                                 const V4FrontCompileOptions* options,
+                                 const char** error_pos, V4FrontStats* stats = nullptr)
+{
+  assert(out_buf);
+
+  // Initialize output buffer
+  out_buf->data = nullptr;
+  out_buf->size = 0;
+  out_buf->words = nullptr;
+  out_buf->word_count = 0;
+  out_buf->block = nullptr;
+  out_buf->relocs = nullptr;
+  out_buf->reloc_count = 0;
+  out_buf->source_map = nullptr;
+  out_buf->source_map_size = 0;
+
+  // The cache files hold images, which have no relocation table, source map
+  // or stack effects
+  if (source && options && options->cache_dir &&
+      !(options->flags &
+        (V4FRONT_OPT_RELOCS | V4FRONT_OPT_SOURCE_MAP | V4FRONT_OPT_STACK_EFFECTS)))
+    return compile_cached(source, len, out_buf, ctx, options, error_pos, stats);
+  return compile_source(source, len, ctx, options, build_output, out_buf, error_pos,
+                        stats);
+}
+
+// ---------------------------------------------------------------------------
+// Public C API implementations
+// ---------------------------------------------------------------------------
+
+extern "C" const char* v4front_err_str(v4front_err code)
+{
+  return front_err_str(static_cast<FrontErr>(code));
+}
+
+// Length of an optional NUL-terminated source
+static size_t source_len(const char* source)
+{
+  return source ? strlen(source) : 0;
+}
+
+extern "C" v4front_err v4front_compile(const char* source, V4FrontBuf* out_buf, char* err,
+                                       size_t err_cap)
+{
+  return v4front_compile_n(source, source_len(source), out_buf, err, err_cap);
+}
+
+extern "C" v4front_err v4front_compile_n(const char* source, size_t len,
+                                         V4FrontBuf* out_buf, char* err, size_t err_cap)
+{
+  if (!out_buf)
+  {
+    write_error_msg(err, err_cap, "output buffer is NULL");
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  }
+
+  const char* error_pos = nullptr;
+  FrontErr result = compile_internal(source, len, out_buf, nullptr, nullptr, &error_pos);
+
+  if (result != FrontErr::OK)
+  {
+    write_error(err, err_cap, result);
+  }
+
+  return front_err_to_int(result);
+}
+
+extern "C" v4front_err v4front_compile_word(const char* name, const char* source,
+                                            V4FrontBuf* out_buf, char* err,
+                                            size_t err_cap)
+{
+  // Current implementation ignores 'name' parameter
+  (void)name;
+  return v4front_compile(source, out_buf, err, err_cap);
+}
+
+extern "C" void v4front_free(V4FrontBuf* buf)
+{
+  if (!buf)
+    return;
+
+  // Compiler output: everything lives in one block
+  if (buf->block)
+  {
+    V4FrontAllocator allocator = ((const OutputBlock*)buf->block)->allocator;
+    if (!allocator.alloc)
+      free(buf->block);
+    else if (allocator.free)
+      allocator.free(allocator.user, buf->block);
+    buf->block = nullptr;
+    buf->words = nullptr;
+    buf->word_count = 0;
+    buf->data = nullptr;
+    buf->size = 0;
+    buf->relocs = nullptr;
+    buf->reloc_count = 0;
+    buf->source_map = nullptr;
+    buf->source_map_size = 0;
+    return;
+  }
+
+  // Separately allocated fields (e.g. from v4front_load_bytecode)
+
+  // Free word definitions
+  if (buf->words)
+  {
+    for (int i = 0; i < buf->word_count; i++)
     {
-      // 0< ( n -- flag ): test if less than zero (negative)
-      // Bytecode: LIT0, LT
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT0))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      free(buf->words[i].name);
+      free(buf->words[i].code);
     }
-    else if (str_eq_ci(token, "0>"))
-    {
-      // 0> ( n -- flag ): test if greater than zero (positive)
-      // Bytecode: LIT0, GT
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT0))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::GT))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
+    free(buf->words);
+    buf->words = nullptr;
+    buf->word_count = 0;
+  }
+
+  // Free main bytecode
+  if (buf->data)
+  {
+    free(buf->data);
+    buf->data = nullptr;
+    buf->size = 0;
+  }
+
+  // Free source map
+  free(const_cast<uint8_t*>(buf->source_map));
+  buf->source_map = nullptr;
+  buf->source_map_size = 0;
+}
+
+extern "C" v4front_err v4front_relocate(V4FrontBuf* buf, uint32_t local_base)
+{
+  if (!buf)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+
+  // Check every site first, so a failure leaves buf as it was
+  for (uint32_t i = 0; i < buf->reloc_count; i++)
+  {
+    const V4FrontReloc& reloc = buf->relocs[i];
+    if (reloc.kind == V4FRONT_RELOC_LOCAL &&
+        local_base > static_cast<uint32_t>(INT16_MAX) - reloc.target)
+      return front_err_to_int(FrontErr::DictionaryFull);
+  }
+
+  for (uint32_t i = 0; i < buf->reloc_count; i++)
+  {
+    V4FrontReloc& reloc = buf->relocs[i];
+    if (reloc.kind != V4FRONT_RELOC_LOCAL)
       continue;
-    }
-    else if (str_eq_ci(token, "2DUP"))
+    reloc.target = static_cast<uint16_t>(reloc.target + local_base);
+    uint8_t* code = reloc.unit < 0 ? buf->data : buf->words[reloc.unit].code;
+    backpatch_i16_le(code, reloc.offset, static_cast<int16_t>(reloc.target));
+  }
+  return front_err_to_int(FrontErr::OK);
+}
+
+// Source map reader (see the writer above source_map_encode)
+struct SourceMapReader
+{
+  const uint8_t* p;
+  const uint8_t* end;
+  bool ok;
+
+  uint32_t uvarint()
+  {
+    uint32_t n = 0;
+    for (uint32_t shift = 0; ok; shift += 7)
     {
-      // 2DUP ( a b -- a b a b ): duplicate top two items
-      // Bytecode: OVER, OVER
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      if (p == end || shift > 28)
+        break;
+      uint8_t byte = *p++;
+      n |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return n;
     }
-    else if (str_eq_ci(token, "2DROP"))
+    ok = false;
+    return 0;
+  }
+
+  // base advanced by a zigzag-encoded delta
+  uint32_t svarint(uint32_t base)
+  {
+    uint32_t z = uvarint();
+    return (z & 1) ? base - ((z >> 1) + 1) : base + (z >> 1);
+  }
+};
+
+extern "C" v4front_err v4front_source_map_lookup(const uint8_t* map, size_t size,
+                                                 int32_t unit, uint32_t pc,
+                                                 V4FrontSourceLoc* out)
+{
+  if (!out)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  *out = {0, 0, 0};
+  if (!map || size == 0 || map[0] != SOURCE_MAP_VERSION)
+    return front_err_to_int(FrontErr::InvalidImage);
+
+  SourceMapReader in = {map + 1, map + size, true};
+  uint32_t unit_count = in.uvarint();
+  const uint32_t slot = static_cast<uint32_t>(unit) + 1;
+  for (uint32_t u = 0; u < unit_count && in.ok; u++)
+  {
+    uint32_t this_slot = in.uvarint();
+    uint32_t entries = in.uvarint();
+    V4FrontSourceLoc loc = {0, 1, 0};
+    uint32_t at = 0;
+    for (uint32_t i = 0; i < entries && in.ok; i++)
     {
-      // 2DROP ( a b -- ): drop top two items
-      // Bytecode: DROP, DROP
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DROP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      at += in.uvarint();
+      loc.offset = in.svarint(loc.offset);
+      loc.line = in.svarint(loc.line);
+      loc.column = in.uvarint();
+      if (!in.ok || this_slot != slot)
+        continue;
+      if (at > pc)
+        return front_err_to_int(FrontErr::OK);
+      *out = loc;
     }
-    else if (str_eq_ci(token, "2SWAP"))
+    if (this_slot == slot)
+      break;
+  }
+  if (!in.ok)
+  {
+    *out = {0, 0, 0};
+    return front_err_to_int(FrontErr::InvalidImage);
+  }
+  return front_err_to_int(FrontErr::OK);
+}
+
+extern "C" v4front_err v4front_task_resources(const V4FrontBuf* buf, int word,
+                                              const V4FrontStackEffect* vm_ops,
+                                              V4FrontTaskResources* out)
+{
+  if (!buf || !out)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  *out = {V4FRONT_TASK_BOUNDED, -1, 0, 0, 0, 0};
+  if (word < 0 || word >= buf->word_count)
+    return front_err_to_int(FrontErr::UnknownToken);
+
+  Arena arena;
+  arena.init();
+  FrontErr err = task_resources(&arena, buf->words, buf->word_count, word, vm_ops, out);
+  arena.release();
+  return front_err_to_int(err);
+}
+
+extern "C" v4front_err v4front_find_yieldless_loops(const V4FrontBuf* buf,
+                                                    V4FrontLoop* out, uint32_t cap,
+                                                    uint32_t* count)
+{
+  if (!buf || !count || (!out && cap > 0) || (!buf->data && buf->size > 0))
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  Arena arena;
+  arena.init();
+  FrontErr err = find_yieldless_loops(&arena, buf, out, cap, count);
+  arena.release();
+  return front_err_to_int(err);
+}
+
+// ===========================================================================
+// Stateful Compiler Context Implementation
+// ===========================================================================
+
+// Allocate an empty word list with one reference
+static ContextWords* context_words_create()
+{
+  void* mem = malloc(sizeof(ContextWords));
+  if (!mem)
+    return nullptr;
+  ContextWords* cw = new (mem) ContextWords;
+  cw->refs.store(1, std::memory_order_relaxed);
+  cw->words = nullptr;
+  cw->word_count = 0;
+  cw->word_capacity = 0;
+  cw->names.init();
+  cw->index.init();
+  return cw;
+}
+
+// Drop one reference; the last one frees the word list
+static void context_words_release(ContextWords* cw)
+{
+  // Release/acquire pairing: every reader is done before the list is freed
+  if (cw->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+
+  cw->names.release();
+  cw->index.destroy();
+  free(cw->words);
+  cw->~ContextWords();
+  free(cw);
+}
+
+// Make ctx->words private to ctx before it is modified (copy-on-write)
+static FrontErr context_words_detach(V4FrontContext* ctx)
+{
+  ContextWords* shared = ctx->words;
+  if (shared->refs.load(std::memory_order_acquire) == 1)
+    return FrontErr::OK;
+
+  ContextWords* copy = context_words_create();
+  if (!copy)
+    return FrontErr::OutOfMemory;
+  if (shared->word_count > 0)
+  {
+    copy->words =
+        (ContextWordEntry*)malloc(sizeof(ContextWordEntry) * shared->word_capacity);
+    if (!copy->words)
     {
-      // 2SWAP ( a b c d -- c d a b ): swap top two pairs
-      // Bytecode: ROT >R ROT R>
-      if ((err = emit_rot_instruction(current_bc, current_bc_size, current_bc_cap)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = emit_rot_instruction(current_bc, current_bc_size, current_bc_cap)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      context_words_release(copy);
+      return FrontErr::OutOfMemory;
     }
-    else if (str_eq_ci(token, "2OVER"))
-    {
-      // 2OVER ( a b c d -- a b c d a b ): copy second pair to top
-      // Bytecode: >R >R OVER OVER R> R> 2SWAP
-      // First, save top pair
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Duplicate the now-top pair
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::OVER))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Restore saved pair
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      // Now we have: a b a b c d, need: a b c d a b
-      // Use 2SWAP: ROT >R ROT R>
-      if ((err = emit_rot_instruction(current_bc, current_bc_size, current_bc_cap)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = emit_rot_instruction(current_bc, current_bc_size, current_bc_cap)) !=
-          FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+    copy->word_capacity = shared->word_capacity;
+  }
+  for (int i = 0; i < shared->word_count; i++)
+  {
+    const ContextWordEntry& entry = shared->words[i];
+    size_t name_len = strlen(entry.name);
+    const char* interned = copy->names.intern(entry.name, name_len);
+    if (!interned || !copy->index.insert(interned, name_len, i))
+    {
+      context_words_release(copy);
+      return FrontErr::OutOfMemory;
     }
-    else if (str_eq_ci(token, "+!"))
+    copy->words[i].name = interned;
+    copy->words[i].vm_word_idx = entry.vm_word_idx;
+    copy->word_count = i + 1;
+  }
+
+  context_words_release(shared);
+  ctx->words = copy;
+  return FrontErr::OK;
+}
+
+extern "C" V4FrontContext* v4front_context_create(void)
+{
+  V4FrontContext* ctx = (V4FrontContext*)malloc(sizeof(V4FrontContext));
+  if (!ctx)
+    return nullptr;
+
+  ctx->words = context_words_create();
+  if (!ctx->words)
+  {
+    free(ctx);
+    return nullptr;
+  }
+  ctx->read_only = false;
+  ctx->cache = nullptr;
+  ctx->lex = nullptr;
+  ctx->data.init(DATA_SPACE_BASE, DATA_SPACE_SIZE);
+
+  return ctx;
+}
+
+extern "C" V4FrontContext* v4front_context_snapshot(const V4FrontContext* ctx)
+{
+  if (!ctx)
+    return nullptr;
+
+  V4FrontContext* snap = (V4FrontContext*)malloc(sizeof(V4FrontContext));
+  if (!snap)
+    return nullptr;
+
+  // Only the reference count is touched, so snapshots of a snapshot may be
+  // taken from any thread
+  ctx->words->refs.fetch_add(1, std::memory_order_relaxed);
+  snap->words = ctx->words;
+  snap->read_only = true;
+  snap->cache = nullptr;
+  snap->lex = nullptr;
+  snap->data = ctx->data;
+
+  return snap;
+}
+
+extern "C" void v4front_context_destroy(V4FrontContext* ctx)
+{
+  if (!ctx)
+    return;
+
+  // Free the word list once no snapshot uses it
+  context_words_release(ctx->words);
+
+  if (ctx->cache)
+  {
+    ctx->cache->destroy();
+    free(ctx->cache);
+  }
+  if (ctx->lex)
+  {
+    ctx->lex->destroy();
+    free(ctx->lex);
+  }
+
+  // Free context
+  free(ctx);
+}
+
+extern "C" void v4front_context_reset(V4FrontContext* ctx)
+{
+  if (!ctx || ctx->read_only)
+    return;
+  ctx->data.reset();
+
+  // A shared list is left to its snapshots
+  if (ctx->words->refs.load(std::memory_order_acquire) != 1)
+  {
+    ContextWords* empty = context_words_create();
+    if (!empty)
+      return;
+    context_words_release(ctx->words);
+    ctx->words = empty;
+    return;
+  }
+
+  // Release word names (the arena keeps one chunk for reuse)
+  ContextWords* cw = ctx->words;
+  cw->names.reset();
+  cw->index.clear();
+
+  // Clear word list
+  cw->word_count = 0;
+}
+
+extern "C" v4front_err v4front_context_register_word(V4FrontContext* ctx,
+                                                     const char* name, int vm_word_idx)
+{
+  if (!ctx || !name)
+    return -1;  // Invalid argument
+  if (ctx->read_only)
+    return front_err_to_int(FrontErr::ReadOnlyContext);
+
+  FrontErr err = context_words_detach(ctx);
+  if (err != FrontErr::OK)
+    return front_err_to_int(err);
+  ContextWords* cw = ctx->words;
+
+  // Check if word already exists (case-insensitive)
+  size_t name_len = strlen(name);
+  WordIndex::Slot* slot = cw->index.find(name, name_len);
+  if (slot)
+  {
+    // Update existing entry
+    cw->words[slot->value].vm_word_idx = vm_word_idx;
+    return front_err_to_int(FrontErr::OK);
+  }
+
+  // Grow array if needed
+  if (cw->word_count >= cw->word_capacity)
+  {
+    int new_capacity = (cw->word_capacity == 0) ? 16 : (cw->word_capacity * 2);
+    ContextWordEntry* new_words =
+        (ContextWordEntry*)realloc(cw->words, sizeof(ContextWordEntry) * new_capacity);
+    if (!new_words)
+      return front_err_to_int(FrontErr::OutOfMemory);
+
+    cw->words = new_words;
+    cw->word_capacity = new_capacity;
+  }
+
+  // Add new entry
+  const char* interned = cw->names.intern(name, name_len);
+  if (!interned || !cw->index.insert(interned, name_len, cw->word_count))
+    return front_err_to_int(FrontErr::OutOfMemory);
+
+  cw->words[cw->word_count].name = interned;
+  cw->words[cw->word_count].vm_word_idx = vm_word_idx;
+  cw->word_count++;
+
+  return front_err_to_int(FrontErr::OK);
+}
+
+extern "C" v4front_err v4front_context_set_word_cache(V4FrontContext* ctx,
+                                                     size_t max_bytes)
+{
+  if (!ctx)
+    return -1;  // Invalid argument
+  if (ctx->read_only)
+    return front_err_to_int(FrontErr::ReadOnlyContext);
+
+  if (max_bytes == 0)
+  {
+    if (ctx->cache)
     {
-      // +! ( n addr -- ): add n to value at addr
-      // Bytecode: DUP >R @ + R> !
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::DUP))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::TOR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LOAD))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::ADD))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::FROMR))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::STORE))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      ctx->cache->destroy();
+      free(ctx->cache);
+      ctx->cache = nullptr;
     }
-    else if (str_eq_ci(token, "TRUE"))
+    return front_err_to_int(FrontErr::OK);
+  }
+
+  if (!ctx->cache)
+  {
+    ctx->cache = (WordCache*)malloc(sizeof(WordCache));
+    if (!ctx->cache)
+      return front_err_to_int(FrontErr::OutOfMemory);
+    ctx->cache->init(max_bytes);
+  }
+  ctx->cache->max_bytes = max_bytes;
+  ctx->cache->trim();
+  return front_err_to_int(FrontErr::OK);
+}
+
+extern "C" void v4front_context_get_word_cache_stats(const V4FrontContext* ctx,
+                                                    V4FrontWordCacheStats* out)
+{
+  if (!out)
+    return;
+  const WordCache* cache = ctx ? ctx->cache : nullptr;
+  out->entries = cache ? cache->count : 0;
+  out->bytes = cache ? cache->bytes : 0;
+  out->reused = cache ? cache->reused : 0;
+  out->compiled = cache ? cache->compiled : 0;
+}
+
+extern "C" v4front_err v4front_context_set_lex_cache(V4FrontContext* ctx,
+                                                     size_t max_bytes)
+{
+  if (!ctx)
+    return -1;  // Invalid argument
+  if (ctx->read_only)
+    return front_err_to_int(FrontErr::ReadOnlyContext);
+
+  if (max_bytes == 0)
+  {
+    if (ctx->lex)
     {
-      // TRUE ( -- -1 ): true flag value
-      // Bytecode: LITN1
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LITN1))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      ctx->lex->destroy();
+      free(ctx->lex);
+      ctx->lex = nullptr;
     }
-    else if (str_eq_ci(token, "FALSE"))
+    return front_err_to_int(FrontErr::OK);
+  }
+
+  if (!ctx->lex)
+  {
+    ctx->lex = (LexCache*)malloc(sizeof(LexCache));
+    if (!ctx->lex)
+      return front_err_to_int(FrontErr::OutOfMemory);
+    ctx->lex->init(max_bytes);
+  }
+  ctx->lex->max_bytes = max_bytes;
+  ctx->lex->trim();
+  return front_err_to_int(FrontErr::OK);
+}
+
+extern "C" void v4front_context_get_lex_cache_stats(const V4FrontContext* ctx,
+                                                   V4FrontLexCacheStats* out)
+{
+  if (!out)
+    return;
+  const LexCache* lex = ctx ? ctx->lex : nullptr;
+  out->entries = lex ? lex->count : 0;
+  out->bytes = lex ? lex->bytes : 0;
+  out->hits = lex ? lex->hits : 0;
+  out->misses = lex ? lex->misses : 0;
+}
+
+extern "C" int v4front_context_get_word_count(const V4FrontContext* ctx)
+{
+  if (!ctx)
+    return 0;
+  return ctx->words->word_count;
+}
+
+extern "C" const char* v4front_context_get_word_name(const V4FrontContext* ctx, int idx)
+{
+  if (!ctx || idx < 0 || idx >= ctx->words->word_count)
+    return nullptr;
+  return ctx->words->words[idx].name;
+}
+
+extern "C" int v4front_context_find_word(const V4FrontContext* ctx, const char* name)
+{
+  if (!ctx || !name)
+    return -1;
+
+  const ContextWords* cw = ctx->words;
+  const WordIndex::Slot* slot = cw->index.find(name, strlen(name));
+  return slot ? cw->words[slot->value].vm_word_idx : -1;
+}
+
+extern "C" v4front_err v4front_context_set_data_space(V4FrontContext* ctx, uint32_t base,
+                                                      uint32_t size)
+{
+  if (!ctx)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  if (ctx->read_only)
+    return front_err_to_int(FrontErr::ReadOnlyContext);
+  // Cells must stay aligned, and the end must be addressable
+  if ((base & 3u) != 0 || size > UINT32_MAX - base)
+    return front_err_to_int(FrontErr::InvalidOption);
+  ctx->data.init(base, size);
+  return front_err_to_int(FrontErr::OK);
+}
+
+extern "C" uint32_t v4front_context_get_here(const V4FrontContext* ctx)
+{
+  return ctx ? ctx->data.get_here() : DATA_SPACE_BASE;
+}
+
+extern "C" v4front_err v4front_compile_with_context(V4FrontContext* ctx,
+                                                    const char* source,
+                                                    V4FrontBuf* out_buf, char* err,
+                                                    size_t err_cap)
+{
+  return v4front_compile_with_context_n(ctx, source, source_len(source), out_buf, err,
+                                        err_cap);
+}
+
+extern "C" v4front_err v4front_compile_with_context_n(V4FrontContext* ctx,
+                                                      const char* source, size_t len,
+                                                      V4FrontBuf* out_buf, char* err,
+                                                      size_t err_cap)
+{
+  if (!out_buf)
+  {
+    write_error_msg(err, err_cap, "output buffer is NULL");
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  }
+
+  // Compile with context (may be NULL for stateless compilation)
+  const char* error_pos = nullptr;
+  FrontErr result = compile_internal(source, len, out_buf, ctx, nullptr, &error_pos);
+
+  if (result != FrontErr::OK)
+  {
+    write_error(err, err_cap, result);
+  }
+
+  return front_err_to_int(result);
+}
+
+// ===========================================================================
+// Error Position Tracking and Detailed Error Information
+// ===========================================================================
+
+// Line starts of a source, for reporting many errors in it without scanning
+// the source again for each one
+struct LineIndex
+{
+  size_t* starts;  // Offset of every line (heap memory)
+  size_t count;
+
+  // False if out of memory
+  bool build(const char* source, size_t len)
+  {
+    const char* end = source + len;
+    size_t lines = 1;
+    for (const char* p = source; (p = find_byte(p, end, '\n')) < end; p++)
+      lines++;
+    starts = static_cast<size_t*>(malloc(sizeof(size_t) * lines));
+    if (!starts)
+      return false;
+    starts[0] = 0;
+    count = 1;
+    for (const char* p = source; (p = find_byte(p, end, '\n')) < end; p++)
+      starts[count++] = static_cast<size_t>(p + 1 - source);
+    return true;
+  }
+
+  void destroy()
+  {
+    free(starts);
+  }
+
+  // Line (0-based) holding offset
+  size_t find(size_t offset) const
+  {
+    const size_t* after = std::upper_bound(starts, starts + count, offset);
+    return static_cast<size_t>(after - starts) - 1;
+  }
+};
+
+// Where an error is: its line and column (1-based) and the bounds of that line
+// (the '\n' excluded)
+struct ErrorLocation
+{
+  int line;
+  int column;
+  const char* line_start;
+  const char* line_end;
+};
+
+// Helper: Locate error_pos in source[0, len), through lines if not nullptr
+static ErrorLocation locate_error(const char* source, size_t len, const char* error_pos,
+                                  const LineIndex* lines)
+{
+  ErrorLocation loc;
+  const char* source_end = source + len;
+  if (lines)
+  {
+    size_t line = lines->find(static_cast<size_t>(error_pos - source));
+    loc.line = static_cast<int>(line + 1);
+    loc.line_start = source + lines->starts[line];
+    loc.line_end = line + 1 < lines->count ? source + lines->starts[line + 1] - 1
+                                           : source_end;
+  }
+  else
+  {
+    // One pass up to the error
+    loc.line = 1;
+    loc.line_start = source;
+    for (const char* p = source; (p = find_byte(p, error_pos, '\n')) < error_pos; p++)
     {
-      // FALSE ( -- 0 ): false flag value
-      // Bytecode: LIT0
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(v4::Op::LIT0))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      loc.line++;
+      loc.line_start = p + 1;
     }
+    loc.line_end = find_byte(error_pos, source_end, '\n');
+  }
+  loc.column = static_cast<int>(error_pos - loc.line_start + 1);
+  return loc;
+}
+
+// Helper: Extract token at error position (it does not span lines)
+static void extract_error_token(const ErrorLocation& loc, const char* error_pos,
+                                char* token_out, size_t token_cap)
+{
+  // Find start of token (skip back over non-whitespace)
+  const char* token_start = error_pos;
+  while (token_start > loc.line_start && !is_space(*(token_start - 1)))
+    token_start--;
+
+  // Find end of token
+  const char* token_end = error_pos;
+  while (token_end < loc.line_end && !is_space(*token_end))
+    token_end++;
+
+  // Copy token
+  size_t token_len = token_end - token_start;
+  if (token_len >= token_cap)
+    token_len = token_cap - 1;
+
+  memcpy(token_out, token_start, token_len);
+  token_out[token_len] = '\0';
+}
+
+// Helper: Extract surrounding context (the line of the error, trimmed to fit)
+static void extract_context(const ErrorLocation& loc, char* context_out,
+                            size_t context_cap)
+{
+  size_t line_len = loc.line_end - loc.line_start;
+  if (line_len >= context_cap)
+    line_len = context_cap - 1;
+
+  memcpy(context_out, loc.line_start, line_len);
+  context_out[line_len] = '\0';
+}
+
+// Helper: Fill V4FrontError structure (lines: index of source, or nullptr)
+static void fill_error_info(V4FrontError* error, const char* source, size_t len,
+                            const char* error_pos, FrontErr code,
+                            const LineIndex* lines = nullptr)
+{
+  if (!error)
+    return;
+
+  error->code = front_err_to_int(code);
+
+  // Copy error message
+  const char* msg = front_err_str(code);
+  size_t msg_len = strlen(msg);
+  if (msg_len >= sizeof(error->message))
+    msg_len = sizeof(error->message) - 1;
+  memcpy(error->message, msg, msg_len);
+  error->message[msg_len] = '\0';
+
+  // Calculate position
+  if (source && error_pos && error_pos >= source && error_pos <= source + len)
+  {
+    error->position = (int)(error_pos - source);
+    ErrorLocation loc = locate_error(source, len, error_pos, lines);
+    error->line = loc.line;
+    error->column = loc.column;
+    extract_error_token(loc, error_pos, error->token, sizeof(error->token));
+    extract_context(loc, error->context, sizeof(error->context));
+  }
+  else
+  {
+    error->position = -1;
+    error->line = -1;
+    error->column = -1;
+    error->token[0] = '\0';
+    error->context[0] = '\0';
+  }
+}
+
+extern "C" v4front_err v4front_compile_ex(const char* source, V4FrontBuf* out_buf,
+                                          V4FrontError* error_out)
+{
+  return v4front_compile_ex_n(source, source_len(source), out_buf, error_out);
+}
 
-    // Try matching simple opcodes using dispatch table
-    v4::Op opcode;
-    if (lookup_simple_opcode(token, &opcode))
+extern "C" v4front_err v4front_compile_ex_n(const char* source, size_t len,
+                                            V4FrontBuf* out_buf, V4FrontError* error_out)
+{
+  if (!out_buf)
+  {
+    if (error_out)
     {
-      // Found in dispatch table - emit the opcode
-      if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                             static_cast<uint8_t>(opcode))) != FrontErr::OK)
-        CLEANUP_AND_RETURN(err);
-      continue;
+      error_out->code = front_err_to_int(FrontErr::BufferTooSmall);
+      snprintf(error_out->message, sizeof(error_out->message), "output buffer is NULL");
+      error_out->position = -1;
+      error_out->line = -1;
+      error_out->column = -1;
+      error_out->token[0] = '\0';
+      error_out->context[0] = '\0';
     }
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  }
 
-    // Token not recognized
-    if (error_pos)
-      *error_pos = token_start;
-    CLEANUP_AND_RETURN(FrontErr::UnknownToken);
+  const char* error_pos = nullptr;
+  FrontErr result = compile_internal(source, len, out_buf, nullptr, nullptr, &error_pos);
+
+  if (result != FrontErr::OK && error_out)
+  {
+    fill_error_info(error_out, source, len, error_pos, result);
   }
 
-  // Check for unclosed control structures
-  if (control_depth > 0)
+  return front_err_to_int(result);
+}
+
+extern "C" v4front_err v4front_compile_with_context_ex(V4FrontContext* ctx,
+                                                       const char* source,
+                                                       V4FrontBuf* out_buf,
+                                                       V4FrontError* error_out)
+{
+  if (!out_buf)
   {
-    // Set error position to end of source (we don't know where the structure started)
-    if (error_pos)
-      *error_pos = p;
+    if (error_out)
+    {
+      error_out->code = front_err_to_int(FrontErr::BufferTooSmall);
+      snprintf(error_out->message, sizeof(error_out->message), "output buffer is NULL");
+      error_out->position = -1;
+      error_out->line = -1;
+      error_out->column = -1;
+      error_out->token[0] = '\0';
+      error_out->context[0] = '\0';
+    }
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  }
 
-    // Check what kind of unclosed structure
-    if (control_stack[control_depth - 1].type == IF_CONTROL)
-      CLEANUP_AND_RETURN(FrontErr::UnclosedIf);
-    else if (control_stack[control_depth - 1].type == DO_CONTROL)
-      CLEANUP_AND_RETURN(FrontErr::UnclosedDo);
-    else
-      CLEANUP_AND_RETURN(FrontErr::UnclosedBegin);
+  const char* error_pos = nullptr;
+  FrontErr result =
+      compile_internal(source, source_len(source), out_buf, ctx, nullptr, &error_pos);
+
+  if (result != FrontErr::OK && error_out)
+  {
+    fill_error_info(error_out, source, source_len(source), error_pos, result);
   }
 
-  // Check for unclosed word definition
-  if (in_definition)
+  return front_err_to_int(result);
+}
+
+extern "C" v4front_err v4front_compile_with_allocator(V4FrontContext* ctx,
+                                                      const char* source,
+                                                      const V4FrontAllocator* allocator,
+                                                      V4FrontBuf* out_buf,
+                                                      V4FrontError* error_out)
+{
+  V4FrontCompileOptions options = {};
+  options.allocator = allocator;
+  return v4front_compile_with_options(ctx, source, &options, out_buf, error_out);
+}
+
+extern "C" v4front_err v4front_compile_with_options(V4FrontContext* ctx,
+                                                    const char* source,
+                                                    const V4FrontCompileOptions* options,
+                                                    V4FrontBuf* out_buf,
+                                                    V4FrontError* error_out)
+{
+  return v4front_compile_with_options_n(ctx, source, source_len(source), options, out_buf,
+                                        error_out);
+}
+
+extern "C" v4front_err v4front_compile_with_options_n(
+    V4FrontContext* ctx, const char* source, size_t len,
+    const V4FrontCompileOptions* options, V4FrontBuf* out_buf, V4FrontError* error_out)
+{
+  if (!out_buf)
   {
-    // Set error position to end of source
-    if (error_pos)
-      *error_pos = p;
-    CLEANUP_AND_RETURN(FrontErr::UnclosedColon);
+    if (error_out)
+    {
+      error_out->code = front_err_to_int(FrontErr::BufferTooSmall);
+      snprintf(error_out->message, sizeof(error_out->message), "output buffer is NULL");
+      error_out->position = -1;
+      error_out->line = -1;
+      error_out->column = -1;
+      error_out->token[0] = '\0';
+      error_out->context[0] = '\0';
+    }
+    return front_err_to_int(FrontErr::BufferTooSmall);
   }
 
-  // Transfer word_dict to out_buf->words
-  if (word_count > 0)
+  const char* error_pos = nullptr;
+  FrontErr result = compile_internal(source, len, out_buf, ctx, options, &error_pos);
+
+  if (result != FrontErr::OK && error_out)
   {
-    // Allocate words array
-    out_buf->words = (V4FrontWord*)malloc(sizeof(V4FrontWord) * word_count);
-    if (!out_buf->words)
-      CLEANUP_AND_RETURN(FrontErr::OutOfMemory);
+    fill_error_info(error_out, source, len, error_pos, result);
+  }
 
-    // Copy each word definition
-    for (int i = 0; i < word_count; i++)
-    {
-      // Copy name
-      out_buf->words[i].name = portable_strdup(word_dict[i].name);
-      if (!out_buf->words[i].name)
-      {
-        // Cleanup already allocated names
-        for (int j = 0; j < i; j++)
-        {
-          free(out_buf->words[j].name);
-        }
-        free(out_buf->words);
-        CLEANUP_AND_RETURN(FrontErr::OutOfMemory);
-      }
+  return front_err_to_int(result);
+}
 
-      // Transfer ownership of code (no copy needed)
-      out_buf->words[i].code = word_dict[i].code;
-      out_buf->words[i].code_len = word_dict[i].code_len;
-      word_dict[i].code = nullptr;  // Ownership transferred, don't free in cleanup
-    }
+extern "C" v4front_err v4front_compile_all_errors(V4FrontContext* ctx, const char* source,
+                                                  size_t len,
+                                                  const V4FrontCompileOptions* options,
+                                                  V4FrontBuf* out_buf,
+                                                  V4FrontError* errors, uint32_t cap,
+                                                  uint32_t* count)
+{
+  if (!out_buf || !count || (!errors && cap > 0))
+    return front_err_to_int(FrontErr::BufferTooSmall);
+
+  out_buf->data = nullptr;
+  out_buf->size = 0;
+  out_buf->words = nullptr;
+  out_buf->word_count = 0;
+  out_buf->block = nullptr;
+  out_buf->relocs = nullptr;
+  out_buf->reloc_count = 0;
+  out_buf->source_map = nullptr;
+  out_buf->source_map_size = 0;
+  *count = 0;
+
+  ErrorLog log;
+  log.init();
+  const char* error_pos = nullptr;
+  FrontErr result = compile_source(source, len, ctx, options, build_output, out_buf,
+                                   &error_pos, nullptr, nullptr, &log);
+  if (result == FrontErr::OK)
+    return 0;
+  if (log.count == 0)
+    log.push(result, error_pos);  // Invalid options, or out of memory
+
+  // One index serves every error; without memory for it each one scans
+  LineIndex lines;
+  bool indexed = source && lines.build(source, len);
+  uint32_t shown = log.count < cap ? log.count : cap;
+  for (uint32_t i = 0; i < shown; i++)
+    fill_error_info(&errors[i], source, len, log.notes[i].pos, log.notes[i].code,
+                    indexed ? &lines : nullptr);
+  if (indexed)
+    lines.destroy();
+  *count = log.count;
+  log.destroy();
+  return front_err_to_int(result);
+}
 
-    out_buf->word_count = word_count;
+extern "C" v4front_err v4front_compile_with_stats(V4FrontContext* ctx,
+                                                  const char* source,
+                                                  const V4FrontCompileOptions* options,
+                                                  V4FrontBuf* out_buf,
+                                                  V4FrontError* error_out,
+                                                  V4FrontStats* stats)
+{
+  if (stats)
+    memset(stats, 0, sizeof(*stats));
+  if (!stats || !out_buf)
+    return v4front_compile_with_options(ctx, source, options, out_buf, error_out);
+
+#if V4FRONT_STATS
+  stats->enabled = 1;
+  uint64_t start = stats_now();
+#endif
+  size_t len = source_len(source);
+  const char* error_pos = nullptr;
+  FrontErr result =
+      compile_internal(source, len, out_buf, ctx, options, &error_pos, stats);
+#if V4FRONT_STATS
+  if (result == FrontErr::OK)
+  {
+    uint32_t bytes = out_buf->size;
+    for (int i = 0; i < out_buf->word_count; i++)
+      bytes += out_buf->words[i].code_len;
+    stats->bytes_emitted = bytes;
   }
-  else
+  stats->total_ns = stats_now() - start;
+#endif
+
+  if (result != FrontErr::OK && error_out)
   {
-    out_buf->words = nullptr;
-    out_buf->word_count = 0;
+    fill_error_info(error_out, source, len, error_pos, result);
   }
 
-  // Append RET only if the last instruction is not an unconditional jump
-  // (unconditional JMP makes following code unreachable)
-  bool needs_ret = true;
-  if (*current_bc_size >= 3)
+  return front_err_to_int(result);
+}
+
+extern "C" v4front_err v4front_compile_image(V4FrontContext* ctx, const char* source,
+                                             const V4FrontAllocator* allocator,
+                                             V4FrontImage* out_image,
+                                             V4FrontError* error_out)
+{
+  if (!out_image)
   {
-    uint8_t last_opcode = (*current_bc)[*current_bc_size - 3];
-    if (last_opcode == static_cast<uint8_t>(v4::Op::JMP))
+    if (error_out)
     {
-      // Last instruction is unconditional jump (from AGAIN or REPEAT) - no RET needed
-      needs_ret = false;
+      error_out->code = front_err_to_int(FrontErr::BufferTooSmall);
+      snprintf(error_out->message, sizeof(error_out->message), "output image is NULL");
+      error_out->position = -1;
+      error_out->line = -1;
+      error_out->column = -1;
+      error_out->token[0] = '\0';
+      error_out->context[0] = '\0';
     }
+    return front_err_to_int(FrontErr::BufferTooSmall);
   }
 
-  if (needs_ret)
+  out_image->data = nullptr;
+  out_image->size = 0;
+  out_image->allocator = {nullptr, nullptr, nullptr};
+
+  V4FrontCompileOptions options = {};
+  options.allocator = allocator;
+  const char* error_pos = nullptr;
+  FrontErr result = compile_source(source, source_len(source), ctx, &options, build_image,
+                                   out_image, &error_pos, nullptr);
+
+  if (result != FrontErr::OK && error_out)
   {
-    if ((err = append_byte(current_bc, current_bc_size, current_bc_cap,
-                           static_cast<uint8_t>(v4::Op::RET))) != FrontErr::OK)
-      CLEANUP_AND_RETURN(err);
+    fill_error_info(error_out, source, source_len(source), error_pos, result);
   }
 
-  out_buf->data = bc;
-  out_buf->size = bc_size;
-  return FrontErr::OK;
+  return front_err_to_int(result);
+}
+
+extern "C" void v4front_image_free(V4FrontImage* image)
+{
+  if (!image || !image->data)
+    return;
+
+  if (!image->allocator.alloc)
+    free(image->data);
+  else if (image->allocator.free)
+    image->allocator.free(image->allocator.user, image->data);
+
+  image->data = nullptr;
+  image->size = 0;
 }
 
 // ---------------------------------------------------------------------------
-// Public C API implementations
+// Compiler sessions
 // ---------------------------------------------------------------------------
+//
+// A session owns a retaining scratch arena and an output block, both reused by
+// every compilation through it. Once they have grown to the size a workload
+// needs, compiling takes no memory from the allocator at all.
 
-extern "C" const char* v4front_err_str(v4front_err code)
+struct V4FrontSession
 {
-  return front_err_str(static_cast<FrontErr>(code));
+  Arena scratch;         // Compile scratch (retain: recycled after every call)
+  uint8_t* output;       // Session-owned output block (nullptr: none yet)
+  size_t output_cap;     // Its size
+  uint8_t* user_output;  // Caller storage from v4front_session_set_output
+  size_t user_cap;       // Its usable size (after alignment)
+  size_t output_size;    // Last output size, or what it needed (BufferTooSmall)
+};
+
+// Allocator recorded in session output: v4front_free() on it releases nothing
+static void* session_no_alloc(void*, size_t)
+{
+  return nullptr;
 }
 
-extern "C" v4front_err v4front_compile(const char* source, V4FrontBuf* out_buf, char* err,
-                                       size_t err_cap)
+struct SessionOutput
 {
-  if (!out_buf)
+  V4FrontSession* session;
+  V4FrontBuf* buf;
+};
+
+// OutputBuilder for sessions: the block is the caller's storage or the
+// session's own, grown only when a larger result comes along
+static FrontErr build_session_output(const Arena* arena, const CodeBuf* main_bc,
+                                     const WordDict* dict, const RelocTable* relocs,
+                                     const CodeBuf* source_map, void* out)
+{
+  SessionOutput* so = (SessionOutput*)out;
+  V4FrontSession* s = so->session;
+  const size_t size = output_size(main_bc, dict, relocs, source_map);
+  s->output_size = size;
+
+  uint8_t* block = s->user_output;
+  if (block && size > s->user_cap)
+    return FrontErr::BufferTooSmall;
+  if (!block)
   {
-    write_error_msg(err, err_cap, "output buffer is NULL");
+    if (size > s->output_cap)
+    {
+      size_t cap = s->output_cap * 2 > size ? s->output_cap * 2 : size;
+      uint8_t* grown = (uint8_t*)arena->raw_alloc(cap);
+      if (!grown)
+        return FrontErr::OutOfMemory;
+      arena->raw_free(s->output);
+      s->output = grown;
+      s->output_cap = cap;
+    }
+    block = s->output;
+  }
+  const V4FrontAllocator owner = {session_no_alloc, nullptr, nullptr};
+  write_output(block, owner, main_bc, dict, relocs, source_map, so->buf);
+  return FrontErr::OK;
+}
+
+extern "C" V4FrontSession* v4front_session_create(const V4FrontAllocator* allocator)
+{
+  Arena owner;
+  owner.init(allocator);
+  V4FrontSession* s =
+      static_cast<V4FrontSession*>(owner.raw_alloc(sizeof(V4FrontSession)));
+  if (!s)
+    return nullptr;
+  s->scratch = owner;
+  s->scratch.retain = true;
+  s->output = nullptr;
+  s->output_cap = 0;
+  s->user_output = nullptr;
+  s->user_cap = 0;
+  s->output_size = 0;
+  return s;
+}
+
+extern "C" void v4front_session_destroy(V4FrontSession* session)
+{
+  if (!session)
+    return;
+  Arena owner = session->scratch;  // Copy: the allocator outlives the session
+  owner.free_chunks();
+  owner.raw_free(session->output);
+  owner.raw_free(session);
+}
+
+extern "C" v4front_err v4front_session_set_output(V4FrontSession* session, void* mem,
+                                                  size_t cap)
+{
+  if (!session)
     return front_err_to_int(FrontErr::BufferTooSmall);
+  if (!mem)
+  {
+    session->user_output = nullptr;
+    session->user_cap = 0;
+    return front_err_to_int(FrontErr::OK);
   }
 
-  const char* error_pos = nullptr;
-  FrontErr result = compile_internal(source, out_buf, nullptr, nullptr, &error_pos);
+  // Start at the first byte aligned like malloc
+  const uintptr_t align = alignof(std::max_align_t);
+  const uintptr_t addr = reinterpret_cast<uintptr_t>(mem);
+  const size_t skip = static_cast<size_t>((align - addr % align) % align);
+  if (cap < skip + sizeof(OutputBlock))
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  session->user_output = static_cast<uint8_t*>(mem) + skip;
+  session->user_cap = cap - skip;
+  return front_err_to_int(FrontErr::OK);
+}
 
-  if (result != FrontErr::OK)
+extern "C" size_t v4front_session_output_size(const V4FrontSession* session)
+{
+  return session ? session->output_size : 0;
+}
+
+extern "C" v4front_err v4front_session_compile(V4FrontSession* session,
+                                               V4FrontContext* ctx, const char* source,
+                                               const V4FrontCompileOptions* options,
+                                               V4FrontBuf* out_buf,
+                                               V4FrontError* error_out)
+{
+  return v4front_session_compile_n(session, ctx, source, source_len(source), options,
+                                   out_buf, error_out);
+}
+
+extern "C" v4front_err v4front_session_compile_n(V4FrontSession* session,
+                                                 V4FrontContext* ctx, const char* source,
+                                                 size_t len,
+                                                 const V4FrontCompileOptions* options,
+                                                 V4FrontBuf* out_buf,
+                                                 V4FrontError* error_out)
+{
+  FrontErr result = FrontErr::OK;
+  const char* error_pos = nullptr;
+  if (!session || !out_buf)
+    result = FrontErr::BufferTooSmall;
+  else if (options && options->cache_dir)
+    result = FrontErr::InvalidOption;  // Cache files are read into fresh memory
+  if (result == FrontErr::OK)
   {
-    write_error(err, err_cap, result);
+    *out_buf = V4FrontBuf{};
+    session->output_size = 0;
+    SessionOutput out = {session, out_buf};
+    result = compile_source(source, len, ctx, options, build_session_output, &out,
+                            &error_pos, nullptr, &session->scratch);
+    // Every error path has released the arena already; this keeps the
+    // session usable even if one were missed
+    session->scratch.recycle();
+    if (result != FrontErr::OK)
+      *out_buf = V4FrontBuf{};
   }
 
+  if (result != FrontErr::OK && error_out)
+    fill_error_info(error_out, source, len, error_pos, result);
   return front_err_to_int(result);
 }
 
-extern "C" v4front_err v4front_compile_word(const char* name, const char* source,
-                                            V4FrontBuf* out_buf, char* err,
-                                            size_t err_cap)
+// ---------------------------------------------------------------------------
+// Streaming compilation
+// ---------------------------------------------------------------------------
+//
+// Source text is buffered until the last safe cut: a line break outside
+// comments, word definitions and control structures, and not between a
+// keyword and its operand. Everything before the cut is compiled into the
+// stream's CompileState and dropped. Every look-ahead of the token loop
+// (definition scans, counted loop scans, operands) stays within one cut, so
+// the output is the same as compiling the whole source at once.
+
+struct V4FrontStream
 {
-  // Current implementation ignores 'name' parameter
-  (void)name;
-  return v4front_compile(source, out_buf, err, err_cap);
-}
+  CompileState state;
+  char* text;       // Source received since the last cut (NUL-terminated)
+  size_t len;       // Bytes in text
+  size_t cap;       // Capacity of text (including the terminator)
+  size_t scan;      // Lexical scan position in text
+  size_t cut;       // End of the last safe cut in text (0: none yet)
+  bool in_definition;    // Scanner: inside : ... ;
+  bool operand_pending;  // Scanner: the next token belongs to a keyword
+  int depth;             // Scanner: open control structures
+  size_t consumed;       // Stream bytes already compiled
+  int consumed_lines;    // Line breaks in them
+  FrontErr failed;       // First error (stream only accepts _end afterwards)
+};
 
-extern "C" void v4front_free(V4FrontBuf* buf)
+// Track the structure that decides where the source may be cut
+static void stream_classify(V4FrontStream* s, const char* token, size_t len)
 {
-  if (!buf)
+  if (s->operand_pending)
+  {
+    s->operand_pending = false;
     return;
+  }
+  const KeywordEntry* kw = lookup_keyword(token, len);
+  switch (kw ? kw->id : KeywordId::None)
+  {
+    case KeywordId::Colon:
+      s->in_definition = true;
+      s->operand_pending = true;  // Word name
+      break;
+    case KeywordId::Semicolon:
+      s->in_definition = false;
+      break;
+    case KeywordId::Constant:
+    case KeywordId::Variable:
+    case KeywordId::Create:
+    case KeywordId::LocalInc:
+    case KeywordId::LocalDec:
+    case KeywordId::LocalGet:
+    case KeywordId::LocalSet:
+    case KeywordId::LocalTee:
+      s->operand_pending = true;
+      break;
+    case KeywordId::If:
+    case KeywordId::Begin:
+    case KeywordId::Do:
+      s->depth++;
+      break;
+    case KeywordId::Then:
+    case KeywordId::Until:
+    case KeywordId::Again:
+    case KeywordId::Repeat:
+    case KeywordId::Loop:
+    case KeywordId::PlusLoop:
+      if (s->depth > 0)
+        s->depth--;
+      break;
+    default:
+      break;
+  }
+}
 
-  // Free word definitions
-  if (buf->words)
+// Advance the scan over every complete token and comment in text, recording
+// safe cuts. Stops at an item that may continue in the next chunk.
+static void stream_scan(V4FrontStream* s)
+{
+  const char* text = s->text;
+  while (s->scan < s->len)
   {
-    for (int i = 0; i < buf->word_count; i++)
+    char c = text[s->scan];
+    if (is_space(c))
     {
-      free(buf->words[i].name);
-      free(buf->words[i].code);
+      if (c == '\n' && !s->in_definition && s->depth == 0 && !s->operand_pending)
+        s->cut = s->scan + 1;
+      s->scan++;
+      continue;
     }
-    free(buf->words);
-    buf->words = nullptr;
-    buf->word_count = 0;
+    if (c == '\\')
+    {
+      // Line comment: the line break that ends it is an ordinary space
+      const void* nl = memchr(text + s->scan, '\n', s->len - s->scan);
+      if (!nl)
+        return;
+      s->scan = static_cast<const char*>(nl) - text;
+      continue;
+    }
+    if (c == '(')
+    {
+      if (s->scan + 1 == s->len)
+        return;  // "( " and "(x" are told apart by the next byte
+      if (is_space(text[s->scan + 1]))
+      {
+        const void* close = memchr(text + s->scan + 1, ')', s->len - s->scan - 1);
+        if (!close)
+          return;
+        s->scan = static_cast<const char*>(close) - text + 1;
+        continue;
+      }
+    }
+
+    size_t end = s->scan;
+    while (end < s->len && !is_space(text[end]))
+      end++;
+    if (end == s->len)
+      return;  // The token may continue in the next chunk
+    stream_classify(s, text + s->scan, end - s->scan);
+    s->scan = end;
   }
+}
 
-  // Free main bytecode
-  if (buf->data)
+// Report err at error_pos (inside text, the buffered source) relative to the
+// whole stream
+static void stream_error(const V4FrontStream* s, const char* text, size_t len,
+                         V4FrontError* error_out, const char* error_pos, FrontErr err)
+{
+  if (!error_out)
+    return;
+  fill_error_info(error_out, text, len, error_pos, err);
+  if (error_out->position >= 0)
   {
-    free(buf->data);
-    buf->data = nullptr;
-    buf->size = 0;
+    // Text after a cut starts a line, so only the line number moves
+    error_out->position += static_cast<int>(s->consumed);
+    error_out->line += s->consumed_lines;
   }
 }
 
-// ===========================================================================
-// Stateful Compiler Context Implementation
-// ===========================================================================
-
-extern "C" V4FrontContext* v4front_context_create(void)
+// Source map position of the start of the buffered text (text after a cut
+// starts a line)
+static void stream_map_rebase(V4FrontStream* s)
 {
-  V4FrontContext* ctx = (V4FrontContext*)malloc(sizeof(V4FrontContext));
-  if (!ctx)
-    return nullptr;
-
-  ctx->words = nullptr;
-  ctx->word_count = 0;
-  ctx->word_capacity = 0;
-
-  return ctx;
+  s->state.map.pos = {static_cast<uint32_t>(s->consumed),
+                      static_cast<uint32_t>(s->consumed_lines) + 1, 1};
 }
 
-extern "C" void v4front_context_destroy(V4FrontContext* ctx)
+// Compile text[0, len) into the stream's state and drop it from the buffer
+static FrontErr stream_compile(V4FrontStream* s, size_t len, V4FrontError* error_out)
 {
-  if (!ctx)
-    return;
-
-  // Free all word names
-  for (int i = 0; i < ctx->word_count; i++)
+  const char* error_pos = nullptr;
+  stream_map_rebase(s);
+  FrontErr err = compile_tokens(&s->state, s->text, s->text + len, &error_pos);
+  if (err != FrontErr::OK)
   {
-    free(ctx->words[i].name);
+    stream_error(s, s->text, len, error_out, error_pos, err);
+    s->failed = err;
+    return err;
   }
 
-  // Free words array
-  free(ctx->words);
+  for (size_t i = 0; i < len; i++)
+  {
+    if (s->text[i] == '\n')
+      s->consumed_lines++;
+  }
+  s->consumed += len;
+  memmove(s->text, s->text + len, s->len - len + 1);
+  s->len -= len;
+  s->scan -= len;
+  s->cut = 0;
+  return FrontErr::OK;
+}
 
-  // Free context
-  free(ctx);
+static void stream_destroy(V4FrontStream* s)
+{
+  Arena owner = s->state.arena;  // Copy: the allocator outlives the stream
+  s->state.arena.release();
+  owner.raw_free(s->text);
+  owner.raw_free(s);
 }
 
-extern "C" void v4front_context_reset(V4FrontContext* ctx)
+extern "C" v4front_err v4front_stream_begin(V4FrontContext* ctx,
+                                            const V4FrontCompileOptions* options,
+                                            V4FrontStream** out_stream)
 {
-  if (!ctx)
-    return;
+  if (!out_stream)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  *out_stream = nullptr;
 
-  // Free all word names
-  for (int i = 0; i < ctx->word_count; i++)
+  Arena owner;
+  owner.init(options ? options->allocator : nullptr);
+  V4FrontStream* s = static_cast<V4FrontStream*>(owner.raw_alloc(sizeof(V4FrontStream)));
+  if (!s)
+    return front_err_to_int(FrontErr::OutOfMemory);
+
+  FrontErr err = compile_init(&s->state, ctx, options);
+  if (err != FrontErr::OK)
   {
-    free(ctx->words[i].name);
+    owner.raw_free(s);
+    return front_err_to_int(err);
   }
-
-  // Clear word list
-  ctx->word_count = 0;
+  s->text = nullptr;
+  s->len = 0;
+  s->cap = 0;
+  s->scan = 0;
+  s->cut = 0;
+  s->in_definition = false;
+  s->operand_pending = false;
+  s->depth = 0;
+  s->consumed = 0;
+  s->consumed_lines = 0;
+  s->failed = FrontErr::OK;
+
+  *out_stream = s;
+  return front_err_to_int(FrontErr::OK);
 }
 
-extern "C" v4front_err v4front_context_register_word(V4FrontContext* ctx,
-                                                     const char* name, int vm_word_idx)
+extern "C" v4front_err v4front_stream_feed(V4FrontStream* stream, const char* chunk,
+                                           size_t len, V4FrontError* error_out)
 {
-  if (!ctx || !name)
-    return -1;  // Invalid argument
+  if (!stream)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  if (stream->failed != FrontErr::OK)
+    return front_err_to_int(stream->failed);
+  if (len == 0)
+    return front_err_to_int(FrontErr::OK);
+  if (!chunk)
+    return front_err_to_int(FrontErr::BufferTooSmall);
 
-  // Check if word already exists (case-insensitive)
-  for (int i = 0; i < ctx->word_count; i++)
+  const void* nul = memchr(chunk, '\0', len);
+  if (nul)
   {
-    if (str_eq_ci(ctx->words[i].name, name))
+    // Source is text; a NUL byte means a corrupted or binary transfer
+    if (error_out)
     {
-      // Update existing entry
-      ctx->words[i].vm_word_idx = vm_word_idx;
-      return front_err_to_int(FrontErr::OK);
+      size_t at = stream->len + (static_cast<const char*>(nul) - chunk);
+      fill_error_info(error_out, nullptr, 0, nullptr, FrontErr::NulInSource);
+      error_out->position = static_cast<int>(stream->consumed + at);
     }
+    stream->failed = FrontErr::NulInSource;
+    return front_err_to_int(stream->failed);
   }
 
-  // Grow array if needed
-  if (ctx->word_count >= ctx->word_capacity)
+  // Append the chunk (the buffer only holds text since the last cut)
+  if (stream->len + len + 1 > stream->cap)
   {
-    int new_capacity = (ctx->word_capacity == 0) ? 16 : (ctx->word_capacity * 2);
-    ContextWordEntry* new_words =
-        (ContextWordEntry*)realloc(ctx->words, sizeof(ContextWordEntry) * new_capacity);
-    if (!new_words)
-      return front_err_to_int(FrontErr::OutOfMemory);
-
-    ctx->words = new_words;
-    ctx->word_capacity = new_capacity;
+    size_t cap = stream->cap ? stream->cap : 256;
+    while (cap < stream->len + len + 1)
+      cap *= 2;
+    Arena& arena = stream->state.arena;
+    char* grown = static_cast<char*>(arena.raw_alloc(cap));
+    if (!grown)
+    {
+      stream->failed = FrontErr::OutOfMemory;
+      fill_error_info(error_out, nullptr, 0, nullptr, stream->failed);
+      return front_err_to_int(stream->failed);
+    }
+    if (stream->text)
+      memcpy(grown, stream->text, stream->len);
+    arena.raw_free(stream->text);
+    stream->text = grown;
+    stream->cap = cap;
   }
+  memcpy(stream->text + stream->len, chunk, len);
+  stream->len += len;
+  stream->text[stream->len] = '\0';
 
-  // Add new entry
-  ctx->words[ctx->word_count].name = portable_strdup(name);
-  if (!ctx->words[ctx->word_count].name)
-    return front_err_to_int(FrontErr::OutOfMemory);
-
-  ctx->words[ctx->word_count].vm_word_idx = vm_word_idx;
-  ctx->word_count++;
-
+  stream_scan(stream);
+  if (stream->cut > 0)
+    return front_err_to_int(stream_compile(stream, stream->cut, error_out));
   return front_err_to_int(FrontErr::OK);
 }
 
-extern "C" int v4front_context_get_word_count(const V4FrontContext* ctx)
+extern "C" v4front_err v4front_stream_end(V4FrontStream* stream, V4FrontBuf* out_buf,
+                                          V4FrontError* error_out)
 {
-  if (!ctx)
-    return 0;
-  return ctx->word_count;
+  if (!stream)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+
+  FrontErr err = stream->failed;
+  if (err == FrontErr::OK && !out_buf)
+    err = FrontErr::BufferTooSmall;  // Abandoned
+  if (err != FrontErr::OK)
+  {
+    stream_destroy(stream);
+    return front_err_to_int(err);
+  }
+
+  out_buf->data = nullptr;
+  out_buf->size = 0;
+  out_buf->words = nullptr;
+  out_buf->word_count = 0;
+  out_buf->block = nullptr;
+  out_buf->relocs = nullptr;
+  out_buf->reloc_count = 0;
+  out_buf->source_map = nullptr;
+  out_buf->source_map_size = 0;
+
+  // Whatever is left is the tail of the source. It stays buffered so errors
+  // at the end of the source get the right column.
+  const char* text = stream->text ? stream->text : "";
+  const char* error_pos = nullptr;
+  stream_map_rebase(stream);
+  err = compile_tokens(&stream->state, text, text + stream->len, &error_pos);
+  if (err == FrontErr::OK)
+    err = compile_finish(&stream->state, text + stream->len, build_output, out_buf,
+                         &error_pos);
+  if (err != FrontErr::OK)
+    stream_error(stream, text, stream->len, error_out, error_pos, err);
+
+  stream_destroy(stream);
+  return front_err_to_int(err);
 }
 
-extern "C" const char* v4front_context_get_word_name(const V4FrontContext* ctx, int idx)
+// ---------------------------------------------------------------------------
+// Batch compilation
+// ---------------------------------------------------------------------------
+//
+//  1. Scan (parallel): every module is tokenized once to list the words it
+//     defines, in the order the compiler adds them, and to count VARIABLEs.
+//  2. Plan: modules get consecutive word index and data space ranges. The
+//     words of ctx and of every module are registered in a link context under
+//     placeholder indices (kImportBase + j).
+//  3. Compile (parallel): every module is compiled against a snapshot of the
+//     link context, so a call into another module compiles to CALL
+//     placeholder. Fusion and dead word elimination are held back.
+//  4. Link: local CALL operands move by the module's word base, placeholders
+//     become final indices, main codes are chained, and the held back passes
+//     run on the linked result.
+
+struct BatchName
 {
-  if (!ctx || idx < 0 || idx >= ctx->word_count)
-    return nullptr;
-  return ctx->words[idx].name;
-}
+  const char* name;  // View into the module source
+  uint32_t len;
+};
 
-extern "C" int v4front_context_find_word(const V4FrontContext* ctx, const char* name)
+// One data space allocation of a module: pad HERE to align, then take bytes
+struct BatchData
 {
-  if (!ctx || !name)
-    return -1;
+  uint32_t align;  // Power of two (0: no padding)
+  uint32_t bytes;
+};
 
-  for (int i = 0; i < ctx->word_count; i++)
+struct BatchUnit
+{
+  const char* source;
+  size_t len;
+  Arena arena;          // Storage for names
+  BatchName* names;     // Words the module defines, in dictionary order
+  uint32_t name_count;  // Entries in names
+  uint32_t name_cap;    // Capacity of names
+  BatchData* data;      // VARIABLE, ALLOT and ALIGN-TO with literal operands, in order
+  uint32_t data_count;  // Entries in data
+  uint32_t data_cap;    // Capacity of data
+  uint32_t word_base;   // Linked index of the module's first word
+  DataSpace space;      // Data space the module starts with
+  uint32_t data_end;    // HERE after the module, as the scan predicts
+  V4FrontBuf buf;       // Compiled, not yet linked
+  FrontErr err;         // First error of this module
+  const char* error_pos;
+};
+
+struct Batch
+{
+  BatchUnit* units;
+  V4FrontContext* link_ctx;  // Snapshot with every importable word
+  const V4FrontCompileOptions* options;
+  uint32_t yield_cell;  // V4FRONT_OPT_AUTO_YIELD counter shared by the modules
+};
+
+static void batch_add_name(BatchUnit* u, const char* name, size_t len)
+{
+  if (u->name_count == u->name_cap)
   {
-    if (str_eq_ci(ctx->words[i].name, name))
-      return ctx->words[i].vm_word_idx;
+    uint32_t new_cap = u->name_cap ? u->name_cap * 2 : 16;
+    BatchName* grown = static_cast<BatchName*>(u->arena.grow(
+        u->names, sizeof(BatchName) * u->name_cap, sizeof(BatchName) * new_cap));
+    if (!grown)
+    {
+      u->err = FrontErr::OutOfMemory;
+      return;
+    }
+    u->names = grown;
+    u->name_cap = new_cap;
   }
-
-  return -1;
+  u->names[u->name_count].name = name;
+  u->names[u->name_count].len = static_cast<uint32_t>(len);
+  u->name_count++;
 }
 
-extern "C" v4front_err v4front_compile_with_context(V4FrontContext* ctx,
-                                                    const char* source,
-                                                    V4FrontBuf* out_buf, char* err,
-                                                    size_t err_cap)
+static void batch_add_data(BatchUnit* u, uint32_t align, uint32_t bytes)
 {
-  if (!out_buf)
+  if (u->data_count == u->data_cap)
   {
-    write_error_msg(err, err_cap, "output buffer is NULL");
-    return front_err_to_int(FrontErr::BufferTooSmall);
+    uint32_t new_cap = u->data_cap ? u->data_cap * 2 : 8;
+    BatchData* grown = static_cast<BatchData*>(u->arena.grow(
+        u->data, sizeof(BatchData) * u->data_cap, sizeof(BatchData) * new_cap));
+    if (!grown)
+    {
+      u->err = FrontErr::OutOfMemory;
+      return;
+    }
+    u->data = grown;
+    u->data_cap = new_cap;
   }
+  u->data[u->data_count].align = align;
+  u->data[u->data_count].bytes = bytes;
+  u->data_count++;
+}
 
-  // Compile with context (may be NULL for stateless compilation)
-  const char* error_pos = nullptr;
-  FrontErr result = compile_internal(source, out_buf, ctx, nullptr, &error_pos);
-
-  if (result != FrontErr::OK)
+// Phase 1: list the definitions and data space allocations of one module.
+// Malformed source is left for the compiler to report.
+static void batch_scan(void* user, uint32_t i)
+{
+  BatchUnit* u = &static_cast<Batch*>(user)->units[i];
+  const char* p = u->source;
+  const char* end = p + u->len;
+  const char* colon_name = nullptr;  // Added at its ; like the compiler does
+  size_t colon_len = 0;
+  bool have_literal = false;  // The previous token was a number (ALLOT operand)
+  int32_t literal = 0;
+
+  while (skip_whitespace_and_comments(&p, end, nullptr) == FrontErr::OK && p < end)
   {
-    write_error(err, err_cap, result);
+    const char* start = p;
+    p = scan_token(p, end);
+    const KeywordEntry* kw = lookup_keyword(start, p - start);
+    KeywordId id = kw ? kw->id : KeywordId::None;
+    const bool after_literal = have_literal;
+    have_literal = !kw && try_parse_int(start, p - start, &literal);
+    switch (id)
+    {
+      case KeywordId::Colon:
+      case KeywordId::Constant:
+      case KeywordId::Variable:
+      case KeywordId::Create:
+      case KeywordId::LocalInc:
+      case KeywordId::LocalDec:
+      case KeywordId::LocalGet:
+      case KeywordId::LocalSet:
+      case KeywordId::LocalTee:
+      {
+        // The next token is a name or an operand, never a keyword
+        if (skip_whitespace_and_comments(&p, end, nullptr) != FrontErr::OK || p == end)
+          return;
+        const char* name = p;
+        p = scan_token(p, end);
+        if (id == KeywordId::Colon)
+        {
+          colon_name = name;
+          colon_len = p - name;
+        }
+        else if (id == KeywordId::Constant || id == KeywordId::Variable ||
+                 id == KeywordId::Create)
+        {
+          batch_add_name(u, name, p - name);
+          if (id == KeywordId::Variable)
+            batch_add_data(u, 0, 4);
+        }
+        break;
+      }
+      case KeywordId::Allot:
+      case KeywordId::AlignTo:
+        // Other operands are only known to the compiler (the module then
+        // fails to link, see batch_compile)
+        if (after_literal)
+        {
+          uint32_t value = static_cast<uint32_t>(literal);
+          if (id == KeywordId::Allot)
+            batch_add_data(u, 0, value);
+          else
+            batch_add_data(u, value, 0);
+        }
+        break;
+      case KeywordId::Semicolon:
+        if (colon_name)
+          batch_add_name(u, colon_name, colon_len);
+        colon_name = nullptr;
+        break;
+      default:
+        break;
+    }
   }
-
-  return front_err_to_int(result);
 }
 
-// ===========================================================================
-// Error Position Tracking and Detailed Error Information
-// ===========================================================================
-
-// Helper: Calculate line and column from position in source
-static void calculate_line_column(const char* source, const char* error_pos, int* line,
-                                  int* column)
+// Phase 3: compile one module against the link context
+static void batch_compile(void* user, uint32_t i)
 {
-  if (!source || !error_pos || error_pos < source)
+  Batch* batch = static_cast<Batch*>(user);
+  BatchUnit* u = &batch->units[i];
+
+  CompileState st;
+  FrontErr err = compile_init(&st, batch->link_ctx, batch->options);
+  if (err != FrontErr::OK)
+  {
+    u->err = err;
+    return;
+  }
+  st.flags &= ~(V4FRONT_OPT_STRIP_UNUSED | V4FRONT_OPT_HOT_LAYOUT);
+  st.super_count = 0;
+  st.data_space = u->space;
+  st.yield_cell = batch->yield_cell;
+
+  const char* end = u->source + u->len;
+  err = compile_tokens(&st, u->source, end, &u->error_pos);
+  if (err == FrontErr::OK)
+    err = compile_finish(&st, end, build_output, &u->buf, &u->error_pos);
+  if (err != FrontErr::OK)
   {
-    *line = -1;
-    *column = -1;
+    u->err = err;
     return;
   }
 
-  *line = 1;
-  *column = 1;
+  // The scan must have predicted the dictionary and data space exactly
+  bool same = u->buf.word_count == static_cast<int>(u->name_count) &&
+              st.data_space.here == u->data_end;
+  for (uint32_t k = 0; same && k < u->name_count; k++)
+    same = name_eq_ci(u->buf.words[k].name, u->names[k].name, u->names[k].len);
+  if (!same)
+  {
+    u->err = FrontErr::LinkFailed;
+    u->error_pos = nullptr;
+  }
+}
 
-  for (const char* p = source; p < error_pos; p++)
+// Phase 4: rewrite the CALL operands of code[0, len). Local indices move by
+// base; placeholders take their final index from imports (the first
+// ctx_count of which are VM indices from ctx).
+static bool batch_relocate(uint8_t* code, uint32_t len, uint32_t base,
+                           const int* imports, int ctx_count, bool* calls_ctx)
+{
+  for (uint32_t pc = 0; pc < len;)
   {
-    if (*p == '\n')
+    uint32_t at = pc;
+    if (!step_insn(code, len, &pc))
+      return false;
+    if (code[at] != static_cast<uint8_t>(v4::Op::CALL))
+      continue;
+    int idx = code[at + 1] | (code[at + 2] << 8);
+    int final_idx;
+    if (idx >= kImportBase)
     {
-      (*line)++;
-      *column = 1;
+      int j = idx - kImportBase;
+      final_idx = imports[j];
+      if (j < ctx_count)
+        *calls_ctx = true;
     }
     else
     {
-      (*column)++;
+      final_idx = static_cast<int>(base) + idx;
     }
+    backpatch_i16_le(code, at + 1, static_cast<int16_t>(final_idx));
   }
+  return true;
 }
 
-// Helper: Extract token at error position
-static void extract_error_token(const char* source, const char* error_pos,
-                                char* token_out, size_t token_cap)
+// Phase 4: append main code that is followed by another module's main code.
+// Every RET (the final one and any an earlier pass moved up, e.g. jump
+// threading) becomes a jump to the next module; the final one just falls
+// through.
+static FrontErr batch_chain_main(Arena* arena, const uint8_t* code, uint32_t size,
+                                 CodeBuf* out)
 {
-  if (!source || !error_pos || !token_out || token_cap == 0 || error_pos < source)
+  IrCode ir;
+  bool decoded;
+  FrontErr err = ir_decode(arena, code, size, &ir, &decoded);
+  if (err != FrontErr::OK)
+    return err;
+  if (!decoded)
+    return FrontErr::LinkFailed;
+
+  uint32_t rets = 0;
+  for (uint32_t i = 0; i < ir.count; i++)
   {
-    if (token_out && token_cap > 0)
-      token_out[0] = '\0';
-    return;
+    IrInsn* insn = &ir.insns[i];
+    if (insn->op != static_cast<uint8_t>(v4::Op::RET))
+      continue;
+    insn->op = static_cast<uint8_t>(v4::Op::JMP);
+    insn->imm_len = 2;
+    insn->is_jump = true;
+    insn->target = ir.count;
+    rets++;
+    if (i + 1 == ir.count)
+      insn->dead = true;
   }
+  ir_compact(&ir);
 
-  // Find start of token (skip back over non-whitespace)
-  const char* token_start = error_pos;
-  while (token_start > source && !isspace((unsigned char)*(token_start - 1)))
-    token_start--;
+  uint8_t* linked = static_cast<uint8_t*>(arena->alloc(size + 2 * rets));
+  if (!linked)
+    return FrontErr::OutOfMemory;
+  uint32_t linked_size;
+  if ((err = ir_emit(&ir, linked, &linked_size)) != FrontErr::OK)
+    return err;
+  return append_bytes(out, linked, linked_size);
+}
 
-  // Find end of token
-  const char* token_end = error_pos;
-  while (*token_end && !isspace((unsigned char)*token_end))
-    token_end++;
+// Phase 4: merge the compiled modules into out_buf
+static FrontErr batch_link(BatchUnit* units, uint32_t count, const int* imports,
+                           int ctx_count, const V4FrontCompileOptions* options,
+                           V4FrontBuf* out_buf)
+{
+  Arena arena;
+  arena.init(options ? options->allocator : nullptr);
+  CodeBuf bc = {nullptr, 0, 0, &arena};
+  WordDict dict;
+  dict.init(&arena);
+  bool calls_ctx = false;
+  FrontErr err = FrontErr::OK;
 
-  // Copy token
-  size_t token_len = token_end - token_start;
-  if (token_len >= token_cap)
-    token_len = token_cap - 1;
+  for (uint32_t m = 0; m < count && err == FrontErr::OK; m++)
+  {
+    V4FrontBuf* buf = &units[m].buf;
+    uint32_t base = units[m].word_base;
+    for (int k = 0; k < buf->word_count && err == FrontErr::OK; k++)
+    {
+      V4FrontWord* word = &buf->words[k];
+      if (!batch_relocate(word->code, word->code_len, base, imports, ctx_count,
+                          &calls_ctx))
+      {
+        err = FrontErr::LinkFailed;
+        break;
+      }
+      uint8_t* code = static_cast<uint8_t*>(arena.alloc(word->code_len));
+      if (!code)
+      {
+        err = FrontErr::OutOfMemory;
+        break;
+      }
+      memcpy(code, word->code, word->code_len);
+      err = dict.add(word->name, strlen(word->name), code, word->code_len);
+      if (err == FrontErr::OK)
+        dict.entries[dict.count - 1].effect = word->effect;
+    }
+    if (err != FrontErr::OK)
+      break;
 
-  memcpy(token_out, token_start, token_len);
-  token_out[token_len] = '\0';
+    uint32_t size = static_cast<uint32_t>(buf->size);
+    if (!batch_relocate(buf->data, size, base, imports, ctx_count, &calls_ctx))
+      err = FrontErr::LinkFailed;
+    else if (m + 1 < count)
+      err = batch_chain_main(&arena, buf->data, size, &bc);
+    else
+      err = append_bytes(&bc, buf->data, size);
+  }
+  if (err == FrontErr::OK && count == 0)
+    err = append_byte(&bc, static_cast<uint8_t>(v4::Op::RET));
+
+  // The passes held back from the modules see the linked code
+  uint32_t flags = options ? options->flags | opt_level_flags(options->opt_level) : 0;
+  if (err == FrontErr::OK && (flags & V4FRONT_OPT_STRIP_UNUSED) && !calls_ctx)
+    err = strip_unused_words(&arena, &bc, &dict);
+  ProfileIndex profile;
+  if (err == FrontErr::OK && (flags & V4FRONT_OPT_HOT_LAYOUT) && options->profile &&
+      !calls_ctx)
+  {
+    err = profile.build(&arena, options->profile) ? FrontErr::OK : FrontErr::OutOfMemory;
+    if (err == FrontErr::OK)
+      err = layout_hot_words(&arena, &bc, &dict, &profile);
+  }
+  uint32_t super_count = options ? options->superinstruction_count : 0;
+  if (err == FrontErr::OK && super_count > 0)
+  {
+    err = fuse_superinstructions(&arena, options->superinstructions, super_count,
+                                 bc.data, &bc.size);
+    for (int i = 0; i < dict.count && err == FrontErr::OK; i++)
+      err = fuse_superinstructions(&arena, options->superinstructions, super_count,
+                                   dict.entries[i].code, &dict.entries[i].code_len);
+  }
+
+  if (err == FrontErr::OK)
+    err = build_output(&arena, &bc, &dict, nullptr, nullptr, out_buf);
+  arena.release();
+  return err;
 }
 
-// Helper: Extract surrounding context
-static void extract_context(const char* source, const char* error_pos, char* context_out,
-                            size_t context_cap)
+// Phase 2: register every importable word under a placeholder. On a name
+// defined twice, *dup_module and *dup_pos locate the second definition.
+static FrontErr batch_plan(const V4FrontContext* ctx, BatchUnit* units, uint32_t count,
+                           V4FrontContext* link, int* imports, int* ctx_count,
+                           uint32_t* dup_module, const char** dup_pos,
+                           uint32_t* yield_cell)
 {
-  if (!source || !error_pos || !context_out || context_cap == 0 || error_pos < source)
+  int n = 0;
+  const ContextWords* base = ctx ? ctx->words : nullptr;
+  for (int j = 0; base && j < base->word_count; j++)
   {
-    if (context_out && context_cap > 0)
-      context_out[0] = '\0';
-    return;
+    // Words with a negative VM index are ignored when compiling, too
+    int vm_idx = base->words[j].vm_word_idx;
+    if (vm_idx < 0)
+      continue;
+    if (n == INT16_MAX - kImportBase)
+      return FrontErr::DictionaryFull;
+    imports[n] = vm_idx;
+    v4front_err err =
+        v4front_context_register_word(link, base->words[j].name, kImportBase + n++);
+    if (err != 0)
+      return static_cast<FrontErr>(err);
   }
+  *ctx_count = n;
 
-  // Find start of line
-  const char* line_start = error_pos;
-  while (line_start > source && *(line_start - 1) != '\n')
-    line_start--;
+  // Modules allocate from ctx's HERE on, one after the other. A module that
+  // runs out stops the layout at the limit and reports it when compiled.
+  DataSpace data;
+  if (ctx)
+    data = ctx->data;
+  else
+    data.init(DATA_SPACE_BASE, DATA_SPACE_SIZE);
+  // The auto-yield counter comes first, whether or not a module needs it
+  if (yield_cell)
+  {
+    FrontErr err = data.allot(4, yield_cell);
+    if (err != FrontErr::OK)
+      return err;
+  }
 
-  // Find end of line
-  const char* line_end = error_pos;
-  while (*line_end && *line_end != '\n')
-    line_end++;
+  uint32_t words = 0;
+  for (uint32_t m = 0; m < count; m++)
+  {
+    BatchUnit* u = &units[m];
+    if (u->name_count >= static_cast<uint32_t>(kImportBase))
+    {
+      *dup_module = m;
+      return FrontErr::DictionaryFull;
+    }
+    u->word_base = words;
+    words += u->name_count;
+    u->space = data;
+    for (uint32_t k = 0; k < u->data_count; k++)
+    {
+      const BatchData& d = u->data[k];
+      uint32_t addr;
+      if ((d.align && data.align_to(d.align) != FrontErr::OK) ||
+          data.allot(d.bytes, &addr) != FrontErr::OK)
+        data.here = data.limit;
+    }
+    u->data_end = data.here;
 
-  // Copy context (trimmed to fit)
-  size_t line_len = line_end - line_start;
-  if (line_len >= context_cap)
-    line_len = context_cap - 1;
+    for (uint32_t k = 0; k < u->name_count; k++)
+    {
+      // Names from MAX_WORD_NAME_LEN on are rejected by the compiler itself
+      const BatchName& name = u->names[k];
+      if (name.len >= MAX_WORD_NAME_LEN)
+        continue;
+      char text[MAX_WORD_NAME_LEN];
+      memcpy(text, name.name, name.len);
+      text[name.len] = '\0';
 
-  memcpy(context_out, line_start, line_len);
-  context_out[line_len] = '\0';
+      int prev = v4front_context_find_word(link, text);
+      if (prev >= kImportBase + *ctx_count)
+      {
+        *dup_module = m;
+        *dup_pos = name.name;
+        return FrontErr::DuplicateWord;
+      }
+      if (n == INT16_MAX - kImportBase || words > MAX_WORDS)
+        return FrontErr::DictionaryFull;
+      imports[n] = static_cast<int>(u->word_base + k);
+      v4front_err err = v4front_context_register_word(link, text, kImportBase + n++);
+      if (err != 0)
+        return static_cast<FrontErr>(err);
+    }
+  }
+  return FrontErr::OK;
 }
 
-// Helper: Fill V4FrontError structure
-static void fill_error_info(V4FrontError* error, const char* source,
-                            const char* error_pos, FrontErr code)
+extern "C" v4front_err v4front_compile_batch(const V4FrontContext* ctx,
+                                             const V4FrontModule* modules,
+                                             uint32_t count,
+                                             const V4FrontCompileOptions* options,
+                                             uint32_t threads, V4FrontBuf* out_buf,
+                                             V4FrontError* error_out,
+                                             uint32_t* error_module)
 {
-  if (!error)
-    return;
-
-  error->code = front_err_to_int(code);
-
-  // Copy error message
-  const char* msg = front_err_str(code);
-  size_t msg_len = strlen(msg);
-  if (msg_len >= sizeof(error->message))
-    msg_len = sizeof(error->message) - 1;
-  memcpy(error->message, msg, msg_len);
-  error->message[msg_len] = '\0';
-
-  // Calculate position
-  if (source && error_pos && error_pos >= source)
+  if (error_module)
+    *error_module = count;
+  if (!out_buf || (count > 0 && !modules))
   {
-    error->position = (int)(error_pos - source);
-    calculate_line_column(source, error_pos, &error->line, &error->column);
-    extract_error_token(source, error_pos, error->token, sizeof(error->token));
-    extract_context(source, error_pos, error->context, sizeof(error->context));
+    fill_error_info(error_out, nullptr, 0, nullptr, FrontErr::BufferTooSmall);
+    return front_err_to_int(FrontErr::BufferTooSmall);
   }
-  else
+  out_buf->data = nullptr;
+  out_buf->size = 0;
+  out_buf->words = nullptr;
+  out_buf->word_count = 0;
+  out_buf->block = nullptr;
+  out_buf->relocs = nullptr;
+  out_buf->reloc_count = 0;
+  out_buf->source_map = nullptr;
+  out_buf->source_map_size = 0;
+
+  // Options are checked once, before any work is spread out. Placeholders
+  // already stand for the imports, so there is no relocation table; modules
+  // are linked as code, so there is no source map either.
+  if (options && (!superinsn_table_valid(options->superinstructions,
+                                         options->superinstruction_count) ||
+                  (options->flags & (V4FRONT_OPT_RELOCS | V4FRONT_OPT_SOURCE_MAP))))
   {
-    error->position = -1;
-    error->line = -1;
-    error->column = -1;
-    error->token[0] = '\0';
-    error->context[0] = '\0';
+    fill_error_info(error_out, nullptr, 0, nullptr, FrontErr::InvalidOption);
+    return front_err_to_int(FrontErr::InvalidOption);
   }
-}
 
-extern "C" v4front_err v4front_compile_ex(const char* source, V4FrontBuf* out_buf,
-                                          V4FrontError* error_out)
-{
-  if (!out_buf)
+  BatchUnit* units = static_cast<BatchUnit*>(malloc(sizeof(BatchUnit) * (count + 1)));
+  V4FrontContext* link = v4front_context_create();
+  int ctx_words = ctx ? ctx->words->word_count : 0;
+  int* imports = nullptr;
+  FrontErr err = (units && link) ? FrontErr::OK : FrontErr::OutOfMemory;
+  for (uint32_t m = 0; units && m < count; m++)
   {
-    if (error_out)
-    {
-      error_out->code = front_err_to_int(FrontErr::BufferTooSmall);
-      snprintf(error_out->message, sizeof(error_out->message), "output buffer is NULL");
-      error_out->position = -1;
-      error_out->line = -1;
-      error_out->column = -1;
-      error_out->token[0] = '\0';
-      error_out->context[0] = '\0';
-    }
-    return front_err_to_int(FrontErr::BufferTooSmall);
+    BatchUnit* u = &units[m];
+    u->source = modules[m].source ? modules[m].source : "";
+    u->len = modules[m].source ? modules[m].len : 0;
+    u->arena.init(options ? options->allocator : nullptr);
+    u->names = nullptr;
+    u->name_count = 0;
+    u->name_cap = 0;
+    u->data = nullptr;
+    u->data_count = 0;
+    u->data_cap = 0;
+    u->buf = {nullptr, 0, nullptr, 0, nullptr, nullptr, 0, nullptr, 0};
+    u->err = FrontErr::OK;
+    u->error_pos = nullptr;
   }
 
+  Batch batch = {units, nullptr, options, 0};
+  uint32_t failed = count;  // Module of the reported error
   const char* error_pos = nullptr;
-  FrontErr result = compile_internal(source, out_buf, nullptr, error_out, &error_pos);
-
-  if (result != FrontErr::OK && error_out)
+  if (err == FrontErr::OK)
+    parallel_for(count, threads, batch_scan, &batch);
+  for (uint32_t m = 0; err == FrontErr::OK && m < count; m++)
   {
-    fill_error_info(error_out, source, error_pos, result);
+    if (units[m].err != FrontErr::OK)
+    {
+      err = units[m].err;
+      failed = m;
+    }
   }
 
-  return front_err_to_int(result);
-}
+  if (err == FrontErr::OK)
+  {
+    size_t names = 0;
+    for (uint32_t m = 0; m < count; m++)
+      names += units[m].name_count;
+    imports = static_cast<int*>(malloc(sizeof(int) * (ctx_words + names + 1)));
+    if (!imports)
+      err = FrontErr::OutOfMemory;
+  }
+  int ctx_count = 0;
+  if (err == FrontErr::OK)
+    err = batch_plan(ctx, units, count, link, imports, &ctx_count, &failed, &error_pos,
+                     (options && (options->flags & V4FRONT_OPT_AUTO_YIELD))
+                         ? &batch.yield_cell
+                         : nullptr);
+  if (err == FrontErr::OK)
+  {
+    batch.link_ctx = v4front_context_snapshot(link);
+    if (!batch.link_ctx)
+      err = FrontErr::OutOfMemory;
+  }
 
-extern "C" v4front_err v4front_compile_with_context_ex(V4FrontContext* ctx,
-                                                       const char* source,
-                                                       V4FrontBuf* out_buf,
-                                                       V4FrontError* error_out)
-{
-  if (!out_buf)
+  if (err == FrontErr::OK)
   {
-    if (error_out)
+    parallel_for(count, threads, batch_compile, &batch);
+    for (uint32_t m = 0; err == FrontErr::OK && m < count; m++)
     {
-      error_out->code = front_err_to_int(FrontErr::BufferTooSmall);
-      snprintf(error_out->message, sizeof(error_out->message), "output buffer is NULL");
-      error_out->position = -1;
-      error_out->line = -1;
-      error_out->column = -1;
-      error_out->token[0] = '\0';
-      error_out->context[0] = '\0';
+      if (units[m].err != FrontErr::OK)
+      {
+        err = units[m].err;
+        failed = m;
+        error_pos = units[m].error_pos;
+      }
     }
-    return front_err_to_int(FrontErr::BufferTooSmall);
   }
+  if (err == FrontErr::OK)
+    err = batch_link(units, count, imports, ctx_count, options, out_buf);
 
-  const char* error_pos = nullptr;
-  FrontErr result = compile_internal(source, out_buf, ctx, error_out, &error_pos);
-
-  if (result != FrontErr::OK && error_out)
+  if (err != FrontErr::OK)
   {
-    fill_error_info(error_out, source, error_pos, result);
+    const BatchUnit* u = failed < count ? &units[failed] : nullptr;
+    fill_error_info(error_out, u ? u->source : nullptr, u ? u->len : 0, error_pos, err);
+    if (error_module)
+      *error_module = failed;
   }
 
-  return front_err_to_int(result);
+  for (uint32_t m = 0; units && m < count; m++)
+  {
+    v4front_free(&units[m].buf);
+    units[m].arena.release();
+  }
+  v4front_context_destroy(batch.link_ctx);
+  v4front_context_destroy(link);
+  free(imports);
+  free(units);
+  return front_err_to_int(err);
 }
 
 extern "C" void v4front_format_error(const V4FrontError* error, const char* source,
@@ -0,0 +1,234 @@
+#include "compress.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "v4front/compile.h"
+
+namespace v4front
+{
+
+namespace
+{
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 65535;
+constexpr uint32_t kHashBits = 12;
+constexpr uint32_t kNoEntry = UINT32_MAX;
+
+uint32_t hash4(const uint8_t* p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// Extension bytes of a nibble that reached 15
+uint8_t* put_length(uint8_t* out, size_t rest)
+{
+  while (rest >= 255)
+  {
+    *out++ = 255;
+    rest -= 255;
+  }
+  *out++ = static_cast<uint8_t>(rest);
+  return out;
+}
+
+// One sequence; match_len == 0 for the final, literals-only one
+uint8_t* put_sequence(uint8_t* out, const uint8_t* literals, size_t literal_len,
+                      size_t offset, size_t match_len)
+{
+  size_t lit_nibble = literal_len < 15 ? literal_len : 15;
+  size_t match_nibble = 0;
+  if (match_len)
+    match_nibble = match_len - kMinMatch < 15 ? match_len - kMinMatch : 15;
+  *out++ = static_cast<uint8_t>((lit_nibble << 4) | match_nibble);
+  if (lit_nibble == 15)
+    out = put_length(out, literal_len - 15);
+  memcpy(out, literals, literal_len);
+  out += literal_len;
+  if (match_len)
+  {
+    *out++ = static_cast<uint8_t>(offset);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    if (match_nibble == 15)
+      out = put_length(out, match_len - kMinMatch - 15);
+  }
+  return out;
+}
+
+// Decoder states
+enum : uint8_t
+{
+  kToken,
+  kLiteralExt,
+  kLiterals,
+  kOffsetLo,
+  kOffsetHi,
+  kMatchExt,
+  kDone,
+  kError,
+};
+
+// After the literal count is known: literals, or the end of a sequence
+void after_literal_count(V4FrontInflater* z)
+{
+  if (z->literals > z->cap - z->out)
+    z->state = kError;
+  else if (z->literals)
+    z->state = kLiterals;
+  else
+    z->state = z->out == z->cap ? kDone : kOffsetLo;
+}
+
+void copy_match(V4FrontInflater* z)
+{
+  if (z->offset == 0 || z->offset > z->out || z->match_len > z->cap - z->out)
+  {
+    z->state = kError;
+    return;
+  }
+  // Byte by byte: a match may overlap the bytes it produces
+  uint8_t* p = z->dst + z->out;
+  const uint8_t* from = p - z->offset;
+  for (uint32_t i = 0; i < z->match_len; i++)
+    p[i] = from[i];
+  z->out += z->match_len;
+  z->state = z->out == z->cap ? kDone : kToken;
+}
+
+}  // namespace
+
+size_t compress(const uint8_t* src, size_t n, uint8_t* dst)
+{
+  if (n == 0)
+    return 0;
+
+  uint32_t* table = static_cast<uint32_t*>(malloc(sizeof(uint32_t) << kHashBits));
+  if (!table)
+    return 0;
+  memset(table, 0xff, sizeof(uint32_t) << kHashBits);
+
+  uint8_t* out = dst;
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + kMinMatch <= n)
+  {
+    uint32_t h = hash4(src + pos);
+    uint32_t candidate = table[h];
+    table[h] = static_cast<uint32_t>(pos);
+    if (candidate == kNoEntry || pos - candidate > kMaxOffset ||
+        memcmp(src + candidate, src + pos, kMinMatch) != 0)
+    {
+      pos++;
+      continue;
+    }
+
+    size_t len = kMinMatch;
+    while (pos + len < n && src[candidate + len] == src[pos + len])
+      len++;
+    out = put_sequence(out, src + anchor, pos - anchor, pos - candidate, len);
+
+    // Index the matched bytes too; sections are small, so this is cheap
+    for (size_t i = pos + 1; i < pos + len && i + kMinMatch <= n; i++)
+      table[hash4(src + i)] = static_cast<uint32_t>(i);
+    pos += len;
+    anchor = pos;
+  }
+  if (anchor < n)
+    out = put_sequence(out, src + anchor, n - anchor, 0, 0);
+
+  free(table);
+  return static_cast<size_t>(out - dst);
+}
+
+}  // namespace v4front
+
+using namespace v4front;
+
+extern "C" void v4front_inflate_init(V4FrontInflater* z, uint8_t* dst, size_t cap)
+{
+  memset(z, 0, sizeof(*z));
+  z->dst = dst;
+  z->cap = cap;
+  z->state = cap ? kToken : kDone;
+}
+
+extern "C" v4front_err v4front_inflate_feed(V4FrontInflater* z, const uint8_t* in,
+                                            size_t len)
+{
+  size_t i = 0;
+  while (i < len && z->state != kError)
+  {
+    switch (z->state)
+    {
+      case kToken:
+        z->token = in[i++];
+        z->literals = z->token >> 4;
+        z->match_len = (z->token & 15u) + kMinMatch;
+        if (z->literals == 15)
+          z->state = kLiteralExt;
+        else
+          after_literal_count(z);
+        break;
+
+      case kLiteralExt:
+      {
+        uint8_t b = in[i++];
+        z->literals += b;
+        if (z->literals > z->cap)
+          z->state = kError;
+        else if (b != 255)
+          after_literal_count(z);
+        break;
+      }
+
+      case kLiterals:
+      {
+        size_t n = len - i < z->literals ? len - i : z->literals;
+        memcpy(z->dst + z->out, in + i, n);
+        i += n;
+        z->out += n;
+        z->literals -= static_cast<uint32_t>(n);
+        if (z->literals == 0)
+          z->state = z->out == z->cap ? kDone : kOffsetLo;
+        break;
+      }
+
+      case kOffsetLo:
+        z->offset = in[i++];
+        z->state = kOffsetHi;
+        break;
+
+      case kOffsetHi:
+        z->offset |= static_cast<uint32_t>(in[i++]) << 8;
+        if ((z->token & 15u) == 15)
+          z->state = kMatchExt;
+        else
+          copy_match(z);
+        break;
+
+      case kMatchExt:
+      {
+        uint8_t b = in[i++];
+        z->match_len += b;
+        if (z->match_len > z->cap)
+          z->state = kError;
+        else if (b != 255)
+          copy_match(z);
+        break;
+      }
+
+      default:  // kDone: input past the end of the stream
+        z->state = kError;
+        break;
+    }
+  }
+  return z->state == kError ? -7 : 0;
+}
+
+extern "C" v4front_err v4front_inflate_finish(const V4FrontInflater* z)
+{
+  return z->state == kDone ? 0 : -7;
+}
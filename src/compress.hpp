@@ -0,0 +1,33 @@
+#pragma once
+// Internal compressor for .v4b code sections (V4B_FLAG_COMPRESSED).
+//
+// The encoding is a byte-oriented LZ77 in the style of LZ4, chosen for a
+// decoder that fits in a few registers (see V4FrontInflater):
+//
+//  - A stream is a series of sequences. Each starts with a token byte: the
+//    high nibble is the literal count, the low nibble the match length - 4.
+//  - A nibble of 15 is extended by the following bytes, each added to it,
+//    until a byte below 255.
+//  - The token (and literal count extension) is followed by the literals,
+//    then a 2-byte little-endian match offset (1..65535 bytes back into the
+//    output), then the match length extension.
+//  - The stream ends when the output reaches the uncompressed size, right
+//    after either the literals or the match of the last sequence.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4front
+{
+
+// Largest compressed size of n bytes
+static inline size_t compress_bound(size_t n)
+{
+  return n + n / 255 + 16;
+}
+
+// Compress n bytes of src into dst (compress_bound(n) bytes); returns the
+// compressed size, or 0 if scratch memory cannot be allocated (n > 0)
+size_t compress(const uint8_t* src, size_t n, uint8_t* dst);
+
+}  // namespace v4front
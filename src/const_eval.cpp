@@ -0,0 +1,427 @@
+#include "const_eval.hpp"
+
+#include "op_info.hpp"
+#include "v4/opcodes.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+constexpr int kMaxFrames = 16;     // Deepest call nesting
+constexpr int kReturnCells = 64;   // Return stack (>R) cells
+constexpr uint32_t kLocals = 32;   // Local slots of each frame
+
+// One running word
+struct Frame
+{
+  const uint8_t* code;
+  uint32_t len;
+  uint32_t pc;
+  int rbase;              // Return stack depth at the call
+  uint32_t locals_set;    // Bit per slot written so far
+  int32_t locals[kLocals];
+};
+
+// Whether the interpreter runs opcode (CALL and locals are checked further)
+bool evaluable_op(uint8_t opcode)
+{
+  switch (static_cast<v4::Op>(opcode))
+  {
+    case v4::Op::LIT:
+    case v4::Op::LIT0:
+    case v4::Op::LIT1:
+    case v4::Op::LITN1:
+    case v4::Op::DUP:
+    case v4::Op::DROP:
+    case v4::Op::SWAP:
+    case v4::Op::OVER:
+    case v4::Op::TOR:
+    case v4::Op::FROMR:
+    case v4::Op::RFETCH:
+    case v4::Op::ADD:
+    case v4::Op::SUB:
+    case v4::Op::MUL:
+    case v4::Op::DIV:
+    case v4::Op::MOD:
+    case v4::Op::DIVU:
+    case v4::Op::MODU:
+    case v4::Op::INC:
+    case v4::Op::DEC:
+    case v4::Op::EQ:
+    case v4::Op::NE:
+    case v4::Op::LT:
+    case v4::Op::LE:
+    case v4::Op::GT:
+    case v4::Op::GE:
+    case v4::Op::LTU:
+    case v4::Op::LEU:
+    case v4::Op::AND:
+    case v4::Op::OR:
+    case v4::Op::XOR:
+    case v4::Op::INVERT:
+    case v4::Op::SHL:
+    case v4::Op::SHR:
+    case v4::Op::SAR:
+    case v4::Op::JMP:
+    case v4::Op::JZ:
+    case v4::Op::JNZ:
+    case v4::Op::CALL:
+    case v4::Op::RET:
+    case v4::Op::LGET:
+    case v4::Op::LSET:
+    case v4::Op::LTEE:
+    case v4::Op::LGET0:
+    case v4::Op::LGET1:
+    case v4::Op::LSET0:
+    case v4::Op::LSET1:
+    case v4::Op::LINC:
+    case v4::Op::LDEC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+int32_t read_i32(const uint8_t* p)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(p[0]) |
+                              (static_cast<uint32_t>(p[1]) << 8) |
+                              (static_cast<uint32_t>(p[2]) << 16) |
+                              (static_cast<uint32_t>(p[3]) << 24));
+}
+
+uint16_t read_u16(const uint8_t* p)
+{
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// Result of a binary opcode on a and b; false if it traps or is not defined
+bool binary(uint8_t opcode, int32_t a, int32_t b, int32_t* out)
+{
+  const uint32_t ua = static_cast<uint32_t>(a);
+  const uint32_t ub = static_cast<uint32_t>(b);
+  const int32_t flag_true = -1;
+  switch (static_cast<v4::Op>(opcode))
+  {
+    case v4::Op::ADD:
+      *out = static_cast<int32_t>(ua + ub);
+      return true;
+    case v4::Op::SUB:
+      *out = static_cast<int32_t>(ua - ub);
+      return true;
+    case v4::Op::MUL:
+      *out = static_cast<int32_t>(ua * ub);
+      return true;
+    case v4::Op::DIV:
+    case v4::Op::MOD:
+      if (b == 0 || (a == INT32_MIN && b == -1))
+        return false;
+      *out = opcode == static_cast<uint8_t>(v4::Op::DIV) ? a / b : a % b;
+      return true;
+    case v4::Op::DIVU:
+    case v4::Op::MODU:
+      if (ub == 0)
+        return false;
+      *out = static_cast<int32_t>(opcode == static_cast<uint8_t>(v4::Op::DIVU) ? ua / ub
+                                                                               : ua % ub);
+      return true;
+    case v4::Op::AND:
+      *out = a & b;
+      return true;
+    case v4::Op::OR:
+      *out = a | b;
+      return true;
+    case v4::Op::XOR:
+      *out = a ^ b;
+      return true;
+    case v4::Op::SHL:
+      if (ub > 31)
+        return false;
+      *out = static_cast<int32_t>(ua << ub);
+      return true;
+    case v4::Op::SHR:
+      if (ub > 31)
+        return false;
+      *out = static_cast<int32_t>(ua >> ub);
+      return true;
+    case v4::Op::SAR:
+      if (ub > 31)
+        return false;
+      *out = a < 0 ? ~static_cast<int32_t>(~ua >> ub) : static_cast<int32_t>(ua >> ub);
+      return true;
+    case v4::Op::EQ:
+      *out = a == b ? flag_true : 0;
+      return true;
+    case v4::Op::NE:
+      *out = a != b ? flag_true : 0;
+      return true;
+    case v4::Op::LT:
+      *out = a < b ? flag_true : 0;
+      return true;
+    case v4::Op::LE:
+      *out = a <= b ? flag_true : 0;
+      return true;
+    case v4::Op::GT:
+      *out = a > b ? flag_true : 0;
+      return true;
+    case v4::Op::GE:
+      *out = a >= b ? flag_true : 0;
+      return true;
+    case v4::Op::LTU:
+      *out = ua < ub ? flag_true : 0;
+      return true;
+    case v4::Op::LEU:
+      *out = ua <= ub ? flag_true : 0;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Local slot the instruction at insn addresses
+uint32_t local_slot(const uint8_t* insn)
+{
+  switch (static_cast<v4::Op>(insn[0]))
+  {
+    case v4::Op::LGET0:
+    case v4::Op::LSET0:
+      return 0;
+    case v4::Op::LGET1:
+    case v4::Op::LSET1:
+      return 1;
+    default:
+      return insn[1];
+  }
+}
+
+class Interpreter
+{
+ public:
+  Interpreter(CalleeCode callee, const void* user, uint32_t callee_count,
+              EvalStack* stack)
+      : callee_(callee), user_(user), callee_count_(callee_count), s_(stack)
+  {
+  }
+
+  bool run(uint32_t entry, uint32_t max_steps)
+  {
+    if (!call(entry))
+      return false;
+    for (uint32_t steps = 0; steps < max_steps; steps++)
+    {
+      Frame& f = frames_[frame_count_ - 1];
+      if (f.pc >= f.len)
+        return false;  // Fell off the end
+      const uint8_t* insn = f.code + f.pc;
+      int operand = op_operand_len(insn[0]);
+      if (operand < 0 || f.pc + 1 + operand > f.len)
+        return false;
+      f.pc += 1 + operand;
+      if (!step(f, insn))
+        return false;
+      if (frame_count_ == 0)
+        return true;
+    }
+    return false;
+  }
+
+ private:
+  bool push(int32_t v)
+  {
+    if (s_->depth == kEvalStackCells)
+      return false;
+    s_->cells[s_->depth++] = v;
+    return true;
+  }
+
+  // Take n cells off the data stack (they stay readable at cells[depth..])
+  bool pop(int n)
+  {
+    if (s_->depth < n)
+      return false;
+    s_->depth -= n;
+    if (s_->depth < s_->low)
+      s_->low = s_->depth;
+    return true;
+  }
+
+  int32_t at(int i) const { return s_->cells[s_->depth + i]; }
+
+  bool call(uint32_t index)
+  {
+    uint32_t len = 0;
+    const uint8_t* code = index < callee_count_ ? callee_(user_, index, &len) : nullptr;
+    if (!code || frame_count_ == kMaxFrames)
+      return false;
+    Frame& f = frames_[frame_count_++];
+    f.code = code;
+    f.len = len;
+    f.pc = 0;
+    f.rbase = rdepth_;
+    f.locals_set = 0;
+    return true;
+  }
+
+  // Branch to the end of the instruction plus offset
+  static bool jump(Frame& f, const uint8_t* insn)
+  {
+    int64_t target =
+        static_cast<int64_t>(f.pc) + static_cast<int16_t>(read_u16(insn + 1));
+    if (target < 0 || target >= static_cast<int64_t>(f.len))
+      return false;
+    f.pc = static_cast<uint32_t>(target);
+    return true;
+  }
+
+  bool step(Frame& f, const uint8_t* insn)
+  {
+    const uint8_t opcode = insn[0];
+    int32_t r;
+    switch (static_cast<v4::Op>(opcode))
+    {
+      case v4::Op::LIT:
+        return push(read_i32(insn + 1));
+      case v4::Op::LIT0:
+        return push(0);
+      case v4::Op::LIT1:
+        return push(1);
+      case v4::Op::LITN1:
+        return push(-1);
+      case v4::Op::DUP:
+        return s_->depth > 0 && push(s_->cells[s_->depth - 1]);
+      case v4::Op::DROP:
+        return pop(1);
+      case v4::Op::SWAP:
+      {
+        if (!pop(2))
+          return false;
+        int32_t a = at(0), b = at(1);
+        return push(b) && push(a);
+      }
+      case v4::Op::OVER:
+      {
+        if (!pop(2))
+          return false;
+        int32_t a = at(0), b = at(1);
+        return push(a) && push(b) && push(a);
+      }
+      case v4::Op::TOR:
+        if (rdepth_ == kReturnCells || !pop(1))
+          return false;
+        rstack_[rdepth_++] = at(0);
+        return true;
+      case v4::Op::FROMR:
+        // A word may only take back what it put there itself
+        if (rdepth_ <= f.rbase)
+          return false;
+        return push(rstack_[--rdepth_]);
+      case v4::Op::RFETCH:
+        if (rdepth_ <= f.rbase)
+          return false;
+        return push(rstack_[rdepth_ - 1]);
+      case v4::Op::INC:
+        return pop(1) && push(static_cast<int32_t>(static_cast<uint32_t>(at(0)) + 1u));
+      case v4::Op::DEC:
+        return pop(1) && push(static_cast<int32_t>(static_cast<uint32_t>(at(0)) - 1u));
+      case v4::Op::INVERT:
+        return pop(1) && push(~at(0));
+      case v4::Op::JMP:
+        return jump(f, insn);
+      case v4::Op::JZ:
+      case v4::Op::JNZ:
+        if (!pop(1))
+          return false;
+        if ((at(0) == 0) == (opcode == static_cast<uint8_t>(v4::Op::JZ)))
+          return jump(f, insn);
+        return true;
+      case v4::Op::CALL:
+        return call(read_u16(insn + 1));
+      case v4::Op::RET:
+        if (rdepth_ != f.rbase)
+          return false;
+        frame_count_--;
+        return true;
+      case v4::Op::LGET:
+      case v4::Op::LGET0:
+      case v4::Op::LGET1:
+      {
+        uint32_t slot = local_slot(insn);
+        if (slot >= kLocals || !(f.locals_set & (1u << slot)))
+          return false;
+        return push(f.locals[slot]);
+      }
+      case v4::Op::LSET:
+      case v4::Op::LSET0:
+      case v4::Op::LSET1:
+      case v4::Op::LTEE:
+      {
+        uint32_t slot = local_slot(insn);
+        if (slot >= kLocals || !pop(1))
+          return false;
+        f.locals[slot] = at(0);
+        f.locals_set |= 1u << slot;
+        return opcode != static_cast<uint8_t>(v4::Op::LTEE) || push(at(0));
+      }
+      case v4::Op::LINC:
+      case v4::Op::LDEC:
+      {
+        uint32_t slot = local_slot(insn);
+        if (slot >= kLocals || !(f.locals_set & (1u << slot)))
+          return false;
+        uint32_t v = static_cast<uint32_t>(f.locals[slot]);
+        f.locals[slot] =
+            static_cast<int32_t>(opcode == static_cast<uint8_t>(v4::Op::LINC) ? v + 1u
+                                                                              : v - 1u);
+        return true;
+      }
+      default:
+        if (!pop(2) || !binary(opcode, at(0), at(1), &r))
+          return false;
+        return push(r);
+    }
+  }
+
+  CalleeCode callee_;
+  const void* user_;
+  uint32_t callee_count_;
+  EvalStack* s_;
+  Frame frames_[kMaxFrames];
+  int frame_count_ = 0;
+  int32_t rstack_[kReturnCells];
+  int rdepth_ = 0;
+};
+
+}  // namespace
+
+bool evaluable_code(const uint8_t* code, uint32_t len, uint32_t self_index,
+                    CalleeCode callee, const void* user, uint32_t callee_count)
+{
+  for (uint32_t pc = 0; pc < len;)
+  {
+    int operand = op_operand_len(code[pc]);
+    if (operand < 0 || pc + 1 + operand > len || !evaluable_op(code[pc]))
+      return false;
+    if (code[pc] == static_cast<uint8_t>(v4::Op::CALL))
+    {
+      uint32_t index = read_u16(code + pc + 1);
+      uint32_t callee_len;
+      if (index >= callee_count ||
+          (index != self_index && !callee(user, index, &callee_len)))
+        return false;
+    }
+    pc += 1 + operand;
+  }
+  return true;
+}
+
+bool eval_call(uint32_t entry, CalleeCode callee, const void* user,
+               uint32_t callee_count, uint32_t max_steps, EvalStack* stack)
+{
+  stack->low = stack->depth;
+  Interpreter interp(callee, user, callee_count, stack);
+  return interp.run(entry, max_steps);
+}
+
+}  // namespace v4front
@@ -0,0 +1,47 @@
+#pragma once
+// Internal compile-time evaluation of words (V4FRONT_OPT_EVAL).
+//
+//  - A small interpreter for the opcodes of a definition as compiled at ;
+//    (before the passes and fusion): literals, stack and return-stack
+//    shuffles, arithmetic, comparisons, jumps, locals and calls of other
+//    words it may run.
+//  - Anything whose result the compiler cannot know, or that would differ
+//    or trap at runtime, stops the evaluation and the call is compiled as
+//    usual: memory access, SYS, task operations, division by zero,
+//    out-of-range shift counts, reads of unset locals, return-stack use
+//    across a call, stack overflow and running out of steps.
+
+#include <cstdint>
+
+namespace v4front
+{
+
+// Code of the word a CALL operand names, or nullptr if it may not be run; index
+// is below callee_count
+typedef const uint8_t* (*CalleeCode)(const void* user, uint32_t index, uint32_t* len);
+
+// Cells the evaluation's data stack holds
+constexpr int kEvalStackCells = 64;
+
+// Data stack of an evaluation. The caller fills cells[0, depth) with the known
+// values under the call, top last; low is the lowest depth the word reached
+// (the values it consumed start there).
+struct EvalStack
+{
+  int32_t cells[kEvalStackCells];
+  int depth;
+  int low;
+};
+
+// Whether code[0, len) only uses opcodes the interpreter runs. CALL operands
+// must be self_index or a word callee(user, operand) accepts, below callee_count.
+bool evaluable_code(const uint8_t* code, uint32_t len, uint32_t self_index,
+                    CalleeCode callee, const void* user, uint32_t callee_count);
+
+// Run the word with CALL operand entry on *stack for at most max_steps
+// instructions. Returns false (leaving *stack undefined) if the run stopped
+// before the word returned.
+bool eval_call(uint32_t entry, CalleeCode callee, const void* user,
+               uint32_t callee_count, uint32_t max_steps, EvalStack* stack);
+
+}  // namespace v4front
@@ -1,10 +1,9 @@
 #include "v4front/disasm.hpp"
 
-#include <cassert>
-#include <cinttypes>
+#include "v4front/disasm.h"
+
 #include <cstdio>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -20,184 +19,236 @@ namespace v4front
 #define IDX16 ImmKind::Idx16
 
 /**
- * @brief Lookup OpInfo for given opcode.
- *
- * Generated from opcodes.def at compile-time.
+ * @brief OpInfo of every opcode value, generated from opcodes.def at compile time.
  */
-static inline OpInfo get_info(uint8_t opcode)
+struct OpInfoTable
 {
-  switch (opcode)
-  {
-    // clang-format off
-#define OP(NAME, CODE, IMM) \
-  case CODE:                \
-    return OpInfo{#NAME, CODE, IMM};
+  OpInfo entries[256];
+};
+
+static constexpr OpInfoTable make_op_info_table()
+{
+  OpInfoTable t{};
+  for (int i = 0; i < 256; i++)
+    t.entries[i] = OpInfo{"???", static_cast<uint8_t>(i), ImmKind::None};
+#define OP(NAME, CODE, IMM) t.entries[CODE] = OpInfo{#NAME, CODE, IMM};
 #include "v4/opcodes.def"
 #undef OP
-// clang-format off
-    default:
-      return OpInfo{"???", opcode, ImmKind::None};
-  }
+  return t;
 }
 
-// Helpers to read little-endian values safely
-static inline bool read_u8(const uint8_t* p, size_t len, size_t off, uint8_t& v)
-{
-  if (off + 1 > len)
-    return false;
-  v = p[off];
-  return true;
-}
+static constexpr OpInfoTable kOpInfo = make_op_info_table();
+
+#undef NO_IMM
+#undef IMM8
+#undef IMM16
+#undef IMM32
+#undef REL16
+#undef IDX16
 
-static inline bool read_i8(const uint8_t* p, size_t len, size_t off, int8_t& v)
+const OpInfo& op_info(uint8_t opcode)
 {
-  uint8_t t;
-  if (!read_u8(p, len, off, t))
-    return false;
-  v = static_cast<int8_t>(t);
-  return true;
+  return kOpInfo.entries[opcode];
 }
 
-static inline bool read_i16(const uint8_t* p, size_t len, size_t off, int16_t& v)
+/**
+ * @brief Immediate bytes of each ImmKind.
+ */
+static inline size_t imm_size(ImmKind kind)
 {
-  if (off + 2 > len)
-    return false;
-  v = static_cast<int16_t>(static_cast<uint16_t>(p[off]) |
-                           (static_cast<uint16_t>(p[off + 1]) << 8));
-  return true;
+  switch (kind)
+  {
+    case ImmKind::None:
+      return 0;
+    case ImmKind::I8:
+      return 1;
+    case ImmKind::I16:
+    case ImmKind::Rel16:
+    case ImmKind::Idx16:
+      return 2;
+    case ImmKind::I32:
+      return 4;
+  }
+  return 0;
 }
 
-static inline bool read_i32(const uint8_t* p, size_t len, size_t off, int32_t& v)
+size_t decode_one(const uint8_t* code, size_t len, size_t pc, DecodedInsn& insn)
 {
-  if (off + 4 > len)
-    return false;
-  v = static_cast<int32_t>(static_cast<uint32_t>(p[off]) |
-                           (static_cast<uint32_t>(p[off + 1]) << 8) |
-                           (static_cast<uint32_t>(p[off + 2]) << 16) |
-                           (static_cast<uint32_t>(p[off + 3]) << 24));
-  return true;
+  if (pc >= len)
+    return 0;
+
+  const OpInfo& info = kOpInfo.entries[code[pc]];
+  const size_t imm = imm_size(info.imm);
+  insn.pc = pc;
+  insn.opcode = code[pc];
+  insn.imm_kind = info.imm;
+  insn.imm = 0;
+  insn.truncated = pc + 1 + imm > len;
+  if (insn.truncated)
+  {
+    insn.length = static_cast<uint8_t>(len - pc);  // The rest of the buffer
+    return insn.length;
+  }
+
+  const uint8_t* p = code + pc + 1;
+  switch (imm)
+  {
+    case 1:
+      insn.imm = static_cast<int8_t>(p[0]);
+      break;
+    case 2:
+      insn.imm = static_cast<int16_t>(static_cast<uint16_t>(p[0] | (p[1] << 8)));
+      break;
+    case 4:
+      insn.imm = static_cast<int32_t>(
+          static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+          (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24));
+      break;
+    default:
+      break;
+  }
+  insn.length = static_cast<uint8_t>(1 + imm);
+  return insn.length;
 }
 
-/**
- * @brief Append hexadecimal address (4 digits) to output stream.
- */
-static inline void append_hex_addr(std::ostringstream& oss, size_t addr)
+size_t decode(const uint8_t* code, size_t len, size_t pc, DecodedInsn* out, size_t cap)
 {
-  oss << std::hex << std::setw(4) << std::setfill('0') << addr
-      << std::dec;  // restore decimal
+  size_t n = 0;
+  while (n < cap)
+  {
+    const size_t consumed = decode_one(code, len, pc, out[n]);
+    if (consumed == 0)
+      break;
+    pc += consumed;
+    n++;
+  }
+  return n;
 }
 
 /**
- * @brief Disassemble one instruction at PC and produce a human-readable line.
+ * @brief Bounded writer into a caller buffer (counts what does not fit too).
  */
-size_t disasm_one(const uint8_t* code, size_t len, size_t pc, std::string& out)
+struct LineWriter
 {
-  std::ostringstream oss;
-  if (pc >= len)
+  char* buf;
+  size_t cap;
+  size_t len;
+
+  void put(char c)
   {
-    out.clear();
-    return 0;
+    if (len + 1 < cap)
+      buf[len] = c;
+    len++;
+  }
+
+  void put(const char* s)
+  {
+    while (*s)
+      put(*s++);
+  }
+
+  // Lowercase hexadecimal, zero-padded to at least 4 digits
+  void hex_addr(size_t v)
+  {
+    char digits[2 * sizeof(size_t)];
+    int n = 0;
+    do
+    {
+      digits[n++] = "0123456789abcdef"[v & 0xF];
+      v >>= 4;
+    } while (v);
+    for (int i = n; i < 4; i++)
+      put('0');
+    while (n > 0)
+      put(digits[--n]);
+  }
+
+  void dec(int32_t v)
+  {
+    char digits[10];
+    int n = 0;
+    uint32_t u = v < 0 ? 0u - static_cast<uint32_t>(v) : static_cast<uint32_t>(v);
+    do
+    {
+      digits[n++] = static_cast<char>('0' + u % 10);
+      u /= 10;
+    } while (u);
+    if (v < 0)
+      put('-');
+    while (n > 0)
+      put(digits[--n]);
   }
 
-  const uint8_t opcode = code[pc];
-  const OpInfo info = get_info(opcode);
+  size_t finish()
+  {
+    if (cap > 0)
+      buf[len < cap ? len : cap - 1] = '\0';
+    return len;
+  }
+};
 
-  // Print address and mnemonic
-  append_hex_addr(oss, pc);
-  oss << ": " << std::left << std::setw(8) << info.name;
+size_t format_insn(const DecodedInsn& insn, char* buf, size_t cap)
+{
+  LineWriter w = {buf, cap, 0};
+  const OpInfo& info = kOpInfo.entries[insn.opcode];
 
-  size_t consumed = 1;  // opcode itself
+  // Address and mnemonic, padded to 8 columns
+  w.hex_addr(insn.pc);
+  w.put(": ");
+  w.put(info.name);
+  for (size_t n = strlen(info.name); n < 8; n++)
+    w.put(' ');
 
-  // Decode immediate operand if present
-  switch (info.imm)
+  if (insn.truncated)
+  {
+    static const char* const kTrunc[] = {"",
+                                         " <trunc-i8>",
+                                         " <trunc-i16>",
+                                         " <trunc-i32>",
+                                         " <trunc-rel16>",
+                                         " <trunc-idx16>"};
+    w.put(kTrunc[static_cast<int>(insn.imm_kind)]);
+    return w.finish();
+  }
+
+  switch (insn.imm_kind)
   {
     case ImmKind::None:
       break;
-
     case ImmKind::I8:
-    {
-      int8_t v;
-      if (read_i8(code, len, pc + consumed, v))
-      {
-        oss << " " << static_cast<int>(v);
-        consumed += 1;
-      }
-      else
-      {
-        oss << " <trunc-i8>";
-        consumed = len - pc;
-      }
-      break;
-    }
-
     case ImmKind::I16:
-    {
-      int16_t v;
-      if (read_i16(code, len, pc + consumed, v))
-      {
-        oss << " " << v;
-        consumed += 2;
-      }
-      else
-      {
-        oss << " <trunc-i16>";
-        consumed = len - pc;
-      }
-      break;
-    }
-
     case ImmKind::I32:
-    {
-      int32_t v;
-      if (read_i32(code, len, pc + consumed, v))
-      {
-        oss << " " << v;
-        consumed += 4;
-      }
-      else
-      {
-        oss << " <trunc-i32>";
-        consumed = len - pc;
-      }
+      w.put(' ');
+      w.dec(insn.imm);
       break;
-    }
-
     case ImmKind::Rel16:
-    {
-      int16_t off;
-      if (read_i16(code, len, pc + consumed, off))
-      {
-        const size_t target = static_cast<size_t>(pc + consumed + 2 + off);
-        oss << " " << (off >= 0 ? "+" : "") << off << " ; -> ";
-        append_hex_addr(oss, target);
-        consumed += 2;
-      }
-      else
-      {
-        oss << " <trunc-rel16>";
-        consumed = len - pc;
-      }
+      w.put(insn.imm >= 0 ? " +" : " ");
+      w.dec(insn.imm);
+      w.put(" ; -> ");
+      w.hex_addr(static_cast<size_t>(insn.pc + insn.length + insn.imm));
       break;
-    }
-
     case ImmKind::Idx16:
-    {
-      int16_t idx;
-      if (read_i16(code, len, pc + consumed, idx))
-      {
-        oss << " @" << idx;  // CALL idx16
-        consumed += 2;
-      }
-      else
-      {
-        oss << " <trunc-idx16>";
-        consumed = len - pc;
-      }
+      w.put(" @");  // CALL idx16
+      w.dec(insn.imm);
       break;
-    }
   }
+  return w.finish();
+}
 
-  out = oss.str();
+/**
+ * @brief Disassemble one instruction at PC and produce a human-readable line.
+ */
+size_t disasm_one(const uint8_t* code, size_t len, size_t pc, std::string& out)
+{
+  DecodedInsn insn;
+  const size_t consumed = decode_one(code, len, pc, insn);
+  if (consumed == 0)
+  {
+    out.clear();
+    return 0;
+  }
+  char line[kDisasmLineMax];
+  out.assign(line, format_insn(insn, line, sizeof(line)));
   return consumed;
 }
 
@@ -225,17 +276,58 @@ std::vector<std::string> disasm_all(const uint8_t* code, size_t len)
  */
 void disasm_print(const uint8_t* code, size_t len, std::FILE* fp)
 {
+  DecodedInsn insn;
+  char line[kDisasmLineMax];
   size_t pc = 0;
   while (pc < len)
   {
-    std::string line;
-    const size_t c = disasm_one(code, len, pc, line);
+    const size_t c = decode_one(code, len, pc, insn);
     if (c == 0)
       break;
-    std::fputs(line.c_str(), fp);
+    format_insn(insn, line, sizeof(line));
+    std::fputs(line, fp);
     std::fputc('\n', fp);
     pc += c;
   }
 }
 
 }  // namespace v4front
+
+/**
+ * @brief C API wrappers (see v4front/disasm.h).
+ */
+extern "C" void v4front_disasm_print(const uint8_t* code, size_t len, FILE* fp)
+{
+  if (!code || !fp)
+    return;
+  v4front::disasm_print(code, len, fp);
+}
+
+extern "C" size_t v4front_disasm_one(const uint8_t* code, size_t len, size_t pc,
+                                     char* out_buf, size_t buf_size)
+{
+  if (!code || !out_buf || buf_size == 0)
+    return 0;
+  v4front::DecodedInsn insn;
+  const size_t consumed = v4front::decode_one(code, len, pc, insn);
+  if (consumed == 0)
+    out_buf[0] = '\0';
+  else
+    v4front::format_insn(insn, out_buf, buf_size);
+  return consumed;
+}
+
+extern "C" size_t v4front_disasm_count(const uint8_t* code, size_t len)
+{
+  if (!code)
+    return 0;
+  size_t count = 0;
+  size_t pc = 0;
+  v4front::DecodedInsn insn;
+  while (pc < len)
+  {
+    pc += v4front::decode_one(code, len, pc, insn);
+    count++;
+  }
+  return count;
+}
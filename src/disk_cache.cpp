@@ -0,0 +1,247 @@
+#include "disk_cache.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#ifdef _WIN32
+#include <process.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace v4front
+{
+
+namespace
+{
+
+constexpr size_t kMaxFileSize = 64u << 20;  // Larger files are not cache entries
+constexpr char kEntryMagic[4] = {'V', '4', 'C', 'E'};
+constexpr uint32_t kEntryVersion = 1;
+
+// Entry header: magic, version, source length (LE), digest
+static_assert(4 + 4 + 8 + 32 == kDiskEntryHeaderSize, "entry header layout");
+
+const uint32_t kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+uint32_t rotr(uint32_t x, int n)
+{
+  return (x >> n) | (x << (32 - n));
+}
+
+void sha256_block(uint32_t* state, const uint8_t* block)
+{
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++)
+  {
+    const uint8_t* b = block + 4 * i;  // Big-endian words
+    w[i] = (static_cast<uint32_t>(b[0]) << 24) | (static_cast<uint32_t>(b[1]) << 16) |
+           (static_cast<uint32_t>(b[2]) << 8) | static_cast<uint32_t>(b[3]);
+  }
+  for (int i = 16; i < 64; i++)
+  {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t v[8];
+  memcpy(v, state, sizeof(v));
+  for (int i = 0; i < 64; i++)
+  {
+    uint32_t s1 = rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25);
+    uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+    uint32_t t1 = v[7] + s1 + ch + kSha256K[i] + w[i];
+    uint32_t s0 = rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22);
+    uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+    memmove(v + 1, v, sizeof(uint32_t) * 7);
+    v[4] += t1;
+    v[0] = t1 + s0 + maj;
+  }
+  for (int i = 0; i < 8; i++)
+    state[i] += v[i];
+}
+
+void put_u64_le(uint8_t* p, uint64_t value)
+{
+  for (int i = 0; i < 8; i++)
+    p[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+void entry_header(const DiskKey& key, uint8_t* out)
+{
+  memcpy(out, kEntryMagic, 4);
+  for (int i = 0; i < 4; i++)
+    out[4 + i] = static_cast<uint8_t>(kEntryVersion >> (8 * i));
+  put_u64_le(out + 8, key.source_len);
+  memcpy(out + 16, key.digest, sizeof(key.digest));
+}
+
+unsigned long process_id()
+{
+#ifdef _WIN32
+  return static_cast<unsigned long>(_getpid());
+#else
+  return static_cast<unsigned long>(getpid());
+#endif
+}
+
+// "<dir>/<first half of the digest in hex><suffix>" in a malloc'd string, or
+// nullptr
+char* cache_path(const char* dir, const DiskKey& key, const char* suffix)
+{
+  size_t len = strlen(dir) + 1 + 32 + strlen(suffix) + 1;
+  char* path = static_cast<char*>(malloc(len));
+  if (!path)
+    return nullptr;
+  int n = snprintf(path, len, "%s/", dir);
+  for (int i = 0; i < 16; i++)
+    n += snprintf(path + n, len - n, "%02x", key.digest[i]);
+  snprintf(path + n, len - n, "%s", suffix);
+  return path;
+}
+
+// Move tmp over path, replacing any existing file in one step
+bool replace_file(const char* tmp, const char* path)
+{
+#ifdef _WIN32
+  return MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return rename(tmp, path) == 0;
+#endif
+}
+
+}  // namespace
+
+void DiskKeyHasher::init()
+{
+  static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  memcpy(state, initial, sizeof(state));
+  total = 0;
+}
+
+void DiskKeyHasher::add(const void* data, size_t len)
+{
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  size_t used = total % 64;
+  total += len;
+  if (used)
+  {
+    size_t n = len < 64 - used ? len : 64 - used;
+    memcpy(block + used, p, n);
+    p += n;
+    len -= n;
+    if (used + n < 64)
+      return;
+    sha256_block(state, block);
+  }
+  for (; len >= 64; p += 64, len -= 64)
+    sha256_block(state, p);
+  memcpy(block, p, len);
+}
+
+DiskKey DiskKeyHasher::finish(uint64_t source_len)
+{
+  // Padding: 0x80, zeros, then the length in bits (big-endian)
+  uint64_t bits = total * 8;
+  uint8_t pad[72] = {0x80};
+  size_t pad_len = (total % 64 < 56 ? 56 : 120) - total % 64;
+  for (int i = 0; i < 8; i++)
+    pad[pad_len + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+  add(pad, pad_len + 8);
+
+  DiskKey key;
+  for (int i = 0; i < 8; i++)
+  {
+    key.digest[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+    key.digest[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+    key.digest[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+    key.digest[4 * i + 3] = static_cast<uint8_t>(state[i]);
+  }
+  key.source_len = source_len;
+  return key;
+}
+
+bool disk_cache_read(const char* dir, const DiskKey& key, uint8_t** out_data,
+                     size_t* out_size)
+{
+  char* path = cache_path(dir, key, ".v4c");
+  if (!path)
+    return false;
+  FILE* f = fopen(path, "rb");
+  free(path);
+  if (!f)
+    return false;
+
+  bool ok = false;
+  uint8_t* data = nullptr;
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0)
+    size = ftell(f);
+  if (size > 0 && static_cast<size_t>(size) <= kMaxFileSize && fseek(f, 0, SEEK_SET) == 0)
+  {
+    data = static_cast<uint8_t*>(malloc(static_cast<size_t>(size)));
+    ok = data && fread(data, 1, static_cast<size_t>(size), f) ==
+                     static_cast<size_t>(size);
+  }
+  fclose(f);
+
+  // The file name is only half the digest: the header must hold all of it
+  uint8_t header[kDiskEntryHeaderSize];
+  entry_header(key, header);
+  if (!ok || static_cast<size_t>(size) < sizeof(header) ||
+      memcmp(data, header, sizeof(header)) != 0)
+  {
+    free(data);
+    return false;
+  }
+  *out_size = static_cast<size_t>(size) - sizeof(header);
+  memmove(data, data + sizeof(header), *out_size);
+  *out_data = data;
+  return true;
+}
+
+void disk_cache_write(const char* dir, const DiskKey& key, const uint8_t* data,
+                      size_t size)
+{
+  // Unique per process, thread and call: other writers of the same key use
+  // their own temporary file, and the last rename wins
+  static std::atomic<uint32_t> counter(0);
+  char suffix[64];
+  snprintf(suffix, sizeof(suffix), ".%lu-%u-%lx.tmp", process_id(),
+           counter.fetch_add(1, std::memory_order_relaxed),
+           static_cast<unsigned long>(time(nullptr)));
+
+  char* tmp = cache_path(dir, key, suffix);
+  char* path = cache_path(dir, key, ".v4c");
+  FILE* f = tmp && path ? fopen(tmp, "wb") : nullptr;
+  if (f)
+  {
+    uint8_t header[kDiskEntryHeaderSize];
+    entry_header(key, header);
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header) &&
+              fwrite(data, 1, size, f) == size;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || !replace_file(tmp, path))
+      remove(tmp);
+  }
+  free(tmp);
+  free(path);
+}
+
+}  // namespace v4front
@@ -0,0 +1,53 @@
+#pragma once
+// Internal on-disk compile cache: a directory of files named by a 256-bit key.
+//
+//  - The caller hashes everything the output depends on into a DiskKey with
+//    DiskKeyHasher (SHA-256); the file "<dir>/<32 hex digits>.v4c" is named
+//    by the first half of the digest and holds an entry header (the source
+//    length and the whole digest) followed by the output (as a relocatable
+//    image, see v4front/image.h). A file whose header is not the key's is a
+//    miss, so sources that share a file name never get each other's output.
+//  - Files are written to a unique temporary name in the same directory and
+//    then renamed over the final name, so concurrent processes sharing the
+//    directory only ever read complete files.
+//  - Every failure (missing directory, unreadable or partial file, full
+//    disk) is a miss: the caller compiles and the cache is bypassed.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4front
+{
+
+struct DiskKey
+{
+  uint8_t digest[32];   // SHA-256 of the key material
+  uint64_t source_len;  // Stored beside the digest and compared on load
+};
+
+// Incremental SHA-256
+struct DiskKeyHasher
+{
+  uint32_t state[8];
+  uint8_t block[64];
+  uint64_t total;  // Bytes added so far
+
+  void init();
+  void add(const void* data, size_t len);
+  void add_u32(uint32_t value) { add(&value, sizeof(value)); }
+  DiskKey finish(uint64_t source_len);
+};
+
+// Size of the header in front of the stored bytes
+constexpr size_t kDiskEntryHeaderSize = 48;
+
+// Read the bytes stored under key into a malloc'd buffer; false on a miss
+// (including a file whose header holds another key)
+bool disk_cache_read(const char* dir, const DiskKey& key, uint8_t** out_data,
+                     size_t* out_size);
+
+// Store size bytes under key (best effort: failures are ignored)
+void disk_cache_write(const char* dir, const DiskKey& key, const uint8_t* data,
+                      size_t size);
+
+}  // namespace v4front
@@ -0,0 +1,97 @@
+#include "v4front/image.h"
+
+#include <cstring>
+
+#include "v4front/errors.hpp"
+
+using namespace v4front;
+
+// Read the header of a (validated) image
+static const V4FrontImageHeader* image_header(const uint8_t* data)
+{
+  return reinterpret_cast<const V4FrontImageHeader*>(data);
+}
+
+// Check that [offset, offset + size) lies within limit
+static bool range_ok(uint32_t offset, uint32_t size, uint32_t limit)
+{
+  return offset <= limit && size <= limit - offset;
+}
+
+extern "C" v4front_err v4front_image_validate(const uint8_t* data, size_t size)
+{
+  const int invalid = front_err_to_int(FrontErr::InvalidImage);
+
+  if (!data || size < sizeof(V4FrontImageHeader))
+    return invalid;
+  if ((reinterpret_cast<uintptr_t>(data) & 3) != 0)
+    return invalid;  // Sections are read in place and need 4-byte alignment
+
+  const V4FrontImageHeader* h = image_header(data);
+  if (memcmp(h->magic, V4FRONT_IMAGE_MAGIC, 4) != 0)
+    return invalid;
+  if (h->version != V4FRONT_IMAGE_VERSION || h->flags != 0)
+    return invalid;
+  if (h->image_size > size)
+    return invalid;
+
+  uint32_t limit = h->image_size;
+  if ((h->words_offset | h->code_offset | h->names_offset) & 3)
+    return invalid;
+  if (h->word_count > (limit / sizeof(V4FrontImageWord)))
+    return invalid;
+  if (!range_ok(h->words_offset, h->word_count * sizeof(V4FrontImageWord), limit))
+    return invalid;
+  if (!range_ok(h->code_offset, h->code_size, limit) || h->main_size > h->code_size)
+    return invalid;
+  if (!range_ok(h->names_offset, h->names_size, limit))
+    return invalid;
+  if (h->names_size > 0 && data[h->names_offset + h->names_size - 1] != '\0')
+    return invalid;  // Every name must be terminated inside the pool
+
+  const V4FrontImageWord* words =
+      reinterpret_cast<const V4FrontImageWord*>(data + h->words_offset);
+  for (uint32_t i = 0; i < h->word_count; i++)
+  {
+    if (words[i].name_offset >= h->names_size)
+      return invalid;
+    if (!range_ok(words[i].code_offset, words[i].code_len, h->code_size))
+      return invalid;
+  }
+
+  return front_err_to_int(FrontErr::OK);
+}
+
+extern "C" const uint8_t* v4front_image_main(const uint8_t* data, uint32_t* out_size)
+{
+  if (!data)
+    return nullptr;
+
+  const V4FrontImageHeader* h = image_header(data);
+  if (out_size)
+    *out_size = h->main_size;
+  return data + h->code_offset;
+}
+
+extern "C" v4front_err v4front_image_word(const uint8_t* data, uint32_t idx,
+                                          const char** out_name, const uint8_t** out_code,
+                                          uint32_t* out_len)
+{
+  if (!data)
+    return front_err_to_int(FrontErr::InvalidImage);
+
+  const V4FrontImageHeader* h = image_header(data);
+  if (idx >= h->word_count)
+    return front_err_to_int(FrontErr::InvalidImage);
+
+  const V4FrontImageWord* word =
+      reinterpret_cast<const V4FrontImageWord*>(data + h->words_offset) + idx;
+  if (out_name)
+    *out_name = reinterpret_cast<const char*>(data + h->names_offset + word->name_offset);
+  if (out_code)
+    *out_code = data + h->code_offset + word->code_offset;
+  if (out_len)
+    *out_len = word->code_len;
+
+  return front_err_to_int(FrontErr::OK);
+}
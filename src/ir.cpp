@@ -0,0 +1,186 @@
+#include "ir.hpp"
+
+#include "op_info.hpp"
+#include "v4/opcodes.hpp"
+
+namespace v4front
+{
+
+FrontErr ir_decode(Arena* arena, const uint8_t* code, uint32_t size, IrCode* ir,
+                   bool* decoded)
+{
+  *decoded = false;
+  ir->insns = nullptr;
+  ir->count = 0;
+  ir->map = nullptr;
+
+  // Every instruction is at least one byte, so size bounds the count
+  IrInsn* insns = static_cast<IrInsn*>(arena->alloc(sizeof(IrInsn) * (size + 1)));
+  uint32_t* index_of =
+      static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * (size + 1)));
+  if (!insns || !index_of)
+    return FrontErr::OutOfMemory;
+
+  const uint32_t none = UINT32_MAX;
+  for (uint32_t pc = 0; pc <= size; pc++)
+    index_of[pc] = none;
+
+  uint32_t n = 0;
+  uint32_t pc = 0;
+  while (pc < size)
+  {
+    bool is_jump;
+    int len = op_operand_len(code[pc], &is_jump);
+    if (len < 0 || pc + 1 + len > size)
+      return FrontErr::OK;
+
+    IrInsn* insn = &insns[n];
+    insn->op = code[pc];
+    insn->imm_len = static_cast<uint8_t>(len);
+    insn->is_jump = is_jump;
+    insn->is_target = false;
+    insn->dead = false;
+    uint32_t raw = 0;
+    for (int k = 0; k < len; k++)
+      raw |= static_cast<uint32_t>(code[pc + 1 + k]) << (8 * k);
+    if (len == 1)
+      insn->imm = static_cast<int8_t>(raw);
+    else if (len == 2)
+      insn->imm = static_cast<int16_t>(raw);
+    else
+      insn->imm = static_cast<int32_t>(raw);
+    insn->target = 0;
+    insn->origin = pc;
+
+    index_of[pc] = n++;
+    pc += 1 + len;
+  }
+  index_of[size] = n;
+
+  // Resolve jump destinations to instruction indices
+  pc = 0;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    uint32_t next = pc + 1 + insns[i].imm_len;
+    if (insns[i].is_jump)
+    {
+      int64_t dest = static_cast<int64_t>(next) + insns[i].imm;
+      if (dest < 0 || dest > size || index_of[dest] == none)
+        return FrontErr::OK;
+      insns[i].target = index_of[dest];
+    }
+    pc = next;
+  }
+
+  ir->insns = insns;
+  ir->count = n;
+  ir->map = index_of;
+  *decoded = true;
+  return FrontErr::OK;
+}
+
+void ir_mark_targets(IrCode* ir)
+{
+  for (uint32_t i = 0; i < ir->count; i++)
+    ir->insns[i].is_target = false;
+  for (uint32_t i = 0; i < ir->count; i++)
+  {
+    if (ir->insns[i].is_jump && ir->insns[i].target < ir->count)
+      ir->insns[ir->insns[i].target].is_target = true;
+  }
+}
+
+void ir_compact(IrCode* ir)
+{
+  IrInsn* insns = ir->insns;
+  uint32_t* remap = ir->map;
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < ir->count; i++)
+  {
+    remap[i] = n;
+    if (!insns[i].dead)
+      insns[n++] = insns[i];
+  }
+  remap[ir->count] = n;
+  for (uint32_t i = 0; i < n; i++)
+  {
+    if (insns[i].is_jump)
+      insns[i].target = remap[insns[i].target];
+  }
+  ir->count = n;
+}
+
+FrontErr ir_emit(IrCode* ir, uint8_t* out, uint32_t* size)
+{
+  // Assign addresses
+  uint32_t* addr = ir->map;
+  uint32_t pc = 0;
+  for (uint32_t i = 0; i < ir->count; i++)
+  {
+    addr[i] = pc;
+    pc += 1 + ir->insns[i].imm_len;
+  }
+  addr[ir->count] = pc;
+
+  // Every jump operand is rel16; check the range before writing anything
+  for (uint32_t i = 0; i < ir->count; i++)
+  {
+    const IrInsn* insn = &ir->insns[i];
+    if (!insn->is_jump)
+      continue;
+    int32_t rel = static_cast<int32_t>(addr[insn->target]) -
+                  static_cast<int32_t>(addr[i] + 1 + insn->imm_len);
+    if (rel < INT16_MIN || rel > INT16_MAX)
+      return FrontErr::JumpOutOfRange;
+  }
+
+  for (uint32_t i = 0; i < ir->count; i++)
+  {
+    const IrInsn* insn = &ir->insns[i];
+    uint8_t* p = out + addr[i];
+    uint32_t value = static_cast<uint32_t>(insn->imm);
+    if (insn->is_jump)
+      value = static_cast<uint32_t>(static_cast<int32_t>(addr[insn->target]) -
+                                    static_cast<int32_t>(addr[i] + 1 + insn->imm_len));
+    p[0] = insn->op;
+    for (uint32_t k = 0; k < insn->imm_len; k++)
+      p[1 + k] = static_cast<uint8_t>(value >> (8 * k));
+  }
+  *size = pc;
+
+  return FrontErr::OK;
+}
+
+void ir_remap_offsets(const IrCode* ir, uint32_t* pcs, uint32_t n)
+{
+  uint32_t i = 0;
+  for (uint32_t k = 0; k < n; k++)
+  {
+    while (i < ir->count && ir->insns[i].origin < pcs[k])
+      i++;
+    pcs[k] = ir->map[i];
+  }
+}
+
+bool ir_literal_value(const IrInsn& insn, int32_t* value)
+{
+  switch (static_cast<v4::Op>(insn.op))
+  {
+    case v4::Op::LIT:
+      *value = insn.imm;
+      return true;
+    case v4::Op::LIT0:
+      *value = 0;
+      return true;
+    case v4::Op::LIT1:
+      *value = 1;
+      return true;
+    case v4::Op::LITN1:
+      *value = -1;
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace v4front
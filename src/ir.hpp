@@ -0,0 +1,64 @@
+#pragma once
+// Internal flat instruction IR used by the optimization passes.
+//
+//  - A unit of bytecode (main code or one word) is decoded into an array of
+//    instructions. Jumps refer to their destination by instruction index
+//    (a symbolic label), so passes can delete or rewrite instructions without
+//    tracking byte offsets.
+//  - ir_emit() assigns addresses and re-encodes every jump; it fails if a
+//    jump no longer fits its rel16 operand.
+
+#include <cstdint>
+
+#include "arena.hpp"
+#include "v4front/errors.hpp"
+
+namespace v4front
+{
+
+// Decoded instruction
+struct IrInsn
+{
+  uint8_t op;
+  uint8_t imm_len;  // Immediate bytes following the opcode
+  bool is_jump;     // REL16 operand (target holds the destination)
+  bool is_target;   // Some jump lands here (valid after ir_mark_targets)
+  bool dead;        // Removed by the current pass (dropped by ir_compact)
+  int32_t imm;      // Immediate value (non-jump instructions)
+  uint32_t target;  // Destination instruction index (count == end of code)
+  uint32_t origin;  // Byte offset the instruction was decoded from
+};
+
+struct IrCode
+{
+  IrInsn* insns;
+  uint32_t count;
+  uint32_t* map;  // Scratch: byte offset/index map, at least count + 1 entries
+};
+
+// Decode code[0, size) into ir. *decoded is false (and ir unusable) if the
+// code contains unknown opcodes, truncated operands or jumps that do not land
+// on an instruction boundary.
+FrontErr ir_decode(Arena* arena, const uint8_t* code, uint32_t size, IrCode* ir,
+                   bool* decoded);
+
+// Recompute is_target flags
+void ir_mark_targets(IrCode* ir);
+
+// Drop dead instructions; a jump to a removed instruction continues at the
+// next surviving one
+void ir_compact(IrCode* ir);
+
+// Encode ir into out (which must hold the encoded size; an IR decoded from
+// N bytes that has only shrunk fits in N) and store the size in *size
+FrontErr ir_emit(IrCode* ir, uint8_t* out, uint32_t* size);
+
+// Move the ascending byte offsets pcs[0, n) of the decoded code to the
+// address of the first surviving instruction decoded at or after them (valid
+// after ir_emit; an offset past the last one becomes the end of the code)
+void ir_remap_offsets(const IrCode* ir, uint32_t* pcs, uint32_t n);
+
+// Literal value pushed by insn, if it is a literal
+bool ir_literal_value(const IrInsn& insn, int32_t* value);
+
+}  // namespace v4front
@@ -0,0 +1,144 @@
+#include "jump_opt.hpp"
+
+#include "v4/opcodes.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+constexpr uint8_t op(v4::Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+bool is_jmp(const IrCode* ir, uint32_t i)
+{
+  return i < ir->count && ir->insns[i].op == op(v4::Op::JMP);
+}
+
+// Final destination of a jump to target, following unconditional JMPs. The
+// walk is bounded by the instruction count so JMP cycles terminate.
+uint32_t final_target(const IrCode* ir, uint32_t target)
+{
+  for (uint32_t hops = 0; hops < ir->count && is_jmp(ir, target); hops++)
+  {
+    uint32_t next = ir->insns[target].target;
+    if (next == target)
+      break;
+    target = next;
+  }
+  return target;
+}
+
+// Mark instructions not reachable from the entry as dead; returns true if
+// any was found. Only JMP and RET end a path (everything else, including
+// CALL and SYS, falls through).
+bool remove_unreachable(IrCode* ir)
+{
+  uint8_t* reached = reinterpret_cast<uint8_t*>(ir->map);  // Byte view of scratch
+  for (uint32_t i = 0; i < ir->count; i++)
+    reached[i] = 0;
+
+  // Sweep forward, repeating while a backward jump reaches new code
+  for (bool grew = true; grew;)
+  {
+    grew = false;
+    bool live = true;  // Entry (instruction 0) is reachable
+    for (uint32_t i = 0; i < ir->count; i++)
+    {
+      if (ir->insns[i].dead)
+        continue;  // Already removed by this sweep; control passes through
+      if (reached[i])
+        live = true;
+      if (!live)
+        continue;
+      if (!reached[i])
+      {
+        reached[i] = 1;
+        grew = true;
+      }
+      const IrInsn* insn = &ir->insns[i];
+      if (insn->is_jump && insn->target < ir->count && !reached[insn->target])
+      {
+        reached[insn->target] = 1;
+        grew = true;
+      }
+      if (insn->op == op(v4::Op::JMP) || insn->op == op(v4::Op::RET))
+        live = false;
+    }
+  }
+
+  bool removed = false;
+  for (uint32_t i = 0; i < ir->count; i++)
+  {
+    if (!reached[i] && !ir->insns[i].dead)
+    {
+      ir->insns[i].dead = true;
+      removed = true;
+    }
+  }
+  return removed;
+}
+
+}  // namespace
+
+bool jump_opt_pass(IrCode* ir)
+{
+  using v4::Op;
+  bool changed = false;
+
+  ir_mark_targets(ir);
+  for (uint32_t i = 0; i < ir->count; i++)
+  {
+    IrInsn* insn = &ir->insns[i];
+    if (!insn->is_jump)
+      continue;
+
+    // Jump to a JMP: go straight to the final destination
+    uint32_t dest = final_target(ir, insn->target);
+    if (dest != insn->target)
+    {
+      insn->target = dest;
+      changed = true;
+    }
+
+    // JMP to RET: return directly
+    bool to_ret = dest < ir->count && ir->insns[dest].op == op(Op::RET);
+    if (insn->op == op(Op::JMP) && to_ret)
+    {
+      *insn = {op(Op::RET), 0, false, insn->is_target, false, 0, 0, insn->origin};
+      changed = true;
+      continue;
+    }
+
+    // JZ/JNZ to the next instruction only consumes the flag
+    if (insn->op != op(Op::JMP) && dest == i + 1)
+    {
+      *insn = {op(Op::DROP), 0, false, insn->is_target, false, 0, 0, insn->origin};
+      changed = true;
+      continue;
+    }
+
+    // JZ L1; JMP L2; L1: -> JNZ L2; L1:
+    if (insn->op != op(Op::JMP) && dest == i + 2 && is_jmp(ir, i + 1) &&
+        !ir->insns[i + 1].is_target)
+    {
+      IrInsn* skip = &ir->insns[i + 1];
+      insn->op = insn->op == op(Op::JZ) ? op(Op::JNZ) : op(Op::JZ);
+      insn->target = skip->target;
+      skip->dead = true;
+      changed = true;
+      i++;  // JMP is gone
+    }
+  }
+
+  if (remove_unreachable(ir))
+    changed = true;
+  if (changed)
+    ir_compact(ir);
+  return changed;
+}
+
+}  // namespace v4front
@@ -0,0 +1,18 @@
+#pragma once
+// Internal jump optimization pass.
+//
+//  - Threads jumps through chains of unconditional JMPs, turns a JMP to RET
+//    into RET, and inverts a conditional jump over a lone JMP.
+//  - Removes instructions that can no longer be reached from the unit entry.
+//  - The V4 ISA has a single rel16 form for JMP/JZ/JNZ, so there is no
+//    short-branch relaxation step; ir_emit() recomputes every offset.
+
+#include "ir.hpp"
+
+namespace v4front
+{
+
+// One sweep over ir; returns true if anything was rewritten
+bool jump_opt_pass(IrCode* ir);
+
+}  // namespace v4front
@@ -0,0 +1,305 @@
+#include "lexer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "word_cache.hpp"
+#include "word_table.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+int by_generation(const void* a, const void* b)
+{
+  uint32_t ga = (*static_cast<LexLine* const*>(a))->generation;
+  uint32_t gb = (*static_cast<LexLine* const*>(b))->generation;
+  return (ga > gb) - (ga < gb);
+}
+
+// Growable token array in arena memory
+struct TokenBuf
+{
+  LexToken* data;
+  uint32_t count;
+  uint32_t cap;
+  Arena* arena;
+
+  bool push(const LexToken& token)
+  {
+    if (count == cap)
+    {
+      uint32_t grown = cap ? cap * 2 : 64;
+      LexToken* bigger = static_cast<LexToken*>(
+          arena->grow(data, sizeof(LexToken) * cap, sizeof(LexToken) * grown));
+      if (!bigger)
+        return false;
+      data = bigger;
+      cap = grown;
+    }
+    data[count++] = token;
+    return true;
+  }
+};
+
+// Lex text[0, len), a line that starts at offset base of the source, onto
+// out. *tail and *clean as in LexLine (tail relative to the line).
+bool lex_line(const char* text, uint32_t len, uint32_t base, TokenBuf* out,
+              uint32_t* tail, bool* clean)
+{
+  const char* p = text;
+  const char* end = text + len;
+  uint32_t gap = base;
+  *tail = 0;
+  while (true)
+  {
+    if (skip_whitespace_and_comments(&p, end, nullptr) != FrontErr::OK)
+    {
+      // A ( comment that continues on a later line
+      *clean = false;
+      return true;
+    }
+    if (p == end)
+    {
+      *clean = true;
+      return true;
+    }
+    const char* start = p;
+    p = scan_token(p, end);
+    LexToken token;
+    token.gap = gap;
+    token.offset = base + static_cast<uint32_t>(start - text);
+    token.len = static_cast<uint32_t>(p - start);
+    token.symbol = hash_ci(start, token.len);
+    token.kind = try_parse_int(start, token.len, &token.value) ? LexKind::Number
+                                                                : LexKind::Word;
+    if (token.kind == LexKind::Word)
+      token.value = 0;
+    if (!out->push(token))
+      return false;
+    *tail = static_cast<uint32_t>(p - text);
+    gap = base + *tail;
+  }
+}
+
+}  // namespace
+
+void LexCache::init(size_t max)
+{
+  entries = nullptr;
+  count = 0;
+  cap = 0;
+  slots = nullptr;
+  mask = 0;
+  bytes = 0;
+  max_bytes = max;
+  generation = 0;
+  hits = 0;
+  misses = 0;
+}
+
+void LexCache::destroy()
+{
+  for (uint32_t i = 0; i < count; i++)
+    free(entries[i]);
+  free(entries);
+  free(slots);
+  init(0);
+}
+
+const LexLine* LexCache::find(const char* text, uint32_t len, uint64_t hash) const
+{
+  if (!slots)
+    return nullptr;
+  for (uint32_t i = static_cast<uint32_t>(hash) & mask;; i = (i + 1) & mask)
+  {
+    if (slots[i] == 0)
+      return nullptr;
+    const LexLine* line = entries[slots[i] - 1];
+    if (line->hash == hash && line->len == len && memcmp(line->text, text, len) == 0)
+      return line;
+  }
+}
+
+bool LexCache::insert(const char* text, uint32_t len, uint64_t hash,
+                      const LexToken* tokens, uint32_t token_count, uint32_t tail,
+                      bool clean)
+{
+  // One block: header, tokens (relative to the line), then the text
+  size_t size = sizeof(LexLine) + sizeof(LexToken) * token_count + len;
+  if (size > max_bytes)
+    return true;  // Would be evicted right away
+  LexLine* line = static_cast<LexLine*>(malloc(size));
+  if (!line)
+    return false;
+  LexToken* line_tokens = reinterpret_cast<LexToken*>(line + 1);
+  char* line_text = reinterpret_cast<char*>(line_tokens + token_count);
+  uint32_t base = token_count ? tokens[0].gap : 0;
+  for (uint32_t i = 0; i < token_count; i++)
+  {
+    line_tokens[i] = tokens[i];
+    line_tokens[i].gap -= base;
+    line_tokens[i].offset -= base;
+  }
+  memcpy(line_text, text, len);
+
+  line->hash = hash;
+  line->generation = generation;
+  line->len = len;
+  line->token_count = token_count;
+  line->tail = tail;
+  line->clean = clean;
+  line->bytes = size;
+  line->text = line_text;
+  line->tokens = line_tokens;
+
+  if (count == cap)
+  {
+    uint32_t new_cap = cap ? cap * 2 : 16;
+    LexLine** grown =
+        static_cast<LexLine**>(realloc(entries, sizeof(LexLine*) * new_cap));
+    if (!grown)
+    {
+      free(line);
+      return false;
+    }
+    entries = grown;
+    cap = new_cap;
+  }
+  if ((count + 1) * 2 > mask + 1 || !slots)
+  {
+    if (!rebuild_slots(slots ? (mask + 1) * 2 : 32))
+    {
+      free(line);
+      return false;
+    }
+  }
+
+  entries[count++] = line;
+  bytes += line->bytes;
+  uint32_t i = static_cast<uint32_t>(hash) & mask;
+  while (slots[i])
+    i = (i + 1) & mask;
+  slots[i] = count;
+  return true;
+}
+
+void LexCache::trim()
+{
+  if (bytes <= max_bytes)
+    return;
+
+  // Oldest first; drop them until the rest fits
+  qsort(entries, count, sizeof(LexLine*), by_generation);
+  uint32_t drop = 0;
+  while (drop < count && bytes > max_bytes)
+  {
+    bytes -= entries[drop]->bytes;
+    free(entries[drop]);
+    drop++;
+  }
+  memmove(entries, entries + drop, sizeof(LexLine*) * (count - drop));
+  count -= drop;
+
+  // Fewer entries fit in the same slots
+  memset(slots, 0, sizeof(uint32_t) * (mask + 1));
+  place_all();
+}
+
+bool LexCache::rebuild_slots(uint32_t slot_count)
+{
+  uint32_t* fresh = static_cast<uint32_t*>(calloc(slot_count, sizeof(uint32_t)));
+  if (!fresh)
+    return false;
+  free(slots);
+  slots = fresh;
+  mask = slot_count - 1;
+  place_all();
+  return true;
+}
+
+void LexCache::place_all()
+{
+  for (uint32_t e = 0; e < count; e++)
+  {
+    uint32_t i = static_cast<uint32_t>(entries[e]->hash) & mask;
+    while (slots[i])
+      i = (i + 1) & mask;
+    slots[i] = e + 1;
+  }
+}
+
+FrontErr lex_source(Arena* arena, LexCache* cache, const char* source, size_t len,
+                    LexStream* out)
+{
+  *out = {nullptr, nullptr, 0, 0};
+  if (!source || len > UINT32_MAX)
+    return FrontErr::OK;  // Offsets are 32-bit: the compiler scans instead
+  cache->generation++;
+  cache->hits = 0;
+  cache->misses = 0;
+
+  TokenBuf tokens = {nullptr, 0, 0, arena};
+  // Skipping from carry reaches the start of the current line (carry_ok)
+  uint32_t carry = 0;
+  bool carry_ok = true;
+  for (uint32_t start = 0; start < len;)
+  {
+    const char* text = source + start;
+    const char* nl = static_cast<const char*>(memchr(text, '\n', len - start));
+    uint32_t line_len = nl ? static_cast<uint32_t>(nl + 1 - text)
+                           : static_cast<uint32_t>(len - start);
+    uint64_t hash = hash64(text, line_len);
+
+    uint32_t first = tokens.count;
+    uint32_t tail;
+    bool clean;
+    LexLine* hit = const_cast<LexLine*>(cache->find(text, line_len, hash));
+    if (hit)
+    {
+      hit->generation = cache->generation;
+      cache->hits++;
+      for (uint32_t i = 0; i < hit->token_count; i++)
+      {
+        LexToken token = hit->tokens[i];
+        token.gap += start;
+        token.offset += start;
+        if (!tokens.push(token))
+          return FrontErr::OutOfMemory;
+      }
+      tail = hit->tail;
+      clean = hit->clean;
+    }
+    else
+    {
+      cache->misses++;
+      if (!lex_line(text, line_len, start, &tokens, &tail, &clean))
+        return FrontErr::OutOfMemory;
+      if (!cache->insert(text, line_len, hash, tokens.data + first, tokens.count - first,
+                         tail, clean))
+        return FrontErr::OutOfMemory;
+    }
+
+    // The first token is also reached from where the lines before stopped
+    if (tokens.count > first && carry_ok)
+      tokens.data[first].gap = carry;
+    if (!clean)
+    {
+      carry_ok = false;
+    }
+    else if (tokens.count > first || !carry_ok)
+    {
+      carry = tokens.count > first ? start + tail : start;
+      carry_ok = true;
+    }
+    start += line_len;
+  }
+  cache->trim();
+
+  *out = {source, tokens.data, tokens.count, 0};
+  return FrontErr::OK;
+}
+
+}  // namespace v4front
@@ -0,0 +1,214 @@
+#pragma once
+// Internal lexer: the lexical rules of the language and the token streams a
+// context caches per source line (v4front_context_set_lex_cache).
+//
+//  - skip_whitespace_and_comments(), scan_token() and try_parse_int() are the
+//    rules; the compiler and lex_source() share them.
+//  - lex_source() turns a source into LexTokens one line at a time, taking
+//    lines it has seen before from a LexCache. Lines are lexed on their own,
+//    so a token is only a hint: the compiler uses it when its position is the
+//    token's gap, the offset from which skipping whitespace and comments
+//    lands exactly on the token. Otherwise (a comment that spans lines, a
+//    keyword that read ahead) it scans the source itself.
+//  - LexCache keys a line on its exact text, including the '\n'. Every entry
+//    is one malloc'd block; trim() evicts the least recently used entries once
+//    more than max_bytes are held (as WordCache does).
+
+#include <cstddef>
+#include <cstdint>
+
+#include "arena.hpp"
+#include "char_class.hpp"
+#include "scan.hpp"
+#include "v4front/errors.hpp"
+
+namespace v4front
+{
+
+// Skip whitespace and comments
+// Handles:
+//   - Line comments: \ (backslash) to end of line
+//   - Parenthesized comments: ( ... )
+// The runs are found 16 bytes at a time where SIMD is available (see scan.hpp)
+// Returns:
+//   - OK on success
+//   - UnterminatedComment if ( is not closed
+static inline FrontErr skip_whitespace_and_comments(const char** p, const char* end,
+                                                    const char** error_pos)
+{
+  while (true)
+  {
+    // Skip whitespace
+    *p = skip_spaces(*p, end);
+
+    // Check for comments
+    if (*p < end && **p == '\\')
+    {
+      // Line comment: skip to end of line
+      *p = find_byte(*p + 1, end, '\n');
+      // Continue to skip more whitespace/comments
+      continue;
+    }
+    else if (*p < end && **p == '(' && end - *p > 1 && is_space(*(*p + 1)))
+    {
+      // Parenthesized comment: ( must be followed by whitespace to distinguish from
+      // (LOCAL) Skip the opening (, then find the closing )
+      *p = find_byte(*p + 1, end, ')');
+
+      if (*p < end)
+      {
+        (*p)++;  // Skip closing )
+        // Continue to skip more whitespace/comments
+        continue;
+      }
+      else
+      {
+        // Unterminated comment
+        if (error_pos)
+          *error_pos = *p - 1;  // Point to the opening (
+        return FrontErr::UnterminatedComment;
+      }
+    }
+    else
+    {
+      // No more whitespace or comments
+      break;
+    }
+  }
+
+  return FrontErr::OK;
+}
+
+// End of the token starting at p (the next whitespace, or end)
+static inline const char* scan_token(const char* p, const char* end)
+{
+  while (p < end && !is_space(*p))
+    p++;
+  return p;
+}
+
+// Try parsing the token [token, token + len) as an integer
+// Accepts what strtol() with base 0 accepts for a whole token: an optional
+// sign, then 0x/0X hex, octal with a leading 0, or decimal. The value is read
+// as a 64-bit integer (saturating) and truncated to 32 bits, so 0xFFFFFFFF is -1.
+static inline bool try_parse_int(const char* token, size_t len, int32_t* out)
+{
+  const char* p = token;
+  const char* end = token + len;
+  bool negative = false;
+  if (p < end && (*p == '+' || *p == '-'))
+    negative = *p++ == '-';
+
+  uint32_t base = 10;
+  if (end - p > 1 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+  {
+    base = 16;
+    p += 2;
+  }
+  else if (p < end && *p == '0')
+  {
+    base = 8;
+  }
+  if (p == end)
+    return false;
+
+  const uint64_t limit = negative ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX);
+  uint64_t mag = 0;
+  for (; p < end; p++)
+  {
+    uint32_t d = digit_value(*p);
+    if (d >= base)
+      return false;
+    mag = mag > (limit - d) / base ? limit : mag * base + d;
+  }
+  *out = static_cast<int32_t>(static_cast<uint32_t>(negative ? 0 - mag : mag));
+  return true;
+}
+
+enum class LexKind : uint8_t
+{
+  Word,    // Anything that is not a number (keywords are told apart by symbol)
+  Number,  // Integer literal (value holds it)
+};
+
+struct LexToken
+{
+  uint32_t gap;     // Skipping whitespace and comments from here reaches offset
+  uint32_t offset;  // Token start in the source
+  uint32_t len;     // Token length
+  uint32_t symbol;  // hash_ci of the token, the key of every name table
+  int32_t value;    // Number: its value
+  LexKind kind;
+};
+
+// A cached line: its text and tokens, offsets relative to the line start
+struct LexLine
+{
+  uint64_t hash;        // Of the text
+  uint32_t generation;  // Last compilation that used the entry
+  uint32_t len;         // Text length, '\n' included
+  uint32_t token_count;
+  uint32_t tail;        // End of the last token (0: none)
+  bool clean;           // Skipping from tail reaches the end of the line
+  size_t bytes;         // Size of the whole block
+  const char* text;
+  const LexToken* tokens;
+  // Followed by tokens and text
+};
+
+struct LexCache
+{
+  LexLine** entries;  // In no particular order
+  uint32_t count;
+  uint32_t cap;
+  uint32_t* slots;    // Open addressing on the text hash: entry index + 1 (0: empty)
+  uint32_t mask;      // Slot count - 1
+  size_t bytes;       // Sum of entry sizes
+  size_t max_bytes;
+  uint32_t generation;  // Current compilation
+
+  // Lines of the last lex_source()
+  uint32_t hits;
+  uint32_t misses;
+
+  void init(size_t max);
+  void destroy();
+
+  // Evict least recently used entries until at most max_bytes are held
+  void trim();
+
+  const LexLine* find(const char* text, uint32_t len, uint64_t hash) const;
+  bool insert(const char* text, uint32_t len, uint64_t hash, const LexToken* tokens,
+              uint32_t token_count, uint32_t tail, bool clean);
+
+ private:
+  bool rebuild_slots(uint32_t slot_count);
+  void place_all();
+};
+
+// The tokens of one source, in order of offset (gaps strictly increase)
+struct LexStream
+{
+  const char* base;  // Source the offsets refer to (nullptr: no stream)
+  const LexToken* tokens;
+  uint32_t count;
+  uint32_t next;  // First token the compiler has not passed
+
+  // The token the compiler reads next from base + at, or nullptr if it must
+  // scan the source itself
+  const LexToken* at(uint32_t at)
+  {
+    while (next < count && tokens[next].gap < at)
+      next++;
+    if (next < count && tokens[next].gap == at)
+      return &tokens[next++];
+    return nullptr;
+  }
+};
+
+// Lex source[0, len) into out (arena memory), through cache. Only fails when
+// out of memory; a line the cache cannot hold is still lexed.
+FrontErr lex_source(Arena* arena, LexCache* cache, const char* source, size_t len,
+                    LexStream* out);
+
+}  // namespace v4front
@@ -0,0 +1,47 @@
+#pragma once
+// Internal opcode operand table generated from opcodes.def (shared by the
+// passes that walk emitted bytecode).
+
+#include <cstdint>
+
+#include "v4/opcodes.hpp"
+
+namespace v4front
+{
+
+// Operand bytes following an opcode, or -1 for opcodes not in opcodes.def.
+// is_jump (optional) is set for REL16 operands (JMP/JZ/JNZ).
+static inline int op_operand_len(uint8_t opcode, bool* is_jump = nullptr)
+{
+  // Encode each IMM kind as (length, jump flag)
+  enum : int
+  {
+    NO_IMM = 0,
+    IMM8 = 1,
+    IMM16 = 2,
+    IMM32 = 4,
+    IDX16 = 2,
+    REL16 = 0x100 | 2,
+  };
+
+  int kind;
+  switch (opcode)
+  {
+    // clang-format off
+#define OP(NAME, CODE, IMM) \
+  case CODE:                \
+    kind = IMM;             \
+    break;
+#include "v4/opcodes.def"
+#undef OP
+    // clang-format on
+    default:
+      return -1;
+  }
+
+  if (is_jump)
+    *is_jump = (kind & 0x100) != 0;
+  return kind & 0xFF;
+}
+
+}  // namespace v4front
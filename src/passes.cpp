@@ -0,0 +1,80 @@
+#include "passes.hpp"
+
+#include "ir.hpp"
+#include "jump_opt.hpp"
+#include "peephole.hpp"
+#include "v4front/compile.h"
+
+namespace v4front
+{
+
+namespace
+{
+
+struct IrPass
+{
+  const char* name;
+  uint32_t flag;  // V4FRONT_OPT_* bit that enables the pass
+  bool (*run)(IrCode* ir);
+};
+
+// Passes in the order they run within one iteration. A pass may rewrite or
+// delete instructions but never grow the code (it is emitted in place).
+constexpr IrPass kPasses[] = {
+    {"jump-thread", V4FRONT_OPT_JUMP_THREAD, jump_opt_pass},
+    {"peephole", V4FRONT_OPT_PEEPHOLE, peephole_pass},
+};
+
+// Upper bound on iterations; every pass only shrinks or rewrites in place,
+// so this is never reached in practice
+constexpr int kMaxIterations = 64;
+
+}  // namespace
+
+uint32_t opt_level_flags(uint32_t level)
+{
+  if (level == 0)
+    return 0;
+  return level == 1 ? V4FRONT_O1_FLAGS : V4FRONT_O2_FLAGS;
+}
+
+bool passes_enabled(uint32_t flags)
+{
+  for (const IrPass& pass : kPasses)
+  {
+    if (flags & pass.flag)
+      return true;
+  }
+  return false;
+}
+
+FrontErr run_passes(Arena* arena, uint32_t flags, uint8_t* code, uint32_t* size,
+                    uint32_t* pcs, uint32_t pc_count)
+{
+  if (!code || *size == 0 || !passes_enabled(flags))
+    return FrontErr::OK;
+
+  IrCode ir;
+  bool decoded;
+  FrontErr err = ir_decode(arena, code, *size, &ir, &decoded);
+  if (err != FrontErr::OK || !decoded)
+    return err;
+
+  bool changed = true;
+  for (int iter = 0; changed && iter < kMaxIterations; iter++)
+  {
+    changed = false;
+    for (const IrPass& pass : kPasses)
+    {
+      if ((flags & pass.flag) && pass.run(&ir))
+        changed = true;
+    }
+  }
+
+  if ((err = ir_emit(&ir, code, size)) != FrontErr::OK)
+    return err;
+  ir_remap_offsets(&ir, pcs, pc_count);
+  return FrontErr::OK;
+}
+
+}  // namespace v4front
@@ -0,0 +1,31 @@
+#pragma once
+// Internal pass manager.
+//
+//  - Each bytecode unit (main code, every word) is decoded into the IR once,
+//    the passes enabled by the V4FRONT_OPT_* flags run until none of them
+//    changes anything, and the result is emitted back in place.
+//  - When no pass is enabled the unit is not decoded at all, so -O0 (and
+//    REPL lines compiled without options) costs nothing.
+
+#include <cstdint>
+
+#include "arena.hpp"
+#include "v4front/errors.hpp"
+
+namespace v4front
+{
+
+// Flags implied by V4FrontCompileOptions::opt_level (levels above 2 act as 2)
+uint32_t opt_level_flags(uint32_t level);
+
+// True if any IR pass is enabled in flags
+bool passes_enabled(uint32_t flags);
+
+// Run the passes enabled in flags over code[0, *size) and update *size.
+// Scratch memory comes from arena. Code that cannot be decoded is left as is.
+// The ascending offsets pcs[0, pc_count) are moved along with the code (see
+// ir_remap_offsets).
+FrontErr run_passes(Arena* arena, uint32_t flags, uint8_t* code, uint32_t* size,
+                    uint32_t* pcs = nullptr, uint32_t pc_count = 0);
+
+}  // namespace v4front
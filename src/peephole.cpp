@@ -0,0 +1,122 @@
+#include "peephole.hpp"
+
+#include "v4/opcodes.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+constexpr uint8_t op(v4::Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Instruction pairs (a b) that cancel out entirely
+bool cancels(uint8_t a, uint8_t b)
+{
+  using v4::Op;
+  return (a == op(Op::SWAP) && b == op(Op::SWAP)) ||
+         (a == op(Op::DUP) && b == op(Op::DROP)) ||
+         (a == op(Op::OVER) && b == op(Op::DROP)) ||
+         (a == op(Op::TOR) && b == op(Op::FROMR)) ||
+         (a == op(Op::FROMR) && b == op(Op::TOR)) ||
+         (a == op(Op::INVERT) && b == op(Op::INVERT));
+}
+
+// Try to rewrite the window starting at code[i]. Returns the number of
+// instructions consumed (0 = no match). Replaced instructions are rewritten in
+// place; removed ones are marked dead.
+uint32_t rewrite_window(IrInsn* code, uint32_t i, uint32_t count)
+{
+  using v4::Op;
+  IrInsn* a = &code[i];
+  IrInsn* b = (i + 1 < count && !code[i + 1].is_target) ? &code[i + 1] : nullptr;
+  IrInsn* c = (b && i + 2 < count && !code[i + 2].is_target) ? &code[i + 2] : nullptr;
+
+  // JMP to the next instruction
+  if (a->is_jump && a->op == op(Op::JMP) && a->target == i + 1)
+  {
+    a->dead = true;
+    return 1;
+  }
+
+  if (!b)
+    return 0;
+
+  if (cancels(a->op, b->op))
+  {
+    a->dead = b->dead = true;
+    return 2;
+  }
+
+  // DUP SWAP -> DUP
+  if (a->op == op(Op::DUP) && b->op == op(Op::SWAP))
+  {
+    b->dead = true;
+    return 2;
+  }
+
+  int32_t value;
+  if (!ir_literal_value(*a, &value))
+    return 0;
+
+  // NEGATE expansion: 0 SWAP - -> INVERT 1+
+  if (value == 0 && c && b->op == op(Op::SWAP) && c->op == op(Op::SUB))
+  {
+    *a = {op(Op::INVERT), 0, false, a->is_target, false, 0, 0, a->origin};
+    *b = {op(Op::INC), 0, false, false, false, 0, 0, b->origin};
+    c->dead = true;
+    return 3;
+  }
+
+  // n DROP -> (nothing)
+  bool identity = b->op == op(Op::DROP);
+  // x 0 + / x 0 - / x 0 OR / x 0 XOR / x 1 * / x 1 / -> x
+  if (value == 0)
+    identity |= b->op == op(Op::ADD) || b->op == op(Op::SUB) || b->op == op(Op::OR) ||
+                b->op == op(Op::XOR);
+  if (value == 1)
+    identity |= b->op == op(Op::MUL) || b->op == op(Op::DIV);
+  if (identity)
+  {
+    a->dead = b->dead = true;
+    return 2;
+  }
+
+  // x 1 + -> 1+, x 1 - -> 1-, x -1 + -> 1-, x -1 - -> 1+
+  uint8_t step = 0;
+  if ((value == 1 && b->op == op(Op::ADD)) || (value == -1 && b->op == op(Op::SUB)))
+    step = op(Op::INC);
+  else if ((value == 1 && b->op == op(Op::SUB)) || (value == -1 && b->op == op(Op::ADD)))
+    step = op(Op::DEC);
+  if (step)
+  {
+    *a = {step, 0, false, a->is_target, false, 0, 0, a->origin};
+    b->dead = true;
+    return 2;
+  }
+
+  return 0;
+}
+
+}  // namespace
+
+bool peephole_pass(IrCode* ir)
+{
+  bool changed = false;
+  ir_mark_targets(ir);
+  for (uint32_t i = 0; i < ir->count;)
+  {
+    uint32_t used = rewrite_window(ir->insns, i, ir->count);
+    if (used)
+      changed = true;
+    i += used ? used : 1;
+  }
+  if (changed)
+    ir_compact(ir);
+  return changed;
+}
+
+}  // namespace v4front
@@ -0,0 +1,18 @@
+#pragma once
+// Internal peephole pass for emitted bytecode.
+//
+//  - Rewrites short, known-redundant instruction windows left behind by the
+//    fixed keyword expansions (e.g. SWAP SWAP, >R R>, LIT 1 ADD).
+//  - A window is only rewritten when no jump lands inside it; jump targets
+//    are symbolic in the IR, so removing instructions needs no fixups.
+
+#include "ir.hpp"
+
+namespace v4front
+{
+
+// One sweep over ir; returns true if anything was rewritten (the pass
+// manager repeats it, since removing a pair can expose a new one)
+bool peephole_pass(IrCode* ir);
+
+}  // namespace v4front
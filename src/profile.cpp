@@ -0,0 +1,230 @@
+#include "profile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "v4front/errors.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+bool is_blank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// One "NAME COUNT" line of a profile
+struct ProfileLine
+{
+  const char* name;
+  size_t name_len;
+  uint64_t count;
+};
+
+// Parse line[0, len); false if malformed. *entry is false for blank and
+// comment lines.
+bool parse_line(const char* line, size_t len, ProfileLine* out, bool* entry)
+{
+  size_t i = 0;
+  while (i < len && is_blank(line[i]))
+    i++;
+  *entry = i < len && line[i] != '#';
+  if (!*entry)
+    return true;
+
+  out->name = line + i;
+  while (i < len && !is_blank(line[i]))
+    i++;
+  out->name_len = static_cast<size_t>(line + i - out->name);
+  while (i < len && is_blank(line[i]))
+    i++;
+
+  // Decimal count, no sign, no overflow
+  if (i == len || line[i] < '0' || line[i] > '9')
+    return false;
+  uint64_t count = 0;
+  for (; i < len && line[i] >= '0' && line[i] <= '9'; i++)
+  {
+    uint64_t digit = static_cast<uint64_t>(line[i] - '0');
+    if (count > (UINT64_MAX - digit) / 10)
+      return false;
+    count = count * 10 + digit;
+  }
+  out->count = count;
+  while (i < len && is_blank(line[i]))
+    i++;
+  return i == len;
+}
+
+// Call fn for every line of text; stops at the first malformed one
+template <typename Fn>
+FrontErr for_each_entry(const char* text, size_t len, uint32_t* error_line, Fn fn)
+{
+  uint32_t number = 0;
+  for (size_t start = 0; start < len;)
+  {
+    const char* nl = static_cast<const char*>(memchr(text + start, '\n', len - start));
+    size_t end = nl ? static_cast<size_t>(nl - text) : len;
+    number++;
+    ProfileLine line;
+    bool entry;
+    if (!parse_line(text + start, end - start, &line, &entry))
+    {
+      if (error_line)
+        *error_line = number;
+      return FrontErr::InvalidProfile;
+    }
+    if (entry)
+      fn(line);
+    start = end + 1;
+  }
+  return FrontErr::OK;
+}
+
+}  // namespace
+
+bool ProfileIndex::build(Arena* arena, const V4FrontProfile* profile)
+{
+  index.init(arena);
+  hot = 1;
+  counts = static_cast<uint64_t*>(
+      arena->alloc(sizeof(uint64_t) * (profile->count > 0 ? profile->count : 1)));
+  if (!counts)
+    return false;
+
+  int distinct = 0;
+  uint64_t max = 0;
+  for (uint32_t i = 0; i < profile->count; i++)
+  {
+    const V4FrontWordCount& word = profile->words[i];
+    size_t len = strlen(word.name);
+    WordIndex::Slot* slot = index.find(word.name, len);
+    uint64_t* count;
+    if (slot)
+    {
+      count = &counts[slot->value];
+    }
+    else
+    {
+      if (!index.insert(word.name, len, distinct))
+        return false;
+      count = &counts[distinct++];
+      *count = 0;
+    }
+    *count = (word.count > UINT64_MAX - *count) ? UINT64_MAX : *count + word.count;
+    if (*count > max)
+      max = *count;
+  }
+  if (max / PROFILE_HOT_RATIO > hot)
+    hot = max / PROFILE_HOT_RATIO;
+  return true;
+}
+
+}  // namespace v4front
+
+using namespace v4front;
+
+extern "C" v4front_err v4front_parse_profile(const char* text, size_t len,
+                                             V4FrontProfile* out, uint32_t* error_line)
+{
+  if (!out)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  out->words = nullptr;
+  out->count = 0;
+  if (!text)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+
+  // Size the block, then fill it: the entries, then their names
+  size_t entries = 0;
+  size_t name_bytes = 0;
+  FrontErr err = for_each_entry(text, len, error_line,
+                                [&](const ProfileLine& line)
+                                {
+                                  entries++;
+                                  name_bytes += line.name_len + 1;
+                                });
+  if (err != FrontErr::OK)
+    return front_err_to_int(err);
+  if (entries == 0)
+    return 0;
+  if (entries > UINT32_MAX)
+    return front_err_to_int(FrontErr::InvalidProfile);
+
+  uint8_t* block =
+      static_cast<uint8_t*>(malloc(sizeof(V4FrontWordCount) * entries + name_bytes));
+  if (!block)
+    return front_err_to_int(FrontErr::OutOfMemory);
+  V4FrontWordCount* words = reinterpret_cast<V4FrontWordCount*>(block);
+  char* names = reinterpret_cast<char*>(block + sizeof(V4FrontWordCount) * entries);
+  uint32_t n = 0;
+  for_each_entry(text, len, nullptr,
+                 [&](const ProfileLine& line)
+                 {
+                   memcpy(names, line.name, line.name_len);
+                   names[line.name_len] = '\0';
+                   words[n].name = names;
+                   words[n++].count = line.count;
+                   names += line.name_len + 1;
+                 });
+  out->words = words;
+  out->count = n;
+  return 0;
+}
+
+extern "C" v4front_err v4front_load_profile(const char* filename, V4FrontProfile* out,
+                                            uint32_t* error_line)
+{
+  if (!filename || !out)
+    return -1;
+  FILE* fp = fopen(filename, "rb");
+  if (!fp)
+    return -2;
+
+  // Read the whole file (profiles are small text files)
+  char* text = nullptr;
+  size_t len = 0;
+  size_t cap = 0;
+  v4front_err err = 0;
+  for (;;)
+  {
+    if (len == cap)
+    {
+      size_t grown = cap ? cap * 2 : 4096;
+      char* bigger = static_cast<char*>(realloc(text, grown));
+      if (!bigger)
+      {
+        err = front_err_to_int(FrontErr::OutOfMemory);
+        break;
+      }
+      text = bigger;
+      cap = grown;
+    }
+    size_t got = fread(text + len, 1, cap - len, fp);
+    len += got;
+    if (got == 0)
+    {
+      if (ferror(fp))
+        err = -2;
+      break;
+    }
+  }
+  fclose(fp);
+
+  if (err == 0)
+    err = v4front_parse_profile(text ? text : "", len, out, error_line);
+  free(text);
+  return err;
+}
+
+extern "C" void v4front_free_profile(V4FrontProfile* profile)
+{
+  if (!profile)
+    return;
+  free(profile->words);
+  profile->words = nullptr;
+  profile->count = 0;
+}
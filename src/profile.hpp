@@ -0,0 +1,65 @@
+#pragma once
+// Internal use of execution profiles (V4FrontCompileOptions::profile).
+//
+//  - ProfileIndex: case-folded word name -> summed count of a V4FrontProfile.
+//  - A word is hot if its count is at least 1/PROFILE_HOT_RATIO of the
+//    hottest word's count, and cold if the profile names it with count 0.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "arena.hpp"
+#include "v4front/compile.h"
+#include "word_table.hpp"
+
+// Hot words run at least 1/PROFILE_HOT_RATIO as often as the hottest word
+#ifndef PROFILE_HOT_RATIO
+#define PROFILE_HOT_RATIO 64
+#endif
+
+// V4FRONT_OPT_INLINE copies hot words of up to this many times
+// inline_max_size bytes
+#ifndef PROFILE_HOT_INLINE_FACTOR
+#define PROFILE_HOT_INLINE_FACTOR 4
+#endif
+
+namespace v4front
+{
+
+struct ProfileIndex
+{
+  WordIndex index;   // Name -> position in counts
+  uint64_t* counts;  // Summed count of each distinct name
+  uint64_t hot;      // Smallest count of a hot word (at least 1)
+
+  // Index profile with memory from arena; false if it runs out
+  bool build(Arena* arena, const V4FrontProfile* profile);
+
+  // Count of name, or false if the profile does not name it
+  bool find(const char* name, size_t len, uint64_t* count) const
+  {
+    int at = index.lookup(name, len, -1);
+    if (at < 0)
+      return false;
+    *count = counts[at];
+    return true;
+  }
+
+  // V4FRONT_OPT_INLINE size limit for a word called name: max_size scaled
+  // up for hot words, 0 for cold ones
+  uint32_t inline_limit(const char* name, size_t len, uint32_t max_size) const
+  {
+    uint64_t count;
+    if (!find(name, len, &count))
+      return max_size;
+    if (count == 0)
+      return 0;
+    if (count < hot)
+      return max_size;
+    return max_size <= UINT32_MAX / PROFILE_HOT_INLINE_FACTOR
+               ? max_size * PROFILE_HOT_INLINE_FACTOR
+               : UINT32_MAX;
+  }
+};
+
+}  // namespace v4front
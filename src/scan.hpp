@@ -0,0 +1,127 @@
+#pragma once
+// Internal fast paths for skipping whitespace and comments.
+//
+//  - skip_spaces(): first byte in [p, end) that is not whitespace (the
+//    char_class.hpp set: space, \t, \n, \v, \f, \r), or end.
+//  - find_byte(): first occurrence of c in [p, end), or end.
+//  - Both test 16 bytes per step with SSE2 (x86) or NEON (AArch64) while at
+//    least 16 bytes remain, then finish with the scalar loop, so no load ever
+//    reads past end. Define V4FRONT_NO_SIMD to build the scalar loops only.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "char_class.hpp"
+
+#if !defined(V4FRONT_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define V4FRONT_SCAN_SSE2 1
+#include <emmintrin.h>
+#elif !defined(V4FRONT_NO_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define V4FRONT_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(V4FRONT_SCAN_SSE2) || defined(V4FRONT_SCAN_NEON))
+#include <intrin.h>
+#endif
+
+namespace v4front
+{
+
+#if defined(V4FRONT_SCAN_SSE2) || defined(V4FRONT_SCAN_NEON)
+// Index of the lowest set bit (bits != 0)
+static inline unsigned lowest_bit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+  unsigned long idx;
+  if (_BitScanForward(&idx, static_cast<unsigned long>(bits)))
+    return static_cast<unsigned>(idx);
+  _BitScanForward(&idx, static_cast<unsigned long>(bits >> 32));
+  return static_cast<unsigned>(idx) + 32;
+#else
+  return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+}
+#endif
+
+#if defined(V4FRONT_SCAN_SSE2)
+// One bit per byte of v that is whitespace
+static inline uint64_t space_mask(__m128i v)
+{
+  // \t..\r are the bytes whose value minus 9 is at most 4 (unsigned)
+  __m128i t = _mm_sub_epi8(v, _mm_set1_epi8(9));
+  __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t);
+  __m128i sp = _mm_or_si128(ctl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+  return static_cast<uint32_t>(_mm_movemask_epi8(sp));
+}
+#elif defined(V4FRONT_SCAN_NEON)
+// Four bits per byte of a 0x00/0xFF comparison result (NEON has no movemask)
+static inline uint64_t nibble_mask(uint8x16_t m)
+{
+  uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(n), 0);
+}
+
+static inline uint8x16_t space_bytes(uint8x16_t v)
+{
+  uint8x16_t ctl = vcleq_u8(vsubq_u8(v, vdupq_n_u8(9)), vdupq_n_u8(4));
+  return vorrq_u8(ctl, vceqq_u8(v, vdupq_n_u8(' ')));
+}
+#endif
+
+static inline const char* skip_spaces(const char* p, const char* end)
+{
+#if defined(V4FRONT_SCAN_SSE2)
+  while (end - p >= 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    uint64_t other = ~space_mask(v) & 0xFFFF;
+    if (other)
+      return p + lowest_bit(other);
+    p += 16;
+  }
+#elif defined(V4FRONT_SCAN_NEON)
+  while (end - p >= 16)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint64_t other = nibble_mask(vmvnq_u8(space_bytes(v)));
+    if (other)
+      return p + lowest_bit(other) / 4;
+    p += 16;
+  }
+#endif
+  while (p < end && is_space(*p))
+    p++;
+  return p;
+}
+
+static inline const char* find_byte(const char* p, const char* end, char c)
+{
+#if defined(V4FRONT_SCAN_SSE2)
+  const __m128i needle = _mm_set1_epi8(c);
+  while (end - p >= 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    uint32_t hits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+    if (hits)
+      return p + lowest_bit(hits);
+    p += 16;
+  }
+#elif defined(V4FRONT_SCAN_NEON)
+  const uint8x16_t needle = vdupq_n_u8(static_cast<uint8_t>(c));
+  while (end - p >= 16)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint64_t hits = nibble_mask(vceqq_u8(v, needle));
+    if (hits)
+      return p + lowest_bit(hits) / 4;
+    p += 16;
+  }
+#endif
+  while (p < end && *p != c)
+    p++;
+  return p;
+}
+
+}  // namespace v4front
@@ -0,0 +1,508 @@
+#include "stack_effect.hpp"
+
+#include "op_info.hpp"
+#include "v4/opcodes.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+// Cells an opcode takes and leaves on the data (pop/push) and return
+// (rpop/rpush) stacks
+struct OpEffect
+{
+  int8_t pop;
+  int8_t push;
+  int8_t rpop;
+  int8_t rpush;
+};
+
+// Fixed effect of opcode; false for control transfers (handled by the walk)
+// and opcodes whose stack use the VM defines
+bool op_effect(uint8_t opcode, OpEffect* e)
+{
+  int pop = 0, push = 0, rpop = 0, rpush = 0;
+  switch (static_cast<v4::Op>(opcode))
+  {
+    case v4::Op::LIT:
+    case v4::Op::LIT0:
+    case v4::Op::LIT1:
+    case v4::Op::LITN1:
+    case v4::Op::LGET:
+    case v4::Op::LGET0:
+    case v4::Op::LGET1:
+    case v4::Op::TASK_SELF:
+    case v4::Op::TASK_COUNT:
+      push = 1;
+      break;
+    case v4::Op::DUP:
+      pop = 1, push = 2;
+      break;
+    case v4::Op::DROP:
+    case v4::Op::LSET:
+    case v4::Op::LSET0:
+    case v4::Op::LSET1:
+    case v4::Op::TASK_SLEEP:
+      pop = 1;
+      break;
+    case v4::Op::SWAP:
+      pop = 2, push = 2;
+      break;
+    case v4::Op::OVER:
+      pop = 2, push = 3;
+      break;
+    case v4::Op::TOR:
+      pop = 1, rpush = 1;
+      break;
+    case v4::Op::FROMR:
+      push = 1, rpop = 1;
+      break;
+    case v4::Op::RFETCH:
+      push = 1, rpop = 1, rpush = 1;
+      break;
+    case v4::Op::ADD:
+    case v4::Op::SUB:
+    case v4::Op::MUL:
+    case v4::Op::DIV:
+    case v4::Op::MOD:
+    case v4::Op::DIVU:
+    case v4::Op::MODU:
+    case v4::Op::EQ:
+    case v4::Op::NE:
+    case v4::Op::LT:
+    case v4::Op::LE:
+    case v4::Op::GT:
+    case v4::Op::GE:
+    case v4::Op::LTU:
+    case v4::Op::LEU:
+    case v4::Op::AND:
+    case v4::Op::OR:
+    case v4::Op::XOR:
+    case v4::Op::SHL:
+    case v4::Op::SHR:
+    case v4::Op::SAR:
+      pop = 2, push = 1;
+      break;
+    case v4::Op::INC:
+    case v4::Op::DEC:
+    case v4::Op::INVERT:
+    case v4::Op::LOAD:
+    case v4::Op::LOAD8U:
+    case v4::Op::LOAD16U:
+    case v4::Op::LTEE:
+      pop = 1, push = 1;
+      break;
+    case v4::Op::STORE:
+    case v4::Op::STORE8:
+    case v4::Op::STORE16:
+      pop = 2;
+      break;
+    case v4::Op::TASK_YIELD:
+    case v4::Op::CRITICAL_ENTER:
+    case v4::Op::CRITICAL_EXIT:
+    case v4::Op::LINC:
+    case v4::Op::LDEC:
+      break;
+    default:
+      return false;
+  }
+  *e = {static_cast<int8_t>(pop), static_cast<int8_t>(push), static_cast<int8_t>(rpop),
+        static_cast<int8_t>(rpush)};
+  return true;
+}
+
+// Highest local slot the instruction at insn addresses, plus one (0: none)
+uint32_t op_frame(const uint8_t* insn)
+{
+  switch (static_cast<v4::Op>(insn[0]))
+  {
+    case v4::Op::LGET:
+    case v4::Op::LSET:
+    case v4::Op::LTEE:
+    case v4::Op::LINC:
+    case v4::Op::LDEC:
+      return insn[1] + 1u;
+    case v4::Op::LGET0:
+    case v4::Op::LSET0:
+      return 1;
+    case v4::Op::LGET1:
+    case v4::Op::LSET1:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+// What one CALL costs its caller
+struct CallCost
+{
+  V4FrontStackEffect effect;  // The callee's effect and peaks
+  uint32_t locals;            // Local slots in use during the call
+  uint32_t calls;             // CALL nesting during the call
+};
+
+// Cost of a CALL to operand, or false if it cannot be known
+typedef bool (*CallCostFn)(const void* user, uint32_t operand, CallCost* out);
+
+// Why a walk found no effect
+enum class Stop : uint8_t
+{
+  None,
+  Call,         // The cost of a CALL is unknown
+  VmOpcode,     // Opcode with VM-defined stack use
+  Undecodable,  // Unknown opcode, truncated operand, or control leaves the code
+  Underflow,    // Takes cells from the caller's return stack
+};
+
+// Depths relative to the unit's entry before an instruction
+struct Depth
+{
+  int32_t data;  // INT32_MIN: not reached yet
+  int32_t ret;
+};
+
+// Abstract run of one unit: every reachable instruction is visited once with
+// the depth it is reached at
+struct Walk
+{
+  Depth* at;       // Per byte of code
+  uint32_t* work;  // Instructions reached but not visited
+  uint32_t top;
+  uint32_t len;
+  int32_t need;     // Cells taken from below the entry depth (the in count)
+  int32_t peak;     // Highest data depth
+  int32_t rpeak;    // Highest return depth
+  int32_t exit;     // Data depth at RET (INT32_MIN: no RET reached)
+  uint32_t frame;   // Local slots the unit addresses
+  uint32_t locals;  // Most local slots in use during one of its calls
+  uint32_t calls;   // Deepest CALL nesting
+  Stop stop;
+
+  // Reach pc with the given depths
+  FrontErr reach(uint32_t pc, int32_t data, int32_t ret)
+  {
+    if (pc >= len)
+    {
+      stop = Stop::Undecodable;  // Falls off the end or jumps outside the unit
+      return FrontErr::OK;
+    }
+    if (at[pc].data == INT32_MIN)
+    {
+      at[pc] = {data, ret};
+      work[top++] = pc;
+      return FrontErr::OK;
+    }
+    if (at[pc].data != data || at[pc].ret != ret)
+      return FrontErr::StackImbalance;
+    return FrontErr::OK;
+  }
+
+  // Account for an instruction taking pop cells and reaching peak_above
+  // cells above the remaining depth at its highest point
+  void use(int32_t data, int32_t pop, int32_t peak_above)
+  {
+    if (pop - data > need)
+      need = pop - data;
+    if (data - pop + peak_above > peak)
+      peak = data - pop + peak_above;
+  }
+
+  void use_return(int32_t depth)
+  {
+    if (depth > rpeak)
+      rpeak = depth;
+  }
+
+  // The effect found, or all 0 if the walk stopped
+  V4FrontStackEffect effect() const
+  {
+    int32_t in = need;
+    int32_t result = exit == INT32_MIN ? 0 : in + exit;
+    int32_t max_data = in + peak;
+    if (stop != Stop::None || max_data > UINT16_MAX || rpeak > UINT16_MAX)
+      return {0, 0, 0, 0, 0};  // Unknown, or too deep to describe
+    return {1, static_cast<uint16_t>(in), static_cast<uint16_t>(result),
+            static_cast<uint16_t>(max_data), static_cast<uint16_t>(rpeak)};
+  }
+};
+
+// Walk code[0, len). vm_ops (may be NULL) supplies the effects of opcodes
+// without a fixed one. Returns StackImbalance if paths disagree on a depth;
+// otherwise w->stop tells whether the walk completed.
+FrontErr walk_unit(Arena* arena, const uint8_t* code, uint32_t len, CallCostFn cost,
+                   const void* user, const V4FrontStackEffect* vm_ops, Walk* w)
+{
+  w->top = 0;
+  w->len = len;
+  w->need = 0;
+  w->peak = 0;
+  w->rpeak = 0;
+  w->exit = INT32_MIN;
+  w->frame = 0;
+  w->locals = 0;
+  w->calls = 0;
+  w->stop = Stop::None;
+  if (len == 0)
+  {
+    w->stop = Stop::Undecodable;
+    return FrontErr::OK;
+  }
+  w->at = static_cast<Depth*>(arena->alloc(sizeof(Depth) * len));
+  w->work = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * len));
+  if (!w->at || !w->work)
+    return FrontErr::OutOfMemory;
+  for (uint32_t pc = 0; pc < len; pc++)
+    w->at[pc].data = INT32_MIN;
+
+  FrontErr err = w->reach(0, 0, 0);
+  while (err == FrontErr::OK && w->stop == Stop::None && w->top > 0)
+  {
+    uint32_t pc = w->work[--w->top];
+    int32_t data = w->at[pc].data;
+    int32_t ret = w->at[pc].ret;
+    bool is_jump;
+    int operand_len = op_operand_len(code[pc], &is_jump);
+    if (operand_len < 0 || pc + 1 + operand_len > len)
+    {
+      w->stop = Stop::Undecodable;
+      break;
+    }
+    uint32_t next = pc + 1 + operand_len;
+    uint32_t frame = op_frame(code + pc);
+    if (frame > w->frame)
+      w->frame = frame;
+
+    uint8_t opcode = code[pc];
+    OpEffect e;
+    if (is_jump)
+    {
+      int16_t rel = static_cast<int16_t>(code[pc + 1] | (code[pc + 2] << 8));
+      int64_t target = static_cast<int64_t>(next) + rel;
+      int32_t pop = opcode == static_cast<uint8_t>(v4::Op::JMP) ? 0 : 1;
+      w->use(data, pop, 0);
+      if (target < 0)
+        w->stop = Stop::Undecodable;
+      else
+        err = w->reach(static_cast<uint32_t>(target), data - pop, ret);
+      if (err == FrontErr::OK && pop)
+        err = w->reach(next, data - pop, ret);  // JZ/JNZ fall through
+    }
+    else if (opcode == static_cast<uint8_t>(v4::Op::RET))
+    {
+      if (w->exit == INT32_MIN)
+        w->exit = data;
+      else if (w->exit != data)
+        err = FrontErr::StackImbalance;
+    }
+    else if (opcode == static_cast<uint8_t>(v4::Op::CALL))
+    {
+      CallCost c;
+      if (!cost(user, code[pc + 1] | (code[pc + 2] << 8), &c) || !c.effect.known)
+      {
+        w->stop = Stop::Call;
+        break;
+      }
+      w->use(data, c.effect.in, c.effect.max_data);
+      w->use_return(ret + c.effect.max_return);
+      if (c.locals > w->locals)
+        w->locals = c.locals;
+      if (c.calls > w->calls)
+        w->calls = c.calls;
+      err = w->reach(next, data - c.effect.in + c.effect.out, ret);
+    }
+    else if (op_effect(opcode, &e))
+    {
+      if (e.rpop > ret)
+      {
+        w->stop = Stop::Underflow;
+        break;
+      }
+      w->use(data, e.pop, e.push);
+      w->use_return(ret - e.rpop + e.rpush);
+      err = w->reach(next, data - e.pop + e.push, ret - e.rpop + e.rpush);
+    }
+    else if (vm_ops && vm_ops[opcode].known)
+    {
+      const V4FrontStackEffect& v = vm_ops[opcode];
+      w->use(data, v.in, v.max_data);
+      w->use_return(ret + v.max_return);
+      err = w->reach(next, data - v.in + v.out, ret);
+    }
+    else
+    {
+      w->stop = Stop::VmOpcode;
+    }
+  }
+  return err;
+}
+
+// Call costs for infer_stack_effect: the callee's effect alone
+struct InferCalls
+{
+  CalleeEffect callee;
+  const void* user;
+  uint32_t count;
+};
+
+bool infer_call_cost(const void* user, uint32_t operand, CallCost* out)
+{
+  const InferCalls* calls = static_cast<const InferCalls*>(user);
+  if (operand >= calls->count)
+    return false;
+  out->effect = *calls->callee(calls->user, operand);
+  out->locals = 0;
+  out->calls = 0;
+  return true;
+}
+
+// Per-word results of the task analysis
+struct TaskWord
+{
+  uint8_t state;  // 0 unvisited, 1 on the DFS path, 2 ordered, 3 summarized
+  CallCost cost;  // What a CALL to the word costs (state 3)
+};
+
+struct TaskCalls
+{
+  const TaskWord* words;
+  uint32_t count;
+};
+
+bool task_call_cost(const void* user, uint32_t operand, CallCost* out)
+{
+  const TaskCalls* calls = static_cast<const TaskCalls*>(user);
+  if (operand >= calls->count || calls->words[operand].state != 3)
+    return false;
+  *out = calls->words[operand].cost;
+  return true;
+}
+
+// Operand of the next CALL in code from *pc on, advancing *pc past it; false
+// at the end or on code that cannot be decoded (the walk reports that)
+bool next_call(const uint8_t* code, uint32_t len, uint32_t* pc, uint32_t* operand)
+{
+  while (*pc < len)
+  {
+    uint32_t at = *pc;
+    int operand_len = op_operand_len(code[at]);
+    if (operand_len < 0 || at + 1 + operand_len > len)
+      return false;
+    *pc = at + 1 + operand_len;
+    if (code[at] == static_cast<uint8_t>(v4::Op::CALL))
+    {
+      *operand = code[at + 1] | (code[at + 2] << 8);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+FrontErr infer_stack_effect(Arena* arena, const uint8_t* code, uint32_t len,
+                            CalleeEffect callee, const void* user,
+                            uint32_t callee_count, V4FrontStackEffect* out)
+{
+  *out = {0, 0, 0, 0, 0};
+  InferCalls calls = {callee, user, callee_count};
+  Walk w;
+  FrontErr err = walk_unit(arena, code, len, infer_call_cost, &calls, nullptr, &w);
+  if (err == FrontErr::OK)
+    *out = w.effect();
+  return err;
+}
+
+FrontErr task_resources(Arena* arena, const V4FrontWord* words, int count, int entry,
+                        const V4FrontStackEffect* vm_ops, V4FrontTaskResources* out)
+{
+  *out = {V4FRONT_TASK_BOUNDED, -1, 0, 0, 0, 0};
+  TaskWord* info = static_cast<TaskWord*>(arena->alloc(sizeof(TaskWord) * count));
+  uint32_t* order = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * count));
+  uint32_t* path = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * count));
+  uint32_t* resume = static_cast<uint32_t*>(arena->alloc(sizeof(uint32_t) * count));
+  if (!info || !order || !path || !resume)
+    return FrontErr::OutOfMemory;
+  for (int i = 0; i < count; i++)
+    info[i].state = 0;
+
+  // Order the words the entry reaches callees first (iterative DFS; a call
+  // back into the path is a cycle)
+  uint32_t ordered = 0;
+  uint32_t depth = 0;
+  path[depth] = static_cast<uint32_t>(entry);
+  resume[depth++] = 0;
+  info[entry].state = 1;
+  while (depth > 0)
+  {
+    uint32_t w = path[depth - 1];
+    uint32_t operand;
+    if (!next_call(words[w].code, words[w].code_len, &resume[depth - 1], &operand))
+    {
+      info[w].state = 2;
+      order[ordered++] = w;
+      depth--;
+      continue;
+    }
+    if (operand >= static_cast<uint32_t>(count))
+      continue;  // Reported by the walk
+    if (info[operand].state == 1)
+    {
+      out->reason = V4FRONT_TASK_RECURSION;
+      out->culprit = static_cast<int32_t>(w);
+      return FrontErr::OK;
+    }
+    if (info[operand].state == 0)
+    {
+      info[operand].state = 1;
+      path[depth] = operand;
+      resume[depth++] = 0;
+    }
+  }
+
+  // Summarize them in that order: every callee is done before its callers
+  TaskCalls calls = {info, static_cast<uint32_t>(count)};
+  Walk w;
+  for (uint32_t i = 0; i < ordered; i++)
+  {
+    uint32_t k = order[i];
+    FrontErr err =
+        walk_unit(arena, words[k].code, words[k].code_len, task_call_cost, &calls,
+                  vm_ops, &w);
+    if (err != FrontErr::OK && err != FrontErr::StackImbalance)
+      return err;
+    V4FrontStackEffect effect = w.effect();
+    if (err == FrontErr::StackImbalance || !effect.known ||
+        effect.max_return == UINT16_MAX)
+    {
+      out->culprit = static_cast<int32_t>(k);
+      if (err == FrontErr::StackImbalance || w.stop == Stop::Underflow)
+        out->reason = V4FRONT_TASK_UNBALANCED;
+      else if (w.stop == Stop::Call)
+        out->reason = V4FRONT_TASK_EXTERNAL_CALL;
+      else if (w.stop == Stop::VmOpcode)
+        out->reason = V4FRONT_TASK_VM_OPCODE;
+      else
+        out->reason = V4FRONT_TASK_UNDECODABLE;  // Also: too deep to describe
+      return FrontErr::OK;
+    }
+
+    // A call adds the return address and the word's frame to what it uses
+    CallCost* cost = &info[k].cost;
+    cost->effect = effect;
+    cost->effect.max_return = static_cast<uint16_t>(effect.max_return + 1);
+    cost->locals = w.frame + w.locals;
+    cost->calls = w.calls + 1;
+    info[k].state = 3;
+  }
+
+  const CallCost& top = info[entry].cost;
+  out->data_depth = top.effect.max_data;
+  out->return_depth = top.effect.max_return;
+  out->locals = top.locals;
+  out->call_depth = top.calls - 1;
+  return FrontErr::OK;
+}
+
+}  // namespace v4front
@@ -0,0 +1,40 @@
+#pragma once
+// Internal stack-effect inference (V4FRONT_OPT_STACK_EFFECTS) and task
+// resource analysis (v4front_task_resources).
+//
+//  - Both walk every path through a unit's code with the fixed effect of
+//    each opcode and the cost of each call.
+//  - Inference runs on a definition's code as compiled at ;, before the
+//    passes and fusion. The passes only ever remove stack traffic, so the
+//    depths found there bound the final code too. A word can only call
+//    earlier words (or itself), so every callee's effect is already known.
+//  - The task analysis runs on finished output, where calls may go either
+//    way (batch modules call each other), so it orders the call graph first.
+
+#include <cstdint>
+
+#include "arena.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+
+namespace v4front
+{
+
+// Effect of the word a CALL operand names; index is below callee_count
+typedef const V4FrontStackEffect* (*CalleeEffect)(const void* user, uint32_t index);
+
+// Infer the effect of code[0, len) into *out. CALL operands below callee_count
+// name words whose effect callee(user, operand) returns; any other CALL leaves
+// the effect unknown (out->known == 0), as does code that cannot be decoded.
+// Returns StackImbalance if two paths reach an instruction, or two RETs, with
+// different data or return stack depths. Scratch memory comes from arena.
+FrontErr infer_stack_effect(Arena* arena, const uint8_t* code, uint32_t len,
+                            CalleeEffect callee, const void* user,
+                            uint32_t callee_count, V4FrontStackEffect* out);
+
+// Worst-case stack and local use of words[entry] and everything it calls (see
+// v4front_task_resources). vm_ops may be NULL. Scratch memory comes from arena.
+FrontErr task_resources(Arena* arena, const V4FrontWord* words, int count, int entry,
+                        const V4FrontStackEffect* vm_ops, V4FrontTaskResources* out);
+
+}  // namespace v4front
@@ -0,0 +1,137 @@
+#include "superinsn.hpp"
+
+#include "ir.hpp"
+#include "op_info.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+// Immediates of the fused instruction: the window's operands, concatenated
+constexpr uint32_t kMaxFusedImm = 4;
+
+// True if insns[0, entry.length) match entry and can be fused
+bool window_matches(const IrInsn* insns, uint32_t avail,
+                    const V4FrontSuperinstruction& entry)
+{
+  if (entry.length > avail)
+    return false;
+  for (uint32_t k = 0; k < entry.length; k++)
+  {
+    if (insns[k].op != entry.pattern[k] || insns[k].dead)
+      return false;
+    if (k > 0 && insns[k].is_target)
+      return false;  // A jump into the middle needs the separate instructions
+  }
+  return true;
+}
+
+// Rewrite insns[0] into the fused instruction and drop the rest of the window
+void fuse_window(IrInsn* insns, const V4FrontSuperinstruction& entry)
+{
+  IrInsn* last = &insns[entry.length - 1];
+  if (last->is_jump)
+  {
+    insns[0].target = last->target;
+    insns[0].is_jump = true;
+    insns[0].imm_len = 2;
+    insns[0].imm = 0;
+  }
+  else
+  {
+    uint32_t raw = 0;
+    uint32_t shift = 0;
+    for (uint32_t k = 0; k < entry.length; k++)
+    {
+      uint32_t len = insns[k].imm_len;
+      if (len == 0)
+        continue;
+      uint32_t mask = len == 4 ? UINT32_MAX : (1u << (8 * len)) - 1;
+      raw |= (static_cast<uint32_t>(insns[k].imm) & mask) << shift;
+      shift += 8 * len;
+    }
+    insns[0].imm_len = static_cast<uint8_t>(shift / 8);
+    insns[0].imm = static_cast<int32_t>(raw);
+  }
+  insns[0].op = entry.opcode;
+  for (uint32_t k = 1; k < entry.length; k++)
+    insns[k].dead = true;
+}
+
+}  // namespace
+
+bool superinsn_table_valid(const V4FrontSuperinstruction* table, uint32_t count)
+{
+  if (count > 0 && !table)
+    return false;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const V4FrontSuperinstruction& entry = table[i];
+    if (entry.length < 2 || entry.length > 4 || op_operand_len(entry.opcode) >= 0)
+      return false;
+
+    uint32_t imm_total = 0;
+    for (uint32_t k = 0; k < entry.length; k++)
+    {
+      bool is_jump;
+      int len = op_operand_len(entry.pattern[k], &is_jump);
+      if (len < 0)
+        return false;
+      if (is_jump)
+      {
+        // Only the last element may branch, and it brings the only operand
+        if (k + 1 != entry.length || imm_total != 0)
+          return false;
+        continue;
+      }
+      imm_total += static_cast<uint32_t>(len);
+    }
+    if (imm_total > kMaxFusedImm)
+      return false;
+  }
+  return true;
+}
+
+FrontErr fuse_superinstructions(Arena* arena, const V4FrontSuperinstruction* table,
+                                uint32_t count, uint8_t* code, uint32_t* size,
+                                uint32_t* pcs, uint32_t pc_count)
+{
+  if (!code || *size == 0 || count == 0)
+    return FrontErr::OK;
+
+  IrCode ir;
+  bool decoded;
+  FrontErr err = ir_decode(arena, code, *size, &ir, &decoded);
+  if (err != FrontErr::OK || !decoded)
+    return err;
+  ir_mark_targets(&ir);
+
+  bool changed = false;
+  for (uint32_t i = 0; i < ir.count; i++)
+  {
+    const V4FrontSuperinstruction* best = nullptr;
+    for (uint32_t t = 0; t < count; t++)
+    {
+      if ((!best || table[t].length > best->length) &&
+          window_matches(&ir.insns[i], ir.count - i, table[t]))
+        best = &table[t];
+    }
+    if (!best)
+      continue;
+    fuse_window(&ir.insns[i], *best);
+    i += best->length - 1;
+    changed = true;
+  }
+  if (!changed)
+    return FrontErr::OK;
+
+  ir_compact(&ir);
+  if ((err = ir_emit(&ir, code, size)) != FrontErr::OK)
+    return err;
+  ir_remap_offsets(&ir, pcs, pc_count);
+  return FrontErr::OK;
+}
+
+}  // namespace v4front
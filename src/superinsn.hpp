@@ -0,0 +1,29 @@
+#pragma once
+// Internal superinstruction fusion.
+//
+//  - The target VM advertises fused opcodes as V4FrontSuperinstruction
+//    entries; this pass replaces matching instruction windows with them.
+//  - Fused opcodes are unknown to opcodes.def, so every other pass (and
+//    anything else that decodes emitted code) must run before this one.
+
+#include <cstdint>
+
+#include "arena.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+
+namespace v4front
+{
+
+// True if every entry of table can be fused (see V4FrontSuperinstruction)
+bool superinsn_table_valid(const V4FrontSuperinstruction* table, uint32_t count);
+
+// Fuse windows of code[0, *size) that match table, longest pattern first, and
+// update *size. A window is only fused if no jump lands inside it. Code that
+// cannot be decoded is left as is. The ascending offsets pcs[0, pc_count) are
+// moved along with the code (see ir_remap_offsets).
+FrontErr fuse_superinstructions(Arena* arena, const V4FrontSuperinstruction* table,
+                                uint32_t count, uint8_t* code, uint32_t* size,
+                                uint32_t* pcs = nullptr, uint32_t pc_count = 0);
+
+}  // namespace v4front
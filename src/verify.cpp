@@ -0,0 +1,160 @@
+// Bytecode verifier (v4front_verify_code / v4front_verify_bytecode).
+//
+//  - One linear decode of each unit with the disassembler's tables. Every
+//    instruction start is set in one bitmap and every jump target in another;
+//    a target that is not also a start lands mid-instruction.
+//  - Bitmaps of units up to kInlineBits bytes live on the stack; larger units
+//    allocate theirs.
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/disasm.hpp"
+#include "v4front/errors.hpp"
+
+using namespace v4front;
+
+namespace
+{
+
+constexpr size_t kInlineBits = 8192;
+constexpr size_t kWordBits = 64;
+
+uint8_t op(v4::Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+bool is_known(uint8_t opcode)
+{
+  return strcmp(op_info(opcode).name, "???") != 0;
+}
+
+FrontErr fail(V4FrontVerifyResult* out, uint32_t reason, size_t pc)
+{
+  out->reason = reason;
+  out->pc = static_cast<uint32_t>(pc);
+  return FrontErr::InvalidImage;
+}
+
+// Verify code[0, len) with bitmaps of (len + 63) / 64 words each
+FrontErr verify_unit(const uint8_t* code, size_t len, uint32_t call_limit,
+                     uint64_t* starts, uint64_t* targets, V4FrontVerifyResult* out)
+{
+  const size_t words = (len + kWordBits - 1) / kWordBits;
+  memset(starts, 0, words * sizeof(uint64_t));
+  memset(targets, 0, words * sizeof(uint64_t));
+
+  DecodedInsn insn = {};
+  for (size_t pc = 0; pc < len; pc += insn.length)
+  {
+    decode_one(code, len, pc, insn);
+    if (!is_known(insn.opcode))
+      return fail(out, V4FRONT_VERIFY_UNKNOWN_OPCODE, pc);
+    if (insn.truncated)
+      return fail(out, V4FRONT_VERIFY_TRUNCATED, pc);
+    starts[pc / kWordBits] |= uint64_t(1) << (pc % kWordBits);
+
+    if (insn.imm_kind == ImmKind::Rel16)
+    {
+      // Offsets are relative to the end of the instruction
+      int64_t target = static_cast<int64_t>(pc + insn.length) + insn.imm;
+      if (target < 0 || target >= static_cast<int64_t>(len))
+        return fail(out, V4FRONT_VERIFY_BAD_JUMP, pc);
+      size_t t = static_cast<size_t>(target);
+      targets[t / kWordBits] |= uint64_t(1) << (t % kWordBits);
+    }
+    else if (insn.imm_kind == ImmKind::Idx16)
+    {
+      if (static_cast<uint16_t>(insn.imm) >= call_limit)
+        return fail(out, V4FRONT_VERIFY_BAD_CALL, pc);
+    }
+    if (pc + insn.length == len && insn.opcode != op(v4::Op::RET) &&
+        insn.opcode != op(v4::Op::JMP))
+      return fail(out, V4FRONT_VERIFY_FALLS_OFF, pc);
+  }
+
+  for (size_t w = 0; w < words; w++)
+  {
+    uint64_t stray = targets[w] & ~starts[w];
+    if (!stray)
+      continue;
+    // Report the first jump to the lowest stray target
+    size_t t = w * kWordBits;
+    while (!(stray & 1))
+    {
+      stray >>= 1;
+      t++;
+    }
+    for (size_t pc = 0; pc < len; pc += insn.length)
+    {
+      decode_one(code, len, pc, insn);
+      if (insn.imm_kind == ImmKind::Rel16 &&
+          static_cast<int64_t>(pc + insn.length) + insn.imm == static_cast<int64_t>(t))
+        return fail(out, V4FRONT_VERIFY_BAD_JUMP, pc);
+    }
+  }
+  return FrontErr::OK;
+}
+
+// verify_unit with bitmaps on the stack or, for large units, the heap
+FrontErr verify_unit_alloc(const uint8_t* code, size_t len, uint32_t call_limit,
+                           V4FrontVerifyResult* out)
+{
+  uint64_t inline_bits[2 * kInlineBits / kWordBits];
+  uint64_t* bits = inline_bits;
+  const size_t words = (len + kWordBits - 1) / kWordBits;
+  if (len > kInlineBits)
+  {
+    bits = static_cast<uint64_t*>(malloc(2 * words * sizeof(uint64_t)));
+    if (!bits)
+      return FrontErr::OutOfMemory;
+  }
+  FrontErr err = verify_unit(code, len, call_limit, bits, bits + words, out);
+  if (bits != inline_bits)
+    free(bits);
+  return err;
+}
+
+}  // namespace
+
+extern "C" v4front_err v4front_verify_code(const uint8_t* code, size_t len,
+                                           uint32_t call_limit, V4FrontVerifyResult* out)
+{
+  V4FrontVerifyResult scratch;
+  if (!out)
+    out = &scratch;
+  *out = V4FrontVerifyResult{V4FRONT_VERIFY_OK, -1, 0};
+  if (!code && len > 0)
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  return front_err_to_int(verify_unit_alloc(code, len, call_limit, out));
+}
+
+extern "C" v4front_err v4front_verify_bytecode(const V4FrontBuf* buf, uint32_t call_limit,
+                                               V4FrontVerifyResult* out)
+{
+  V4FrontVerifyResult scratch;
+  if (!out)
+    out = &scratch;
+  *out = V4FrontVerifyResult{V4FRONT_VERIFY_OK, -1, 0};
+  if (!buf || (!buf->data && buf->size > 0))
+    return front_err_to_int(FrontErr::BufferTooSmall);
+  if (call_limit == 0)
+    call_limit = static_cast<uint32_t>(buf->word_count);
+
+  FrontErr err = verify_unit_alloc(buf->data, buf->size, call_limit, out);
+  for (int i = 0; err == FrontErr::OK && i < buf->word_count; i++)
+  {
+    const V4FrontWord& word = buf->words[i];
+    if (!word.code && word.code_len > 0)
+      return front_err_to_int(FrontErr::BufferTooSmall);
+    out->unit = i;
+    err = verify_unit_alloc(word.code, word.code_len, call_limit, out);
+  }
+  if (err == FrontErr::OK)
+    out->unit = -1;
+  return front_err_to_int(err);
+}
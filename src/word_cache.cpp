@@ -0,0 +1,206 @@
+#include "word_cache.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace v4front
+{
+
+namespace
+{
+
+uint64_t key_hash(const CacheKey& key)
+{
+  uint64_t h = hash64(key.name, key.name_len);
+  h = hash64(key.body, key.body_len, h);
+  h = hash64(&key.flags, sizeof(key.flags), h);
+  h = hash64(&key.inline_max_size, sizeof(key.inline_max_size), h);
+  return hash64(&key.self_index, sizeof(key.self_index), h);
+}
+
+bool key_matches(const CachedWord* w, uint64_t hash, const CacheKey& key)
+{
+  return w->hash == hash && w->flags == key.flags &&
+         w->inline_max_size == key.inline_max_size && w->self_index == key.self_index &&
+         w->name_len == key.name_len && w->body_len == key.body_len &&
+         memcmp(w->name, key.name, key.name_len) == 0 &&
+         memcmp(w->body, key.body, key.body_len) == 0;
+}
+
+int by_generation(const void* a, const void* b)
+{
+  uint32_t ga = (*static_cast<CachedWord* const*>(a))->generation;
+  uint32_t gb = (*static_cast<CachedWord* const*>(b))->generation;
+  return (ga > gb) - (ga < gb);
+}
+
+}  // namespace
+
+void WordCache::init(size_t max)
+{
+  entries = nullptr;
+  count = 0;
+  cap = 0;
+  slots = nullptr;
+  mask = 0;
+  bytes = 0;
+  max_bytes = max;
+  generation = 0;
+  reused = 0;
+  compiled = 0;
+}
+
+void WordCache::destroy()
+{
+  for (uint32_t i = 0; i < count; i++)
+    free(entries[i]);
+  free(entries);
+  free(slots);
+  init(0);
+}
+
+CachedWord* WordCache::find(const CacheKey& key) const
+{
+  if (!slots)
+    return nullptr;
+  uint64_t hash = key_hash(key);
+  for (uint32_t i = static_cast<uint32_t>(hash) & mask;; i = (i + 1) & mask)
+  {
+    if (slots[i] == 0)
+      return nullptr;
+    CachedWord* w = entries[slots[i] - 1];
+    if (key_matches(w, hash, key))
+      return w;
+  }
+}
+
+bool WordCache::insert(const CacheKey& key, const CacheDep* deps, uint32_t dep_count,
+                       const uint8_t* code, uint32_t code_len, const uint8_t* final_code,
+                       uint32_t final_len)
+{
+  // One block: header, deps, then the byte arrays
+  size_t size = sizeof(CachedWord) + sizeof(CacheDep) * dep_count + key.name_len +
+                key.body_len + code_len + final_len;
+  CachedWord* w = static_cast<CachedWord*>(malloc(size));
+  if (!w)
+    return false;
+  CacheDep* w_deps = reinterpret_cast<CacheDep*>(w + 1);
+  char* w_name = reinterpret_cast<char*>(w_deps + dep_count);
+  char* w_body = w_name + key.name_len;
+  uint8_t* w_code = reinterpret_cast<uint8_t*>(w_body + key.body_len);
+  uint8_t* w_final = w_code + code_len;
+  if (dep_count)
+    memcpy(w_deps, deps, sizeof(CacheDep) * dep_count);
+  memcpy(w_name, key.name, key.name_len);
+  memcpy(w_body, key.body, key.body_len);
+  memcpy(w_code, code, code_len);
+  memcpy(w_final, final_code, final_len);
+
+  w->hash = key_hash(key);
+  w->generation = generation;
+  w->flags = key.flags;
+  w->inline_max_size = key.inline_max_size;
+  w->self_index = key.self_index;
+  w->name_len = key.name_len;
+  w->body_len = key.body_len;
+  w->dep_count = dep_count;
+  w->code_len = code_len;
+  w->final_len = final_len;
+  w->bytes = size;
+  w->deps = w_deps;
+  w->name = w_name;
+  w->body = w_body;
+  w->code = w_code;
+  w->final_code = w_final;
+
+  // Same definition compiled against changed words: replace the old entry
+  for (uint32_t i = static_cast<uint32_t>(w->hash) & mask; slots && slots[i];
+       i = (i + 1) & mask)
+  {
+    CachedWord*& old = entries[slots[i] - 1];
+    if (key_matches(old, w->hash, key))
+    {
+      bytes = bytes - old->bytes + w->bytes;
+      free(old);
+      old = w;
+      return true;
+    }
+  }
+
+  if (count == cap)
+  {
+    uint32_t new_cap = cap ? cap * 2 : 16;
+    CachedWord** grown =
+        static_cast<CachedWord**>(realloc(entries, sizeof(CachedWord*) * new_cap));
+    if (!grown)
+    {
+      free(w);
+      return false;
+    }
+    entries = grown;
+    cap = new_cap;
+  }
+  if ((count + 1) * 2 > mask + 1 || !slots)
+  {
+    if (!rebuild_slots(slots ? (mask + 1) * 2 : 32))
+    {
+      free(w);
+      return false;
+    }
+  }
+
+  entries[count++] = w;
+  bytes += w->bytes;
+  uint32_t i = static_cast<uint32_t>(w->hash) & mask;
+  while (slots[i])
+    i = (i + 1) & mask;
+  slots[i] = count;
+  return true;
+}
+
+void WordCache::trim()
+{
+  if (bytes <= max_bytes)
+    return;
+
+  // Oldest first; drop them until the rest fits
+  qsort(entries, count, sizeof(CachedWord*), by_generation);
+  uint32_t drop = 0;
+  while (drop < count && bytes > max_bytes)
+  {
+    bytes -= entries[drop]->bytes;
+    free(entries[drop]);
+    drop++;
+  }
+  memmove(entries, entries + drop, sizeof(CachedWord*) * (count - drop));
+  count -= drop;
+
+  // Fewer entries fit in the same slots
+  memset(slots, 0, sizeof(uint32_t) * (mask + 1));
+  place_all();
+}
+
+bool WordCache::rebuild_slots(uint32_t slot_count)
+{
+  uint32_t* fresh = static_cast<uint32_t*>(calloc(slot_count, sizeof(uint32_t)));
+  if (!fresh)
+    return false;
+  free(slots);
+  slots = fresh;
+  mask = slot_count - 1;
+  place_all();
+  return true;
+}
+
+void WordCache::place_all()
+{
+  for (uint32_t e = 0; e < count; e++)
+  {
+    uint32_t i = static_cast<uint32_t>(entries[e]->hash) & mask;
+    while (slots[i])
+      i = (i + 1) & mask;
+    slots[i] = e + 1;
+  }
+}
+
+}  // namespace v4front
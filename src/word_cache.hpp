@@ -0,0 +1,119 @@
+#pragma once
+// Internal cache of compiled word bodies, kept by a context across
+// compilations (incremental recompilation).
+//
+//  - An entry is one colon definition: its exact name and body text (the
+//    source between the name and ';'), the options and dictionary index it
+//    was compiled with, what every looked-up token of the body resolved to,
+//    and its code before and after the per-unit passes.
+//  - A definition whose text, options, index and lookups all match an entry
+//    needs no code generation. Lookups of words from the same compilation
+//    record the callee's fingerprint (its code and value), so a changed word
+//    also invalidates every word that used it.
+//  - Every entry is one malloc'd block. trim() evicts the least recently
+//    used entries once more than max_bytes are held.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4front
+{
+
+// FNV-1a, 64-bit (seed: the FNV offset basis, or a previous result to chain)
+static inline uint64_t hash64(const void* data, size_t len,
+                              uint64_t h = 14695981039346656037ull)
+{
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= p[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+enum class CacheDepKind : uint8_t
+{
+  None,     // Not a word (a primitive or a number)
+  Word,     // Word of the same compilation
+  Context,  // Word registered in the context
+};
+
+// How one token of a cached body was resolved
+struct CacheDep
+{
+  uint32_t offset;       // Token position in the body
+  uint32_t len;          // Token length
+  CacheDepKind kind;
+  int32_t target;        // Dictionary index (Word) or VM word index (Context)
+  uint64_t fingerprint;  // Word: fingerprint of the dictionary entry
+};
+
+// What a definition was compiled from
+struct CacheKey
+{
+  const char* name;
+  uint32_t name_len;
+  const char* body;
+  uint32_t body_len;
+  uint32_t flags;            // Effective V4FRONT_OPT_* bits
+  uint32_t inline_max_size;
+  int32_t self_index;        // Dictionary index of the word (RECURSE target)
+};
+
+struct CachedWord
+{
+  uint64_t hash;        // Of the key
+  uint32_t generation;  // Last compilation that used the entry
+  uint32_t flags;
+  uint32_t inline_max_size;
+  int32_t self_index;
+  uint32_t name_len;
+  uint32_t body_len;
+  uint32_t dep_count;
+  uint32_t code_len;
+  uint32_t final_len;
+  size_t bytes;               // Size of the whole block
+  const CacheDep* deps;
+  const char* name;
+  const char* body;
+  const uint8_t* code;        // Before the passes (what callers inline)
+  const uint8_t* final_code;  // After the passes
+  // Followed by deps, name, body, code and final_code
+};
+
+struct WordCache
+{
+  CachedWord** entries;  // In no particular order
+  uint32_t count;
+  uint32_t cap;
+  uint32_t* slots;       // Open addressing on the key hash: entry index + 1 (0: empty)
+  uint32_t mask;         // Slot count - 1
+  size_t bytes;          // Sum of entry sizes
+  size_t max_bytes;
+  uint32_t generation;   // Current compilation
+
+  // Counts of the last successful compilation
+  uint32_t reused;
+  uint32_t compiled;
+
+  void init(size_t max);
+  void destroy();
+
+  // The entry compiled from key, or nullptr
+  CachedWord* find(const CacheKey& key) const;
+
+  // Add (or replace) the entry for key; false if out of memory
+  bool insert(const CacheKey& key, const CacheDep* deps, uint32_t dep_count,
+              const uint8_t* code, uint32_t code_len, const uint8_t* final_code,
+              uint32_t final_len);
+
+  // Evict least recently used entries until at most max_bytes are held
+  void trim();
+
+ private:
+  bool rebuild_slots(uint32_t slot_count);
+  void place_all();
+};
+
+}  // namespace v4front
@@ -0,0 +1,171 @@
+#pragma once
+// Internal word lookup structures shared by the compiler and its context.
+//
+//  - WordIndex: open-addressing hash table (linear probing) mapping a
+//    case-folded name to an integer value (dictionary slot or VM word index).
+//    Names are interned elsewhere (see Arena::intern).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "arena.hpp"
+#include "char_class.hpp"
+
+namespace v4front
+{
+
+// FNV-1a over case-folded bytes
+static constexpr uint32_t hash_ci(const char* s, size_t len)
+{
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= static_cast<uint8_t>(fold_ascii(s[i]));
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// Case-insensitive match of a NUL-terminated name against a token of length len
+static constexpr bool name_eq_ci(const char* name, const char* token, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    if (name[i] == '\0' || fold_ascii(name[i]) != fold_ascii(token[i]))
+      return false;
+  }
+  return name[len] == '\0';
+}
+
+// ---------------------------------------------------------------------------
+// WordIndex
+// ---------------------------------------------------------------------------
+struct WordIndex
+{
+  struct Slot
+  {
+    const char* name;  // nullptr = empty (names are owned elsewhere, e.g. an arena)
+    uint32_t hash;
+    int value;
+  };
+
+  static constexpr uint32_t kMinSlots = 16;
+
+  Slot* slots;
+  uint32_t mask;   // slot count - 1 (slot count is a power of two)
+  uint32_t count;  // Occupied slots
+  Arena* arena;    // Slot storage source (nullptr = heap)
+
+  void init(Arena* a = nullptr)
+  {
+    slots = nullptr;
+    mask = 0;
+    count = 0;
+    arena = a;
+  }
+
+  void destroy()
+  {
+    if (!arena)
+      free(slots);
+    init(arena);
+  }
+
+  void clear()
+  {
+    if (slots)
+      memset(slots, 0, sizeof(Slot) * (mask + 1));
+    count = 0;
+  }
+
+  // Returns the slot holding name, or nullptr if absent
+  Slot* find(const char* name, size_t len) const
+  {
+    return find(name, len, hash_ci(name, len));
+  }
+
+  // find() with hash = hash_ci(name, len) already known
+  Slot* find(const char* name, size_t len, uint32_t hash) const
+  {
+    if (!slots)
+      return nullptr;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask)
+    {
+      Slot* s = &slots[i];
+      if (!s->name)
+        return nullptr;
+      if (s->hash == hash && name_eq_ci(s->name, name, len))
+        return s;
+    }
+  }
+
+  int lookup(const char* name, size_t len, int not_found) const
+  {
+    const Slot* s = find(name, len);
+    return s ? s->value : not_found;
+  }
+
+  int lookup(const char* name, size_t len, uint32_t hash, int not_found) const
+  {
+    const Slot* s = find(name, len, hash);
+    return s ? s->value : not_found;
+  }
+
+  // Insert a name that is known to be absent. Keeps load factor <= 1/2.
+  bool insert(const char* name, size_t len, int value)
+  {
+    if ((count + 1) * 2 > mask + 1 || !slots)
+    {
+      if (!grow())
+        return false;
+    }
+    place(name, hash_ci(name, len), value);
+    count++;
+    return true;
+  }
+
+ private:
+  void place(const char* name, uint32_t hash, int value)
+  {
+    uint32_t i = hash & mask;
+    while (slots[i].name)
+      i = (i + 1) & mask;
+    slots[i].name = name;
+    slots[i].hash = hash;
+    slots[i].value = value;
+  }
+
+  bool grow()
+  {
+    uint32_t old_n = slots ? mask + 1 : 0;
+    uint32_t new_n = old_n ? old_n * 2 : kMinSlots;
+    Slot* fresh;
+    if (arena)
+    {
+      fresh = static_cast<Slot*>(arena->alloc(sizeof(Slot) * new_n));
+      if (fresh)
+        memset(fresh, 0, sizeof(Slot) * new_n);
+    }
+    else
+    {
+      fresh = static_cast<Slot*>(calloc(new_n, sizeof(Slot)));
+    }
+    if (!fresh)
+      return false;
+    Slot* old = slots;
+    slots = fresh;
+    mask = new_n - 1;
+    for (uint32_t i = 0; i < old_n; i++)
+    {
+      if (old[i].name)
+        place(old[i].name, old[i].hash, old[i].value);
+    }
+    if (!arena)
+      free(old);
+    return true;
+  }
+};
+
+}  // namespace v4front
@@ -0,0 +1,113 @@
+#include "work_pool.hpp"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace v4front
+{
+
+namespace
+{
+
+// Indices [next, end) not yet taken from one worker's share
+struct Share
+{
+  std::mutex lock;
+  uint32_t next;
+  uint32_t end;
+};
+
+struct Pool
+{
+  Share* shares;
+  uint32_t workers;
+  PoolTask task;
+  void* user;
+};
+
+// Take the next index of the worker's own share
+bool take_own(Share* share, uint32_t* index)
+{
+  std::lock_guard<std::mutex> guard(share->lock);
+  if (share->next == share->end)
+    return false;
+  *index = share->next++;
+  return true;
+}
+
+// Take the last index of the fullest other share
+bool steal(Pool* pool, uint32_t self, uint32_t* index)
+{
+  while (true)
+  {
+    // Pick the fullest share, then re-check it under its own lock: its owner
+    // or another thief may have emptied it in between
+    uint32_t victim = self;
+    uint32_t most = 0;
+    for (uint32_t w = 0; w < pool->workers; w++)
+    {
+      Share* share = &pool->shares[w];
+      std::lock_guard<std::mutex> guard(share->lock);
+      uint32_t left = share->end - share->next;
+      if (w != self && left > most)
+      {
+        most = left;
+        victim = w;
+      }
+    }
+    if (victim == self)
+      return false;
+
+    Share* share = &pool->shares[victim];
+    std::lock_guard<std::mutex> guard(share->lock);
+    if (share->next < share->end)
+    {
+      *index = --share->end;
+      return true;
+    }
+  }
+}
+
+void run_worker(Pool* pool, uint32_t self)
+{
+  uint32_t index;
+  while (take_own(&pool->shares[self], &index) || steal(pool, self, &index))
+    pool->task(pool->user, index);
+}
+
+}  // namespace
+
+void parallel_for(uint32_t count, uint32_t threads, PoolTask task, void* user)
+{
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+  if (threads > count)
+    threads = count;
+  if (threads <= 1)
+  {
+    for (uint32_t i = 0; i < count; i++)
+      task(user, i);
+    return;
+  }
+
+  std::vector<Share> shares(threads);
+  for (uint32_t w = 0; w < threads; w++)
+  {
+    shares[w].next = static_cast<uint32_t>(uint64_t(count) * w / threads);
+    shares[w].end = static_cast<uint32_t>(uint64_t(count) * (w + 1) / threads);
+  }
+  Pool pool = {shares.data(), threads, task, user};
+
+  std::vector<std::thread> helpers;
+  helpers.reserve(threads - 1);
+  for (uint32_t w = 1; w < threads; w++)
+    helpers.emplace_back(run_worker, &pool, w);
+  run_worker(&pool, 0);
+  for (std::thread& helper : helpers)
+    helper.join();
+}
+
+}  // namespace v4front
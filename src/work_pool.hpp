@@ -0,0 +1,22 @@
+#pragma once
+// Internal work-stealing thread pool for batch compilation.
+//
+//  - parallel_for() runs task(user, i) once for every i in [0, count).
+//  - Every worker starts with its own contiguous share of the indices and
+//    takes them from the front. A worker whose share is empty steals from the
+//    back of the fullest other share, so uneven tasks (one large module among
+//    many small ones) still keep every thread busy.
+//  - The calling thread is worker 0; parallel_for() returns when every task
+//    has finished.
+
+#include <cstdint>
+
+namespace v4front
+{
+
+typedef void (*PoolTask)(void* user, uint32_t index);
+
+// Run count tasks on up to threads threads (0: one per hardware thread)
+void parallel_for(uint32_t count, uint32_t threads, PoolTask task, void* user);
+
+}  // namespace v4front
@@ -0,0 +1,133 @@
+#include "yield.hpp"
+
+#include "op_info.hpp"
+#include "v4/opcodes.hpp"
+
+namespace v4front
+{
+
+namespace
+{
+
+bool yield_op(uint8_t opcode)
+{
+  return opcode == static_cast<uint8_t>(v4::Op::TASK_YIELD) ||
+         opcode == static_cast<uint8_t>(v4::Op::TASK_SLEEP) ||
+         opcode == static_cast<uint8_t>(v4::Op::TASK_RECEIVE_BLOCKING);
+}
+
+// Words of one buffer and which of them are known to yield
+struct Words
+{
+  const V4FrontBuf* buf;
+  bool* yields;
+};
+
+// Operands from word_count up name words outside buf; they are assumed not to
+// yield
+bool word_yields(const void* user, uint32_t operand)
+{
+  const Words* w = static_cast<const Words*>(user);
+  return operand < static_cast<uint32_t>(w->buf->word_count) && w->yields[operand];
+}
+
+// Record the yieldless loops of one unit; false if it does not decode
+bool unit_loops(const uint8_t* code, uint32_t len, int32_t unit, const Words* words,
+                V4FrontLoop* out, uint32_t cap, uint32_t* count)
+{
+  for (uint32_t pc = 0; pc < len;)
+  {
+    bool is_jump;
+    int operand = op_operand_len(code[pc], &is_jump);
+    if (operand < 0 || pc + 1 + operand > len)
+      return false;
+    uint32_t next = pc + 1 + operand;
+    if (is_jump)
+    {
+      int16_t rel = static_cast<int16_t>(code[pc + 1] | (code[pc + 2] << 8));
+      int64_t target = static_cast<int64_t>(next) + rel;
+      bool ok = true;
+      if (target >= 0 && target <= pc &&
+          !range_yields(code, static_cast<uint32_t>(target), next, word_yields, words,
+                        nullptr, &ok))
+      {
+        if (!ok)
+          return false;
+        if (*count < cap)
+          out[*count] = {unit, static_cast<uint32_t>(target), pc};
+        (*count)++;
+      }
+    }
+    pc = next;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool range_yields(const uint8_t* code, uint32_t start, uint32_t end, CallYields yields,
+                  const void* user, uint32_t* insns, bool* ok)
+{
+  uint32_t n = 0;
+  bool found = false;
+  for (uint32_t pc = start; pc < end; n++)
+  {
+    int operand = op_operand_len(code[pc]);
+    if (operand < 0 || pc + 1 + operand > end)
+    {
+      *ok = false;
+      return false;
+    }
+    if (yield_op(code[pc]) ||
+        (code[pc] == static_cast<uint8_t>(v4::Op::CALL) && yields &&
+         yields(user, static_cast<uint32_t>(code[pc + 1] | (code[pc + 2] << 8)))))
+      found = true;
+    pc += 1 + operand;
+  }
+  if (insns)
+    *insns = n;
+  return found;
+}
+
+FrontErr find_yieldless_loops(Arena* arena, const V4FrontBuf* buf, V4FrontLoop* out,
+                              uint32_t cap, uint32_t* count)
+{
+  *count = 0;
+  const int n = buf->word_count;
+  Words words = {buf, static_cast<bool*>(arena->alloc(n > 0 ? n : 1))};
+  if (!words.yields)
+    return FrontErr::OutOfMemory;
+  for (int i = 0; i < n; i++)
+    words.yields[i] = false;
+
+  // Words may call later words (batch output), so repeat until nothing changes
+  for (bool changed = true; changed;)
+  {
+    changed = false;
+    for (int i = 0; i < n; i++)
+    {
+      bool ok = true;
+      if (!words.yields[i] && range_yields(buf->words[i].code, 0, buf->words[i].code_len,
+                                           word_yields, &words, nullptr, &ok))
+      {
+        words.yields[i] = true;
+        changed = true;
+      }
+      if (!ok)
+        return FrontErr::InvalidImage;
+    }
+  }
+
+  if (!unit_loops(buf->data, static_cast<uint32_t>(buf->size), -1, &words, out, cap,
+                  count))
+    return FrontErr::InvalidImage;
+  for (int i = 0; i < n; i++)
+  {
+    if (!unit_loops(buf->words[i].code, buf->words[i].code_len, i, &words, out, cap,
+                    count))
+      return FrontErr::InvalidImage;
+  }
+  return FrontErr::OK;
+}
+
+}  // namespace v4front
@@ -0,0 +1,33 @@
+#pragma once
+// Internal yield-point analysis (v4front_find_yieldless_loops and
+// V4FRONT_OPT_AUTO_YIELD).
+//
+//  - A yield point is an opcode that may switch tasks (TASK_YIELD,
+//    TASK_SLEEP, TASK_RECEIVE_BLOCKING) or a CALL of a word that contains one.
+//  - A loop is a JMP, JZ or JNZ whose target is at or before it, with the
+//    code from the target to the end of the jump as its body.
+
+#include <cstdint>
+
+#include "arena.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+
+namespace v4front
+{
+
+// Whether a CALL with this operand reaches a yield point
+typedef bool (*CallYields)(const void* user, uint32_t operand);
+
+// Whether code[start, end) contains a yield point (yields may be NULL: no call
+// yields). *insns (may be NULL) receives the number of instructions. *ok is
+// set to false if the range does not decode.
+bool range_yields(const uint8_t* code, uint32_t start, uint32_t end, CallYields yields,
+                  const void* user, uint32_t* insns, bool* ok);
+
+// The loops of buf without a yield point, main code first (see
+// v4front_find_yieldless_loops). Scratch memory comes from arena.
+FrontErr find_yieldless_loops(Arena* arena, const V4FrontBuf* buf, V4FrontLoop* out,
+                              uint32_t cap, uint32_t* count);
+
+}  // namespace v4front
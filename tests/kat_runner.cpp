@@ -1,36 +1,48 @@
 #include "kat_runner.hpp"
 
+#include <atomic>
 #include <cctype>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <fstream>
-#include <sstream>
+#include <functional>
+#include <thread>
+
+#include "v4front/compile.h"
 
 namespace v4front
 {
 namespace kat
 {
 
-// Helper: trim whitespace from both ends
-static std::string trim(const std::string& str)
+// Helper: whitespace as in std::isspace
+static bool is_space(char c)
 {
-  size_t start = 0;
-  size_t end = str.length();
+  return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
 
-  while (start < end && std::isspace(static_cast<unsigned char>(str[start])))
-    start++;
-  while (end > start && std::isspace(static_cast<unsigned char>(str[end - 1])))
-    end--;
+// Helper: trim whitespace from both ends of [*begin, *end)
+static void trim(const char** begin, const char** end)
+{
+  while (*begin < *end && is_space(**begin))
+    (*begin)++;
+  while (*end > *begin && is_space((*end)[-1]))
+    (*end)--;
+}
 
-  return str.substr(start, end - start);
+// Helper: check if [begin, end) starts with prefix (case-sensitive)
+static bool starts_with(const char* begin, const char* end, const char* prefix)
+{
+  size_t n = strlen(prefix);
+  return static_cast<size_t>(end - begin) >= n && memcmp(begin, prefix, n) == 0;
 }
 
-// Helper: check if string starts with prefix (case-sensitive)
-static bool starts_with(const std::string& str, const std::string& prefix)
+// Helper: trimmed rest of [begin, end) after a prefix of skip bytes
+static std::string field(const char* begin, const char* end, size_t skip)
 {
-  if (str.length() < prefix.length())
-    return false;
-  return str.compare(0, prefix.length(), prefix) == 0;
+  begin += skip;
+  trim(&begin, &end);
+  return std::string(begin, end - begin);
 }
 
 bool parse_hex_byte(const char* str, uint8_t* out)
@@ -61,113 +73,227 @@ bool parse_hex_byte(const char* str, uint8_t* out)
   return true;
 }
 
-std::vector<uint8_t> parse_hex_bytes(const std::string& hex_str)
+// Parse the tokens of [p, end) as hex bytes into *bytes; false on a bad token
+static bool parse_hex_range(const char* p, const char* end, std::vector<uint8_t>* bytes)
 {
-  std::vector<uint8_t> bytes;
-  std::istringstream iss(hex_str);
-  std::string token;
-
-  while (iss >> token)
+  bytes->clear();
+  for (;;)
   {
+    while (p < end && is_space(*p))
+      p++;
+    if (p == end)
+      return true;
+    const char* token = p;
+    while (p < end && !is_space(*p))
+      p++;
+
     // Skip comments (anything after #)
     if (token[0] == '#')
-      break;
+      return true;
 
     uint8_t byte;
-    if (parse_hex_byte(token.c_str(), &byte))
-    {
-      bytes.push_back(byte);
-    }
-    else
-    {
-      // Invalid hex byte - return empty to signal error
-      return std::vector<uint8_t>();
-    }
+    if (!parse_hex_byte(std::string(token, p - token).c_str(), &byte))
+      return false;  // Invalid hex byte
+    bytes->push_back(byte);
   }
+}
 
+std::vector<uint8_t> parse_hex_bytes(const std::string& hex_str)
+{
+  std::vector<uint8_t> bytes;
+  if (!parse_hex_range(hex_str.data(), hex_str.data() + hex_str.size(), &bytes))
+    bytes.clear();  // Empty signals an error
   return bytes;
 }
 
-std::vector<KatTest> load_kat_file(const char* filename)
+std::vector<KatTest> parse_kat(const char* data, size_t len)
 {
   std::vector<KatTest> tests;
-
-  std::ifstream file(filename);
-  if (!file.is_open())
-  {
-    return tests;  // Empty vector indicates error
-  }
-
-  std::string line;
   KatTest current_test;
   bool in_test = false;
 
-  while (std::getline(file, line))
+  const char* end = data + len;
+  for (const char* p = data; p < end;)
   {
-    line = trim(line);
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!eol)
+      eol = end;
+    const char* line = p;
+    const char* line_end = eol;
+    p = eol + (eol < end);
+    trim(&line, &line_end);
 
     // Skip empty lines
-    if (line.empty())
-      continue;
-
-    // Skip comment lines (but not test headers)
-    if (starts_with(line, "#") && !starts_with(line, "## Test:"))
+    if (line == line_end)
       continue;
 
     // Test header
-    if (starts_with(line, "## Test:"))
+    if (starts_with(line, line_end, "## Test:"))
     {
       // Save previous test if exists
       if (in_test && !current_test.name.empty())
-      {
-        tests.push_back(current_test);
-      }
+        tests.push_back(std::move(current_test));
 
       // Start new test
       current_test = KatTest();
-      current_test.name = trim(line.substr(8));  // Skip "## Test:"
+      current_test.name = field(line, line_end, 8);  // Skip "## Test:"
       in_test = true;
       continue;
     }
 
+    // Skip comment lines
+    if (line[0] == '#')
+      continue;
+
     // SOURCE line
-    if (starts_with(line, "SOURCE:"))
+    if (starts_with(line, line_end, "SOURCE:"))
     {
       if (!in_test)
         continue;  // SOURCE without test header - skip
 
-      current_test.source = trim(line.substr(7));  // Skip "SOURCE:"
+      current_test.source = field(line, line_end, 7);  // Skip "SOURCE:"
       continue;
     }
 
     // BYTECODE line
-    if (starts_with(line, "BYTECODE:"))
+    if (starts_with(line, line_end, "BYTECODE:"))
     {
       if (!in_test)
         continue;  // BYTECODE without test header - skip
 
-      std::string hex_str = trim(line.substr(9));  // Skip "BYTECODE:"
-      current_test.expected_bytes = parse_hex_bytes(hex_str);
-
-      if (current_test.expected_bytes.empty() && !hex_str.empty())
+      const char* hex = line + 9;  // Skip "BYTECODE:"
+      trim(&hex, &line_end);
+      if (!parse_hex_range(hex, line_end, &current_test.expected_bytes) ||
+          (current_test.expected_bytes.empty() && hex != line_end))
       {
         // Parse error - skip this test
         in_test = false;
         current_test = KatTest();
       }
-
       continue;
     }
   }
 
   // Save last test if exists
   if (in_test && !current_test.name.empty())
+    tests.push_back(std::move(current_test));
+
+  return tests;
+}
+
+std::vector<KatTest> load_kat_file(const char* filename)
+{
+  // Read the whole file at once and parse it in place
+  FILE* fp = fopen(filename, "rb");
+  if (!fp)
+    return std::vector<KatTest>();  // Empty vector indicates error
+
+  std::vector<char> data;
+  char chunk[16384];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+    data.insert(data.end(), chunk, chunk + n);
+  fclose(fp);
+  return parse_kat(data.data(), data.size());
+}
+
+bool check_kat_test(const KatTest& test, uint32_t opt_level, std::string* reason)
+{
+  V4FrontCompileOptions options = {};
+  options.opt_level = opt_level;
+  V4FrontBuf buf;
+  V4FrontError error;
+  char msg[320];
+  if (v4front_compile_with_options(nullptr, test.source.c_str(), &options, &buf,
+                                   &error) != 0)
   {
-    tests.push_back(current_test);
+    snprintf(msg, sizeof(msg), "compilation failed: %s", error.message);
+  }
+  else
+  {
+    msg[0] = '\0';
+    if (buf.size != test.expected_bytes.size())
+    {
+      snprintf(msg, sizeof(msg), "bytecode size mismatch: expected %zu bytes, got %zu",
+               test.expected_bytes.size(), buf.size);
+    }
+    else
+    {
+      for (size_t i = 0; i < buf.size; i++)
+      {
+        if (buf.data[i] != test.expected_bytes[i])
+        {
+          snprintf(msg, sizeof(msg), "byte %zu: expected 0x%02X, got 0x%02X", i,
+                   test.expected_bytes[i], buf.data[i]);
+          break;
+        }
+      }
+    }
+    v4front_free(&buf);
   }
+  if (reason)
+    *reason = msg;
+  return msg[0] == '\0';
+}
 
-  file.close();
-  return tests;
+bool run_kat_batch(const std::vector<std::string>& files, unsigned threads,
+                   uint32_t opt_level, KatBatchResult* out)
+{
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+
+  // Run job(i) for every i below count, handing out indices as workers free up
+  auto shard = [threads](size_t count, const std::function<void(size_t)>& job) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+      for (size_t i; (i = next.fetch_add(1)) < count;)
+        job(i);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads && t < count; t++)
+      pool.emplace_back(worker);
+    worker();
+    for (std::thread& th : pool)
+      th.join();
+  };
+
+  std::vector<std::vector<KatTest>> loaded(files.size());
+  shard(files.size(), [&](size_t i) { loaded[i] = load_kat_file(files[i].c_str()); });
+
+  // Cases in file order, so failures come out in a stable order
+  struct Case
+  {
+    size_t file;
+    const KatTest* test;
+  };
+  std::vector<Case> cases;
+  for (size_t f = 0; f < files.size(); f++)
+  {
+    for (const KatTest& test : loaded[f])
+      cases.push_back(Case{f, &test});
+  }
+  std::vector<std::string> reasons(cases.size());
+  std::vector<uint8_t> passed(cases.size());
+  shard(cases.size(), [&](size_t i) {
+    passed[i] = check_kat_test(*cases[i].test, opt_level, &reasons[i]);
+  });
+
+  out->cases = cases.size();
+  out->failures.clear();
+  for (size_t f = 0; f < files.size(); f++)
+  {
+    if (loaded[f].empty())
+      out->failures.push_back(KatFailure{files[f], "", "cannot load file"});
+  }
+  for (size_t i = 0; i < cases.size(); i++)
+  {
+    if (!passed[i])
+      out->failures.push_back(
+          KatFailure{files[cases[i].file], cases[i].test->name, reasons[i]});
+  }
+  return out->failures.empty();
 }
 
 }  // namespace kat
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -21,6 +22,34 @@ struct KatTest
 // Returns empty vector on parse error
 std::vector<KatTest> load_kat_file(const char* filename);
 
+// Parse the KAT text at data[0, len) (the contents of a KAT file)
+std::vector<KatTest> parse_kat(const char* data, size_t len);
+
+// Compile test.source at opt_level and compare with test.expected_bytes
+// Returns true on a match; otherwise *reason (may be NULL) says what differs
+bool check_kat_test(const KatTest& test, uint32_t opt_level, std::string* reason);
+
+// One failed case of a batch
+struct KatFailure
+{
+  std::string file;    // KAT file the case came from
+  std::string name;    // Test name ("" if the file itself could not be loaded)
+  std::string reason;  // What went wrong
+};
+
+// Outcome of run_kat_batch
+struct KatBatchResult
+{
+  size_t cases = 0;                  // Cases run
+  std::vector<KatFailure> failures;  // In file order, then case order
+};
+
+// Load files and run every case on threads workers (0: one per hardware
+// thread). Files are sharded across the workers for loading, then cases for
+// compiling. Returns true if every file loaded and every case passed.
+bool run_kat_batch(const std::vector<std::string>& files, unsigned threads,
+                   uint32_t opt_level, KatBatchResult* out);
+
 // Parse a single hex byte string (e.g., "FF" -> 0xFF)
 // Returns true on success, false on parse error
 bool parse_hex_byte(const char* str, uint8_t* out);
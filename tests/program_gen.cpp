@@ -0,0 +1,351 @@
+#include "program_gen.hpp"
+
+#include <random>
+#include <vector>
+
+namespace v4front
+{
+namespace gen
+{
+
+namespace
+{
+
+constexpr int kMaxNest = 4;   // Deepest IF/DO/BEGIN nesting
+constexpr int kMaxWords = 4;  // Most words defined per program
+
+const char* const kBinary[] = {"+", "-",  "*", "AND", "OR", "XOR", "=",   "<>",
+                               "<", ">",  "<=", ">=", "U<", "MIN", "MAX"};
+const char* const kUnary[] = {"INVERT", "NEGATE", "1+", "1-", "0=", "ABS"};
+const char* const kShift[] = {"LSHIFT", "RSHIFT", "ARSHIFT"};
+const char* const kDivide[] = {"/", "MOD"};
+const char* const kLoopIndex[] = {"I", "J", "K"};
+const char* const kMix[] = {"+", "-", "XOR"};  // Keep what both cells held
+const int32_t kEdgeValues[] = {INT32_MIN, INT32_MAX, -1,    65535,
+                               65536,     -32768,    32767, 255};
+
+template <typename T, size_t N>
+constexpr int count_of(const T (&)[N])
+{
+  return static_cast<int>(N);
+}
+
+struct WordSig
+{
+  std::string name;
+  int in;   // Cells taken
+  int out;  // Cells left
+};
+
+// Where code is being generated
+struct Scope
+{
+  int floor;     // Cells below are not touched (the counter of a BEGIN loop)
+  int nest;      // Enclosing IF, DO and BEGIN
+  int loops;     // Enclosing DO loops, for I, J and K
+  int leave_at;  // Depth LEAVE may exit the innermost DO at, or -1
+  bool locals;   // Local 0 holds a value (words only)
+};
+
+class Generator
+{
+ public:
+  explicit Generator(uint32_t seed) : rng_(seed) {}
+
+  std::string run()
+  {
+    int word_count = pick(kMaxWords + 1);
+    for (int w = 0; w < word_count; w++)
+    {
+      WordSig sig = {"W" + std::to_string(w), pick(3), pick(3)};
+      put(":");
+      put(sig.name);
+      Scope scope = {0, 0, 0, -1, pick(3) != 0};
+      if (scope.locals)
+      {
+        random_literal();
+        put("L! 0");
+      }
+      int depth = sig.in;
+      block(&depth, sig.out, 3 + pick(6), scope);
+      put(";");
+      words_.push_back(sig);
+    }
+    int depth = 0;
+    block(&depth, pick(kMaxDepth / 2 + 1), 10 + pick(20), {0, 0, 0, -1, false});
+    return out_;
+  }
+
+ private:
+  int pick(int n) { return static_cast<int>(rng_() % static_cast<uint32_t>(n)); }
+
+  void put(const std::string& token)
+  {
+    if (!out_.empty())
+      out_ += ' ';
+    out_ += token;
+  }
+
+  void literal(int32_t v) { put(std::to_string(v)); }
+
+  void random_literal()
+  {
+    int kind = pick(10);
+    if (kind < 6)
+      literal(pick(10));
+    else if (kind < 9)
+      literal(pick(201) - 100);
+    else
+      literal(kEdgeValues[pick(count_of(kEdgeValues))]);
+  }
+
+  // Emit about budget operations at *depth, then settle the depth at target
+  void block(int* depth, int target, int budget, const Scope& scope)
+  {
+    for (int i = 0; i < budget; i++)
+      op(depth, scope);
+    // Mostly fold the extra cells into the result, so wrong values show
+    while (*depth > target)
+    {
+      put(*depth - scope.floor >= 2 && pick(4) ? kMix[pick(count_of(kMix))] : "DROP");
+      (*depth)--;
+    }
+    while (*depth < target)
+    {
+      random_literal();
+      (*depth)++;
+    }
+  }
+
+  // Scope of a nested IF, DO or BEGIN body
+  static Scope inner(const Scope& scope)
+  {
+    Scope s = scope;
+    s.nest++;
+    return s;
+  }
+
+  void op(int* depth, const Scope& scope)
+  {
+    const int d = *depth - scope.floor;  // Cells this code may use
+    const bool room = *depth < kMaxDepth;
+    const bool can_nest = scope.nest < kMaxNest;
+    switch (pick(17))
+    {
+      case 0:
+      case 1:
+        if (room)
+        {
+          random_literal();
+          (*depth)++;
+        }
+        return;
+      case 2:
+      case 3:
+        if (d >= 2)
+        {
+          put(kBinary[pick(count_of(kBinary))]);
+          (*depth)--;
+        }
+        return;
+      case 4:
+        if (d >= 1)
+          put(kUnary[pick(count_of(kUnary))]);
+        return;
+      case 5:
+        // Divisors are positive and shift amounts below 32: defined results
+        if (d >= 1 && room)
+        {
+          if (pick(2))
+          {
+            literal(1 + pick(50));
+            put(kDivide[pick(count_of(kDivide))]);
+          }
+          else
+          {
+            literal(pick(32));
+            put(kShift[pick(count_of(kShift))]);
+          }
+        }
+        return;
+      case 6:
+        stack_op(depth, d);
+        return;
+      case 7:
+        if (d >= 1 && can_nest)
+        {
+          // Both branches leave the same depth (without ELSE, the depth
+          // the flag was taken at)
+          put("IF");
+          (*depth)--;
+          bool has_else = pick(2) != 0;
+          int target = *depth;
+          if (has_else)
+            target += pick(3) - 1;
+          if (target < scope.floor || target > kMaxDepth)
+            target = *depth;
+          int then_depth = *depth;
+          block(&then_depth, target, 1 + pick(4), inner(scope));
+          if (has_else)
+          {
+            put("ELSE");
+            block(depth, target, 1 + pick(4), inner(scope));
+          }
+          put("THEN");
+        }
+        return;
+      case 8:
+      case 9:
+        // limit 0 DO ... LOOP, or ... step +LOOP with a positive step
+        if (*depth + 2 <= kMaxDepth && can_nest)
+        {
+          const int start = *depth;
+          literal(pick(5));
+          literal(0);
+          put("DO");
+          Scope body = inner(scope);
+          body.loops++;
+          body.leave_at = start;
+          block(depth, start, 1 + pick(4), body);
+          if (pick(3) == 0)
+          {
+            literal(1 + pick(3));
+            put("+LOOP");
+          }
+          else
+          {
+            put("LOOP");
+          }
+        }
+        return;
+      case 10:
+      case 11:
+        if (scope.loops > 0 && room)
+        {
+          int levels = scope.loops < 3 ? scope.loops : 3;
+          put(kLoopIndex[pick(levels)]);
+          (*depth)++;
+          if (d >= 1 && pick(2))
+          {
+            put(kMix[pick(count_of(kMix))]);
+            (*depth)--;
+          }
+        }
+        return;
+      case 12:
+        // n BEGIN ... 1- DUP 0= UNTIL DROP: the body runs n times and never
+        // reaches the counter
+        if (*depth + 3 <= kMaxDepth && can_nest)
+        {
+          literal(1 + pick(4));
+          put("BEGIN");
+          (*depth)++;
+          Scope body = inner(scope);
+          body.floor = *depth;
+          body.leave_at = -1;  // LEAVE would skip the counter's DROP
+          block(depth, *depth, 1 + pick(4), body);
+          put("1- DUP 0= UNTIL DROP");
+          (*depth)--;
+        }
+        return;
+      case 13:
+        // LEAVE at the depth of its DO, on a condition of the index
+        if (scope.leave_at == *depth && *depth + 2 <= kMaxDepth)
+        {
+          put("I");
+          literal(pick(4));
+          put(pick(2) ? "=" : ">");
+          put("IF LEAVE THEN");
+        }
+        return;
+      case 14:
+        if (scope.locals)
+        {
+          if (room && pick(2))
+          {
+            put("L@ 0");
+            (*depth)++;
+          }
+          else if (d >= 1)
+          {
+            put("L! 0");
+            (*depth)--;
+          }
+        }
+        return;
+      default:
+        call(depth, d);
+        return;
+    }
+  }
+
+  // d: cells above the scope's floor
+  void stack_op(int* depth, int d)
+  {
+    switch (pick(6))
+    {
+      case 0:
+        if (d >= 1 && *depth < kMaxDepth)
+        {
+          put("DUP");
+          (*depth)++;
+        }
+        break;
+      case 1:
+        if (d >= 1)
+        {
+          put("DROP");
+          (*depth)--;
+        }
+        break;
+      case 2:
+        if (d >= 2)
+          put("SWAP");
+        break;
+      case 3:
+        if (d >= 2 && *depth < kMaxDepth)
+        {
+          put("OVER");
+          (*depth)++;
+        }
+        break;
+      case 4:
+        if (d >= 3)
+          put("ROT");
+        break;
+      default:
+        if (d >= 2)
+        {
+          put("NIP");
+          (*depth)--;
+        }
+        break;
+    }
+  }
+
+  void call(int* depth, int d)
+  {
+    if (words_.empty())
+      return;
+    const WordSig& w = words_[pick(static_cast<int>(words_.size()))];
+    if (d >= w.in && *depth - w.in + w.out <= kMaxDepth)
+    {
+      put(w.name);
+      *depth += w.out - w.in;
+    }
+  }
+
+  std::mt19937 rng_;
+  std::string out_;
+  std::vector<WordSig> words_;
+};
+
+}  // namespace
+
+std::string random_program(uint32_t seed)
+{
+  return Generator(seed).run();
+}
+
+}  // namespace gen
+}  // namespace v4front
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace v4front
+{
+namespace gen
+{
+
+// Random well-formed program for differential testing, the same for the same
+// seed on every platform. It defines a few words and runs them from main code:
+//  - only stack, arithmetic, comparison and shift words, IF/ELSE/THEN, calls
+//    of earlier words, local 0 in words (stored before it is read), and
+//    loops: DO ... LOOP and +LOOP nested up to three deep with I, J, K and
+//    conditional LEAVE, and BEGIN ... UNTIL (no SYS, memory or tasks)
+//  - the data stack never underflows and stays at most kMaxDepth deep
+//  - every / and MOD divides by a positive literal, every shift amount is a
+//    literal below 32, every DO has literal bounds and a positive step, and
+//    every BEGIN loop counts a literal down to zero, so the program always
+//    terminates with a defined result
+std::string random_program(uint32_t seed);
+
+constexpr int kMaxDepth = 8;
+
+}  // namespace gen
+}  // namespace v4front
@@ -0,0 +1,131 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdlib>
+#include <cstring>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+// Counting wrapper around malloc/free
+struct CountingHeap
+{
+  int allocs;
+  int frees;
+};
+
+static void* counting_alloc(void* user, size_t size)
+{
+  static_cast<CountingHeap*>(user)->allocs++;
+  return malloc(size);
+}
+
+static void counting_free(void* user, void* ptr)
+{
+  static_cast<CountingHeap*>(user)->frees++;
+  free(ptr);
+}
+
+// Fixed static pool with no free (reclaimed wholesale by resetting `used`)
+struct StaticPool
+{
+  alignas(16) uint8_t bytes[16 * 1024];
+  size_t used;
+};
+
+static void* pool_alloc(void* user, size_t size)
+{
+  StaticPool* pool = static_cast<StaticPool*>(user);
+  size_t aligned = (size + 15) & ~static_cast<size_t>(15);
+  if (pool->used + aligned > sizeof(pool->bytes))
+    return nullptr;
+  void* p = pool->bytes + pool->used;
+  pool->used += aligned;
+  return p;
+}
+
+static const char* kProgram = ": SQUARE DUP * ; : CUBE DUP SQUARE * ; 3 CUBE";
+
+TEST_CASE("Allocator hook: counting heap")
+{
+  CountingHeap heap = {0, 0};
+  V4FrontAllocator allocator = {counting_alloc, counting_free, &heap};
+  V4FrontBuf buf;
+
+  SUBCASE("Scratch is returned before compile returns; output is one block")
+  {
+    v4front_err err =
+        v4front_compile_with_allocator(nullptr, kProgram, &allocator, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    REQUIRE(buf.word_count == 2);
+    CHECK(strcmp(buf.words[0].name, "SQUARE") == 0);
+    CHECK(strcmp(buf.words[1].name, "CUBE") == 0);
+    CHECK(buf.words[0].code[0] == static_cast<uint8_t>(Op::DUP));
+
+    // Only the output block is still live
+    CHECK(heap.allocs - heap.frees == 1);
+
+    v4front_free(&buf);
+    CHECK(heap.allocs == heap.frees);
+    CHECK(buf.block == nullptr);
+    CHECK(buf.words == nullptr);
+    CHECK(buf.data == nullptr);
+  }
+
+  SUBCASE("Errors release everything")
+  {
+    v4front_err err =
+        v4front_compile_with_allocator(nullptr, ": BAD 1 2", &allocator, &buf, nullptr);
+    CHECK(err == FrontErr::UnclosedColon);
+    CHECK(heap.allocs == heap.frees);
+  }
+}
+
+TEST_CASE("Allocator hook: static pool without free")
+{
+  static StaticPool pool;
+  pool.used = 0;
+  V4FrontAllocator allocator = {pool_alloc, nullptr, &pool};
+  V4FrontBuf buf;
+
+  SUBCASE("Compiles into the pool")
+  {
+    v4front_err err =
+        v4front_compile_with_allocator(nullptr, kProgram, &allocator, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(reinterpret_cast<uint8_t*>(buf.block) >= pool.bytes);
+    CHECK(reinterpret_cast<uint8_t*>(buf.block) < pool.bytes + sizeof(pool.bytes));
+    v4front_free(&buf);  // No-op for the pool, clears the buffer
+    CHECK(buf.data == nullptr);
+  }
+
+  SUBCASE("Pool exhaustion reports OutOfMemory")
+  {
+    pool.used = sizeof(pool.bytes) - 64;
+    v4front_err err =
+        v4front_compile_with_allocator(nullptr, kProgram, &allocator, &buf, nullptr);
+    CHECK(err == FrontErr::OutOfMemory);
+  }
+}
+
+TEST_CASE("Default compile output is a single block")
+{
+  V4FrontBuf buf;
+  char errmsg[256];
+
+  v4front_err err = v4front_compile(kProgram, &buf, errmsg, sizeof(errmsg));
+  REQUIRE(err == FrontErr::OK);
+  CHECK(buf.block != nullptr);
+
+  // Main code, word code and names all live inside the block
+  uint8_t* block = static_cast<uint8_t*>(buf.block);
+  CHECK(buf.data > block);
+  CHECK(reinterpret_cast<uint8_t*>(buf.words[1].name) > buf.words[1].code);
+
+  v4front_free(&buf);
+  v4front_free(&buf);  // Double free is a no-op
+}
@@ -0,0 +1,222 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void compile_opt(const char* source, uint32_t flags, V4FrontBuf* buf,
+                        uint32_t yield_budget = 0, V4FrontContext* ctx = nullptr)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  options.yield_budget = yield_budget;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(ctx, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<V4FrontLoop> loops_of(const V4FrontBuf& buf)
+{
+  uint32_t count = 0;
+  v4front_err err = v4front_find_yieldless_loops(&buf, nullptr, 0, &count);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<V4FrontLoop> loops(count);
+  uint32_t again = 0;
+  err = v4front_find_yieldless_loops(&buf, loops.data(), count, &again);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(again == count);
+  return loops;
+}
+
+static size_t count_op(const V4FrontBuf& buf, Op o)
+{
+  size_t n = 0;
+  for (size_t i = 0; i < buf.size; i++)
+    n += buf.data[i] == op(o);
+  return n;
+}
+
+TEST_CASE("Yieldless loops: analysis")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Loops of main code and words, inner first")
+  {
+    compile_opt(": W BEGIN DUP WHILE 1 - REPEAT ; BEGIN BEGIN 1 UNTIL 0 UNTIL", 0, &buf);
+    std::vector<V4FrontLoop> loops = loops_of(buf);
+    REQUIRE(loops.size() == 3);
+    CHECK(loops[0].unit == -1);
+    CHECK(loops[1].unit == -1);
+    CHECK(loops[0].start == loops[1].start);  // Both BEGINs are at offset 0
+    CHECK(loops[0].end < loops[1].end);
+    CHECK(buf.data[loops[1].end] == op(Op::JZ));
+    CHECK(loops[2].unit == 0);
+    CHECK(loops[2].start == 0);
+    CHECK(buf.words[0].code[loops[2].end] == op(Op::JMP));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Yield points, also through calls")
+  {
+    compile_opt("BEGIN YIELD AGAIN BEGIN 10 MS AGAIN BEGIN RECEIVE-BLOCKING AGAIN", 0,
+                &buf);
+    CHECK(loops_of(buf).empty());
+    v4front_free(&buf);
+    compile_opt(": P PAUSE ; : Q 1 DROP P ; BEGIN Q AGAIN", 0, &buf);
+    CHECK(loops_of(buf).empty());
+    v4front_free(&buf);
+    compile_opt(": R 1 DROP ; BEGIN R AGAIN", 0, &buf);
+    CHECK(loops_of(buf).size() == 1);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("DO loops count too; cap limits what is written")
+  {
+    compile_opt("10 0 DO LOOP 5 0 DO LOOP", 0, &buf);
+    V4FrontLoop one[1];
+    uint32_t count = 0;
+    v4front_err err = v4front_find_yieldless_loops(&buf, one, 1, &count);
+    CHECK(err == FrontErr::OK);
+    CHECK(count == 2);
+    CHECK(one[0].unit == -1);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Bad arguments")
+  {
+    compile_opt("1", 0, &buf);
+    uint32_t count;
+    v4front_err err = v4front_find_yieldless_loops(nullptr, nullptr, 0, &count);
+    CHECK(err == FrontErr::BufferTooSmall);
+    err = v4front_find_yieldless_loops(&buf, nullptr, 1, &count);
+    CHECK(err == FrontErr::BufferTooSmall);
+    err = v4front_find_yieldless_loops(&buf, nullptr, 0, nullptr);
+    CHECK(err == FrontErr::BufferTooSmall);
+    uint8_t bad[] = {0xFF, op(Op::RET)};
+    V4FrontBuf raw = buf;
+    raw.data = bad;
+    raw.size = sizeof(bad);
+    err = v4front_find_yieldless_loops(&raw, nullptr, 0, &count);
+    CHECK(err == FrontErr::InvalidImage);
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Auto yield: every BEGIN loop gets a yield point")
+{
+  const uint32_t flags = V4FRONT_OPT_AUTO_YIELD;
+  V4FrontBuf buf;
+
+  SUBCASE("Bodies of at least the budget yield on every iteration")
+  {
+    compile_opt("BEGIN 1 AGAIN", flags, &buf, 1);
+    CHECK(std::vector<uint8_t>(buf.data, buf.data + buf.size) ==
+          std::vector<uint8_t>{op(Op::LIT), 1, 0, 0, 0, op(Op::TASK_YIELD), op(Op::JMP),
+                               0xF7, 0xFF});
+    CHECK(loops_of(buf).empty());
+    v4front_free(&buf);
+
+    // UNTIL keeps its flag below the yield; WHILE ... REPEAT yields before JMP
+    compile_opt("BEGIN 1 UNTIL BEGIN 1 WHILE REPEAT", flags, &buf, 1);
+    CHECK(count_op(buf, Op::TASK_YIELD) == 2);
+    CHECK(buf.data[5] == op(Op::TASK_YIELD));
+    CHECK(buf.data[6] == op(Op::JZ));
+    CHECK(loops_of(buf).empty());
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Short bodies count their instructions in a data-space cell")
+  {
+    compile_opt("BEGIN 1 DROP AGAIN VARIABLE X X", flags, &buf);
+    CHECK(count_op(buf, Op::TASK_YIELD) == 1);
+    CHECK(count_op(buf, Op::LTU) == 1);
+    CHECK(loops_of(buf).empty());
+    // The counter took the first cell
+    REQUIRE(buf.word_count == 1);
+    CHECK(buf.words[0].code[1] == 0x04);
+    CHECK(buf.words[0].code[2] == 0x00);
+    CHECK(buf.words[0].code[3] == 0x01);
+    v4front_free(&buf);
+
+    // Jump threading keeps every back-edge behind the yield
+    compile_opt("BEGIN DUP WHILE 1 - REPEAT BEGIN 1 DROP AGAIN", flags | V4FRONT_O2_FLAGS,
+                &buf);
+    CHECK(count_op(buf, Op::TASK_YIELD) == 2);
+    CHECK(loops_of(buf).empty());
+    v4front_free(&buf);
+
+    // Loops share one counter
+    compile_opt("BEGIN 1 UNTIL BEGIN 0 UNTIL VARIABLE X", flags, &buf);
+    CHECK(count_op(buf, Op::TASK_YIELD) == 2);
+    REQUIRE(buf.word_count == 1);
+    CHECK(buf.words[0].code[1] == 0x04);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Loops with a yield point and DO loops are left alone")
+  {
+    const char* sources[] = {"BEGIN PAUSE AGAIN", ": P YIELD ; BEGIN P 1 UNTIL",
+                             "10 0 DO LOOP", "BEGIN 1 SLEEP DUP WHILE REPEAT"};
+    for (const char* source : sources)
+    {
+      INFO(source);
+      V4FrontBuf plain;
+      compile_opt(source, 0, &plain);
+      compile_opt(source, flags, &buf);
+      CHECK(std::vector<uint8_t>(buf.data, buf.data + buf.size) ==
+            std::vector<uint8_t>(plain.data, plain.data + plain.size));
+      v4front_free(&plain);
+      v4front_free(&buf);
+    }
+  }
+
+  SUBCASE("The counter cell is allocated in the context's data space")
+  {
+    V4FrontContext* ctx = v4front_context_create();
+    REQUIRE(ctx != nullptr);
+    compile_opt("BEGIN 1 UNTIL", flags, &buf, 0, ctx);
+    CHECK(v4front_context_get_here(ctx) == 0x10004);
+    v4front_free(&buf);
+    compile_opt("BEGIN 1 UNTIL", flags, &buf, 1, ctx);
+    CHECK(v4front_context_get_here(ctx) == 0x10004);  // No counter needed
+    v4front_free(&buf);
+    v4front_context_destroy(ctx);
+  }
+}
+
+TEST_CASE("Auto yield: batch modules share the counter")
+{
+  const char* sources[] = {"BEGIN 1 UNTIL", "VARIABLE X : F BEGIN X @ UNTIL ;"};
+  V4FrontModule modules[2] = {{sources[0], strlen(sources[0])},
+                              {sources[1], strlen(sources[1])}};
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_AUTO_YIELD;
+  V4FrontBuf batch;
+  v4front_err err =
+      v4front_compile_batch(nullptr, modules, 2, &options, 2, &batch, nullptr, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  V4FrontBuf whole;
+  compile_opt("BEGIN 1 UNTIL\nVARIABLE X : F BEGIN X @ UNTIL ;", options.flags, &whole);
+  CHECK(std::vector<uint8_t>(batch.data, batch.data + batch.size) ==
+        std::vector<uint8_t>(whole.data, whole.data + whole.size));
+  REQUIRE(batch.word_count == 2);
+  CHECK(std::vector<uint8_t>(batch.words[1].code,
+                             batch.words[1].code + batch.words[1].code_len) ==
+        std::vector<uint8_t>(whole.words[1].code,
+                             whole.words[1].code + whole.words[1].code_len));
+  CHECK(loops_of(batch).empty());
+  v4front_free(&batch);
+  v4front_free(&whole);
+}
@@ -0,0 +1,295 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+static std::vector<V4FrontModule> modules_of(const std::vector<std::string>& sources)
+{
+  std::vector<V4FrontModule> modules;
+  for (const std::string& source : sources)
+    modules.push_back({source.data(), source.size()});
+  return modules;
+}
+
+static std::vector<uint8_t> batch(const std::vector<std::string>& sources,
+                                  const V4FrontCompileOptions* options = nullptr,
+                                  uint32_t threads = 4,
+                                  const V4FrontContext* ctx = nullptr)
+{
+  std::vector<V4FrontModule> modules = modules_of(sources);
+  V4FrontBuf buf;
+  V4FrontError error;
+  uint32_t module;
+  v4front_err err =
+      v4front_compile_batch(ctx, modules.data(), static_cast<uint32_t>(modules.size()),
+                            options, threads, &buf, &error, &module);
+  REQUIRE_MESSAGE(err == FrontErr::OK, error.message);
+  std::vector<uint8_t> out = flatten(buf);
+  v4front_free(&buf);
+  return out;
+}
+
+static std::vector<uint8_t> whole(const std::string& source,
+                                  const V4FrontCompileOptions* options = nullptr)
+{
+  V4FrontBuf buf;
+  v4front_err err =
+      v4front_compile_with_options(nullptr, source.c_str(), options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> out = flatten(buf);
+  v4front_free(&buf);
+  return out;
+}
+
+// Only colon words are used across modules: CONSTANT and VARIABLE values of
+// another module are called instead of being compiled as literals
+static const std::vector<std::string> kModules = {
+    "VARIABLE COUNTER\n: SQUARE DUP * ;\n: BUMP COUNTER @ 1+ COUNTER ! ;\n3 SQUARE DROP",
+    "10 CONSTANT TEN\n: TENS TEN * ;\nBUMP 2 TENS DROP",
+    "VARIABLE TOTAL\n: SUM 0 SWAP 0 DO I SQUARE + LOOP ;\n5 SUM TOTAL ! 1 IF BUMP THEN",
+    "",
+    ": LAST SUM ; 4 LAST DROP",
+};
+
+static std::string concatenated(const std::vector<std::string>& sources)
+{
+  std::string all;
+  for (const std::string& source : sources)
+    all += source + "\n";
+  return all;
+}
+
+TEST_CASE("Batch: links like one source compiled in module order")
+{
+  SUBCASE("Default options")
+  {
+    CHECK(batch(kModules) == whole(concatenated(kModules)));
+  }
+
+  SUBCASE("Optimizations run on each module")
+  {
+    // Every optimization that stays within a unit
+    V4FrontCompileOptions options = {};
+    options.flags = V4FRONT_OPT_PEEPHOLE | V4FRONT_OPT_COMPACT_LITERALS |
+                    V4FRONT_OPT_CONSTANT_FOLD | V4FRONT_OPT_TAIL_CALLS |
+                    V4FRONT_OPT_LOOP_LOCALS | V4FRONT_OPT_COUNTED_LOOPS;
+    CHECK(batch(kModules, &options) == whole(concatenated(kModules), &options));
+  }
+
+  SUBCASE("Every thread count gives the same output")
+  {
+    std::vector<std::string> many;
+    for (int i = 0; i < 64; i++)
+    {
+      std::string n = std::to_string(i);
+      many.push_back(": W" + n + " " + n + " + ;\nVARIABLE V" + n + "\n" + n + " W" + n +
+                     " V" + n + " !");
+    }
+    std::vector<uint8_t> expected = whole(concatenated(many));
+    for (uint32_t threads : {1u, 2u, 3u, 8u, 0u})
+    {
+      CAPTURE(threads);
+      CHECK(batch(many, nullptr, threads) == expected);
+    }
+  }
+
+  SUBCASE("No modules")
+  {
+    CHECK(batch({}) == whole(""));
+  }
+}
+
+TEST_CASE("Batch: modules call each other in any order")
+{
+  V4FrontBuf buf;
+  std::vector<std::string> sources = {": A B 1 + ; A", ": C 3 ;", ": B C C * ;"};
+  std::vector<V4FrontModule> modules = modules_of(sources);
+  v4front_err err = v4front_compile_batch(nullptr, modules.data(), 3, nullptr, 2, &buf,
+                                          nullptr, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  REQUIRE(buf.word_count == 3);
+  CHECK(strcmp(buf.words[0].name, "A") == 0);
+  CHECK(strcmp(buf.words[1].name, "C") == 0);
+  CHECK(strcmp(buf.words[2].name, "B") == 0);
+
+  // A calls B (index 2); B calls C (index 1) twice
+  std::vector<uint8_t> a(buf.words[0].code, buf.words[0].code + buf.words[0].code_len);
+  CHECK(a == std::vector<uint8_t>{op(Op::CALL), 2, 0, op(Op::LIT), 1, 0, 0, 0,
+                                  op(Op::ADD), op(Op::RET)});
+  std::vector<uint8_t> b(buf.words[2].code, buf.words[2].code + buf.words[2].code_len);
+  CHECK(b == std::vector<uint8_t>{op(Op::CALL), 1, 0, op(Op::CALL), 1, 0, op(Op::MUL),
+                                  op(Op::RET)});
+  std::vector<uint8_t> main_code(buf.data, buf.data + buf.size);
+  CHECK(main_code == std::vector<uint8_t>{op(Op::CALL), 0, 0, op(Op::RET)});
+  v4front_free(&buf);
+}
+
+TEST_CASE("Batch: main code of every module runs")
+{
+  // Jump threading turns the JMP over ELSE into a RET; linking must not let
+  // it end the merged main code early
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_JUMP_THREAD;
+  V4FrontBuf buf;
+  std::vector<std::string> sources = {"1 IF 2 ELSE 3 THEN", "4"};
+  std::vector<V4FrontModule> modules = modules_of(sources);
+  v4front_err err = v4front_compile_batch(nullptr, modules.data(), 2, &options, 1, &buf,
+                                          nullptr, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> expected = {
+      op(Op::LIT), 1, 0, 0, 0,  // 0
+      op(Op::JZ),  8, 0,        // 5: IF (-> 16)
+      op(Op::LIT), 2, 0, 0, 0,  // 8
+      op(Op::JMP), 5, 0,        // 13: was RET (-> 21)
+      op(Op::LIT), 3, 0, 0, 0,  // 16
+      op(Op::LIT), 4, 0, 0, 0,  // 21: second module
+      op(Op::RET),
+  };
+  CHECK(std::vector<uint8_t>(buf.data, buf.data + buf.size) == expected);
+  v4front_free(&buf);
+}
+
+TEST_CASE("Batch: context words and deferred passes")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 40);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_context_register_word(ctx, "SHADOWED", 41);
+  REQUIRE(err == FrontErr::OK);
+  V4FrontContext* snap = v4front_context_snapshot(ctx);
+  REQUIRE(snap != nullptr);
+
+  SUBCASE("Context calls keep their VM index; module words shadow them")
+  {
+    std::vector<uint8_t> out = batch({"HOST SHADOWED", ": SHADOWED ;"}, nullptr, 2, snap);
+    std::vector<uint8_t> main_code(out.begin(), out.begin() + 7);
+    CHECK(main_code == std::vector<uint8_t>{op(Op::CALL), 40, 0, op(Op::CALL), 0, 0,
+                                            op(Op::RET)});
+  }
+
+  SUBCASE("Dead words are stripped across modules")
+  {
+    V4FrontCompileOptions options = {};
+    options.flags = V4FRONT_OPT_STRIP_UNUSED;
+    std::vector<uint8_t> out = batch({": UNUSED 1 ;", ": USED 2 ;", "USED"}, &options);
+    CHECK(out == whole(": USED 2 ; USED"));
+  }
+
+  v4front_context_destroy(snap);
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Batch: errors name the module")
+{
+  V4FrontBuf buf;
+  V4FrontError error;
+  uint32_t module = 99;
+
+  SUBCASE("Compile error in one module")
+  {
+    std::vector<std::string> sources = {"1 2 +", ": OK ;", "3\n 4 NOPE"};
+    std::vector<V4FrontModule> modules = modules_of(sources);
+    v4front_err err = v4front_compile_batch(nullptr, modules.data(), 3, nullptr, 3, &buf,
+                                            &error, &module);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(module == 2);
+    CHECK(error.line == 2);
+    CHECK(error.column == 4);
+    CHECK(strcmp(error.token, "NOPE") == 0);
+  }
+
+  SUBCASE("The first failing module is reported")
+  {
+    std::vector<std::string> sources = {"1", "BAD1", "2", "BAD2"};
+    std::vector<V4FrontModule> modules = modules_of(sources);
+    v4front_err err = v4front_compile_batch(nullptr, modules.data(), 4, nullptr, 4, &buf,
+                                            &error, &module);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(module == 1);
+  }
+
+  SUBCASE("A word defined by two modules")
+  {
+    std::vector<std::string> sources = {": X 1 ;", "2 : X 3 ;"};
+    std::vector<V4FrontModule> modules = modules_of(sources);
+    v4front_err err = v4front_compile_batch(nullptr, modules.data(), 2, nullptr, 2, &buf,
+                                            &error, &module);
+    CHECK(err == FrontErr::DuplicateWord);
+    CHECK(module == 1);
+    CHECK(error.position == 4);
+  }
+
+  SUBCASE("Invalid options")
+  {
+    V4FrontCompileOptions options = {};
+    options.superinstruction_count = 1;
+    std::vector<std::string> sources = {"1"};
+    std::vector<V4FrontModule> modules = modules_of(sources);
+    v4front_err err = v4front_compile_batch(nullptr, modules.data(), 1, &options, 1, &buf,
+                                            &error, &module);
+    CHECK(err == FrontErr::InvalidOption);
+    CHECK(module == 1);  // Not a module error
+  }
+}
+
+TEST_CASE("Batch: data space is laid out as in one source")
+{
+  const std::vector<std::string> sources = {
+      "CREATE BUF 10 ALLOT VARIABLE A", "16 ALIGN-TO CREATE B VARIABLE C",
+      ": USE BUF A B C ; USE"};
+  CHECK(batch(sources) == whole(concatenated(sources)));
+
+  // Context data space: the batch starts at its HERE and leaves it alone
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_set_data_space(ctx, 0x4000, 256);
+  REQUIRE(err == FrontErr::OK);
+  V4FrontBuf buf;
+  err = v4front_compile_with_context(ctx, "VARIABLE FIRST", &buf, nullptr, 0);
+  REQUIRE(err == FrontErr::OK);
+  v4front_free(&buf);
+  std::vector<uint8_t> out = batch({"VARIABLE X"}, nullptr, 1, ctx);
+  std::vector<uint8_t> tail(out.end() - 6, out.end());
+  CHECK(tail == std::vector<uint8_t>{op(Op::LIT), 0x04, 0x40, 0, 0, op(Op::RET)});
+  CHECK(v4front_context_get_here(ctx) == 0x4004);
+  v4front_context_destroy(ctx);
+
+  // An operand only the compiler knows cannot be planned
+  std::vector<std::string> folded = {"CREATE T 2 2 + ALLOT", "VARIABLE Y"};
+  std::vector<V4FrontModule> modules = modules_of(folded);
+  V4FrontCompileOptions options = {};
+  options.opt_level = 1;
+  uint32_t module;
+  err = v4front_compile_batch(nullptr, modules.data(), 2, &options, 2, &buf, nullptr,
+                              &module);
+  CHECK(err == FrontErr::LinkFailed);
+}
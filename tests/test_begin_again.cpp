@@ -466,4 +466,54 @@ TEST_CASE("Deep nesting with AGAIN")
     CHECK(err == FrontErr::OK);
     v4front_free(&buf);
   }
-}
\ No newline at end of file
+}
+TEST_CASE("Main code keeps its RET unless it ends in a loop back-edge")
+{
+  V4FrontBuf buf;
+  char errmsg[256];
+
+  SUBCASE("Literal whose bytes look like a JMP")
+  {
+    // 16384 is LIT 00 40 00 00: the byte three from the end is 0x40 (JMP)
+    v4front_err err = v4front_compile("16384", &buf, errmsg, sizeof(errmsg));
+    REQUIRE(err == FrontErr::OK);
+    const uint8_t expected[] = {static_cast<uint8_t>(Op::LIT), 0x00, 0x40, 0x00, 0x00,
+                                static_cast<uint8_t>(Op::RET)};
+    REQUIRE(buf.size == sizeof(expected));
+    CHECK(memcmp(buf.data, expected, sizeof(expected)) == 0);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Programs ending in 16384 and -1")
+  {
+    const char* sources[] = {"-1", "1 16384", "16384 -1", "-1 16384", "0x4000 1 +"};
+    for (const char* source : sources)
+    {
+      CAPTURE(source);
+      v4front_err err = v4front_compile(source, &buf, errmsg, sizeof(errmsg));
+      REQUIRE(err == FrontErr::OK);
+      REQUIRE(buf.size > 0);
+      CHECK(buf.data[buf.size - 1] == static_cast<uint8_t>(Op::RET));
+      v4front_free(&buf);
+    }
+  }
+
+  SUBCASE("A WHILE exit reaches the end")
+  {
+    v4front_err err =
+        v4front_compile("5 BEGIN DUP WHILE 1- REPEAT", &buf, errmsg, sizeof(errmsg));
+    REQUIRE(err == FrontErr::OK);
+    CHECK(buf.data[buf.size - 1] == static_cast<uint8_t>(Op::RET));
+    CHECK(buf.data[buf.size - 4] == static_cast<uint8_t>(Op::JMP));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("AGAIN at the end needs no RET")
+  {
+    v4front_err err = v4front_compile("BEGIN 16384 DROP AGAIN", &buf, errmsg,
+                                      sizeof(errmsg));
+    REQUIRE(err == FrontErr::OK);
+    CHECK(buf.data[buf.size - 3] == static_cast<uint8_t>(Op::JMP));
+    v4front_free(&buf);
+  }
+}
@@ -1,6 +1,11 @@
 #define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "v4front/compile.h"
 #include "vendor/doctest/doctest.h"
@@ -219,3 +224,746 @@ TEST_CASE("Bytecode file I/O")
     }
   }
 }
+
+TEST_CASE("Memory-mapped bytecode")
+{
+  char errmsg[256];
+
+  SUBCASE("Map a saved file")
+  {
+    V4FrontBuf buf;
+    v4front_err err = v4front_compile("1 IF 2 ELSE 3 THEN", &buf, errmsg, sizeof(errmsg));
+    REQUIRE(err == 0);
+    const char* filename = "test_map.v4b";
+    err = v4front_save_bytecode(&buf, filename);
+    REQUIRE(err == 0);
+
+    V4FrontMappedBytecode map;
+    err = v4front_map_bytecode(filename, &map);
+    REQUIRE(err == 0);
+    REQUIRE(map.size == buf.size);
+    CHECK(memcmp(map.code, buf.data, buf.size) == 0);
+    CHECK(map.length == sizeof(V4BytecodeHeader) + buf.size);
+
+    v4front_unmap_bytecode(&map);
+    CHECK(map.code == nullptr);
+    CHECK(map.size == 0);
+    v4front_unmap_bytecode(&map);  // Already released
+    v4front_unmap_bytecode(nullptr);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("code_size is checked against the file length")
+  {
+    const char* filename = "test_map_truncated.v4b";
+    FILE* fp = fopen(filename, "wb");
+    REQUIRE(fp != nullptr);
+    V4BytecodeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "V4BC", 4);
+    header.code_size = 11;
+    fwrite(&header, sizeof(header), 1, fp);
+    uint8_t code[10] = {0};
+    fwrite(code, 1, sizeof(code), fp);
+    fclose(fp);
+
+    V4FrontMappedBytecode map;
+    v4front_err err = v4front_map_bytecode(filename, &map);
+    CHECK(err == -6);
+    CHECK(map.code == nullptr);
+  }
+
+  SUBCASE("Errors")
+  {
+    V4FrontMappedBytecode map;
+    CHECK(v4front_map_bytecode(nullptr, &map) == -1);
+    CHECK(v4front_map_bytecode("test.v4b", nullptr) == -1);
+    CHECK(v4front_map_bytecode("nonexistent_xyz.v4b", &map) == -2);
+
+    // Shorter than the header
+    const char* filename = "test_map_short.v4b";
+    FILE* fp = fopen(filename, "wb");
+    REQUIRE(fp != nullptr);
+    fwrite("V4BC", 1, 4, fp);
+    fclose(fp);
+    CHECK(v4front_map_bytecode(filename, &map) == -3);
+
+    // Invalid magic
+    filename = "test_map_magic.v4b";
+    fp = fopen(filename, "wb");
+    REQUIRE(fp != nullptr);
+    V4BytecodeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "XXXX", 4);
+    fwrite(&header, sizeof(header), 1, fp);
+    fclose(fp);
+    CHECK(v4front_map_bytecode(filename, &map) == -4);
+  }
+}
+
+// Whole file contents
+static std::vector<uint8_t> read_file(const char* filename)
+{
+  std::vector<uint8_t> bytes;
+  FILE* fp = fopen(filename, "rb");
+  REQUIRE(fp != nullptr);
+  int c;
+  while ((c = fgetc(fp)) != EOF)
+    bytes.push_back(static_cast<uint8_t>(c));
+  fclose(fp);
+  return bytes;
+}
+
+static void write_file(const char* filename, const std::vector<uint8_t>& bytes)
+{
+  FILE* fp = fopen(filename, "wb");
+  REQUIRE(fp != nullptr);
+  CHECK(fwrite(bytes.data(), 1, bytes.size(), fp) == bytes.size());
+  fclose(fp);
+}
+
+TEST_CASE("Bytecode sections (v0.2)")
+{
+  char errmsg[256];
+  V4FrontBuf buf;
+  const char* source = ": SQ DUP * ;\n: CUBE DUP SQ * ;\n3 CUBE";
+  v4front_err err = v4front_compile(source, &buf, errmsg, sizeof(errmsg));
+  REQUIRE(err == 0);
+  REQUIRE(buf.word_count == 2);
+  const char* filename = "test_sections.v4b";
+  err = v4front_save_bytecode(&buf, filename);
+  REQUIRE(err == 0);
+
+  std::vector<uint8_t> file = read_file(filename);
+  V4BytecodeHeader header;
+  REQUIRE(file.size() >= sizeof(header));
+  memcpy(&header, file.data(), sizeof(header));
+
+  SUBCASE("Header and directory")
+  {
+    CHECK(header.version_major == 0);
+    CHECK(header.version_minor == 2);
+    CHECK(header.flags == V4B_FLAG_SECTIONS);
+    CHECK(header.code_size == buf.size);
+    CHECK(header.reserved % V4B_SECTION_ALIGN == 0);
+    CHECK(header.reserved >= sizeof(header) + buf.size);
+
+    // The main code is where a v0.1 reader expects it
+    CHECK(memcmp(file.data() + sizeof(header), buf.data, buf.size) == 0);
+
+    V4BytecodeDirectory directory;
+    memcpy(&directory, file.data() + header.reserved, sizeof(directory));
+    REQUIRE(directory.section_count == 4);
+    for (uint32_t i = 0; i < directory.section_count; i++)
+    {
+      V4BytecodeSection section;
+      size_t at = header.reserved + sizeof(directory) + i * sizeof(section);
+      memcpy(&section, file.data() + at, sizeof(section));
+      CAPTURE(section.type);
+      CHECK(section.offset % V4B_SECTION_ALIGN == 0);
+      CHECK(section.offset + section.size <= file.size());
+      if (section.type == V4B_SECTION_WORDS)
+        CHECK(section.count == 2);
+    }
+  }
+
+  SUBCASE("Load restores the words")
+  {
+    V4FrontBuf loaded;
+    err = v4front_load_bytecode(filename, &loaded);
+    REQUIRE(err == 0);
+    REQUIRE(loaded.size == buf.size);
+    CHECK(memcmp(loaded.data, buf.data, buf.size) == 0);
+    REQUIRE(loaded.word_count == buf.word_count);
+    for (int i = 0; i < buf.word_count; i++)
+    {
+      CHECK(strcmp(loaded.words[i].name, buf.words[i].name) == 0);
+      REQUIRE(loaded.words[i].code_len == buf.words[i].code_len);
+      CHECK(memcmp(loaded.words[i].code, buf.words[i].code, buf.words[i].code_len) == 0);
+    }
+
+    // And saves back to the same file
+    err = v4front_save_bytecode(&loaded, "test_sections_again.v4b");
+    REQUIRE(err == 0);
+    CHECK(read_file("test_sections_again.v4b") == file);
+    v4front_free(&loaded);
+  }
+
+  SUBCASE("Mapped words are used in place")
+  {
+    V4FrontMappedBytecode map;
+    err = v4front_map_bytecode(filename, &map);
+    REQUIRE(err == 0);
+    REQUIRE(map.word_count == 2);
+    CHECK(reinterpret_cast<uintptr_t>(map.words) % V4B_SECTION_ALIGN == 0);
+    CHECK(map.debug == nullptr);
+    CHECK(memcmp(map.code, buf.data, buf.size) == 0);
+    for (uint32_t i = 0; i < map.word_count; i++)
+    {
+      const char* name;
+      const uint8_t* code;
+      uint32_t len;
+      err = v4front_mapped_word(&map, i, &name, &code, &len);
+      REQUIRE(err == 0);
+      CHECK(strcmp(name, buf.words[i].name) == 0);
+      REQUIRE(len == buf.words[i].code_len);
+      CHECK(memcmp(code, buf.words[i].code, len) == 0);
+      CHECK(code >= static_cast<const uint8_t*>(map.base));
+      CHECK(code + len <= static_cast<const uint8_t*>(map.base) + map.length);
+    }
+    err = v4front_mapped_word(&map, 2, nullptr, nullptr, nullptr);
+    CHECK(err == -1);
+    v4front_unmap_bytecode(&map);
+    CHECK(map.word_count == 0);
+    err = v4front_mapped_word(nullptr, 0, nullptr, nullptr, nullptr);
+    CHECK(err == -1);
+  }
+
+  SUBCASE("A malformed word table is rejected")
+  {
+    // Point the directory past the end of the file
+    std::vector<uint8_t> bad = file;
+    uint32_t dir = static_cast<uint32_t>(file.size());
+    memcpy(bad.data() + 12, &dir, sizeof(dir));
+    write_file("test_sections_bad.v4b", bad);
+    V4FrontBuf loaded;
+    err = v4front_load_bytecode("test_sections_bad.v4b", &loaded);
+    CHECK(err == -7);
+    V4FrontMappedBytecode map;
+    err = v4front_map_bytecode("test_sections_bad.v4b", &map);
+    CHECK(err == -7);
+    CHECK(map.base == nullptr);
+
+    // A word whose code runs past its section
+    bad = file;
+    V4BytecodeDirectory directory;
+    memcpy(&directory, bad.data() + header.reserved, sizeof(directory));
+    for (uint32_t i = 0; i < directory.section_count; i++)
+    {
+      V4BytecodeSection section;
+      size_t at = header.reserved + sizeof(directory) + i * sizeof(section);
+      memcpy(&section, bad.data() + at, sizeof(section));
+      if (section.type == V4B_SECTION_WORDS)
+      {
+        uint32_t len = 1000;
+        memcpy(bad.data() + section.offset + offsetof(V4BytecodeWord, code_len), &len,
+               sizeof(len));
+      }
+    }
+    write_file("test_sections_bad.v4b", bad);
+    err = v4front_load_bytecode("test_sections_bad.v4b", &loaded);
+    CHECK(err == -7);
+    err = v4front_map_bytecode("test_sections_bad.v4b", &map);
+    CHECK(err == -7);
+  }
+
+  v4front_free(&buf);
+}
+
+TEST_CASE("Bytecode sections: unknown and debug sections")
+{
+  // Header, 1 byte of code, directory at 24 with two sections at 64 and 72
+  std::vector<uint8_t> file(80, 0);
+  V4BytecodeHeader header = {{'V', '4', 'B', 'C'}, 0, 2, V4B_FLAG_SECTIONS, 1, 24};
+  memcpy(file.data(), &header, sizeof(header));
+  file[16] = 0x51;  // RET
+  V4BytecodeDirectory directory = {2, 0};
+  memcpy(file.data() + 24, &directory, sizeof(directory));
+  V4BytecodeSection sections[2] = {{99, 64, 8, 0}, {V4B_SECTION_DEBUG, 72, 8, 0}};
+  memcpy(file.data() + 32, sections, sizeof(sections));
+  memcpy(file.data() + 72, "lines...", 8);
+  write_file("test_sections_debug.v4b", file);
+
+  V4FrontMappedBytecode map;
+  v4front_err err = v4front_map_bytecode("test_sections_debug.v4b", &map);
+  REQUIRE(err == 0);
+  CHECK(map.size == 1);
+  CHECK(map.word_count == 0);
+  REQUIRE(map.debug_size == 8);
+  CHECK(memcmp(map.debug, "lines...", 8) == 0);
+  v4front_unmap_bytecode(&map);
+
+  V4FrontBuf loaded;
+  err = v4front_load_bytecode("test_sections_debug.v4b", &loaded);
+  REQUIRE(err == 0);
+  CHECK(loaded.size == 1);
+  CHECK(loaded.word_count == 0);
+  v4front_free(&loaded);
+
+  // Misaligned sections are rejected
+  sections[1].offset = 68;
+  memcpy(file.data() + 32, sections, sizeof(sections));
+  write_file("test_sections_debug.v4b", file);
+  err = v4front_map_bytecode("test_sections_debug.v4b", &map);
+  CHECK(err == -7);
+}
+
+// Section of the given type from a file image (false if absent)
+static bool find_section(const std::vector<uint8_t>& file, uint32_t type,
+                         V4BytecodeSection* out)
+{
+  V4BytecodeHeader header;
+  memcpy(&header, file.data(), sizeof(header));
+  V4BytecodeDirectory directory;
+  memcpy(&directory, file.data() + header.reserved, sizeof(directory));
+  for (uint32_t i = 0; i < directory.section_count; i++)
+  {
+    size_t at = header.reserved + sizeof(directory) + i * sizeof(*out);
+    memcpy(out, file.data() + at, sizeof(*out));
+    if (out->type == type)
+      return true;
+  }
+  return false;
+}
+
+TEST_CASE("Compressed bytecode (v0.3)")
+{
+  // Repetitive code, as loops and literals produce
+  std::string source;
+  for (int i = 0; i < 20; i++)
+    source += ": W" + std::to_string(i) + " 10 0 DO I J + 1000 * DROP LOOP ;\n";
+  for (int i = 0; i < 20; i++)
+    source += "W" + std::to_string(i) + " 100000 200000 + DROP\n";
+
+  char errmsg[256];
+  V4FrontBuf buf;
+  v4front_err err = v4front_compile(source.c_str(), &buf, errmsg, sizeof(errmsg));
+  REQUIRE(err == 0);
+  err = v4front_save_bytecode(&buf, "test_plain.v4b");
+  REQUIRE(err == 0);
+  err = v4front_save_bytecode_with_flags(&buf, "test_packed.v4b", V4B_SAVE_COMPRESS);
+  REQUIRE(err == 0);
+  std::vector<uint8_t> plain = read_file("test_plain.v4b");
+  std::vector<uint8_t> packed = read_file("test_packed.v4b");
+
+  V4BytecodeHeader header;
+  memcpy(&header, packed.data(), sizeof(header));
+  CHECK(header.version_minor == 3);
+  CHECK(header.flags == (V4B_FLAG_SECTIONS | V4B_FLAG_COMPRESSED));
+  CHECK(header.code_size == buf.size);
+  CHECK(header.reserved == sizeof(header));
+  CHECK(packed.size() * 2 < plain.size());
+
+  SUBCASE("Flags 0 write the plain format")
+  {
+    err = v4front_save_bytecode_with_flags(&buf, "test_plain_again.v4b", 0);
+    REQUIRE(err == 0);
+    CHECK(read_file("test_plain_again.v4b") == plain);
+  }
+
+  SUBCASE("Load inflates main code and words")
+  {
+    V4FrontBuf loaded;
+    err = v4front_load_bytecode("test_packed.v4b", &loaded);
+    REQUIRE(err == 0);
+    REQUIRE(loaded.size == buf.size);
+    CHECK(memcmp(loaded.data, buf.data, buf.size) == 0);
+    REQUIRE(loaded.word_count == buf.word_count);
+    for (int i = 0; i < buf.word_count; i++)
+    {
+      CHECK(strcmp(loaded.words[i].name, buf.words[i].name) == 0);
+      REQUIRE(loaded.words[i].code_len == buf.words[i].code_len);
+      CHECK(memcmp(loaded.words[i].code, buf.words[i].code, buf.words[i].code_len) == 0);
+    }
+    v4front_free(&loaded);
+
+    V4FrontMappedBytecode map;
+    err = v4front_map_bytecode("test_packed.v4b", &map);
+    CHECK(err == -8);
+  }
+
+  SUBCASE("The inflater takes input in any pieces")
+  {
+    V4BytecodeSection code;
+    REQUIRE(find_section(packed, V4B_SECTION_CODE, &code));
+    REQUIRE(code.count == buf.size);
+    const uint8_t* in = packed.data() + code.offset;
+    for (size_t piece : {size_t(1), size_t(3), size_t(code.size)})
+    {
+      CAPTURE(piece);
+      std::vector<uint8_t> out(code.count, 0xee);
+      V4FrontInflater z;
+      v4front_inflate_init(&z, out.data(), out.size());
+      for (size_t at = 0; at < code.size; at += piece)
+      {
+        size_t n = code.size - at < piece ? code.size - at : piece;
+        err = v4front_inflate_feed(&z, in + at, n);
+        REQUIRE(err == 0);
+      }
+      err = v4front_inflate_finish(&z);
+      CHECK(err == 0);
+      CHECK(memcmp(out.data(), buf.data, buf.size) == 0);
+    }
+
+    // Truncated input
+    std::vector<uint8_t> out(code.count);
+    V4FrontInflater z;
+    v4front_inflate_init(&z, out.data(), out.size());
+    err = v4front_inflate_feed(&z, in, code.size - 1);
+    CHECK(err == 0);
+    err = v4front_inflate_finish(&z);
+    CHECK(err == -7);
+  }
+
+  SUBCASE("Corrupt streams are rejected")
+  {
+    uint8_t out[8];
+    V4FrontInflater z;
+
+    // Match before the start of the output
+    const uint8_t back[] = {0x10, 'a', 0x02, 0x00};
+    v4front_inflate_init(&z, out, sizeof(out));
+    err = v4front_inflate_feed(&z, back, sizeof(back));
+    CHECK(err == -7);
+
+    // More literals than the output holds
+    const uint8_t big[] = {0xf0, 0x00};
+    v4front_inflate_init(&z, out, sizeof(out));
+    err = v4front_inflate_feed(&z, big, sizeof(big));
+    CHECK(err == -7);
+
+    // Input past the end of the stream
+    const uint8_t tail[] = {0x10, 'a', 0x01, 0x00, 0x30, 'b', 'c', 'd', 0x00};
+    v4front_inflate_init(&z, out, sizeof(out));
+    err = v4front_inflate_feed(&z, tail, sizeof(tail) - 1);
+    CHECK(err == 0);
+    err = v4front_inflate_finish(&z);
+    CHECK(err == 0);
+    CHECK(memcmp(out, "aaaaabcd", 8) == 0);
+    err = v4front_inflate_feed(&z, tail + sizeof(tail) - 1, 1);
+    CHECK(err == -7);
+
+    // A damaged file fails to load
+    std::vector<uint8_t> bad = packed;
+    V4BytecodeSection code;
+    REQUIRE(find_section(bad, V4B_SECTION_CODE, &code));
+    bad[code.offset] = 0xff;
+    write_file("test_packed_bad.v4b", bad);
+    V4FrontBuf loaded;
+    err = v4front_load_bytecode("test_packed_bad.v4b", &loaded);
+    CHECK(err == -7);
+  }
+
+  v4front_free(&buf);
+}
+
+TEST_CASE("Compressed bytecode: round trip of edge cases")
+{
+  // Main code only, and code that does not compress
+  const char* sources[] = {"1", "1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20"};
+  for (const char* source : sources)
+  {
+    CAPTURE(source);
+    char errmsg[256];
+    V4FrontBuf buf;
+    v4front_err err = v4front_compile(source, &buf, errmsg, sizeof(errmsg));
+    REQUIRE(err == 0);
+    const char* filename = "test_packed_edge.v4b";
+    err = v4front_save_bytecode_with_flags(&buf, filename, V4B_SAVE_COMPRESS);
+    REQUIRE(err == 0);
+    V4FrontBuf loaded;
+    err = v4front_load_bytecode(filename, &loaded);
+    REQUIRE(err == 0);
+    REQUIRE(loaded.size == buf.size);
+    CHECK(memcmp(loaded.data, buf.data, buf.size) == 0);
+    CHECK(loaded.word_count == 0);
+    v4front_free(&loaded);
+    v4front_free(&buf);
+  }
+}
+
+// Byte stream into a vector, recording the size of every write
+struct VectorSink
+{
+  std::vector<uint8_t> bytes;
+  std::vector<size_t> writes;
+  int fail_at = -1;  // Index of the write that fails
+
+  static int write(void* user, const uint8_t* data, size_t len)
+  {
+    VectorSink* sink = static_cast<VectorSink*>(user);
+    if (static_cast<int>(sink->writes.size()) == sink->fail_at)
+      return -1;
+    sink->writes.push_back(len);
+    sink->bytes.insert(sink->bytes.end(), data, data + len);
+    return 0;
+  }
+};
+
+// Byte stream out of a vector, handing out at most `step` bytes per call
+struct VectorSource
+{
+  const std::vector<uint8_t>* bytes;
+  size_t limit;  // Bytes available (to simulate truncation)
+  size_t step;
+  size_t at = 0;
+  size_t largest_request = 0;
+
+  static size_t read(void* user, uint8_t* dst, size_t len)
+  {
+    VectorSource* source = static_cast<VectorSource*>(user);
+    if (len > source->largest_request)
+      source->largest_request = len;
+    size_t n = len < source->step ? len : source->step;
+    if (n > source->limit - source->at)
+      n = source->limit - source->at;
+    memcpy(dst, source->bytes->data() + source->at, n);
+    source->at += n;
+    return n;
+  }
+};
+
+static void check_same(const V4FrontBuf& a, const V4FrontBuf& b)
+{
+  REQUIRE(a.size == b.size);
+  CHECK(memcmp(a.data, b.data, a.size) == 0);
+  REQUIRE(a.word_count == b.word_count);
+  for (int i = 0; i < a.word_count; i++)
+  {
+    CHECK(strcmp(a.words[i].name, b.words[i].name) == 0);
+    REQUIRE(a.words[i].code_len == b.words[i].code_len);
+    CHECK(memcmp(a.words[i].code, b.words[i].code, a.words[i].code_len) == 0);
+  }
+}
+
+TEST_CASE("Bytecode over I/O callbacks")
+{
+  std::string source;
+  for (int i = 0; i < 30; i++)
+    source += ": WORD" + std::to_string(i) + " " + std::to_string(i * 1000) +
+              " DUP * ;\n";
+  source += "WORD3 WORD7 +";
+  char errmsg[256];
+  V4FrontBuf buf;
+  v4front_err err = v4front_compile(source.c_str(), &buf, errmsg, sizeof(errmsg));
+  REQUIRE(err == 0);
+
+  for (uint32_t flags : {0u, static_cast<uint32_t>(V4B_SAVE_COMPRESS)})
+  {
+    CAPTURE(flags);
+    VectorSink sink;
+    V4FrontByteWriter writer = {VectorSink::write, &sink};
+    err = v4front_write_bytecode_cb(&buf, flags, &writer);
+    REQUIRE(err == 0);
+
+    // Same bytes as the file, in whole chunks
+    err = v4front_save_bytecode_with_flags(&buf, "test_callbacks.v4b", flags);
+    REQUIRE(err == 0);
+    CHECK(sink.bytes == read_file("test_callbacks.v4b"));
+    REQUIRE(sink.writes.size() > 1);
+    for (size_t i = 0; i + 1 < sink.writes.size(); i++)
+      CHECK(sink.writes[i] == V4B_IO_CHUNK);
+    CHECK(sink.writes.back() <= V4B_IO_CHUNK);
+
+    // Read back in small pieces, never asked for more than a chunk
+    for (size_t step : {size_t(1), size_t(7), size_t(1000)})
+    {
+      CAPTURE(step);
+      VectorSource src = {&sink.bytes, sink.bytes.size(), step};
+      V4FrontByteReader reader = {VectorSource::read, &src};
+      V4FrontBuf loaded;
+      err = v4front_read_bytecode_cb(&reader, &loaded);
+      REQUIRE(err == 0);
+      check_same(loaded, buf);
+      CHECK(src.largest_request <= V4B_IO_CHUNK);
+      v4front_free(&loaded);
+    }
+
+    // Truncated at every length: an error, never a partial result
+    for (size_t limit = 0; limit < sink.bytes.size(); limit += 13)
+    {
+      CAPTURE(limit);
+      VectorSource src = {&sink.bytes, limit, V4B_IO_CHUNK};
+      V4FrontByteReader reader = {VectorSource::read, &src};
+      V4FrontBuf loaded;
+      err = v4front_read_bytecode_cb(&reader, &loaded);
+      CHECK(err < 0);
+    }
+  }
+
+  SUBCASE("Writer failures")
+  {
+    VectorSink sink;
+    sink.fail_at = 0;
+    V4FrontByteWriter writer = {VectorSink::write, &sink};
+    err = v4front_write_bytecode_cb(&buf, 0, &writer);
+    CHECK(err == -3);
+    sink.fail_at = 1;
+    err = v4front_write_bytecode_cb(&buf, 0, &writer);
+    CHECK(err == -4);
+  }
+
+  SUBCASE("Overlapping sections cannot be read front to back")
+  {
+    VectorSink sink;
+    V4FrontByteWriter writer = {VectorSink::write, &sink};
+    err = v4front_write_bytecode_cb(&buf, 0, &writer);
+    REQUIRE(err == 0);
+    V4BytecodeSection words;
+    REQUIRE(find_section(sink.bytes, V4B_SECTION_WORDS, &words));
+    V4BytecodeHeader header;
+    memcpy(&header, sink.bytes.data(), sizeof(header));
+    V4BytecodeDirectory directory;
+    memcpy(&directory, sink.bytes.data() + header.reserved, sizeof(directory));
+    for (uint32_t i = 0; i < directory.section_count; i++)
+    {
+      size_t at = header.reserved + sizeof(directory) + i * sizeof(V4BytecodeSection);
+      V4BytecodeSection section;
+      memcpy(&section, sink.bytes.data() + at, sizeof(section));
+      if (section.type == V4B_SECTION_NAMES)
+      {
+        section.offset = words.offset + 8;
+        memcpy(sink.bytes.data() + at, &section, sizeof(section));
+      }
+    }
+    VectorSource src = {&sink.bytes, sink.bytes.size(), V4B_IO_CHUNK};
+    V4FrontByteReader reader = {VectorSource::read, &src};
+    V4FrontBuf loaded;
+    err = v4front_read_bytecode_cb(&reader, &loaded);
+    CHECK(err == -7);
+  }
+
+  SUBCASE("Invalid parameters")
+  {
+    V4FrontByteWriter writer = {nullptr, nullptr};
+    CHECK(v4front_write_bytecode_cb(&buf, 0, nullptr) == -1);
+    CHECK(v4front_write_bytecode_cb(&buf, 0, &writer) == -1);
+    V4FrontByteReader reader = {nullptr, nullptr};
+    V4FrontBuf loaded;
+    CHECK(v4front_read_bytecode_cb(nullptr, &loaded) == -1);
+    CHECK(v4front_read_bytecode_cb(&reader, &loaded) == -1);
+  }
+
+  v4front_free(&buf);
+}
+
+TEST_CASE("Prelude files")
+{
+  const char* filename = "test_prelude.v4b";
+  V4FrontBuf lib;
+  v4front_err err = v4front_compile(": SQ DUP * ;\n: CUBE DUP SQ * ;", &lib, nullptr, 0);
+  REQUIRE(err == 0);
+
+  // A host primitive, then the library words as the VM numbered them
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  REQUIRE(v4front_context_register_word(ctx, "HOST", 0) == 0);
+  REQUIRE(v4front_context_register_word(ctx, "SQ", 1) == 0);
+  REQUIRE(v4front_context_register_word(ctx, "CUBE", 2) == 0);
+  err = v4front_save_prelude(ctx, &lib, filename);
+  REQUIRE(err == 0);
+
+  SUBCASE("A new context starts where the saved one was")
+  {
+    V4FrontContext* fresh = v4front_context_create();
+    REQUIRE(fresh != nullptr);
+    REQUIRE(v4front_context_register_word(fresh, "STALE", 9) == 0);
+    V4FrontMappedBytecode map;
+    err = v4front_context_load_prelude(fresh, filename, &map);
+    REQUIRE(err == 0);
+
+    REQUIRE(v4front_context_get_word_count(fresh) == 3);
+    CHECK(std::string(v4front_context_get_word_name(fresh, 0)) == "HOST");
+    CHECK(std::string(v4front_context_get_word_name(fresh, 2)) == "CUBE");
+    CHECK(v4front_context_find_word(fresh, "cube") == 2);
+    CHECK(v4front_context_find_word(fresh, "STALE") < 0);
+
+    // The library comes straight from the mapping
+    REQUIRE(map.word_count == 2);
+    for (uint32_t i = 0; i < map.word_count; i++)
+    {
+      const char* name;
+      const uint8_t* code;
+      uint32_t len;
+      REQUIRE(v4front_mapped_word(&map, i, &name, &code, &len) == 0);
+      CHECK(std::string(name) == lib.words[i].name);
+      REQUIRE(len == lib.words[i].code_len);
+      CHECK(memcmp(code, lib.words[i].code, len) == 0);
+    }
+    v4front_unmap_bytecode(&map);
+
+    // User code compiles the same against both contexts
+    V4FrontBuf a;
+    V4FrontBuf b;
+    REQUIRE(v4front_compile_with_context(ctx, "3 CUBE HOST SQ", &a, nullptr, 0) == 0);
+    REQUIRE(v4front_compile_with_context(fresh, "3 CUBE HOST SQ", &b, nullptr, 0) == 0);
+    REQUIRE(a.size == b.size);
+    CHECK(memcmp(a.data, b.data, a.size) == 0);
+    v4front_free(&a);
+    v4front_free(&b);
+    v4front_context_destroy(fresh);
+  }
+
+  SUBCASE("The file is still a plain v0.2 file")
+  {
+    V4FrontBuf loaded;
+    err = v4front_load_bytecode(filename, &loaded);
+    REQUIRE(err == 0);
+    REQUIRE(loaded.word_count == 2);
+    CHECK(std::string(loaded.words[1].name) == "CUBE");
+    v4front_free(&loaded);
+
+    V4BytecodeSection section;
+    std::vector<uint8_t> file = read_file(filename);
+    REQUIRE(find_section(file, V4B_SECTION_CONTEXT, &section));
+    CHECK(section.count == 3);
+    CHECK(section.offset % V4B_SECTION_ALIGN == 0);
+    CHECK(section.offset + section.size == file.size());
+  }
+
+  SUBCASE("Without a library")
+  {
+    err = v4front_save_prelude(ctx, nullptr, filename);
+    REQUIRE(err == 0);
+    V4FrontContext* fresh = v4front_context_create();
+    REQUIRE(fresh != nullptr);
+    err = v4front_context_load_prelude(fresh, filename, nullptr);
+    CHECK(err == 0);
+    CHECK(v4front_context_get_word_count(fresh) == 3);
+    v4front_context_destroy(fresh);
+  }
+
+  SUBCASE("Files that are not preludes")
+  {
+    V4FrontContext* fresh = v4front_context_create();
+    REQUIRE(fresh != nullptr);
+    REQUIRE(v4front_context_register_word(fresh, "KEEP", 4) == 0);
+
+    // No context section: ctx is left alone
+    REQUIRE(v4front_save_bytecode(&lib, "test_prelude_plain.v4b") == 0);
+    err = v4front_context_load_prelude(fresh, "test_prelude_plain.v4b", nullptr);
+    CHECK(err == -7);
+    CHECK(v4front_context_find_word(fresh, "KEEP") == 4);
+
+    // A name offset inside the entry table
+    std::vector<uint8_t> file = read_file(filename);
+    V4BytecodeSection section;
+    REQUIRE(find_section(file, V4B_SECTION_CONTEXT, &section));
+    uint32_t bad = 4;
+    memcpy(file.data() + section.offset + sizeof(V4BytecodeContextWord), &bad, 4);
+    write_file("test_prelude_bad.v4b", file);
+    err = v4front_context_load_prelude(fresh, "test_prelude_bad.v4b", nullptr);
+    CHECK(err == -7);
+
+    CHECK(v4front_context_load_prelude(fresh, "missing.v4b", nullptr) == -2);
+    CHECK(v4front_context_get_word_count(fresh) == 1);
+    v4front_context_destroy(fresh);
+  }
+
+  SUBCASE("Invalid parameters")
+  {
+    CHECK(v4front_save_prelude(nullptr, &lib, filename) == -1);
+    CHECK(v4front_save_prelude(ctx, &lib, nullptr) == -1);
+    CHECK(v4front_context_load_prelude(nullptr, filename, nullptr) == -1);
+    CHECK(v4front_context_load_prelude(ctx, nullptr, nullptr) == -1);
+
+    V4FrontContext* snap = v4front_context_snapshot(ctx);
+    REQUIRE(snap != nullptr);
+    CHECK(v4front_context_load_prelude(snap, filename, nullptr) == -1);
+    CHECK(v4front_context_get_word_count(snap) == 3);
+    v4front_context_destroy(snap);
+  }
+
+  v4front_context_destroy(ctx);
+  v4front_free(&lib);
+}
@@ -276,4 +276,39 @@ TEST_CASE("Complex expressions with mixed case")
     CHECK(err == FrontErr::OK);
     v4front_free(&buf);
   }
-}
\ No newline at end of file
+}
+TEST_CASE("Keyword classification precedence")
+{
+  V4FrontBuf buf;
+  char errmsg[256];
+
+  SUBCASE("Composite words can be shadowed by user words in any case")
+  {
+    v4front_err err =
+        v4front_compile(": rot 42 ; Rot", &buf, errmsg, sizeof(errmsg));
+    CHECK(err == FrontErr::OK);
+    REQUIRE(buf.word_count == 1);
+    // Main code: CALL 0, RET
+    REQUIRE(buf.size == 4);
+    CHECK(buf.data[0] == static_cast<uint8_t>(v4::Op::CALL));
+    CHECK(buf.data[3] == static_cast<uint8_t>(v4::Op::RET));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Near-miss spellings are not keywords")
+  {
+    v4front_err err = v4front_compile("1 DUPE", &buf, errmsg, sizeof(errmsg));
+    CHECK(err == FrontErr::UnknownToken);
+
+    err = v4front_compile("1 +LOOPS", &buf, errmsg, sizeof(errmsg));
+    CHECK(err == FrontErr::UnknownToken);
+  }
+
+  SUBCASE("Mixed case control flow")
+  {
+    v4front_err err = v4front_compile("1 If 2 eLsE 3 tHeN 10 0 Do LoOp", &buf, errmsg,
+                                      sizeof(errmsg));
+    CHECK(err == FrontErr::OK);
+    v4front_free(&buf);
+  }
+}
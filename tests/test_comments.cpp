@@ -2,6 +2,7 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <cstdint>
 #include <cstring>
+#include <string>
 #include <v4/opcodes.hpp>
 
 #include "v4front/compile.hpp"
@@ -239,3 +240,57 @@ TEST_CASE("comments: only parenthesized comment")
   CHECK(buf.size == 1);  // Just RET
   CHECK(buf.data[0] == static_cast<uint8_t>(Op::RET));
 }
+
+// Whitespace and comment runs are skipped in 16-byte blocks where SIMD is
+// available; every run length and block offset must give the same result
+TEST_CASE("comments: long runs at every length")
+{
+  const char spaces[] = " \t\n\v\f\r";
+  for (size_t n = 0; n <= 40; n++)
+  {
+    CAPTURE(n);
+    std::string pad;
+    std::string body;
+    for (size_t i = 0; i < n; i++)
+    {
+      pad += spaces[i % 6];
+      body += static_cast<char>(i % 2 ? 0x80 + i : 'a' + i % 26);  // High bytes too
+    }
+
+    std::string sources[] = {
+        pad + "7" + pad,
+        "\\" + body + "\n7",
+        "( " + body + " ) 7",
+        pad + "( " + body + ")" + pad + "\\ " + body + "\n" + pad + "7",
+    };
+    for (const std::string& source : sources)
+    {
+      V4FrontBuf buf{};
+      BufferGuard guard(&buf);
+      char err[128];
+      int rc = v4front_compile_n(source.data(), source.size(), &buf, err, sizeof(err));
+      REQUIRE_MESSAGE(rc == 0, err);
+      REQUIRE(buf.size == 6);  // LIT 7, RET
+      CHECK(read_u32_le(buf.data + 1) == 7);
+    }
+
+    // A comment closed only past the end of the source stays unterminated
+    std::string open = "( " + body + pad;
+    V4FrontBuf buf{};
+    BufferGuard guard(&buf);
+    int rc = v4front_compile_n(open.data(), open.size(), &buf, nullptr, 0);
+    CHECK(rc == V4FRONT_ERR_UnterminatedComment);
+  }
+}
+
+TEST_CASE("comments: non-ASCII bytes are not whitespace")
+{
+  V4FrontBuf buf{};
+  BufferGuard guard(&buf);
+
+  // 32 bytes of 0x85 (NEL) and 0xA0 (no-break space) form one unknown token
+  std::string source(16, '\x85');
+  source += std::string(16, '\xA0');
+  int rc = v4front_compile(("1 " + source + " 2").c_str(), &buf, nullptr, 0);
+  CHECK(rc == V4FRONT_ERR_UnknownToken);
+}
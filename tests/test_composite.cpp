@@ -118,13 +118,15 @@ TEST_CASE("Composite words: conditional")
     CHECK(err == FrontErr::OK);
     CHECK(buf.word_count == 1);
 
-    // Should contain: DUP, DUP, JZ, DUP
+    // Should contain: DUP, JZ +1, DUP (JZ consumes the copy, so a zero
+    // is left alone and only a non-zero value is duplicated)
     const uint8_t* code = buf.words[0].code;
     CHECK(code[0] == static_cast<uint8_t>(Op::DUP));
-    CHECK(code[1] == static_cast<uint8_t>(Op::DUP));
-    CHECK(code[2] == static_cast<uint8_t>(Op::JZ));
-    // Skip offset check (2 bytes)
-    CHECK(code[5] == static_cast<uint8_t>(Op::DUP));
+    CHECK(code[1] == static_cast<uint8_t>(Op::JZ));
+    CHECK(code[2] == 1);
+    CHECK(code[3] == 0);
+    CHECK(code[4] == static_cast<uint8_t>(Op::DUP));
+    CHECK(code[5] == static_cast<uint8_t>(Op::RET));
 
     v4front_free(&buf);
   }
@@ -0,0 +1,133 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <string>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Main code of source compiled with flags
+static std::vector<uint8_t> main_code(const char* source, uint32_t flags,
+                                      const V4FrontContext* ctx = nullptr)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(const_cast<V4FrontContext*>(ctx),
+                                                 source, &options, &buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  v4front_free(&buf);
+  return out;
+}
+
+static const char* const kFact = ": FACT DUP 1 > IF DUP 1 - RECURSE * THEN ; ";
+
+TEST_CASE("Eval: pure words on literals become literals")
+{
+  const uint32_t flags = V4FRONT_OPT_EVAL;
+  std::string fact = kFact;
+
+  SUBCASE("Recursion")
+  {
+    CHECK(main_code((fact + "10 FACT").c_str(), flags) == main_code("3628800", 0));
+    CHECK(main_code((fact + "10 FACT").c_str(), 0) != main_code("3628800", 0));
+  }
+
+  SUBCASE("Loops, locals and nested calls")
+  {
+    const char* sum = ": SQ DUP * ; : SUMSQ 0 SWAP 0 DO I SQ + LOOP ; 4 SUMSQ";
+    CHECK(main_code(sum, flags) == main_code("14", 0));
+    CHECK(main_code(sum, flags | V4FRONT_O2_FLAGS) == main_code("14", V4FRONT_O2_FLAGS));
+    const char* loc = ": SWAPL L! 0 L! 1 L@ 0 L@ 1 ; 1 2 SWAPL";
+    CHECK(main_code(loc, flags) == main_code("2 1", 0));
+  }
+
+  SUBCASE("Words without inputs and partial consumption")
+  {
+    CHECK(main_code(": SIZE 16 4 * ; SIZE", flags) == main_code("64", 0));
+    CHECK(main_code(": SQ DUP * ; 7 8 SQ", flags) == main_code("7 64", 0));
+  }
+
+  SUBCASE("Results feed folding and further calls")
+  {
+    uint32_t fold = flags | V4FRONT_OPT_CONSTANT_FOLD;
+    CHECK(main_code((fact + "5 FACT 2 *").c_str(), fold) == main_code("240", 0));
+    CHECK(main_code((fact + "3 FACT FACT").c_str(), flags) == main_code("720", 0));
+  }
+
+  SUBCASE("Inside definitions")
+  {
+    V4FrontCompileOptions options = {};
+    options.flags = flags;
+    V4FrontBuf buf;
+    v4front_err err = v4front_compile_with_options(
+        nullptr, (fact + ": F5 5 FACT ;").c_str(), &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    REQUIRE(buf.word_count == 2);
+    CHECK(std::vector<uint8_t>(buf.words[1].code,
+                               buf.words[1].code + buf.words[1].code_len) ==
+          std::vector<uint8_t>{op(Op::LIT), 120, 0, 0, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Eval: calls that must run on the VM are kept")
+{
+  const uint32_t flags = V4FRONT_OPT_EVAL;
+  auto kept = [&](const char* source)
+  {
+    INFO(source);
+    CHECK(main_code(source, flags) == main_code(source, 0));
+  };
+
+  // Side effects
+  kept("VARIABLE X : GET X @ ; GET");
+  kept("VARIABLE X : SET X ! ; 5 SET");
+  kept(": OUT 1 SYS ; 65 OUT");
+  kept(": OUT 1 SYS ; : CALLS-OUT 2 OUT ; CALLS-OUT");
+  // Inputs the compiler does not know
+  kept(": ADD2 + ; 5 ADD2");
+  kept(": SQ DUP * ; DUP SQ");
+  // Traps and undefined results
+  kept(": D 0 / ; 5 D");
+  kept(": SH 40 LSHIFT ; 1 SH");
+  kept(": UNSET L@ 3 ; UNSET");
+  kept(": RPOP R> ; 1 RPOP");
+  // Runs that do not end
+  kept(": SPIN BEGIN 0 UNTIL ; SPIN");
+  kept(": DEEP RECURSE ; DEEP");
+}
+
+TEST_CASE("Eval: context words and output size")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 3);
+  REQUIRE(err == FrontErr::OK);
+
+  // After a context call, local and context CALL operands look alike: only
+  // words without calls still run
+  const uint32_t flags = V4FRONT_OPT_EVAL;
+  const char* after = "HOST : SQ DUP * ; : QUAD SQ SQ ; 3 QUAD";
+  CHECK(main_code(after, flags, ctx) == main_code(after, 0, ctx));
+  CHECK(main_code("HOST : SQ DUP * ; 3 SQ", flags, ctx) ==
+        main_code("HOST : SQ DUP * ; 9", 0, ctx));
+  CHECK(main_code(": SQ DUP * ; 3 SQ HOST", flags, ctx) == main_code("9 HOST", 0, ctx));
+
+  // More results than MAX_FOLD_DEPTH stay a call
+  const char* many = ": MANY 1 2 3 4 5 6 7 8 9 ; MANY";
+  CHECK(main_code(many, flags) == main_code(many, 0));
+  v4front_context_destroy(ctx);
+}
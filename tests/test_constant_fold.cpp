@@ -0,0 +1,216 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void compile_opt(const char* source, uint32_t flags, V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> bytes(const uint8_t* code, size_t len)
+{
+  return std::vector<uint8_t>(code, code + len);
+}
+
+// LIT <value> (imm32, little-endian)
+static void push_lit(std::vector<uint8_t>* out, int32_t value)
+{
+  uint32_t v = static_cast<uint32_t>(value);
+  out->push_back(op(Op::LIT));
+  for (int i = 0; i < 4; i++)
+    out->push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+// Main code of a program that folds down to one literal
+static std::vector<uint8_t> folded(int32_t value)
+{
+  std::vector<uint8_t> out;
+  push_lit(&out, value);
+  out.push_back(op(Op::RET));
+  return out;
+}
+
+TEST_CASE("Constant folding: expressions")
+{
+  V4FrontBuf buf;
+
+  struct Case
+  {
+    const char* source;
+    int32_t value;
+  };
+  const Case cases[] = {
+      {"2 3 +", 5},
+      {"2 3 -", -1},
+      {"4 8 *", 32},
+      {"-7 2 /", -3},
+      {"-7 2 MOD", -1},
+      {"-1 2 U/", 0x7FFFFFFF},
+      {"12 10 AND", 8},
+      {"12 10 OR", 14},
+      {"12 10 XOR", 6},
+      {"1 4 LSHIFT", 16},
+      {"-16 2 RSHIFT", 0x3FFFFFFC},
+      {"-16 2 ARSHIFT", -4},
+      {"3 3 =", -1},
+      {"3 4 <", -1},
+      {"3 4 >", 0},
+      {"-1 1 U<", 0},
+      {"5 NEGATE", -5},
+      {"-5 ABS", 5},
+      {"0 0=", -1},
+      {"3 9 MIN", 3},
+      {"3 9 MAX", 9},
+      {"0 INVERT", -1},
+      {"41 1+", 42},
+      {"2147483647 1 +", INT32_MIN},
+      {"4 8 * 2 LSHIFT 1 -", 127},
+      {"1 2 3 + *", 5},
+  };
+
+  for (const Case& c : cases)
+  {
+    INFO("Source: ", c.source);
+    compile_opt(c.source, V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    CHECK(bytes(buf.data, buf.size) == folded(c.value));
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Constant folding: CONSTANT words")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("CONSTANT references fold by value")
+  {
+    compile_opt("100 CONSTANT BASE 10 CONSTANT OFFSET BASE OFFSET +",
+                V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    CHECK(buf.word_count == 2);
+    CHECK(bytes(buf.data, buf.size) == folded(110));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("CONSTANT takes a folded expression")
+  {
+    compile_opt("2 3 + CONSTANT FIVE FIVE FIVE *", V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    REQUIRE(buf.word_count == 1);
+    std::vector<uint8_t> body;
+    push_lit(&body, 5);
+    body.push_back(op(Op::RET));
+    CHECK(bytes(buf.words[0].code, buf.words[0].code_len) == body);
+    CHECK(bytes(buf.data, buf.size) == folded(25));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Constants fold inside definitions")
+  {
+    compile_opt("8 CONSTANT W : AREA W W * ;", V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    REQUIRE(buf.word_count == 2);
+    std::vector<uint8_t> body;
+    push_lit(&body, 64);
+    body.push_back(op(Op::RET));
+    CHECK(bytes(buf.words[1].code, buf.words[1].code_len) == body);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Without folding, CONSTANT words are called")
+  {
+    compile_opt("100 CONSTANT BASE BASE 1 +", 0, &buf);
+    std::vector<uint8_t> expected = {op(Op::CALL), 0, 0};
+    push_lit(&expected, 1);
+    expected.push_back(op(Op::ADD));
+    expected.push_back(op(Op::RET));
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Constant folding: limits")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Division by zero is left to the VM")
+  {
+    compile_opt("1 0 /", V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    std::vector<uint8_t> expected;
+    push_lit(&expected, 1);
+    push_lit(&expected, 0);
+    expected.push_back(op(Op::DIV));
+    expected.push_back(op(Op::RET));
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Oversized shift counts are left to the VM")
+  {
+    compile_opt("1 32 LSHIFT", V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    CHECK(buf.size == 12);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Runtime values stop folding")
+  {
+    // DUP is not a constant, so only 2 3 + folds
+    compile_opt("DUP 2 3 + +", V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    std::vector<uint8_t> expected = {op(Op::DUP)};
+    push_lit(&expected, 5);
+    expected.push_back(op(Op::ADD));
+    expected.push_back(op(Op::RET));
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("No folding across a branch target")
+  {
+    // BEGIN marks a jump target between 5 and 3
+    compile_opt("5 BEGIN 3 + DUP UNTIL", V4FRONT_OPT_CONSTANT_FOLD, &buf);
+    std::vector<uint8_t> expected;
+    push_lit(&expected, 5);
+    push_lit(&expected, 3);
+    expected.push_back(op(Op::ADD));
+    expected.push_back(op(Op::DUP));
+    expected.insert(expected.end(), {op(Op::JZ), 0xF6, 0xFF, op(Op::RET)});
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Deep literal runs degrade gracefully")
+  {
+    // Only the newest MAX_FOLD_DEPTH literals are tracked: 3..10 fold to 52
+    compile_opt("1 2 3 4 5 6 7 8 9 10 + + + + + + + + +", V4FRONT_OPT_CONSTANT_FOLD,
+                &buf);
+    std::vector<uint8_t> expected;
+    push_lit(&expected, 1);
+    push_lit(&expected, 2);
+    push_lit(&expected, 52);
+    expected.insert(expected.end(), {op(Op::ADD), op(Op::ADD), op(Op::RET)});
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Works with compact literals")
+  {
+    compile_opt("3 4 < 2 2 -", V4FRONT_OPT_CONSTANT_FOLD | V4FRONT_OPT_COMPACT_LITERALS,
+                &buf);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::LITN1), op(Op::LIT0), op(Op::RET)});
+    v4front_free(&buf);
+  }
+}
@@ -1,5 +1,6 @@
 #define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdio>
 #include <cstring>
 
 #include "v4front/compile.h"
@@ -237,3 +238,48 @@ TEST_CASE("Stateful compiler: case insensitivity")
 
   v4front_context_destroy(ctx);
 }
+
+TEST_CASE("Stateful compiler: large dictionaries")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  char name[32];
+
+  SUBCASE("Thousands of registered words stay addressable")
+  {
+    for (int i = 0; i < 5000; i++)
+    {
+      snprintf(name, sizeof(name), "word%d", i);
+      REQUIRE(v4front_context_register_word(ctx, name, i) == 0);
+    }
+    CHECK(v4front_context_get_word_count(ctx) == 5000);
+
+    CHECK(v4front_context_find_word(ctx, "WORD0") == 0);
+    CHECK(v4front_context_find_word(ctx, "Word2500") == 2500);
+    CHECK(v4front_context_find_word(ctx, "word4999") == 4999);
+    CHECK(v4front_context_find_word(ctx, "word5000") == -1);
+    CHECK(strcmp(v4front_context_get_word_name(ctx, 1234), "word1234") == 0);
+
+    // Re-registering updates in place, regardless of case
+    REQUIRE(v4front_context_register_word(ctx, "WORD42", 9000) == 0);
+    CHECK(v4front_context_get_word_count(ctx) == 5000);
+    CHECK(v4front_context_find_word(ctx, "word42") == 9000);
+  }
+
+  SUBCASE("Reset then repopulate")
+  {
+    for (int i = 0; i < 100; i++)
+    {
+      snprintf(name, sizeof(name), "w%d", i);
+      v4front_context_register_word(ctx, name, i);
+    }
+    v4front_context_reset(ctx);
+    CHECK(v4front_context_find_word(ctx, "w1") == -1);
+
+    v4front_context_register_word(ctx, "w1", 7);
+    CHECK(v4front_context_get_word_count(ctx) == 1);
+    CHECK(v4front_context_find_word(ctx, "W1") == 7);
+  }
+
+  v4front_context_destroy(ctx);
+}
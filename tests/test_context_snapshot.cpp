@@ -0,0 +1,136 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+// VM word index that "W<n>" compiles to in main code ("W<n>" alone -> CALL idx, RET)
+static int called_index(V4FrontContext* ctx, const char* source)
+{
+  V4FrontBuf buf;
+  v4front_err err = v4front_compile_with_context(ctx, source, &buf, nullptr, 0);
+  if (err != FrontErr::OK)
+    return -1;
+  int idx = (buf.size == 4) ? (buf.data[1] | (buf.data[2] << 8)) : -1;
+  v4front_free(&buf);
+  return idx;
+}
+
+TEST_CASE("Snapshot: sees the words at the time it was taken")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "SQUARE", 3);
+  REQUIRE(err == FrontErr::OK);
+
+  V4FrontContext* snap = v4front_context_snapshot(ctx);
+  REQUIRE(snap != nullptr);
+  CHECK(v4front_context_get_word_count(snap) == 1);
+  CHECK(called_index(snap, "SQUARE") == 3);
+
+  // Writes after the snapshot are not visible in it
+  err = v4front_context_register_word(ctx, "CUBE", 4);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_context_register_word(ctx, "SQUARE", 9);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(called_index(ctx, "SQUARE") == 9);
+  CHECK(called_index(ctx, "CUBE") == 4);
+  CHECK(called_index(snap, "SQUARE") == 3);
+  CHECK(called_index(snap, "CUBE") == -1);
+  CHECK(v4front_context_find_word(snap, "square") == 3);
+
+  // Reset leaves the snapshot alone
+  v4front_context_reset(ctx);
+  CHECK(v4front_context_get_word_count(ctx) == 0);
+  CHECK(v4front_context_get_word_count(snap) == 1);
+  CHECK(strcmp(v4front_context_get_word_name(snap, 0), "SQUARE") == 0);
+
+  // The snapshot outlives its context
+  v4front_context_destroy(ctx);
+  CHECK(called_index(snap, "SQUARE") == 3);
+  v4front_context_destroy(snap);
+}
+
+TEST_CASE("Snapshot: is read-only")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  V4FrontContext* snap = v4front_context_snapshot(ctx);
+  REQUIRE(snap != nullptr);
+
+  v4front_err err = v4front_context_register_word(snap, "X", 0);
+  CHECK(err == FrontErr::ReadOnlyContext);
+  CHECK(v4front_context_get_word_count(snap) == 0);
+
+  // A snapshot of a snapshot shares the same words and is read-only too
+  V4FrontContext* again = v4front_context_snapshot(snap);
+  REQUIRE(again != nullptr);
+  err = v4front_context_register_word(again, "X", 0);
+  CHECK(err == FrontErr::ReadOnlyContext);
+
+  v4front_context_destroy(snap);
+  v4front_context_destroy(again);
+  v4front_context_destroy(ctx);
+  CHECK(v4front_context_snapshot(nullptr) == nullptr);
+}
+
+TEST_CASE("Snapshot: parallel compilation against one snapshot")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  for (int i = 0; i < 200; i++)
+  {
+    std::string name = "W" + std::to_string(i);
+    v4front_err err = v4front_context_register_word(ctx, name.c_str(), i);
+    REQUIRE(err == FrontErr::OK);
+  }
+  V4FrontContext* base = v4front_context_snapshot(ctx);
+  REQUIRE(base != nullptr);
+
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++)
+  {
+    threads.emplace_back(
+        [&, t]()
+        {
+          // Every thread also takes and drops its own references
+          for (int i = 0; i < 200; i++)
+          {
+            V4FrontContext* mine = v4front_context_snapshot(base);
+            std::string source = "W" + std::to_string((i + t) % 200);
+            if (!mine || called_index(mine, source.c_str()) != (i + t) % 200)
+              mismatches++;
+            v4front_context_destroy(mine);
+          }
+        });
+  }
+
+  // The writer keeps publishing new versions meanwhile
+  for (int i = 200; i < 400; i++)
+  {
+    std::string name = "W" + std::to_string(i);
+    v4front_err err = v4front_context_register_word(ctx, name.c_str(), i);
+    REQUIRE(err == FrontErr::OK);
+    V4FrontContext* published = v4front_context_snapshot(ctx);
+    REQUIRE(published != nullptr);
+    v4front_context_destroy(published);
+  }
+
+  for (std::thread& thread : threads)
+    thread.join();
+  CHECK(mismatches.load() == 0);
+  CHECK(v4front_context_get_word_count(base) == 200);
+  CHECK(v4front_context_get_word_count(ctx) == 400);
+
+  v4front_context_destroy(base);
+  v4front_context_destroy(ctx);
+}
@@ -0,0 +1,131 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Compile source with the given flags and return the code of word 0
+static std::vector<uint8_t> word_code(const char* source, uint32_t flags)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, &buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+  REQUIRE(buf.word_count >= 1);
+  std::vector<uint8_t> code(buf.words[0].code, buf.words[0].code + buf.words[0].code_len);
+  v4front_free(&buf);
+  return code;
+}
+
+static const uint32_t kCounted = V4FRONT_OPT_COUNTED_LOOPS;
+
+TEST_CASE("Counted loops: literal bounds use a down-counter")
+{
+  SUBCASE("Body without I")
+  {
+    std::vector<uint8_t> expected = {
+        op(Op::LIT),   100,          0,           0,           0,  // 0: trip count
+        op(Op::TOR),                                               // 5
+        op(Op::LIT),   7,            0,           0,           0,  // 6: body
+        op(Op::SYS),                                               // 11
+        op(Op::FROMR), op(Op::DEC),  op(Op::DUP), op(Op::TOR),     // 12
+        op(Op::JNZ),   0xF3,         0xFF,                         // 16: -> 6
+        op(Op::FROMR), op(Op::DROP), op(Op::RET),
+    };
+    CHECK(word_code(": P 100 0 DO 7 SYS LOOP ;", kCounted) == expected);
+  }
+
+  SUBCASE("I is limit minus counter")
+  {
+    std::vector<uint8_t> code = word_code(": R 10 2 DO I DROP LOOP ;", kCounted);
+    REQUIRE(code.size() == 24);
+    CHECK(code[0] == op(Op::LIT));
+    CHECK(code[1] == 8);  // 10 - 2 iterations
+    std::vector<uint8_t> index = {op(Op::LIT), 10, 0, 0, 0, op(Op::RFETCH), op(Op::SUB)};
+    CHECK(std::vector<uint8_t>(code.begin() + 6, code.begin() + 13) == index);
+  }
+
+  SUBCASE("Folded bounds count as literals")
+  {
+    std::vector<uint8_t> code =
+        word_code(": F 50 2 * 0 DO 7 SYS LOOP ;", kCounted | V4FRONT_OPT_CONSTANT_FOLD);
+    CHECK(code == word_code(": P 100 0 DO 7 SYS LOOP ;", kCounted));
+  }
+
+  SUBCASE("Compact literals apply to the counter")
+  {
+    std::vector<uint8_t> code =
+        word_code(": P 100 0 DO 7 SYS LOOP ;", kCounted | V4FRONT_OPT_COMPACT_LITERALS);
+    CHECK(code[0] == op(Op::LIT));
+    CHECK(code[5] == op(Op::TOR));
+  }
+}
+
+TEST_CASE("Counted loops: tiny loops are unrolled")
+{
+  SUBCASE("Within the budget")
+  {
+    std::vector<uint8_t> expected = {
+        op(Op::DUP), op(Op::ADD), op(Op::DUP), op(Op::ADD), op(Op::DUP),
+        op(Op::ADD), op(Op::DUP), op(Op::ADD), op(Op::RET),
+    };
+    CHECK(word_code(": Q 4 0 DO DUP + LOOP ;", kCounted) == expected);
+  }
+
+  SUBCASE("Bodies with branches keep their relative jumps")
+  {
+    std::vector<uint8_t> code = word_code(": B 2 0 DO DUP IF 1 - THEN LOOP ;", kCounted);
+    std::vector<uint8_t> body = {op(Op::DUP), op(Op::JZ), 6, 0, op(Op::LIT), 1, 0, 0,
+                                 0,           op(Op::SUB)};
+    std::vector<uint8_t> expected = body;
+    expected.insert(expected.end(), body.begin(), body.end());
+    expected.push_back(op(Op::RET));
+    CHECK(code == expected);
+  }
+
+  SUBCASE("Over the budget or reading I")
+  {
+    CHECK(word_code(": Q 40 0 DO DUP + LOOP ;", kCounted).size() == 18);
+    CHECK(word_code(": I2 2 0 DO I DROP LOOP ;", kCounted)[5] == op(Op::TOR));
+  }
+}
+
+TEST_CASE("Counted loops: general lowering is kept when needed")
+{
+  const char* sources[] = {
+      ": A 10 0 DO J DROP LOOP ;",               // J reads the return stack layout
+      ": B 10 0 DO I 5 = IF LEAVE THEN LOOP ;",  // LEAVE
+      ": C 10 0 DO 2 +LOOP ;",                   // +LOOP
+      ": D 10 0 DO R@ DROP LOOP ;",              // Explicit R@
+      ": E 0 10 DO 1 DROP LOOP ;",               // Runs once (limit <= start)
+      ": G DUP 0 DO 1 DROP LOOP ;",              // Non-literal bound
+  };
+  for (const char* source : sources)
+  {
+    CAPTURE(source);
+    CHECK(word_code(source, kCounted) == word_code(source, 0));
+  }
+}
+
+TEST_CASE("Counted loops: nested loops")
+{
+  // LEAVE in the inner loop only disqualifies the inner loop
+  std::vector<uint8_t> code = word_code(": U 3 0 DO 1 0 DO LEAVE LOOP LOOP ;", kCounted);
+  CHECK(code[0] == op(Op::LIT));
+  CHECK(code[1] == 3);
+  CHECK(code[5] == op(Op::TOR));
+  CHECK(code[16] == op(Op::SWAP));  // Inner loop: SWAP >R >R
+}
@@ -0,0 +1,121 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "program_gen.hpp"
+#include "v4/vm_api.h"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+// Programs per run; V4FRONT_DIFF_PROGRAMS overrides it for longer soaks
+static const uint32_t kDefaultPrograms = 500;
+
+static uint32_t program_count()
+{
+  const char* env = getenv("V4FRONT_DIFF_PROGRAMS");
+  return env && atoi(env) > 0 ? static_cast<uint32_t>(atoi(env)) : kDefaultPrograms;
+}
+
+// Result of one run: the VM error and the data stack, bottom first
+struct Outcome
+{
+  v4_err err;
+  std::vector<v4_i32> stack;
+
+  bool operator==(const Outcome& o) const { return err == o.err && stack == o.stack; }
+};
+
+// A compiler configuration compared with -O0
+struct Config
+{
+  const char* name;
+  uint32_t opt_level;
+  uint32_t flags;
+};
+
+static const Config kConfigs[] = {
+    {"-O1", 1, 0},
+    {"-O2", 2, 0},
+    {"-O0 + LOOP_LOCALS", 0, V4FRONT_OPT_LOOP_LOCALS},
+    {"-O2 + LOOP_LOCALS", 2, V4FRONT_OPT_LOOP_LOCALS},
+};
+
+// Compile source with opt_level and flags and run it on a fresh VM
+static bool run(const std::string& source, uint32_t opt_level, uint32_t flags,
+                Outcome* out)
+{
+  V4FrontCompileOptions options = {};
+  options.opt_level = opt_level;
+  options.flags = flags;
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err =
+      v4front_compile_with_options(nullptr, source.c_str(), &options, &buf, &error);
+  INFO("-O" << opt_level << " flags " << flags << ": " << error.message);
+  REQUIRE(err == FrontErr::OK);
+  if (err != FrontErr::OK)
+    return false;
+  err = v4front_verify_bytecode(&buf, 0, nullptr);
+  CHECK(err == FrontErr::OK);
+
+  uint8_t ram[4096] = {0};
+  VmConfig cfg = {ram, sizeof(ram), nullptr, 0};
+  struct Vm* vm = vm_create(&cfg);
+  REQUIRE(vm != nullptr);
+
+  // Words get VM indices 0..word_count-1, as their CALL operands expect
+  bool ok = true;
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    int idx = vm_register_word(vm, buf.words[i].name, buf.words[i].code,
+                               static_cast<int>(buf.words[i].code_len));
+    CHECK(idx == i);
+    ok = ok && idx == i;
+  }
+  int main_idx = vm_register_word(vm, "main", buf.data, static_cast<int>(buf.size));
+  struct Word* entry = ok && main_idx >= 0 ? vm_get_word(vm, main_idx) : nullptr;
+  CHECK(entry != nullptr);
+  if (entry)
+  {
+    out->err = vm_exec(vm, entry);
+    int depth = vm_ds_depth_public(vm);
+    out->stack.clear();
+    for (int i = depth - 1; i >= 0; i--)
+      out->stack.push_back(vm_ds_peek_public(vm, i));
+  }
+
+  vm_destroy(vm);
+  v4front_free(&buf);
+  return entry != nullptr;
+}
+
+TEST_CASE("Differential: every configuration agrees with -O0 on random programs")
+{
+  const uint32_t count = program_count();
+  uint32_t mismatches = 0;
+  for (uint32_t seed = 1; seed <= count && mismatches < 10; seed++)
+  {
+    std::string source = gen::random_program(seed);
+    INFO("seed " << seed << ": " << source);
+    Outcome base;
+    if (!run(source, 0, 0, &base))
+      continue;
+    CHECK(base.err == 0);  // Generated programs are always well defined
+
+    for (const Config& config : kConfigs)
+    {
+      Outcome opt;
+      if (!run(source, config.opt_level, config.flags, &opt))
+        continue;
+      INFO(config.name);
+      CHECK(opt == base);
+      if (!(opt == base))
+        mismatches++;
+    }
+  }
+}
@@ -5,10 +5,12 @@
 #define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 
+#include <climits>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include "v4front/disasm.h"
 #include "v4front/disasm.hpp"
 #include "vendor/doctest/doctest.h"
 
@@ -209,4 +211,135 @@ TEST_CASE("disasm: PC advancing across mixed sizes")
   expect_contains_all(lines[1], {"ADD"});
   expect_contains_all(lines[2], {"JMP", "-1", " ; -> "});
   expect_contains_all(lines[3], {"RET"});
-}
\ No newline at end of file
+}
+/**
+ * @test C API: disasm_count agrees with disasm_all, disasm_one writes a C string.
+ */
+TEST_CASE("disasm: C API")
+{
+  std::vector<uint8_t> bc;
+  bc.push_back(static_cast<uint8_t>(OP_LIT));
+  append_i32(bc, 42);
+  bc.push_back(static_cast<uint8_t>(OP_ADD));
+  bc.push_back(static_cast<uint8_t>(OP_JMP));
+  append_i16(bc, -1);
+  bc.push_back(static_cast<uint8_t>(OP_RET));
+
+  CHECK(v4front_disasm_count(bc.data(), bc.size()) == 4);
+  CHECK(v4front_disasm_count(bc.data(), 3) == 1);  // Truncated LIT
+  CHECK(v4front_disasm_count(nullptr, 4) == 0);
+  CHECK(v4front_disasm_count(bc.data(), 0) == 0);
+
+  char line[64];
+  CHECK(v4front_disasm_one(bc.data(), bc.size(), 0, line, sizeof(line)) == 5);
+  CHECK(std::string(line) == disasm_all(bc.data(), bc.size())[0]);
+  CHECK(v4front_disasm_one(bc.data(), bc.size(), 6, line, 4) == 3);
+  CHECK(std::string(line) == "000");  // Truncated to the buffer
+  CHECK(v4front_disasm_one(nullptr, 4, 0, line, sizeof(line)) == 0);
+  v4front_disasm_print(nullptr, 4, stdout);  // No-op
+}
+
+/**
+ * @test Exact line format, including negative, and extreme immediates.
+ */
+TEST_CASE("disasm: exact line format")
+{
+  std::vector<uint8_t> bc;
+  bc.push_back(static_cast<uint8_t>(OP_LIT));
+  append_i32(bc, INT32_MIN);
+  bc.push_back(static_cast<uint8_t>(OP_JZ));
+  append_i16(bc, 4);
+  bc.push_back(static_cast<uint8_t>(OP_JMP));
+  append_i16(bc, -5);
+  bc.push_back(static_cast<uint8_t>(OP_CALL));
+  append_i16(bc, -1);
+  bc.push_back(static_cast<uint8_t>(OP_DUP));
+
+  auto lines = disasm_all(bc.data(), bc.size());
+  REQUIRE(lines.size() == 5);
+  CHECK(lines[0] == "0000: LIT      -2147483648");
+  CHECK(lines[1] == "0005: JZ       +4 ; -> 000c");
+  CHECK(lines[2] == "0008: JMP      -5 ; -> 0006");
+  CHECK(lines[3] == "000b: CALL     @-1");
+  CHECK(lines[4] == "000e: DUP     ");
+}
+
+/**
+ * @test decode() fills POD instructions and resumes where a full array stopped.
+ */
+TEST_CASE("disasm: structured decode")
+{
+  std::vector<uint8_t> bc;
+  bc.push_back(static_cast<uint8_t>(OP_LIT));
+  append_i32(bc, -7);
+  bc.push_back(static_cast<uint8_t>(OP_JNZ));
+  append_i16(bc, -3);
+  bc.push_back(0xFF);  // Unknown opcode
+  bc.push_back(static_cast<uint8_t>(OP_LIT));
+  bc.push_back(0x01);  // Truncated
+
+  v4front::DecodedInsn insns[2];
+  size_t n = v4front::decode(bc.data(), bc.size(), 0, insns, 2);
+  REQUIRE(n == 2);
+  CHECK(insns[0].pc == 0);
+  CHECK(insns[0].opcode == OP_LIT);
+  CHECK(insns[0].imm_kind == v4front::ImmKind::I32);
+  CHECK(insns[0].imm == -7);
+  CHECK(insns[0].length == 5);
+  CHECK_FALSE(insns[0].truncated);
+  CHECK(insns[1].pc == 5);
+  CHECK(insns[1].imm_kind == v4front::ImmKind::Rel16);
+  CHECK(insns[1].imm == -3);
+  CHECK(insns[1].length == 3);
+
+  // Resume after the last decoded instruction
+  n = v4front::decode(bc.data(), bc.size(), insns[1].pc + insns[1].length, insns, 2);
+  REQUIRE(n == 2);
+  CHECK(insns[0].pc == 8);
+  CHECK(insns[0].imm_kind == v4front::ImmKind::None);
+  CHECK(insns[0].length == 1);
+  CHECK(std::string(v4front::op_info(insns[0].opcode).name) == "???");
+  CHECK(insns[1].pc == 9);
+  CHECK(insns[1].truncated);
+  CHECK(insns[1].length == 2);  // The rest of the buffer
+  CHECK(v4front::decode(bc.data(), bc.size(), bc.size(), insns, 2) == 0);
+
+  CHECK(std::string(v4front::op_info(OP_ADD).name) == "ADD");
+  CHECK(v4front::op_info(OP_CALL).imm == v4front::ImmKind::Idx16);
+}
+
+/**
+ * @test format_insn() writes disasm_one()'s line and truncates like snprintf.
+ */
+TEST_CASE("disasm: format_insn")
+{
+  std::vector<uint8_t> bc;
+  bc.push_back(static_cast<uint8_t>(OP_LIT));
+  append_i32(bc, 123456);
+  bc.push_back(static_cast<uint8_t>(OP_JMP));
+  append_i16(bc, 0);
+  bc.push_back(static_cast<uint8_t>(OP_CALL));
+  bc.push_back(0x02);
+
+  size_t pc = 0;
+  v4front::DecodedInsn insn;
+  while (size_t used = v4front::decode_one(bc.data(), bc.size(), pc, insn))
+  {
+    std::string expected;
+    disasm_one(bc.data(), bc.size(), pc, expected);
+    char line[v4front::kDisasmLineMax];
+    CHECK(v4front::format_insn(insn, line, sizeof(line)) == expected.size());
+    CHECK(std::string(line) == expected);
+
+    char small[6];
+    CHECK(v4front::format_insn(insn, small, sizeof(small)) == expected.size());
+    CHECK(std::string(small) == expected.substr(0, 5));
+    pc += used;
+  }
+  CHECK(pc == bc.size());
+
+  char none[1] = {'x'};
+  v4front::decode_one(bc.data(), bc.size(), 0, insn);
+  CHECK(v4front::format_insn(insn, none, 0) == 21);  // "0000: LIT      123456"
+  CHECK(none[0] == 'x');
+}
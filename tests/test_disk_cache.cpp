@@ -0,0 +1,283 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "v4front/image.h"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+namespace fs = std::filesystem;
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+// Fresh, empty cache directory for one test
+struct CacheDir
+{
+  fs::path path;
+
+  explicit CacheDir(const char* name)
+  {
+    std::error_code ec;
+    path = fs::temp_directory_path(ec) / name;
+    fs::remove_all(path, ec);
+    fs::create_directories(path, ec);
+  }
+
+  ~CacheDir()
+  {
+    std::error_code ec;
+    fs::remove_all(path, ec);
+  }
+
+  // Files in the directory with the given extension
+  std::vector<fs::path> files(const char* extension) const
+  {
+    std::vector<fs::path> found;
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(path, ec))
+    {
+      if (entry.path().extension() == extension)
+        found.push_back(entry.path());
+    }
+    return found;
+  }
+};
+
+static std::vector<uint8_t> compile(V4FrontContext* ctx, const std::string& source,
+                                    const V4FrontCompileOptions* options)
+{
+  V4FrontBuf buf;
+  v4front_err err =
+      v4front_compile_with_options(ctx, source.c_str(), options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> out = flatten(buf);
+  v4front_free(&buf);
+  return out;
+}
+
+static void write_file(const fs::path& path, const uint8_t* data, size_t size)
+{
+  FILE* f = fopen(path.string().c_str(), "wb");
+  REQUIRE(f != nullptr);
+  CHECK(fwrite(data, 1, size, f) == size);
+  fclose(f);
+}
+
+static std::vector<uint8_t> read_file(const fs::path& path)
+{
+  std::vector<uint8_t> data(fs::file_size(path));
+  FILE* f = fopen(path.string().c_str(), "rb");
+  REQUIRE(f != nullptr);
+  CHECK(fread(data.data(), 1, data.size(), f) == data.size());
+  fclose(f);
+  return data;
+}
+
+// Magic, version, source length and SHA-256 in front of each stored image
+static const size_t kEntryHeaderSize = 48;
+
+static const char* kSource = ": SQUARE DUP * ;\n: CUBE DUP SQUARE * ;\n3 CUBE SQUARE";
+
+TEST_CASE("Disk cache: a miss is stored, a hit is loaded")
+{
+  CacheDir dir("v4front-test-disk-cache-hit");
+  std::string dir_name = dir.path.string();
+  V4FrontCompileOptions options = {};
+  options.opt_level = 2;
+  std::vector<uint8_t> expected = compile(nullptr, kSource, &options);
+
+  options.cache_dir = dir_name.c_str();
+  CHECK(compile(nullptr, kSource, &options) == expected);
+  std::vector<fs::path> files = dir.files(".v4c");
+  REQUIRE(files.size() == 1);
+  CHECK(files[0].stem().string().size() == 32);
+  CHECK(dir.files(".tmp").empty());
+
+  SUBCASE("The second compilation reads the file")
+  {
+    CHECK(compile(nullptr, kSource, &options) == expected);
+    CHECK(dir.files(".v4c").size() == 1);
+
+    // Proof that the file is what is returned: keep its entry header (the
+    // source length and digest) and replace the output after it
+    std::vector<uint8_t> entry = read_file(files[0]);
+    REQUIRE(entry.size() > kEntryHeaderSize);
+    V4FrontImage other;
+    v4front_err err = v4front_compile_image(nullptr, "99", nullptr, &other, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    entry.resize(kEntryHeaderSize);
+    entry.insert(entry.end(), other.data, other.data + other.size);
+    write_file(files[0], entry.data(), entry.size());
+    V4FrontBuf buf;
+    err = v4front_compile_with_options(nullptr, kSource, &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    uint32_t main_size;
+    const uint8_t* main_code = v4front_image_main(other.data, &main_size);
+    CHECK(std::vector<uint8_t>(buf.data, buf.data + buf.size) ==
+          std::vector<uint8_t>(main_code, main_code + main_size));
+    CHECK(buf.word_count == 0);
+    v4front_free(&buf);
+    v4front_image_free(&other);
+  }
+
+  SUBCASE("A damaged file is a miss and gets replaced")
+  {
+    const uint8_t junk[3] = {'V', '4', 'I'};
+    write_file(files[0], junk, sizeof(junk));
+    CHECK(compile(nullptr, kSource, &options) == expected);
+    CHECK(fs::file_size(files[0]) > sizeof(junk));
+    CHECK(compile(nullptr, kSource, &options) == expected);
+  }
+}
+
+TEST_CASE("Disk cache: the key covers options, context and source")
+{
+  CacheDir dir("v4front-test-disk-cache-key");
+  std::string dir_name = dir.path.string();
+  V4FrontCompileOptions options = {};
+  options.cache_dir = dir_name.c_str();
+
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 40);
+  REQUIRE(err == FrontErr::OK);
+
+  compile(ctx, "HOST 1", &options);
+  compile(ctx, "HOST 2", &options);
+  CHECK(dir.files(".v4c").size() == 2);
+
+  // The VM index of a context word is part of the output
+  err = v4front_context_register_word(ctx, "host", 41);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> out = compile(ctx, "HOST 1", &options);
+  CHECK(out[1] == 41);
+  CHECK(dir.files(".v4c").size() == 3);
+
+  options.flags = V4FRONT_OPT_COMPACT_LITERALS;
+  CHECK(compile(ctx, "HOST 1", &options) != out);
+  CHECK(dir.files(".v4c").size() == 4);
+
+  // Errors are not cached
+  V4FrontBuf buf;
+  err = v4front_compile_with_options(ctx, "NOPE", &options, &buf, nullptr);
+  CHECK(err == FrontErr::UnknownToken);
+  CHECK(dir.files(".v4c").size() == 4);
+
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Disk cache: different sources never share an entry")
+{
+  CacheDir dir("v4front-test-disk-cache-collide");
+  std::string dir_name = dir.path.string();
+  V4FrontCompileOptions options = {};
+  options.cache_dir = dir_name.c_str();
+
+  // Same length, so only the digest tells them apart
+  const char* a = ": F 1 2 + ; F";
+  const char* b = ": F 1 3 + ; F";
+  std::vector<uint8_t> expected_a = compile(nullptr, a, nullptr);
+  std::vector<uint8_t> expected_b = compile(nullptr, b, nullptr);
+  REQUIRE(expected_a != expected_b);
+
+  CHECK(compile(nullptr, a, &options) == expected_a);
+  std::vector<fs::path> files = dir.files(".v4c");
+  REQUIRE(files.size() == 1);
+  fs::path file_a = files[0];
+  CHECK(compile(nullptr, b, &options) == expected_b);
+  files = dir.files(".v4c");
+  REQUIRE(files.size() == 2);
+  fs::path file_b = files[0] == file_a ? files[1] : files[0];
+
+  // A key collision: b's file name holding a's entry. The header does not
+  // match b, so it is a miss and b's output replaces it.
+  std::vector<uint8_t> entry_a = read_file(file_a);
+  write_file(file_b, entry_a.data(), entry_a.size());
+  CHECK(compile(nullptr, b, &options) == expected_b);
+  CHECK(read_file(file_b) != entry_a);
+  CHECK(compile(nullptr, b, &options) == expected_b);
+  CHECK(compile(nullptr, a, &options) == expected_a);
+
+  // Likewise for a source of another length
+  const char* c = ": F 1 2 + ; F F";
+  std::vector<uint8_t> expected_c = compile(nullptr, c, nullptr);
+  compile(nullptr, c, &options);
+  files = dir.files(".v4c");
+  REQUIRE(files.size() == 3);
+  for (const fs::path& file : files)
+  {
+    if (file != file_a && file != file_b)
+      write_file(file, entry_a.data(), entry_a.size());
+  }
+  CHECK(compile(nullptr, c, &options) == expected_c);
+}
+
+TEST_CASE("Disk cache: a missing directory is a miss")
+{
+  V4FrontCompileOptions options = {};
+  options.cache_dir = "/nonexistent/v4front-cache";
+  CHECK(compile(nullptr, kSource, &options) == compile(nullptr, kSource, nullptr));
+}
+
+TEST_CASE("Disk cache: concurrent writers and readers")
+{
+  CacheDir dir("v4front-test-disk-cache-threads");
+  std::string dir_name = dir.path.string();
+  std::vector<std::string> sources;
+  std::vector<std::vector<uint8_t>> expected;
+  for (int i = 0; i < 4; i++)
+  {
+    sources.push_back(": W" + std::to_string(i) + " " + std::to_string(i) + " + ;\n" +
+                      std::to_string(i) + " W" + std::to_string(i));
+    expected.push_back(compile(nullptr, sources.back(), nullptr));
+  }
+
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++)
+  {
+    threads.emplace_back(
+        [&, t]()
+        {
+          V4FrontCompileOptions options = {};
+          options.cache_dir = dir_name.c_str();
+          for (int i = 0; i < 40; i++)
+          {
+            size_t s = (i + t) % sources.size();
+            V4FrontBuf buf;
+            v4front_err err = v4front_compile_with_options(nullptr, sources[s].c_str(),
+                                                           &options, &buf, nullptr);
+            if (err != FrontErr::OK || flatten(buf) != expected[s])
+              mismatches++;
+            v4front_free(&buf);
+          }
+        });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  CHECK(mismatches.load() == 0);
+  CHECK(dir.files(".v4c").size() == sources.size());
+  CHECK(dir.files(".tmp").empty());
+}
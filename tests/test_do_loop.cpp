@@ -1,6 +1,8 @@
 #define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <cstring>
+#include <utility>
+#include <vector>
 
 #include "v4/opcodes.hpp"
 #include "v4front/compile.h"
@@ -112,7 +114,16 @@ TEST_CASE("Nested DO LOOP structures")
         v4front_compile("3 0 DO 3 0 DO I J + LOOP LOOP", &buf, errmsg, sizeof(errmsg));
     CHECK(err == FrontErr::OK);
 
-    // Should contain code for J (3 FROMR, DUP, 3 TOR)
+    // J: R> R> R@ SWAP >R SWAP >R (the inner pair goes back under the copy)
+    const uint8_t j_code[] = {
+        static_cast<uint8_t>(Op::FROMR), static_cast<uint8_t>(Op::FROMR),
+        static_cast<uint8_t>(Op::RFETCH), static_cast<uint8_t>(Op::SWAP),
+        static_cast<uint8_t>(Op::TOR),   static_cast<uint8_t>(Op::SWAP),
+        static_cast<uint8_t>(Op::TOR)};
+    bool found = false;
+    for (size_t i = 0; !found && i + sizeof(j_code) <= buf.size; i++)
+      found = memcmp(buf.data + i, j_code, sizeof(j_code)) == 0;
+    CHECK(found);
     v4front_free(&buf);
   }
 
@@ -468,4 +479,140 @@ TEST_CASE("LEAVE case insensitivity")
     CHECK(err == FrontErr::OK);
     v4front_free(&buf);
   }
-}
\ No newline at end of file
+}
+// Run main code from the default (-O0) output: just the opcodes DO/LOOP/+LOOP
+// and I compile to. Returns false on any other opcode or a runaway loop.
+static bool run_loop_code(const V4FrontBuf& buf, std::vector<int32_t>* ds)
+{
+  std::vector<int32_t> rs;
+  uint32_t pc = 0;
+  for (int steps = 0; steps < 100000 && pc < buf.size; steps++)
+  {
+    uint8_t op = buf.data[pc++];
+    int32_t a, b;
+    switch (static_cast<Op>(op))
+    {
+      case Op::LIT:
+        memcpy(&a, buf.data + pc, 4);  // Little-endian host
+        pc += 4;
+        ds->push_back(a);
+        break;
+      case Op::DUP:
+        ds->push_back(ds->back());
+        break;
+      case Op::DROP:
+        ds->pop_back();
+        break;
+      case Op::SWAP:
+        std::swap((*ds)[ds->size() - 1], (*ds)[ds->size() - 2]);
+        break;
+      case Op::OVER:
+        ds->push_back((*ds)[ds->size() - 2]);
+        break;
+      case Op::TOR:
+        rs.push_back(ds->back());
+        ds->pop_back();
+        break;
+      case Op::FROMR:
+        ds->push_back(rs.back());
+        rs.pop_back();
+        break;
+      case Op::RFETCH:
+        ds->push_back(rs.back());
+        break;
+      case Op::INC:
+        ds->back()++;
+        break;
+      case Op::ADD:
+      case Op::LT:
+        b = ds->back();
+        ds->pop_back();
+        a = ds->back();
+        ds->back() = op == static_cast<uint8_t>(Op::ADD) ? a + b : (a < b ? -1 : 0);
+        break;
+      case Op::JMP:
+      case Op::JZ:
+      {
+        int16_t rel = static_cast<int16_t>(buf.data[pc] | (buf.data[pc + 1] << 8));
+        pc += 2;
+        if (op == static_cast<uint8_t>(Op::JZ))
+        {
+          a = ds->back();
+          ds->pop_back();
+          if (a != 0)
+            break;
+        }
+        pc += rel;
+        break;
+      }
+      case Op::RET:
+        return rs.empty();
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
+static std::vector<int32_t> run_loop(const char* source)
+{
+  V4FrontBuf buf;
+  char errmsg[256];
+  v4front_err err = v4front_compile(source, &buf, errmsg, sizeof(errmsg));
+  REQUIRE_MESSAGE(err == FrontErr::OK, errmsg);
+  std::vector<int32_t> ds;
+  CHECK_MESSAGE(run_loop_code(buf, &ds), source);
+  v4front_free(&buf);
+  return ds;
+}
+
+TEST_CASE("LOOP and +LOOP run with the right index and trip count")
+{
+  using Stack = std::vector<int32_t>;
+
+  SUBCASE("LOOP: trip count")
+  {
+    CHECK(run_loop("0 10 0 DO 1+ LOOP") == Stack{10});
+    CHECK(run_loop("0 1 0 DO 1+ LOOP") == Stack{1});
+    CHECK(run_loop("0 7 3 DO 1+ LOOP") == Stack{4});
+    CHECK(run_loop("0 -2 -5 DO 1+ LOOP") == Stack{3});
+  }
+
+  SUBCASE("LOOP: index at each step")
+  {
+    CHECK(run_loop("5 0 DO I LOOP") == Stack{0, 1, 2, 3, 4});
+    CHECK(run_loop("13 10 DO I LOOP") == Stack{10, 11, 12});
+    CHECK(run_loop("0 -3 DO I LOOP") == Stack{-3, -2, -1});
+  }
+
+  SUBCASE("+LOOP: trip count")
+  {
+    CHECK(run_loop("0 10 0 DO 1+ 2 +LOOP") == Stack{5});
+    CHECK(run_loop("0 10 0 DO 1+ 3 +LOOP") == Stack{4});
+    CHECK(run_loop("0 10 0 DO 1+ 20 +LOOP") == Stack{1});
+  }
+
+  SUBCASE("+LOOP: index at each step")
+  {
+    CHECK(run_loop("10 0 DO I 3 +LOOP") == Stack{0, 3, 6, 9});
+    CHECK(run_loop("20 5 DO I 5 +LOOP") == Stack{5, 10, 15});
+    CHECK(run_loop("4 0 DO I 1 +LOOP") == Stack{0, 1, 2, 3});
+  }
+
+  SUBCASE("Nested loops keep their own index")
+  {
+    CHECK(run_loop("3 0 DO 2 0 DO I LOOP LOOP") == Stack{0, 1, 0, 1, 0, 1});
+    CHECK(run_loop("0 3 0 DO 4 0 DO 1+ 2 +LOOP LOOP") == Stack{6});
+  }
+
+  SUBCASE("J and K read the outer indices and keep the return stack")
+  {
+    CHECK(run_loop("3 0 DO 2 0 DO J LOOP LOOP") == Stack{0, 0, 1, 1, 2, 2});
+    CHECK(run_loop("0 3 0 DO 4 0 DO J + LOOP LOOP") == Stack{12});
+    CHECK(run_loop("13 10 DO 2 0 DO I J + LOOP LOOP") == Stack{10, 11, 11, 12, 12, 13});
+    CHECK(run_loop("2 0 DO 2 0 DO 2 0 DO K J I LOOP LOOP LOOP") ==
+          Stack{0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 1, 1, 1, 0, 1, 1, 1});
+    CHECK(run_loop("0 3 0 DO 2 0 DO 2 0 DO K + LOOP LOOP LOOP") == Stack{12});
+    CHECK(run_loop("0 6 0 DO 3 0 DO J + 2 +LOOP 3 +LOOP") == Stack{6});
+  }
+}
@@ -335,3 +335,108 @@ TEST_CASE("Error position tracking: complex multiline source")
     v4front_free(&buf);
   }
 }
+
+TEST_CASE("Error position tracking: every error in one pass")
+{
+  V4FrontBuf buf;
+  V4FrontError errors[8];
+  uint32_t count = 0;
+
+  SUBCASE("Recovery after the next ;")
+  {
+    const char* source =
+        ": SQ DUP * ;\n"
+        ": BAD1 1 FOO + ;\n"
+        ": OK2 SQ ;\n"
+        ": BAD2 THEN ;\n"
+        "5 OK2 BAR ; 6\n"
+        ": OPEN 1 IF";
+    v4front_err err =
+        v4front_compile_all_errors(nullptr, source, strlen(source), nullptr, &buf, errors,
+                                   8, &count);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(buf.data == nullptr);
+    REQUIRE(count == 4);
+
+    CHECK(errors[0].code == front_err_to_int(FrontErr::UnknownToken));
+    CHECK(errors[0].line == 2);
+    CHECK(errors[0].column == 10);
+    CHECK(strcmp(errors[0].token, "FOO") == 0);
+    CHECK(strcmp(errors[0].context, ": BAD1 1 FOO + ;") == 0);
+
+    CHECK(errors[1].code == front_err_to_int(FrontErr::ThenWithoutIf));
+    CHECK(errors[1].line == 4);
+    CHECK(errors[1].column == 8);
+
+    CHECK(errors[2].code == front_err_to_int(FrontErr::UnknownToken));
+    CHECK(errors[2].line == 5);
+    CHECK(strcmp(errors[2].token, "BAR") == 0);
+
+    // Open at the end of the source
+    CHECK(errors[3].code == front_err_to_int(FrontErr::UnclosedIf));
+    CHECK(errors[3].position == static_cast<int>(strlen(source)));
+    CHECK(errors[3].line == 6);
+    CHECK(strcmp(errors[3].context, ": OPEN 1 IF") == 0);
+
+    // The first error is the one v4front_compile_ex reports
+    V4FrontError first;
+    err = v4front_compile_ex(source, &buf, &first);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(first.position == errors[0].position);
+    CHECK(first.line == errors[0].line);
+    CHECK(first.column == errors[0].column);
+    CHECK(strcmp(first.context, errors[0].context) == 0);
+  }
+
+  SUBCASE("No ; after an error ends the pass")
+  {
+    const char* source = "1 FOO 2\n: A 1 ;\nBAR ( never closed";
+    v4front_err err =
+        v4front_compile_all_errors(nullptr, source, strlen(source), nullptr, &buf, errors,
+                                   8, &count);
+    CHECK(err == FrontErr::UnknownToken);
+    REQUIRE(count == 2);
+    CHECK(errors[1].line == 3);
+    CHECK(strcmp(errors[1].token, "BAR") == 0);
+  }
+
+  SUBCASE("Clean sources compile as usual")
+  {
+    const char* source = ": SQ DUP * ;\n3 SQ";
+    v4front_err err =
+        v4front_compile_all_errors(nullptr, source, strlen(source), nullptr, &buf, errors,
+                                   8, &count);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(count == 0);
+    V4FrontBuf plain;
+    REQUIRE(v4front_compile(source, &plain, nullptr, 0) == 0);
+    CHECK(buf.size == plain.size);
+    CHECK(memcmp(buf.data, plain.data, buf.size) == 0);
+    CHECK(buf.word_count == plain.word_count);
+    v4front_free(&plain);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Counting past cap")
+  {
+    const char* source = "A ; B ; C ; D";
+    v4front_err err =
+        v4front_compile_all_errors(nullptr, source, strlen(source), nullptr, &buf, errors,
+                                   2, &count);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(count == 4);
+    CHECK(strcmp(errors[1].token, "B") == 0);
+
+    err = v4front_compile_all_errors(nullptr, source, strlen(source), nullptr, &buf,
+                                     nullptr, 0, &count);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(count == 4);
+
+    err = v4front_compile_all_errors(nullptr, source, strlen(source), nullptr, &buf,
+                                     nullptr, 1, &count);
+    CHECK(err == FrontErr::BufferTooSmall);
+    err = v4front_compile_all_errors(nullptr, source, strlen(source), nullptr, &buf,
+                                     errors, 8, nullptr);
+    CHECK(err == FrontErr::BufferTooSmall);
+  }
+}
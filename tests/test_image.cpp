@@ -0,0 +1,156 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "v4front/image.h"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+TEST_CASE("Contiguous image: layout")
+{
+  V4FrontImage image;
+  v4front_err err;
+
+  SUBCASE("Words, names and code are reachable through offsets")
+  {
+    const char* src = ": SQUARE DUP * ; : CUBE DUP SQUARE * ; 3 CUBE";
+    err = v4front_compile_image(nullptr, src, nullptr, &image, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_image_validate(image.data, image.size);
+    REQUIRE(err == FrontErr::OK);
+
+    const V4FrontImageHeader* h = reinterpret_cast<const V4FrontImageHeader*>(image.data);
+    CHECK(memcmp(h->magic, "V4IM", 4) == 0);
+    CHECK(h->word_count == 2);
+    CHECK(h->image_size == image.size);
+    CHECK(h->code_offset % 4 == 0);
+    CHECK(h->names_offset % 4 == 0);
+
+    // Main code: LIT 3, CALL 1, RET
+    uint32_t main_size = 0;
+    const uint8_t* main_code = v4front_image_main(image.data, &main_size);
+    REQUIRE(main_size == 9);
+    CHECK(main_code[0] == static_cast<uint8_t>(Op::LIT));
+    CHECK(main_code[5] == static_cast<uint8_t>(Op::CALL));
+    CHECK(main_code[6] == 1);
+    CHECK(main_code[8] == static_cast<uint8_t>(Op::RET));
+
+    const char* name = nullptr;
+    const uint8_t* code = nullptr;
+    uint32_t len = 0;
+    err = v4front_image_word(image.data, 0, &name, &code, &len);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(strcmp(name, "SQUARE") == 0);
+    REQUIRE(len == 3);
+    CHECK(code[0] == static_cast<uint8_t>(Op::DUP));
+    CHECK(code[1] == static_cast<uint8_t>(Op::MUL));
+    CHECK(code[2] == static_cast<uint8_t>(Op::RET));
+
+    err = v4front_image_word(image.data, 1, &name, &code, &len);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(strcmp(name, "CUBE") == 0);
+    CHECK(len == 6);
+
+    err = v4front_image_word(image.data, 2, &name, &code, &len);
+    CHECK(err == FrontErr::InvalidImage);
+
+    v4front_image_free(&image);
+    CHECK(image.data == nullptr);
+    v4front_image_free(&image);  // Double free is a no-op
+  }
+
+  SUBCASE("Image matches V4FrontBuf output")
+  {
+    const char* src = ": A 1 ; : B A A + ; B 10 0 DO I LOOP";
+    V4FrontBuf buf;
+    char errmsg[128];
+    err = v4front_compile(src, &buf, errmsg, sizeof(errmsg));
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_compile_image(nullptr, src, nullptr, &image, nullptr);
+    REQUIRE(err == FrontErr::OK);
+
+    uint32_t main_size = 0;
+    const uint8_t* main_code = v4front_image_main(image.data, &main_size);
+    REQUIRE(main_size == buf.size);
+    CHECK(memcmp(main_code, buf.data, buf.size) == 0);
+    for (int i = 0; i < buf.word_count; i++)
+    {
+      const char* name;
+      const uint8_t* code;
+      uint32_t len;
+      err = v4front_image_word(image.data, i, &name, &code, &len);
+      REQUIRE(err == FrontErr::OK);
+      CHECK(strcmp(name, buf.words[i].name) == 0);
+      REQUIRE(len == buf.words[i].code_len);
+      CHECK(memcmp(code, buf.words[i].code, len) == 0);
+    }
+
+    v4front_image_free(&image);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Relocatable: a copy at another address is still valid")
+  {
+    err = v4front_compile_image(nullptr, ": X 42 ; X", nullptr, &image, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    alignas(8) uint8_t copy[256];
+    REQUIRE(image.size <= sizeof(copy));
+    memcpy(copy, image.data, image.size);
+    v4front_image_free(&image);
+
+    err = v4front_image_validate(copy, sizeof(copy));
+    CHECK(err == FrontErr::OK);
+    const char* name;
+    err = v4front_image_word(copy, 0, &name, nullptr, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(strcmp(name, "X") == 0);
+  }
+}
+
+TEST_CASE("Contiguous image: validation")
+{
+  V4FrontImage image;
+  v4front_err err;
+  err = v4front_compile_image(nullptr, ": X 42 ; X", nullptr, &image, nullptr);
+  REQUIRE(err == FrontErr::OK);
+
+  SUBCASE("Truncated image")
+  {
+    err = v4front_image_validate(image.data, image.size - 1);
+    CHECK(err == FrontErr::InvalidImage);
+    err = v4front_image_validate(image.data, 8);
+    CHECK(err == FrontErr::InvalidImage);
+    err = v4front_image_validate(nullptr, image.size);
+    CHECK(err == FrontErr::InvalidImage);
+  }
+
+  SUBCASE("Corrupted fields")
+  {
+    V4FrontImageHeader* h = reinterpret_cast<V4FrontImageHeader*>(image.data);
+    h->magic[0] = 'X';
+    err = v4front_image_validate(image.data, image.size);
+    CHECK(err == FrontErr::InvalidImage);
+    h->magic[0] = 'V';
+
+    h->code_size = 0xFFFFFFF0u;
+    err = v4front_image_validate(image.data, image.size);
+    CHECK(err == FrontErr::InvalidImage);
+  }
+
+  SUBCASE("Compile errors leave the image empty")
+  {
+    V4FrontImage bad;
+    V4FrontError error;
+    err = v4front_compile_image(nullptr, "1 BOGUS", nullptr, &bad, &error);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(bad.data == nullptr);
+    CHECK(strcmp(error.token, "BOGUS") == 0);
+  }
+
+  v4front_image_free(&image);
+}
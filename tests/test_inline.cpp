@@ -0,0 +1,161 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void compile_opt(const char* source, uint32_t flags, V4FrontBuf* buf,
+                        uint32_t inline_max_size = 0)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  options.inline_max_size = inline_max_size;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> bytes(const uint8_t* code, size_t len)
+{
+  return std::vector<uint8_t>(code, code + len);
+}
+
+// Main code ends with CALL idx; RET (the word was not inlined)
+static bool calls_word(const V4FrontBuf& buf, int idx)
+{
+  return buf.size >= 4 && buf.data[buf.size - 4] == op(Op::CALL) &&
+         buf.data[buf.size - 3] == idx && buf.data[buf.size - 2] == 0;
+}
+
+TEST_CASE("Inlining: small leaf words")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Body replaces the CALL")
+  {
+    compile_opt(": DOUBLE DUP + ; DOUBLE", V4FRONT_OPT_INLINE, &buf);
+    REQUIRE(buf.word_count == 1);  // The definition itself is kept
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::DUP), op(Op::ADD), op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Off by default")
+  {
+    compile_opt(": DOUBLE DUP + ; DOUBLE", 0, &buf);
+    CHECK(calls_word(buf, 0));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Inlined words inline into later definitions")
+  {
+    compile_opt(": A DUP ; : B A A ; B", V4FRONT_OPT_INLINE, &buf);
+    REQUIRE(buf.word_count == 2);
+    CHECK(bytes(buf.words[1].code, buf.words[1].code_len) ==
+          std::vector<uint8_t>{op(Op::DUP), op(Op::DUP), op(Op::RET)});
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::DUP), op(Op::DUP), op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Branches inside the body stay valid")
+  {
+    // JZ to the word's RET now lands on the caller's next instruction
+    compile_opt(": ?ONE IF 1 THEN ; ?ONE DROP", V4FRONT_OPT_INLINE, &buf);
+    const std::vector<uint8_t> expected = {op(Op::JZ), 5, 0, op(Op::LIT), 1, 0,
+                                           0,          0, op(Op::DROP), op(Op::RET)};
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Size threshold")
+  {
+    // 10-byte body: above the default limit of 8
+    const char* src = ": TWO-LITS 1 2 ; TWO-LITS";
+    compile_opt(src, V4FRONT_OPT_INLINE, &buf);
+    CHECK(calls_word(buf, 0));
+    v4front_free(&buf);
+
+    compile_opt(src, V4FRONT_OPT_INLINE, &buf, 16);
+    CHECK(buf.size == 11);
+    CHECK(buf.data[0] == op(Op::LIT));
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Inlining: words that must stay calls")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("EXIT")
+  {
+    compile_opt(": E DUP IF EXIT THEN ; E", V4FRONT_OPT_INLINE, &buf);
+    CHECK(calls_word(buf, 0));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("RECURSE")
+  {
+    compile_opt(": R DUP IF RECURSE THEN ; R", V4FRONT_OPT_INLINE, &buf);
+    CHECK(calls_word(buf, 0));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Locals")
+  {
+    compile_opt(": L L@0 ; L", V4FRONT_OPT_INLINE, &buf);
+    CHECK(calls_word(buf, 0));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Return stack reads outside the word's own pushes")
+  {
+    compile_opt(": IDX I ; IDX", V4FRONT_OPT_INLINE, &buf);
+    CHECK(calls_word(buf, 0));
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Balanced return stack use is fine")
+  {
+    compile_opt(": UNDER >R DUP R> ; UNDER", V4FRONT_OPT_INLINE, &buf);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::TOR), op(Op::DUP), op(Op::FROMR), op(Op::RET)});
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Inlining: CONSTANT and VARIABLE")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("CONSTANT becomes its literal")
+  {
+    compile_opt("1000 CONSTANT LIMIT LIMIT", V4FRONT_OPT_INLINE, &buf);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::LIT), 0xE8, 0x03, 0, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("VARIABLE becomes its address")
+  {
+    compile_opt("VARIABLE X X @", V4FRONT_OPT_INLINE, &buf);
+    REQUIRE(buf.word_count == 1);
+    // Word body: LIT <addr> RET; main: LIT <addr> LOAD RET
+    REQUIRE(buf.words[0].code_len == 6);
+    REQUIRE(buf.size == 7);
+    CHECK(bytes(buf.data, 5) == bytes(buf.words[0].code, 5));
+    CHECK(buf.data[5] == op(Op::LOAD));
+    v4front_free(&buf);
+  }
+}
@@ -0,0 +1,110 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Compile source with the given flags and return the code of word 0
+static std::vector<uint8_t> word_code(const char* source, uint32_t flags)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, &buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+  REQUIRE(buf.word_count >= 1);
+  std::vector<uint8_t> code(buf.words[0].code, buf.words[0].code + buf.words[0].code_len);
+  v4front_free(&buf);
+  return code;
+}
+
+static const uint32_t kThread = V4FRONT_OPT_JUMP_THREAD;
+
+TEST_CASE("Jump threading: jumps to JMP go to the final target")
+{
+  // ELSE skip lands on REPEAT's JMP back to BEGIN
+  const char* source = ": B BEGIN DUP WHILE DUP IF 1 - ELSE 2 - THEN REPEAT ;";
+  std::vector<uint8_t> plain = word_code(source, 0);
+  std::vector<uint8_t> code = word_code(source, kThread);
+  REQUIRE(plain.size() == 27);
+  REQUIRE(code.size() == 27);
+  CHECK(plain[14] == op(Op::JMP));
+  CHECK(plain[15] == 0x06);  // -> 23 (REPEAT)
+  CHECK(code[14] == op(Op::JMP));
+  CHECK(code[15] == 0xEF);  // -> 0 (BEGIN)
+  CHECK(code[16] == 0xFF);
+}
+
+TEST_CASE("Jump threading: JMP to RET returns directly")
+{
+  std::vector<uint8_t> expected = {
+      op(Op::JZ),  0x06, 0x00,        //
+      op(Op::LIT), 1,    0,    0, 0,  //
+      op(Op::RET),                    // Was JMP to the final RET
+      op(Op::LIT), 2,    0,    0, 0,  //
+      op(Op::RET),
+  };
+  CHECK(word_code(": A IF 1 ELSE 2 THEN ;", kThread) == expected);
+}
+
+TEST_CASE("Jump threading: conditional jumps")
+{
+  SUBCASE("JZ over a lone JMP is inverted")
+  {
+    std::vector<uint8_t> expected = {
+        op(Op::DUP),                    //
+        op(Op::JNZ), 0x06, 0x00,        // -> LIT 2
+        op(Op::LIT), 1,    0,    0, 0,  //
+        op(Op::SUB),                    //
+        op(Op::LIT), 2,    0,    0, 0,  //
+        op(Op::MUL), op(Op::RET),
+    };
+    CHECK(word_code(": G DUP IF ELSE 1 - THEN 2 * ;", kThread) == expected);
+  }
+
+  SUBCASE("JZ to the next instruction drops the flag")
+  {
+    std::vector<uint8_t> expected = {op(Op::DROP), op(Op::LIT), 7, 0, 0, 0, op(Op::RET)};
+    CHECK(word_code(": H IF THEN 7 ;", kThread) == expected);
+  }
+}
+
+TEST_CASE("Jump threading: unreachable code is removed")
+{
+  SUBCASE("RET after AGAIN")
+  {
+    CHECK(word_code(": D BEGIN AGAIN ;", 0).size() == 4);
+    CHECK(word_code(": D BEGIN AGAIN ;", kThread) ==
+          std::vector<uint8_t>{op(Op::JMP), 0xFD, 0xFF});
+  }
+
+  SUBCASE("Code after EXIT")
+  {
+    std::vector<uint8_t> expected = {op(Op::DUP), op(Op::RET)};
+    CHECK(word_code(": X DUP EXIT 1 2 + ;", kThread) == expected);
+  }
+
+  SUBCASE("Loop bodies stay reachable through backward jumps")
+  {
+    const char* source = ": L BEGIN DUP 1 - DUP 0 = UNTIL ;";
+    CHECK(word_code(source, kThread) == word_code(source, 0));
+  }
+}
+
+TEST_CASE("Jump threading: off by default")
+{
+  std::vector<uint8_t> code = word_code(": A IF 1 ELSE 2 THEN ;", 0);
+  CHECK(code[8] == op(Op::JMP));
+}
@@ -1,11 +1,15 @@
 #define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "kat_runner.hpp"
+#include "program_gen.hpp"
 #include "v4front/compile.h"
 #include "vendor/doctest/doctest.h"
 
+using namespace v4front;
 using namespace v4front::kat;
 
 // Helper function to run a single KAT test
@@ -232,3 +236,90 @@ TEST_CASE("KAT Parser: File loading")
     CHECK(!tests[0].expected_bytes.empty());
   }
 }
+
+TEST_CASE("KAT Parser: In-memory text")
+{
+  const char* text =
+      "# header comment\r\n"
+      "SOURCE: ignored without a header\n"
+      "## Test: First\r\n"
+      "SOURCE:   1 2 +  \r\n"
+      "BYTECODE: 00 01 00 00 00 00 02 00 00 00 10 51 # LIT 1, LIT 2, ADD, RET\r\n"
+      "\n"
+      "## Test: Bad bytes\n"
+      "SOURCE: 1\n"
+      "BYTECODE: 00 ZZ\n"
+      "## Test: Last\n"
+      "SOURCE: DUP";  // No final newline
+  auto tests = parse_kat(text, strlen(text));
+  REQUIRE(tests.size() == 2);
+  CHECK(tests[0].name == "First");
+  CHECK(tests[0].source == "1 2 +");
+  CHECK(tests[0].expected_bytes.size() == 12);
+  CHECK(tests[1].name == "Last");
+  CHECK(tests[1].source == "DUP");
+  CHECK(tests[1].expected_bytes.empty());
+
+  std::string reason;
+  CHECK(check_kat_test(tests[0], 0, &reason));
+  CHECK(reason.empty());
+  tests[0].expected_bytes[11] = 0x50;
+  CHECK_FALSE(check_kat_test(tests[0], 0, &reason));
+  CHECK(reason == "byte 11: expected 0x50, got 0x51");
+}
+
+TEST_CASE("KAT: Batched run of every file")
+{
+  std::vector<std::string> files = {
+      "tests/kat/arithmetic.kat", "tests/kat/control.kat", "tests/kat/locals.kat",
+      "tests/kat/memory.kat",     "tests/kat/stack.kat",   "tests/kat/sys.kat",
+      "tests/kat/words.kat"};
+  size_t serial_cases = 0;
+  for (const std::string& file : files)
+    serial_cases += load_kat_file(file.c_str()).size();
+
+  for (unsigned threads : {1u, 3u, 0u})
+  {
+    INFO("threads: " << threads);
+    KatBatchResult result;
+    CHECK(run_kat_batch(files, threads, 0, &result));
+    CHECK(result.cases == serial_cases);
+    CHECK(result.failures.empty());
+  }
+
+  // Failures are reported in order, whatever the thread count
+  files.insert(files.begin() + 1, "nonexistent.kat");
+  KatBatchResult result;
+  CHECK_FALSE(run_kat_batch(files, 4, 0, &result));
+  REQUIRE(result.failures.size() == 1);
+  CHECK(result.failures[0].file == "nonexistent.kat");
+  CHECK(result.failures[0].name.empty());
+}
+
+TEST_CASE("KAT: Generated programs compile and verify at every level")
+{
+  CHECK(gen::random_program(7) == gen::random_program(7));
+  CHECK(gen::random_program(7) != gen::random_program(8));
+
+  for (uint32_t seed = 1; seed <= 300; seed++)
+  {
+    std::string source = gen::random_program(seed);
+    INFO("seed " << seed << ": " << source);
+    for (uint32_t config = 0; config <= 3; config++)
+    {
+      // -O0..-O2, then -O2 with loop parameters in locals
+      V4FrontCompileOptions options = {};
+      options.opt_level = config < 3 ? config : 2;
+      options.flags = config < 3 ? 0 : V4FRONT_OPT_LOOP_LOCALS;
+      V4FrontBuf buf;
+      v4front_err err =
+          v4front_compile_with_options(nullptr, source.c_str(), &options, &buf, nullptr);
+      REQUIRE(err == 0);
+      if (err != 0)
+        continue;
+      err = v4front_verify_bytecode(&buf, 0, nullptr);
+      CHECK(err == 0);
+      v4front_free(&buf);
+    }
+  }
+}
@@ -0,0 +1,216 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+static std::vector<uint8_t> compile(V4FrontContext* ctx, const std::string& source,
+                                    const V4FrontCompileOptions* options = nullptr)
+{
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err =
+      v4front_compile_with_options(ctx, source.c_str(), options, &buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+  std::vector<uint8_t> out = flatten(buf);
+  v4front_free(&buf);
+  return out;
+}
+
+static V4FrontLexCacheStats stats(const V4FrontContext* ctx)
+{
+  V4FrontLexCacheStats s;
+  v4front_context_get_lex_cache_stats(ctx, &s);
+  return s;
+}
+
+static V4FrontContext* create_with_cache(size_t max_bytes)
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_set_lex_cache(ctx, max_bytes);
+  REQUIRE(err == FrontErr::OK);
+  return ctx;
+}
+
+// Five lines
+static const char* kScript =
+    ": SQUARE DUP * ;\n"
+    "0x10 CONSTANT SIXTEEN  \\ hex\n"
+    ": sum 0 swap 0 do i square + loop ;\n"
+    "-3 constant minus ( a comment ) minus negate\n"
+    "SIXTEEN SUM 017 + MINUS +";
+
+TEST_CASE("Lex cache: output is identical to scanning")
+{
+  const char* sources[] = {
+      kScript,
+      // Comments that span lines: the second line is lexed wrongly on its own
+      "1 ( starts here\n  DUP ) 2 +\n3 ( again\n:\n) 4",
+      // A line that starts inside a comment, seen twice
+      "1 ( x\n  DUP ) 2 +\n( z\n  DUP ) 2 +\n( y ) 3 +",
+      // Definitions and constants read their name ahead
+      ": A 1 ;\n: B\nA A + ;\n5 CONSTANT\nFIVE FIVE B",
+      "\\ only a comment\n\n   \n1 \\ trailing\n\t2\r\n+",
+  };
+  V4FrontCompileOptions o2 = {};
+  o2.opt_level = 2;
+  const V4FrontCompileOptions* configs[] = {nullptr, &o2};
+
+  for (const V4FrontCompileOptions* options : configs)
+  {
+    V4FrontContext* ctx = create_with_cache(1 << 20);
+    for (const char* source : sources)
+    {
+      CAPTURE(source);
+      std::vector<uint8_t> expected = compile(nullptr, source, options);
+      CHECK(compile(ctx, source, options) == expected);
+      CHECK(compile(ctx, source, options) == expected);
+    }
+    v4front_context_destroy(ctx);
+  }
+}
+
+TEST_CASE("Lex cache: errors are reported at the same position")
+{
+  const char* sources[] = {"1 2 +\n3 ( never\nclosed", "1 2 +\nNOSUCHWORD 3"};
+  for (const char* source : sources)
+  {
+    CAPTURE(source);
+    V4FrontError plain;
+    V4FrontBuf buf;
+    v4front_err expected = v4front_compile_with_options(nullptr, source, nullptr, &buf,
+                                                        &plain);
+    REQUIRE(expected != 0);
+    V4FrontContext* ctx = create_with_cache(1 << 20);
+    for (int round = 0; round < 2; round++)
+    {
+      V4FrontError cached;
+      v4front_err err =
+          v4front_compile_with_options(ctx, source, nullptr, &buf, &cached);
+      CHECK(err == expected);
+      CHECK(cached.position == plain.position);
+      CHECK(strcmp(cached.token, plain.token) == 0);
+    }
+    v4front_context_destroy(ctx);
+  }
+}
+
+TEST_CASE("Lex cache: re-entered lines are not tokenized again")
+{
+  V4FrontContext* ctx = create_with_cache(1 << 20);
+  std::vector<uint8_t> expected = compile(nullptr, kScript);
+
+  CHECK(compile(ctx, kScript) == expected);
+  CHECK(stats(ctx).misses == 5);
+  CHECK(stats(ctx).hits == 0);
+  CHECK(stats(ctx).entries == 5);
+
+  CHECK(compile(ctx, kScript) == expected);
+  CHECK(stats(ctx).misses == 0);
+  CHECK(stats(ctx).hits == 5);
+  CHECK(stats(ctx).entries == 5);
+  CHECK(stats(ctx).bytes > 0);
+
+  // One edited line; a REPL line that matches a line of the script
+  std::string edited = kScript;
+  edited.replace(edited.find("017"), 3, "016");
+  CHECK(compile(ctx, edited) == compile(nullptr, edited));
+  CHECK(stats(ctx).misses == 1);
+  CHECK(stats(ctx).hits == 4);
+  compile(ctx, ": SQUARE DUP * ;\n");
+  CHECK(stats(ctx).hits == 1);
+
+  // With the word cache as well
+  v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(compile(ctx, kScript) == expected);
+  CHECK(compile(ctx, kScript) == expected);
+  CHECK(stats(ctx).hits == 5);
+
+  // The cache survives a reset
+  v4front_context_reset(ctx);
+  compile(ctx, kScript);
+  CHECK(stats(ctx).hits == 5);
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Lex cache: limits and configuration")
+{
+  SUBCASE("Least recently used lines are evicted")
+  {
+    V4FrontContext* ctx = create_with_cache(1 << 20);
+    compile(ctx, kScript);
+    const size_t full = stats(ctx).bytes;
+
+    v4front_err err = v4front_context_set_lex_cache(ctx, full / 2);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(stats(ctx).bytes <= full / 2);
+    CHECK(stats(ctx).entries < 5);
+    CHECK(compile(ctx, kScript) == compile(nullptr, kScript));
+    CHECK(stats(ctx).bytes <= full / 2);
+
+    // A line taken from the cache becomes the most recent
+    err = v4front_context_set_lex_cache(ctx, 1 << 20);
+    REQUIRE(err == FrontErr::OK);
+    compile(ctx, "1 2 +\n3 4 +\n");
+    compile(ctx, "1 2 +\n");
+    err = v4front_context_set_lex_cache(ctx, stats(ctx).bytes - 1);
+    REQUIRE(err == FrontErr::OK);
+    compile(ctx, "1 2 +\n");
+    CHECK(stats(ctx).hits == 1);
+    v4front_context_destroy(ctx);
+  }
+
+  SUBCASE("Disabling frees the cache")
+  {
+    V4FrontContext* ctx = create_with_cache(1 << 20);
+    compile(ctx, kScript);
+    v4front_err err = v4front_context_set_lex_cache(ctx, 0);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(stats(ctx).entries == 0);
+    CHECK(stats(ctx).bytes == 0);
+    compile(ctx, kScript);
+    CHECK(stats(ctx).misses == 0);
+    v4front_context_destroy(ctx);
+  }
+
+  SUBCASE("Snapshots have no cache")
+  {
+    V4FrontContext* ctx = create_with_cache(1 << 20);
+    V4FrontContext* snap = v4front_context_snapshot(ctx);
+    REQUIRE(snap != nullptr);
+    v4front_err err = v4front_context_set_lex_cache(snap, 1 << 20);
+    CHECK(err == FrontErr::ReadOnlyContext);
+    CHECK(compile(snap, kScript) == compile(nullptr, kScript));
+    CHECK(stats(snap).entries == 0);
+    CHECK(stats(ctx).entries == 0);
+    v4front_context_destroy(snap);
+    v4front_context_destroy(ctx);
+
+    CHECK(v4front_context_set_lex_cache(nullptr, 1) == -1);
+    V4FrontLexCacheStats s;
+    v4front_context_get_lex_cache_stats(nullptr, &s);
+    CHECK(s.entries == 0);
+  }
+}
@@ -0,0 +1,99 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void compile_opt(const char* source, uint32_t flags, V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> bytes(const uint8_t* code, size_t len)
+{
+  return std::vector<uint8_t>(code, code + len);
+}
+
+TEST_CASE("Compact literals")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("0, 1 and -1 use one-byte forms")
+  {
+    compile_opt("0 1 -1 2", V4FRONT_OPT_COMPACT_LITERALS, &buf);
+    const std::vector<uint8_t> expected = {op(Op::LIT0), op(Op::LIT1), op(Op::LITN1),
+                                           op(Op::LIT),  2,            0,
+                                           0,            0,            op(Op::RET)};
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Hex literals are encoded by value")
+  {
+    compile_opt("0x0 0x1 0xFFFFFFFF", V4FRONT_OPT_COMPACT_LITERALS, &buf);
+    const std::vector<uint8_t> expected = {op(Op::LIT0), op(Op::LIT1), op(Op::LITN1),
+                                           op(Op::RET)};
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Default encoding is unchanged")
+  {
+    compile_opt("0 1", 0, &buf);
+    const std::vector<uint8_t> expected = {op(Op::LIT), 0, 0, 0, 0, op(Op::LIT), 1,
+                                           0,           0, 0, op(Op::RET)};
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("LOOP increment uses LIT1")
+  {
+    V4FrontBuf plain;
+    compile_opt("10 0 DO LOOP", 0, &plain);
+    compile_opt("10 0 DO LOOP", V4FRONT_OPT_COMPACT_LITERALS, &buf);
+    // 0 (4 bytes) and the LOOP step (4 bytes) shrink; the backward JMP follows
+    CHECK(buf.size == plain.size - 8);
+    v4front_free(&plain);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("CONSTANT accepts a compact literal")
+  {
+    compile_opt("1 CONSTANT ONE -1 CONSTANT TRUE? 7 CONSTANT SEVEN ONE",
+                V4FRONT_OPT_COMPACT_LITERALS, &buf);
+    REQUIRE(buf.word_count == 3);
+    CHECK(bytes(buf.words[0].code, buf.words[0].code_len) ==
+          std::vector<uint8_t>{op(Op::LIT1), op(Op::RET)});
+    CHECK(bytes(buf.words[1].code, buf.words[1].code_len) ==
+          std::vector<uint8_t>{op(Op::LITN1), op(Op::RET)});
+    CHECK(buf.words[2].code_len == 6);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::CALL), 0, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("CONSTANT still requires a literal right before it")
+  {
+    V4FrontCompileOptions options = {};
+    options.flags = V4FRONT_OPT_COMPACT_LITERALS;
+    V4FrontError error;
+    v4front_err err =
+        v4front_compile_with_options(nullptr, "1 DUP CONSTANT X", &options, &buf, &error);
+    CHECK(err == FrontErr::ConstantWithoutValue);
+  }
+}
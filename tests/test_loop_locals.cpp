@@ -0,0 +1,318 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <utility>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Compile source with the given flags and return the code of word 0 (or of
+// main code when the source defines no word)
+static std::vector<uint8_t> code_of(const char* source, uint32_t flags)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, &buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+  std::vector<uint8_t> code;
+  if (buf.word_count > 0)
+    code.assign(buf.words[0].code, buf.words[0].code + buf.words[0].code_len);
+  else
+    code.assign(buf.data, buf.data + buf.size);
+  v4front_free(&buf);
+  return code;
+}
+
+static const uint32_t kLocals = V4FRONT_OPT_LOOP_LOCALS;
+
+TEST_CASE("Loop locals: DO parameters move to slots above the word's locals")
+{
+  SUBCASE("LOOP and I")
+  {
+    std::vector<uint8_t> expected = {
+        op(Op::LIT),  0, 0, 0, 0,  // 0
+        op(Op::LSET), 0,           // 5
+        op(Op::LIT),  4, 0, 0, 0,  // 7
+        op(Op::LIT),  0, 0, 0, 0,  // 12
+        op(Op::LSET), 1,           // 17: index
+        op(Op::LSET), 2,           // 19: limit
+        op(Op::LGET), 1,           // 21: I
+        op(Op::LGET), 0,           // 23
+        op(Op::ADD),               // 25
+        op(Op::LSET), 0,           // 26
+        op(Op::LINC), 1,           // 28: LOOP
+        op(Op::LGET), 1,           //
+        op(Op::LGET), 2,           //
+        op(Op::LT),                //
+        op(Op::JNZ),  0xEF, 0xFF,  // 35: -> 21
+        op(Op::LGET), 0,           //
+        op(Op::RET),
+    };
+    CHECK(code_of(": S 0 L! 0 4 0 DO I L@ 0 + L! 0 LOOP L@ 0 ;", kLocals) == expected);
+  }
+
+  SUBCASE("Nested loops: J reads the outer slot")
+  {
+    std::vector<uint8_t> code =
+        code_of(": N L@0 3 0 DO 2 0 DO J I + L!0 LOOP LOOP ;", kLocals);
+    // L@0 uses slot 0, so the outer loop takes 1/2 and the inner 3/4
+    REQUIRE(code.size() > 20);
+    CHECK(code[11] == op(Op::LSET));
+    CHECK(code[12] == 1);
+    CHECK(code[25] == op(Op::LSET));
+    CHECK(code[26] == 3);
+    CHECK(code[29] == op(Op::LGET));  // J
+    CHECK(code[30] == 1);
+    CHECK(code[31] == op(Op::LGET));  // I
+    CHECK(code[32] == 3);
+  }
+
+  SUBCASE("+LOOP and LEAVE")
+  {
+    std::vector<uint8_t> code =
+        code_of(": T L@ 2 5 0 DO I 3 = IF LEAVE THEN 2 +LOOP ;", kLocals);
+    std::vector<uint8_t> tail = {
+        op(Op::LGET), 3, op(Op::ADD), op(Op::LTEE), 3,     //
+        op(Op::LGET), 4, op(Op::LT),  op(Op::JNZ),  0xE2,  //
+        0xFF,         op(Op::RET),
+    };
+    REQUIRE(code.size() > tail.size());
+    CHECK(std::vector<uint8_t>(code.end() - tail.size(), code.end()) == tail);
+
+    // LEAVE is a bare JMP to the exit (no return-stack cleanup)
+    CHECK(code[24] == op(Op::JZ));
+    CHECK(code[27] == op(Op::JMP));
+  }
+}
+
+TEST_CASE("Loop locals: words that do not qualify are unchanged")
+{
+  const char* sources[] = {
+      ": A 4 0 DO I DROP LOOP ;",                 // No locals
+      ": B L@ 0 4 0 DO R@ DROP LOOP ;",           // Explicit R@
+      ": C L@ 0 4 0 DO I >R R> DROP LOOP ;",      // Explicit >R/R>
+      ": D L@ 255 4 0 DO I DROP LOOP ;",          // No free slots
+      "L@ 0 4 0 DO I DROP LOOP",                  // Main code
+      ": E L@ 0 ; 4 0 DO I DROP LOOP",            // Locals end with E
+  };
+  for (const char* source : sources)
+  {
+    CAPTURE(source);
+    CHECK(code_of(source, kLocals) == code_of(source, 0));
+  }
+}
+
+TEST_CASE("Loop locals: off by default")
+{
+  std::vector<uint8_t> code = code_of(": S L@ 0 4 0 DO I DROP LOOP ;", 0);
+  CHECK(code[2] == op(Op::LIT));
+  CHECK(code[12] == op(Op::SWAP));
+  CHECK(code[13] == op(Op::TOR));
+}
+
+// Data stack cells an opcode of run() reads
+static size_t cells_taken(Op o)
+{
+  switch (o)
+  {
+    case Op::SWAP:
+    case Op::OVER:
+    case Op::ADD:
+    case Op::LT:
+      return 2;
+    case Op::DUP:
+    case Op::DROP:
+    case Op::TOR:
+    case Op::INC:
+    case Op::JZ:
+    case Op::JNZ:
+    case Op::LSET:
+    case Op::LTEE:
+    case Op::LSET0:
+    case Op::LSET1:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// Run a compilation on a minimal VM: the opcodes loops, locals and calls
+// compile to. Returns false on any other opcode, an underflow or a runaway
+// program; *ds is the data stack, bottom first.
+static bool run(const V4FrontBuf& buf, std::vector<int32_t>* ds)
+{
+  struct Frame
+  {
+    const uint8_t* code;
+    uint32_t pc;
+    int32_t locals[256];
+  };
+  std::vector<Frame> frames(1);
+  frames[0].code = buf.data;
+  frames[0].pc = 0;
+  std::vector<int32_t> rs;
+  for (int steps = 0; steps < 100000; steps++)
+  {
+    Frame& f = frames.back();
+    const uint8_t* ip = f.code + f.pc;
+    Op o = static_cast<Op>(ip[0]);
+    int16_t rel = static_cast<int16_t>(ip[1] | (ip[2] << 8));
+    if (ds->size() < cells_taken(o))
+      return false;
+    int32_t* top = ds->empty() ? nullptr : &ds->back();
+    f.pc++;
+    switch (o)
+    {
+      case Op::LIT:
+        ds->push_back(static_cast<int32_t>(ip[1] | (ip[2] << 8) | (ip[3] << 16) |
+                                           (static_cast<uint32_t>(ip[4]) << 24)));
+        f.pc += 4;
+        break;
+      case Op::LIT0:
+      case Op::LIT1:
+      case Op::LITN1:
+        ds->push_back(o == Op::LIT0 ? 0 : o == Op::LIT1 ? 1 : -1);
+        break;
+      case Op::DUP:
+        ds->push_back(*top);
+        break;
+      case Op::DROP:
+        ds->pop_back();
+        break;
+      case Op::SWAP:
+        std::swap(top[0], top[-1]);
+        break;
+      case Op::OVER:
+        ds->push_back(top[-1]);
+        break;
+      case Op::TOR:
+        rs.push_back(*top);
+        ds->pop_back();
+        break;
+      case Op::FROMR:
+      case Op::RFETCH:
+        if (rs.empty())
+          return false;
+        ds->push_back(rs.back());
+        if (o == Op::FROMR)
+          rs.pop_back();
+        break;
+      case Op::INC:
+        (*top)++;
+        break;
+      case Op::ADD:
+      case Op::LT:
+        top[-1] = o == Op::ADD ? top[-1] + top[0] : (top[-1] < top[0] ? -1 : 0);
+        ds->pop_back();
+        break;
+      case Op::JMP:
+      case Op::JZ:
+      case Op::JNZ:
+        f.pc += 2;
+        if (o != Op::JMP)
+        {
+          bool zero = *top == 0;
+          ds->pop_back();
+          if (zero != (o == Op::JZ))
+            break;
+        }
+        f.pc += rel;
+        break;
+      case Op::CALL:
+        if (rel < 0 || rel >= buf.word_count || frames.size() > 16)
+          return false;
+        f.pc += 2;
+        frames.emplace_back();
+        frames.back().code = buf.words[rel].code;
+        frames.back().pc = 0;
+        break;
+      case Op::RET:
+        frames.pop_back();
+        if (frames.empty())
+          return rs.empty();
+        break;
+      case Op::LGET:
+        ds->push_back(f.locals[ip[1]]);
+        f.pc++;
+        break;
+      case Op::LSET:
+      case Op::LTEE:
+        f.locals[ip[1]] = *top;
+        if (o == Op::LSET)
+          ds->pop_back();
+        f.pc++;
+        break;
+      case Op::LINC:
+        f.locals[ip[1]]++;
+        f.pc++;
+        break;
+      case Op::LGET0:
+      case Op::LGET1:
+        ds->push_back(f.locals[o == Op::LGET1]);
+        break;
+      case Op::LSET0:
+      case Op::LSET1:
+        f.locals[o == Op::LSET1] = *top;
+        ds->pop_back();
+        break;
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
+TEST_CASE("Loop locals: J and K compute the same as on the return stack")
+{
+  struct Case
+  {
+    const char* source;
+    std::vector<int32_t> expected;
+  };
+  const Case cases[] = {
+      {": T 0 L! 0 0 3 0 DO 4 0 DO J + LOOP LOOP ; T", {12}},
+      {": T 0 L! 0 0 3 0 DO 2 0 DO 2 0 DO K + LOOP LOOP LOOP ; T", {12}},
+      {": T 0 L! 0 3 0 DO 2 0 DO J I + LOOP LOOP ; T", {0, 1, 1, 2, 2, 3}},
+      {": T 0 L! 0 2 0 DO 2 0 DO 2 0 DO K J I + + LOOP LOOP LOOP ; T",
+       {0, 1, 1, 2, 1, 2, 2, 3}},
+      {": T 1 L! 0 0 6 0 DO 3 0 DO J + L@ 0 +LOOP 2 +LOOP ; T", {18}},
+      {": T 0 L! 0 0 4 0 DO 5 0 DO J I + L@ 0 + L! 0 LOOP 1+ LOOP L@ 0 ; T", {4, 70}},
+  };
+  const uint32_t levels[] = {0, 2};
+  for (const Case& c : cases)
+  {
+    INFO(c.source);
+    for (uint32_t level : levels)
+    {
+      for (uint32_t flags : {0u, kLocals})
+      {
+        CAPTURE(level);
+        CAPTURE(flags);
+        V4FrontCompileOptions options = {};
+        options.opt_level = level;
+        options.flags = flags;
+        V4FrontBuf buf;
+        V4FrontError error;
+        v4front_err err =
+            v4front_compile_with_options(nullptr, c.source, &options, &buf, &error);
+        REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+        std::vector<int32_t> ds;
+        CHECK(run(buf, &ds));
+        CHECK(ds == c.expected);
+        v4front_free(&buf);
+      }
+    }
+  }
+}
@@ -0,0 +1,107 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void compile_opt(const char* source, uint32_t flags, uint32_t opt_level,
+                        V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  options.opt_level = opt_level;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> main_code(const char* source, uint32_t flags,
+                                      uint32_t opt_level)
+{
+  V4FrontBuf buf;
+  compile_opt(source, flags, opt_level, &buf);
+  std::vector<uint8_t> code(buf.data, buf.data + buf.size);
+  v4front_free(&buf);
+  return code;
+}
+
+static const char* kProgram =
+    ": SQ DUP * ; : CD DUP IF 1 - RECURSE THEN ; "
+    "5 SQ 1 + SWAP SWAP 2 3 + BEGIN DUP 0 = UNTIL CD";
+
+TEST_CASE("Optimization levels")
+{
+  SUBCASE("-O0 matches the default output")
+  {
+    V4FrontBuf buf;
+    char errmsg[128];
+    v4front_err err = v4front_compile(kProgram, &buf, errmsg, sizeof(errmsg));
+    REQUIRE(err == FrontErr::OK);
+    std::vector<uint8_t> plain(buf.data, buf.data + buf.size);
+    v4front_free(&buf);
+    CHECK(main_code(kProgram, 0, 0) == plain);
+  }
+
+  SUBCASE("Levels are presets for the flags")
+  {
+    CHECK(main_code(kProgram, 0, 1) == main_code(kProgram, V4FRONT_O1_FLAGS, 0));
+    CHECK(main_code(kProgram, 0, 2) == main_code(kProgram, V4FRONT_O2_FLAGS, 0));
+    CHECK(main_code(kProgram, 0, 9) == main_code(kProgram, 0, 2));
+  }
+
+  SUBCASE("Explicit flags add to the level")
+  {
+    CHECK(main_code(kProgram, V4FRONT_OPT_INLINE, 1) ==
+          main_code(kProgram, V4FRONT_O1_FLAGS | V4FRONT_OPT_INLINE, 0));
+  }
+
+  SUBCASE("Each level shrinks the code")
+  {
+    size_t o0 = main_code(kProgram, 0, 0).size();
+    size_t o1 = main_code(kProgram, 0, 1).size();
+    size_t o2 = main_code(kProgram, 0, 2).size();
+    CHECK(o1 < o0);
+    CHECK(o2 < o1);
+  }
+}
+
+TEST_CASE("Passes compose")
+{
+  V4FrontBuf buf;
+
+  // Folding leaves 5 on the stack; inlining puts SQ's DUP * next to the
+  // literal and the peephole pass removes the SWAP SWAP between them
+  compile_opt(": SQ DUP * ; 2 3 + SWAP SWAP SQ", 0, 2, &buf);
+  std::vector<uint8_t> expected = {
+      op(Op::LIT), 5, 0, 0, 0, op(Op::DUP), op(Op::MUL), op(Op::RET),
+  };
+  CHECK(std::vector<uint8_t>(buf.data, buf.data + buf.size) == expected);
+  v4front_free(&buf);
+}
+
+TEST_CASE("Jump targets survive removal in every unit")
+{
+  V4FrontBuf buf;
+
+  compile_opt(": W BEGIN SWAP SWAP DUP 1 - DUP 0 = UNTIL ; W", 0, 1, &buf);
+  REQUIRE(buf.word_count == 1);
+  const uint8_t* code = buf.words[0].code;
+  uint32_t len = buf.words[0].code_len;
+  std::vector<uint8_t> expected = {
+      op(Op::DUP), op(Op::DEC), op(Op::DUP), op(Op::LIT0), op(Op::EQ),
+      op(Op::JZ),  0xF8,        0xFF,        op(Op::RET),
+  };
+  CHECK(std::vector<uint8_t>(code, code + len) == expected);
+  v4front_free(&buf);
+}
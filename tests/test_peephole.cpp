@@ -0,0 +1,170 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Compile source with the peephole pass (or without, if flags == 0)
+static void compile_opt(const char* source, uint32_t flags, V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> bytes(const uint8_t* code, size_t len)
+{
+  return std::vector<uint8_t>(code, code + len);
+}
+
+TEST_CASE("Peephole: off by default")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Zero options match v4front_compile")
+  {
+    const char* src = ": SQ DUP * ; 5 NEGATE SQ SWAP SWAP 10 0 DO I LOOP";
+    char errmsg[128];
+    V4FrontBuf plain;
+    v4front_err err = v4front_compile(src, &plain, errmsg, sizeof(errmsg));
+    REQUIRE(err == FrontErr::OK);
+    compile_opt(src, 0, &buf);
+    CHECK(bytes(buf.data, buf.size) == bytes(plain.data, plain.size));
+    v4front_free(&plain);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("NULL options")
+  {
+    V4FrontError error;
+    v4front_err err =
+        v4front_compile_with_options(nullptr, "NEGATE", nullptr, &buf, &error);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::LIT0), op(Op::SWAP), op(Op::SUB), op(Op::RET)});
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Peephole: window rewrites")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Cancelling pairs are removed")
+  {
+    compile_opt("SWAP SWAP DUP DROP >R R> OVER DROP INVERT INVERT", V4FRONT_OPT_PEEPHOLE,
+                &buf);
+    CHECK(bytes(buf.data, buf.size) == std::vector<uint8_t>{op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Removal exposes new pairs")
+  {
+    // >R SWAP SWAP R> -> >R R> -> nothing
+    compile_opt("1 >R SWAP SWAP R>", V4FRONT_OPT_PEEPHOLE, &buf);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::LIT), 1, 0, 0, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("NEGATE becomes INVERT 1+")
+  {
+    compile_opt("NEGATE", V4FRONT_OPT_PEEPHOLE, &buf);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::INVERT), op(Op::INC), op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Literal identities and increments")
+  {
+    compile_opt("1 + 1 - -1 + 0 + 0 XOR 1 * 7 DROP", V4FRONT_OPT_PEEPHOLE, &buf);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::INC), op(Op::DEC), op(Op::DEC), op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("2OVER sheds the R> >R pair")
+  {
+    V4FrontBuf plain;
+    compile_opt("2OVER", 0, &plain);
+    compile_opt("2OVER", V4FRONT_OPT_PEEPHOLE, &buf);
+    CHECK(buf.size == plain.size - 2);
+    v4front_free(&plain);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Word bodies are optimized too")
+  {
+    compile_opt(": NEG NEGATE ; NEG", V4FRONT_OPT_PEEPHOLE, &buf);
+    REQUIRE(buf.word_count == 1);
+    CHECK(bytes(buf.words[0].code, buf.words[0].code_len) ==
+          std::vector<uint8_t>{op(Op::INVERT), op(Op::INC), op(Op::RET)});
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Peephole: control flow")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Jump offsets are retargeted")
+  {
+    // IF DUP DROP 5 THEN: JZ skips only LIT 5 after the rewrite
+    compile_opt("IF DUP DROP 5 THEN", V4FRONT_OPT_PEEPHOLE, &buf);
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::JZ), 5, 0, op(Op::LIT), 5, 0, 0, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Windows spanning a jump target are kept")
+  {
+    // The second SWAP is the THEN target, so SWAP | SWAP must survive
+    compile_opt("IF SWAP THEN SWAP", V4FRONT_OPT_PEEPHOLE, &buf);
+    const std::vector<uint8_t> expected = {op(Op::JZ),   1, 0, op(Op::SWAP),
+                                           op(Op::SWAP), op(Op::RET)};
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Window at a jump target is removed and the jump follows")
+  {
+    // BEGIN lands on SWAP SWAP; the loop now starts at LIT 1
+    compile_opt("BEGIN SWAP SWAP 1 UNTIL", V4FRONT_OPT_PEEPHOLE, &buf);
+    const std::vector<uint8_t> expected = {op(Op::LIT), 1,    0,   0,   0,
+                                           op(Op::JZ),  0xF8, 0xFF, op(Op::RET)};
+    CHECK(bytes(buf.data, buf.size) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("DO LOOP increments with 1+")
+  {
+    V4FrontBuf plain;
+    compile_opt("10 0 DO I LOOP", 0, &plain);
+    compile_opt("10 0 DO I LOOP", V4FRONT_OPT_PEEPHOLE, &buf);
+    CHECK(buf.size == plain.size - 5);
+
+    // R> 1+ R> OVER OVER < JZ +5 >R >R JMP -15
+    const uint8_t body[] = {op(Op::RFETCH), op(Op::FROMR), op(Op::INC), op(Op::FROMR),
+                            op(Op::OVER),   op(Op::OVER),  op(Op::LT),  op(Op::JZ),
+                            5,              0,             op(Op::TOR), op(Op::TOR),
+                            op(Op::JMP),    0xF1,          0xFF};
+    REQUIRE(buf.size >= 13 + sizeof(body));
+    CHECK(memcmp(buf.data + 13, body, sizeof(body)) == 0);
+    v4front_free(&plain);
+    v4front_free(&buf);
+  }
+}
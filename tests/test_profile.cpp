@@ -0,0 +1,232 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static V4FrontProfile parse(const char* text)
+{
+  V4FrontProfile profile;
+  v4front_err err = v4front_parse_profile(text, strlen(text), &profile, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  return profile;
+}
+
+static void compile_opt(const char* source, uint32_t flags, const V4FrontProfile* profile,
+                        V4FrontBuf* buf, V4FrontContext* ctx = nullptr)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  options.profile = profile;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(ctx, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> main_code(const char* source, uint32_t flags,
+                                      const V4FrontProfile* profile)
+{
+  V4FrontBuf buf;
+  compile_opt(source, flags, profile, &buf);
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  v4front_free(&buf);
+  return out;
+}
+
+static std::vector<std::string> names_of(const V4FrontBuf& buf)
+{
+  std::vector<std::string> names;
+  for (int i = 0; i < buf.word_count; i++)
+    names.push_back(buf.words[i].name);
+  return names;
+}
+
+TEST_CASE("Profile: text form")
+{
+  SUBCASE("Entries, comments and blank lines")
+  {
+    V4FrontProfile profile =
+        parse("# counts of run 7\n\nSQ 1200\r\n  \tmain-loop\t5  \nX 0");
+    REQUIRE(profile.count == 3);
+    CHECK(strcmp(profile.words[0].name, "SQ") == 0);
+    CHECK(profile.words[0].count == 1200);
+    CHECK(strcmp(profile.words[1].name, "main-loop") == 0);
+    CHECK(profile.words[1].count == 5);
+    CHECK(strcmp(profile.words[2].name, "X") == 0);
+    CHECK(profile.words[2].count == 0);
+    v4front_free_profile(&profile);
+    CHECK(profile.words == nullptr);
+
+    profile = parse("# nothing\n");
+    CHECK(profile.count == 0);
+    v4front_free_profile(&profile);
+    v4front_free_profile(nullptr);
+  }
+
+  SUBCASE("Malformed lines")
+  {
+    const char* bad[] = {"SQ 1\nSQUARE\n", "SQ 1\nSQ -1\n", "SQ 1\nSQ 12x\n",
+                         "SQ 1\nSQ 1 2\n", "SQ 1\nSQ 18446744073709551616\n"};
+    for (const char* text : bad)
+    {
+      INFO(text);
+      V4FrontProfile profile;
+      uint32_t line = 0;
+      v4front_err err = v4front_parse_profile(text, strlen(text), &profile, &line);
+      CHECK(err == FrontErr::InvalidProfile);
+      CHECK(line == 2);
+      CHECK(profile.words == nullptr);
+    }
+    V4FrontProfile profile = parse("MAX 18446744073709551615");
+    CHECK(profile.words[0].count == UINT64_MAX);
+    v4front_free_profile(&profile);
+
+    v4front_err err = v4front_parse_profile(nullptr, 0, &profile, nullptr);
+    CHECK(err == FrontErr::BufferTooSmall);
+    err = v4front_parse_profile("", 0, nullptr, nullptr);
+    CHECK(err == FrontErr::BufferTooSmall);
+  }
+
+  SUBCASE("Files")
+  {
+    const char* filename = "test_profile.prof";
+    FILE* fp = fopen(filename, "wb");
+    REQUIRE(fp != nullptr);
+    fputs("SQ 3\nCUBE 4\n", fp);
+    fclose(fp);
+    V4FrontProfile profile;
+    v4front_err err = v4front_load_profile(filename, &profile, nullptr);
+    remove(filename);
+    REQUIRE(err == FrontErr::OK);
+    REQUIRE(profile.count == 2);
+    CHECK(profile.words[1].count == 4);
+    v4front_free_profile(&profile);
+
+    CHECK(v4front_load_profile("nonexistent_xyz.prof", &profile, nullptr) == -2);
+    CHECK(v4front_load_profile(nullptr, &profile, nullptr) == -1);
+  }
+}
+
+TEST_CASE("Profile: inlining limits")
+{
+  const uint32_t flags = V4FRONT_OPT_INLINE;
+  // BIG's body is 12 bytes, over the default limit of 8
+  const char* big = ": BIG 1 + 2 + ; 5 BIG";
+  const char* sq = ": SQ DUP * ; 5 SQ";
+  const std::vector<uint8_t> big_inlined = main_code(": BIG ; 5 1 + 2 +", 0, nullptr);
+  const std::vector<uint8_t> sq_inlined = main_code(": SQ ; 5 DUP *", 0, nullptr);
+
+  SUBCASE("Hot words may be larger")
+  {
+    V4FrontProfile profile = parse("big 5000\n");
+    CHECK(main_code(big, flags, &profile) == big_inlined);
+    CHECK(main_code(big, flags, nullptr) != big_inlined);
+    CHECK(main_code(big, 0, &profile) == main_code(big, 0, nullptr));
+    v4front_free_profile(&profile);
+
+    // Below 1/64 of the hottest word: the default limit
+    profile = parse("BIG 100\nOTHER 100000\n");
+    CHECK(main_code(big, flags, &profile) == main_code(big, flags, nullptr));
+    v4front_free_profile(&profile);
+  }
+
+  SUBCASE("Cold words stay calls, unnamed ones keep the default")
+  {
+    V4FrontProfile profile = parse("SQ 0\n");
+    CHECK(main_code(sq, flags, nullptr) == sq_inlined);
+    CHECK(main_code(sq, flags, &profile) == main_code(sq, 0, nullptr));
+    v4front_free_profile(&profile);
+
+    profile = parse("ELSE 10\n");
+    CHECK(main_code(sq, flags, &profile) == sq_inlined);
+    v4front_free_profile(&profile);
+  }
+}
+
+TEST_CASE("Profile: hot words are laid out first")
+{
+  const uint32_t flags = V4FRONT_OPT_HOT_LAYOUT;
+  const char* source = ": A 1 ;\n: B 2 ;\n: C A B ;\nC";
+  V4FrontProfile profile = parse("B 50\nC 100\n");
+  V4FrontBuf buf;
+
+  SUBCASE("Order and CALL operands")
+  {
+    compile_opt(source, flags, &profile, &buf);
+    CHECK(names_of(buf) == std::vector<std::string>{"C", "B", "A"});
+    CHECK(std::vector<uint8_t>(buf.data, buf.data + buf.size) ==
+          std::vector<uint8_t>{op(Op::CALL), 0, 0, op(Op::RET)});
+    CHECK(std::vector<uint8_t>(buf.words[0].code,
+                               buf.words[0].code + buf.words[0].code_len) ==
+          std::vector<uint8_t>{op(Op::CALL), 2, 0, op(Op::CALL), 1, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Nothing moves without the flag, a profile or local calls only")
+  {
+    compile_opt(source, 0, &profile, &buf);
+    CHECK(names_of(buf) == std::vector<std::string>{"A", "B", "C"});
+    v4front_free(&buf);
+    compile_opt(source, flags, nullptr, &buf);
+    CHECK(names_of(buf) == std::vector<std::string>{"A", "B", "C"});
+    v4front_free(&buf);
+
+    V4FrontContext* ctx = v4front_context_create();
+    REQUIRE(ctx != nullptr);
+    v4front_err err = v4front_context_register_word(ctx, "HOST", 3);
+    REQUIRE(err == FrontErr::OK);
+    compile_opt((std::string(source) + " HOST").c_str(), flags, &profile, &buf, ctx);
+    CHECK(names_of(buf) == std::vector<std::string>{"A", "B", "C"});
+    v4front_free(&buf);
+    v4front_context_destroy(ctx);
+  }
+
+  SUBCASE("Source maps follow the words")
+  {
+    compile_opt(source, flags | V4FRONT_OPT_SOURCE_MAP, &profile, &buf);
+    REQUIRE(names_of(buf) == std::vector<std::string>{"C", "B", "A"});
+    const uint32_t lines[] = {3, 2, 1};
+    for (int unit = 0; unit < 3; unit++)
+    {
+      V4FrontSourceLoc loc;
+      v4front_err err =
+          v4front_source_map_lookup(buf.source_map, buf.source_map_size, unit, 0, &loc);
+      CHECK(err == FrontErr::OK);
+      CHECK(loc.line == lines[unit]);
+    }
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Batches are laid out after linking")
+  {
+    const char* sources[] = {": A 1 ; : B 2 ;", ": C A B ; C"};
+    V4FrontModule modules[2] = {{sources[0], strlen(sources[0])},
+                                {sources[1], strlen(sources[1])}};
+    V4FrontCompileOptions options = {};
+    options.flags = flags;
+    options.profile = &profile;
+    v4front_err err =
+        v4front_compile_batch(nullptr, modules, 2, &options, 2, &buf, nullptr, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(names_of(buf) == std::vector<std::string>{"C", "B", "A"});
+    CHECK(std::vector<uint8_t>(buf.words[0].code,
+                               buf.words[0].code + buf.words[0].code_len) ==
+          std::vector<uint8_t>{op(Op::CALL), 2, 0, op(Op::CALL), 1, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+  v4front_free_profile(&profile);
+}
@@ -0,0 +1,334 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+// Relocation entry as a comparable tuple
+struct Site
+{
+  int32_t unit;
+  uint32_t offset;
+  uint16_t kind;
+  uint16_t target;
+
+  bool operator==(const Site& other) const
+  {
+    return unit == other.unit && offset == other.offset && kind == other.kind &&
+           target == other.target;
+  }
+};
+
+static std::vector<Site> sites(const V4FrontBuf& buf)
+{
+  std::vector<Site> out;
+  for (uint32_t i = 0; i < buf.reloc_count; i++)
+  {
+    const V4FrontReloc& r = buf.relocs[i];
+    out.push_back({r.unit, r.offset, r.kind, r.target});
+  }
+  return out;
+}
+
+// Every site must name a CALL operand that holds its target (local targets
+// moved by local_base)
+static void check_sites(const V4FrontBuf& buf, uint32_t local_base = 0)
+{
+  for (uint32_t i = 0; i < buf.reloc_count; i++)
+  {
+    const V4FrontReloc& r = buf.relocs[i];
+    CAPTURE(i);
+    REQUIRE(r.unit < buf.word_count);
+    const uint8_t* code = r.unit < 0 ? buf.data : buf.words[r.unit].code;
+    uint32_t len =
+        r.unit < 0 ? static_cast<uint32_t>(buf.size) : buf.words[r.unit].code_len;
+    REQUIRE(r.offset + 2 <= len);
+    CHECK((code[r.offset] | (code[r.offset + 1] << 8)) == r.target);
+    if (r.kind == V4FRONT_RELOC_LOCAL)
+      CHECK(r.target - local_base < static_cast<uint32_t>(buf.word_count));
+  }
+}
+
+static const uint16_t LOCAL = V4FRONT_RELOC_LOCAL;
+static const uint16_t EXTERNAL = V4FRONT_RELOC_EXTERNAL;
+
+TEST_CASE("Relocations: local and external CALL sites")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  // VM index 2 is also the index of the local word C
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 2);
+  REQUIRE(err == FrontErr::OK);
+
+  const char* source = ": A 1 ;\n: B 2 ;\n: C A HOST ;\nC HOST B";
+  V4FrontCompileOptions options = {};
+
+  SUBCASE("Off by default")
+  {
+    V4FrontBuf buf;
+    err = v4front_compile_with_options(ctx, source, &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(buf.relocs == nullptr);
+    CHECK(buf.reloc_count == 0);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Listed in order, code unchanged")
+  {
+    V4FrontBuf plain;
+    err = v4front_compile_with_options(ctx, source, &options, &plain, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    options.flags = V4FRONT_OPT_RELOCS;
+    V4FrontBuf buf;
+    err = v4front_compile_with_options(ctx, source, &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+
+    CHECK(flatten(buf) == flatten(plain));
+    std::vector<Site> expected = {
+        {-1, 1, LOCAL, 2}, {-1, 4, EXTERNAL, 2}, {-1, 7, LOCAL, 1},
+        {2, 1, LOCAL, 0},  {2, 4, EXTERNAL, 2},
+    };
+    CHECK(sites(buf) == expected);
+    check_sites(buf);
+
+    v4front_free(&buf);
+    CHECK(buf.relocs == nullptr);
+    CHECK(buf.reloc_count == 0);
+    v4front_free(&plain);
+  }
+
+  SUBCASE("Every optimization level keeps the same code")
+  {
+    const char* script =
+        ": SQ DUP * ;\n: F 0 SWAP 0 DO I SQ + HOST LOOP ;\n"
+        ": G DUP IF 1- RECURSE THEN HOST ;\n5 F 3 G";
+    for (uint32_t level = 0; level <= 2; level++)
+    {
+      CAPTURE(level);
+      options.opt_level = level;
+      options.flags = 0;
+      V4FrontBuf plain;
+      err = v4front_compile_with_options(ctx, script, &options, &plain, nullptr);
+      REQUIRE(err == FrontErr::OK);
+      options.flags = V4FRONT_OPT_RELOCS;
+      V4FrontBuf buf;
+      err = v4front_compile_with_options(ctx, script, &options, &buf, nullptr);
+      REQUIRE(err == FrontErr::OK);
+
+      CHECK(flatten(buf) == flatten(plain));
+      check_sites(buf);
+      uint32_t external = 0;
+      for (const Site& site : sites(buf))
+        external += site.kind == EXTERNAL;
+      CHECK(external >= 2);
+      v4front_free(&buf);
+      v4front_free(&plain);
+    }
+  }
+
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Relocations: sites inside superinstructions")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 9);
+  REQUIRE(err == FrontErr::OK);
+
+  const uint8_t DUP_CALL = 0xA0;
+  const uint8_t CALL_CALL = 0xA1;
+  const V4FrontSuperinstruction table[] = {
+      {DUP_CALL, 2, {op(Op::DUP), op(Op::CALL)}},
+      {CALL_CALL, 2, {op(Op::CALL), op(Op::CALL)}},
+  };
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_RELOCS;
+  options.superinstructions = table;
+  options.superinstruction_count = 2;
+
+  V4FrontBuf buf;
+  err = v4front_compile_with_options(ctx, ": W 1 ;\nDUP HOST W HOST", &options, &buf,
+                                     nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> main_code(buf.data, buf.data + buf.size);
+  CHECK(main_code ==
+        std::vector<uint8_t>{DUP_CALL, 9, 0, CALL_CALL, 0, 0, 9, 0, op(Op::RET)});
+  std::vector<Site> expected = {
+      {-1, 1, EXTERNAL, 9}, {-1, 4, LOCAL, 0}, {-1, 6, EXTERNAL, 9}};
+  CHECK(sites(buf) == expected);
+  v4front_free(&buf);
+
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Relocations: v4front_relocate")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 3);
+  REQUIRE(err == FrontErr::OK);
+
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_RELOCS;
+  V4FrontBuf buf;
+  err = v4front_compile_with_options(ctx, ": A HOST ;\n: B A ;\nB HOST", &options, &buf,
+                                     nullptr);
+  REQUIRE(err == FrontErr::OK);
+
+  err = v4front_relocate(&buf, 100);
+  CHECK(err == FrontErr::OK);
+  std::vector<uint8_t> main_code(buf.data, buf.data + buf.size);
+  CHECK(main_code == std::vector<uint8_t>{op(Op::CALL), 101, 0, op(Op::CALL), 3, 0,
+                                          op(Op::RET)});
+  std::vector<uint8_t> b(buf.words[1].code, buf.words[1].code + buf.words[1].code_len);
+  CHECK(b == std::vector<uint8_t>{op(Op::CALL), 100, 0, op(Op::RET)});
+  check_sites(buf, 100);
+
+  SUBCASE("Relocating again adds up")
+  {
+    err = v4front_relocate(&buf, 0x100);
+    CHECK(err == FrontErr::OK);
+    CHECK(buf.data[1] == 101);
+    CHECK(buf.data[2] == 1);
+    CHECK(buf.data[4] == 3);
+  }
+
+  SUBCASE("An index past 32767 is refused and changes nothing")
+  {
+    std::vector<uint8_t> before = flatten(buf);
+    err = v4front_relocate(&buf, 32767);
+    CHECK(err == FrontErr::DictionaryFull);
+    CHECK(flatten(buf) == before);
+    CHECK(buf.relocs[0].target == 101);
+  }
+
+  err = v4front_relocate(nullptr, 1);
+  CHECK(err == FrontErr::BufferTooSmall);
+  v4front_free(&buf);
+
+  // No table, nothing to do
+  err = v4front_compile_with_options(nullptr, ": A ;\nA", nullptr, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_relocate(&buf, 5);
+  CHECK(err == FrontErr::OK);
+  CHECK(buf.data[1] == 0);
+  v4front_free(&buf);
+
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Relocations: word cache and other entry points")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_context_register_word(ctx, "ONE", 10);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_context_register_word(ctx, "TWO", 20);
+  REQUIRE(err == FrontErr::OK);
+
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_RELOCS;
+  const char* source = ": USE ONE TWO ;\nUSE";
+
+  SUBCASE("Cached bodies resolve against the current context")
+  {
+    V4FrontBuf buf;
+    err = v4front_compile_with_options(ctx, source, &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    v4front_free(&buf);
+
+    // Same VM indices, registered in the other order
+    v4front_context_reset(ctx);
+    err = v4front_context_register_word(ctx, "TWO", 20);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_context_register_word(ctx, "ONE", 10);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_compile_with_options(ctx, source, &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    const V4FrontWord& use = buf.words[0];
+    CHECK(std::vector<uint8_t>(use.code, use.code + use.code_len) ==
+          std::vector<uint8_t>{op(Op::CALL), 10, 0, op(Op::CALL), 20, 0, op(Op::RET)});
+    check_sites(buf);
+    v4front_free(&buf);
+
+    err = v4front_compile_with_options(ctx, source, &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    V4FrontWordCacheStats stats;
+    v4front_context_get_word_cache_stats(ctx, &stats);
+    CHECK(stats.reused == 1);
+    CHECK(buf.words[0].code[1] == 10);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("A cache directory is bypassed")
+  {
+    options.cache_dir = "/nonexistent/v4front-cache";
+    V4FrontBuf buf;
+    err = v4front_compile_with_options(ctx, source, &options, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(buf.reloc_count == 3);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Streams list relocations too")
+  {
+    V4FrontStream* stream;
+    err = v4front_stream_begin(ctx, &options, &stream);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_stream_feed(stream, ": USE ONE TWO ;\n", 16, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_stream_feed(stream, "USE ONE", 7, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    V4FrontBuf buf;
+    err = v4front_stream_end(stream, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    std::vector<Site> expected = {
+        {-1, 1, LOCAL, 0},
+        {-1, 4, EXTERNAL, 10},
+        {0, 1, EXTERNAL, 10},
+        {0, 4, EXTERNAL, 20},
+    };
+    CHECK(sites(buf) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Batches refuse the flag")
+  {
+    V4FrontModule module = {source, strlen(source)};
+    V4FrontBuf buf;
+    err = v4front_compile_batch(ctx, &module, 1, &options, 1, &buf, nullptr, nullptr);
+    CHECK(err == FrontErr::InvalidOption);
+  }
+
+  v4front_context_destroy(ctx);
+}
@@ -0,0 +1,235 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+// Counting wrapper around malloc/free
+struct CountingHeap
+{
+  int allocs;
+  int frees;
+};
+
+static void* counting_alloc(void* user, size_t size)
+{
+  static_cast<CountingHeap*>(user)->allocs++;
+  return malloc(size);
+}
+
+static void counting_free(void* user, void* ptr)
+{
+  static_cast<CountingHeap*>(user)->frees++;
+  free(ptr);
+}
+
+// Short lines as a REPL sees them
+static const char* const kLines[] = {
+    "1 2 +",
+    ": SQ DUP * ; 7 SQ",
+    "10 0 DO I DROP LOOP",
+    "VARIABLE X 5 X ! X @",
+    "3 4 < IF 1 ELSE 2 THEN",
+    "BEGIN DUP WHILE 1 - REPEAT DROP",
+    ": FACT DUP 1 > IF DUP 1 - RECURSE * THEN ; 5 FACT",
+};
+
+// Same bytes and words as a plain compile
+static void check_same(const V4FrontBuf& a, const V4FrontBuf& b)
+{
+  REQUIRE(a.size == b.size);
+  CHECK(memcmp(a.data, b.data, a.size) == 0);
+  REQUIRE(a.word_count == b.word_count);
+  for (int i = 0; i < a.word_count; i++)
+  {
+    CHECK(strcmp(a.words[i].name, b.words[i].name) == 0);
+    REQUIRE(a.words[i].code_len == b.words[i].code_len);
+    CHECK(memcmp(a.words[i].code, b.words[i].code, a.words[i].code_len) == 0);
+  }
+}
+
+TEST_CASE("Session: output matches v4front_compile_with_options")
+{
+  V4FrontSession* session = v4front_session_create(nullptr);
+  REQUIRE(session != nullptr);
+
+  for (uint32_t level = 0; level <= 2; level++)
+  {
+    V4FrontCompileOptions options = {};
+    options.opt_level = level;
+    for (const char* line : kLines)
+    {
+      INFO("-O" << level << ": " << line);
+      V4FrontBuf expected;
+      v4front_err err =
+          v4front_compile_with_options(nullptr, line, &options, &expected, nullptr);
+      REQUIRE(err == FrontErr::OK);
+
+      V4FrontBuf buf;
+      err = v4front_session_compile(session, nullptr, line, &options, &buf, nullptr);
+      REQUIRE(err == FrontErr::OK);
+      check_same(buf, expected);
+      CHECK(v4front_session_output_size(session) > 0);
+      v4front_free(&expected);
+    }
+  }
+
+  // Freeing session output only clears the buffer
+  V4FrontBuf buf;
+  v4front_err err =
+      v4front_session_compile(session, nullptr, "1", nullptr, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  v4front_free(&buf);
+  CHECK(buf.data == nullptr);
+  CHECK(buf.block == nullptr);
+  v4front_session_destroy(session);
+}
+
+TEST_CASE("Session: steady state takes no memory from the allocator")
+{
+  CountingHeap heap = {0, 0};
+  V4FrontAllocator allocator = {counting_alloc, counting_free, &heap};
+  V4FrontSession* session = v4front_session_create(&allocator);
+  REQUIRE(session != nullptr);
+
+  V4FrontCompileOptions options = {};
+  options.opt_level = 2;
+  V4FrontBuf buf;
+  v4front_err err;
+
+  // Warm up: scratch and output grow to the largest line
+  for (int round = 0; round < 2; round++)
+  {
+    for (const char* line : kLines)
+    {
+      err = v4front_session_compile(session, nullptr, line, &options, &buf, nullptr);
+      REQUIRE(err == FrontErr::OK);
+    }
+  }
+
+  const int warm = heap.allocs;
+  for (int round = 0; round < 50; round++)
+  {
+    for (const char* line : kLines)
+    {
+      err = v4front_session_compile(session, nullptr, line, &options, &buf, nullptr);
+      REQUIRE(err == FrontErr::OK);
+    }
+    // Errors recycle the scratch too
+    err = v4front_session_compile(session, nullptr, "1 IF", &options, &buf, nullptr);
+    CHECK(err == FrontErr::UnclosedIf);
+  }
+  CHECK(heap.allocs == warm);
+
+  v4front_session_destroy(session);
+  CHECK(heap.allocs == heap.frees);
+}
+
+TEST_CASE("Session: caller-provided output")
+{
+  V4FrontSession* session = v4front_session_create(nullptr);
+  REQUIRE(session != nullptr);
+  V4FrontBuf expected;
+  v4front_err err = v4front_compile_with_options(nullptr, kLines[1], nullptr, &expected,
+                                                 nullptr);
+  REQUIRE(err == FrontErr::OK);
+
+  alignas(16) uint8_t storage[512];
+  V4FrontBuf buf;
+
+  SUBCASE("Output lands in the storage, even when unaligned")
+  {
+    err = v4front_session_set_output(session, storage + 3, sizeof(storage) - 3);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_session_compile(session, nullptr, kLines[1], nullptr, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    check_same(buf, expected);
+    CHECK(buf.data > storage + 3);
+    CHECK(buf.data < storage + sizeof(storage));
+    CHECK(reinterpret_cast<uintptr_t>(buf.words) % alignof(V4FrontWord) == 0);
+  }
+
+  SUBCASE("Too small: BufferTooSmall and the size it needs")
+  {
+    err = v4front_session_set_output(session, storage, 40);
+    REQUIRE(err == FrontErr::OK);
+    V4FrontError error;
+    err = v4front_session_compile(session, nullptr, kLines[1], nullptr, &buf, &error);
+    CHECK(err == FrontErr::BufferTooSmall);
+    CHECK(error.code == front_err_to_int(FrontErr::BufferTooSmall));
+    CHECK(buf.data == nullptr);
+    size_t needed = v4front_session_output_size(session);
+    CHECK(needed > 40);
+
+    err = v4front_session_set_output(session, storage, needed);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_session_compile(session, nullptr, kLines[1], nullptr, &buf, nullptr);
+    CHECK(err == FrontErr::OK);
+    CHECK(v4front_session_output_size(session) == needed);
+  }
+
+  SUBCASE("NULL switches back to session memory")
+  {
+    err = v4front_session_set_output(session, storage, 1);
+    CHECK(err == FrontErr::BufferTooSmall);
+    err = v4front_session_set_output(session, nullptr, 0);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_session_compile(session, nullptr, kLines[1], nullptr, &buf, nullptr);
+    REQUIRE(err == FrontErr::OK);
+    check_same(buf, expected);
+  }
+
+  v4front_free(&expected);
+  v4front_session_destroy(session);
+}
+
+TEST_CASE("Session: contexts, errors and refused options")
+{
+  V4FrontSession* session = v4front_session_create(nullptr);
+  REQUIRE(session != nullptr);
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "EMIT", 9);
+  REQUIRE(err == FrontErr::OK);
+
+  V4FrontBuf buf;
+  V4FrontError error;
+  err = v4front_session_compile(session, ctx, "65 EMIT", nullptr, &buf, &error);
+  REQUIRE(err == FrontErr::OK);
+  V4FrontBuf expected;
+  err = v4front_compile_with_context(ctx, "65 EMIT", &expected, nullptr, 0);
+  REQUIRE(err == FrontErr::OK);
+  check_same(buf, expected);
+  v4front_free(&expected);
+
+  // Errors carry positions like any other compile
+  err = v4front_session_compile(session, ctx, "1 NOPE", nullptr, &buf, &error);
+  CHECK(err == FrontErr::UnknownToken);
+  CHECK(error.position == 2);
+  CHECK(buf.data == nullptr);
+  CHECK(v4front_session_output_size(session) == 0);
+
+  V4FrontCompileOptions options = {};
+  options.cache_dir = ".";
+  err = v4front_session_compile(session, ctx, "1", &options, &buf, nullptr);
+  CHECK(err == FrontErr::InvalidOption);
+
+  err = v4front_session_compile(session, ctx, "1", nullptr, nullptr, nullptr);
+  CHECK(err == FrontErr::BufferTooSmall);
+  err = v4front_session_compile(nullptr, ctx, "1", nullptr, &buf, nullptr);
+  CHECK(err == FrontErr::BufferTooSmall);
+
+  // Still usable after all of that
+  err = v4front_session_compile_n(session, ctx, "2 3 +junk", 5, nullptr, &buf, nullptr);
+  CHECK(err == FrontErr::OK);
+
+  v4front_context_destroy(ctx);
+  v4front_session_destroy(session);
+  v4front_session_destroy(nullptr);
+}
@@ -0,0 +1,114 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+static std::vector<uint8_t> main_code(const V4FrontBuf& buf)
+{
+  return std::vector<uint8_t>(buf.data, buf.data + buf.size);
+}
+
+// Compile the first len bytes of text and compare with compiling expected
+static void check_prefix(const char* text, size_t len, const char* expected)
+{
+  V4FrontBuf a, b;
+  char errmsg[128];
+  v4front_err err = v4front_compile_n(text, len, &a, errmsg, sizeof(errmsg));
+  REQUIRE_MESSAGE(err == FrontErr::OK, errmsg);
+  err = v4front_compile(expected, &b, errmsg, sizeof(errmsg));
+  REQUIRE(err == FrontErr::OK);
+  CHECK(main_code(a) == main_code(b));
+  v4front_free(&a);
+  v4front_free(&b);
+}
+
+TEST_CASE("Length-delimited source: nothing past len is read")
+{
+  SUBCASE("Trailing bytes are ignored")
+  {
+    check_prefix("1 2 + GARBAGE", 5, "1 2 +");
+  }
+
+  SUBCASE("A token can end exactly at len")
+  {
+    check_prefix("1 DUPLICATE", 5, "1 DUP");
+  }
+
+  SUBCASE("Comments end at len")
+  {
+    check_prefix("1 \\ comment\n2", 11, "1");
+    check_prefix("1 ( x ) 2 NOPE", 9, "1 2");
+  }
+
+  SUBCASE("Definitions and loops are scanned within len")
+  {
+    const char* text = ": SQ DUP * ; 3 0 DO I SQ DROP LOOP ; ; ;";
+    check_prefix(text, strlen(text) - 6, ": SQ DUP * ; 3 0 DO I SQ DROP LOOP");
+  }
+
+  SUBCASE("Empty source")
+  {
+    check_prefix("DROP", 0, "");
+  }
+}
+
+TEST_CASE("Length-delimited source: errors stay within len")
+{
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err;
+
+  SUBCASE("Error token is cut at len")
+  {
+    err = v4front_compile_ex_n("1 FOOBAR", 5, &buf, &error);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(strcmp(error.token, "FOO") == 0);
+    CHECK(strcmp(error.context, "1 FOO") == 0);
+  }
+
+  SUBCASE("Comment closed only after len is unterminated")
+  {
+    err = v4front_compile_ex_n("( abc ) 1", 5, &buf, &error);
+    CHECK(err == FrontErr::UnterminatedComment);
+  }
+
+  SUBCASE("Operand missing before len")
+  {
+    err = v4front_compile_ex_n("L@ 0", 3, &buf, &error);
+    CHECK(err != FrontErr::OK);
+    err = v4front_compile_ex_n(": X ;", 2, &buf, &error);
+    CHECK(err == FrontErr::ColonWithoutName);
+  }
+}
+
+TEST_CASE("Length-delimited source: context and options variants")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "SQUARE", 0);
+  REQUIRE(err == FrontErr::OK);
+
+  V4FrontBuf buf;
+  char errmsg[128];
+  err = v4front_compile_with_context_n(ctx, "5 SQUARE  SQUARE", 8, &buf, errmsg,
+                                       sizeof(errmsg));
+  REQUIRE(err == FrontErr::OK);
+  CHECK(buf.size == 5 + 3 + 1);  // LIT 5, CALL 0, RET
+  v4front_free(&buf);
+
+  V4FrontCompileOptions options = {};
+  options.opt_level = 1;
+  V4FrontError error;
+  err = v4front_compile_with_options_n(ctx, "2 3 + 99", 5, &options, &buf, &error);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(buf.size == 5 + 1);  // Folded to LIT 5, RET
+  v4front_free(&buf);
+
+  v4front_context_destroy(ctx);
+}
@@ -0,0 +1,263 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+static V4FrontBuf compile(const char* source, uint32_t flags, uint32_t opt_level = 0)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  options.opt_level = opt_level;
+  V4FrontBuf buf;
+  v4front_err err =
+      v4front_compile_with_options(nullptr, source, &options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  return buf;
+}
+
+// Line and column of the instruction at pc of unit
+static std::pair<uint32_t, uint32_t> where(const V4FrontBuf& buf, int32_t unit,
+                                           uint32_t pc)
+{
+  V4FrontSourceLoc loc;
+  v4front_err err =
+      v4front_source_map_lookup(buf.source_map, buf.source_map_size, unit, pc, &loc);
+  REQUIRE(err == FrontErr::OK);
+  return {loc.line, loc.column};
+}
+
+typedef std::pair<uint32_t, uint32_t> LineCol;
+
+TEST_CASE("Source map: every instruction maps to its token")
+{
+  const char* source = "1 2 +\n: SQ DUP * ;\n3 SQ";
+  V4FrontBuf plain = compile(source, 0);
+  CHECK(plain.source_map == nullptr);
+  CHECK(plain.source_map_size == 0);
+
+  V4FrontBuf buf = compile(source, V4FRONT_OPT_SOURCE_MAP);
+  CHECK(flatten(buf) == flatten(plain));  // The code is unchanged
+  REQUIRE(buf.source_map != nullptr);
+
+  // Main: LIT 1 @0, LIT 2 @5, ADD @10, LIT 3 @11, CALL @16, RET @19
+  CHECK(where(buf, -1, 0) == LineCol(1, 1));
+  CHECK(where(buf, -1, 3) == LineCol(1, 1));  // Inside the instruction
+  CHECK(where(buf, -1, 5) == LineCol(1, 3));
+  CHECK(where(buf, -1, 10) == LineCol(1, 5));
+  CHECK(where(buf, -1, 11) == LineCol(3, 1));
+  CHECK(where(buf, -1, 16) == LineCol(3, 3));
+  CHECK(where(buf, -1, 19) == LineCol(3, 3));  // The final RET
+
+  // SQ: DUP @0, MUL @1, RET @2 (from ;)
+  CHECK(where(buf, 0, 0) == LineCol(2, 6));
+  CHECK(where(buf, 0, 1) == LineCol(2, 10));
+  CHECK(where(buf, 0, 2) == LineCol(2, 12));
+
+  V4FrontSourceLoc loc;
+  v4front_err err =
+      v4front_source_map_lookup(buf.source_map, buf.source_map_size, 0, 1, &loc);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(loc.offset == 15);
+
+  // No entry: an unknown unit
+  err = v4front_source_map_lookup(buf.source_map, buf.source_map_size, 5, 0, &loc);
+  CHECK(err == FrontErr::OK);
+  CHECK(loc.line == 0);
+
+  v4front_free(&buf);
+  v4front_free(&plain);
+}
+
+TEST_CASE("Source map: offsets follow the passes")
+{
+  const char* source = "2 3 +\nDUP DROP\n: W 1 + ;\n5 W";
+  V4FrontBuf plain = compile(source, 0, 2);
+  V4FrontBuf buf = compile(source, V4FRONT_OPT_SOURCE_MAP, 2);
+  CHECK(flatten(buf) == flatten(plain));
+
+  // 2 3 + folds into one literal; DUP DROP is gone; W is inlined as 5 1+
+  std::vector<uint8_t> main_code(buf.data, buf.data + buf.size);
+  REQUIRE(main_code.size() >= 6);
+  CHECK(main_code[0] == op(Op::LIT));
+  CHECK(where(buf, -1, 0) == LineCol(1, 1));
+  CHECK(where(buf, -1, 5).first == 4);
+
+  // Every instruction has a position
+  for (uint32_t pc = 0; pc < buf.size; pc++)
+    CHECK(where(buf, -1, pc).first > 0);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    for (uint32_t pc = 0; pc < buf.words[i].code_len; pc++)
+      CHECK(where(buf, i, pc).first == 3);
+  }
+
+  v4front_free(&buf);
+  v4front_free(&plain);
+}
+
+TEST_CASE("Source map: stripped words and superinstructions")
+{
+  const uint8_t DUP_MUL = 0xA0;
+  const V4FrontSuperinstruction table[] = {{DUP_MUL, 2, {op(Op::DUP), op(Op::MUL)}}};
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_SOURCE_MAP | V4FRONT_OPT_STRIP_UNUSED;
+  options.superinstructions = table;
+  options.superinstruction_count = 1;
+
+  V4FrontBuf buf;
+  v4front_err err = v4front_compile_with_options(
+      nullptr, ": UNUSED 1 ;\n: SQ 7 DUP * ;\nSQ", &options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  REQUIRE(buf.word_count == 1);
+  REQUIRE(buf.words[0].code_len == 7);  // LIT 7, DUP_MUL, RET
+
+  // SQ is word 0 now
+  CHECK(where(buf, 0, 0) == LineCol(2, 6));
+  CHECK(where(buf, 0, 5) == LineCol(2, 8));
+  CHECK(where(buf, 0, 6) == LineCol(2, 14));
+  CHECK(where(buf, -1, 0) == LineCol(3, 1));
+  V4FrontSourceLoc loc;
+  err = v4front_source_map_lookup(buf.source_map, buf.source_map_size, 1, 0, &loc);
+  CHECK(err == FrontErr::OK);
+  CHECK(loc.line == 0);
+  v4front_free(&buf);
+}
+
+TEST_CASE("Source map: a stream matches one compilation")
+{
+  const char* source = ": A 1 + ;\n\n  5 A\n( note ) A 7\n";
+  V4FrontBuf whole = compile(source, V4FRONT_OPT_SOURCE_MAP);
+
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_SOURCE_MAP;
+  V4FrontStream* stream;
+  v4front_err err = v4front_stream_begin(nullptr, &options, &stream);
+  REQUIRE(err == FrontErr::OK);
+  size_t len = strlen(source);
+  for (size_t at = 0; at < len; at += 3)
+  {
+    size_t n = len - at < 3 ? len - at : 3;
+    err = v4front_stream_feed(stream, source + at, n, nullptr);
+    REQUIRE(err == FrontErr::OK);
+  }
+  V4FrontBuf streamed;
+  err = v4front_stream_end(stream, &streamed, nullptr);
+  REQUIRE(err == FrontErr::OK);
+
+  CHECK(flatten(streamed) == flatten(whole));
+  REQUIRE(streamed.source_map_size == whole.source_map_size);
+  CHECK(memcmp(streamed.source_map, whole.source_map, whole.source_map_size) == 0);
+  CHECK(where(whole, -1, 0) == LineCol(3, 3));
+  CHECK(where(whole, -1, 8) == LineCol(4, 10));
+
+  v4front_free(&streamed);
+  v4front_free(&whole);
+}
+
+TEST_CASE("Source map: saved as the debug section")
+{
+  V4FrontBuf buf = compile("1 2 +\n: W 3 * ;\nW", V4FRONT_OPT_SOURCE_MAP);
+  std::vector<uint8_t> map(buf.source_map, buf.source_map + buf.source_map_size);
+
+  SUBCASE("Plain file")
+  {
+    REQUIRE(v4front_save_bytecode(&buf, "test_source_map.v4b") == 0);
+    V4FrontBuf loaded;
+    REQUIRE(v4front_load_bytecode("test_source_map.v4b", &loaded) == 0);
+    CHECK(flatten(loaded) == flatten(buf));
+    REQUIRE(loaded.source_map_size == map.size());
+    CHECK(std::vector<uint8_t>(loaded.source_map, loaded.source_map + map.size()) ==
+          map);
+    v4front_free(&loaded);
+
+    // A mapped file is looked up in place
+    V4FrontMappedBytecode mapped;
+    REQUIRE(v4front_map_bytecode("test_source_map.v4b", &mapped) == 0);
+    REQUIRE(mapped.debug_size == map.size());
+    V4FrontSourceLoc loc;
+    v4front_err err =
+        v4front_source_map_lookup(mapped.debug, mapped.debug_size, 0, 5, &loc);
+    CHECK(err == FrontErr::OK);
+    CHECK(loc.line == 2);
+    CHECK(loc.column == 7);
+    v4front_unmap_bytecode(&mapped);
+  }
+
+  SUBCASE("Compressed file")
+  {
+    REQUIRE(v4front_save_bytecode_with_flags(&buf, "test_source_map.v4b",
+                                             V4B_SAVE_COMPRESS) == 0);
+    V4FrontBuf loaded;
+    REQUIRE(v4front_load_bytecode("test_source_map.v4b", &loaded) == 0);
+    CHECK(flatten(loaded) == flatten(buf));
+    REQUIRE(loaded.source_map_size == map.size());
+    CHECK(std::vector<uint8_t>(loaded.source_map, loaded.source_map + map.size()) ==
+          map);
+    v4front_free(&loaded);
+  }
+
+  remove("test_source_map.v4b");
+  v4front_free(&buf);
+}
+
+TEST_CASE("Source map: bad input")
+{
+  V4FrontBuf buf = compile("1 2 3 4 5", V4FRONT_OPT_SOURCE_MAP);
+  V4FrontSourceLoc loc;
+  v4front_err err =
+      v4front_source_map_lookup(buf.source_map, buf.source_map_size, -1, 0, nullptr);
+  CHECK(err == FrontErr::BufferTooSmall);
+  err = v4front_source_map_lookup(nullptr, 0, -1, 0, &loc);
+  CHECK(err == FrontErr::InvalidImage);
+
+  // Truncated maps fail once the reader runs out
+  for (uint32_t size = 1; size + 1 < buf.source_map_size; size++)
+  {
+    err = v4front_source_map_lookup(buf.source_map, size, -1, 100, &loc);
+    CHECK(err == FrontErr::InvalidImage);
+    CHECK(loc.line == 0);
+  }
+
+  std::vector<uint8_t> bad(buf.source_map, buf.source_map + buf.source_map_size);
+  bad[0] = 99;  // Unknown version
+  err = v4front_source_map_lookup(bad.data(), bad.size(), -1, 0, &loc);
+  CHECK(err == FrontErr::InvalidImage);
+  v4front_free(&buf);
+
+  // Batches link code only
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_SOURCE_MAP;
+  V4FrontModule module = {"1", 1};
+  V4FrontBuf out;
+  err = v4front_compile_batch(nullptr, &module, 1, &options, 1, &out, nullptr, nullptr);
+  CHECK(err == FrontErr::InvalidOption);
+}
@@ -0,0 +1,291 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+static V4FrontBuf compile(const char* source, uint32_t flags, uint32_t opt_level = 0,
+                          V4FrontContext* ctx = nullptr)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  options.opt_level = opt_level;
+  V4FrontBuf buf;
+  v4front_err err = v4front_compile_with_options(ctx, source, &options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  return buf;
+}
+
+// Effect of the named word as "known in out max_data max_return"
+static std::string effect(const V4FrontBuf& buf, const char* name)
+{
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    if (strcmp(buf.words[i].name, name) != 0)
+      continue;
+    const V4FrontStackEffect& e = buf.words[i].effect;
+    return std::to_string(e.known) + " " + std::to_string(e.in) + " " +
+           std::to_string(e.out) + " " + std::to_string(e.max_data) + " " +
+           std::to_string(e.max_return);
+  }
+  return "missing";
+}
+
+TEST_CASE("Stack effects: straight-line words and calls")
+{
+  const char* source =
+      ": SQ DUP * ;\n"           // ( n -- n^2 ), 2 deep
+      ": ADD3 + + ;\n"           // ( a b c -- sum )
+      ": QUAD SQ SQ ;\n"         // Calls keep the callee's peak
+      ": PUSH3 1 2 3 ;\n"        // ( -- 1 2 3 )
+      ": RSTACK >R >R R> R> ;\n"  // ( a b -- a b ), 2 return cells
+      ": CAST 7 PUSH3 ADD3 ;\n"   // ( -- 7 6 ), 4 deep inside PUSH3
+      "3 QUAD";
+  V4FrontBuf plain = compile(source, 0);
+  CHECK(effect(plain, "SQ") == "0 0 0 0 0");  // Not requested
+
+  V4FrontBuf buf = compile(source, V4FRONT_OPT_STACK_EFFECTS);
+  CHECK(flatten(buf) == flatten(plain));  // The code is unchanged
+  CHECK(effect(buf, "SQ") == "1 1 1 2 0");
+  CHECK(effect(buf, "ADD3") == "1 3 1 3 0");
+  CHECK(effect(buf, "QUAD") == "1 1 1 2 0");
+  CHECK(effect(buf, "PUSH3") == "1 0 3 3 0");
+  CHECK(effect(buf, "RSTACK") == "1 2 2 2 2");
+  CHECK(effect(buf, "CAST") == "1 0 2 4 0");
+  v4front_free(&buf);
+  v4front_free(&plain);
+}
+
+TEST_CASE("Stack effects: control flow")
+{
+  const char* source =
+      ": ABS2 DUP 0< IF 0 SWAP - THEN ;\n"       // Balanced IF
+      ": PICK1 IF 1 ELSE 2 THEN ;\n"             // ( flag -- n )
+      ": SUM 0 SWAP 0 DO I + LOOP ;\n"           // ( n -- sum ), loop on R:
+      ": EARLY DUP 0= IF DROP 0 EXIT THEN 1 + ;\n"  // Both exits leave 1 cell
+      ": SPIN BEGIN 1 DROP AGAIN ;\n"            // Never returns
+      ": COUNT DUP IF 1 - RECURSE THEN ;\n"      // Tail call or not
+      "5 SUM";
+  V4FrontBuf buf = compile(source, V4FRONT_OPT_STACK_EFFECTS);
+  CHECK(effect(buf, "ABS2") == "1 1 1 3 0");
+  CHECK(effect(buf, "PICK1") == "1 1 1 1 0");
+  CHECK(effect(buf, "SUM").substr(0, 6) == "1 1 1 ");
+  CHECK(effect(buf, "SUM").back() == '2');  // Limit and index
+  CHECK(effect(buf, "EARLY") == "1 1 1 3 0");
+  CHECK(effect(buf, "SPIN") == "1 0 0 1 0");
+  CHECK(effect(buf, "COUNT") == "0 0 0 0 0");  // Non-tail RECURSE
+  v4front_free(&buf);
+
+  // Lowered to a jump, the tail call is a loop with a fixed effect
+  buf = compile(": COUNT DUP IF 1 - RECURSE THEN ;",
+                V4FRONT_OPT_STACK_EFFECTS | V4FRONT_OPT_TAIL_CALLS);
+  CHECK(effect(buf, "COUNT") == "1 1 1 2 0");
+  v4front_free(&buf);
+
+  // The passes run on the code but not on the effects
+  buf = compile(source, V4FRONT_OPT_STACK_EFFECTS, 2);
+  CHECK(effect(buf, "PICK1") == "1 1 1 1 0");
+  CHECK(effect(buf, "EARLY") == "1 1 1 3 0");
+  v4front_free(&buf);
+}
+
+TEST_CASE("Stack effects: unbalanced definitions are errors")
+{
+  const char* bad[] = {
+      ": W IF 1 2 ELSE 3 THEN ;",   // Branches differ
+      ": W IF 1 THEN ;",            // Only one branch pushes
+      ": W BEGIN 1 DUP UNTIL ;",    // Each iteration grows the stack
+      ": W DUP IF EXIT THEN DROP ;",  // Exits differ
+      ": W DUP IF >R THEN ;",       // Return stack differs
+      ": W ?DUP ;",                 // Variable by definition
+  };
+  for (const char* source : bad)
+  {
+    CAPTURE(source);
+    V4FrontCompileOptions options = {};
+    options.flags = V4FRONT_OPT_STACK_EFFECTS;
+    V4FrontBuf buf;
+    V4FrontError error;
+    v4front_err err =
+        v4front_compile_with_options(nullptr, source, &options, &buf, &error);
+    CHECK(err == FrontErr::StackImbalance);
+    CHECK(std::string(error.token) == ";");
+
+    // Without the option these are accepted as before
+    buf = compile(source, 0);
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Stack effects: unknown effects")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 5);
+  REQUIRE(err == FrontErr::OK);
+
+  const char* source =
+      ": A 1 + ;\n"
+      ": OUT 65 EMIT ;\n"  // SYS
+      ": VIA OUT A ;\n"    // Calls a word of unknown effect
+      ": B A A ;\n"        // Still known: no context call yet
+      ": H HOST ;\n"
+      ": C A ;\n";  // After the first context call
+  V4FrontBuf buf = compile(source, V4FRONT_OPT_STACK_EFFECTS, 0, ctx);
+  CHECK(effect(buf, "A") == "1 1 1 2 0");
+  CHECK(effect(buf, "OUT").front() == '0');
+  CHECK(effect(buf, "VIA").front() == '0');
+  CHECK(effect(buf, "B") == "1 1 1 2 0");
+  CHECK(effect(buf, "H").front() == '0');
+  CHECK(effect(buf, "C").front() == '0');
+  v4front_free(&buf);
+
+  // Words reused from the word cache get their effect too
+  err = v4front_context_set_word_cache(ctx, 1 << 20);
+  REQUIRE(err == FrontErr::OK);
+  for (int run = 0; run < 2; run++)
+  {
+    buf = compile(": SQ DUP * ;\n: FOUR SQ SQ ;", V4FRONT_OPT_STACK_EFFECTS, 0, ctx);
+    CHECK(effect(buf, "FOUR") == "1 1 1 2 0");
+    v4front_free(&buf);
+  }
+  V4FrontWordCacheStats stats;
+  v4front_context_get_word_cache_stats(ctx, &stats);
+  CHECK(stats.reused == 2);
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Stack effects: batches keep each module's effects")
+{
+  V4FrontCompileOptions options = {};
+  options.flags = V4FRONT_OPT_STACK_EFFECTS;
+  V4FrontModule modules[] = {{": SQ DUP * ;", 12}, {": USE SQ 1 + ;\n: PAIR 1 2 ;", 27}};
+  V4FrontBuf out;
+  v4front_err err =
+      v4front_compile_batch(nullptr, modules, 2, &options, 1, &out, nullptr, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(effect(out, "SQ") == "1 1 1 2 0");
+  CHECK(effect(out, "USE").front() == '0');  // Imports are resolved at link time
+  CHECK(effect(out, "PAIR") == "1 0 2 2 0");
+  v4front_free(&out);
+}
+
+// Worst-case resources of the named word as a task entry
+static V4FrontTaskResources task(const V4FrontBuf& buf, const char* name,
+                                 const V4FrontStackEffect* vm_ops = nullptr)
+{
+  V4FrontTaskResources r = {};
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    if (strcmp(buf.words[i].name, name) == 0)
+    {
+      v4front_err err = v4front_task_resources(&buf, i, vm_ops, &r);
+      REQUIRE(err == FrontErr::OK);
+      return r;
+    }
+  }
+  FAIL("no word ", name);
+  return r;
+}
+
+TEST_CASE("Task resources: bounded entries")
+{
+  V4FrontBuf buf = compile(
+      ": LEAF 1 2 + ;\n"
+      ": WORKER 0 10 0 DO LEAF + LOOP ;\n"  // DO frame plus a call
+      ": LW 7 L! 2 L@ 2 ;\n"                // Three local slots
+      ": T LW LW ;\n"
+      ": T2 1 L!0 LW L@0 + ;\n"             // Its own slot plus LW's
+      ": SPIN BEGIN YIELD AGAIN ;\n",
+      0);
+
+  V4FrontTaskResources r = task(buf, "LEAF");
+  CHECK(r.reason == V4FRONT_TASK_BOUNDED);
+  CHECK(r.culprit == -1);
+  CHECK(r.data_depth == 2);
+  CHECK(r.return_depth == 1);  // The entry's own return address
+  CHECK(r.call_depth == 0);
+
+  r = task(buf, "WORKER");
+  CHECK(r.reason == V4FRONT_TASK_BOUNDED);
+  CHECK(r.data_depth == 5);    // Sum, index and limit while LOOP compares
+  CHECK(r.return_depth == 4);  // Entry, limit, index, LEAF
+  CHECK(r.call_depth == 1);
+
+  CHECK(task(buf, "LW").locals == 3);
+  CHECK(task(buf, "T").locals == 3);  // Calls run one after the other
+  r = task(buf, "T2");
+  CHECK(r.locals == 4);
+  CHECK(r.data_depth == 2);
+  CHECK(task(buf, "SPIN").reason == V4FRONT_TASK_BOUNDED);
+  v4front_free(&buf);
+}
+
+TEST_CASE("Task resources: what cannot be bounded")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 40);
+  REQUIRE(err == FrontErr::OK);
+  V4FrontBuf buf = compile(
+      ": DOWN DUP IF 1 - RECURSE THEN ;\n"  // Not lowered to a loop
+      ": RUN 5 DOWN ;\n"
+      ": OUT 65 EMIT ;\n"
+      ": GROW BEGIN 1 AGAIN ;\n"
+      ": EXT HOST ;\n",
+      0, 0, ctx);
+
+  V4FrontTaskResources r = task(buf, "RUN");
+  CHECK(r.reason == V4FRONT_TASK_RECURSION);
+  CHECK(r.culprit == 0);  // DOWN
+  CHECK(r.data_depth == 0);
+  CHECK(task(buf, "GROW").reason == V4FRONT_TASK_UNBALANCED);
+  CHECK(task(buf, "EXT").reason == V4FRONT_TASK_EXTERNAL_CALL);
+
+  // SYS takes its ID and argument; the host knows its own system calls
+  r = task(buf, "OUT");
+  CHECK(r.reason == V4FRONT_TASK_VM_OPCODE);
+  CHECK(r.culprit == 2);
+  std::vector<V4FrontStackEffect> vm_ops(256, V4FrontStackEffect{0, 0, 0, 0, 0});
+  vm_ops[0x60] = {1, 2, 0, 2, 0};  // SYS ( c id -- )
+  r = task(buf, "OUT", vm_ops.data());
+  CHECK(r.reason == V4FRONT_TASK_BOUNDED);
+  CHECK(r.data_depth == 2);
+  v4front_free(&buf);
+
+  // Lowered to a jump, the recursion is a loop
+  buf = compile(": DOWN DUP IF 1 - RECURSE THEN ;\n: RUN 5 DOWN ;",
+                V4FRONT_OPT_TAIL_CALLS, 0);
+  r = task(buf, "RUN");
+  CHECK(r.reason == V4FRONT_TASK_BOUNDED);
+  CHECK(r.data_depth == 2);
+  CHECK(r.return_depth == 2);
+
+  V4FrontTaskResources out;
+  err = v4front_task_resources(&buf, 2, nullptr, &out);
+  CHECK(err == FrontErr::UnknownToken);
+  err = v4front_task_resources(nullptr, 0, nullptr, &out);
+  CHECK(err == FrontErr::BufferTooSmall);
+  v4front_free(&buf);
+  v4front_context_destroy(ctx);
+}
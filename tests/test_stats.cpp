@@ -0,0 +1,98 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <string>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+static uint64_t phase_sum(const V4FrontStats& s)
+{
+  return s.tokenize_ns + s.keyword_ns + s.lookup_ns + s.emit_ns + s.backpatch_ns +
+         s.finish_ns;
+}
+
+TEST_CASE("Stats: counts of a small script")
+{
+  V4FrontBuf buf;
+  V4FrontStats stats;
+  v4front_err err = v4front_compile_with_stats(nullptr, ": SQ DUP * ;\n3 SQ 4 SQ",
+                                               nullptr, &buf, nullptr, &stats);
+  REQUIRE(err == FrontErr::OK);
+  if (!stats.enabled)
+  {
+    // Built without V4FRONT_ENABLE_STATS: the hooks are compiled out
+    CHECK(stats.tokens == 0);
+    CHECK(stats.total_ns == 0);
+    v4front_free(&buf);
+    return;
+  }
+
+  CHECK(stats.tokens == 8);  // The name after ':' is read by ':' itself
+  CHECK(stats.literals == 2);
+  CHECK(stats.words == 1);
+  CHECK(stats.lookups == 6);  // Primitives and numbers go through the dictionary first
+  CHECK(stats.bytes_emitted == buf.size + buf.words[0].code_len);
+  CHECK(stats.allocations >= 1);
+  CHECK(phase_sum(stats) <= stats.total_ns);
+  v4front_free(&buf);
+}
+
+TEST_CASE("Stats: lookups in the context and jump resolution")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "HOST", 9);
+  REQUIRE(err == FrontErr::OK);
+
+  std::string source;
+  for (int i = 0; i < 2000; i++)
+    source += "HOST IF 1 ELSE 2 THEN ( a comment ) ";
+  V4FrontBuf buf;
+  V4FrontStats stats;
+  err = v4front_compile_with_stats(ctx, source.c_str(), nullptr, &buf, nullptr, &stats);
+  REQUIRE(err == FrontErr::OK);
+  if (stats.enabled)
+  {
+    CHECK(stats.tokens == 12000);
+    CHECK(stats.literals == 4000);
+    CHECK(stats.words == 0);
+    CHECK(stats.lookups == 2 * 6000);  // HOST and the numbers look in both places
+    CHECK(stats.backpatch_ns > 0);
+    CHECK(stats.lookup_ns > 0);
+    CHECK(stats.tokenize_ns > 0);
+    CHECK(stats.reallocations > 0);  // Main code grew past its chunk
+    CHECK(stats.bytes_emitted == buf.size);
+  }
+  v4front_free(&buf);
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Stats: errors and optional parameters")
+{
+  V4FrontBuf buf;
+  V4FrontStats stats;
+  V4FrontError error;
+  v4front_err err =
+      v4front_compile_with_stats(nullptr, "1 2 NOPE 3", nullptr, &buf, &error, &stats);
+  CHECK(err == FrontErr::UnknownToken);
+  CHECK(error.position == 4);
+  if (stats.enabled)
+  {
+    CHECK(stats.tokens == 3);  // Up to the failing token
+    CHECK(stats.literals == 2);
+    CHECK(stats.bytes_emitted == 0);
+  }
+
+  // Without stats this is v4front_compile_with_options()
+  err = v4front_compile_with_stats(nullptr, "1 2 +", nullptr, &buf, nullptr, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(buf.size == 12);
+  v4front_free(&buf);
+
+  err = v4front_compile_with_stats(nullptr, "1", nullptr, nullptr, nullptr, &stats);
+  CHECK(err == FrontErr::BufferTooSmall);
+  CHECK(stats.tokens == 0);
+}
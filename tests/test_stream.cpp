@@ -0,0 +1,222 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+static const char* kProgram =
+    "\\ Streaming test program\n"
+    "10 CONSTANT TEN\n"
+    "VARIABLE COUNTER\n"
+    ": SQUARE ( n -- n*n ) DUP * ;\n"
+    ": SUM 0 SWAP 0 DO\n"
+    "    I SQUARE +\n"
+    "  LOOP ;\n"
+    "TEN SUM DROP\n"
+    "5 0 DO I DROP\n"
+    "LOOP\n"
+    "1 IF 2 ELSE 3\n"
+    "THEN COUNTER !\n"
+    ": LOCALS L@ 0 L@ 1 + L! 2 ;\n"
+    "2 3 + 4 * DROP";
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+static std::vector<uint8_t> compile_whole(const char* source,
+                                          const V4FrontCompileOptions* options)
+{
+  V4FrontBuf buf;
+  v4front_err err = v4front_compile_with_options(nullptr, source, options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> out = flatten(buf);
+  v4front_free(&buf);
+  return out;
+}
+
+// Feed source in chunks of chunk_len bytes
+static std::vector<uint8_t> compile_streamed(const char* source, size_t chunk_len,
+                                             const V4FrontCompileOptions* options)
+{
+  V4FrontStream* stream;
+  v4front_err err = v4front_stream_begin(nullptr, options, &stream);
+  REQUIRE(err == FrontErr::OK);
+  size_t len = strlen(source);
+  for (size_t at = 0; at < len; at += chunk_len)
+  {
+    size_t n = len - at < chunk_len ? len - at : chunk_len;
+    err = v4front_stream_feed(stream, source + at, n, nullptr);
+    REQUIRE(err == FrontErr::OK);
+  }
+  V4FrontBuf buf;
+  err = v4front_stream_end(stream, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> out = flatten(buf);
+  v4front_free(&buf);
+  return out;
+}
+
+TEST_CASE("Stream: chunked source compiles like the whole source")
+{
+  SUBCASE("Default options, every chunk size")
+  {
+    std::vector<uint8_t> expected = compile_whole(kProgram, nullptr);
+    for (size_t chunk = 1; chunk <= strlen(kProgram); chunk++)
+    {
+      CAPTURE(chunk);
+      CHECK(compile_streamed(kProgram, chunk, nullptr) == expected);
+    }
+  }
+
+  SUBCASE("Optimizations see the same look-ahead")
+  {
+    V4FrontCompileOptions options = {};
+    options.opt_level = 2;
+    options.flags = V4FRONT_OPT_LOOP_LOCALS;
+    std::vector<uint8_t> expected = compile_whole(kProgram, &options);
+    for (size_t chunk = 1; chunk <= 16; chunk++)
+    {
+      CAPTURE(chunk);
+      CHECK(compile_streamed(kProgram, chunk, &options) == expected);
+    }
+  }
+
+  SUBCASE("Empty stream")
+  {
+    CHECK(compile_streamed("", 1, nullptr) == compile_whole("", nullptr));
+  }
+}
+
+TEST_CASE("Stream: errors are reported relative to the stream")
+{
+  V4FrontStream* stream;
+  V4FrontError error;
+  v4front_err err;
+
+  SUBCASE("Unknown token on a later line")
+  {
+    err = v4front_stream_begin(nullptr, nullptr, &stream);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_stream_feed(stream, "1 2 +\n3 ", 8, &error);
+    CHECK(err == FrontErr::OK);
+    err = v4front_stream_feed(stream, "FOO\n", 4, &error);
+    CHECK(err == FrontErr::UnknownToken);
+    CHECK(error.position == 8);
+    CHECK(error.line == 2);
+    CHECK(error.column == 3);
+    CHECK(strcmp(error.token, "FOO") == 0);
+
+    // The stream stays failed
+    err = v4front_stream_feed(stream, "4\n", 2, &error);
+    CHECK(err == FrontErr::UnknownToken);
+    V4FrontBuf buf;
+    err = v4front_stream_end(stream, &buf, &error);
+    CHECK(err == FrontErr::UnknownToken);
+  }
+
+  SUBCASE("Unclosed definition at the end")
+  {
+    err = v4front_stream_begin(nullptr, nullptr, &stream);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_stream_feed(stream, "1 DROP\n: X 1", 12, &error);
+    CHECK(err == FrontErr::OK);
+    V4FrontBuf buf;
+    err = v4front_stream_end(stream, &buf, &error);
+    CHECK(err == FrontErr::UnclosedColon);
+    CHECK(error.line == 2);
+    CHECK(error.column == 6);
+  }
+
+  SUBCASE("NUL bytes are rejected")
+  {
+    err = v4front_stream_begin(nullptr, nullptr, &stream);
+    REQUIRE(err == FrontErr::OK);
+    err = v4front_stream_feed(stream, "1 2\0 3", 6, &error);
+    CHECK(err == FrontErr::NulInSource);
+    CHECK(error.position == 3);
+    err = v4front_stream_end(stream, nullptr, nullptr);
+    CHECK(err == FrontErr::NulInSource);
+  }
+
+  SUBCASE("Invalid options fail at begin")
+  {
+    V4FrontCompileOptions options = {};
+    options.superinstruction_count = 1;
+    err = v4front_stream_begin(nullptr, &options, &stream);
+    CHECK(err == FrontErr::InvalidOption);
+    CHECK(stream == nullptr);
+  }
+}
+
+// Tracks live bytes through a size header in front of every block
+struct TrackingHeap
+{
+  size_t live;
+  size_t peak;
+};
+
+static void* tracking_alloc(void* user, size_t size)
+{
+  TrackingHeap* heap = static_cast<TrackingHeap*>(user);
+  size_t* block = static_cast<size_t*>(malloc(size + 16));
+  if (!block)
+    return nullptr;
+  block[0] = size;
+  heap->live += size;
+  if (heap->live > heap->peak)
+    heap->peak = heap->live;
+  return reinterpret_cast<uint8_t*>(block) + 16;
+}
+
+static void tracking_free(void* user, void* ptr)
+{
+  size_t* block = reinterpret_cast<size_t*>(static_cast<uint8_t*>(ptr) - 16);
+  static_cast<TrackingHeap*>(user)->live -= block[0];
+  free(block);
+}
+
+TEST_CASE("Stream: buffered source stays bounded")
+{
+  TrackingHeap heap = {0, 0};
+  V4FrontAllocator allocator = {tracking_alloc, tracking_free, &heap};
+  V4FrontCompileOptions options = {};
+  options.allocator = &allocator;
+
+  V4FrontStream* stream;
+  v4front_err err = v4front_stream_begin(nullptr, &options, &stream);
+  REQUIRE(err == FrontErr::OK);
+  std::string line = "\\ a comment line that produces no code at all, padded out\n";
+  size_t total = 0;
+  for (int i = 0; i < 4000; i++)
+  {
+    err = v4front_stream_feed(stream, line.data(), line.size(), nullptr);
+    REQUIRE(err == FrontErr::OK);
+    total += line.size();
+  }
+  V4FrontBuf buf;
+  err = v4front_stream_end(stream, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  v4front_free(&buf);
+
+  CHECK(total > 200 * 1024);
+  CHECK(heap.peak < 16 * 1024);
+  CHECK(heap.live == 0);
+}
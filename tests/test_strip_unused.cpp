@@ -0,0 +1,112 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void compile_opt(V4FrontContext* ctx, const char* source, uint32_t flags,
+                        V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(ctx, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> bytes(const uint8_t* code, size_t len)
+{
+  return std::vector<uint8_t>(code, code + len);
+}
+
+static const uint32_t kStrip = V4FRONT_OPT_STRIP_UNUSED;
+
+TEST_CASE("Dead word elimination")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Unreachable words are dropped and indices compacted")
+  {
+    compile_opt(nullptr, ": A 1 ; : UNUSED 5 ; : B A ; B", kStrip, &buf);
+    REQUIRE(buf.word_count == 2);
+    CHECK(strcmp(buf.words[0].name, "A") == 0);
+    CHECK(strcmp(buf.words[1].name, "B") == 0);
+    CHECK(bytes(buf.words[1].code, buf.words[1].code_len) ==
+          std::vector<uint8_t>{op(Op::CALL), 0, 0, op(Op::RET)});
+    CHECK(bytes(buf.data, buf.size) ==
+          std::vector<uint8_t>{op(Op::CALL), 1, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Words reached only through other words are kept")
+  {
+    compile_opt(nullptr, ": A 1 ; : B 2 ; : C A ; : D B C ; : E 9 ; D", kStrip, &buf);
+    REQUIRE(buf.word_count == 4);
+    CHECK(strcmp(buf.words[3].name, "D") == 0);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Recursive words do not keep themselves alive")
+  {
+    compile_opt(nullptr, ": LOOPY RECURSE ; : F 1 ; F", kStrip, &buf);
+    REQUIRE(buf.word_count == 1);
+    CHECK(strcmp(buf.words[0].name, "F") == 0);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("A library without main code keeps nothing")
+  {
+    compile_opt(nullptr, ": A 1 ; : B A ;", kStrip, &buf);
+    CHECK(buf.word_count == 0);
+    CHECK(buf.words == nullptr);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Inlined words become dead")
+  {
+    compile_opt(nullptr, ": SQ DUP * ; : K 3 ; K SQ", kStrip | V4FRONT_OPT_INLINE, &buf);
+    CHECK(buf.word_count == 0);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Off by default")
+  {
+    compile_opt(nullptr, ": A 1 ; : UNUSED 5 ; : B A ; B", 0, &buf);
+    CHECK(buf.word_count == 3);
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Dead word elimination: context words disable stripping")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_register_word(ctx, "LIBWORD", 0);
+  REQUIRE(err == FrontErr::OK);
+
+  V4FrontBuf buf;
+  compile_opt(ctx, ": UNUSED 5 ; LIBWORD", kStrip, &buf);
+  CHECK(buf.word_count == 1);  // CALL 0 (LIBWORD) looks like a call to UNUSED
+  CHECK(bytes(buf.data, buf.size) ==
+        std::vector<uint8_t>{op(Op::CALL), 0, 0, op(Op::RET)});
+  v4front_free(&buf);
+
+  // Without a context reference the local dictionary is stripped as usual
+  compile_opt(ctx, ": UNUSED 5 ; 1", kStrip, &buf);
+  CHECK(buf.word_count == 0);
+  v4front_free(&buf);
+
+  v4front_context_destroy(ctx);
+}
@@ -0,0 +1,175 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Fused opcodes of a hypothetical VM (outside opcodes.def)
+static const uint8_t LIT_ADD = 0xA0;
+static const uint8_t DUP_LOAD = 0xA1;
+static const uint8_t LGET_LGET = 0xA2;
+static const uint8_t LIT0_EQ = 0xA3;
+static const uint8_t LIT0_EQ_JZ = 0xA4;
+
+static const V4FrontSuperinstruction kTable[] = {
+    {LIT_ADD, 2, {op(Op::LIT), op(Op::ADD)}},
+    {DUP_LOAD, 2, {op(Op::DUP), op(Op::LOAD)}},
+    {LGET_LGET, 2, {op(Op::LGET), op(Op::LGET)}},
+    {LIT0_EQ, 2, {op(Op::LIT0), op(Op::EQ)}},
+    {LIT0_EQ_JZ, 3, {op(Op::LIT0), op(Op::EQ), op(Op::JZ)}},
+};
+
+static v4front_err compile_fused(const char* source, const V4FrontSuperinstruction* table,
+                                 uint32_t count, V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.superinstructions = table;
+  options.superinstruction_count = count;
+  return v4front_compile_with_options(nullptr, source, &options, buf, nullptr);
+}
+
+// Fuse with table and return main code (word < 0) or the code of a word
+static std::vector<uint8_t> fused(const char* source,
+                                  const V4FrontSuperinstruction* table = kTable,
+                                  uint32_t count = sizeof(kTable) / sizeof(kTable[0]),
+                                  int word = -1)
+{
+  V4FrontBuf buf;
+  v4front_err err = compile_fused(source, table, count, &buf);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> code;
+  if (word < 0)
+  {
+    code.assign(buf.data, buf.data + buf.size);
+  }
+  else
+  {
+    REQUIRE(word < buf.word_count);
+    code.assign(buf.words[word].code, buf.words[word].code + buf.words[word].code_len);
+  }
+  v4front_free(&buf);
+  return code;
+}
+
+TEST_CASE("Superinstructions: operand-carrying windows")
+{
+  SUBCASE("LIT x ADD keeps the literal as the operand")
+  {
+    std::vector<uint8_t> expected = {LIT_ADD, 5, 0, 0, 0, op(Op::RET)};
+    CHECK(fused("5 +") == expected);
+  }
+
+  SUBCASE("DUP LOAD has no operand")
+  {
+    std::vector<uint8_t> expected = {op(Op::LIT), 100, 0, 0, 0, DUP_LOAD, op(Op::RET)};
+    CHECK(fused("100 DUP @") == expected);
+  }
+
+  SUBCASE("LGET a LGET b concatenates both indices")
+  {
+    std::vector<uint8_t> expected = {LGET_LGET, 0, 1, op(Op::ADD), op(Op::RET)};
+    CHECK(fused(": T L@ 0 L@ 1 + ;", kTable, 5, 0) == expected);
+  }
+}
+
+TEST_CASE("Superinstructions: branches")
+{
+  SUBCASE("The longest pattern wins and becomes a rel16 branch")
+  {
+    std::vector<uint8_t> expected = {
+        LIT0_EQ_JZ,  5, 0,        // 0: IF (-> 8)
+        op(Op::LIT), 7, 0, 0, 0,  // 3
+        op(Op::RET),              // 8
+    };
+    CHECK(fused(": T 0= IF 7 THEN ;", kTable, 5, 0) == expected);
+  }
+
+  SUBCASE("Without the branch entry only LIT0 EQ fuses")
+  {
+    std::vector<uint8_t> expected = {
+        LIT0_EQ,     op(Op::JZ), 5, 0,  // 0: IF (-> 9)
+        op(Op::LIT), 7,          0, 0, 0,
+        op(Op::RET),
+    };
+    CHECK(fused(": T 0= IF 7 THEN ;", kTable, 4, 0) == expected);
+  }
+
+  SUBCASE("Backward branches are re-encoded")
+  {
+    std::vector<uint8_t> expected = {
+        LIT_ADD,     5,    0, 0, 0,  // 0: BEGIN
+        op(Op::DUP),                 // 5
+        LIT0_EQ_JZ,  0xF7, 0xFF,     // 6: UNTIL (-> 0)
+        op(Op::RET),
+    };
+    CHECK(fused(": W BEGIN 5 + DUP 0= UNTIL ;", kTable, 5, 0) == expected);
+  }
+
+  SUBCASE("A window with a jump target inside is not fused")
+  {
+    std::vector<uint8_t> expected = {
+        op(Op::LIT), 5,    0, 0, 0,  // 0
+        op(Op::ADD),                 // 5: BEGIN
+        op(Op::JMP), 0xFC, 0xFF,     // 6: AGAIN (-> 5)
+    };
+    CHECK(fused("5 BEGIN + AGAIN") == expected);
+  }
+}
+
+TEST_CASE("Superinstructions: runs after the other passes")
+{
+  V4FrontCompileOptions options = {};
+  options.opt_level = 2;
+  options.superinstructions = kTable;
+  options.superinstruction_count = 5;
+  V4FrontBuf buf;
+
+  // Constant folding turns 2 3 + 4 + into one literal, so nothing fuses
+  v4front_err err =
+      v4front_compile_with_options(nullptr, "2 3 + 4 + DUP @", &options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> expected = {op(Op::LIT), 9, 0, 0, 0, DUP_LOAD, op(Op::RET)};
+  CHECK(std::vector<uint8_t>(buf.data, buf.data + buf.size) == expected);
+  v4front_free(&buf);
+}
+
+TEST_CASE("Superinstructions: invalid tables are rejected")
+{
+  const V4FrontSuperinstruction bad[] = {
+      {0xA0, 1, {op(Op::DUP)}},                               // Too short
+      {0xA0, 5, {op(Op::DUP), op(Op::DUP)}},                  // Too long
+      {op(Op::ADD), 2, {op(Op::DUP), op(Op::ADD)}},           // Existing opcode
+      {0xA0, 2, {op(Op::JZ), op(Op::DROP)}},                  // Branch not last
+      {0xA0, 2, {op(Op::LIT0), 0xEE}},                        // Unknown element
+      {0xA0, 2, {op(Op::LIT), op(Op::LIT)}},                  // 8 operand bytes
+      {0xA0, 3, {op(Op::LGET), op(Op::EQ), op(Op::JNZ)}},     // Operand + branch
+  };
+
+  for (const V4FrontSuperinstruction& entry : bad)
+  {
+    V4FrontBuf buf;
+    v4front_err err = compile_fused("1 2 +", &entry, 1, &buf);
+    CHECK(err == FrontErr::InvalidOption);
+  }
+
+  V4FrontBuf buf;
+  v4front_err err = compile_fused("1 2 +", nullptr, 1, &buf);
+  CHECK(err == FrontErr::InvalidOption);
+
+  // An empty table is the default
+  err = compile_fused("1 2 +", nullptr, 0, &buf);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(buf.size == 12);
+  v4front_free(&buf);
+}
@@ -0,0 +1,118 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void compile_opt(const char* source, uint32_t flags, V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.flags = flags;
+  V4FrontError error;
+  v4front_err err = v4front_compile_with_options(nullptr, source, &options, buf, &error);
+  REQUIRE_MESSAGE(err == FrontErr::OK, "Compilation failed: ", error.message);
+}
+
+static std::vector<uint8_t> bytes(const uint8_t* code, size_t len)
+{
+  return std::vector<uint8_t>(code, code + len);
+}
+
+TEST_CASE("Tail calls: RECURSE before RET becomes JMP")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("RECURSE at the end of an IF branch")
+  {
+    compile_opt(": CD DUP IF 1 - RECURSE THEN ;", V4FRONT_OPT_TAIL_CALLS, &buf);
+    REQUIRE(buf.word_count == 1);
+    std::vector<uint8_t> expected = {
+        op(Op::DUP),                     // 0
+        op(Op::JZ),  0x09, 0x00,         // 1: -> 13
+        op(Op::LIT), 1,    0,    0, 0,   // 4
+        op(Op::SUB),                     // 9
+        op(Op::JMP), 0xF3, 0xFF,         // 10: -> 0
+        op(Op::RET),                     // 13
+    };
+    CHECK(bytes(buf.words[0].code, buf.words[0].code_len) == expected);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("RECURSE directly before ;")
+  {
+    compile_opt(": F RECURSE ;", V4FRONT_OPT_TAIL_CALLS, &buf);
+    REQUIRE(buf.word_count == 1);
+    CHECK(bytes(buf.words[0].code, buf.words[0].code_len) ==
+          std::vector<uint8_t>{op(Op::JMP), 0xFD, 0xFF, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("RECURSE followed by the skip over ELSE")
+  {
+    compile_opt(": H DUP IF 1 - RECURSE ELSE DROP THEN ;", V4FRONT_OPT_TAIL_CALLS, &buf);
+    REQUIRE(buf.word_count == 1);
+    const uint8_t* code = buf.words[0].code;
+    REQUIRE(buf.words[0].code_len == 18);
+    CHECK(code[10] == op(Op::JMP));
+    CHECK(code[11] == 0xF3);
+    CHECK(code[12] == 0xFF);
+    CHECK(code[13] == op(Op::JMP));  // ELSE skip is untouched
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Tail calls: non-tail calls are kept")
+{
+  V4FrontBuf buf;
+
+  SUBCASE("Work after RECURSE")
+  {
+    compile_opt(": G DUP IF RECURSE 1 + THEN ;", V4FRONT_OPT_TAIL_CALLS, &buf);
+    REQUIRE(buf.word_count == 1);
+    const uint8_t* code = buf.words[0].code;
+    CHECK(code[4] == op(Op::CALL));
+    CHECK(code[5] == 0);
+    CHECK(code[6] == 0);
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Calls to other words")
+  {
+    compile_opt(": A DUP ; : B A ;", V4FRONT_OPT_TAIL_CALLS, &buf);
+    REQUIRE(buf.word_count == 2);
+    CHECK(bytes(buf.words[1].code, buf.words[1].code_len) ==
+          std::vector<uint8_t>{op(Op::CALL), 0, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Off by default")
+  {
+    compile_opt(": F RECURSE ;", 0, &buf);
+    REQUIRE(buf.word_count == 1);
+    CHECK(bytes(buf.words[0].code, buf.words[0].code_len) ==
+          std::vector<uint8_t>{op(Op::CALL), 0, 0, op(Op::RET)});
+    v4front_free(&buf);
+  }
+}
+
+TEST_CASE("Tail calls: lowered words can be inlined")
+{
+  V4FrontBuf buf;
+
+  // Without TCO the self CALL keeps F out of line. The inlined JMP is
+  // relative, so it loops on the inlined copy; main ends in it (no RET).
+  compile_opt(": F RECURSE ; F", V4FRONT_OPT_TAIL_CALLS | V4FRONT_OPT_INLINE, &buf);
+  CHECK(bytes(buf.data, buf.size) == std::vector<uint8_t>{op(Op::JMP), 0xFD, 0xFF});
+  v4front_free(&buf);
+}
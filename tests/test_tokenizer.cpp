@@ -0,0 +1,94 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+
+static std::vector<uint8_t> main_code(const char* source)
+{
+  V4FrontBuf buf;
+  char errmsg[128];
+  v4front_err err = v4front_compile(source, &buf, errmsg, sizeof(errmsg));
+  REQUIRE_MESSAGE(err == FrontErr::OK, errmsg);
+  std::vector<uint8_t> code(buf.data, buf.data + buf.size);
+  v4front_free(&buf);
+  return code;
+}
+
+// Value of the single LIT (LIT, imm32, RET) that source compiles to
+static int32_t literal_of(const char* source)
+{
+  std::vector<uint8_t> code = main_code(source);
+  REQUIRE(code.size() == 6);
+  uint32_t v = code[1] | (code[2] << 8) | (code[3] << 16) | (uint32_t(code[4]) << 24);
+  return static_cast<int32_t>(v);
+}
+
+TEST_CASE("Tokenizer: integer literals")
+{
+  CHECK(literal_of("42") == 42);
+  CHECK(literal_of("-10") == -10);
+  CHECK(literal_of("+7") == 7);
+  CHECK(literal_of("0x1F") == 31);
+  CHECK(literal_of("0XfF") == 255);
+  CHECK(literal_of("-0x10") == -16);
+  CHECK(literal_of("017") == 15);
+  CHECK(literal_of("0") == 0);
+  CHECK(literal_of("0xFFFFFFFF") == -1);
+  CHECK(literal_of("4294967296") == 0);
+  CHECK(literal_of("99999999999999999999999") == -1);  // Saturates first
+
+  const char* not_numbers[] = {"0x", "-0x", "08", "0x1G", "12a", "--1", "+-1"};
+  for (const char* text : not_numbers)
+  {
+    CAPTURE(text);
+    V4FrontBuf buf;
+    v4front_err err = v4front_compile(text, &buf, nullptr, 0);
+    CHECK(err == FrontErr::UnknownToken);
+  }
+}
+
+TEST_CASE("Tokenizer: long tokens are not truncated")
+{
+  V4FrontBuf buf;
+  V4FrontError error;
+
+  // 300 zeros followed by X used to be cut to 255 zeros and read as 0
+  std::string zeros = std::string(300, '0') + "X";
+  v4front_err err = v4front_compile_ex(zeros.c_str(), &buf, &error);
+  CHECK(err == FrontErr::UnknownToken);
+  CHECK(error.position == 0);
+
+  // A long literal is parsed in full
+  std::string padded = std::string(300, '0') + "7";
+  CHECK(literal_of(padded.c_str()) == 7);
+
+  // A long local index is parsed in full too
+  std::string local = ": T L@ " + std::string(300, '0') + "1 ;";
+  err = v4front_compile_ex(local.c_str(), &buf, &error);
+  REQUIRE(err == FrontErr::OK);
+  v4front_free(&buf);
+}
+
+TEST_CASE("Tokenizer: whitespace is the C-locale set only")
+{
+  // \v and \f separate tokens
+  CHECK(main_code("1\v2\f+") == main_code("1 2 +"));
+
+  // 0xA0 (no-break space in Latin-1) is part of the token
+  V4FrontBuf buf;
+  V4FrontError error;
+  v4front_err err = v4front_compile_ex("1\xA0" "2", &buf, &error);
+  CHECK(err == FrontErr::UnknownToken);
+  CHECK(strcmp(error.token, "1\xA0" "2") == 0);
+
+  // Non-ASCII bytes are valid in word names
+  std::vector<uint8_t> code = main_code(": \xC3\xA9T 5 ; \xC3\xA9T");
+  CHECK(code.size() == 4);  // CALL 0, RET
+}
@@ -5,6 +5,7 @@
 #include <v4/opcodes.hpp>
 
 #include "v4front/compile.hpp"
+#include "v4front/errors.hpp"
 #include "vendor/doctest/doctest.h"
 
 using Op = v4::Op;
@@ -285,3 +286,140 @@ TEST_CASE("variable: +! for adding to variable")
   // Check that +! is compiled correctly (it's a composite word)
   CHECK(buf.size > 0);
 }
+
+// Address a VARIABLE or CREATE word pushes
+static uint32_t word_addr(const V4FrontBuf& buf, int i)
+{
+  REQUIRE(buf.words[i].code_len == 6);
+  return read_u32_le(&buf.words[i].code[1]);
+}
+
+TEST_CASE("variable: CREATE, ALLOT and ALIGN-TO")
+{
+  V4FrontBuf buf{};
+  BufferGuard guard(&buf);
+  char err[128];
+
+  int rc = v4front_compile("CREATE A 10 ALLOT 64 ALIGN-TO CREATE B VARIABLE C CREATE D",
+                           &buf, err, sizeof(err));
+  REQUIRE(rc == 0);
+  REQUIRE(buf.word_count == 4);
+  CHECK(word_addr(buf, 0) == 0x10000);
+  CHECK(word_addr(buf, 1) == 0x10040);
+  CHECK(word_addr(buf, 2) == 0x10040);  // CREATE reserves nothing
+  CHECK(word_addr(buf, 3) == 0x10044);
+  CHECK(buf.size == 1);                 // Operands leave no code behind
+
+  // ALLOT keeps cells aligned
+  v4front_free(&buf);
+  rc = v4front_compile("CREATE A 3 ALLOT VARIABLE B", &buf, err, sizeof(err));
+  REQUIRE(rc == 0);
+  CHECK(word_addr(buf, 1) == 0x10004);
+}
+
+TEST_CASE("variable: ALLOT and ALIGN-TO errors")
+{
+  V4FrontBuf buf{};
+  BufferGuard guard(&buf);
+  char err[128];
+
+  int rc = v4front_compile("CREATE A ALLOT", &buf, err, sizeof(err));
+  CHECK(rc == -48);
+  rc = v4front_compile("DUP ALIGN-TO", &buf, err, sizeof(err));
+  CHECK(rc == -48);
+  rc = v4front_compile("12 ALIGN-TO", &buf, err, sizeof(err));
+  CHECK(rc == -49);
+  rc = v4front_compile("0 ALIGN-TO", &buf, err, sizeof(err));
+  CHECK(rc == -49);
+  rc = v4front_compile("65537 ALLOT", &buf, err, sizeof(err));
+  CHECK(rc == -40);  // DataSpaceExhausted
+  rc = v4front_compile("-1 ALLOT", &buf, err, sizeof(err));
+  CHECK(rc == -40);
+  rc = v4front_compile("CREATE", &buf, err, sizeof(err));
+  CHECK(rc != 0);
+}
+
+TEST_CASE("variable: context keeps the data space across compilations")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  V4FrontBuf buf{};
+  BufferGuard guard(&buf);
+  char err[128];
+
+  CHECK(v4front_context_get_here(ctx) == 0x10000);
+  CHECK(v4front_context_get_here(nullptr) == 0x10000);
+
+  int rc = v4front_compile_with_context(ctx, "VARIABLE X", &buf, err, sizeof(err));
+  REQUIRE(rc == 0);
+  CHECK(word_addr(buf, 0) == 0x10000);
+  CHECK(v4front_context_get_here(ctx) == 0x10004);
+
+  v4front_free(&buf);
+  rc = v4front_compile_with_context(ctx, "CREATE T 16 ALLOT", &buf, err, sizeof(err));
+  REQUIRE(rc == 0);
+  CHECK(word_addr(buf, 0) == 0x10004);
+  CHECK(v4front_context_get_here(ctx) == 0x10014);
+
+  // A failed compile does not move HERE
+  v4front_free(&buf);
+  rc = v4front_compile_with_context(ctx, "VARIABLE Y 1 IF", &buf, err, sizeof(err));
+  CHECK(rc != 0);
+  CHECK(v4front_context_get_here(ctx) == 0x10014);
+
+  // Snapshots keep their own copy and never move it
+  V4FrontContext* snap = v4front_context_snapshot(ctx);
+  REQUIRE(snap != nullptr);
+  rc = v4front_compile_with_context(snap, "VARIABLE Y", &buf, err, sizeof(err));
+  REQUIRE(rc == 0);
+  CHECK(word_addr(buf, 0) == 0x10014);
+  v4front_free(&buf);
+  rc = v4front_compile_with_context(snap, "VARIABLE Z", &buf, err, sizeof(err));
+  REQUIRE(rc == 0);
+  CHECK(word_addr(buf, 0) == 0x10014);
+  CHECK(v4front_context_get_here(snap) == 0x10014);
+  v4front_err e = v4front_context_set_data_space(snap, 0, 64);
+  CHECK(e == v4front::FrontErr::ReadOnlyContext);
+  v4front_context_destroy(snap);
+
+  v4front_context_reset(ctx);
+  CHECK(v4front_context_get_here(ctx) == 0x10000);
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("variable: v4front_context_set_data_space")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  V4FrontBuf buf{};
+  BufferGuard guard(&buf);
+  char err[128];
+
+  v4front_err e = v4front_context_set_data_space(ctx, 0x2000, 8);
+  REQUIRE(e == v4front::FrontErr::OK);
+  CHECK(v4front_context_get_here(ctx) == 0x2000);
+  int rc = v4front_compile_with_context(ctx, "VARIABLE A VARIABLE B", &buf, err,
+                                        sizeof(err));
+  REQUIRE(rc == 0);
+  CHECK(word_addr(buf, 1) == 0x2004);
+  v4front_free(&buf);
+  rc = v4front_compile_with_context(ctx, "VARIABLE C", &buf, err, sizeof(err));
+  CHECK(rc == -40);  // DataSpaceExhausted
+
+  // Resetting the range starts over and reset() returns to the new base
+  e = v4front_context_set_data_space(ctx, 0x2000, 8);
+  REQUIRE(e == v4front::FrontErr::OK);
+  rc = v4front_compile_with_context(ctx, "VARIABLE C", &buf, err, sizeof(err));
+  REQUIRE(rc == 0);
+  CHECK(word_addr(buf, 0) == 0x2000);
+  v4front_context_reset(ctx);
+  CHECK(v4front_context_get_here(ctx) == 0x2000);
+
+  e = v4front_context_set_data_space(ctx, 0x2001, 8);
+  CHECK(e == v4front::FrontErr::InvalidOption);
+  e = v4front_context_set_data_space(ctx, 0xFFFFFF00u, 0x200);
+  CHECK(e == v4front::FrontErr::InvalidOption);
+  e = v4front_context_set_data_space(nullptr, 0, 8);
+  CHECK(e == v4front::FrontErr::BufferTooSmall);
+  v4front_context_destroy(ctx);
+}
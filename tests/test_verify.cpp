@@ -0,0 +1,197 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdio>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+static void append_i16(std::vector<uint8_t>& code, int16_t v)
+{
+  code.push_back(static_cast<uint8_t>(v & 0xFF));
+  code.push_back(static_cast<uint8_t>((static_cast<uint16_t>(v) >> 8) & 0xFF));
+}
+
+// Verify code against a table of call_limit words; returns the reason
+static uint32_t verify(const std::vector<uint8_t>& code, uint32_t call_limit = 0,
+                       uint32_t* pc = nullptr)
+{
+  V4FrontVerifyResult result;
+  v4front_err err = v4front_verify_code(code.data(), code.size(), call_limit, &result);
+  CHECK((err == FrontErr::OK) == (result.reason == V4FRONT_VERIFY_OK));
+  if (err != FrontErr::OK)
+    CHECK(err == FrontErr::InvalidImage);
+  if (pc)
+    *pc = result.pc;
+  return result.reason;
+}
+
+TEST_CASE("Verify: compiler output passes")
+{
+  const char* sources[] = {
+      "1 2 + DUP *",
+      ": SQ DUP * ; 3 SQ",
+      ": F DUP 0= IF DROP 1 EXIT THEN DUP 1 - RECURSE * ; 5 F",
+      ": T 10 0 DO I 2 = IF LEAVE THEN LOOP ; T",
+      ": G BEGIN DUP WHILE 1 - REPEAT ; : H G G ; 3 H",
+      ": Y BEGIN AGAIN ;",
+  };
+  for (const char* source : sources)
+  {
+    for (uint32_t level = 0; level <= 3; level++)
+    {
+      INFO(source << " at -O" << level);
+      V4FrontCompileOptions options = {};
+      options.opt_level = level;
+      V4FrontBuf buf;
+      v4front_err err =
+          v4front_compile_with_options(nullptr, source, &options, &buf, nullptr);
+      REQUIRE(err == FrontErr::OK);
+      V4FrontVerifyResult result;
+      err = v4front_verify_bytecode(&buf, 0, &result);
+      CHECK(err == FrontErr::OK);
+      CHECK(result.reason == V4FRONT_VERIFY_OK);
+      CHECK(result.unit == -1);
+      v4front_free(&buf);
+    }
+  }
+}
+
+TEST_CASE("Verify: malformed instructions")
+{
+  uint32_t pc;
+  CHECK(verify({op(Op::DUP), op(Op::RET)}) == V4FRONT_VERIFY_OK);
+  CHECK(verify({}) == V4FRONT_VERIFY_OK);
+
+  CHECK(verify({op(Op::DUP), 0xFF, op(Op::RET)}, 0, &pc) ==
+        V4FRONT_VERIFY_UNKNOWN_OPCODE);
+  CHECK(pc == 1);
+  CHECK(verify({op(Op::DUP), op(Op::LIT), 1, 2}, 0, &pc) == V4FRONT_VERIFY_TRUNCATED);
+  CHECK(pc == 1);
+  CHECK(verify({op(Op::LIT0), op(Op::DROP)}, 0, &pc) == V4FRONT_VERIFY_FALLS_OFF);
+  CHECK(pc == 1);
+  CHECK(verify({op(Op::LIT0), op(Op::JZ), 0xFD, 0xFF}) == V4FRONT_VERIFY_FALLS_OFF);
+}
+
+TEST_CASE("Verify: jump targets")
+{
+  // 0: LIT 7, 5: JZ, 8: DUP, 9: RET
+  std::vector<uint8_t> code = {op(Op::LIT), 7, 0, 0, 0, op(Op::JZ)};
+  append_i16(code, 0);
+  code.push_back(op(Op::DUP));
+  code.push_back(op(Op::RET));
+
+  auto with_offset = [&](int16_t off) {
+    std::vector<uint8_t> c = code;
+    c[6] = static_cast<uint8_t>(off & 0xFF);
+    c[7] = static_cast<uint8_t>((static_cast<uint16_t>(off) >> 8) & 0xFF);
+    return c;
+  };
+  CHECK(verify(with_offset(0)) == V4FRONT_VERIFY_OK);    // -> 8
+  CHECK(verify(with_offset(1)) == V4FRONT_VERIFY_OK);    // -> 9
+  CHECK(verify(with_offset(-8)) == V4FRONT_VERIFY_OK);   // -> 0
+  CHECK(verify(with_offset(-3)) == V4FRONT_VERIFY_OK);   // -> 5 (itself)
+  uint32_t pc;
+  CHECK(verify(with_offset(2), 0, &pc) == V4FRONT_VERIFY_BAD_JUMP);  // -> 10, the end
+  CHECK(pc == 5);
+  CHECK(verify(with_offset(-9)) == V4FRONT_VERIFY_BAD_JUMP);  // Before the start
+  CHECK(verify(with_offset(-6)) == V4FRONT_VERIFY_BAD_JUMP);  // Inside LIT
+  CHECK(verify(with_offset(-1)) == V4FRONT_VERIFY_BAD_JUMP);  // Inside JZ
+  CHECK(verify(with_offset(INT16_MAX)) == V4FRONT_VERIFY_BAD_JUMP);
+
+  // A forward jump into a later instruction's immediate is found after the pass
+  std::vector<uint8_t> fwd = {op(Op::JMP)};
+  append_i16(fwd, 1);
+  fwd.push_back(op(Op::LIT));
+  fwd.insert(fwd.end(), {0, 0, 0, 0});
+  fwd.push_back(op(Op::RET));
+  CHECK(verify(fwd, 0, &pc) == V4FRONT_VERIFY_BAD_JUMP);
+  CHECK(pc == 0);
+}
+
+TEST_CASE("Verify: call targets and large units")
+{
+  std::vector<uint8_t> code = {op(Op::CALL)};
+  append_i16(code, 2);
+  code.push_back(op(Op::RET));
+  CHECK(verify(code, 3) == V4FRONT_VERIFY_OK);
+  CHECK(verify(code, 2) == V4FRONT_VERIFY_BAD_CALL);
+  CHECK(verify(code, 0) == V4FRONT_VERIFY_BAD_CALL);
+
+  // Bitmaps of large units are allocated; a bad jump at the far end is found
+  std::vector<uint8_t> big(20000, op(Op::DUP));
+  big.push_back(op(Op::JMP));
+  append_i16(big, -20003);
+  CHECK(verify(big) == V4FRONT_VERIFY_OK);
+  big[big.size() - 2] = static_cast<uint8_t>(big[big.size() - 2] + 1);  // Off by one
+  CHECK(verify(big) == V4FRONT_VERIFY_OK);                                // -> 1
+  big[5] = op(Op::LIT);  // Swallows DUPs 6..9: the jump to 1 still lands
+  CHECK(verify(big) == V4FRONT_VERIFY_OK);
+  big[0] = op(Op::LIT);  // Now 1 is inside an immediate
+  uint32_t pc;
+  CHECK(verify(big, 0, &pc) == V4FRONT_VERIFY_BAD_JUMP);
+  CHECK(pc == big.size() - 3);
+}
+
+TEST_CASE("Verify: buffers, words and call_limit")
+{
+  V4FrontBuf buf;
+  v4front_err err = v4front_compile(": A 1 + ; : B A A ; 2 B", &buf, nullptr, 0);
+  REQUIRE(err == FrontErr::OK);
+  REQUIRE(buf.word_count == 2);
+
+  V4FrontVerifyResult result;
+  err = v4front_verify_bytecode(&buf, 0, &result);
+  CHECK(err == FrontErr::OK);
+  err = v4front_verify_bytecode(&buf, 1, &result);  // B calls word 1 from main code
+  CHECK(err == FrontErr::InvalidImage);
+  CHECK(result.reason == V4FRONT_VERIFY_BAD_CALL);
+  CHECK(result.unit == -1);
+  err = v4front_verify_bytecode(&buf, 2, nullptr);
+  CHECK(err == FrontErr::OK);
+
+  // Saved and loaded (or mapped) images verify the same way
+  REQUIRE(v4front_save_bytecode(&buf, "test_verify.v4b") == 0);
+  V4FrontMappedBytecode mapped;
+  REQUIRE(v4front_map_bytecode("test_verify.v4b", &mapped) == 0);
+  err = v4front_verify_code(mapped.code, mapped.size, mapped.word_count, nullptr);
+  CHECK(err == FrontErr::OK);
+  for (uint32_t i = 0; i < mapped.word_count; i++)
+  {
+    const uint8_t* code;
+    uint32_t len;
+    REQUIRE(v4front_mapped_word(&mapped, i, nullptr, &code, &len) == 0);
+    err = v4front_verify_code(code, len, mapped.word_count, nullptr);
+    CHECK(err == FrontErr::OK);
+  }
+  v4front_unmap_bytecode(&mapped);
+
+  V4FrontBuf loaded;
+  REQUIRE(v4front_load_bytecode("test_verify.v4b", &loaded) == 0);
+  loaded.words[1].code[1] = 5;  // B's first CALL now names word 5
+  err = v4front_verify_bytecode(&loaded, 0, &result);
+  CHECK(err == FrontErr::InvalidImage);
+  CHECK(result.reason == V4FRONT_VERIFY_BAD_CALL);
+  CHECK(result.unit == 1);
+  CHECK(result.pc == 0);
+  v4front_free(&loaded);
+  remove("test_verify.v4b");
+
+  err = v4front_verify_bytecode(nullptr, 0, &result);
+  CHECK(err == FrontErr::BufferTooSmall);
+  err = v4front_verify_code(nullptr, 4, 0, &result);
+  CHECK(err == FrontErr::BufferTooSmall);
+  err = v4front_verify_code(nullptr, 0, 0, &result);
+  CHECK(err == FrontErr::OK);
+  v4front_free(&buf);
+}
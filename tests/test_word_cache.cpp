@@ -0,0 +1,249 @@
+#define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/errors.hpp"
+#include "vendor/doctest/doctest.h"
+
+using namespace v4front;
+using Op = v4::Op;
+
+static uint8_t op(Op o)
+{
+  return static_cast<uint8_t>(o);
+}
+
+// Flattened compiler output, for comparing two compilations
+static std::vector<uint8_t> flatten(const V4FrontBuf& buf)
+{
+  std::vector<uint8_t> out(buf.data, buf.data + buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    const char* name = buf.words[i].name;
+    out.insert(out.end(), name, name + strlen(name));
+    out.push_back(0);
+    out.insert(out.end(), buf.words[i].code, buf.words[i].code + buf.words[i].code_len);
+  }
+  return out;
+}
+
+static std::vector<uint8_t> compile(V4FrontContext* ctx, const std::string& source,
+                                    const V4FrontCompileOptions* options = nullptr)
+{
+  V4FrontBuf buf;
+  v4front_err err =
+      v4front_compile_with_options(ctx, source.c_str(), options, &buf, nullptr);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> out = flatten(buf);
+  v4front_free(&buf);
+  return out;
+}
+
+static V4FrontWordCacheStats stats(const V4FrontContext* ctx)
+{
+  V4FrontWordCacheStats s;
+  v4front_context_get_word_cache_stats(ctx, &s);
+  return s;
+}
+
+static const char* kScript =
+    ": SQUARE DUP * ;\n"
+    ": CUBE DUP SQUARE * ;\n"
+    ": SUM 0 SWAP 0 DO I CUBE + LOOP ;\n"
+    "10 CONSTANT TEN\n"
+    ": TENS TEN * ;  ( uses a constant )\n"
+    ": COUNTDOWN BEGIN DUP WHILE 1- REPEAT DROP RECURSE ;\n"
+    "5 SUM TENS DROP";
+
+TEST_CASE("Word cache: resubmitting a script reuses every definition")
+{
+  V4FrontCompileOptions o2 = {};
+  o2.opt_level = 2;
+  const V4FrontCompileOptions* configs[] = {nullptr, &o2};
+
+  for (const V4FrontCompileOptions* options : configs)
+  {
+    CAPTURE(options != nullptr);
+    V4FrontContext* ctx = v4front_context_create();
+    REQUIRE(ctx != nullptr);
+    v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+    REQUIRE(err == FrontErr::OK);
+
+    std::vector<uint8_t> expected = compile(nullptr, kScript, options);
+    CHECK(compile(ctx, kScript, options) == expected);
+    CHECK(stats(ctx).compiled == 5);
+    CHECK(stats(ctx).reused == 0);
+    CHECK(stats(ctx).entries == 5);
+
+    CHECK(compile(ctx, kScript, options) == expected);
+    CHECK(stats(ctx).compiled == 0);
+    CHECK(stats(ctx).reused == 5);
+    CHECK(stats(ctx).entries == 5);
+    CHECK(stats(ctx).bytes > 0);
+
+    v4front_context_destroy(ctx);
+  }
+}
+
+TEST_CASE("Word cache: only changed definitions and their users are recompiled")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+  REQUIRE(err == FrontErr::OK);
+  compile(ctx, ": A 1 ;\n: B A A + ;\n: C B 2 * ;\n: D 7 ;\nC D");
+
+  SUBCASE("A changed body; B calls A, C only calls the unchanged B")
+  {
+    std::string edited = ": A 100 ;\n: B A A + ;\n: C B 2 * ;\n: D 7 ;\nC D";
+    CHECK(compile(ctx, edited) == compile(nullptr, edited));
+    CHECK(stats(ctx).compiled == 2);
+    CHECK(stats(ctx).reused == 2);
+  }
+
+  SUBCASE("With inlining, the change reaches every caller of the body")
+  {
+    V4FrontCompileOptions options = {};
+    options.flags = V4FRONT_OPT_INLINE;
+    std::string source = ": A 1 ;\n: B A A + ;\n: C B 2 * ;\n: D 7 ;\nC D";
+    compile(ctx, source, &options);
+    std::string edited = ": A 100 ;\n: B A A + ;\n: C B 2 * ;\n: D 7 ;\nC D";
+    CHECK(compile(ctx, edited, &options) == compile(nullptr, edited, &options));
+    CHECK(stats(ctx).compiled == 3);
+    CHECK(stats(ctx).reused == 1);
+  }
+
+  SUBCASE("Whitespace and comments outside definitions do not matter")
+  {
+    compile(ctx, "( header )\n\n: A 1 ;   : B A A + ;\n: C B 2 * ;\n: D 7 ;\nC D D");
+    CHECK(stats(ctx).compiled == 0);
+    CHECK(stats(ctx).reused == 4);
+  }
+
+  SUBCASE("A word inserted in front moves every index")
+  {
+    std::string edited = ": Z 0 ;\n: A 1 ;\n: B A A + ;\n: C B 2 * ;\n: D 7 ;\nC D";
+    CHECK(compile(ctx, edited) == compile(nullptr, edited));
+    CHECK(stats(ctx).compiled == 5);
+  }
+
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Word cache: context words are part of the key")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+  v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_context_register_word(ctx, "HOST", 40);
+  REQUIRE(err == FrontErr::OK);
+
+  const char* source = ": USE HOST ;\n: SQ DUP * ;";
+  compile(ctx, source);
+  compile(ctx, source);
+  CHECK(stats(ctx).reused == 2);
+
+  // A new VM index for HOST
+  err = v4front_context_register_word(ctx, "HOST", 41);
+  REQUIRE(err == FrontErr::OK);
+  compile(ctx, source);
+  CHECK(stats(ctx).compiled == 1);
+  CHECK(stats(ctx).reused == 1);
+  V4FrontBuf buf;
+  err = v4front_compile_with_context(ctx, source, &buf, nullptr, 0);
+  REQUIRE(err == FrontErr::OK);
+  std::vector<uint8_t> use(buf.words[0].code, buf.words[0].code + buf.words[0].code_len);
+  CHECK(use == std::vector<uint8_t>{op(Op::CALL), 41, 0, op(Op::RET)});
+  v4front_free(&buf);
+
+  // A host word now shadows the primitive DUP
+  err = v4front_context_register_word(ctx, "DUP", 7);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_compile_with_context(ctx, source, &buf, nullptr, 0);
+  REQUIRE(err == FrontErr::OK);
+  CHECK(stats(ctx).compiled == 1);
+  std::vector<uint8_t> sq(buf.words[1].code, buf.words[1].code + buf.words[1].code_len);
+  CHECK(sq == std::vector<uint8_t>{op(Op::CALL), 7, 0, op(Op::MUL), op(Op::RET)});
+  v4front_free(&buf);
+
+  // Hot reload: the cache survives a reset, and the definitions are reused
+  // once the host has registered its words again
+  v4front_context_reset(ctx);
+  err = v4front_context_register_word(ctx, "HOST", 41);
+  REQUIRE(err == FrontErr::OK);
+  err = v4front_context_register_word(ctx, "DUP", 7);
+  REQUIRE(err == FrontErr::OK);
+  compile(ctx, source);
+  CHECK(stats(ctx).compiled == 0);
+  CHECK(stats(ctx).reused == 2);
+
+  v4front_context_destroy(ctx);
+}
+
+TEST_CASE("Word cache: limits and configuration")
+{
+  V4FrontContext* ctx = v4front_context_create();
+  REQUIRE(ctx != nullptr);
+
+  SUBCASE("Disabled by default")
+  {
+    compile(ctx, kScript);
+    compile(ctx, kScript);
+    CHECK(stats(ctx).entries == 0);
+    CHECK(stats(ctx).reused == 0);
+  }
+
+  SUBCASE("Least recently used definitions are dropped")
+  {
+    v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+    REQUIRE(err == FrontErr::OK);
+    compile(ctx, ": OLD 1 2 3 + + ;");
+    compile(ctx, ": NEW 4 ;");
+    size_t both = stats(ctx).bytes;
+    compile(ctx, ": NEW 4 ;");  // OLD is now the least recently used
+
+    err = v4front_context_set_word_cache(ctx, both - 1);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(stats(ctx).entries == 1);
+    compile(ctx, ": NEW 4 ;");
+    CHECK(stats(ctx).reused == 1);
+    compile(ctx, ": OLD 1 2 3 + + ;");
+    CHECK(stats(ctx).reused == 0);
+  }
+
+  SUBCASE("Definitions inside control structures or defining words are not cached")
+  {
+    v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+    REQUIRE(err == FrontErr::OK);
+    compile(ctx, "1 IF : W 1 ; THEN : V 5 CONSTANT FIVE ;");
+    CHECK(stats(ctx).compiled == 2);
+    CHECK(stats(ctx).entries == 0);
+  }
+
+  SUBCASE("Turning the cache off frees it")
+  {
+    v4front_err err = v4front_context_set_word_cache(ctx, 1 << 20);
+    REQUIRE(err == FrontErr::OK);
+    compile(ctx, kScript);
+    err = v4front_context_set_word_cache(ctx, 0);
+    REQUIRE(err == FrontErr::OK);
+    CHECK(stats(ctx).entries == 0);
+    CHECK(stats(ctx).bytes == 0);
+  }
+
+  SUBCASE("Snapshots have no cache")
+  {
+    V4FrontContext* snap = v4front_context_snapshot(ctx);
+    REQUIRE(snap != nullptr);
+    v4front_err err = v4front_context_set_word_cache(snap, 1 << 20);
+    CHECK(err == FrontErr::ReadOnlyContext);
+    v4front_context_destroy(snap);
+  }
+
+  v4front_context_destroy(ctx);
+}
@@ -1,6 +1,8 @@
 #define DOCTEST_CONFIG_NO_EXCEPTIONS_BUT_WITH_ALL_ASSERTS
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdio>
 #include <cstring>
+#include <string>
 
 #include "v4/opcodes.hpp"
 #include "v4front/compile.h"
@@ -370,3 +372,48 @@ TEST_CASE("EXIT keyword for early return")
     v4front_free(&buf);
   }
 }
+
+TEST_CASE("Large dictionaries")
+{
+  V4FrontBuf buf;
+  char errmsg[256];
+
+  SUBCASE("More than 256 words in one compilation")
+  {
+    std::string src;
+    char def[64];
+    for (int i = 0; i < 1000; i++)
+    {
+      snprintf(def, sizeof(def), ": W%d %d ; ", i, i);
+      src += def;
+    }
+    src += "W0 W999";
+
+    v4front_err err = v4front_compile(src.c_str(), &buf, errmsg, sizeof(errmsg));
+    REQUIRE(err == FrontErr::OK);
+    CHECK(buf.word_count == 1000);
+    CHECK(strcmp(buf.words[999].name, "W999") == 0);
+
+    // Main code: CALL 0, CALL 999, RET
+    REQUIRE(buf.size == 7);
+    CHECK(buf.data[0] == static_cast<uint8_t>(Op::CALL));
+    CHECK(buf.data[3] == static_cast<uint8_t>(Op::CALL));
+    CHECK(buf.data[4] == (999 & 0xFF));
+    CHECK(buf.data[5] == (999 >> 8));
+
+    v4front_free(&buf);
+  }
+
+  SUBCASE("Deep nesting within the control depth limit")
+  {
+    std::string src = "1";
+    for (int i = 0; i < 31; i++)
+      src += " 1 IF";
+    for (int i = 0; i < 31; i++)
+      src += " THEN";
+
+    v4front_err err = v4front_compile(src.c_str(), &buf, errmsg, sizeof(errmsg));
+    CHECK(err == FrontErr::OK);
+    v4front_free(&buf);
+  }
+}
@@ -0,0 +1,127 @@
+// v4front-batch: compile many source files into one linked .v4b image.
+//
+//  Usage: v4front-batch [-j THREADS] [-O LEVEL] [-z] -o OUT.v4b FILE...
+//
+//  - Every FILE is one module of v4front_compile_batch(): the modules are
+//    compiled in parallel on THREADS threads (default: one per hardware
+//    thread) and linked in command-line order.
+//  - -O selects the optimization level (0..2, default 0).
+//  - -z writes a compressed (v0.3) file, for transfer over slow links.
+//  - Errors are printed as "FILE:LINE:COLUMN: message" and nothing is
+//    written; the exit status is 1 on error and 2 on bad usage.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "v4front/compile.h"
+
+namespace
+{
+
+bool read_file(const char* path, std::string* out)
+{
+  FILE* f = fopen(path, "rb");
+  if (!f)
+    return false;
+  char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    out->append(chunk, n);
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+void usage()
+{
+  fprintf(stderr,
+          "usage: v4front-batch [-j THREADS] [-O LEVEL] [-z] -o OUT.v4b FILE...\n"
+          "  -j THREADS  compile threads (default 0: one per hardware thread)\n"
+          "  -O LEVEL    optimization level 0..2 (default 0)\n"
+          "  -z          compress the code sections\n"
+          "  -o OUT      linked bytecode file to write\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  int threads = 0;
+  int level = 0;
+  uint32_t save_flags = 0;
+  const char* out_path = nullptr;
+
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++)
+  {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+    {
+      threads = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-O") == 0 && i + 1 < argc)
+    {
+      level = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-z") == 0)
+    {
+      save_flags |= V4B_SAVE_COMPRESS;
+    }
+    else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+    {
+      out_path = argv[++i];
+    }
+    else
+    {
+      usage();
+      return 2;
+    }
+  }
+  if (i == argc || !out_path || threads < 0 || level < 0 || level > 2)
+  {
+    usage();
+    return 2;
+  }
+
+  const char* const* paths = argv + i;
+  std::vector<std::string> sources(argc - i);
+  std::vector<V4FrontModule> modules;
+  for (size_t m = 0; m < sources.size(); m++)
+  {
+    if (!read_file(paths[m], &sources[m]))
+    {
+      fprintf(stderr, "%s: cannot read file\n", paths[m]);
+      return 1;
+    }
+    modules.push_back({sources[m].data(), sources[m].size()});
+  }
+
+  V4FrontCompileOptions options = {};
+  options.opt_level = level;
+  V4FrontBuf buf;
+  V4FrontError error;
+  uint32_t module;
+  v4front_err err = v4front_compile_batch(
+      nullptr, modules.data(), static_cast<uint32_t>(modules.size()), &options,
+      static_cast<uint32_t>(threads), &buf, &error, &module);
+  if (err != 0)
+  {
+    if (module < modules.size())
+      fprintf(stderr, "%s:%d:%d: %s\n", paths[module], error.line, error.column,
+              error.message);
+    else
+      fprintf(stderr, "v4front-batch: %s\n", error.message);
+    return 1;
+  }
+
+  err = v4front_save_bytecode_with_flags(&buf, out_path, save_flags);
+  v4front_free(&buf);
+  if (err != 0)
+  {
+    fprintf(stderr, "%s: cannot write bytecode (error %d)\n", out_path, err);
+    return 1;
+  }
+  return 0;
+}
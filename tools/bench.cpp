@@ -0,0 +1,416 @@
+// v4front-bench: compiler throughput on synthetic workloads.
+//
+//  Usage: v4front-bench [-t SECONDS] [-s SCALE] [-w WORKLOAD]
+//
+//  - Every workload is generated in memory (see kWorkloads) and compiled
+//    with v4front_compile(), with v4front_compile_with_context() against a
+//    context of host words and with v4front_session_compile() against the
+//    same context, repeatedly for at least SECONDS (default 0.5).
+//  - -s multiplies the size of every workload (default 1); -w runs only the
+//    named workload.
+//  - One JSON object per line is printed for each workload and API, so runs
+//    of different releases can be collected and compared:
+//      {"workload":"nesting","api":"v4front_compile","version":"0.7.0",
+//       "source_bytes":...,"tokens":...,"iterations":...,"seconds":...,
+//       "tokens_per_sec":...,"bytes_per_sec":...,"allocs_per_compile":...,
+//       "peak_bytes":...}
+//  - tokens counts the words the compiler reads (comments excluded).
+//    allocs_per_compile and peak_bytes come from one extra compilation through
+//    a counting V4FrontAllocator (v4front_compile_with_allocator(), the same
+//    code path); peak_bytes is the highest live total, output block included.
+//    For the session they count one compilation after the timed ones (0 in
+//    the steady state) and the session's whole memory.
+//  - The exit status is 1 if a workload fails to compile and 2 on bad usage.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "v4front/compile.h"
+
+#ifndef V4FRONT_VERSION
+#define V4FRONT_VERSION "unknown"
+#endif
+
+namespace
+{
+
+constexpr int kHostWords = 256;  // Words registered in the benchmark context
+
+// Source text with a count of the tokens the compiler sees
+struct Source
+{
+  std::string text;
+  unsigned long tokens = 0;
+
+  void code(const std::string& word)
+  {
+    text += word;
+    text += ' ';
+    tokens++;
+  }
+
+  void comment(const std::string& body)
+  {
+    text += "( ";
+    text += body;
+    text += " ) ";
+  }
+
+  void line_comment(const std::string& body)
+  {
+    text += "\\ ";
+    text += body;
+    text += '\n';
+  }
+
+  void newline() { text += '\n'; }
+};
+
+// Words nested 30 control structures deep, alternating IF and DO
+void gen_nesting(Source* src, int scale)
+{
+  const int depth = 30;  // MAX_CONTROL_DEPTH is 32
+  for (int w = 0; w < 40 * scale; w++)
+  {
+    src->code(":");
+    src->code("NEST" + std::to_string(w));
+    for (int d = 0; d < depth; d++)
+    {
+      if (d % 2 == 0)
+      {
+        src->code("DUP");
+        src->code("IF");
+      }
+      else
+      {
+        src->code("2");
+        src->code("0");
+        src->code("DO");
+      }
+    }
+    src->code("1");
+    src->code("+");
+    for (int d = depth - 1; d >= 0; d--)
+      src->code(d % 2 == 0 ? "THEN" : "LOOP");
+    src->code(";");
+    src->newline();
+  }
+  src->code("1");
+  src->code("NEST0");
+}
+
+// Thousands of short definitions, each calling the previous one
+void gen_definitions(Source* src, int scale)
+{
+  int count = 4000 * scale;
+  if (count > 30000)
+    count = 30000;  // MAX_WORDS is 32767
+  src->code(":");
+  src->code("W0");
+  src->code("1");
+  src->code(";");
+  src->newline();
+  for (int w = 1; w < count; w++)
+  {
+    src->code(":");
+    src->code("W" + std::to_string(w));
+    src->code("W" + std::to_string(w - 1));
+    src->code(std::to_string(w));
+    src->code("+");
+    src->code(";");
+    src->newline();
+  }
+}
+
+// Long runs of decimal, hexadecimal and negative literals
+void gen_literals(Source* src, int scale)
+{
+  for (int line = 0; line < 400 * scale; line++)
+  {
+    src->code(":");
+    src->code("L" + std::to_string(line));
+    for (int k = 0; k < 16; k++)
+    {
+      int n = line * 16 + k;
+      char hex[16];
+      snprintf(hex, sizeof(hex), "0x%X", n * 2654435761u & 0xFFFFFFu);
+      src->code(k % 3 == 0 ? std::to_string(n) : k % 3 == 1 ? hex : std::to_string(-n));
+      if (k > 0)
+        src->code("+");
+    }
+    src->code(";");
+    src->newline();
+  }
+}
+
+// Sources that are mostly comments around a little code
+void gen_comments(Source* src, int scale)
+{
+  const std::string prose =
+      "this word keeps the top of the stack and adds the step value "
+      "; see the module notes for the calling convention";
+  for (int w = 0; w < 800 * scale; w++)
+  {
+    src->line_comment("C" + std::to_string(w) + ": " + prose);
+    src->code(":");
+    src->code("C" + std::to_string(w));
+    src->comment("n -- n'");
+    src->code("1");
+    src->comment(prose);
+    src->code("+");
+    src->code(";");
+    src->line_comment(prose);
+  }
+}
+
+// Definitions calling the host words of the context
+void gen_host_calls(Source* src, int scale)
+{
+  for (int w = 0; w < 1000 * scale; w++)
+  {
+    src->code(":");
+    src->code("H" + std::to_string(w));
+    for (int k = 0; k < 6; k++)
+      src->code("HOST" + std::to_string((w * 7 + k) % kHostWords));
+    src->code(";");
+    src->newline();
+  }
+}
+
+struct Workload
+{
+  const char* name;
+  void (*generate)(Source* src, int scale);
+  bool needs_context;  // Refers to host words: not compiled by v4front_compile()
+};
+
+const Workload kWorkloads[] = {
+    {"nesting", gen_nesting, false},       {"definitions", gen_definitions, false},
+    {"literals", gen_literals, false},     {"comments", gen_comments, false},
+    {"host_calls", gen_host_calls, true},
+};
+
+// Allocator that counts calls and tracks the live and peak byte totals
+struct CountingHeap
+{
+  unsigned long allocs = 0;
+  size_t live = 0;
+  size_t peak = 0;
+};
+
+// Every block is prefixed by its size, padded to keep malloc's alignment
+union BlockHeader
+{
+  size_t size;
+  max_align_t align;
+};
+
+void* counting_alloc(void* user, size_t size)
+{
+  CountingHeap* heap = static_cast<CountingHeap*>(user);
+  BlockHeader* header = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + size));
+  if (!header)
+    return nullptr;
+  header->size = size;
+  heap->allocs++;
+  heap->live += size;
+  if (heap->live > heap->peak)
+    heap->peak = heap->live;
+  return header + 1;
+}
+
+void counting_free(void* user, void* ptr)
+{
+  if (!ptr)
+    return;
+  CountingHeap* heap = static_cast<CountingHeap*>(user);
+  BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+  heap->live -= header->size;
+  free(header);
+}
+
+v4front_err compile_once(V4FrontContext* ctx, V4FrontSession* session, const char* source,
+                         V4FrontBuf* buf, char* err, size_t err_cap)
+{
+  if (!session)
+    return ctx ? v4front_compile_with_context(ctx, source, buf, err, err_cap)
+               : v4front_compile(source, buf, err, err_cap);
+  V4FrontError error;
+  v4front_err status =
+      v4front_session_compile(session, ctx, source, nullptr, buf, &error);
+  if (status != 0 && err)
+    snprintf(err, err_cap, "%s", error.message);
+  return status;
+}
+
+struct Result
+{
+  unsigned long iterations;
+  double seconds;
+  unsigned long allocs;
+  size_t peak;
+};
+
+bool measure(V4FrontContext* ctx, bool use_session, const Source& src, double min_seconds,
+             Result* out)
+{
+  typedef std::chrono::steady_clock Clock;
+  CountingHeap heap;
+  V4FrontAllocator allocator = {counting_alloc, counting_free, &heap};
+  V4FrontSession* session = nullptr;
+  if (use_session && !(session = v4front_session_create(&allocator)))
+  {
+    fprintf(stderr, "out of memory\n");
+    return false;
+  }
+
+  char err[256];
+  V4FrontBuf buf;
+  // Warm-up, which also checks that the workload compiles
+  if (compile_once(ctx, session, src.text.c_str(), &buf, err, sizeof(err)) != 0)
+  {
+    fprintf(stderr, "compile failed: %s\n", err);
+    v4front_session_destroy(session);
+    return false;
+  }
+  v4front_free(&buf);
+
+  unsigned long iterations = 0;
+  double seconds = 0;
+  Clock::time_point start = Clock::now();
+  while (iterations < 3 || seconds < min_seconds)
+  {
+    compile_once(ctx, session, src.text.c_str(), &buf, nullptr, 0);
+    v4front_free(&buf);
+    iterations++;
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  const unsigned long before = heap.allocs;
+  v4front_err status =
+      session ? compile_once(ctx, session, src.text.c_str(), &buf, nullptr, 0)
+              : v4front_compile_with_allocator(ctx, src.text.c_str(), &allocator, &buf,
+                                               nullptr);
+  v4front_free(&buf);
+  v4front_session_destroy(session);
+  if (status != 0)
+    return false;
+
+  out->iterations = iterations;
+  out->seconds = seconds;
+  out->allocs = heap.allocs - before;
+  out->peak = heap.peak;
+  return true;
+}
+
+void report(const char* workload, const char* api, const Source& src, const Result& r)
+{
+  double per_compile = r.seconds / static_cast<double>(r.iterations);
+  printf("{\"workload\":\"%s\",\"api\":\"%s\",\"version\":\"%s\","
+         "\"source_bytes\":%zu,\"tokens\":%lu,\"iterations\":%lu,\"seconds\":%.6f,"
+         "\"tokens_per_sec\":%.0f,\"bytes_per_sec\":%.0f,\"allocs_per_compile\":%lu,"
+         "\"peak_bytes\":%zu}\n",
+         workload, api, V4FRONT_VERSION, src.text.size(), src.tokens, r.iterations,
+         r.seconds, static_cast<double>(src.tokens) / per_compile,
+         static_cast<double>(src.text.size()) / per_compile, r.allocs, r.peak);
+  fflush(stdout);
+}
+
+void usage()
+{
+  fprintf(stderr,
+          "usage: v4front-bench [-t SECONDS] [-s SCALE] [-w WORKLOAD]\n"
+          "  -t SECONDS  minimum time per measurement (default 0.5)\n"
+          "  -s SCALE    workload size multiplier (default 1)\n"
+          "  -w WORKLOAD run only this workload:");
+  for (const Workload& w : kWorkloads)
+    fprintf(stderr, " %s", w.name);
+  fprintf(stderr, "\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  double min_seconds = 0.5;
+  int scale = 1;
+  const char* only = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+    {
+      min_seconds = atof(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+    {
+      scale = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+    {
+      only = argv[++i];
+    }
+    else
+    {
+      usage();
+      return 2;
+    }
+  }
+  bool known = only == nullptr;
+  for (const Workload& w : kWorkloads)
+    known = known || strcmp(w.name, only) == 0;
+  if (min_seconds < 0 || scale < 1 || !known)
+  {
+    usage();
+    return 2;
+  }
+
+  V4FrontContext* ctx = v4front_context_create();
+  if (!ctx)
+  {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  for (int i = 0; i < kHostWords; i++)
+  {
+    std::string name = "HOST" + std::to_string(i);
+    if (v4front_context_register_word(ctx, name.c_str(), i) != 0)
+    {
+      fprintf(stderr, "cannot register %s\n", name.c_str());
+      v4front_context_destroy(ctx);
+      return 1;
+    }
+  }
+
+  int status = 0;
+  for (const Workload& w : kWorkloads)
+  {
+    if (only && strcmp(w.name, only) != 0)
+      continue;
+    Source src;
+    w.generate(&src, scale);
+
+    Result r;
+    if (!w.needs_context)
+    {
+      if (measure(nullptr, false, src, min_seconds, &r))
+        report(w.name, "v4front_compile", src, r);
+      else
+        status = 1;
+    }
+    if (measure(ctx, false, src, min_seconds, &r))
+      report(w.name, "v4front_compile_with_context", src, r);
+    else
+      status = 1;
+    if (measure(ctx, true, src, min_seconds, &r))
+      report(w.name, "v4front_session_compile", src, r);
+    else
+      status = 1;
+  }
+
+  v4front_context_destroy(ctx);
+  return status;
+}
@@ -0,0 +1,573 @@
+// v4front-codebench: size and dispatch count of the emitted code.
+//
+//  Usage: v4front-codebench [-O LEVEL] [KAT_FILE...]
+//
+//  - Every construct of kConstructs is compiled twice: its snippet alone
+//    (bytes and instructions of the construct's expansion) and a small
+//    program that exercises it in a loop (dispatches). The program takes its
+//    accumulator from the data stack the harness starts it with (kInput), so
+//    constant evaluation at -O2 cannot fold it to a literal.
+//  - Every SOURCE line of the KAT_FILEs (tests/kat/*.kat) is compiled as a
+//    program of its own; a last line totals the corpus.
+//  - -O selects the optimization level (0..2, default 0).
+//  - One JSON object per line is printed, so an optimizer change can be
+//    judged against the numbers of the previous release:
+//      {"construct":"LOOP","opt_level":0,"bytes":...,"instructions":...,
+//       "dispatches":...}
+//      {"kat":"control.kat","test":"Simple IF-THEN","opt_level":0,...}
+//  - bytes and instructions cover main code and every word (instructions are
+//    counted with v4front_disasm_count()). dispatches is the number of
+//    instructions executed until main returns, from the reference
+//    interpreter below: the V4 VM API has no instruction counter. It is null
+//    for programs the interpreter cannot run (SYS, memory, task operations,
+//    fused opcodes, stack underflow or more than kMaxSteps steps).
+//  - Each construct program must run, leave its known result on the stack
+//    and take more dispatches than its loop has iterations (fewer means the
+//    construct was optimized away); a failure is reported on stderr.
+//  - The exit status is 1 if a construct or KAT source fails to compile or a
+//    construct program fails a check, and 2 on bad usage.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "kat_runner.hpp"
+#include "v4/opcodes.hpp"
+#include "v4front/compile.h"
+#include "v4front/disasm.h"
+
+namespace
+{
+
+using Op = v4::Op;
+
+constexpr unsigned long kMaxSteps = 10000000;
+
+// Data stack a construct program starts with: its accumulator
+constexpr int32_t kInput = 0;
+
+struct Construct
+{
+  const char* name;
+  const char* snippet;  // The construct alone, for its size
+  const char* program;  // A loop around it, for the dispatch count
+  int32_t result;       // What program leaves on the stack, from kInput
+  long iterations;      // Times program runs the construct
+};
+
+const Construct kConstructs[] = {
+    {"LOOP", "10 0 DO LOOP", ": T 100 0 DO I + LOOP ; T", 4950, 100},
+    {"J", "3 0 DO 3 0 DO J DROP LOOP LOOP", ": T 10 0 DO 10 0 DO J + LOOP LOOP ; T", 450,
+     100},
+    {"K", "2 0 DO 2 0 DO 2 0 DO K DROP LOOP LOOP LOOP",
+     ": T 5 0 DO 5 0 DO 5 0 DO K + LOOP LOOP LOOP ; T", 250, 125},
+    {"2OVER", "2OVER", ": T 100 0 DO 1 2 3 4 2OVER + + + + + + LOOP ; T", 1300, 100},
+    {"ABS", "ABS", ": T 100 0 DO I 50 - ABS + LOOP ; T", 2500, 100},
+    {"MIN", "MIN", ": T 100 0 DO I 50 MIN + LOOP ; T", 3725, 100},
+    {"MAX", "MAX", ": T 100 0 DO I 50 MAX + LOOP ; T", 6225, 100},
+    {"?DUP", "?DUP", ": T 100 0 DO I 2 MOD ?DUP IF + THEN LOOP ; T", 50, 100},
+};
+
+struct Metrics
+{
+  size_t bytes = 0;
+  size_t instructions = 0;
+  long dispatches = -1;  // -1: not runnable
+};
+
+int32_t read_i32(const uint8_t* p)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(p[0]) |
+                              (static_cast<uint32_t>(p[1]) << 8) |
+                              (static_cast<uint32_t>(p[2]) << 16) |
+                              (static_cast<uint32_t>(p[3]) << 24));
+}
+
+int16_t read_i16(const uint8_t* p)
+{
+  return static_cast<int16_t>(static_cast<uint16_t>(p[0]) |
+                              (static_cast<uint16_t>(p[1]) << 8));
+}
+
+// Reference interpreter for the stack, arithmetic, branch, call and local
+// opcodes; counts dispatches. Words are numbered as in buf.words (a VM that
+// registered them in order, then main). stack is the initial data stack.
+class Interpreter
+{
+ public:
+  explicit Interpreter(const V4FrontBuf& buf, const std::vector<int32_t>& stack = {})
+      : buf_(buf), ds_(stack)
+  {
+  }
+
+  long run()
+  {
+    Frame frame = {buf_.data, buf_.size, 0, 0};
+    frames_.push_back(frame);
+    locals_.assign(256, 0);
+    unsigned long steps = 0;
+    while (!frames_.empty())
+    {
+      if (++steps > kMaxSteps || !step())
+        return -1;
+    }
+    return static_cast<long>(steps);
+  }
+
+  // Data stack left by run()
+  const std::vector<int32_t>& stack() const { return ds_; }
+
+ private:
+  struct Frame
+  {
+    const uint8_t* code;
+    size_t len;
+    size_t pc;
+    size_t locals;  // First slot of this frame in locals_
+  };
+
+  bool pop(int32_t* v)
+  {
+    if (ds_.empty())
+      return false;
+    *v = ds_.back();
+    ds_.pop_back();
+    return true;
+  }
+
+  bool pop2(int32_t* a, int32_t* b) { return pop(b) && pop(a); }
+
+  bool step()
+  {
+    Frame& f = frames_.back();
+    if (f.pc >= f.len)
+      return false;
+    const uint8_t* ip = f.code + f.pc;
+    size_t avail = f.len - f.pc;
+    int32_t a, b;
+    const int32_t kTrue = -1;
+    switch (static_cast<Op>(ip[0]))
+    {
+      case Op::LIT:
+        if (avail < 5)
+          return false;
+        ds_.push_back(read_i32(ip + 1));
+        f.pc += 5;
+        return true;
+      case Op::LIT0:
+      case Op::LIT1:
+      case Op::LITN1:
+        ds_.push_back(ip[0] == static_cast<uint8_t>(Op::LIT0)   ? 0
+                      : ip[0] == static_cast<uint8_t>(Op::LIT1) ? 1
+                                                                 : -1);
+        break;
+      case Op::DUP:
+        if (!pop(&a))
+          return false;
+        ds_.push_back(a);
+        ds_.push_back(a);
+        break;
+      case Op::DROP:
+        if (!pop(&a))
+          return false;
+        break;
+      case Op::SWAP:
+        if (!pop2(&a, &b))
+          return false;
+        ds_.push_back(b);
+        ds_.push_back(a);
+        break;
+      case Op::OVER:
+        if (!pop2(&a, &b))
+          return false;
+        ds_.push_back(a);
+        ds_.push_back(b);
+        ds_.push_back(a);
+        break;
+      case Op::TOR:
+        if (!pop(&a))
+          return false;
+        rs_.push_back(a);
+        break;
+      case Op::FROMR:
+      case Op::RFETCH:
+        if (rs_.empty())
+          return false;
+        ds_.push_back(rs_.back());
+        if (ip[0] == static_cast<uint8_t>(Op::FROMR))
+          rs_.pop_back();
+        break;
+      case Op::INC:
+      case Op::DEC:
+        if (!pop(&a))
+          return false;
+        ds_.push_back(static_cast<int32_t>(static_cast<uint32_t>(a) +
+                                           (ip[0] == static_cast<uint8_t>(Op::INC)
+                                                ? 1u
+                                                : 0xFFFFFFFFu)));
+        break;
+      case Op::INVERT:
+        if (!pop(&a))
+          return false;
+        ds_.push_back(~a);
+        break;
+      case Op::ADD:
+      case Op::SUB:
+      case Op::MUL:
+      case Op::DIV:
+      case Op::MOD:
+      case Op::AND:
+      case Op::OR:
+      case Op::XOR:
+      case Op::EQ:
+      case Op::NE:
+      case Op::LT:
+      case Op::LE:
+      case Op::GT:
+      case Op::GE:
+      case Op::LTU:
+      case Op::LEU:
+      case Op::SHL:
+      case Op::SHR:
+      case Op::SAR:
+      {
+        if (!pop2(&a, &b))
+          return false;
+        uint32_t ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+        int32_t r = 0;
+        switch (static_cast<Op>(ip[0]))
+        {
+          case Op::ADD:
+            r = static_cast<int32_t>(ua + ub);
+            break;
+          case Op::SUB:
+            r = static_cast<int32_t>(ua - ub);
+            break;
+          case Op::MUL:
+            r = static_cast<int32_t>(ua * ub);
+            break;
+          case Op::DIV:
+          case Op::MOD:
+            if (b == 0 || (a == INT32_MIN && b == -1))
+              return false;
+            r = ip[0] == static_cast<uint8_t>(Op::DIV) ? a / b : a % b;
+            break;
+          case Op::AND:
+            r = a & b;
+            break;
+          case Op::OR:
+            r = a | b;
+            break;
+          case Op::XOR:
+            r = a ^ b;
+            break;
+          case Op::EQ:
+            r = a == b ? kTrue : 0;
+            break;
+          case Op::NE:
+            r = a != b ? kTrue : 0;
+            break;
+          case Op::LT:
+            r = a < b ? kTrue : 0;
+            break;
+          case Op::LE:
+            r = a <= b ? kTrue : 0;
+            break;
+          case Op::GT:
+            r = a > b ? kTrue : 0;
+            break;
+          case Op::GE:
+            r = a >= b ? kTrue : 0;
+            break;
+          case Op::LTU:
+            r = ua < ub ? kTrue : 0;
+            break;
+          case Op::SHL:
+          case Op::SHR:
+          case Op::SAR:
+            // As compile-time folding: other amounts are left to the VM
+            if (ub > 31)
+              return false;
+            if (ip[0] == static_cast<uint8_t>(Op::SHL))
+              r = static_cast<int32_t>(ua << ub);
+            else if (ip[0] == static_cast<uint8_t>(Op::SHR) || a >= 0)
+              r = static_cast<int32_t>(ua >> ub);
+            else
+              r = ~static_cast<int32_t>(~ua >> ub);
+            break;
+          default:  // LEU
+            r = ua <= ub ? kTrue : 0;
+            break;
+        }
+        ds_.push_back(r);
+        break;
+      }
+      case Op::JMP:
+      case Op::JZ:
+      case Op::JNZ:
+      {
+        if (avail < 3)
+          return false;
+        bool taken = true;
+        if (ip[0] != static_cast<uint8_t>(Op::JMP))
+        {
+          if (!pop(&a))
+            return false;
+          taken = ip[0] == static_cast<uint8_t>(Op::JZ) ? a == 0 : a != 0;
+        }
+        f.pc += 3;
+        if (taken)
+          f.pc += read_i16(ip + 1);
+        return true;
+      }
+      case Op::CALL:
+      {
+        if (avail < 3)
+          return false;
+        int idx = read_i16(ip + 1);
+        if (idx < 0 || idx >= buf_.word_count || frames_.size() > 256)
+          return false;
+        f.pc += 3;
+        const V4FrontWord& w = buf_.words[idx];
+        Frame callee = {w.code, w.code_len, 0, locals_.size()};
+        locals_.resize(locals_.size() + 256, 0);
+        frames_.push_back(callee);
+        return true;
+      }
+      case Op::RET:
+        locals_.resize(f.locals == 0 ? 256 : f.locals);
+        frames_.pop_back();
+        return true;
+      case Op::LGET:
+      case Op::LSET:
+      case Op::LTEE:
+      case Op::LINC:
+      case Op::LDEC:
+      {
+        if (avail < 2)
+          return false;
+        int32_t& slot = locals_[f.locals + ip[1]];
+        switch (static_cast<Op>(ip[0]))
+        {
+          case Op::LGET:
+            ds_.push_back(slot);
+            break;
+          case Op::LSET:
+            if (!pop(&slot))
+              return false;
+            break;
+          case Op::LTEE:
+            if (ds_.empty())
+              return false;
+            slot = ds_.back();
+            break;
+          case Op::LINC:
+            slot = static_cast<int32_t>(static_cast<uint32_t>(slot) + 1u);
+            break;
+          default:  // LDEC
+            slot = static_cast<int32_t>(static_cast<uint32_t>(slot) - 1u);
+            break;
+        }
+        f.pc += 2;
+        return true;
+      }
+      case Op::LGET0:
+      case Op::LGET1:
+        ds_.push_back(locals_[f.locals + (ip[0] == static_cast<uint8_t>(Op::LGET1))]);
+        break;
+      case Op::LSET0:
+      case Op::LSET1:
+        if (!pop(&locals_[f.locals + (ip[0] == static_cast<uint8_t>(Op::LSET1))]))
+          return false;
+        break;
+      default:
+        return false;  // SYS, memory, tasks, fused or unknown opcodes
+    }
+    f.pc += 1;
+    return true;
+  }
+
+  const V4FrontBuf& buf_;
+  std::vector<Frame> frames_;
+  std::vector<int32_t> ds_;
+  std::vector<int32_t> rs_;
+  std::vector<int32_t> locals_;
+};
+
+bool compile(const char* source, int opt_level, V4FrontBuf* buf)
+{
+  V4FrontCompileOptions options = {};
+  options.opt_level = static_cast<uint32_t>(opt_level);
+  V4FrontError error;
+  if (v4front_compile_with_options(nullptr, source, &options, buf, &error) != 0)
+  {
+    fprintf(stderr, "cannot compile \"%s\": %s (line %d, column %d)\n", source,
+            error.message, error.line, error.column);
+    return false;
+  }
+  return true;
+}
+
+Metrics measure_size(const V4FrontBuf& buf)
+{
+  Metrics m;
+  m.bytes = buf.size;
+  m.instructions = v4front_disasm_count(buf.data, buf.size);
+  for (int i = 0; i < buf.word_count; i++)
+  {
+    m.bytes += buf.words[i].code_len;
+    m.instructions += v4front_disasm_count(buf.words[i].code, buf.words[i].code_len);
+  }
+  return m;
+}
+
+// JSON string body (KAT names are plain text, but may hold quotes)
+std::string json_escape(const std::string& s)
+{
+  std::string out;
+  for (char c : s)
+  {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    if (static_cast<unsigned char>(c) >= 0x20)
+      out += c;
+  }
+  return out;
+}
+
+void print_metrics(const Metrics& m)
+{
+  printf("\"bytes\":%zu,\"instructions\":%zu,\"dispatches\":", m.bytes, m.instructions);
+  if (m.dispatches < 0)
+    printf("null}\n");
+  else
+    printf("%ld}\n", m.dispatches);
+}
+
+void usage()
+{
+  fprintf(stderr,
+          "usage: v4front-codebench [-O LEVEL] [KAT_FILE...]\n"
+          "  -O LEVEL  optimization level (0..2, default 0)\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  int opt_level = 0;
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++)
+  {
+    if (strcmp(argv[i], "-O") == 0 && i + 1 < argc)
+    {
+      opt_level = atoi(argv[++i]);
+    }
+    else
+    {
+      usage();
+      return 2;
+    }
+  }
+  if (opt_level < 0 || opt_level > 2)
+  {
+    usage();
+    return 2;
+  }
+
+  int status = 0;
+  for (const Construct& c : kConstructs)
+  {
+    V4FrontBuf buf;
+    if (!compile(c.snippet, opt_level, &buf))
+    {
+      status = 1;
+      continue;
+    }
+    Metrics m = measure_size(buf);
+    v4front_free(&buf);
+    if (compile(c.program, opt_level, &buf))
+    {
+      // A miscompiled construct must not be timed as if it were correct
+      Interpreter interp(buf, {kInput});
+      m.dispatches = interp.run();
+      v4front_free(&buf);
+      const std::vector<int32_t>& stack = interp.stack();
+      if (m.dispatches < 0)
+      {
+        fprintf(stderr, "%s: \"%s\" cannot be run\n", c.name, c.program);
+        status = 1;
+      }
+      else if (stack.size() != 1 || stack[0] != c.result)
+      {
+        fprintf(stderr, "%s: \"%s\" leaves ", c.name, c.program);
+        for (int32_t v : stack)
+          fprintf(stderr, "%d ", v);
+        fprintf(stderr, "instead of %d\n", c.result);
+        status = 1;
+      }
+      else if (m.dispatches <= c.iterations)
+      {
+        fprintf(stderr, "%s: \"%s\" takes %ld dispatches for %ld iterations\n",
+                c.name, c.program, m.dispatches, c.iterations);
+        status = 1;
+      }
+    }
+    else
+    {
+      status = 1;
+    }
+    printf("{\"construct\":\"%s\",\"opt_level\":%d,", c.name, opt_level);
+    print_metrics(m);
+  }
+
+  Metrics total;
+  total.dispatches = 0;
+  size_t programs = 0;
+  size_t runnable = 0;
+  for (; i < argc; i++)
+  {
+    const char* base = strrchr(argv[i], '/');
+    std::string file = base ? base + 1 : argv[i];
+    std::vector<v4front::kat::KatTest> tests = v4front::kat::load_kat_file(argv[i]);
+    if (tests.empty())
+    {
+      fprintf(stderr, "%s: no tests\n", argv[i]);
+      status = 1;
+    }
+    for (const v4front::kat::KatTest& test : tests)
+    {
+      V4FrontBuf buf;
+      if (!compile(test.source.c_str(), opt_level, &buf))
+      {
+        status = 1;
+        continue;
+      }
+      Metrics m = measure_size(buf);
+      m.dispatches = Interpreter(buf).run();
+      v4front_free(&buf);
+      printf("{\"kat\":\"%s\",\"test\":\"%s\",\"opt_level\":%d,",
+             json_escape(file).c_str(), json_escape(test.name).c_str(), opt_level);
+      print_metrics(m);
+
+      programs++;
+      total.bytes += m.bytes;
+      total.instructions += m.instructions;
+      if (m.dispatches >= 0)
+      {
+        runnable++;
+        total.dispatches += m.dispatches;
+      }
+    }
+  }
+  if (programs > 0)
+  {
+    // dispatches sums the runnable programs only
+    printf("{\"kat\":\"total\",\"programs\":%zu,\"runnable\":%zu,\"opt_level\":%d,",
+           programs, runnable, opt_level);
+    print_metrics(total);
+  }
+  return status;
+}
@@ -0,0 +1,84 @@
+// v4front-kat: run KAT files in parallel.
+//
+//  Usage: v4front-kat [-j THREADS] [-O LEVEL] FILE...
+//
+//  - Every FILE is a .kat file (see docs/kat-format.md). The files are loaded
+//    and their cases compiled on THREADS workers (default: one per hardware
+//    thread), each taking the next file or case as it frees up, so a corpus
+//    of many small files and one of a few huge files spread the same way.
+//  - -O selects the optimization level the cases are compiled at (default 0,
+//    which the expected bytecode of the shipped corpus is written for).
+//  - Every failure is printed as "FILE: TEST: reason", in file and case
+//    order whatever the thread count, then one summary line.
+//  - The exit status is 1 if a file cannot be loaded or a case fails, and 2
+//    on bad usage.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "kat_runner.hpp"
+
+namespace
+{
+
+void usage()
+{
+  fprintf(stderr,
+          "usage: v4front-kat [-j THREADS] [-O LEVEL] FILE...\n"
+          "  -j THREADS  worker threads (default: one per hardware thread)\n"
+          "  -O LEVEL    optimization level (default 0)\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  int threads = 0;
+  int opt_level = 0;
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++)
+  {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+    {
+      threads = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-O") == 0 && i + 1 < argc)
+    {
+      opt_level = atoi(argv[++i]);
+    }
+    else
+    {
+      usage();
+      return 2;
+    }
+  }
+  if (i == argc || threads < 0 || opt_level < 0)
+  {
+    usage();
+    return 2;
+  }
+
+  std::vector<std::string> files(argv + i, argv + argc);
+  auto start = std::chrono::steady_clock::now();
+  v4front::kat::KatBatchResult result;
+  bool ok = v4front::kat::run_kat_batch(files, static_cast<unsigned>(threads),
+                                        static_cast<uint32_t>(opt_level), &result);
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                        start)
+                  .count();
+
+  for (const v4front::kat::KatFailure& f : result.failures)
+  {
+    if (f.name.empty())
+      printf("%s: %s\n", f.file.c_str(), f.reason.c_str());
+    else
+      printf("%s: %s: %s\n", f.file.c_str(), f.name.c_str(), f.reason.c_str());
+  }
+  printf("%zu files, %zu cases, %zu failed (%.1f ms)\n", files.size(), result.cases,
+         result.failures.size(), ms);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,272 @@
+// v4front-ngrams: report the most frequent opcode n-grams.
+//
+//  Usage: v4front-ngrams [-n MAX] [-k TOP] [-t | -p PROFILE] FILE...
+//
+//  - Without -t every FILE is a .v4b bytecode file; its code is decoded with
+//    decode() and every window of 2..MAX consecutive instructions is
+//    counted (a static profile).
+//  - With -t every FILE is a VM trace: one executed instruction per line,
+//    either a disassembly line ("0040: LIT 5") or a bare mnemonic ("LIT 5").
+//    Blank lines and lines starting with '#' are skipped; a line "---" ends
+//    one run (n-grams never span runs). This gives a dynamic profile.
+//  - With -p the .v4b files' words are counted too, each n-gram of a word
+//    weighted by the word's count in PROFILE (see v4front_load_profile;
+//    words it does not name count 0). The main code counts once. This ranks
+//    static windows by how often they run.
+//  - The top TOP n-grams of each length are printed with their counts; they
+//    are the candidates for V4FrontSuperinstruction entries.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "v4front/compile.h"
+#include "v4front/disasm.hpp"
+
+namespace
+{
+
+constexpr int kMaxN = 4;  // Longest pattern a V4FrontSuperinstruction can hold
+
+struct Profile
+{
+  int max_n;
+  std::map<std::string, unsigned long> counts[kMaxN + 1];
+  std::vector<std::string> window;  // Most recent mnemonics of the current run
+
+  void reset_run() { window.clear(); }
+
+  void add(const std::string& mnemonic, unsigned long weight = 1)
+  {
+    window.push_back(mnemonic);
+    if (window.size() > static_cast<size_t>(max_n))
+      window.erase(window.begin());
+    // Count every n-gram that ends at this instruction
+    for (int n = 2; n <= static_cast<int>(window.size()); n++)
+    {
+      std::string key;
+      for (size_t k = window.size() - n; k < window.size(); k++)
+      {
+        if (!key.empty())
+          key += ' ';
+        key += window[k];
+      }
+      counts[n][key] += weight;
+    }
+  }
+};
+
+// Mnemonic of a disassembly line ("0040: JMP      +6 ; -> 0048" -> "JMP")
+std::string mnemonic_of(const char* line)
+{
+  const char* colon = strstr(line, ": ");
+  const char* p = colon ? colon + 2 : line;
+  while (*p == ' ' || *p == '\t')
+    p++;
+  const char* end = p;
+  while (*end && *end != ' ' && *end != '\t' && *end != '\n' && *end != '\r')
+    end++;
+  return std::string(p, end - p);
+}
+
+// Count the instructions of code[0, size)
+void profile_code(const uint8_t* code, size_t size, unsigned long weight,
+                  Profile* profile)
+{
+  v4front::DecodedInsn insns[64];
+  size_t pc = 0;
+  profile->reset_run();
+  while (size_t n = v4front::decode(code, size, pc, insns, 64))
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      std::string mnemonic = v4front::op_info(insns[i].opcode).name;
+      if (mnemonic == "???")
+      {
+        // Opcode outside opcodes.def (e.g. already fused code): name it by value
+        char hex[8];
+        snprintf(hex, sizeof(hex), "0x%02X", insns[i].opcode);
+        mnemonic = hex;
+      }
+      profile->add(mnemonic, weight);
+    }
+    pc = insns[n - 1].pc + insns[n - 1].length;
+  }
+}
+
+// Count of name in counts (0 if absent; names match case-insensitively)
+unsigned long word_weight(const V4FrontProfile* counts, const char* name)
+{
+  unsigned long weight = 0;
+  for (uint32_t i = 0; counts && i < counts->count; i++)
+  {
+    const char* a = counts->words[i].name;
+    const char* b = name;
+    while (*a && toupper(static_cast<unsigned char>(*a)) ==
+                     toupper(static_cast<unsigned char>(*b)))
+      a++, b++;
+    if (*a == '\0' && *b == '\0')
+      weight += static_cast<unsigned long>(counts->words[i].count);
+  }
+  return weight;
+}
+
+bool profile_bytecode(const char* path, const V4FrontProfile* counts, Profile* profile)
+{
+  V4FrontBuf buf;
+  v4front_err err = v4front_load_bytecode(path, &buf);
+  if (err != 0)
+  {
+    fprintf(stderr, "%s: cannot load bytecode (error %d)\n", path, err);
+    return false;
+  }
+
+  profile_code(buf.data, buf.size, 1, profile);
+  for (int w = 0; counts && w < buf.word_count; w++)
+  {
+    unsigned long weight = word_weight(counts, buf.words[w].name);
+    if (weight > 0)
+      profile_code(buf.words[w].code, buf.words[w].code_len, weight, profile);
+  }
+
+  v4front_free(&buf);
+  return true;
+}
+
+bool profile_trace(const char* path, Profile* profile)
+{
+  FILE* fp = fopen(path, "r");
+  if (!fp)
+  {
+    fprintf(stderr, "%s: cannot open trace\n", path);
+    return false;
+  }
+
+  char line[512];
+  profile->reset_run();
+  while (fgets(line, sizeof(line), fp))
+  {
+    if (strncmp(line, "---", 3) == 0)
+    {
+      profile->reset_run();
+      continue;
+    }
+    std::string mnemonic = mnemonic_of(line);
+    if (mnemonic.empty() || mnemonic[0] == '#')
+      continue;
+    profile->add(mnemonic);
+  }
+
+  fclose(fp);
+  return true;
+}
+
+void report(const Profile& profile, int top)
+{
+  for (int n = 2; n <= profile.max_n; n++)
+  {
+    std::vector<std::pair<unsigned long, std::string>> ranked;
+    for (const auto& entry : profile.counts[n])
+      ranked.emplace_back(entry.second, entry.first);
+    // Highest count first; the map order keeps ties in mnemonic order
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const std::pair<unsigned long, std::string>& a,
+                        const std::pair<unsigned long, std::string>& b)
+                     { return a.first > b.first; });
+    if (ranked.size() > static_cast<size_t>(top))
+      ranked.resize(top);
+
+    printf("%d-grams:\n", n);
+    for (const auto& entry : ranked)
+      printf("  %8lu  %s\n", entry.first, entry.second.c_str());
+  }
+}
+
+void usage()
+{
+  fprintf(stderr,
+          "usage: v4front-ngrams [-n MAX] [-k TOP] [-t | -p PROFILE] FILE...\n"
+          "  -n MAX      longest n-gram to count (2..%d, default 3)\n"
+          "  -k TOP      n-grams to report per length (default 10)\n"
+          "  -t          FILEs are VM traces instead of .v4b files\n"
+          "  -p PROFILE  also count words, weighted by their execution counts\n",
+          kMaxN);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  Profile profile;
+  profile.max_n = 3;
+  int top = 10;
+  bool trace = false;
+  const char* profile_path = nullptr;
+
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++)
+  {
+    if (strcmp(argv[i], "-t") == 0)
+    {
+      trace = true;
+    }
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      profile.max_n = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc)
+    {
+      top = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+    {
+      profile_path = argv[++i];
+    }
+    else
+    {
+      usage();
+      return 2;
+    }
+  }
+  if (i == argc || profile.max_n < 2 || profile.max_n > kMaxN || top < 1 ||
+      (trace && profile_path))
+  {
+    usage();
+    return 2;
+  }
+
+  V4FrontProfile counts = {nullptr, 0};
+  if (profile_path)
+  {
+    uint32_t line = 0;
+    v4front_err err = v4front_load_profile(profile_path, &counts, &line);
+    if (err != 0)
+    {
+      if (line > 0)
+        fprintf(stderr, "%s:%u: malformed profile line\n", profile_path, line);
+      else
+        fprintf(stderr, "%s: cannot load profile (error %d)\n", profile_path, err);
+      return 1;
+    }
+  }
+
+  int status = 0;
+  for (; i < argc; i++)
+  {
+    bool ok = trace ? profile_trace(argv[i], &profile)
+                    : profile_bytecode(argv[i], profile_path ? &counts : nullptr,
+                                       &profile);
+    if (!ok)
+      status = 1;
+  }
+
+  report(profile, top);
+  v4front_free_profile(&counts);
+  return status;
+}